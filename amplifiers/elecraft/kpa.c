@@ -401,7 +401,7 @@ int kpa_get_level(AMP *amp, setting_t level, value_t *val)
 
     case AMP_LEVEL_PWR_INPUT:
         cmd = "^PWI;";
-        nargs = sscanf(responsebuf, "^SW%d", &pwrinput);
+        nargs = sscanf(responsebuf, "^PWI%d", &pwrinput);
 
         if (nargs != 1)
         {
@@ -417,7 +417,7 @@ int kpa_get_level(AMP *amp, setting_t level, value_t *val)
 
     case AMP_LEVEL_PWR_FWD:
         cmd = "^PWF;";
-        nargs = sscanf(responsebuf, "^SW%d", &pwrfwd);
+        nargs = sscanf(responsebuf, "^PWF%d", &pwrfwd);
 
         if (nargs != 1)
         {
@@ -433,7 +433,7 @@ int kpa_get_level(AMP *amp, setting_t level, value_t *val)
 
     case AMP_LEVEL_PWR_REFLECTED:
         cmd = "^PWR;";
-        nargs = sscanf(responsebuf, "^SW%d", &pwrref);
+        nargs = sscanf(responsebuf, "^PWR%d", &pwrref);
 
         if (nargs != 1)
         {
@@ -449,7 +449,7 @@ int kpa_get_level(AMP *amp, setting_t level, value_t *val)
 
     case AMP_LEVEL_PWR_PEAK:
         cmd = "^PWK;";
-        nargs = sscanf(responsebuf, "^SW%d", &pwrpeak);
+        nargs = sscanf(responsebuf, "^PWK%d", &pwrpeak);
 
         if (nargs != 1)
         {
@@ -465,7 +465,7 @@ int kpa_get_level(AMP *amp, setting_t level, value_t *val)
 
     case AMP_LEVEL_FAULT:
         cmd = "^SF;";
-        nargs = sscanf(responsebuf, "^SW%d", &fault);
+        nargs = sscanf(responsebuf, "^SF%d", &fault);
 
         if (nargs != 1)
         {
@@ -540,15 +540,15 @@ int kpa_get_powerstat(AMP *amp, powerstat_t *status)
         return -RIG_EPROTO;
     }
 
-    retval = kpa_transaction(amp, "^OP;", responsebuf, sizeof(responsebuf));
+    retval = kpa_transaction(amp, "^OS;", responsebuf, sizeof(responsebuf));
 
     if (retval != RIG_OK) { return retval; }
 
-    nargs = sscanf(responsebuf, "^ON%d", &operate);
+    nargs = sscanf(responsebuf, "^OS%d", &operate);
 
     if (nargs != 1)
     {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s Error: ^ON response='%s'\n", __func__,
+        rig_debug(RIG_DEBUG_VERBOSE, "%s Error: ^OS response='%s'\n", __func__,
                   responsebuf);
         return -RIG_EPROTO;
     }
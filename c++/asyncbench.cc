@@ -0,0 +1,115 @@
+/*
+ * Hamlib C++ asynchronous interface benchmark
+ *
+ * Simulates a GUI event loop polling frequency, mode, VFO and S-meter
+ * once per frame and reports how long the loop thread is blocked in
+ * Hamlib per frame, with the synchronous and the asynchronous calls.
+ *
+ *   asyncbench [model [rig_pathname]]
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <hamlib/rigclass.h>
+
+#define FRAMES 50
+#define FRAME_MS 20
+
+typedef std::chrono::steady_clock Clock;
+
+static double ms_since(Clock::time_point t0)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static void report(const char *name, std::vector<double> &blocked, int updates)
+{
+	double total = 0;
+
+	for (double b : blocked)
+		total += b;
+
+	std::sort(blocked.begin(), blocked.end());
+
+	std::cout << name << ": frames=" << blocked.size()
+		  << " blocked_mean_ms=" << total / blocked.size()
+		  << " blocked_p99_ms=" << blocked[(blocked.size() - 1) * 99 / 100]
+		  << " blocked_max_ms=" << blocked.back()
+		  << " updates=" << updates << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	rig_model_t model = argc > 1 ? atoi(argv[1]) : RIG_MODEL_DUMMY;
+	std::vector<double> blocked;
+	int updates = 0;
+
+	rig_set_debug(RIG_DEBUG_NONE);
+
+	Rig myRig {model};
+
+	try {
+		if (argc > 2)
+			myRig.setConf("rig_pathname", argv[2]);
+		myRig.open();
+
+		for (int i = 0; i < FRAMES; i++) {
+			pbwidth_t width;
+			Clock::time_point t0 = Clock::now();
+
+			myRig.getFreq();
+			myRig.getMode(width);
+			myRig.getVFO();
+			myRig.getLevelI(RIG_LEVEL_STRENGTH);
+			updates++;
+
+			blocked.push_back(ms_since(t0));
+			std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_MS));
+		}
+		report("sync", blocked, updates);
+
+		blocked.clear();
+		updates = 0;
+
+		std::future<RigReply<freq_t>> freq;
+		std::future<RigReply<RigMode>> mode;
+		std::future<RigReply<vfo_t>> vfo;
+		std::future<RigReply<value_t>> strength;
+
+		for (int i = 0; i < FRAMES; i++) {
+			Clock::time_point t0 = Clock::now();
+
+			/* pick up answers that arrived, ask again when they have */
+			if (freq.valid() && freq.wait_for(std::chrono::seconds(0)) == std::future_status::ready
+					&& strength.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+				freq.get();
+				mode.get();
+				vfo.get();
+				strength.get();
+				updates++;
+			}
+
+			if (!freq.valid()) {
+				freq = myRig.getFreqAsync();
+				mode = myRig.getModeAsync();
+				vfo = myRig.getVFOAsync();
+				strength = myRig.getLevelAsync(RIG_LEVEL_STRENGTH);
+			}
+
+			blocked.push_back(ms_since(t0));
+			std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_MS));
+		}
+		report("async", blocked, updates);
+
+		myRig.close();
+	}
+	catch (const RigException &Ex) {
+		Ex.print();
+		return 1;
+	}
+
+	return 0;
+}
@@ -33,6 +33,16 @@
 #include <hamlib/rig.h>
 #include <hamlib/rigclass.h>
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #define CHECK_RIG(cmd) { int _retval = cmd; if (_retval != RIG_OK) \
 							THROW(new RigException (_retval)); }
 
@@ -52,6 +62,241 @@ static int hamlibpp_freq_event(RIG *rig, vfo_t vfo, freq_t freq, rig_ptr_t arg)
 }
 
 
+
+/*
+ * Asynchronous request queue, one worker thread per Rig
+ */
+struct RigRequest
+{
+	std::string key;		/* identifies a read, empty for writes */
+	std::shared_ptr<void> op;	/* RigReadOp of the read */
+	std::function<void()> run;
+};
+
+template <class T>
+struct RigReadOp
+{
+	std::vector<Rig::Callback<T>> waiters;
+};
+
+/* an exception must not leave the worker thread, it would terminate */
+template <class F, class... Args>
+static void run_callback(const F &cb, Args &&... args)
+{
+	try {
+		cb(std::forward<Args>(args)...);
+	}
+	catch (...) {
+		rig_debug(RIG_DEBUG_ERR, "%s: exception thrown by an async callback ignored\n",
+			  __func__);
+	}
+}
+
+class RigWorker
+{
+public:
+	RigWorker() : stop(false), busy(false), released(false), stats()
+	{
+		thread = std::thread(&RigWorker::loop, this);
+	}
+
+	~RigWorker()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		cond.notify_all();
+		if (thread.joinable())
+			thread.join();
+	}
+
+	template <class T>
+	void read(const std::string &key, std::function<int(T &)> fn,
+		  Rig::Callback<T> done);
+	void write(std::function<int()> fn, Rig::Done done);
+	void waitIdle();
+	bool isWorkerThread() const;
+	void release();
+	RigAsyncStats getStats();
+
+private:
+	void loop();
+
+	std::mutex mutex;
+	std::condition_variable cond;	/* request queued or stop */
+	std::condition_variable idle;	/* queue drained */
+	std::deque<RigRequest> queue;
+	bool stop;
+	bool busy;
+	bool released;			/* deletes itself when the loop ends */
+	RigAsyncStats stats;
+	std::thread thread;
+};
+
+void RigWorker::loop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (;;) {
+		while (queue.empty() && !stop)
+			cond.wait(lock);
+
+		/* queued requests are still run on stop */
+		if (queue.empty())
+			break;
+
+		RigRequest r = std::move(queue.front());
+		queue.pop_front();
+		busy = true;
+		stats.executed++;
+
+		lock.unlock();
+		r.run();
+		lock.lock();
+
+		busy = false;
+		if (queue.empty())
+			idle.notify_all();
+	}
+
+	if (released) {
+		lock.unlock();
+		delete this;
+	}
+}
+
+template <class T>
+void RigWorker::read(const std::string &key, std::function<int(T &)> fn,
+		     Rig::Callback<T> done)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	stats.requests++;
+
+	/* share a queued read, unless a write was queued after it */
+	for (auto it = queue.rbegin(); it != queue.rend() && !it->key.empty(); ++it) {
+		if (it->key == key) {
+			static_cast<RigReadOp<T> *>(it->op.get())->waiters.push_back(done);
+			stats.merged++;
+			return;
+		}
+	}
+
+	auto op = std::make_shared<RigReadOp<T>>();
+	op->waiters.push_back(done);
+
+	RigRequest r;
+	r.key = key;
+	r.op = op;
+	r.run = [op, fn]() {
+		RigReply<T> reply = RigReply<T>();
+		int retval = fn(reply.value);
+
+		reply.time = std::chrono::steady_clock::now();
+
+		for (auto &w : op->waiters)
+			run_callback(w, retval, reply);
+	};
+
+	queue.push_back(std::move(r));
+	cond.notify_one();
+}
+
+void RigWorker::write(std::function<int()> fn, Rig::Done done)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	stats.requests++;
+
+	RigRequest r;
+	r.run = [fn, done]() {
+		int retval = fn();
+
+		if (done)
+			run_callback(done, retval);
+	};
+
+	queue.push_back(std::move(r));
+	cond.notify_one();
+}
+
+void RigWorker::waitIdle()
+{
+	/* called from a callback, the queue can't drain while we wait */
+	if (isWorkerThread())
+		return;
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (!queue.empty() || busy)
+		idle.wait(lock);
+}
+
+bool RigWorker::isWorkerThread() const
+{
+	return std::this_thread::get_id() == thread.get_id();
+}
+
+/*
+ * The Rig is destroyed from one of its callbacks, on this thread, which
+ * can't join itself.  The requests still queued would use the Rig, so
+ * they are dropped, and the worker goes when the callback returns.
+ */
+void RigWorker::release()
+{
+	std::deque<RigRequest> dropped;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		dropped.swap(queue);
+		stop = true;
+		released = true;
+	}
+	thread.detach();
+}
+
+RigAsyncStats RigWorker::getStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	return stats;
+}
+
+template <class T>
+static Rig::Callback<T> promise_callback(std::shared_ptr<std::promise<RigReply<T>>> p)
+{
+	return [p](int retval, const RigReply<T> &reply) {
+		if (retval != RIG_OK)
+			p->set_exception(std::make_exception_ptr(RigException(retval)));
+		else
+			p->set_value(reply);
+	};
+}
+
+static Rig::Done promise_done(std::shared_ptr<std::promise<void>> p)
+{
+	return [p](int retval) {
+		if (retval != RIG_OK)
+			p->set_exception(std::make_exception_ptr(RigException(retval)));
+		else
+			p->set_value();
+	};
+}
+
+/* the workers are kept out of Rig to leave its layout as it was */
+static std::mutex worker_lock;
+static std::map<const Rig *, RigWorker *> workers;
+
+static RigWorker *find_worker(const Rig *rig)
+{
+	std::lock_guard<std::mutex> lock(worker_lock);
+	std::map<const Rig *, RigWorker *>::iterator it = workers.find(rig);
+
+	return it == workers.end() ? NULL : it->second;
+}
+
+
 Rig::Rig(rig_model_t rig_model) {
 	theRig = rig_init(rig_model);
    	if (!theRig)
@@ -63,16 +308,35 @@ Rig::Rig(rig_model_t rig_model) {
 }
 
 Rig::~Rig() {
+	RigWorker *worker = find_worker(this);
+
+	/* finishes the queued requests first, unless called by one of them */
+	if (worker && worker->isWorkerThread())
+		worker->release();
+	else
+		delete worker;
+	{
+		std::lock_guard<std::mutex> lock(worker_lock);
+		workers.erase(this);
+	}
 	theRig->state.obj = NULL;
 	CHECK_RIG( rig_cleanup(theRig) );
 	caps = NULL;
 }
 
 void Rig::open(void) {
+	RigWorker *worker = find_worker(this);
+
+	if (worker)
+		worker->waitIdle();
 	CHECK_RIG( rig_open(theRig) );
 }
 
 void Rig::close(void) {
+	RigWorker *worker = find_worker(this);
+
+	if (worker)
+		worker->waitIdle();
 	CHECK_RIG( rig_close(theRig) );
 }
 
@@ -700,3 +964,206 @@ rmode_t Rig::RngTxModes (freq_t freq)
 	return (rmode_t)modes;
 }
 
+
+
+RigWorker &Rig::asyncWorker()
+{
+	std::lock_guard<std::mutex> lock(worker_lock);
+	RigWorker *&worker = workers[this];
+
+	if (!worker)
+		worker = new RigWorker();
+
+	return *worker;
+}
+
+RigAsyncStats Rig::getAsyncStats()
+{
+	RigWorker *worker = find_worker(this);
+
+	if (!worker) {
+		RigAsyncStats stats = RigAsyncStats();
+		return stats;
+	}
+
+	return worker->getStats();
+}
+
+void Rig::getFreqAsync(Callback<freq_t> done, vfo_t vfo)
+{
+	asyncWorker().read<freq_t>("freq " + std::to_string(vfo),
+		[this, vfo](freq_t &freq) { return rig_get_freq(theRig, vfo, &freq); },
+		done);
+}
+
+std::future<RigReply<freq_t>> Rig::getFreqAsync(vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<RigReply<freq_t>>>();
+
+	getFreqAsync(promise_callback(p), vfo);
+
+	return p->get_future();
+}
+
+void Rig::getModeAsync(Callback<RigMode> done, vfo_t vfo)
+{
+	asyncWorker().read<RigMode>("mode " + std::to_string(vfo),
+		[this, vfo](RigMode &m) { return rig_get_mode(theRig, vfo, &m.mode, &m.width); },
+		done);
+}
+
+std::future<RigReply<RigMode>> Rig::getModeAsync(vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<RigReply<RigMode>>>();
+
+	getModeAsync(promise_callback(p), vfo);
+
+	return p->get_future();
+}
+
+void Rig::getVFOAsync(Callback<vfo_t> done)
+{
+	asyncWorker().read<vfo_t>("vfo",
+		[this](vfo_t &vfo) { return rig_get_vfo(theRig, &vfo); },
+		done);
+}
+
+std::future<RigReply<vfo_t>> Rig::getVFOAsync()
+{
+	auto p = std::make_shared<std::promise<RigReply<vfo_t>>>();
+
+	getVFOAsync(promise_callback(p));
+
+	return p->get_future();
+}
+
+void Rig::getPTTAsync(Callback<ptt_t> done, vfo_t vfo)
+{
+	asyncWorker().read<ptt_t>("ptt " + std::to_string(vfo),
+		[this, vfo](ptt_t &ptt) { return rig_get_ptt(theRig, vfo, &ptt); },
+		done);
+}
+
+std::future<RigReply<ptt_t>> Rig::getPTTAsync(vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<RigReply<ptt_t>>>();
+
+	getPTTAsync(promise_callback(p), vfo);
+
+	return p->get_future();
+}
+
+void Rig::getLevelAsync(Callback<value_t> done, setting_t level, vfo_t vfo)
+{
+	asyncWorker().read<value_t>("level " + std::to_string(level) + " " + std::to_string(vfo),
+		[this, level, vfo](value_t &val) { return rig_get_level(theRig, vfo, level, &val); },
+		done);
+}
+
+std::future<RigReply<value_t>> Rig::getLevelAsync(setting_t level, vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<RigReply<value_t>>>();
+
+	getLevelAsync(promise_callback(p), level, vfo);
+
+	return p->get_future();
+}
+
+void Rig::getSplitFreqAsync(Callback<freq_t> done, vfo_t vfo)
+{
+	asyncWorker().read<freq_t>("split_freq " + std::to_string(vfo),
+		[this, vfo](freq_t &freq) { return rig_get_split_freq(theRig, vfo, &freq); },
+		done);
+}
+
+std::future<RigReply<freq_t>> Rig::getSplitFreqAsync(vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<RigReply<freq_t>>>();
+
+	getSplitFreqAsync(promise_callback(p), vfo);
+
+	return p->get_future();
+}
+
+void Rig::setFreqAsync(Done done, freq_t freq, vfo_t vfo)
+{
+	asyncWorker().write([this, freq, vfo]() { return rig_set_freq(theRig, vfo, freq); },
+		done);
+}
+
+std::future<void> Rig::setFreqAsync(freq_t freq, vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<void>>();
+
+	setFreqAsync(promise_done(p), freq, vfo);
+
+	return p->get_future();
+}
+
+std::future<void> Rig::setModeAsync(rmode_t mode, pbwidth_t width, vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<void>>();
+
+	asyncWorker().write([this, mode, width, vfo]() { return rig_set_mode(theRig, vfo, mode, width); },
+		promise_done(p));
+
+	return p->get_future();
+}
+
+std::future<void> Rig::setVFOAsync(vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<void>>();
+
+	asyncWorker().write([this, vfo]() { return rig_set_vfo(theRig, vfo); },
+		promise_done(p));
+
+	return p->get_future();
+}
+
+std::future<void> Rig::setPTTAsync(ptt_t ptt, vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<void>>();
+
+	asyncWorker().write([this, ptt, vfo]() { return rig_set_ptt(theRig, vfo, ptt); },
+		promise_done(p));
+
+	return p->get_future();
+}
+
+std::future<void> Rig::setLevelAsync(setting_t level, value_t val, vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<void>>();
+
+	asyncWorker().write([this, level, val, vfo]() { return rig_set_level(theRig, vfo, level, val); },
+		promise_done(p));
+
+	return p->get_future();
+}
+
+std::future<void> Rig::setSplitFreqAsync(freq_t tx_freq, vfo_t vfo)
+{
+	auto p = std::make_shared<std::promise<void>>();
+
+	asyncWorker().write([this, tx_freq, vfo]() { return rig_set_split_freq(theRig, vfo, tx_freq); },
+		promise_done(p));
+
+	return p->get_future();
+}
+
+std::future<void> Rig::callAsync(std::function<void(Rig &)> fn)
+{
+	auto p = std::make_shared<std::promise<void>>();
+
+	asyncWorker().write([this, fn, p]() {
+		try {
+			fn(*this);
+			p->set_value();
+		}
+		catch (...) {
+			p->set_exception(std::current_exception());
+		}
+		return RIG_OK;
+	}, NULL);
+
+	return p->get_future();
+}
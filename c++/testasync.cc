@@ -0,0 +1,133 @@
+/*
+ * Hamlib C++ asynchronous interface test
+ *
+ * Drives many concurrent requests from several threads against the
+ * dummy rig and checks results, ordering against writes, merging of
+ * identical reads and error reporting.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <hamlib/rigclass.h>
+#include "../tests/testcheck.h"
+
+#define THREADS 8
+#define LOOPS 10
+
+int main(int argc, char* argv[])
+{
+	std::atomic<int> callbacks(0);
+
+	rig_set_debug(RIG_DEBUG_NONE);
+
+	Rig myRig {RIG_MODEL_DUMMY};
+
+	try {
+		myRig.open();
+
+		/* reads and writes come back in queue order */
+		auto f1 = myRig.getFreqAsync();
+		auto s1 = myRig.setFreqAsync(MHz(14.074));
+		auto f2 = myRig.getFreqAsync();
+		auto s2 = myRig.setModeAsync(RIG_MODE_USB, 2400);
+		auto m1 = myRig.getModeAsync();
+
+		s1.get();
+		s2.get();
+		check(f1.get().value != MHz(14.074), "read before a write sees the old value");
+		check(f2.get().value == MHz(14.074), "read after a write sees the new value");
+		check(m1.get().value.mode == RIG_MODE_USB, "mode read after mode write");
+
+		/* identical reads queued behind a slow request are merged */
+		RigAsyncStats before = myRig.getAsyncStats();
+		auto slow = myRig.callAsync([](Rig &) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		});
+		std::vector<std::future<RigReply<freq_t>>> same;
+		for (int i = 0; i < 5; i++)
+			same.push_back(myRig.getFreqAsync());
+		slow.get();
+		for (auto &f : same)
+			check(f.get().value == MHz(14.074), "merged read value");
+		RigAsyncStats after = myRig.getAsyncStats();
+		check(after.merged - before.merged == 4, "4 of 5 identical reads merged");
+
+		/* many threads at once, futures and callbacks */
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (int t = 0; t < THREADS; t++) {
+			threads.push_back(std::thread([&myRig, &callbacks, start]() {
+				for (int i = 0; i < LOOPS; i++) {
+					auto f = myRig.getFreqAsync();
+					auto m = myRig.getModeAsync();
+					auto l = myRig.getLevelAsync(RIG_LEVEL_STRENGTH);
+					myRig.getVFOAsync([&callbacks](int retval, const RigReply<vfo_t> &) {
+						if (retval == RIG_OK)
+							callbacks++;
+					});
+					auto fr = f.get();
+					check(fr.value == MHz(14.074), "concurrent freq");
+					check(fr.time >= start, "reply timestamp");
+					check(m.get().value.mode == RIG_MODE_USB, "concurrent mode");
+					l.get();
+				}
+			}));
+		}
+		for (auto &t : threads)
+			t.join();
+
+		/* errors come back as exceptions from the future */
+		bool thrown = false;
+		try {
+			myRig.getLevelAsync(RIG_LEVEL_NONE).get();
+		}
+		catch (const RigException &Ex) {
+			thrown = true;
+		}
+		check(thrown, "failed request throws RigException");
+
+		/* an exception from a callback leaves the worker running */
+		myRig.setFreqAsync([](int) { throw RigException("callback"); }, MHz(7.074));
+		check(myRig.getFreqAsync().get().value == MHz(7.074), "worker survives a throwing callback");
+
+		/* close waits for the callbacks still queued */
+		myRig.close();
+		check(callbacks == THREADS * LOOPS, "all callbacks called");
+
+		RigAsyncStats stats = myRig.getAsyncStats();
+		check(stats.executed + stats.merged == stats.requests, "request accounting");
+		std::cout << "requests=" << stats.requests << " merged=" << stats.merged
+			  << " executed=" << stats.executed << std::endl;
+	}
+	catch (const RigException &Ex) {
+		Ex.print();
+		return 1;
+	}
+
+	/* a Rig destroyed from its own callback drops what is still queued */
+	Rig *tmpRig = new Rig(RIG_MODEL_DUMMY);
+	std::promise<void> gate, destroyed;
+	std::shared_future<void> opened = gate.get_future();
+	tmpRig->open();
+	/* hold the worker until both requests are queued */
+	tmpRig->callAsync([opened](Rig &) { opened.wait(); });
+	tmpRig->getFreqAsync([tmpRig, &destroyed](int, const RigReply<freq_t> &) {
+		delete tmpRig;
+		destroyed.set_value();
+	});
+	auto dropped = tmpRig->getModeAsync();
+	gate.set_value();
+	destroyed.get_future().get();
+	bool broken = false;
+	try {
+		dropped.get();
+	}
+	catch (const std::future_error &) {
+		broken = true;
+	}
+	check(broken, "request queued behind the destroying callback is dropped");
+
+	return failures ? 1 : 0;
+}
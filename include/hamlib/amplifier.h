@@ -159,6 +159,19 @@ enum amp_level_e
 #define AMP_LEVEL_IS_STRING(l) ((l)&AMP_LEVEL_STRING_LIST)
 //! @endcond
 
+/**
+ * \brief Amplifier level cache counters
+ *
+ * \sa amp_get_cache_stats()
+ */
+typedef struct hamlib_amp_cache_stats {
+  unsigned long hits;         /*!< Reads served from the cache */
+  unsigned long misses;       /*!< Reads that went to the amplifier */
+  unsigned long polls;        /*!< Values read by the poller */
+  unsigned long poll_errors;  /*!< Poller reads that returned an error */
+  double max_age_ms;          /*!< Oldest cached value served */
+} hamlib_amp_cache_stats_t;
+
 /* Basic amp type, can store some useful info about different amplifiers. Each
  * lib must be able to populate this structure, so we can make useful
  * enquiries about capabilities.
@@ -297,6 +310,8 @@ struct amp_state
   gran_t level_gran[RIG_SETTING_MAX]; /*!< Level granularity. */
   gran_t parm_gran[RIG_SETTING_MAX];  /*!< Parameter granularity. */
   hamlib_port_t ampport;  /*!< Amplifier port (internal use). */
+  rig_ptr_t cache_priv;   /*!< Level cache and poller (internal use). */
+  rig_ptr_t station;      /*!< Station event loop, see rig_station_add_amp() (internal use). */
 };
 
 
@@ -374,6 +389,30 @@ amp_get_level HAMLIB_PARAMS((AMP *amp, setting_t level, value_t *val));
 extern HAMLIB_EXPORT(int)
 amp_set_level HAMLIB_PARAMS((AMP *amp, setting_t level, value_t val));
 
+extern HAMLIB_EXPORT(int)
+amp_set_cache_timeout HAMLIB_PARAMS((AMP *amp, setting_t level, int ms));
+
+extern HAMLIB_EXPORT(int)
+amp_set_poll HAMLIB_PARAMS((AMP *amp, setting_t level, int interval_ms));
+
+extern HAMLIB_EXPORT(int)
+amp_set_powerstat_poll HAMLIB_PARAMS((AMP *amp, int interval_ms));
+
+extern HAMLIB_EXPORT(int)
+amp_get_level_cached HAMLIB_PARAMS((AMP *amp,
+                                    setting_t level,
+                                    value_t *val,
+                                    double *age_ms));
+
+extern HAMLIB_EXPORT(int)
+amp_get_powerstat_cached HAMLIB_PARAMS((AMP *amp,
+                                        powerstat_t *status,
+                                        double *age_ms));
+
+extern HAMLIB_EXPORT(int)
+amp_get_cache_stats HAMLIB_PARAMS((AMP *amp,
+                                   hamlib_amp_cache_stats_t *stats));
+
 
 extern HAMLIB_EXPORT(int)
 amp_register HAMLIB_PARAMS((const struct amp_caps *caps));
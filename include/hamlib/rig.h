@@ -151,6 +151,7 @@ typedef struct
     int flush;  // flush flag for stop_morse
 #ifdef _PTHREAD_H
     pthread_mutex_t mutex;
+    pthread_cond_t cond;    // signalled on push, flush and fifo_wake
 #else
     int mutex;
 #endif
@@ -205,6 +206,7 @@ enum rig_errcode_e {
     RIG_EDEPRECATED,/*!< 18 Function deprecated */
     RIG_ESECURITY,  /*!< 19 Security error */
     RIG_EPOWER,     /*!< 20 Rig not powered on */
+    RIG_ECANCELED,  /*!< 21 Operation cancelled */
     RIG_EEND        // MUST BE LAST ITEM IN LAST
 };
 /**
@@ -318,6 +320,7 @@ typedef enum rig_port_e {
     RIG_PORT_CM108,         /*!< CM108 GPIO */
     RIG_PORT_GPIO,          /*!< GPIO */
     RIG_PORT_GPION,         /*!< GPIO inverted */
+    RIG_PORT_REPLAY,        /*!< Replay of a recorded port trace */
 } rig_port_t;
 
 
@@ -822,6 +825,7 @@ RIG_BANDSELECT_10M | RIG_BANDSELECT_6M)
 #define RIG_BANDSELECT_UHF (RIG_BANDSELECT_70CM)
 
 
+
 /**
  * \brief Rig Scan operation
  *
@@ -1195,6 +1199,28 @@ typedef uint64_t setting_t;
  */
 #define RIG_SETTING_MAX 64
 
+
+/**
+ * \brief One band of a rig's band map
+ *
+ * The band map holds the bands a rig can tune, sorted by frequency.  It
+ * is built by rig_open() from the rig's frequency ranges and its
+ * BANDSELECT parm list.
+ *
+ * \sa rig_lookup_band(), rig_get_band_info(), rig_get_band_map()
+ */
+typedef struct hamlib_band_edge {
+    freq_t start;           /*!< Lowest frequency of the band in Hz */
+    freq_t stop;            /*!< Highest frequency of the band in Hz */
+    setting_t bandselect;   /*!< RIG_BANDSELECT_* of the band */
+    const char *name;       /*!< BANDSELECT name, e.g. "BAND20M" */
+    int rig_band;           /*!< Index of the band in the rig's BANDSELECT parm, -1 if not there */
+} hamlib_band_edge_t;
+
+//! @cond Doxygen_Suppress
+struct rig_band_map;
+//! @endcond
+
 /**
  * \brief Transceive mode
  * The rig notifies the host of any event, like freq changed, mode changed, etc.
@@ -1852,6 +1878,29 @@ struct rig_spectrum_line
     unsigned char *spectrum_data; /*!< 8-bit spectrum data covering bandwidth of either the span_freq in center mode or from low edge to high edge in fixed mode. A higher value represents higher signal strength. */
 };
 
+/**
+ * \brief How the bins of a spectrum reduction combine their points
+ *
+ * \sa rig_spectrum_subscribe()
+ */
+typedef enum {
+    RIG_SPECTRUM_BIN_MAX,       /*!< Strongest point, keeps narrow signals visible */
+    RIG_SPECTRUM_BIN_MEAN       /*!< Mean of the points, smooths the noise floor */
+} rig_spectrum_bin_t;
+
+/**
+ * \brief Spectrum reduction of one subscriber
+ *
+ * \sa rig_spectrum_subscribe(), rig_spectrum_reduction_parse()
+ */
+typedef struct rig_spectrum_reduction {
+    int width;                  /*!< Points of the reduced line, 0 keeps the points of the rig */
+    rig_spectrum_bin_t bin;     /*!< How a point of the reduced line combines the points it covers */
+    int average;                /*!< Exponential average over about 2^average lines, 0 to 8, 0 for none */
+    int peak_hold_ms;           /*!< Hold the peak of each point this long, 0 for none */
+    int interval_ms;            /*!< Shortest time between two reduced lines, 0 for every line */
+} rig_spectrum_reduction_t;
+
 /**
  * \brief Rig data structure.
  *
@@ -2547,6 +2596,188 @@ typedef enum {
     HAMLIB_CACHE_WIDTH
 } hamlib_cache_t;
 
+/**
+ * \brief Adaptive cache policy
+ *
+ * Current state of the adaptive cache timeouts, see the cache_adaptive
+ * configuration token and rig_get_cache_policy().
+ */
+typedef struct hamlib_cache_policy {
+    int adaptive;           /*!< True when the cache timeouts adapt to the port load */
+    int target_load;        /*!< Port load aimed for, in percent */
+    int max_ms;             /*!< Longest cache timeout, the staleness bound */
+    double load;            /*!< Port load measured over the last window, in percent */
+    double backoff;         /*!< Current timeout multiplier */
+    int timeout_ms[HAMLIB_CACHE_WIDTH + 1];    /*!< Cache timeout of each class */
+    double latency_ms[HAMLIB_CACHE_WIDTH + 1]; /*!< Average backend read time of each class */
+} hamlib_cache_policy_t;
+
+/**
+ * \brief Port trace counters
+ *
+ * Transaction counters kept while a port trace is being recorded or
+ * replayed, see the trace_record and trace_replay configuration tokens.
+ */
+typedef struct hamlib_trace_stats {
+    unsigned long writes;           /*!< Number of blocks written */
+    unsigned long reads;            /*!< Number of successful reads */
+    unsigned long read_errors;      /*!< Number of reads that timed out or failed */
+    unsigned long bytes_written;    /*!< Total bytes written */
+    unsigned long bytes_read;       /*!< Total bytes read */
+    unsigned long mismatches;       /*!< Replay only: writes differing from the recording */
+} hamlib_trace_stats_t;
+
+/**
+ * \brief Asynchronous set command
+ *
+ * \sa rig_set_freq_async()
+ */
+typedef enum {
+    RIG_ASYNC_SET_FREQ,         /*!< rig_set_freq() */
+    RIG_ASYNC_SET_SPLIT_FREQ,   /*!< rig_set_split_freq() */
+    RIG_ASYNC_SET_MODE          /*!< rig_set_mode() */
+} rig_async_set_cmd_t;
+
+/**
+ * \brief An asynchronous set as applied, passed to the completion callback
+ */
+typedef struct rig_async_set {
+    rig_async_set_cmd_t cmd;    /*!< Command */
+    vfo_t vfo;                  /*!< Target VFO */
+    freq_t freq;                /*!< Frequency of RIG_ASYNC_SET_FREQ and RIG_ASYNC_SET_SPLIT_FREQ */
+    rmode_t mode;               /*!< Mode of RIG_ASYNC_SET_MODE */
+    pbwidth_t width;            /*!< Passband width of RIG_ASYNC_SET_MODE */
+    unsigned long coalesced;    /*!< Older values of this command and VFO this one replaced */
+    double queued_ms;           /*!< Time from queuing this value to the end of the command */
+} rig_async_set_t;
+
+/**
+ * \brief Asynchronous set completion callback
+ *
+ * Called from the async set thread after each command with its return code.
+ */
+typedef void (*rig_async_set_cb_t)(RIG *rig, const rig_async_set_t *set,
+                                   int retval, rig_ptr_t arg);
+
+/**
+ * \brief Asynchronous set counters
+ *
+ * \sa rig_get_async_set_stats()
+ */
+typedef struct hamlib_async_set_stats {
+    unsigned long requests;     /*!< Asynchronous sets queued */
+    unsigned long coalesced;    /*!< Sets replaced by a newer value before they were sent */
+    unsigned long applied;      /*!< Commands sent to the rig */
+    unsigned long failed;       /*!< Commands that returned an error */
+    int pending;                /*!< Sets waiting to be sent */
+    double max_queued_ms;       /*!< Longest time from queuing a value to the end of its command */
+} hamlib_async_set_stats_t;
+
+/**
+ * \brief Step of rig_open() or rig_close(), reported by rig_open_async() and rig_close_async()
+ *
+ * The open steps come in this order, and a step is left out when the rig
+ * does not need it.
+ */
+typedef enum {
+    RIG_OPEN_STEP_PORT,         /*!< Opening the rig port */
+    RIG_OPEN_STEP_LINES,        /*!< Opening the PTT and DCD lines */
+    RIG_OPEN_STEP_POWERSTAT,    /*!< Probing the power status */
+    RIG_OPEN_STEP_BACKEND,      /*!< Backend open, waking up the rig */
+    RIG_OPEN_STEP_STATE,        /*!< Reading VFO, frequency, mode and split */
+    RIG_OPEN_STEP_CLOSE_BACKEND, /*!< Backend close, restoring the rig's transceive state */
+    RIG_OPEN_STEP_CLOSE_PORT,   /*!< Closing the lines and the rig port */
+    RIG_OPEN_STEP_DONE          /*!< Open or close ended with the return code passed */
+} rig_open_step_t;
+
+/**
+ * \brief Asynchronous open and close progress callback
+ *
+ * Called from the open thread as each step starts with RIG_OK, and at
+ * the end with RIG_OPEN_STEP_DONE and the return code of the open or close.
+ */
+typedef void (*rig_open_progress_cb_t)(RIG *rig, rig_open_step_t step,
+                                       int retval, rig_ptr_t arg);
+
+/**
+ * \brief Station event loop shared by the rigs, rotators and amplifiers of a station
+ *
+ * \sa rig_station_new()
+ */
+typedef struct hamlib_station hamlib_station_t;
+
+/**
+ * \brief Station event loop counters
+ *
+ * \sa rig_station_get_stats()
+ */
+typedef struct hamlib_station_stats {
+    int sources;                /*!< Ports and timers the loop serves */
+    unsigned long wakeups;      /*!< Times the loop woke up */
+    unsigned long events;       /*!< Port reads dispatched */
+    unsigned long timers;       /*!< Timers run */
+    double max_late_ms;         /*!< Longest time a loop timer ran after it was due */
+    double io_max_late_ms;      /*!< The same for the port polls of the I/O thread */
+} hamlib_station_stats_t;
+
+/**
+ * \brief One key down or key up interval of a software keyer timeline
+ *
+ * \sa rig_keyer_timeline()
+ */
+typedef struct rig_keyer_element {
+    int key;                    /*!< 1 for key down, 0 for key up */
+    int duration_us;            /*!< Length of the interval in microseconds */
+} rig_keyer_element_t;
+
+/**
+ * \brief Timing of the software keyer
+ *
+ * \sa rig_keyer_timeline()
+ */
+typedef struct rig_keyer_params {
+    int wpm;                    /*!< Character speed in words per minute of PARIS */
+    int farnsworth_wpm;         /*!< Overall speed with the spaces stretched, 0 or not below wpm for none */
+    int weight;                 /*!< Dot key down share in percent of a dot and its space, 50 for 1:1 */
+} rig_keyer_params_t;
+
+/**
+ * \brief Software keyer line callback
+ *
+ * Called from the keyer thread at each key down (key 1) and key up (key 0)
+ * after the keyer line is set.
+ */
+typedef int (*rig_keyer_cb_t)(RIG *rig, int key, rig_ptr_t arg);
+
+/**
+ * \brief Software keyer timing counters
+ *
+ * \sa rig_get_keyer_stats()
+ */
+typedef struct hamlib_keyer_stats {
+    unsigned long edges;        /*!< Key downs and key ups */
+    unsigned long late;         /*!< Edges more than 1 ms after their deadline */
+    double mean_us;             /*!< Mean time from the deadline of an edge to the line being set */
+    double max_us;              /*!< Longest time from the deadline of an edge to the line being set */
+    int realtime;               /*!< True when the keyer thread runs at a real-time priority */
+} hamlib_keyer_stats_t;
+
+/**
+ * \brief Station automation counters
+ *
+ * \sa rig_automation_get_stats()
+ */
+typedef struct hamlib_automation_stats {
+    unsigned long band_changes;     /*!< Band changes acted on */
+    unsigned long actions;          /*!< Antenna, amplifier and rotator commands sent */
+    unsigned long failed;           /*!< Commands that returned an error */
+    unsigned long interlocks;       /*!< PTT requests held until band switching was done */
+    unsigned long interlock_timeouts; /*!< PTT requests refused because switching took too long */
+    double last_interlock_ms;       /*!< Time the last held PTT request waited */
+    double max_interlock_ms;        /*!< Longest time a PTT request waited */
+    double max_switch_ms;           /*!< Longest time from a band change to its last action done */
+} hamlib_automation_stats_t;
+
 typedef enum {
     TWIDDLE_OFF,
     TWIDDLE_ON
@@ -2860,6 +3091,38 @@ struct rig_state {
     int post_ptt_delay;         /*!< delay after PTT to allow for relays and such */
     struct timespec freq_event_elapsed;
     int freq_skip; /*!< allow frequency skip for gpredict RX/TX freq set */
+    char *trace_record_pathname; /*!< File to record rig port traffic to, NULL to disable */
+    char *trace_replay_pathname; /*!< Trace file to replay instead of opening the rig port, NULL to disable */
+    int trace_timing; /*!< Replay timing in percent of the recorded timing, 0 replays as fast as possible */
+    hamlib_trace_stats_t trace_stats; /*!< Port trace counters */
+    int cache_timeouts_ms[HAMLIB_CACHE_WIDTH + 1]; /*!< Cache timeout of each hamlib_cache_t class */
+    int cache_adaptive; /*!< True adapts the cache timeouts to the measured port load */
+    int cache_target_load; /*!< Adaptive cache: port load to aim for in percent */
+    int cache_max_ms; /*!< Adaptive cache: longest cache timeout, i.e. the staleness bound */
+    double cache_latency_ms[HAMLIB_CACHE_WIDTH + 1]; /*!< Adaptive cache: average backend read time of each class */
+    double cache_backoff; /*!< Adaptive cache: timeout multiplier, raised while the port is busy */
+    double port_busy_ms; /*!< Adaptive cache: rig port busy time in the current load window */
+    double port_load; /*!< Adaptive cache: rig port load in the last load window, 0 to 1 */
+    struct timespec port_load_window; /*!< Adaptive cache: start of the current load window */
+    struct rig_band_map *band_map; /*!< Bands the rig can tune, built by rig_open() */
+    int async_set; /*!< True queues rig_set_freq(), rig_set_split_freq() and rig_set_mode() as with rig_set_freq_async() */
+    void *async_set_priv_data;
+    void *automation_priv_data;
+    int shared_handle; /*!< True when the handle is a private mapping of the shared state of its model, see rig_init() */
+    int multicast_delta; /*!< True publishes only the changed fields between multicast keyframes */
+    int multicast_keyframe_ms; /*!< Longest time between multicast keyframes in delta mode, 0 sends them only on request */
+    char *multicast_spectrum; /*!< Spectrum reduction of the multicast scope lines as for rig_spectrum_reduction_parse(), NULL or empty for none */
+    void *spectrum_reduce_priv_data;
+    ptt_type_t keyer_type; /*!< Line the software keyer keys, RIG_PTT_NONE for the rig's own keyer */
+    char *keyer_pathname; /*!< Device of the software keyer line, NULL for the rig port */
+    int keyer_bitnum; /*!< CM108 GPIO bit of the software keyer line */
+    int keyer_wpm; /*!< Software keyer character speed */
+    int keyer_farnsworth_wpm; /*!< Software keyer overall speed, 0 for none */
+    int keyer_weight; /*!< Software keyer weighting in percent */
+    void *keyer_priv_data;
+    void *async_open_priv_data;
+    void *station; /*!< Station event loop of the rig, see rig_station_add_rig() */
+    pthread_mutex_t ptt_mutex; /*!< Lock of PTT on a line of its own, so keying never waits for the CAT lock */
 // New rig_state items go before this line ============================================
 };
 
@@ -3825,6 +4088,7 @@ extern HAMLIB_EXPORT(void) rig_no_restore_ai(void);
 
 extern HAMLIB_EXPORT(int) rig_get_cache_timeout_ms(RIG *rig, hamlib_cache_t selection);
 extern HAMLIB_EXPORT(int) rig_set_cache_timeout_ms(RIG *rig, hamlib_cache_t selection, int ms);
+extern HAMLIB_EXPORT(int) rig_get_cache_policy(RIG *rig, hamlib_cache_policy_t *policy);
 
 extern HAMLIB_EXPORT(int) rig_set_vfo_opt(RIG *rig, int status);
 extern HAMLIB_EXPORT(int) rig_get_vfo_info(RIG *rig, vfo_t vfo, freq_t *freq, rmode_t *mode, pbwidth_t *width, split_t *split, int *satmode);
@@ -3869,9 +4133,52 @@ enum GPIO { GPIO1, GPIO2, GPIO3, GPIO4 };
 extern HAMLIB_EXPORT(int) rig_cm108_get_bit(hamlib_port_t *p, enum GPIO gpio, int *bit);
 extern HAMLIB_EXPORT(int) rig_cm108_set_bit(hamlib_port_t *p, enum GPIO gpio, int bit);
 extern HAMLIB_EXPORT(int) rig_band_changed(RIG *rig, hamlib_bandselect_t band);
+extern HAMLIB_EXPORT(int) rig_lookup_band(RIG *rig, freq_t freq, const hamlib_band_edge_t **band);
+extern HAMLIB_EXPORT(int) rig_get_band_info(RIG *rig, setting_t bandselect, const hamlib_band_edge_t **band);
+extern HAMLIB_EXPORT(int) rig_get_band_map(RIG *rig, const hamlib_band_edge_t **bands, int *count);
 
 extern HAMLIB_EXPORT(void *) rig_data_pointer(RIG *rig, rig_ptrx_t idx);
 
+extern HAMLIB_EXPORT(int) rig_get_trace_stats(RIG *rig, hamlib_trace_stats_t *stats);
+
+extern HAMLIB_EXPORT(int) rig_set_freq_async(RIG *rig, vfo_t vfo, freq_t freq);
+extern HAMLIB_EXPORT(int) rig_set_split_freq_async(RIG *rig, vfo_t vfo, freq_t tx_freq);
+extern HAMLIB_EXPORT(int) rig_set_mode_async(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width);
+extern HAMLIB_EXPORT(int) rig_set_async_callback(RIG *rig, rig_async_set_cb_t cb, rig_ptr_t arg);
+extern HAMLIB_EXPORT(int) rig_async_set_flush(RIG *rig, int timeout_ms);
+extern HAMLIB_EXPORT(int) rig_get_async_set_stats(RIG *rig, hamlib_async_set_stats_t *stats);
+
+extern HAMLIB_EXPORT(int) rig_open_async(RIG *rig, rig_open_progress_cb_t cb, rig_ptr_t arg);
+extern HAMLIB_EXPORT(int) rig_close_async(RIG *rig, rig_open_progress_cb_t cb, rig_ptr_t arg);
+extern HAMLIB_EXPORT(int) rig_open_wait(RIG *rig, int timeout_ms);
+extern HAMLIB_EXPORT(int) rig_open_cancel(RIG *rig);
+
+extern HAMLIB_EXPORT(int) rig_spectrum_subscribe(RIG *rig, const rig_spectrum_reduction_t *reduction, spectrum_cb_t cb, rig_ptr_t arg);
+extern HAMLIB_EXPORT(int) rig_spectrum_unsubscribe(RIG *rig, int subscriber);
+extern HAMLIB_EXPORT(int) rig_spectrum_reduction_parse(const char *spec, rig_spectrum_reduction_t *reduction);
+
+extern HAMLIB_EXPORT(int) rig_keyer_timeline(const char *text, const rig_keyer_params_t *params, rig_keyer_element_t *elements, int max);
+extern HAMLIB_EXPORT(int) rig_set_keyer_callback(RIG *rig, rig_keyer_cb_t cb, rig_ptr_t arg);
+extern HAMLIB_EXPORT(int) rig_get_keyer_stats(RIG *rig, hamlib_keyer_stats_t *stats);
+
+struct amp;
+struct s_rot;
+extern HAMLIB_EXPORT(int) rig_automation_load(RIG *rig, const char *path);
+extern HAMLIB_EXPORT(int) rig_automation_attach(RIG *rig, struct amp *amp, struct s_rot *rot);
+extern HAMLIB_EXPORT(int) rig_automation_wait(RIG *rig, int timeout_ms);
+extern HAMLIB_EXPORT(int) rig_automation_get_stats(RIG *rig, hamlib_automation_stats_t *stats);
+
+extern HAMLIB_EXPORT(hamlib_station_t *) rig_station_new(void);
+extern HAMLIB_EXPORT(int) rig_station_add_rig(hamlib_station_t *st, RIG *rig);
+extern HAMLIB_EXPORT(int) rig_station_add_rot(hamlib_station_t *st, struct s_rot *rot);
+extern HAMLIB_EXPORT(int) rig_station_add_amp(hamlib_station_t *st, struct amp *amp);
+extern HAMLIB_EXPORT(int) rig_station_start(hamlib_station_t *st);
+extern HAMLIB_EXPORT(int) rig_station_stop(hamlib_station_t *st);
+extern HAMLIB_EXPORT(int) rig_station_get_fd(hamlib_station_t *st);
+extern HAMLIB_EXPORT(int) rig_station_dispatch(hamlib_station_t *st, int timeout_ms);
+extern HAMLIB_EXPORT(int) rig_station_get_stats(hamlib_station_t *st, hamlib_station_stats_t *stats);
+extern HAMLIB_EXPORT(int) rig_station_free(hamlib_station_t *st);
+
 //! @endcond
 
 __END_DECLS
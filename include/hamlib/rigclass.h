@@ -24,14 +24,47 @@
 
 #include <hamlib/rig.h>
 #include <iostream>
+#if __cplusplus >= 201103L
+#include <chrono>
+#include <functional>
+#include <future>
+#endif
 
 
 //! @cond Doxygen_Suppress
+#if __cplusplus >= 201103L
+// Result of an asynchronous request, time is when the rig answered
+template <class T>
+struct RigReply
+{
+    T value;
+    std::chrono::steady_clock::time_point time;
+};
+
+struct RigMode
+{
+    rmode_t mode;
+    pbwidth_t width;
+};
+#endif
+
+struct RigAsyncStats
+{
+    unsigned long requests;     // asynchronous requests made
+    unsigned long merged;       // reads answered by an identical queued read
+    unsigned long executed;     // requests that reached the rig
+};
+
+class RigWorker;
+
 class HAMLIB_CPP_IMPEXP Rig
 {
 private:
     RIG *theRig;  // Global ref. to the rig
 
+    // asynchronous request queue, started on first use
+    RigWorker &asyncWorker();
+
 protected:
 public:
     explicit Rig(rig_model_t rig_model);
@@ -176,6 +209,53 @@ public:
     shortfreq_t getResolution(rmode_t mode);
     void reset(reset_t reset);
 
+#if __cplusplus >= 201103L
+    // Asynchronous interface.  Requests run in order on a worker thread
+    // owned by this Rig, so the caller never waits for the rig.  A read
+    // still waiting in the queue answers later identical reads too,
+    // unless a write was queued in between.  Futures throw RigException
+    // from get() when the request failed, callbacks run on the worker
+    // thread and get the Hamlib return code.  An exception thrown by a
+    // callback is caught and logged.  open() and close() wait for queued
+    // requests to finish; other synchronous calls are not ordered with
+    // the queue.  A Rig destroyed from one of its callbacks drops the
+    // requests still queued, whose futures then throw broken_promise.
+    template <class T>
+    using Callback = std::function<void(int, const RigReply<T> &)>;
+    typedef std::function<void(int)> Done;
+
+    std::future<RigReply<freq_t>> getFreqAsync(vfo_t vfo = RIG_VFO_CURR);
+    void getFreqAsync(Callback<freq_t> done, vfo_t vfo = RIG_VFO_CURR);
+    std::future<RigReply<RigMode>> getModeAsync(vfo_t vfo = RIG_VFO_CURR);
+    void getModeAsync(Callback<RigMode> done, vfo_t vfo = RIG_VFO_CURR);
+    std::future<RigReply<vfo_t>> getVFOAsync();
+    void getVFOAsync(Callback<vfo_t> done);
+    std::future<RigReply<ptt_t>> getPTTAsync(vfo_t vfo = RIG_VFO_CURR);
+    void getPTTAsync(Callback<ptt_t> done, vfo_t vfo = RIG_VFO_CURR);
+    std::future<RigReply<value_t>> getLevelAsync(setting_t level,
+            vfo_t vfo = RIG_VFO_CURR);
+    void getLevelAsync(Callback<value_t> done, setting_t level,
+                       vfo_t vfo = RIG_VFO_CURR);
+    std::future<RigReply<freq_t>> getSplitFreqAsync(vfo_t vfo = RIG_VFO_CURR);
+    void getSplitFreqAsync(Callback<freq_t> done, vfo_t vfo = RIG_VFO_CURR);
+
+    std::future<void> setFreqAsync(freq_t freq, vfo_t vfo = RIG_VFO_CURR);
+    void setFreqAsync(Done done, freq_t freq, vfo_t vfo = RIG_VFO_CURR);
+    std::future<void> setModeAsync(rmode_t mode,
+                                   pbwidth_t width = RIG_PASSBAND_NORMAL,
+                                   vfo_t vfo = RIG_VFO_CURR);
+    std::future<void> setVFOAsync(vfo_t vfo);
+    std::future<void> setPTTAsync(ptt_t ptt, vfo_t vfo = RIG_VFO_CURR);
+    std::future<void> setLevelAsync(setting_t level, value_t val,
+                                    vfo_t vfo = RIG_VFO_CURR);
+    std::future<void> setSplitFreqAsync(freq_t tx_freq, vfo_t vfo = RIG_VFO_CURR);
+
+    // run any other call on the worker, in order with the queue
+    std::future<void> callAsync(std::function<void(Rig &)> fn);
+#endif
+
+    RigAsyncStats getAsyncStats();
+
     // callbacks available in your derived object
 // cppcheck-suppress unusedFunction
     virtual int FreqEvent(vfo_t, freq_t, rig_ptr_t) const
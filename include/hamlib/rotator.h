@@ -508,6 +508,8 @@ struct rot_state {
     int current_speed;      /*!< Current speed 1-100, to be used when no change to speed is requested. */
     hamlib_port_t rotport;  /*!< Rotator port (internal use). */
     hamlib_port_t rotport2;  /*!< 2nd Rotator port (internal use). */
+    rig_ptr_t track_priv;   /*!< Trajectory tracker (internal use). */
+    rig_ptr_t station;      /*!< Station event loop, see rig_station_add_rot() (internal use). */
 };
 
 
@@ -528,6 +530,68 @@ struct s_rot {
 };
 
 
+/**
+ * \brief A point of a trajectory
+ *
+ * \sa rot_track_start()
+ */
+typedef struct rot_track_point {
+    double time;            /*!< When, in seconds since the Unix epoch. */
+    azimuth_t az;           /*!< Azimuth in degrees, any turn. */
+    elevation_t el;         /*!< Elevation in degrees. */
+} rot_track_point_t;
+
+/**
+ * \brief Trajectory tracker state
+ *
+ * \sa rot_track_get_status()
+ */
+typedef enum {
+    ROT_TRACK_IDLE = 0,     /*!< No trajectory. */
+    ROT_TRACK_WAIT,         /*!< Moving to or waiting at the first point. */
+    ROT_TRACK_TRACKING,     /*!< Following the trajectory. */
+    ROT_TRACK_DONE,         /*!< At the last point. */
+    ROT_TRACK_ERROR         /*!< Stopped, the rotator did not answer. */
+} rot_track_state_t;
+
+/**
+ * \brief Trajectory tracker status
+ *
+ * Angles are as sent to the rotator, so a flipped trajectory has
+ * elevations over 90 degrees.
+ *
+ * \sa rot_track_get_status()
+ */
+typedef struct rot_track_status {
+    rot_track_state_t state;    /*!< Tracker state. */
+    int flipped;                /*!< Trajectory followed over the zenith. */
+    azimuth_t az;               /*!< Last position read. */
+    elevation_t el;             /*!< Last position read. */
+    azimuth_t target_az;        /*!< Where the trajectory is now. */
+    elevation_t target_el;      /*!< Where the trajectory is now. */
+    double error;               /*!< Pointing error at the last read, degrees. */
+    double max_error;           /*!< Largest pointing error while tracking. */
+    double rms_error;           /*!< RMS pointing error while tracking. */
+    double slew_rate;           /*!< Measured slew rate, degrees per second. */
+    double latency_ms;          /*!< Measured command latency. */
+    unsigned long commands;     /*!< Positions sent. */
+    unsigned long polls;        /*!< Positions read. */
+} rot_track_status_t;
+
+
+/**
+ * \brief Local station for qrb_bulk()
+ *
+ * Filled in by qrb_origin_set().
+ */
+typedef struct qrb_origin {
+    double lon;         /*!< Longitude, radians. */
+    double lat;         /*!< Latitude, radians. */
+    double sin_lat;     /*!< Sine of the latitude. */
+    double cos_lat;     /*!< Cosine of the latitude. */
+} qrb_origin_t;
+
+
 //! @cond Doxygen_Suppress
 /* --------------- API function prototypes -----------------*/
 
@@ -668,6 +732,18 @@ extern HAMLIB_EXPORT(int)
 rot_get_status HAMLIB_PARAMS((ROT *rot,
         rot_status_t *status));
 
+extern HAMLIB_EXPORT(int)
+rot_track_start HAMLIB_PARAMS((ROT *rot,
+                               const rot_track_point_t *points,
+                               int npoints));
+
+extern HAMLIB_EXPORT(int)
+rot_track_stop HAMLIB_PARAMS((ROT *rot));
+
+extern HAMLIB_EXPORT(int)
+rot_track_get_status HAMLIB_PARAMS((ROT *rot,
+                                    rot_track_status_t *status));
+
 extern HAMLIB_EXPORT(int)
 rot_register HAMLIB_PARAMS((const struct rot_caps *caps));
 
@@ -752,6 +828,28 @@ distance_long_path HAMLIB_PARAMS((double distance));
 extern HAMLIB_EXPORT(double)
 azimuth_long_path HAMLIB_PARAMS((double azimuth));
 
+extern HAMLIB_EXPORT(int)
+qrb_origin_set HAMLIB_PARAMS((qrb_origin_t *origin,
+                              double lon,
+                              double lat));
+
+extern HAMLIB_EXPORT(int)
+qrb_bulk HAMLIB_PARAMS((const qrb_origin_t *origin,
+                        int n,
+                        const double *lon,
+                        const double *lat,
+                        double *distance,
+                        double *azimuth,
+                        double *azimuth_long));
+
+extern HAMLIB_EXPORT(int)
+qrb_bulk_locator HAMLIB_PARAMS((const qrb_origin_t *origin,
+                                int n,
+                                const char *const *locator,
+                                double *distance,
+                                double *azimuth,
+                                double *azimuth_long));
+
 #if 0
 extern HAMLIB_EXPORT(int)
 longlat2locator HAMLIB_PARAMS((double longitude,
@@ -49,7 +49,8 @@
 #define NB_CHAN 22      /* see caps->chan_list */
 
 
-#define CMDSLEEP 20*1000  /* ms for each command */
+/* us for each command, cmd_latency conf, 20ms by default */
+#define CMDSLEEP (((struct dummy_priv_data *)rig->state.priv)->cmd_latency_ms * 1000)
 
 struct dummy_priv_data
 {
@@ -81,6 +82,7 @@ struct dummy_priv_data
 
     char *magic_conf;
     int static_data;
+    int cmd_latency_ms;
 
     //freq_t freq_vfoa;
     //freq_t freq_vfob;
@@ -138,6 +140,10 @@ static const struct confparams dummy_cfg_params[] =
         TOK_CFG_STATIC_DATA, "static_data", "Static data", "Output only static data, no randomization of meter values",
         "0", RIG_CONF_CHECKBUTTON, { }
     },
+    {
+        TOK_CFG_CMD_LATENCY, "cmd_latency", "Command latency", "Time each command takes in ms, to emulate a slow CAT link",
+        "20", RIG_CONF_NUMERIC, { .n = { 0, 10000, 1 } }
+    },
     { RIG_CONF_END, NULL, }
 };
 
@@ -313,6 +319,7 @@ static int dummy_init(RIG *rig)
     }
 
     priv->magic_conf = strdup("DX");
+    priv->cmd_latency_ms = 20;
 
     RETURNFUNC(RIG_OK);
 }
@@ -397,6 +404,10 @@ static int dummy_set_conf(RIG *rig, hamlib_token_t token, const char *val)
         priv->static_data = atoi(val) ? 1 : 0;
         break;
 
+    case TOK_CFG_CMD_LATENCY:
+        priv->cmd_latency_ms = atoi(val);
+        break;
+
     default:
         RETURNFUNC(-RIG_EINVAL);
     }
@@ -417,6 +428,10 @@ static int dummy_get_conf(RIG *rig, hamlib_token_t token, char *val)
         strcpy(val, priv->magic_conf);
         break;
 
+    case TOK_CFG_CMD_LATENCY:
+        sprintf(val, "%d", priv->cmd_latency_ms);
+        break;
+
     default:
         RETURNFUNC(-RIG_EINVAL);
     }
@@ -1776,6 +1791,8 @@ static int dummy_set_ant(RIG *rig, vfo_t vfo, ant_t ant, value_t option)
     channel_t *curr = priv->curr;
     ENTERFUNC;
 
+    usleep(CMDSLEEP);
+
     switch (ant)
     {
     case RIG_ANT_CURR:
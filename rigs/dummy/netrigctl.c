@@ -863,9 +863,12 @@ static int netrigctl_open(RIG *rig)
                     int level;
                     sscanf(p, "%d", &level);
 
-                    rig->caps->parm_gran[i].step.s = 0;
-
-                    if (RIG_PARM_IS_FLOAT(level))
+                    // level is the index, the string lists are not sent
+                    if (RIG_PARM_IS_STRING(rig_idx2setting(level)))
+                    {
+                        rig->caps->parm_gran[i].step.s = rs->parm_gran[i].step.s = NULL;
+                    }
+                    else if (RIG_PARM_IS_FLOAT(rig_idx2setting(level)))
                     {
                         double min, max, step;
                         sscanf(p, "%*d=%lf,%lf,%lf", &min, &max, &step);
@@ -873,10 +876,6 @@ static int netrigctl_open(RIG *rig)
                         rig->caps->parm_gran[i].max.f = rs->parm_gran[i].max.f = max;
                         rig->caps->parm_gran[i].step.f = rs->parm_gran[i].step.f = step;
                     }
-                    else if (RIG_PARM_IS_STRING(level))
-                    {
-                        rig->caps->parm_gran[i].step.s = strdup(value);
-                    }
                     else // must be INT
                     {
                         int min, max, step;
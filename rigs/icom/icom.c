@@ -8786,6 +8786,17 @@ int icom_mW2power(RIG *rig, float *power, unsigned int mwpower, freq_t freq,
 
 
 #if defined(HAVE_PTHREAD)
+/* division, max division and the two frequencies of a scope frame */
+static const bcd_field_t icom_spectrum_header[] =
+{
+    { 1, 1 * 2, 0 },
+    { 2, 1 * 2, 0 },
+    { 4, 5 * 2, 0 },
+    { 9, 5 * 2, 0 },
+};
+
+#define ICOM_SPECTRUM_HEADER_LENGTH 15
+
 static int icom_parse_spectrum_frame(RIG *rig, size_t length,
                                      const unsigned char *frame_data)
 {
@@ -8794,14 +8805,28 @@ static int icom_parse_spectrum_frame(RIG *rig, size_t length,
     struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
     struct icom_spectrum_scope_cache *cache;
 
-    int division = (int) from_bcd(frame_data + 1, 1 * 2);
-    int max_division = (int) from_bcd(frame_data + 2, 1 * 2);
+    unsigned long long header[4];
+    int division;
+    int max_division;
 
     size_t spectrum_data_length_in_frame;
     const unsigned char *spectrum_data_start_in_frame;
 
     ENTERFUNC;
 
+    // division 1 starts a sweep and has the frequencies too, decode them at once
+    if (from_bcd_fields(frame_data, length, icom_spectrum_header,
+                        length >= ICOM_SPECTRUM_HEADER_LENGTH && frame_data[1] == 0x01 ? 4 : 2,
+                        header) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: short spectrum scope frame: %d bytes\n",
+                  __func__, (int) length);
+        RETURNFUNC(-RIG_EPROTO);
+    }
+
+    division = (int) header[0];
+    max_division = (int) header[1];
+
     // The first byte indicates spectrum scope ID/VFO: 0 = Main, 1 = Sub
     int spectrum_id = frame_data[0];
 
@@ -8816,8 +8841,18 @@ static int icom_parse_spectrum_frame(RIG *rig, size_t length,
 
     if (division == 1)
     {
-        int spectrum_scope_mode = frame_data[3];
-        int out_of_range = frame_data[14];
+        int spectrum_scope_mode;
+        int out_of_range;
+
+        if (length < ICOM_SPECTRUM_HEADER_LENGTH)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: short spectrum scope frame: %d bytes\n",
+                      __func__, (int) length);
+            RETURNFUNC(-RIG_EPROTO);
+        }
+
+        spectrum_scope_mode = frame_data[3];
+        out_of_range = frame_data[14];
 
         cache->spectrum_mode = RIG_SPECTRUM_MODE_NONE;
 
@@ -8825,8 +8860,8 @@ static int icom_parse_spectrum_frame(RIG *rig, size_t length,
         {
         case SCOPE_MODE_CENTER:
             cache->spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
-            cache->spectrum_center_freq = (freq_t) from_bcd(frame_data + 4, 5 * 2);
-            cache->spectrum_span_freq = (freq_t) from_bcd(frame_data + 9, 5 * 2) * 2;
+            cache->spectrum_center_freq = (freq_t) header[2];
+            cache->spectrum_span_freq = (freq_t) header[3] * 2;
             cache->spectrum_low_edge_freq = cache->spectrum_center_freq -
                                             cache->spectrum_span_freq / 2;
             cache->spectrum_high_edge_freq = cache->spectrum_center_freq +
@@ -8848,8 +8883,8 @@ static int icom_parse_spectrum_frame(RIG *rig, size_t length,
                 cache->spectrum_mode = RIG_SPECTRUM_MODE_FIXED_SCROLL;
             }
 
-            cache->spectrum_low_edge_freq = (freq_t) from_bcd(frame_data + 4, 5 * 2);
-            cache->spectrum_high_edge_freq = (freq_t) from_bcd(frame_data + 9, 5 * 2);
+            cache->spectrum_low_edge_freq = (freq_t) header[2];
+            cache->spectrum_high_edge_freq = (freq_t) header[3];
             cache->spectrum_span_freq = (cache->spectrum_high_edge_freq -
                                          cache->spectrum_low_edge_freq);
             cache->spectrum_center_freq = cache->spectrum_high_edge_freq -
@@ -8862,8 +8897,8 @@ static int icom_parse_spectrum_frame(RIG *rig, size_t length,
             RETURNFUNC(-RIG_EPROTO);
         }
 
-        spectrum_data_length_in_frame = length - 15;
-        spectrum_data_start_in_frame = frame_data + 15;
+        spectrum_data_length_in_frame = length - ICOM_SPECTRUM_HEADER_LENGTH;
+        spectrum_data_start_in_frame = frame_data + ICOM_SPECTRUM_HEADER_LENGTH;
 
         memset(cache->spectrum_data, 0,
                priv_caps->spectrum_scope_caps.spectrum_line_length);
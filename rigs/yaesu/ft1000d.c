@@ -29,6 +29,7 @@
  */
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>  /* String function definitions */
 
 #include "hamlib/rig.h"
@@ -37,6 +38,7 @@
 #include "misc.h"
 #include "yaesu.h"
 #include "ft1000d.h"
+#include "ftstatus.h"
 
 // FT1000D native commands
 enum FT1000D_native_cmd_e
@@ -165,6 +167,8 @@ static int ft1000d_get_channel(RIG *rig, vfo_t vfo, channel_t *chan,
 /* Private helper function prototypes */
 static int ft1000d_get_update_data(RIG *rig, unsigned char ci,
                                    unsigned short ch);
+static int ft1000d_get_status(RIG *rig, const void *field, size_t length);
+static void ft1000d_invalidate(RIG *rig, unsigned char ci);
 static int ft1000d_send_static_cmd(RIG *rig, unsigned char ci);
 static int ft1000d_send_dynamic_cmd(RIG *rig, unsigned char ci,
                                     unsigned char p1, unsigned char p2,
@@ -252,6 +256,31 @@ struct ft1000d_priv_data
     split_t split;                              /* split active or not Added on 16 Dec 2016 to include FT1000D function */
     unsigned char p_cmd[YAESU_CMD_LENGTH];    /* private copy of CAT cmd */
     ft1000d_update_data_t update_data;          /* returned data */
+    ftstatus_cache_t status;                    /* age of update_data */
+};
+
+/*
+ * What each update fills in update_data.  The 1636 byte Update All Data
+ * is left out, the smaller updates always hold what a get needs.  The
+ * FT-1000D sends only the front VFO as its OP data.
+ */
+#define FT1000D_FIELD(f) offsetof(ft1000d_update_data_t, f)
+
+static const ftstatus_field_t ft1000d_status_fields[] =
+{
+    { FT1000D_FIELD(flag1), 3, 1 },
+    { FT1000D_FIELD(channelnumber), 1, 1 },
+    { FT1000D_FIELD(current_front), sizeof(ft1000d_op_data_t), 4 },
+    { FT1000D_FIELD(channel), sizeof(ft1000d_op_data_t), 90 },
+};
+
+static const ftstatus_block_t ft1000d_status_blocks[] =
+{
+    { FT1000D_NATIVE_READ_FLAGS, FT1000D_FIELD(flag1), 3, FT1000D_STATUS_FLAGS_LENGTH, 1 },
+    { FT1000D_NATIVE_UPDATE_MEM_CHNL, FT1000D_FIELD(channelnumber), 1, FT1000D_MEM_CHNL_LENGTH, 1 },
+    { FT1000D_NATIVE_UPDATE_OP_DATA, FT1000D_FIELD(current_front), FT1000D_OP_DATA_LENGTH, FT1000D_OP_DATA_LENGTH, 1 },
+    { FT1000D_NATIVE_UPDATE_VFO_DATA, FT1000D_FIELD(vfoa), FT1000D_VFO_DATA_LENGTH, FT1000D_VFO_DATA_LENGTH, 1 },
+    { FT1000D_NATIVE_UPDATE_MEM_CHNL_DATA, FT1000D_FIELD(channel), FT1000D_MEM_CHNL_DATA_LENGTH, FT1000D_MEM_CHNL_DATA_LENGTH, 90 },
 };
 
 /*
@@ -600,6 +629,16 @@ static int ft1000d_init(RIG *rig)
     // Set operating vfo mode to current VFO changed from RIG_VFO_MAIN to RIG_VFO_A December 2016
     priv->current_vfo =  RIG_VFO_A;
 
+    if (ftstatus_init(&priv->status, ft1000d_status_fields,
+                      sizeof(ft1000d_status_fields) / sizeof(ft1000d_status_fields[0]),
+                      ft1000d_status_blocks,
+                      sizeof(ft1000d_status_blocks) / sizeof(ft1000d_status_blocks[0]),
+                      ft1000d_get_update_data) != RIG_OK)
+    {
+        free(rig->state.priv);
+        rig->state.priv = NULL;
+        return -RIG_ENOMEM;
+    }
 
     return RIG_OK;
 }
@@ -619,6 +658,9 @@ static int ft1000d_cleanup(RIG *rig)
 
     if (rig->state.priv)
     {
+        struct ft1000d_priv_data *priv = (struct ft1000d_priv_data *)rig->state.priv;
+
+        ftstatus_cleanup(&priv->status);
         free(rig->state.priv);
     }
 
@@ -662,9 +704,12 @@ static int  ft1000d_open(RIG *rig)
 
 
     // Get current rig settings and status
+    ftstatus_invalidate_all(&priv->status);
+
     if (rig->caps->rig_model != RIG_MODEL_FT1000)
     {
-        err = ft1000d_get_update_data(rig, FT1000D_NATIVE_UPDATE_OP_DATA, 0);
+        err = ft1000d_get_status(rig, &priv->update_data.current_front,
+                                 sizeof(ft1000d_op_data_t));
 
         if (err != RIG_OK)
         {
@@ -785,7 +830,6 @@ static int ft1000d_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     unsigned char *p;
     freq_t f;
     int err;
-    int ci;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
     rig_debug(RIG_DEBUG_TRACE, "%s: passed vfo = 0x%02x\n", __func__, vfo);
@@ -809,18 +853,15 @@ static int ft1000d_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     case RIG_VFO_A:
     case RIG_VFO_VFO:
         p = priv->update_data.vfoa.basefreq;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_B:
         p = priv->update_data.vfob.basefreq;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
         p = priv->update_data.current_front.basefreq;
-        ci = FT1000D_NATIVE_UPDATE_OP_DATA;
         break;
 
     default:
@@ -828,7 +869,7 @@ static int ft1000d_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     }
 
     // Get update data structure to obtain get frequency
-    err = ft1000d_get_update_data(rig, ci, 0);
+    err = ft1000d_get_status(rig, p, 3);
 
     if (err != RIG_OK)
     {
@@ -966,7 +1007,7 @@ static int ft1000d_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
 
     priv = (struct ft1000d_priv_data *) rig->state.priv;
 
-    err = ft1000d_get_update_data(rig, FT1000D_NATIVE_READ_FLAGS, 0);
+    err = ft1000d_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -1046,17 +1087,14 @@ static int ft1000d_set_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t rptr_shift)
     {
     case RIG_VFO_A:
         p = (char *) &priv->update_data.vfoa.mode;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_B:
         p = (char *) &priv->update_data.vfob.mode;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_MEM:
         p = (char *) &priv->update_data.current_front.mode;
-        ci = FT1000D_NATIVE_UPDATE_OP_DATA;
         break;
 
     default:
@@ -1064,7 +1102,7 @@ static int ft1000d_set_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t rptr_shift)
     }
 
     // Get update for selected VFO
-    err = ft1000d_get_update_data(rig, ci, 0);
+    err = ft1000d_get_status(rig, p, 1);
 
     if (err != RIG_OK)
     {
@@ -1134,7 +1172,6 @@ static int ft1000d_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
 {
     struct ft1000d_priv_data *priv;
     ft1000d_op_data_t *p;
-    unsigned char ci;
     int err;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -1161,18 +1198,15 @@ static int ft1000d_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
     case RIG_VFO_A:
     case RIG_VFO_VFO:
         p = &priv->update_data.vfoa;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_B:
         p = &priv->update_data.vfob;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
         p = &priv->update_data.current_front;
-        ci = FT1000D_NATIVE_UPDATE_OP_DATA;
         break;
 
     default:
@@ -1180,7 +1214,7 @@ static int ft1000d_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
     }
 
     // Get update for selected VFO
-    err = ft1000d_get_update_data(rig, ci, 0);
+    err = ft1000d_get_status(rig, p, sizeof(ft1000d_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -1403,7 +1437,7 @@ static int ft1000d_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
     priv = (struct ft1000d_priv_data *) rig->state.priv;
 
     // Read status flags
-    err = ft1000d_get_update_data(rig, FT1000D_NATIVE_READ_FLAGS, 0);
+    err = ft1000d_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -1533,7 +1567,8 @@ static int ft1000d_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
     // If rit = 0 disable RX clarifier
     if (rit == 0)
     {
-        err = ft1000d_get_update_data(rig, FT1000D_NATIVE_UPDATE_OP_DATA, 0);
+        err = ft1000d_get_status(rig,
+                &priv->update_data.current_front, sizeof(ft1000d_op_data_t));
 
         if (err != RIG_OK)
         {
@@ -1602,7 +1637,6 @@ static int ft1000d_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
 static int ft1000d_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
 {
     struct ft1000d_priv_data *priv;
-    unsigned char ci;
     ft1000d_op_data_t *p;
     int err;
 
@@ -1629,18 +1663,15 @@ static int ft1000d_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
     {
     case RIG_VFO_A:
     case RIG_VFO_VFO:
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         p = (ft1000d_op_data_t *) &priv->update_data.vfoa;
         break;
 
     case RIG_VFO_B:
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         p = (ft1000d_op_data_t *) &priv->update_data.vfob;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
-        ci = FT1000D_NATIVE_UPDATE_OP_DATA;
         p = (ft1000d_op_data_t *) &priv->update_data.current_front;
         break;
 
@@ -1649,7 +1680,7 @@ static int ft1000d_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
     }
 
     // Get update for selected VFO/MEM
-    err = ft1000d_get_update_data(rig, ci, 0);
+    err = ft1000d_get_status(rig, p, sizeof(ft1000d_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -1739,7 +1770,8 @@ static int ft1000d_set_xit(RIG *rig, vfo_t vfo, shortfreq_t xit)
     // Disable TX clarifier and return if xit = 0
     if (xit == 0)
     {
-        err = ft1000d_get_update_data(rig, FT1000D_NATIVE_UPDATE_OP_DATA, 0);
+        err = ft1000d_get_status(rig,
+                &priv->update_data.current_front, sizeof(ft1000d_op_data_t));
 
         if (err != RIG_OK)
         {
@@ -1807,7 +1839,6 @@ static int ft1000d_set_xit(RIG *rig, vfo_t vfo, shortfreq_t xit)
 static int ft1000d_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
 {
     struct ft1000d_priv_data *priv;
-    unsigned char ci;
     ft1000d_op_data_t *p;
     int err;
 
@@ -1833,18 +1864,15 @@ static int ft1000d_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
     {
     case RIG_VFO_A:
     case RIG_VFO_VFO:
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         p = (ft1000d_op_data_t *) &priv->update_data.vfoa;
         break;
 
     case RIG_VFO_B:
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         p = (ft1000d_op_data_t *) &priv->update_data.vfob;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
-        ci = FT1000D_NATIVE_UPDATE_OP_DATA;
         p = (ft1000d_op_data_t *) &priv->update_data.current_front;
         break;
 
@@ -1852,7 +1880,7 @@ static int ft1000d_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
         return -RIG_EINVAL;
     }
 
-    err = ft1000d_get_update_data(rig, ci, 0);
+    err = ft1000d_get_status(rig, p, sizeof(ft1000d_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -1982,7 +2010,7 @@ static int ft1000d_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
 
     priv = (struct ft1000d_priv_data *)rig->state.priv;
 
-    err = ft1000d_get_update_data(rig, FT1000D_NATIVE_READ_FLAGS, 0);
+    err = ft1000d_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -2246,7 +2274,6 @@ static int ft1000d_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
     struct ft1000d_priv_data *priv;
     unsigned char *p;
     unsigned char *fl;
-    unsigned char ci;
     int err;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -2272,26 +2299,22 @@ static int ft1000d_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
     {
     case RIG_VFO_A:
         p = &priv->update_data.vfoa.mode;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         fl = &priv->update_data.vfoa.filter;
         break;
 
     case RIG_VFO_VFO:
         p = &priv->update_data.vfoa.mode;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         fl = &priv->update_data.vfoa.filter;
         break;
 
     case RIG_VFO_B:
         p = &priv->update_data.vfob.mode;
-        ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
         fl = &priv->update_data.vfob.filter;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
         p = &priv->update_data.current_front.mode;
-        ci = FT1000D_NATIVE_UPDATE_OP_DATA;
         fl = &priv->update_data.current_front.filter;
         break;
 
@@ -2300,7 +2323,7 @@ static int ft1000d_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
     }
 
     // Get update for selected VFO
-    err = ft1000d_get_update_data(rig, ci, 0);
+    err = ft1000d_get_status(rig, p, 2);
 
     if (err != RIG_OK)
     {
@@ -2534,7 +2557,7 @@ static int ft1000d_get_vfo(RIG *rig, vfo_t *vfo)
     priv = (struct ft1000d_priv_data *)rig->state.priv;
 
     /* Get flags for VFO status */
-    err = ft1000d_get_update_data(rig, FT1000D_NATIVE_READ_FLAGS, 0);
+    err = ft1000d_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -2899,7 +2922,7 @@ static int ft1000d_get_mem(RIG *rig, vfo_t vfo, int *ch)
                   __func__, vfo);
     }
 
-    err = ft1000d_get_update_data(rig, FT1000D_NATIVE_UPDATE_MEM_CHNL, 0);
+    err = ft1000d_get_status(rig, &priv->update_data.channelnumber, 1);
 
     if (err != RIG_OK)
     {
@@ -2969,7 +2992,6 @@ static int ft1000d_get_channel(RIG *rig, vfo_t vfo, channel_t *chan,
 {
     struct ft1000d_priv_data *priv;
     ft1000d_op_data_t *p;
-    char ci;
     int err;
     channel_t _chan;
 
@@ -3008,31 +3030,32 @@ static int ft1000d_get_channel(RIG *rig, vfo_t vfo, channel_t *chan,
         {
         // Current or last selected memory channel
         case RIG_VFO_MEM:
-            err = ft1000d_get_update_data(rig, FT1000D_NATIVE_UPDATE_MEM_CHNL, 0);
+            err = ft1000d_get_status(rig, &priv->update_data.channelnumber, 1);
 
             if (err != RIG_OK)
             {
                 return err;
             }
 
+            if (priv->update_data.channelnumber >= 90)
+            {
+                return -RIG_EPROTO;
+            }
+
             chan->channel_num = priv->update_data.channelnumber + 1;
-            p = (ft1000d_op_data_t *) &priv->update_data.channel[chan->channel_num];
-            ci = FT1000D_NATIVE_UPDATE_MEM_CHNL_DATA;
+            p = (ft1000d_op_data_t *) &priv->update_data.channel[chan->channel_num - 1];
             break;
 
         case RIG_VFO_A:
             p = (ft1000d_op_data_t *) &priv->update_data.vfoa;
-            ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
             break;
 
         case RIG_VFO_B:
             p = (ft1000d_op_data_t *) &priv->update_data.vfob;
-            ci = FT1000D_NATIVE_UPDATE_VFO_DATA;
             break;
 
         case RIG_VFO_CURR:
             p = (ft1000d_op_data_t *) &priv->update_data.current_front;
-            ci = FT1000D_NATIVE_UPDATE_OP_DATA;
             break;
 
         default:
@@ -3041,15 +3064,14 @@ static int ft1000d_get_channel(RIG *rig, vfo_t vfo, channel_t *chan,
     }
     else
     {
-        p = (ft1000d_op_data_t *) &priv->update_data.channel[chan->channel_num];
-        ci = FT1000D_NATIVE_UPDATE_MEM_CHNL_DATA;
+        p = (ft1000d_op_data_t *) &priv->update_data.channel[chan->channel_num - 1];
         chan->vfo = RIG_VFO_MEM;
     }
 
     /*
      * Get data for selected VFO/MEM
      */
-    err = ft1000d_get_update_data(rig, ci, chan->channel_num);
+    err = ft1000d_get_status(rig, p, sizeof(ft1000d_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -3168,7 +3190,7 @@ static int ft1000d_get_channel(RIG *rig, vfo_t vfo, channel_t *chan,
         return -RIG_EINVAL;
     }
 
-    err = ft1000d_get_update_data(rig, FT1000D_NATIVE_READ_FLAGS, 0);
+    err = ft1000d_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -3437,11 +3459,12 @@ static int ft1000d_get_channel(RIG *rig, vfo_t vfo, channel_t *chan,
  * Extended to be command agnostic as 990 has several ways to
  * get data and several ways to return it.
  *
- * Need to use this when doing FT1000D_get_* stuff
+ * The ft1000d_get_* functions go through ft1000d_get_status(), which
+ * calls this when the data they need has gone stale.
  *
  * Arguments:   *rig    Valid RIG instance
  *              ci      command index
- *              rl      expected length of returned data in octets
+ *              ch      memory channel less one for Update Memory Ch Data
  *
  * Returns:     RIG_OK if all called functions are successful,
  *              otherwise returns error from called function
@@ -3476,7 +3499,12 @@ static int ft1000d_get_update_data(RIG *rig, unsigned char ci,
         if (ci == FT1000D_NATIVE_UPDATE_MEM_CHNL_DATA)
             // P4 = 0x01 to 0x5a for channel 1 - 90
         {
-            err = ft1000d_send_dynamic_cmd(rig, ci, 4, 0, 0, ch);
+            if (ch >= 90)
+            {
+                return -RIG_EINVAL;
+            }
+
+            err = ft1000d_send_dynamic_cmd(rig, ci, 4, 0, 0, ch + 1);
         }
         else
         {
@@ -3558,6 +3586,143 @@ static int ft1000d_get_update_data(RIG *rig, unsigned char ci,
     return RIG_OK;
 }
 
+/*
+ * Private helper function. Makes a field of priv->update_data current,
+ * reading the smallest update that holds it unless it was read within
+ * the cache timeout and no command has changed it since.
+ *
+ * Arguments:   *rig    Valid RIG instance
+ *              field   pointer into priv->update_data
+ *              length  of the field in octets
+ *
+ * Returns:     RIG_OK if all called functions are successful,
+ *              otherwise returns error from called function
+ */
+static int ft1000d_get_status(RIG *rig, const void *field, size_t length)
+{
+    struct ft1000d_priv_data *priv = (struct ft1000d_priv_data *)rig->state.priv;
+
+    return ftstatus_get(rig, &priv->status,
+                        (const unsigned char *) field
+                        - (const unsigned char *) &priv->update_data, length);
+}
+
+/*
+ * Private helper function. Marks what command ci changes in
+ * priv->update_data stale, called once the command has been sent.
+ *
+ * Arguments:   *rig    Valid RIG instance
+ *              ci      Command index of the ncmd table
+ */
+static void ft1000d_invalidate(RIG *rig, unsigned char ci)
+{
+    struct ft1000d_priv_data *priv = (struct ft1000d_priv_data *)rig->state.priv;
+    ftstatus_cache_t *status = &priv->status;
+
+    switch (ci)
+    {
+    case FT1000D_NATIVE_SPLIT_OFF:
+    case FT1000D_NATIVE_SPLIT_ON:
+    case FT1000D_NATIVE_LOCK_OFF:
+    case FT1000D_NATIVE_LOCK_ON:
+    case FT1000D_NATIVE_PTT_OFF:
+    case FT1000D_NATIVE_PTT_ON:
+    case FT1000D_NATIVE_TUNER_OFF:
+    case FT1000D_NATIVE_TUNER_ON:
+    case FT1000D_NATIVE_TUNER_START:
+        ftstatus_invalidate(status, FT1000D_FIELD(flag1), 3);
+        break;
+
+    case FT1000D_NATIVE_VFO_A:
+    case FT1000D_NATIVE_VFO_B:
+    case FT1000D_NATIVE_RECALL_MEM:
+        ftstatus_invalidate(status, FT1000D_FIELD(flag1), 3);
+        ftstatus_invalidate(status, FT1000D_FIELD(channelnumber), 1);
+        ftstatus_invalidate(status, FT1000D_FIELD(current_front),
+                            sizeof(ft1000d_op_data_t));
+        break;
+
+    /* these change the displayed VFO or memory tune */
+    case FT1000D_NATIVE_VFO_STEP_UP:
+    case FT1000D_NATIVE_VFO_STEP_UP_FAST:
+    case FT1000D_NATIVE_VFO_STEP_DOWN:
+    case FT1000D_NATIVE_VFO_STEP_DOWN_FAST:
+    case FT1000D_NATIVE_RX_CLARIFIER_OFF:
+    case FT1000D_NATIVE_RX_CLARIFIER_ON:
+    case FT1000D_NATIVE_TX_CLARIFIER_OFF:
+    case FT1000D_NATIVE_TX_CLARIFIER_ON:
+    case FT1000D_NATIVE_CLEAR_CLARIFIER_OFFSET:
+    case FT1000D_NATIVE_CLARIFIER_OPS:
+    case FT1000D_NATIVE_FREQ_SET:
+    case FT1000D_NATIVE_MODE_SET_LSB:
+    case FT1000D_NATIVE_MODE_SET_USB:
+    case FT1000D_NATIVE_MODE_SET_CW_W:
+    case FT1000D_NATIVE_MODE_SET_CW_N:
+    case FT1000D_NATIVE_MODE_SET_AM_W:
+    case FT1000D_NATIVE_MODE_SET_AM_N:
+    case FT1000D_NATIVE_MODE_SET_FM:
+    case FT1000D_NATIVE_MODE_SET_RTTY_LSB:
+    case FT1000D_NATIVE_MODE_SET_RTTY_USB:
+    case FT1000D_NATIVE_MODE_SET_PKT_LSB:
+    case FT1000D_NATIVE_MODE_SET_PKT_FM:
+    case FT1000D_NATIVE_RPTR_SHIFT_NONE:
+    case FT1000D_NATIVE_RPTR_SHIFT_MINUS:
+    case FT1000D_NATIVE_RPTR_SHIFT_PLUS:
+    case FT1000D_NATIVE_RPTR_OFFSET:
+    case FT1000D_NATIVE_BANDWIDTH:
+    case FT1000D_NATIVE_OP_FREQ_STEP_UP:
+    case FT1000D_NATIVE_OP_FREQ_STEP_DOWN:
+        ftstatus_invalidate(status, FT1000D_FIELD(current_front),
+                            sizeof(ft1000d_op_data_t));
+
+        if (priv->current_vfo != RIG_VFO_B && priv->current_vfo != RIG_VFO_MEM)
+        {
+            ftstatus_invalidate(status, FT1000D_FIELD(vfoa),
+                                sizeof(ft1000d_op_data_t));
+        }
+
+        if (priv->current_vfo != RIG_VFO_A && priv->current_vfo != RIG_VFO_MEM)
+        {
+            ftstatus_invalidate(status, FT1000D_FIELD(vfob),
+                                sizeof(ft1000d_op_data_t));
+        }
+
+        break;
+
+    /* the sub VFO is VFO B whichever one is displayed */
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_LSB:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_USB:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_CW_W:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_CW_N:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_AM_W:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_AM_N:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_FM:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_RTTY_LSB:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_RTTY_USB:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_PKT_LSB:
+    case FT1000D_NATIVE_MODE_SUB_VFOB_SET_PKT_FM:
+    case FT1000D_NATIVE_SET_SUB_VFO_FREQ:
+        ftstatus_invalidate(status, FT1000D_FIELD(vfob), sizeof(ft1000d_op_data_t));
+
+        if (priv->current_vfo == RIG_VFO_B)
+        {
+            ftstatus_invalidate(status, FT1000D_FIELD(current_front),
+                                sizeof(ft1000d_op_data_t));
+        }
+
+        break;
+
+    case FT1000D_NATIVE_VFO_TO_MEM:
+    case FT1000D_NATIVE_MEM_TO_VFO:
+    case FT1000D_NATIVE_VFO_TO_VFO:
+        ftstatus_invalidate_all(status);
+        break;
+
+    default:
+        break;
+    }
+}
+
 /*
  * Private helper function to send a complete command sequence.
  *
@@ -3590,6 +3755,7 @@ static int ft1000d_send_static_cmd(RIG *rig, unsigned char ci)
     }
 
     err = write_block(rp, ncmd[ci].nseq, YAESU_CMD_LENGTH);
+    ft1000d_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -3651,6 +3817,7 @@ static int ft1000d_send_dynamic_cmd(RIG *rig, unsigned char ci,
     priv->p_cmd[0] = p4;
 
     err = write_block(rp, (unsigned char *) &priv->p_cmd, YAESU_CMD_LENGTH);
+    ft1000d_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -3710,6 +3877,7 @@ static int ft1000d_send_dial_freq(RIG *rig, unsigned char ci, freq_t freq)
               FT1000D_BCD_DIAL) * 10);
 
     err = write_block(rp, (unsigned char *) &priv->p_cmd, YAESU_CMD_LENGTH);
+    ft1000d_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -3776,6 +3944,7 @@ static int ft1000d_send_rit_freq(RIG *rig, unsigned char ci, shortfreq_t rit)
     to_bcd(priv->p_cmd, labs(rit) / 10, FT1000D_BCD_RIT);
 
     err = write_block(rp, (unsigned char *) &priv->p_cmd, YAESU_CMD_LENGTH);
+    ft1000d_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -3833,15 +4002,6 @@ static int ft1000d_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
 
     err = ft1000d_send_dial_freq(rig, FT1000D_NATIVE_SET_SUB_VFO_FREQ, tx_freq);
 
-    if (err != RIG_OK)
-    {
-        return err;
-    }
-
-    // Get current rig settings and status
-    err = ft1000d_get_update_data(rig, FT1000D_NATIVE_UPDATE_OP_DATA, 0);
-
-
     if (err != RIG_OK)
     {
         return err;
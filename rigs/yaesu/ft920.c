@@ -37,6 +37,7 @@
 #include "misc.h"
 #include "yaesu.h"
 #include "ft920.h"
+#include "ftstatus.h"
 
 
 /*
@@ -327,7 +328,11 @@ static int ft920_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status);
 
 /* Private helper function prototypes */
 
-static int ft920_get_update_data(RIG *rig, unsigned char ci, unsigned char rl);
+static int ft920_get_update_data(RIG *rig, unsigned char ci,
+                                 unsigned short index);
+static int ft920_get_status(RIG *rig, unsigned char ci, unsigned char offset,
+                            unsigned char length, unsigned char **p);
+static void ft920_invalidate(RIG *rig, unsigned char ci);
 static int ft920_send_static_cmd(RIG *rig, unsigned char ci);
 static int ft920_send_dynamic_cmd(RIG *rig, unsigned char ci, unsigned char p1,
                                   unsigned char p2, unsigned char p3, unsigned char p4);
@@ -393,7 +398,29 @@ struct ft920_priv_data
     unsigned char
     p_cmd[YAESU_CMD_LENGTH];      /* private copy of 1 constructed CAT cmd */
     unsigned char
-    update_data[FT920_VFO_DATA_LENGTH];   /* returned data--max value, some are less */
+    update_data[FT920_STATUS_SIZE];       /* returned data, see below */
+    ftstatus_cache_t status;                    /* age of update_data */
+};
+
+/*
+ * The status flags, OP data and VFO data each have their place in
+ * update_data, so that reading one does not throw away the others.  The
+ * FT920_SUMO_* offsets are relative to the start of the update they are
+ * in.  OP data is the displayed VFO or memory followed by VFO B, VFO data
+ * is VFO A followed by VFO B, each a record the size of a memory channel.
+ */
+static const ftstatus_field_t ft920_status_fields[] =
+{
+    { FT920_STATUS_FLAGS_BASE, FT920_STATUS_FLAGS_LENGTH, 1 },
+    { FT920_STATUS_OP_BASE, FT920_MEM_CHNL_DATA_LENGTH, 2 },
+    { FT920_STATUS_VFO_BASE, FT920_MEM_CHNL_DATA_LENGTH, 2 },
+};
+
+static const ftstatus_block_t ft920_status_blocks[] =
+{
+    { FT920_NATIVE_STATUS_FLAGS, FT920_STATUS_FLAGS_BASE, FT920_STATUS_FLAGS_LENGTH, FT920_STATUS_FLAGS_LENGTH, 1 },
+    { FT920_NATIVE_OP_DATA, FT920_STATUS_OP_BASE, FT920_VFO_DATA_LENGTH, FT920_VFO_DATA_LENGTH, 1 },
+    { FT920_NATIVE_VFO_DATA, FT920_STATUS_VFO_BASE, FT920_VFO_DATA_LENGTH, FT920_VFO_DATA_LENGTH, 1 },
 };
 
 /*
@@ -648,6 +675,17 @@ static int ft920_init(RIG *rig)
         FT920_PACING_DEFAULT_VALUE;              /* set pacing to minimum for now */
     priv->current_vfo =  RIG_VFO_A;                         /* default to VFO_A */
 
+    if (ftstatus_init(&priv->status, ft920_status_fields,
+                      sizeof(ft920_status_fields) / sizeof(ft920_status_fields[0]),
+                      ft920_status_blocks,
+                      sizeof(ft920_status_blocks) / sizeof(ft920_status_blocks[0]),
+                      ft920_get_update_data) != RIG_OK)
+    {
+        free(rig->state.priv);
+        rig->state.priv = NULL;
+        return -RIG_ENOMEM;
+    }
+
     return RIG_OK;
 }
 
@@ -670,6 +708,9 @@ static int ft920_cleanup(RIG *rig)
 
     if (rig->state.priv)
     {
+        struct ft920_priv_data *priv = (struct ft920_priv_data *)rig->state.priv;
+
+        ftstatus_cleanup(&priv->status);
         free(rig->state.priv);
     }
 
@@ -719,6 +760,8 @@ static int ft920_open(RIG *rig)
         return err;
     }
 
+    ftstatus_invalidate_all(&priv->status);
+
     /* TODO: more initialization as necessary */
 
     return RIG_OK;
@@ -885,15 +928,13 @@ static int ft920_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
         return -RIG_EINVAL;             /* sorry, wrong VFO */
     }
 
-    err = ft920_get_update_data(rig, cmd_index, FT920_VFO_DATA_LENGTH);
+    err = ft920_get_status(rig, cmd_index, offset, 4, &p);
 
     if (err != RIG_OK)
     {
         return err;
     }
 
-    p = &priv->update_data[offset];
-
     /* big endian integer */
     f = (((((p[0] << 8) + p[1]) << 8) + p[2]) << 8) + p[3];
 
@@ -1171,6 +1212,7 @@ static int ft920_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 static int ft920_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
 {
     struct ft920_priv_data *priv;
+    unsigned char *p;
     unsigned char mymode, offset;       /* ft920 mode, flag offset */
     int err, cmd_index, norm;
 
@@ -1215,14 +1257,14 @@ static int ft920_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
         return -RIG_EINVAL;
     }
 
-    err = ft920_get_update_data(rig, cmd_index, FT920_VFO_DATA_LENGTH);
+    err = ft920_get_status(rig, cmd_index, offset, 1, &p);
 
     if (err != RIG_OK)
     {
         return err;
     }
 
-    mymode = priv->update_data[offset];
+    mymode = *p;
     mymode &= MODE_MASK;
 
     rig_debug(RIG_DEBUG_TRACE, "%s: mymode = 0x%02x\n", __func__, mymode);
@@ -1446,8 +1488,8 @@ static int ft920_get_vfo(RIG *rig, vfo_t *vfo)
     priv = (struct ft920_priv_data *)rig->state.priv;
 
     /* Get flags for VFO status */
-    err = ft920_get_update_data(rig, FT920_NATIVE_STATUS_FLAGS,
-                                FT920_STATUS_FLAGS_LENGTH);
+    err = ft920_get_status(rig, FT920_NATIVE_STATUS_FLAGS, 0,
+                           FT920_STATUS_FLAGS_LENGTH, NULL);
 
     if (err != RIG_OK)
     {
@@ -1635,8 +1677,8 @@ static int ft920_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
     priv = (struct ft920_priv_data *)rig->state.priv;
 
     /* Get flags for VFO split status */
-    err = ft920_get_update_data(rig, FT920_NATIVE_STATUS_FLAGS,
-                                FT920_STATUS_FLAGS_LENGTH);
+    err = ft920_get_status(rig, FT920_NATIVE_STATUS_FLAGS, 0,
+                           FT920_STATUS_FLAGS_LENGTH, NULL);
 
     if (err != RIG_OK)
     {
@@ -2091,15 +2133,13 @@ static int ft920_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
     rig_debug(RIG_DEBUG_TRACE, "%s: set cmd_index = %i\n", __func__, cmd_index);
     rig_debug(RIG_DEBUG_TRACE, "%s: set offset = 0x%02x\n", __func__, offset);
 
-    err = ft920_get_update_data(rig, cmd_index, FT920_VFO_DATA_LENGTH);
+    err = ft920_get_status(rig, cmd_index, offset, 2, &p);
 
     if (err != RIG_OK)
     {
         return err;
     }
 
-    p = &priv->update_data[offset];
-
     /* big endian integer */
     f = (p[0] << 8) + p[1];
 
@@ -2334,8 +2374,8 @@ static int ft920_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     priv = (struct ft920_priv_data *)rig->state.priv;
 
     /* Get flags for VFO status */
-    err = ft920_get_update_data(rig, FT920_NATIVE_STATUS_FLAGS,
-                                FT920_STATUS_FLAGS_LENGTH);
+    err = ft920_get_status(rig, FT920_NATIVE_STATUS_FLAGS, 0,
+                           FT920_STATUS_FLAGS_LENGTH, NULL);
 
     if (err != RIG_OK)
     {
@@ -2504,8 +2544,8 @@ static int ft920_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
     }
 
     /* Get flags for VFO status */
-    err = ft920_get_update_data(rig, FT920_NATIVE_STATUS_FLAGS,
-                                FT920_STATUS_FLAGS_LENGTH);
+    err = ft920_get_status(rig, FT920_NATIVE_STATUS_FLAGS, 0,
+                           FT920_STATUS_FLAGS_LENGTH, NULL);
 
     if (err != RIG_OK)
     {
@@ -2599,20 +2639,24 @@ static int ft920_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
  * Extended to be command agnostic as 920 has several ways to
  * get data and several ways to return it.
  *
- * Need to use this when doing ft920_get_* stuff
+ * The ft920_get_* functions go through ft920_get_status(), which calls
+ * this when the data they need has gone stale.
  *
  * Arguments:   *rig    Valid RIG instance
  *              ci      command index
- *              rl      expected length of returned data in octets
+ *              index   unused, the FT-920 updates read have one copy
  *
  * Returns:     RIG_OK if all called functions are successful,
  *              otherwise returns error from called function
  */
 
-static int ft920_get_update_data(RIG *rig, unsigned char ci, unsigned char rl)
+static int ft920_get_update_data(RIG *rig, unsigned char ci,
+                                 unsigned short index)
 {
     struct ft920_priv_data *priv;
+    unsigned char *p;
     int n;                              /* for read_  */
+    int rl;
     int err;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -2624,6 +2668,27 @@ static int ft920_get_update_data(RIG *rig, unsigned char ci, unsigned char rl)
 
     priv = (struct ft920_priv_data *)rig->state.priv;
 
+    switch (ci)
+    {
+    case FT920_NATIVE_STATUS_FLAGS:
+        p = &priv->update_data[FT920_STATUS_FLAGS_BASE];
+        rl = FT920_STATUS_FLAGS_LENGTH;
+        break;
+
+    case FT920_NATIVE_OP_DATA:
+        p = &priv->update_data[FT920_STATUS_OP_BASE];
+        rl = FT920_VFO_DATA_LENGTH;
+        break;
+
+    case FT920_NATIVE_VFO_DATA:
+        p = &priv->update_data[FT920_STATUS_VFO_BASE];
+        rl = FT920_VFO_DATA_LENGTH;
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
     err = ft920_send_static_cmd(rig, ci);
 
     if (err != RIG_OK)
@@ -2631,7 +2696,7 @@ static int ft920_get_update_data(RIG *rig, unsigned char ci, unsigned char rl)
         return err;
     }
 
-    n = read_block(RIGPORT(rig), priv->update_data, rl);
+    n = read_block(RIGPORT(rig), p, rl);
 
     if (n < 0)
     {
@@ -2644,6 +2709,126 @@ static int ft920_get_update_data(RIG *rig, unsigned char ci, unsigned char rl)
 }
 
 
+/*
+ * Private helper function to make length octets at offset of update ci
+ * current, reading the update unless they were read within the cache
+ * timeout and no command has changed them since.
+ *
+ * Arguments:   *rig    Valid RIG instance
+ *              ci      command index of the update
+ *              offset  FT920_SUMO_* offset in the update
+ *              length  in octets
+ *              **p     if not NULL, set to the data in priv->update_data
+ *
+ * Returns:     RIG_OK if all called functions are successful,
+ *              otherwise returns error from called function
+ */
+
+static int ft920_get_status(RIG *rig, unsigned char ci, unsigned char offset,
+                            unsigned char length, unsigned char **p)
+{
+    struct ft920_priv_data *priv = (struct ft920_priv_data *)rig->state.priv;
+    unsigned int base;
+    int err;
+
+    switch (ci)
+    {
+    case FT920_NATIVE_STATUS_FLAGS:
+        base = FT920_STATUS_FLAGS_BASE;
+        break;
+
+    case FT920_NATIVE_OP_DATA:
+        base = FT920_STATUS_OP_BASE;
+        break;
+
+    case FT920_NATIVE_VFO_DATA:
+        base = FT920_STATUS_VFO_BASE;
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    err = ftstatus_get(rig, &priv->status, base + offset, length);
+
+    if (err == RIG_OK && p)
+    {
+        *p = &priv->update_data[base + offset];
+    }
+
+    return err;
+}
+
+
+/*
+ * Private helper function to mark what command ci changes in
+ * priv->update_data stale, called once the command has been sent.
+ *
+ * Arguments:   *rig    Valid RIG instance
+ *              ci      Command index of the ncmd table
+ */
+
+static void ft920_invalidate(RIG *rig, unsigned char ci)
+{
+    struct ft920_priv_data *priv = (struct ft920_priv_data *)rig->state.priv;
+    ftstatus_cache_t *status = &priv->status;
+
+    switch (ci)
+    {
+    case FT920_NATIVE_SPLIT_OFF:
+    case FT920_NATIVE_SPLIT_ON:
+    case FT920_NATIVE_PTT_OFF:
+    case FT920_NATIVE_PTT_ON:
+    case FT920_NATIVE_TUNER_BYPASS:
+    case FT920_NATIVE_TUNER_INLINE:
+    case FT920_NATIVE_TUNER_START:
+        ftstatus_invalidate(status, FT920_STATUS_FLAGS_BASE,
+                            FT920_STATUS_FLAGS_LENGTH);
+        break;
+
+    case FT920_NATIVE_VFO_A:
+    case FT920_NATIVE_VFO_B:
+    case FT920_NATIVE_RECALL_MEM:
+        ftstatus_invalidate(status, FT920_STATUS_FLAGS_BASE,
+                            FT920_STATUS_FLAGS_LENGTH);
+        ftstatus_invalidate(status, FT920_STATUS_OP_BASE, FT920_VFO_DATA_LENGTH);
+        break;
+
+    case FT920_NATIVE_VFO_A_FREQ_SET:
+    case FT920_NATIVE_VFO_A_PASSBAND_WIDE:
+    case FT920_NATIVE_VFO_A_PASSBAND_NAR:
+        ftstatus_invalidate(status, FT920_STATUS_OP_BASE, FT920_VFO_DATA_LENGTH);
+        ftstatus_invalidate(status, FT920_STATUS_VFO_BASE,
+                            FT920_MEM_CHNL_DATA_LENGTH);
+        break;
+
+    case FT920_NATIVE_VFO_B_FREQ_SET:
+    case FT920_NATIVE_VFO_B_PASSBAND_WIDE:
+    case FT920_NATIVE_VFO_B_PASSBAND_NAR:
+        ftstatus_invalidate(status, FT920_STATUS_OP_BASE, FT920_VFO_DATA_LENGTH);
+        ftstatus_invalidate(status,
+                            FT920_STATUS_VFO_BASE + FT920_MEM_CHNL_DATA_LENGTH,
+                            FT920_MEM_CHNL_DATA_LENGTH);
+        break;
+
+    /* the mode parameter says which VFO, the clarifier is the displayed one */
+    case FT920_NATIVE_MODE_SET:
+    case FT920_NATIVE_CLARIFIER_OPS:
+        ftstatus_invalidate(status, FT920_STATUS_OP_BASE, FT920_VFO_DATA_LENGTH);
+        ftstatus_invalidate(status, FT920_STATUS_VFO_BASE, FT920_VFO_DATA_LENGTH);
+        break;
+
+    case FT920_NATIVE_VFO_TO_MEM:
+    case FT920_NATIVE_MEM_TO_VFO:
+        ftstatus_invalidate_all(status);
+        break;
+
+    default:
+        break;
+    }
+}
+
+
 /*
  * Private helper function to send a complete command sequence.
  *
@@ -2679,6 +2864,7 @@ static int ft920_send_static_cmd(RIG *rig, unsigned char ci)
     }
 
     err = write_block(RIGPORT(rig), ncmd[ci].nseq, YAESU_CMD_LENGTH);
+    ft920_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -2745,6 +2931,7 @@ static int ft920_send_dynamic_cmd(RIG *rig, unsigned char ci,
 
     err = write_block(RIGPORT(rig), (unsigned char *) &priv->p_cmd,
                       YAESU_CMD_LENGTH);
+    ft920_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -2810,6 +2997,7 @@ static int ft920_send_dial_freq(RIG *rig, unsigned char ci, freq_t freq)
 
     err = write_block(RIGPORT(rig), (unsigned char *) &priv->p_cmd,
                       YAESU_CMD_LENGTH);
+    ft920_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -2894,6 +3082,7 @@ static int ft920_send_rit_freq(RIG *rig, unsigned char ci, shortfreq_t rit)
 
     err = write_block(RIGPORT(rig), (unsigned char *) &priv->p_cmd,
                       YAESU_CMD_LENGTH);
+    ft920_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
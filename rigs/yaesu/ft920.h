@@ -56,6 +56,12 @@
 #define FT920_VFO_DATA_LENGTH       28  /* 0x10 P1 = 02, 03 return size */
 #define FT920_MEM_CHNL_DATA_LENGTH  14  /* 0x10 P1 = 04, P4 = 0x00-0x89 return size */
 
+/* Where each update is kept in the status image, flags first */
+#define FT920_STATUS_FLAGS_BASE     0
+#define FT920_STATUS_OP_BASE        (FT920_STATUS_FLAGS_BASE + FT920_STATUS_FLAGS_LENGTH)
+#define FT920_STATUS_VFO_BASE       (FT920_STATUS_OP_BASE + FT920_VFO_DATA_LENGTH)
+#define FT920_STATUS_SIZE           (FT920_STATUS_VFO_BASE + FT920_VFO_DATA_LENGTH)
+
 
 /* Delay sequential fast writes
  *
@@ -32,6 +32,7 @@
 */
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>  /* String function definitions */
 
 #include "hamlib/rig.h"
@@ -40,6 +41,7 @@
 #include "misc.h"
 #include "yaesu.h"
 #include "ft990.h"
+#include "ftstatus.h"
 
 // FT990 native commands
 enum ft990_native_cmd_e
@@ -142,6 +144,8 @@ static int ft990_get_channel(RIG *rig, vfo_t vfo, channel_t *chan,
 
 /* Private helper function prototypes */
 static int ft990_get_update_data(RIG *rig, unsigned char ci, unsigned short ch);
+static int ft990_get_status(RIG *rig, const void *field, size_t length);
+static void ft990_invalidate(RIG *rig, unsigned char ci);
 static int ft990_send_static_cmd(RIG *rig, unsigned char ci);
 static int ft990_send_dynamic_cmd(RIG *rig, unsigned char ci,
                                   unsigned char p1, unsigned char p2,
@@ -215,6 +219,30 @@ struct ft990_priv_data
     vfo_t current_vfo;                        /* active VFO from last cmd */
     unsigned char p_cmd[YAESU_CMD_LENGTH];    /* private copy of CAT cmd */
     ft990_update_data_t update_data;          /* returned data */
+    ftstatus_cache_t status;                  /* age of update_data */
+};
+
+/*
+ * What each update fills in update_data.  The 1508 byte Update All Data
+ * is left out, the smaller updates always hold what a get needs.
+ */
+#define FT990_FIELD(f) offsetof(ft990_update_data_t, f)
+
+static const ftstatus_field_t ft990_status_fields[] =
+{
+    { FT990_FIELD(flag1), 3, 1 },
+    { FT990_FIELD(channelnumber), 1, 1 },
+    { FT990_FIELD(current_front), sizeof(ft990_op_data_t), 4 },
+    { FT990_FIELD(channel), sizeof(ft990_op_data_t), 90 },
+};
+
+static const ftstatus_block_t ft990_status_blocks[] =
+{
+    { FT990_NATIVE_READ_FLAGS, FT990_FIELD(flag1), 3, FT990_STATUS_FLAGS_LENGTH, 1 },
+    { FT990_NATIVE_UPDATE_MEM_CHNL, FT990_FIELD(channelnumber), 1, FT990_MEM_CHNL_LENGTH, 1 },
+    { FT990_NATIVE_UPDATE_OP_DATA, FT990_FIELD(current_front), FT990_OP_DATA_LENGTH, FT990_OP_DATA_LENGTH, 1 },
+    { FT990_NATIVE_UPDATE_VFO_DATA, FT990_FIELD(vfoa), FT990_VFO_DATA_LENGTH, FT990_VFO_DATA_LENGTH, 1 },
+    { FT990_NATIVE_UPDATE_MEM_CHNL_DATA, FT990_FIELD(channel), FT990_MEM_CHNL_DATA_LENGTH, FT990_MEM_CHNL_DATA_LENGTH, 90 },
 };
 
 /*
@@ -413,6 +441,16 @@ int ft990_init(RIG *rig)
     // Set operating vfo mode to current VFO
     priv->current_vfo =  RIG_VFO_MAIN;
 
+    if (ftstatus_init(&priv->status, ft990_status_fields,
+                      sizeof(ft990_status_fields) / sizeof(ft990_status_fields[0]),
+                      ft990_status_blocks,
+                      sizeof(ft990_status_blocks) / sizeof(ft990_status_blocks[0]),
+                      ft990_get_update_data) != RIG_OK)
+    {
+        free(rig->state.priv);
+        rig->state.priv = NULL;
+        return -RIG_ENOMEM;
+    }
 
     return RIG_OK;
 }
@@ -432,6 +470,9 @@ int ft990_cleanup(RIG *rig)
 
     if (rig->state.priv)
     {
+        struct ft990_priv_data *priv = (struct ft990_priv_data *)rig->state.priv;
+
+        ftstatus_cleanup(&priv->status);
         free(rig->state.priv);
     }
 
@@ -473,7 +514,9 @@ int  ft990_open(RIG *rig)
     }
 
     // Get current rig settings and status
-    err = ft990_get_update_data(rig, FT990_NATIVE_UPDATE_OP_DATA, 0);
+    ftstatus_invalidate_all(&priv->status);
+    err = ft990_get_status(rig, &priv->update_data.current_front,
+                           sizeof(ft990_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -605,7 +648,6 @@ int ft990_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     unsigned char *p;
     freq_t f;
     int err;
-    int ci;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
     rig_debug(RIG_DEBUG_TRACE, "%s: passed vfo = 0x%02x\n", __func__, vfo);
@@ -629,18 +671,15 @@ int ft990_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     case RIG_VFO_A:
     case RIG_VFO_VFO:
         p = priv->update_data.vfoa.basefreq;
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_B:
         p = priv->update_data.vfob.basefreq;
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
         p = priv->update_data.current_front.basefreq;
-        ci = FT990_NATIVE_UPDATE_OP_DATA;
         break;
 
     default:
@@ -648,7 +687,7 @@ int ft990_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     }
 
     // Get update data structure to obtain get frequency
-    err = ft990_get_update_data(rig, ci, 0);
+    err = ft990_get_status(rig, p, 3);
 
     if (err != RIG_OK)
     {
@@ -786,7 +825,7 @@ int ft990_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
 
     priv = (struct ft990_priv_data *) rig->state.priv;
 
-    err = ft990_get_update_data(rig, FT990_NATIVE_READ_FLAGS, 0);
+    err = ft990_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -866,17 +905,14 @@ int ft990_set_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t rptr_shift)
     {
     case RIG_VFO_A:
         p = (char *) &priv->update_data.vfoa.mode;
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_B:
         p = (char *) &priv->update_data.vfob.mode;
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_MEM:
         p = (char *) &priv->update_data.current_front.mode;
-        ci = FT990_NATIVE_UPDATE_OP_DATA;
         break;
 
     default:
@@ -884,7 +920,7 @@ int ft990_set_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t rptr_shift)
     }
 
     // Get update for selected VFO
-    err = ft990_get_update_data(rig, ci, 0);
+    err = ft990_get_status(rig, p, 1);
 
     if (err != RIG_OK)
     {
@@ -954,7 +990,6 @@ int ft990_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
 {
     struct ft990_priv_data *priv;
     ft990_op_data_t *p;
-    unsigned char ci;
     int err;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -981,18 +1016,15 @@ int ft990_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
     case RIG_VFO_A:
     case RIG_VFO_VFO:
         p = &priv->update_data.vfoa;
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_B:
         p = &priv->update_data.vfob;
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
         p = &priv->update_data.current_front;
-        ci = FT990_NATIVE_UPDATE_OP_DATA;
         break;
 
     default:
@@ -1000,7 +1032,7 @@ int ft990_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
     }
 
     // Get update for selected VFO
-    err = ft990_get_update_data(rig, ci, 0);
+    err = ft990_get_status(rig, p, sizeof(ft990_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -1216,7 +1248,7 @@ int ft990_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split, vfo_t *tx_vfo)
     priv = (struct ft990_priv_data *) rig->state.priv;
 
     // Read status flags
-    err = ft990_get_update_data(rig, FT990_NATIVE_READ_FLAGS, 0);
+    err = ft990_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -1331,7 +1363,8 @@ int ft990_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
     // If rit = 0 disable RX clarifier
     if (rit == 0)
     {
-        err = ft990_get_update_data(rig, FT990_NATIVE_UPDATE_OP_DATA, 0);
+        err = ft990_get_status(rig,
+                &priv->update_data.current_front, sizeof(ft990_op_data_t));
 
         if (err != RIG_OK)
         {
@@ -1400,7 +1433,6 @@ int ft990_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
 int ft990_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
 {
     struct ft990_priv_data *priv;
-    unsigned char ci;
     ft990_op_data_t *p;
     int err;
 
@@ -1427,18 +1459,15 @@ int ft990_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
     {
     case RIG_VFO_A:
     case RIG_VFO_VFO:
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         p = (ft990_op_data_t *) &priv->update_data.vfoa;
         break;
 
     case RIG_VFO_B:
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         p = (ft990_op_data_t *) &priv->update_data.vfob;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
-        ci = FT990_NATIVE_UPDATE_OP_DATA;
         p = (ft990_op_data_t *) &priv->update_data.current_front;
         break;
 
@@ -1447,7 +1476,7 @@ int ft990_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
     }
 
     // Get update for selected VFO/MEM
-    err = ft990_get_update_data(rig, ci, 0);
+    err = ft990_get_status(rig, p, sizeof(ft990_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -1537,7 +1566,8 @@ int ft990_set_xit(RIG *rig, vfo_t vfo, shortfreq_t xit)
     // Disable TX clarifier and return if xit = 0
     if (xit == 0)
     {
-        err = ft990_get_update_data(rig, FT990_NATIVE_UPDATE_OP_DATA, 0);
+        err = ft990_get_status(rig,
+                &priv->update_data.current_front, sizeof(ft990_op_data_t));
 
         if (err != RIG_OK)
         {
@@ -1605,7 +1635,6 @@ int ft990_set_xit(RIG *rig, vfo_t vfo, shortfreq_t xit)
 int ft990_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
 {
     struct ft990_priv_data *priv;
-    unsigned char ci;
     ft990_op_data_t *p;
     int err;
 
@@ -1631,18 +1660,15 @@ int ft990_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
     {
     case RIG_VFO_A:
     case RIG_VFO_VFO:
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         p = (ft990_op_data_t *) &priv->update_data.vfoa;
         break;
 
     case RIG_VFO_B:
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         p = (ft990_op_data_t *) &priv->update_data.vfob;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
-        ci = FT990_NATIVE_UPDATE_OP_DATA;
         p = (ft990_op_data_t *) &priv->update_data.current_front;
         break;
 
@@ -1650,7 +1676,7 @@ int ft990_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
         return -RIG_EINVAL;
     }
 
-    err = ft990_get_update_data(rig, ci, 0);
+    err = ft990_get_status(rig, p, sizeof(ft990_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -1780,7 +1806,7 @@ int ft990_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
 
     priv = (struct ft990_priv_data *)rig->state.priv;
 
-    err = ft990_get_update_data(rig, FT990_NATIVE_READ_FLAGS, 0);
+    err = ft990_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -2043,7 +2069,6 @@ int ft990_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
     struct ft990_priv_data *priv;
     unsigned char *p;
     unsigned char *fl;
-    unsigned char ci;
     int err;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -2069,20 +2094,17 @@ int ft990_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
     case RIG_VFO_A:
     case RIG_VFO_VFO:
         p = &priv->update_data.vfoa.mode;
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         fl = &priv->update_data.vfoa.filter;
         break;
 
     case RIG_VFO_B:
         p = &priv->update_data.vfob.mode;
-        ci = FT990_NATIVE_UPDATE_VFO_DATA;
         fl = &priv->update_data.vfob.filter;
         break;
 
     case RIG_VFO_MEM:
     case RIG_VFO_MAIN:
         p = &priv->update_data.current_front.mode;
-        ci = FT990_NATIVE_UPDATE_OP_DATA;
         fl = &priv->update_data.current_front.filter;
         break;
 
@@ -2091,7 +2113,7 @@ int ft990_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
     }
 
     // Get update for selected VFO
-    err = ft990_get_update_data(rig, ci, 0);
+    err = ft990_get_status(rig, p, 2);
 
     if (err != RIG_OK)
     {
@@ -2317,7 +2339,7 @@ int ft990_get_vfo(RIG *rig, vfo_t *vfo)
     priv = (struct ft990_priv_data *)rig->state.priv;
 
     /* Get flags for VFO status */
-    err = ft990_get_update_data(rig, FT990_NATIVE_READ_FLAGS, 0);
+    err = ft990_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -2681,7 +2703,7 @@ int ft990_get_mem(RIG *rig, vfo_t vfo, int *ch)
                   __func__, vfo);
     }
 
-    err = ft990_get_update_data(rig, FT990_NATIVE_UPDATE_MEM_CHNL, 0);
+    err = ft990_get_status(rig, &priv->update_data.channelnumber, 1);
 
     if (err != RIG_OK)
     {
@@ -2750,7 +2772,6 @@ int ft990_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
 {
     struct ft990_priv_data *priv;
     ft990_op_data_t *p;
-    char ci;
     int err;
     channel_t _chan;
 
@@ -2789,31 +2810,32 @@ int ft990_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
         {
         // Current or last selected memory channel
         case RIG_VFO_MEM:
-            err = ft990_get_update_data(rig, FT990_NATIVE_UPDATE_MEM_CHNL, 0);
+            err = ft990_get_status(rig, &priv->update_data.channelnumber, 1);
 
             if (err != RIG_OK)
             {
                 return err;
             }
 
+            if (priv->update_data.channelnumber >= 90)
+            {
+                return -RIG_EPROTO;
+            }
+
             chan->channel_num = priv->update_data.channelnumber + 1;
-            p = (ft990_op_data_t *) &priv->update_data.channel[chan->channel_num];
-            ci = FT990_NATIVE_UPDATE_MEM_CHNL_DATA;
+            p = (ft990_op_data_t *) &priv->update_data.channel[chan->channel_num - 1];
             break;
 
         case RIG_VFO_A:
             p = (ft990_op_data_t *) &priv->update_data.vfoa;
-            ci = FT990_NATIVE_UPDATE_VFO_DATA;
             break;
 
         case RIG_VFO_B:
             p = (ft990_op_data_t *) &priv->update_data.vfob;
-            ci = FT990_NATIVE_UPDATE_VFO_DATA;
             break;
 
         case RIG_VFO_CURR:
             p = (ft990_op_data_t *) &priv->update_data.current_front;
-            ci = FT990_NATIVE_UPDATE_OP_DATA;
             break;
 
         default:
@@ -2822,15 +2844,14 @@ int ft990_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
     }
     else
     {
-        p = (ft990_op_data_t *) &priv->update_data.channel[chan->channel_num];
-        ci = FT990_NATIVE_UPDATE_MEM_CHNL_DATA;
+        p = (ft990_op_data_t *) &priv->update_data.channel[chan->channel_num - 1];
         chan->vfo = RIG_VFO_MEM;
     }
 
     /*
      * Get data for selected VFO/MEM
      */
-    err = ft990_get_update_data(rig, ci, chan->channel_num);
+    err = ft990_get_status(rig, p, sizeof(ft990_op_data_t));
 
     if (err != RIG_OK)
     {
@@ -2949,7 +2970,7 @@ int ft990_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
         return -RIG_EINVAL;
     }
 
-    err = ft990_get_update_data(rig, FT990_NATIVE_READ_FLAGS, 0);
+    err = ft990_get_status(rig, &priv->update_data.flag1, 3);
 
     if (err != RIG_OK)
     {
@@ -3216,11 +3237,12 @@ int ft990_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
  * Extended to be command agnostic as 990 has several ways to
  * get data and several ways to return it.
  *
- * Need to use this when doing ft990_get_* stuff
+ * The ft990_get_* functions go through ft990_get_status(), which calls
+ * this when the data they need has gone stale.
  *
  * Arguments:   *rig    Valid RIG instance
  *              ci      command index
- *              rl      expected length of returned data in octets
+ *              ch      memory channel less one for Update Memory Ch Data
  *
  * Returns:     RIG_OK if all called functions are successful,
  *              otherwise returns error from called function
@@ -3248,7 +3270,12 @@ int ft990_get_update_data(RIG *rig, unsigned char ci, unsigned short ch)
     if (ci == FT990_NATIVE_UPDATE_MEM_CHNL_DATA)
         // P4 = 0x01 to 0x5a for channel 1 - 90
     {
-        err = ft990_send_dynamic_cmd(rig, ci, 4, 0, 0, ch);
+        if (ch >= 90)
+        {
+            return -RIG_EINVAL;
+        }
+
+        err = ft990_send_dynamic_cmd(rig, ci, 4, 0, 0, ch + 1);
     }
     else
     {
@@ -3312,6 +3339,118 @@ int ft990_get_update_data(RIG *rig, unsigned char ci, unsigned short ch)
     return RIG_OK;
 }
 
+/*
+ * Private helper function. Makes a field of priv->update_data current,
+ * reading the smallest update that holds it unless it was read within
+ * the cache timeout and no command has changed it since.
+ *
+ * Arguments:   *rig    Valid RIG instance
+ *              field   pointer into priv->update_data
+ *              length  of the field in octets
+ *
+ * Returns:     RIG_OK if all called functions are successful,
+ *              otherwise returns error from called function
+ */
+int ft990_get_status(RIG *rig, const void *field, size_t length)
+{
+    struct ft990_priv_data *priv = (struct ft990_priv_data *)rig->state.priv;
+
+    return ftstatus_get(rig, &priv->status,
+                        (const unsigned char *) field
+                        - (const unsigned char *) &priv->update_data, length);
+}
+
+/*
+ * Private helper function. Marks what command ci changes in
+ * priv->update_data stale, called once the command has been sent.
+ *
+ * Arguments:   *rig    Valid RIG instance
+ *              ci      Command index of the ncmd table
+ */
+static void ft990_invalidate(RIG *rig, unsigned char ci)
+{
+    struct ft990_priv_data *priv = (struct ft990_priv_data *)rig->state.priv;
+    ftstatus_cache_t *status = &priv->status;
+
+    switch (ci)
+    {
+    case FT990_NATIVE_SPLIT_OFF:
+    case FT990_NATIVE_SPLIT_ON:
+    case FT990_NATIVE_LOCK_OFF:
+    case FT990_NATIVE_LOCK_ON:
+    case FT990_NATIVE_PTT_OFF:
+    case FT990_NATIVE_PTT_ON:
+    case FT990_NATIVE_TUNER_OFF:
+    case FT990_NATIVE_TUNER_ON:
+    case FT990_NATIVE_TUNER_START:
+        ftstatus_invalidate(status, FT990_FIELD(flag1), 3);
+        break;
+
+    case FT990_NATIVE_VFO_A:
+    case FT990_NATIVE_VFO_B:
+    case FT990_NATIVE_RECALL_MEM:
+        ftstatus_invalidate(status, FT990_FIELD(flag1), 3);
+        ftstatus_invalidate(status, FT990_FIELD(channelnumber), 1);
+        ftstatus_invalidate(status, FT990_FIELD(current_front),
+                            sizeof(ft990_op_data_t));
+        break;
+
+    /* these change the displayed VFO or memory tune */
+    case FT990_NATIVE_VFO_STEP_UP:
+    case FT990_NATIVE_VFO_STEP_UP_FAST:
+    case FT990_NATIVE_VFO_STEP_DOWN:
+    case FT990_NATIVE_VFO_STEP_DOWN_FAST:
+    case FT990_NATIVE_RX_CLARIFIER_OFF:
+    case FT990_NATIVE_RX_CLARIFIER_ON:
+    case FT990_NATIVE_TX_CLARIFIER_OFF:
+    case FT990_NATIVE_TX_CLARIFIER_ON:
+    case FT990_NATIVE_CLEAR_CLARIFIER_OFFSET:
+    case FT990_NATIVE_CLARIFIER_OPS:
+    case FT990_NATIVE_FREQ_SET:
+    case FT990_NATIVE_MODE_SET_LSB:
+    case FT990_NATIVE_MODE_SET_USB:
+    case FT990_NATIVE_MODE_SET_CW_W:
+    case FT990_NATIVE_MODE_SET_CW_N:
+    case FT990_NATIVE_MODE_SET_AM_W:
+    case FT990_NATIVE_MODE_SET_AM_N:
+    case FT990_NATIVE_MODE_SET_FM:
+    case FT990_NATIVE_MODE_SET_RTTY_LSB:
+    case FT990_NATIVE_MODE_SET_RTTY_USB:
+    case FT990_NATIVE_MODE_SET_PKT_LSB:
+    case FT990_NATIVE_MODE_SET_PKT_FM:
+    case FT990_NATIVE_RPTR_SHIFT_NONE:
+    case FT990_NATIVE_RPTR_SHIFT_MINUS:
+    case FT990_NATIVE_RPTR_SHIFT_PLUS:
+    case FT990_NATIVE_RPTR_OFFSET:
+    case FT990_NATIVE_BANDWIDTH:
+    case FT990_NATIVE_OP_FREQ_STEP_UP:
+    case FT990_NATIVE_OP_FREQ_STEP_DOWN:
+        ftstatus_invalidate(status, FT990_FIELD(current_front),
+                            sizeof(ft990_op_data_t));
+
+        if (priv->current_vfo != RIG_VFO_B && priv->current_vfo != RIG_VFO_MEM)
+        {
+            ftstatus_invalidate(status, FT990_FIELD(vfoa), sizeof(ft990_op_data_t));
+        }
+
+        if (priv->current_vfo != RIG_VFO_A && priv->current_vfo != RIG_VFO_MEM)
+        {
+            ftstatus_invalidate(status, FT990_FIELD(vfob), sizeof(ft990_op_data_t));
+        }
+
+        break;
+
+    case FT990_NATIVE_VFO_TO_MEM:
+    case FT990_NATIVE_MEM_TO_VFO:
+    case FT990_NATIVE_VFO_TO_VFO:
+        ftstatus_invalidate_all(status);
+        break;
+
+    default:
+        break;
+    }
+}
+
 /*
  * Private helper function to send a complete command sequence.
  *
@@ -3342,6 +3481,7 @@ int ft990_send_static_cmd(RIG *rig, unsigned char ci)
     }
 
     err = write_block(RIGPORT(rig), ncmd[ci].nseq, YAESU_CMD_LENGTH);
+    ft990_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -3401,6 +3541,7 @@ int ft990_send_dynamic_cmd(RIG *rig, unsigned char ci,
 
     err = write_block(RIGPORT(rig), (unsigned char *) &priv->p_cmd,
                       YAESU_CMD_LENGTH);
+    ft990_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -3460,6 +3601,7 @@ int ft990_send_dial_freq(RIG *rig, unsigned char ci, freq_t freq)
 
     err = write_block(RIGPORT(rig), (unsigned char *) &priv->p_cmd,
                       YAESU_CMD_LENGTH);
+    ft990_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
@@ -3525,6 +3667,7 @@ int ft990_send_rit_freq(RIG *rig, unsigned char ci, shortfreq_t rit)
 
     err = write_block(RIGPORT(rig), (unsigned char *) &priv->p_cmd,
                       YAESU_CMD_LENGTH);
+    ft990_invalidate(rig, ci);
 
     if (err != RIG_OK)
     {
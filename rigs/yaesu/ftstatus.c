@@ -0,0 +1,215 @@
+/*
+ * ftstatus.c - status block cache of the Yaesu rigs that report their
+ * state in fixed binary update blocks (FT-990, FT-1000D, FT-920)
+ *
+ * These rigs answer a read with an update block of up to 32 bytes, and
+ * the backends used to ask for one for every get call, so a client
+ * polling frequency, mode, PTT, split and clarifier moved the same block
+ * over a 4800 baud link several times a round.  Each field of the status
+ * image remembers when it was read.  A get is served from the image while
+ * the fields it needs are younger than the rig's cache timeout, otherwise
+ * the smallest update holding them is read, and a command that changes
+ * the rig marks just the fields it changes stale.
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <stdlib.h>
+
+#include "hamlib/rig.h"
+#include "misc.h"
+#include "ftstatus.h"
+
+
+static int overlaps(const struct ftstatus_slot *slot, unsigned int offset,
+                    unsigned int length)
+{
+    return offset < slot->offset + slot->length
+           && slot->offset < offset + length;
+}
+
+
+int ftstatus_init(ftstatus_cache_t *cache, const ftstatus_field_t *fields,
+                  int nfields, const ftstatus_block_t *blocks, int nblocks,
+                  ftstatus_fetch_t fetch)
+{
+    int i, j, n = 0;
+
+    for (i = 0; i < nfields; i++)
+    {
+        n += fields[i].count;
+    }
+
+    cache->slot = calloc(n, sizeof(struct ftstatus_slot));
+
+    if (!cache->slot)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    for (i = 0; i < nfields; i++)
+    {
+        for (j = 0; j < fields[i].count; j++)
+        {
+            struct ftstatus_slot *slot = &cache->slot[cache->nslots++];
+
+            slot->offset = fields[i].offset + j * fields[i].length;
+            slot->length = fields[i].length;
+        }
+    }
+
+    cache->blocks = blocks;
+    cache->nblocks = nblocks;
+    cache->fetch = fetch;
+
+    return RIG_OK;
+}
+
+
+void ftstatus_cleanup(ftstatus_cache_t *cache)
+{
+    free(cache->slot);
+    cache->slot = NULL;
+    cache->nslots = 0;
+}
+
+
+/*
+ * Makes length bytes at offset of the status image current, reading the
+ * smallest update that holds them unless every field they touch is
+ * younger than the cache timeout.
+ */
+int ftstatus_get(RIG *rig, ftstatus_cache_t *cache, unsigned int offset,
+                 unsigned int length)
+{
+    int timeout_ms = rig_get_cache_timeout_ms(rig, HAMLIB_CACHE_ALL);
+    const ftstatus_block_t *best = NULL;
+    unsigned int index = 0;
+    unsigned int start;
+    int fresh = 0;
+    int err;
+    int i;
+
+    for (i = 0; i < cache->nslots; i++)
+    {
+        struct ftstatus_slot *slot = &cache->slot[i];
+
+        if (!overlaps(slot, offset, length))
+        {
+            continue;
+        }
+
+        fresh = slot->valid && timeout_ms != 0
+                && (timeout_ms == HAMLIB_CACHE_ALWAYS
+                    || elapsed_ms(&slot->stamp, HAMLIB_ELAPSED_GET) < timeout_ms);
+
+        if (!fresh)
+        {
+            break;
+        }
+    }
+
+    if (fresh)
+    {
+        return RIG_OK;
+    }
+
+    for (i = 0; i < cache->nblocks; i++)
+    {
+        const ftstatus_block_t *block = &cache->blocks[i];
+        unsigned int n;
+
+        if (offset < block->offset)
+        {
+            continue;
+        }
+
+        n = (offset - block->offset) / block->length;
+
+        if (n >= block->count
+                || offset + length > block->offset + (n + 1) * block->length)
+        {
+            continue;
+        }
+
+        if (!best || block->rl < best->rl)
+        {
+            best = block;
+            index = n;
+        }
+    }
+
+    if (!best)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: no update holds %u bytes at %u\n", __func__,
+                  length, offset);
+        return -RIG_EINTERNAL;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: reading update 0x%02x copy %u for %u bytes "
+              "at %u\n", __func__, best->ci, index, length, offset);
+
+    err = cache->fetch(rig, best->ci, index);
+
+    if (err != RIG_OK)
+    {
+        return err;
+    }
+
+    start = best->offset + index * best->length;
+
+    for (i = 0; i < cache->nslots; i++)
+    {
+        struct ftstatus_slot *slot = &cache->slot[i];
+
+        if (slot->offset >= start
+                && slot->offset + slot->length <= start + best->length)
+        {
+            slot->valid = 1;
+            elapsed_ms(&slot->stamp, HAMLIB_ELAPSED_SET);
+        }
+    }
+
+    return RIG_OK;
+}
+
+
+/* the rig has been told to change what is at offset */
+void ftstatus_invalidate(ftstatus_cache_t *cache, unsigned int offset,
+                         unsigned int length)
+{
+    int i;
+
+    for (i = 0; i < cache->nslots; i++)
+    {
+        if (overlaps(&cache->slot[i], offset, length))
+        {
+            cache->slot[i].valid = 0;
+        }
+    }
+}
+
+
+void ftstatus_invalidate_all(ftstatus_cache_t *cache)
+{
+    int i;
+
+    for (i = 0; i < cache->nslots; i++)
+    {
+        cache->slot[i].valid = 0;
+    }
+}
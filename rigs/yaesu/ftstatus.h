@@ -0,0 +1,84 @@
+/*
+ * ftstatus.h - status block cache of the Yaesu rigs that report their
+ * state in fixed binary update blocks (FT-990, FT-1000D, FT-920)
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _FTSTATUS_H
+#define _FTSTATUS_H 1
+
+#include <time.h>
+#include <hamlib/rig.h>
+
+/*
+ * The backend keeps what the rig sends in one status image and describes
+ * it with two tables.  A field is a part of the image that is read and
+ * goes stale as a whole, e.g. the status flags or the data of a VFO.  A
+ * block is an update the rig can be asked for, with the part of the image
+ * it fills.  Both may repeat count times one after the other, as the
+ * memory channels do; a block copy is asked for by its index.
+ */
+typedef struct
+{
+    unsigned short offset;      /* in the status image */
+    unsigned short length;
+    unsigned short count;       /* copies, at least 1 */
+} ftstatus_field_t;
+
+typedef struct
+{
+    unsigned char ci;           /* native command index of the update */
+    unsigned short offset;      /* of the part of the image it fills */
+    unsigned short length;
+    unsigned short rl;          /* bytes the rig sends for it */
+    unsigned short count;       /* copies, at least 1 */
+} ftstatus_block_t;
+
+/* reads copy index of update ci from the rig into the status image */
+typedef int (*ftstatus_fetch_t)(RIG *rig, unsigned char ci,
+                                unsigned short index);
+
+struct ftstatus_slot
+{
+    unsigned short offset;
+    unsigned short length;
+    int valid;
+    struct timespec stamp;      /* when it was read */
+};
+
+typedef struct
+{
+    const ftstatus_block_t *blocks;
+    int nblocks;
+    ftstatus_fetch_t fetch;
+    struct ftstatus_slot *slot; /* a slot per field copy */
+    int nslots;
+} ftstatus_cache_t;
+
+int ftstatus_init(ftstatus_cache_t *cache, const ftstatus_field_t *fields,
+                  int nfields, const ftstatus_block_t *blocks, int nblocks,
+                  ftstatus_fetch_t fetch);
+void ftstatus_cleanup(ftstatus_cache_t *cache);
+
+int ftstatus_get(RIG *rig, ftstatus_cache_t *cache, unsigned int offset,
+                 unsigned int length);
+void ftstatus_invalidate(ftstatus_cache_t *cache, unsigned int offset,
+                         unsigned int length);
+void ftstatus_invalidate_all(ftstatus_cache_t *cache);
+
+#endif /* _FTSTATUS_H */
@@ -18,3 +18,79 @@ int write_sim(int fd, const unsigned char *buf, int buflen, const char *func,
 
     return n;
 }
+
+/*
+ * CW keyer with a buffer of capacity characters keyed at wpm, for the
+ * send_morse commands.  Each text taken is reported on stdout as
+ * "CW text=<chars> idle_ms=<ms>", idle_ms being how long the keyer had
+ * already run out of text, 0 while it is still keying.
+ */
+#define SIM_CW_MAX 256
+
+static double sim_cw_end_ms[SIM_CW_MAX];
+static int sim_cw_first, sim_cw_count;
+static double sim_cw_last_ms = -1;
+static struct timespec sim_cw_start;
+
+static double sim_cw_now(void)
+{
+    if (sim_cw_start.tv_sec == 0)
+    {
+        elapsed_ms(&sim_cw_start, HAMLIB_ELAPSED_SET);
+    }
+
+    return elapsed_ms(&sim_cw_start, HAMLIB_ELAPSED_GET);
+}
+
+/* characters taken and not keyed yet */
+int sim_cw_pending(void)
+{
+    double now = sim_cw_now();
+
+    while (sim_cw_count > 0 && sim_cw_end_ms[sim_cw_first] <= now)
+    {
+        sim_cw_first = (sim_cw_first + 1) % SIM_CW_MAX;
+        sim_cw_count--;
+    }
+
+    return sim_cw_count;
+}
+
+/* returns -1 without taking any of the text if it does not fit */
+int sim_cw_send(const char *text, int len, int wpm, int capacity)
+{
+    double now = sim_cw_now();
+    double end;
+    int i;
+
+    if (capacity > SIM_CW_MAX) { capacity = SIM_CW_MAX; }
+
+    if (sim_cw_pending() + len > capacity)
+    {
+        printf("CW rejected text=%d pending=%d\n", len, sim_cw_count);
+        return -1;
+    }
+
+    end = sim_cw_count > 0 ? sim_cw_end_ms[(sim_cw_first + sim_cw_count - 1)
+                                           % SIM_CW_MAX] : now;
+    printf("CW text=%d idle_ms=%.0f\n", len,
+           sim_cw_count > 0 || sim_cw_last_ms < 0 ? 0 : now - sim_cw_last_ms);
+
+    for (i = 0; i < len; i++)
+    {
+        end += dot10ths_to_millis(morse_code_char_to_dot10ths(text[i]), wpm);
+        sim_cw_end_ms[(sim_cw_first + sim_cw_count) % SIM_CW_MAX] = end;
+        sim_cw_count++;
+    }
+
+    sim_cw_last_ms = end;
+
+    return 0;
+}
+
+void sim_cw_stop(void)
+{
+    printf("CW stop pending=%d\n", sim_cw_pending());
+    sim_cw_count = 0;
+    sim_cw_last_ms = -1;
+}
@@ -1,5 +1,7 @@
 // can run this using rigctl/rigctld and socat pty devices
 // gcc -o simft1000 simft1000.c
+// answers the FT1000D update requests, status flags and meter from its
+// own state
 #define _XOPEN_SOURCE 700
 // since we are POSIX here we need this
 #if 0
@@ -18,14 +20,60 @@ struct ip_mreq
 
 #define BUFSIZE 256
 
-float freqA = 14074000;
-float freqB = 14074500;
-char tx_vfo = '0';
-char rx_vfo = '0';
-char modeA = '1';
-char modeB = '1';
-int width_main = 500;
-int width_sub = 700;
+#define OP_LENGTH 16    /* one VFO or memory record */
+
+int freqA = 14074000;
+int freqB = 14074500;
+int vfo = 0;            /* 0 = A, 1 = B */
+int split = 0;
+int ptt = 0;
+unsigned char modeA = 1;    /* USB */
+unsigned char modeB = 1;
+unsigned char filterA = 0;  /* 2.4 kHz */
+unsigned char filterB = 0;
+
+/* the op mode of the set mode command to the mode and filter reported */
+static const unsigned char op_mode[12][2] =
+{
+    { 0, 0x00 }, { 1, 0x00 }, { 2, 0x00 }, { 2, 0x02 }, { 3, 0x00 },
+    { 3, 0x80 }, { 4, 0x00 }, { 4, 0x00 }, { 5, 0x00 }, { 5, 0x80 },
+    { 6, 0x00 }, { 6, 0x80 },
+};
+
+
+static void op_record(unsigned char *p, int freq, unsigned char mode,
+                      unsigned char filter)
+{
+    memset(p, 0, OP_LENGTH);
+    freq /= 10;
+    p[1] = freq >> 16;
+    p[2] = freq >> 8;
+    p[3] = freq;
+    p[7] = mode;
+    p[8] = filter;
+}
+
+/* flags, channel number, front, rear, VFO A, VFO B and 90 channels */
+static void status_image(unsigned char *buf)
+{
+    int i;
+
+    buf[0] = (split ? 0x01 : 0) | (ptt ? 0x80 : 0);
+    buf[1] = 0x20;
+    buf[2] = ptt ? 0x01 : 0;
+    buf[3] = 0;
+    op_record(&buf[4], vfo ? freqB : freqA, vfo ? modeB : modeA,
+              vfo ? filterB : filterA);
+    op_record(&buf[4 + OP_LENGTH], vfo ? freqA : freqB, vfo ? modeA : modeB,
+              vfo ? filterA : filterB);
+    op_record(&buf[4 + 2 * OP_LENGTH], freqA, modeA, filterA);
+    op_record(&buf[4 + 3 * OP_LENGTH], freqB, modeB, filterB);
+
+    for (i = 0; i < 90; i++)
+    {
+        op_record(&buf[4 + (4 + i) * OP_LENGTH], 7000000 + i * 1000, 0, 0);
+    }
+}
 
 
 int
@@ -89,7 +137,10 @@ int openPort(char *comport) // doesn't matter for using pts devices
 
 int main(int argc, char *argv[])
 {
+    unsigned char image[4 + 94 * OP_LENGTH];
+    unsigned char reply[5];
     unsigned char buf[256];
+    int freq;
 
 again:
     int fd = openPort(argv[1]);
@@ -110,26 +161,73 @@ again:
             continue;
         }
 
+        status_image(image);
+
         switch (buf[4])
         {
         case 0x01:
             printf("Split\n");
+            split = buf[3] & 1;
             break;
 
         case 0x05:
             printf("Select VFO\n");
+            vfo = buf[3] & 1;
             break;
 
         case 0x0a:
-            printf("Set Main freq\n");
+        case 0x8a:
+            printf(buf[4] == 0x0a ? "Set Main freq\n" : "Set Sub freq\n");
+            freq = ((buf[3] >> 4) * 10000000 + (buf[3] & 0x0f) * 1000000
+                    + (buf[2] >> 4) * 100000 + (buf[2] & 0x0f) * 10000
+                    + (buf[1] >> 4) * 1000 + (buf[1] & 0x0f) * 100
+                    + (buf[0] >> 4) * 10 + (buf[0] & 0x0f)) * 10;
+
+            if (buf[4] == 0x8a || vfo) { freqB = freq; }
+            else { freqA = freq; }
+
             break;
 
         case 0x10:
             printf("Info\n");
+
+            /* the FT-1000D sends only the front VFO as OP data */
+            switch (buf[3])
+            {
+            case 1: write(fd, &image[3], 1); break;
+
+            case 2: write(fd, &image[4], OP_LENGTH); break;
+
+            case 3: write(fd, &image[4 + 2 * OP_LENGTH], 2 * OP_LENGTH); break;
+
+            case 4:
+                if (buf[0] >= 1 && buf[0] <= 90)
+                {
+                    write(fd, &image[4 + (3 + buf[0]) * OP_LENGTH], OP_LENGTH);
+                }
+
+                break;
+            }
+
             break;
 
         case 0x0c:
             printf("Set mode\n");
+
+            if ((buf[3] & 0x7f) < 12)
+            {
+                if ((buf[3] & 0x80) || vfo)
+                {
+                    modeB = op_mode[buf[3] & 0x7f][0];
+                    filterB = op_mode[buf[3] & 0x7f][1];
+                }
+                else
+                {
+                    modeA = op_mode[buf[3] & 0x7f][0];
+                    filterA = op_mode[buf[3] & 0x7f][1];
+                }
+            }
+
             break;
 
         case 0x0e:
@@ -138,22 +236,31 @@ again:
 
         case 0x0f:
             printf("Tx\n");
+            ptt = buf[3] & 1;
             break;
 
         case 0x83:
             printf("Full Duplex Rx Mode\n");
             break;
 
-        case 0x8a:
-            printf("Set Sub freq\n");
-            break;
-
         case 0x8b:
             printf("Bandwidth\n");
             break;
 
         case 0xf7:
             printf("Read meter\n");
+            memset(reply, 0, sizeof(reply));
+            reply[0] = ptt ? 0x80 : 0x60;
+            reply[4] = 0xf7;
+            write(fd, reply, sizeof(reply));
+            break;
+
+        case 0xfa:
+            printf("Read flags\n");
+            memcpy(reply, image, 3);
+            reply[3] = 0;
+            reply[4] = 0xfa;
+            write(fd, reply, sizeof(reply));
             break;
 
         default: printf("Unknown cmd=%02x\n", buf[4]);
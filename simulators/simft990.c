@@ -1,6 +1,8 @@
 // can run this using rigctl/rigctld and socat pty devices
 // gcc -o simft990 simft990.c
-// emulates 1.2 ROM FT990 which can only read 1492 bytes
+// answers the FT990 update requests from its own state, or with the
+// 1492 bytes of a 1.2 ROM FT990 from simft990.dat for Update All Data
+// when that file is in the current directory
 #define _XOPEN_SOURCE 700
 // since we are POSIX here we need this
 #if 0
@@ -19,36 +21,29 @@ struct ip_mreq
 
 #define BUFSIZE 256
 
-float freqA = 14074000;
-float freqB = 14074500;
-char tx_vfo = '0';
-char rx_vfo = '0';
-char modeA = '1';
-char modeB = '1';
-int width_main = 500;
-int width_sub = 700;
+#define OP_LENGTH 16    /* one VFO or memory record */
 
+int freqA = 14074000;
+int freqB = 14074500;
+int vfo = 0;            /* 0 = A, 1 = B */
+int split = 0;
+int ptt = 0;
+unsigned char modeA = 1;    /* USB */
+unsigned char modeB = 1;
+unsigned char filterA = 0;  /* 2.4 kHz */
+unsigned char filterB = 0;
 
-// ID 0310 == 310, Must drop leading zero
-typedef enum nc_rigid_e
+/* the op mode of the set mode command to the mode and filter reported */
+static const unsigned char op_mode[12][2] =
 {
-    NC_RIGID_NONE            = 0,
-    NC_RIGID_FT450           = 241,
-    NC_RIGID_FT450D          = 244,
-    NC_RIGID_FT950           = 310,
-    NC_RIGID_FT891           = 135,
-    NC_RIGID_FT991           = 135,
-    NC_RIGID_FT2000          = 251,
-    NC_RIGID_FT2000D         = 252,
-    NC_RIGID_FTDX1200        = 583,
-    NC_RIGID_FTDX9000D       = 101,
-    NC_RIGID_FTDX9000Contest = 102,
-    NC_RIGID_FTDX9000MP      = 103,
-    NC_RIGID_FTDX5000        = 362,
-    NC_RIGID_FTDX3000        = 460,
-    NC_RIGID_FTDX101D        = 681,
-    NC_RIGID_FTDX101MP       = 682
-} nc_rigid_t;
+    { 0, 0x00 }, { 1, 0x00 }, { 2, 0x00 }, { 2, 0x02 }, { 3, 0x00 },
+    { 3, 0x80 }, { 4, 0x00 }, { 4, 0x00 }, { 5, 0x00 }, { 5, 0x80 },
+    { 6, 0x00 }, { 6, 0x80 },
+};
+
+
+static unsigned char alldata[1492];
+static int alldata_len;
 
 void load_dat(const char *filename, unsigned char buf[1492])
 {
@@ -56,6 +51,11 @@ void load_dat(const char *filename, unsigned char buf[1492])
     char line[4096];
     int n = 0;
 
+    if (fp == NULL)
+    {
+        return;
+    }
+
     while (fgets(line, sizeof(line), fp))
     {
         char *s = strdup(line);
@@ -67,7 +67,7 @@ void load_dat(const char *filename, unsigned char buf[1492])
             sscanf(p, "%x", &val);
             buf[n++] = val;
         }
-        while (p = strtok(NULL, " \r\n"));
+        while ((p = strtok(NULL, " \r\n")));
 
         strtok(s, "\r\n");
         //printf("n=%d, %s\n",n,s);
@@ -76,9 +76,44 @@ void load_dat(const char *filename, unsigned char buf[1492])
 
     fclose(fp);
     printf("%d bytes read\n", n);
+    alldata_len = n;
 }
 
-static unsigned char alldata[1492];
+static void op_record(unsigned char *p, int freq, unsigned char mode,
+                      unsigned char filter)
+{
+    memset(p, 0, OP_LENGTH);
+    freq /= 10;
+    p[1] = freq >> 16;
+    p[2] = freq >> 8;
+    p[3] = freq;
+    p[7] = mode;
+    p[8] = filter;
+}
+
+/* flags, channel number, front, rear, VFO A, VFO B and 90 channels */
+static int status_image(unsigned char *buf)
+{
+    int i;
+
+    buf[0] = (split ? 0x01 : 0) | (vfo ? 0x02 : 0) | (ptt ? 0x80 : 0);
+    buf[1] = 0x20;
+    buf[2] = ptt ? 0x01 : 0;
+    buf[3] = 0;
+    op_record(&buf[4], vfo ? freqB : freqA, vfo ? modeB : modeA,
+              vfo ? filterB : filterA);
+    op_record(&buf[4 + OP_LENGTH], vfo ? freqA : freqB, vfo ? modeA : modeB,
+              vfo ? filterA : filterB);
+    op_record(&buf[4 + 2 * OP_LENGTH], freqA, modeA, filterA);
+    op_record(&buf[4 + 3 * OP_LENGTH], freqB, modeB, filterB);
+
+    for (i = 0; i < 90; i++)
+    {
+        op_record(&buf[4 + (4 + i) * OP_LENGTH], 7000000 + i * 1000, 0, 0);
+    }
+
+    return 4 + 94 * OP_LENGTH;
+}
 
 int
 getmyline(int fd, char *buf)
@@ -146,26 +181,118 @@ int openPort(char *comport) // doesn't matter for using pts devices
 
 int main(int argc, char *argv[])
 {
+    unsigned char image[4 + 94 * OP_LENGTH];
+    unsigned char reply[5];
     char buf[256];
     int fd = openPort(argv[1]);
+    int freq;
+    int n;
 
     load_dat("simft990.dat", alldata);
 
     while (1)
     {
         int bytes = getmyline(fd, buf);
+        unsigned char *cmd = (unsigned char *) buf;
 
         if (bytes == 0) { continue; }
 
         if (bytes != 5)
         {
             printf("Not 5 bytes?  bytes=%d\n", bytes);
+            continue;
         }
 
-        if (buf[4] == 0x10)
+        n = status_image(image);
+
+        switch (cmd[4])
         {
-            write(fd, alldata, 1492);
+        case 0x01:
+            split = cmd[3] & 1;
+            break;
+
+        case 0x05:
+            vfo = cmd[3] & 1;
+            break;
+
+        case 0x0a:
+        case 0x8a:
+            freq = ((cmd[3] >> 4) * 10000000 + (cmd[3] & 0x0f) * 1000000
+                    + (cmd[2] >> 4) * 100000 + (cmd[2] & 0x0f) * 10000
+                    + (cmd[1] >> 4) * 1000 + (cmd[1] & 0x0f) * 100
+                    + (cmd[0] >> 4) * 10 + (cmd[0] & 0x0f)) * 10;
+
+            if (cmd[4] == 0x8a || vfo) { freqB = freq; }
+            else { freqA = freq; }
+
+            break;
+
+        case 0x0c:
+            if ((cmd[3] & 0x7f) < 12)
+            {
+                if ((cmd[3] & 0x80) || vfo)
+                {
+                    modeB = op_mode[cmd[3] & 0x7f][0];
+                    filterB = op_mode[cmd[3] & 0x7f][1];
+                }
+                else
+                {
+                    modeA = op_mode[cmd[3] & 0x7f][0];
+                    filterA = op_mode[cmd[3] & 0x7f][1];
+                }
+            }
+
+            break;
+
+        case 0x0f:
+            ptt = cmd[3] & 1;
+            break;
+
+        case 0x10:
+            switch (cmd[3])
+            {
+            case 0:
+                if (alldata_len) { write(fd, alldata, alldata_len); }
+                else { write(fd, image, n); }
+
+                break;
+
+            case 1: write(fd, &image[3], 1); break;
+
+            case 2: write(fd, &image[4], 2 * OP_LENGTH); break;
+
+            case 3: write(fd, &image[4 + 2 * OP_LENGTH], 2 * OP_LENGTH); break;
+
+            case 4:
+                if (cmd[0] >= 1 && cmd[0] <= 90)
+                {
+                    write(fd, &image[4 + (3 + cmd[0]) * OP_LENGTH], OP_LENGTH);
+                }
+
+                break;
+            }
+
+            break;
+
+        case 0xf7:
+            memset(reply, 0, sizeof(reply));
+            reply[0] = ptt ? 0x80 : 0x60;
+            reply[4] = 0xf7;
+            write(fd, reply, sizeof(reply));
+            break;
+
+        case 0xfa:
+            memcpy(reply, image, 3);
+            reply[3] = 0;
+            reply[4] = 0xfa;
+            write(fd, reply, sizeof(reply));
+            break;
+
+        default:
+            break;
         }
+
+        fflush(stdout);
     }
 
     return 0;
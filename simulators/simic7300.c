@@ -22,6 +22,7 @@ struct ip_mreq
 #include <sys/time.h>
 #include <hamlib/rig.h>
 #include "../src/misc.h"
+#include "sim.h"
 #include <termios.h>
 #include <unistd.h>
 
@@ -267,6 +268,30 @@ void frameParse(int fd, unsigned char *frame, int len)
 
         break;
 
+    case 0x17:
+        if (frame[5] == 0xff)
+        {
+            sim_cw_stop();
+            frame[4] = 0xfb;
+        }
+        else
+        {
+            int len = 0;
+
+            while (5 + len < BUFSIZE && frame[5 + len] != 0xfd) { len++; }
+
+            // keyspd 0-255 is 6-48 WPM, NG when the 30 character buffer is full
+            frame[4] = sim_cw_send((char *) &frame[5], len, 6 + keyspd * 42 / 255,
+                                   30) < 0 ? 0xfa : 0xfb;
+        }
+
+        frame[5] = 0xfd;
+        n = write(fd, frame, 6);
+
+        if (n <= 0) { fprintf(stderr, "%s(%d) write error %s\n", __func__, __LINE__, strerror(errno)); }
+
+        break;
+
     case 0x14:
         printf("cmd=0x14\n");
 
@@ -321,16 +346,17 @@ void frameParse(int fd, unsigned char *frame, int len)
             if (frame[6] != 0xfd) // then we have data
             {
                 printf("subcmd=0x0c #1\n");
-                keyspd = from_bcd(&frame[6], 2);
-                frame[6] = 0xfb;
-                n = write(fd, frame, 7);
+                keyspd = from_bcd_be(&frame[6], 4);
+                frame[4] = 0xfb;
+                frame[5] = 0xfd;
+                n = write(fd, frame, 6);
 
                 if (n <= 0) { fprintf(stderr, "%s(%d) write error %s\n", __func__, __LINE__, strerror(errno)); }
             }
             else
             {
                 printf("subcmd=0x0c #1\n");
-                to_bcd(&frame[6], keyspd, 2);
+                to_bcd_be(&frame[6], keyspd, 4);
                 frame[8] = 0xfd;
                 n = write(fd, frame, 9);
 
@@ -641,15 +667,15 @@ case 0x26:
     {
         for (int i = 0; i < 12; ++i) { printf("%02x:", frame[i]); }
 
-        if (frame[6] == 0)
+        if (frame[5] == 0)
         {
-            modeA = frame[7];
-            datamodeA = frame[8];
+            modeA = frame[6];
+            datamodeA = frame[7];
         }
         else
         {
-            modeB = frame[7];
-            datamodeB = frame[8];
+            modeB = frame[6];
+            datamodeB = frame[7];
         }
 
         frame[4] = 0xfb;
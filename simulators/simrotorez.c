@@ -14,6 +14,7 @@ struct ip_mreq
 #include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include "../include/hamlib/rig.h"
 
 #define BUFSIZE 256
@@ -147,6 +148,40 @@ int main(int argc, char *argv[])
     */
 }
 
+/* degrees per second the simulated motors turn */
+#define RATE 4.0
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* turn towards the target for the time since the last move */
+static void slew(float *pos, float target, double *moved)
+{
+    double now = now_s();
+    float step = (float)((now - *moved) * RATE);
+
+    if (target > *pos + step)
+    {
+        *pos += step;
+    }
+    else if (target < *pos - step)
+    {
+        *pos -= step;
+    }
+    else
+    {
+        *pos = target;
+    }
+
+    *moved = now;
+}
+
 static void *rotorez_thread(void *arg)
 {
     int n = 0;
@@ -154,6 +189,9 @@ static void *rotorez_thread(void *arg)
     int fd = *(int *)arg;
     float az = 123;
     float el = 45;
+    float target_az = az;
+    float target_el = el;
+    double moved = now_s();
 again:
 
     while (1)
@@ -171,6 +209,15 @@ again:
 
         printf("line[%d]=%s\n", fd, buf);
 
+        if (fd == thread_args[0])
+        {
+            slew(&az, target_az, &moved);
+        }
+        else
+        {
+            slew(&el, target_el, &moved);
+        }
+
         if (strncmp(buf, "BI1", 3) == 0)
         {
             if (fd == thread_args[0])
@@ -191,11 +238,11 @@ again:
         {
             if (fd == thread_args[0])
             {
-                sscanf(buf, "AP1%f", &az);
+                sscanf(buf, "AP1%f", &target_az);
             }
             else
             {
-                sscanf(buf, "AP1%f", &el);
+                sscanf(buf, "AP1%f", &target_el);
             }
         }
         else
@@ -1,5 +1,14 @@
-// can run this using rigctl/rigctld and socat pty devices
+// can run this using rotctl/rotctld and socat pty devices
 // gcc -o simspid simspid.c
+//
+// Simulates a SPID Rot2Prog: answers the status, set and stop frames and
+// turns both axes at RATE degrees per second towards the last position
+// set.  Like a real controller it stops the motors and ramps them up
+// again over RAMP seconds on every new position, so trackers sending
+// small steps pay for each one.  Prints each frame with the position and
+// counts the motor starts.
+//
+//   rotctl -m 901 -r /dev/pts/N
 #define _XOPEN_SOURCE 700
 // since we are POSIX here we need this
 #if 0
@@ -14,18 +23,96 @@ struct ip_mreq
 #include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include "../include/hamlib/rig.h"
 
 #define BUFSIZE 256
 
-float freqA = 14074000;
-float freqB = 14074500;
-char tx_vfo = '0';
-char rx_vfo = '0';
-char modeA = '1';
-char modeB = '1';
-int width_main = 500;
-int width_sub = 700;
+/* degrees per second and seconds to full speed */
+#define RATE 6.0
+#define RAMP 0.5
+/* pulses per degree, PH and PV */
+#define RESOLUTION 10
+
+struct axis
+{
+    double pos;
+    double target;
+    double start;       /* when the motor started, 0 stopped */
+};
+
+struct axis az = { 0, 0, 0 };
+struct axis el = { 0, 0, 0 };
+double last_update;
+int starts;
+
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* turn the axis for the time since the last update, ramping up from a start */
+static void axis_update(struct axis *a, double from, double to)
+{
+    double t;
+
+    for (t = from; a->start > 0 && t < to; t += 0.01)
+    {
+        double dt = to - t < 0.01 ? to - t : 0.01;
+        double speed = RATE;
+        double step;
+
+        if (t - a->start < RAMP)
+        {
+            speed = RATE * (t - a->start + dt) / RAMP;
+        }
+
+        step = speed * dt;
+
+        if (a->target > a->pos + step)
+        {
+            a->pos += step;
+        }
+        else if (a->target < a->pos - step)
+        {
+            a->pos -= step;
+        }
+        else
+        {
+            a->pos = a->target;
+            a->start = 0;
+        }
+    }
+}
+
+
+static void update(void)
+{
+    double now = now_s();
+
+    axis_update(&az, last_update, now);
+    axis_update(&el, last_update, now);
+    last_update = now;
+}
+
+
+static void axis_set(struct axis *a, double target)
+{
+    a->target = target;
+
+    if (a->target != a->pos)
+    {
+        /* the controller stops and starts again */
+        a->start = last_update;
+        starts++;
+    }
+}
 
 
 int
@@ -36,17 +123,51 @@ getmyline(int fd, unsigned char *buf)
     int n = 0;
     memset(buf, 0, BUFSIZE);
 
-    while (i < 5 && read(fd, &c, 1) > 0)
+    while (i < 13 && read(fd, &c, 1) > 0)
     {
         buf[i++] = c;
         n++;
     }
 
-    printf("n=%d %02x %02x %02x %02x %02x\n", n, buf[0], buf[1], buf[2], buf[3],
-           buf[4]);
     return n;
 }
 
+
+static void reply_status(int fd)
+{
+    unsigned char buf[12];
+    int u_az = (int)((az.pos + 360) * 10 + 0.5);
+    int u_el = (int)((el.pos + 360) * 10 + 0.5);
+
+    buf[0] = 'W';
+    buf[1] = u_az / 1000;
+    buf[2] = (u_az / 100) % 10;
+    buf[3] = (u_az / 10) % 10;
+    buf[4] = u_az % 10;
+    buf[5] = RESOLUTION;
+    buf[6] = u_el / 1000;
+    buf[7] = (u_el / 100) % 10;
+    buf[8] = (u_el / 10) % 10;
+    buf[9] = u_el % 10;
+    buf[10] = RESOLUTION;
+    buf[11] = ' ';
+
+    if (write(fd, buf, sizeof(buf)) != sizeof(buf))
+    {
+        perror("write");
+    }
+}
+
+
+static double frame_angle(const unsigned char *digits, int resolution)
+{
+    int u = (digits[0] - '0') * 1000 + (digits[1] - '0') * 100
+            + (digits[2] - '0') * 10 + (digits[3] - '0');
+
+    return (double) u / (resolution ? resolution : 1) - 360;
+}
+
+
 #if defined(WIN32) || defined(_WIN32)
 int openPort(char *comport) // doesn't matter for using pts devices
 {
@@ -91,6 +212,8 @@ int main(int argc, char *argv[])
 {
     unsigned char buf[256];
 
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    last_update = now_s();
 
 again:
     int fd = openPort(argv[1]);
@@ -105,19 +228,39 @@ again:
             goto again;
         }
 
-        if (bytes != 5)
+        if (bytes != 13 || buf[0] != 'W' || buf[12] != ' ')
         {
-            printf("Not 5 bytes?  bytes=%d\n", bytes);
+            printf("Not a frame?  bytes=%d\n", bytes);
+            continue;
         }
 
-        switch (buf[0])
+        update();
+
+        switch (buf[11])
         {
-        case '?': printf("Query %c\n", buf[1]); break;
+        case 0x1F:
+            reply_status(fd);
+            break;
+
+        case 0x2F:
+            axis_set(&az, frame_angle(buf + 1, buf[5]));
+            axis_set(&el, frame_angle(buf + 6, buf[10]));
+            break;
 
-        case '*': printf("Set %c\n", buf[1]); break;
+        case 0x0F:
+            az.target = az.pos;
+            el.target = el.pos;
+            az.start = el.start = 0;
+            reply_status(fd);
+            break;
 
-        default: printf("Unknown cmd=%02x\n", buf[4]);
+        default:
+            printf("Unknown cmd=%02x\n", buf[11]);
+            continue;
         }
+
+        printf("cmd=%02x az=%.1f el=%.1f target=%.1f/%.1f starts=%d\n", buf[11],
+               az.pos, el.pos, az.target, el.target, starts);
     }
 
     return 0;
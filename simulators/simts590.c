@@ -404,6 +404,25 @@ int main(int argc, char *argv[])
             }
 
         }
+        else if (strcmp(buf, "KY;") == 0)
+        {
+            // KY1 until there is room for another 24 character message
+            sprintf(buf, "KY%d;", sim_cw_pending() + 24 > 48);
+            WRITE(fd, buf, strlen(buf));
+        }
+        else if (strncmp(buf, "KY ", 3) == 0)
+        {
+            // the message is padded to 24 characters with spaces
+            int len = strlen(buf) - 4;
+
+            while (len > 0 && buf[3 + len - 1] == ' ') { len--; }
+
+            sim_cw_send(buf + 3, len, keyspd, 48);
+        }
+        else if (strncmp(buf, "KY0", 3) == 0)
+        {
+            sim_cw_stop();
+        }
         else if (strncmp(buf, "KS;", 3) == 0)
         {
             sprintf(buf, "KS%03d;", keyspd);
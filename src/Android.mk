@@ -28,7 +28,8 @@ LOCAL_SRC_FILES := \
         microham.c \
         rot_ext.c \
         cm108.c \
-        sprintflst.c
+        sprintflst.c \
+        rig_index.c
 
 
 LOCAL_MODULE := libhamlib
@@ -44,3 +45,10 @@ LOCAL_STATIC_LIBRARIES := adat alinco amsat aor ars barrett celestron cnctrk \
 LOCAL_LDLIBS := -llog -landroid
 
 include $(BUILD_SHARED_LIBRARY)
+
+# the rig model index is generated from the backend sources, as in Makefile.am
+RIG_INDEX_SRC := $(LOCAL_PATH)/../include/hamlib/riglist.h $(LOCAL_PATH)/register.c \
+        $(wildcard $(LOCAL_PATH)/../rigs/*/*.c $(LOCAL_PATH)/../rigs/*/*.h)
+
+$(LOCAL_PATH)/rig_index.c: $(LOCAL_PATH)/mkrigindex.awk $(RIG_INDEX_SRC)
+	awk -f $< $(RIG_INDEX_SRC) > $@
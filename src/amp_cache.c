@@ -0,0 +1,1096 @@
+/*
+ *  Hamlib Interface - amplifier level cache and poller
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file amp_cache.c
+ * \brief Amplifier level cache and poller
+ *
+ * Amplifier backends read each level with its own transaction on a slow
+ * serial link, so a few monitoring clients asking for power, SWR and
+ * faults keep the link saturated.  Every level and the power status read
+ * from the amplifier is cached with the time it was read.  A read younger
+ * than the cache timeout of the level is served from the cache, and a
+ * thread per amplifier, or the loop of its station, can poll chosen
+ * levels at fixed intervals so that clients are served from the cache
+ * while the link carries one read per level and interval, whatever the
+ * number of clients.
+ */
+
+/**
+ * \addtogroup amplifier
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/amplifier.h>
+#include "amp_cache.h"
+#include "station.h"
+#include "token.h"
+#include "misc.h"
+
+//! @cond Doxygen_Suppress
+/* a slot per level, the power status after them */
+#define AMP_CACHE_POWERSTAT RIG_SETTING_MAX
+#define AMP_CACHE_SLOTS (RIG_SETTING_MAX + 1)
+
+#define AMP_CACHE_DEFAULT_POLL_MS 1000
+
+struct amp_cache_slot
+{
+    int valid;
+    value_t val;
+    struct timespec stamp;      /* when the value was read */
+    int timeout_ms;             /* -1 for the default timeout */
+    int poll_ms;                /* 0 not polled, -1 the default interval */
+    struct timespec due;        /* next poll */
+};
+
+struct amp_cache_priv
+{
+    int timeout_ms;
+    int poll_interval_ms;
+    hamlib_amp_cache_stats_t stats;
+    struct amp_cache_slot slot[AMP_CACHE_SLOTS];
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_t mutex;      /* the slots and counters */
+    pthread_mutex_t io;         /* the amplifier, between poller and callers */
+    pthread_cond_t wake;        /* the poll set changed or the thread must stop */
+    pthread_t thread_id;
+    station_source_t *source;   /* polled by the station loop instead */
+    int running;
+    int stop;
+#endif
+};
+
+
+static void amp_cache_mutex_lock(struct amp_cache_priv *priv)
+{
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+#endif
+}
+
+
+static void amp_cache_mutex_unlock(struct amp_cache_priv *priv)
+{
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+}
+
+
+static int slot_index(setting_t level)
+{
+    int i = rig_setting2idx(level);
+
+    /* exactly one level */
+    if (level == 0 || (level & (level - 1)) || i >= RIG_SETTING_MAX)
+    {
+        return -1;
+    }
+
+    return i;
+}
+
+
+static int slot_poll_ms(const struct amp_cache_priv *priv,
+                        const struct amp_cache_slot *slot)
+{
+    return slot->poll_ms < 0 ? priv->poll_interval_ms : slot->poll_ms;
+}
+
+
+/* how old a value of the slot may be when served, 0 not served */
+static int slot_max_age(const struct amp_cache_priv *priv,
+                        const struct amp_cache_slot *slot)
+{
+    int max_age = slot->timeout_ms < 0 ? priv->timeout_ms : slot->timeout_ms;
+    int poll_ms = slot_poll_ms(priv, slot);
+
+    /* a polled value is good until the poller has missed a round */
+    if (poll_ms > 0 && 2 * poll_ms > max_age)
+    {
+        max_age = 2 * poll_ms;
+    }
+
+    return max_age;
+}
+
+
+static double slot_age(struct amp_cache_slot *slot)
+{
+    return elapsed_ms(&slot->stamp, HAMLIB_ELAPSED_GET);
+}
+
+
+static void slot_store(struct amp_cache_slot *slot, const value_t *val)
+{
+    slot->val = *val;
+    slot->valid = 1;
+    elapsed_ms(&slot->stamp, HAMLIB_ELAPSED_SET);
+}
+
+
+/* the cached value if it is still fresh, counts the hit or miss */
+static int slot_lookup(struct amp_cache_priv *priv, int idx, value_t *val)
+{
+    struct amp_cache_slot *slot = &priv->slot[idx];
+    int max_age;
+    double age;
+
+    amp_cache_mutex_lock(priv);
+
+    max_age = slot_max_age(priv, slot);
+
+    if (slot->valid && max_age > 0 && (age = slot_age(slot)) < max_age)
+    {
+        *val = slot->val;
+        priv->stats.hits++;
+
+        if (age > priv->stats.max_age_ms)
+        {
+            priv->stats.max_age_ms = age;
+        }
+
+        amp_cache_mutex_unlock(priv);
+        return RIG_OK;
+    }
+
+    priv->stats.misses++;
+    amp_cache_mutex_unlock(priv);
+
+    return -RIG_ENAVAIL;
+}
+
+
+static int amp_cache_read(AMP *amp, int idx, value_t *val)
+{
+    int retval;
+
+    amp_cache_lock(amp);
+
+    if (idx == AMP_CACHE_POWERSTAT)
+    {
+        powerstat_t status = RIG_POWER_UNKNOWN;
+
+        retval = amp->caps->get_powerstat(amp, &status);
+        val->i = status;
+    }
+    else
+    {
+        retval = amp->caps->get_level(amp, rig_idx2setting(idx), val);
+    }
+
+    amp_cache_unlock(amp);
+
+    return retval;
+}
+
+
+#if defined(HAVE_PTHREAD)
+static void timespec_add_ms(struct timespec *ts, int ms)
+{
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000L;
+
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+
+static int timespec_before(const struct timespec *a, const struct timespec *b)
+{
+    return a->tv_sec < b->tv_sec
+           || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+
+static int amp_cache_polling(const struct amp_cache_priv *priv)
+{
+    int i;
+
+    for (i = 0; i < AMP_CACHE_SLOTS; i++)
+    {
+        if (slot_poll_ms(priv, &priv->slot[i]) > 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * Called with the mutex held: polls the slot due first if it is due
+ * within slack_ms.  Returns 1 when it polled, 0 with the due time of the
+ * next poll in *due, or -1 when no level is polled.
+ */
+static int amp_cache_poll_next(AMP *amp, int slack_ms, struct timespec *due)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    struct amp_cache_slot *next = NULL;
+    struct timespec now, ahead;
+    value_t val;
+    int poll_ms = 0;
+    int retval;
+    int i;
+
+    for (i = 0; i < AMP_CACHE_SLOTS; i++)
+    {
+        struct amp_cache_slot *slot = &priv->slot[i];
+
+        if (slot_poll_ms(priv, slot) > 0
+                && (!next || timespec_before(&slot->due, &next->due)))
+        {
+            next = slot;
+        }
+    }
+
+    if (!next)
+    {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    ahead = now;
+    timespec_add_ms(&ahead, slack_ms);
+
+    if (timespec_before(&ahead, &next->due))
+    {
+        *due = next->due;
+        return 0;
+    }
+
+    /* fixed rate, a round missed while the link was busy is skipped */
+    poll_ms = slot_poll_ms(priv, next);
+    timespec_add_ms(&next->due, poll_ms);
+
+    if (timespec_before(&next->due, &now))
+    {
+        next->due = now;
+        timespec_add_ms(&next->due, poll_ms);
+    }
+
+    pthread_mutex_unlock(&priv->mutex);
+    retval = amp_cache_read(amp, (int)(next - priv->slot), &val);
+    pthread_mutex_lock(&priv->mutex);
+
+    if (retval == RIG_OK)
+    {
+        slot_store(next, &val);
+        priv->stats.polls++;
+    }
+    else
+    {
+        priv->stats.poll_errors++;
+        amp_debug(RIG_DEBUG_WARN, "%s: poll of %s failed: %s\n", __func__,
+                  next - priv->slot == AMP_CACHE_POWERSTAT ? "POWERSTAT"
+                  : amp_strlevel(rig_idx2setting(next - priv->slot)),
+                  rigerror(retval));
+    }
+
+    return 1;
+}
+
+
+static void *amp_cache_thread(void *arg)
+{
+    AMP *amp = arg;
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+
+    pthread_mutex_lock(&priv->mutex);
+
+    while (!priv->stop)
+    {
+        struct timespec due;
+        int polled = amp_cache_poll_next(amp, 0, &due);
+
+        if (polled < 0)
+        {
+            pthread_cond_wait(&priv->wake, &priv->mutex);
+        }
+        else if (polled == 0)
+        {
+            pthread_cond_timedwait(&priv->wake, &priv->mutex, &due);
+        }
+    }
+
+    pthread_mutex_unlock(&priv->mutex);
+
+    return NULL;
+}
+
+
+/* the polls of an amplifier in a station run on the station loop */
+static int amp_cache_station(void *arg)
+{
+    AMP *amp = arg;
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    struct timespec due, now;
+    long long ns;
+    int polled;
+
+    pthread_mutex_lock(&priv->mutex);
+
+    do
+    {
+        polled = priv->stop ? -1 : amp_cache_poll_next(amp, STATION_SLACK_MS, &due);
+    }
+    while (polled > 0);
+
+    pthread_mutex_unlock(&priv->mutex);
+
+    if (polled < 0)
+    {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    ns = (due.tv_sec - now.tv_sec) * 1000000000LL + (due.tv_nsec - now.tv_nsec);
+
+    return ns > 0 ? (int)((ns + 999999) / 1000000) : 0;
+}
+#endif
+
+
+/*
+ * Called by amp_init(), the cache exists for the life of the handle.
+ */
+int amp_cache_init(AMP *amp)
+{
+    struct amp_cache_priv *priv;
+    int i;
+
+    priv = calloc(1, sizeof(*priv));
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    priv->poll_interval_ms = AMP_CACHE_DEFAULT_POLL_MS;
+
+    for (i = 0; i < AMP_CACHE_SLOTS; i++)
+    {
+        priv->slot[i].timeout_ms = -1;
+    }
+
+#if defined(HAVE_PTHREAD)
+    {
+        pthread_mutexattr_t attr;
+
+        /* a backend may call the frontend while holding the amplifier */
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&priv->io, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+    pthread_mutex_init(&priv->mutex, NULL);
+    pthread_cond_init(&priv->wake, NULL);
+#endif
+
+    amp->state.cache_priv = priv;
+
+    return RIG_OK;
+}
+
+
+/*
+ * Starts the poller when levels are to be polled and the amplifier is
+ * open, called by amp_open() and when the poll set changes.
+ */
+int amp_cache_start(AMP *amp)
+{
+#if defined(HAVE_PTHREAD)
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    struct timespec now;
+    int i;
+
+    if (!priv || !amp->state.comm_state)
+    {
+        return RIG_OK;
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+
+    if (priv->running || !amp_cache_polling(priv))
+    {
+        pthread_cond_signal(&priv->wake);
+        station_kick(amp->state.station, priv->source);
+        pthread_mutex_unlock(&priv->mutex);
+        return RIG_OK;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    for (i = 0; i < AMP_CACHE_SLOTS; i++)
+    {
+        priv->slot[i].due = now;
+    }
+
+    priv->stop = 0;
+    priv->source = station_add_io(amp->state.station, amp_cache_station, amp, 0);
+
+    if (!priv->source
+            && pthread_create(&priv->thread_id, NULL, amp_cache_thread, amp))
+    {
+        pthread_mutex_unlock(&priv->mutex);
+        amp_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                  strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    priv->running = 1;
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+
+    return RIG_OK;
+}
+
+
+/*
+ * Stops the poller, called by amp_close().  The cached values stay but
+ * are stale by the time the amplifier is opened again.
+ */
+void amp_cache_stop(AMP *amp)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+
+    if (!priv)
+    {
+        return;
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+
+    if (!priv->running)
+    {
+        pthread_mutex_unlock(&priv->mutex);
+        return;
+    }
+
+    priv->stop = 1;
+    pthread_cond_signal(&priv->wake);
+    pthread_mutex_unlock(&priv->mutex);
+
+    if (priv->source)
+    {
+        station_remove(amp->state.station, priv->source);
+        priv->source = NULL;
+    }
+    else
+    {
+        pthread_join(priv->thread_id, NULL);
+    }
+
+    priv->running = 0;
+#endif
+
+    amp_cache_invalidate(amp, 0);
+}
+
+
+void amp_cache_cleanup(AMP *amp)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    amp_cache_stop(amp);
+#if defined(HAVE_PTHREAD)
+    pthread_cond_destroy(&priv->wake);
+    pthread_mutex_destroy(&priv->mutex);
+    pthread_mutex_destroy(&priv->io);
+#endif
+    free(priv);
+    amp->state.cache_priv = NULL;
+}
+
+
+/*
+ * Serializes the commands of callers and poller on the amplifier port.
+ */
+void amp_cache_lock(AMP *amp)
+{
+#if defined(HAVE_PTHREAD)
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+
+    if (priv)
+    {
+        pthread_mutex_lock(&priv->io);
+    }
+
+#endif
+}
+
+
+void amp_cache_unlock(AMP *amp)
+{
+#if defined(HAVE_PTHREAD)
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+
+    if (priv)
+    {
+        pthread_mutex_unlock(&priv->io);
+    }
+
+#endif
+}
+
+
+/*
+ * Forgets the cached \a level, or everything if \a level is 0.  The power
+ * status goes with everything.
+ */
+void amp_cache_invalidate(AMP *amp, setting_t level)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    int i;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    amp_cache_mutex_lock(priv);
+
+    for (i = 0; i < AMP_CACHE_SLOTS; i++)
+    {
+        if (level == 0 || (i < RIG_SETTING_MAX && (level & rig_idx2setting(i))))
+        {
+            priv->slot[i].valid = 0;
+        }
+    }
+
+    amp_cache_mutex_unlock(priv);
+}
+
+
+/*
+ * amp_get_level() through the cache, the caller has checked the handle
+ * and the backend.
+ */
+int amp_cache_get_level(AMP *amp, setting_t level, value_t *val)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    int idx = slot_index(level);
+    int retval;
+
+    if (!priv || idx < 0)
+    {
+        amp_cache_lock(amp);
+        retval = amp->caps->get_level(amp, level, val);
+        amp_cache_unlock(amp);
+        return retval;
+    }
+
+    if (slot_lookup(priv, idx, val) == RIG_OK)
+    {
+        return RIG_OK;
+    }
+
+    retval = amp_cache_read(amp, idx, val);
+
+    if (retval == RIG_OK)
+    {
+        amp_cache_mutex_lock(priv);
+        slot_store(&priv->slot[idx], val);
+        amp_cache_mutex_unlock(priv);
+    }
+
+    return retval;
+}
+
+
+int amp_cache_get_powerstat(AMP *amp, powerstat_t *status)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    value_t val;
+    int retval;
+
+    if (!priv)
+    {
+        amp_cache_lock(amp);
+        retval = amp->caps->get_powerstat(amp, status);
+        amp_cache_unlock(amp);
+        return retval;
+    }
+
+    if (slot_lookup(priv, AMP_CACHE_POWERSTAT, &val) == RIG_OK)
+    {
+        *status = (powerstat_t) val.i;
+        return RIG_OK;
+    }
+
+    retval = amp_cache_read(amp, AMP_CACHE_POWERSTAT, &val);
+
+    if (retval == RIG_OK)
+    {
+        *status = (powerstat_t) val.i;
+        amp_cache_mutex_lock(priv);
+        slot_store(&priv->slot[AMP_CACHE_POWERSTAT], &val);
+        amp_cache_mutex_unlock(priv);
+    }
+
+    return retval;
+}
+
+
+/* "SWR:500/PWRFORWARD/POWERSTAT:2000", an entry without :MS uses poll_interval */
+static int amp_cache_parse_poll(AMP *amp, const char *val)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    int poll_ms[AMP_CACHE_SLOTS];
+    char buf[256];
+    char *entry, *saveptr = NULL;
+    int i;
+
+    for (i = 0; i < AMP_CACHE_SLOTS; i++)
+    {
+        poll_ms[i] = 0;
+    }
+
+    SNPRINTF(buf, sizeof(buf), "%s", val);
+
+    for (entry = strtok_r(buf, "/", &saveptr); entry;
+            entry = strtok_r(NULL, "/", &saveptr))
+    {
+        char *ms = strchr(entry, ':');
+        int idx;
+
+        if (ms)
+        {
+            *ms++ = '\0';
+        }
+
+        if (strcmp(entry, "POWERSTAT") == 0)
+        {
+            idx = AMP_CACHE_POWERSTAT;
+        }
+        else if ((idx = slot_index(amp_parse_level(entry))) < 0)
+        {
+            amp_debug(RIG_DEBUG_ERR, "%s: unknown level '%s'\n", __func__, entry);
+            return -RIG_EINVAL;
+        }
+
+        poll_ms[idx] = ms ? atoi(ms) : -1;
+
+        if (ms && poll_ms[idx] <= 0)
+        {
+            amp_debug(RIG_DEBUG_ERR, "%s: bad interval '%s'\n", __func__, ms);
+            return -RIG_EINVAL;
+        }
+    }
+
+    amp_cache_mutex_lock(priv);
+
+    for (i = 0; i < AMP_CACHE_SLOTS; i++)
+    {
+        priv->slot[i].poll_ms = poll_ms[i];
+    }
+
+    amp_cache_mutex_unlock(priv);
+
+    return amp_cache_start(amp);
+}
+
+
+int amp_cache_set_conf(AMP *amp, hamlib_token_t token, const char *val)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    int ms;
+
+    if (!priv)
+    {
+        return -RIG_EINTERNAL;
+    }
+
+    switch (token)
+    {
+    case TOK_AMP_CACHE_TIMEOUT:
+    case TOK_AMP_POLL_INTERVAL:
+        ms = atoi(val);
+
+        if (ms < 0 || (token == TOK_AMP_POLL_INTERVAL && ms == 0))
+        {
+            return -RIG_EINVAL;
+        }
+
+        amp_cache_mutex_lock(priv);
+
+        if (token == TOK_AMP_CACHE_TIMEOUT)
+        {
+            priv->timeout_ms = ms;
+        }
+        else
+        {
+            priv->poll_interval_ms = ms;
+        }
+
+        amp_cache_mutex_unlock(priv);
+        return amp_cache_start(amp);
+
+    case TOK_AMP_POLL_LEVELS:
+        return amp_cache_parse_poll(amp, val);
+    }
+
+    return -RIG_EINVAL;
+}
+
+
+int amp_cache_get_conf(AMP *amp, hamlib_token_t token, char *val, int val_len)
+{
+    struct amp_cache_priv *priv = amp->state.cache_priv;
+    int len = 0;
+    int i;
+
+    if (!priv)
+    {
+        return -RIG_EINTERNAL;
+    }
+
+    amp_cache_mutex_lock(priv);
+
+    switch (token)
+    {
+    case TOK_AMP_CACHE_TIMEOUT:
+        SNPRINTF(val, val_len, "%d", priv->timeout_ms);
+        break;
+
+    case TOK_AMP_POLL_INTERVAL:
+        SNPRINTF(val, val_len, "%d", priv->poll_interval_ms);
+        break;
+
+    case TOK_AMP_POLL_LEVELS:
+        val[0] = '\0';
+
+        for (i = 0; i < AMP_CACHE_SLOTS && len < val_len; i++)
+        {
+            const struct amp_cache_slot *slot = &priv->slot[i];
+
+            if (slot->poll_ms == 0)
+            {
+                continue;
+            }
+
+            len += snprintf(val + len, val_len - len, "%s%s",
+                            len ? "/" : "", i == AMP_CACHE_POWERSTAT ? "POWERSTAT"
+                            : amp_strlevel(rig_idx2setting(i)));
+
+            if (slot->poll_ms > 0 && len < val_len)
+            {
+                len += snprintf(val + len, val_len - len, ":%d", slot->poll_ms);
+            }
+        }
+
+        break;
+
+    default:
+        amp_cache_mutex_unlock(priv);
+        return -RIG_EINVAL;
+    }
+
+    amp_cache_mutex_unlock(priv);
+
+    return RIG_OK;
+}
+//! @endcond
+
+
+/**
+ * \brief Set how long read levels are served from the cache
+ *
+ * \param amp The #AMP handle.
+ * \param level The levels, or AMP_LEVEL_NONE for the default of all levels
+ * and of the power status.
+ * \param ms The cache timeout in ms, 0 to always read the amplifier, or -1
+ * to have \a level use the default again.
+ *
+ * Levels polled with amp_set_poll() are served from the cache for two poll
+ * intervals whatever their timeout.  The cache_timeout configuration token
+ * sets the default.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a amp is NULL or \a ms out of range.
+ *
+ * \sa amp_set_poll(), amp_get_level_cached()
+ */
+int HAMLIB_API amp_set_cache_timeout(AMP *amp, setting_t level, int ms)
+{
+    struct amp_cache_priv *priv;
+    int i;
+
+    if (!amp || !amp->state.cache_priv || ms < -1
+            || (level == AMP_LEVEL_NONE && ms < 0))
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = amp->state.cache_priv;
+    amp_cache_mutex_lock(priv);
+
+    if (level == AMP_LEVEL_NONE)
+    {
+        priv->timeout_ms = ms;
+    }
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        if (level & rig_idx2setting(i))
+        {
+            priv->slot[i].timeout_ms = ms;
+        }
+    }
+
+    amp_cache_mutex_unlock(priv);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Poll levels in the background
+ *
+ * \param amp The #AMP handle.
+ * \param level The levels to poll.
+ * \param interval_ms How often to read them in ms, 0 to stop polling them.
+ *
+ * A thread reads each polled level at its interval while the amplifier is
+ * open, and amp_get_level() serves the polled levels from the cache.
+ * When the link cannot keep up the poller skips rounds instead of falling
+ * behind.  The poll_levels configuration token does the same.
+ *
+ * \return RIG_OK, or a negative value if \a amp is NULL, \a interval_ms is
+ * negative or the thread could not be started.
+ *
+ * \sa amp_set_powerstat_poll(), amp_get_cache_stats()
+ */
+int HAMLIB_API amp_set_poll(AMP *amp, setting_t level, int interval_ms)
+{
+    struct amp_cache_priv *priv;
+    int i;
+
+    if (!amp || !amp->state.cache_priv || interval_ms < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = amp->state.cache_priv;
+    amp_cache_mutex_lock(priv);
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        if (level & rig_idx2setting(i))
+        {
+            priv->slot[i].poll_ms = interval_ms;
+        }
+    }
+
+    amp_cache_mutex_unlock(priv);
+
+    return amp_cache_start(amp);
+}
+
+
+/**
+ * \brief Poll the power status in the background
+ *
+ * \param amp The #AMP handle.
+ * \param interval_ms How often to read it in ms, 0 to stop polling it.
+ *
+ * As amp_set_poll() for amp_get_powerstat().
+ *
+ * \return RIG_OK, or a negative value on error.
+ *
+ * \sa amp_set_poll()
+ */
+int HAMLIB_API amp_set_powerstat_poll(AMP *amp, int interval_ms)
+{
+    struct amp_cache_priv *priv;
+
+    if (!amp || !amp->state.cache_priv || interval_ms < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = amp->state.cache_priv;
+    amp_cache_mutex_lock(priv);
+    priv->slot[AMP_CACHE_POWERSTAT].poll_ms = interval_ms;
+    amp_cache_mutex_unlock(priv);
+
+    return amp_cache_start(amp);
+}
+
+
+/**
+ * \brief Query a level from the cache with its age
+ *
+ * \param amp The #AMP handle.
+ * \param level The requested level.
+ * \param val The variable to store the \a level value.
+ * \param age_ms Set to how long ago the value was read from the amplifier.
+ *
+ * Returns the last value read whatever its age, so that a client can show
+ * how stale it is.  The amplifier is only read when the level has not been
+ * read since it was opened, the age is 0 then.
+ *
+ * \return RIG_OK if the operation was successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \sa amp_get_level()
+ */
+int HAMLIB_API amp_get_level_cached(AMP *amp, setting_t level, value_t *val,
+                                    double *age_ms)
+{
+    struct amp_cache_priv *priv;
+    int idx = slot_index(level);
+
+    if (!amp || !amp->caps || !amp->state.comm_state || !val || !age_ms)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = amp->state.cache_priv;
+
+    if (priv && idx >= 0)
+    {
+        amp_cache_mutex_lock(priv);
+
+        if (priv->slot[idx].valid)
+        {
+            *val = priv->slot[idx].val;
+            *age_ms = slot_age(&priv->slot[idx]);
+            priv->stats.hits++;
+            amp_cache_mutex_unlock(priv);
+            return RIG_OK;
+        }
+
+        amp_cache_mutex_unlock(priv);
+    }
+
+    *age_ms = 0;
+
+    return amp_get_level(amp, level, val);
+}
+
+
+/**
+ * \brief Query the power status from the cache with its age
+ *
+ * \param amp The #AMP handle.
+ * \param status The variable to store the amplifier \a status.
+ * \param age_ms Set to how long ago the status was read from the amplifier.
+ *
+ * As amp_get_level_cached() for amp_get_powerstat().
+ *
+ * \return RIG_OK if the operation was successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \sa amp_get_powerstat()
+ */
+int HAMLIB_API amp_get_powerstat_cached(AMP *amp, powerstat_t *status,
+                                        double *age_ms)
+{
+    struct amp_cache_priv *priv;
+
+    if (!amp || !amp->caps || !amp->state.comm_state || !status || !age_ms)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = amp->state.cache_priv;
+
+    if (priv)
+    {
+        struct amp_cache_slot *slot = &priv->slot[AMP_CACHE_POWERSTAT];
+
+        amp_cache_mutex_lock(priv);
+
+        if (slot->valid)
+        {
+            *status = (powerstat_t) slot->val.i;
+            *age_ms = slot_age(slot);
+            priv->stats.hits++;
+            amp_cache_mutex_unlock(priv);
+            return RIG_OK;
+        }
+
+        amp_cache_mutex_unlock(priv);
+    }
+
+    *age_ms = 0;
+
+    return amp_get_powerstat(amp, status);
+}
+
+
+/**
+ * \brief Get the level cache counters
+ *
+ * \param amp The #AMP handle.
+ * \param stats Set to the counters.
+ *
+ * The counters cover the life of the #AMP handle, across amp_close().
+ *
+ * \return RIG_OK, or -RIG_EINVAL if an argument is NULL.
+ */
+int HAMLIB_API amp_get_cache_stats(AMP *amp, hamlib_amp_cache_stats_t *stats)
+{
+    struct amp_cache_priv *priv;
+
+    if (!amp || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = amp->state.cache_priv;
+
+    if (!priv)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return RIG_OK;
+    }
+
+    amp_cache_mutex_lock(priv);
+    *stats = priv->stats;
+    amp_cache_mutex_unlock(priv);
+
+    return RIG_OK;
+}
+
+/** @} */
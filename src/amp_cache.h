@@ -0,0 +1,41 @@
+/*
+ *  Hamlib Interface - amplifier level cache header
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _AMP_CACHE_H
+#define _AMP_CACHE_H 1
+
+#include <hamlib/amplifier.h>
+
+int amp_cache_init(AMP *amp);
+int amp_cache_start(AMP *amp);
+void amp_cache_stop(AMP *amp);
+void amp_cache_cleanup(AMP *amp);
+
+void amp_cache_lock(AMP *amp);
+void amp_cache_unlock(AMP *amp);
+void amp_cache_invalidate(AMP *amp, setting_t level);
+
+int amp_cache_get_level(AMP *amp, setting_t level, value_t *val);
+int amp_cache_get_powerstat(AMP *amp, powerstat_t *status);
+
+int amp_cache_set_conf(AMP *amp, hamlib_token_t token, const char *val);
+int amp_cache_get_conf(AMP *amp, hamlib_token_t token, char *val, int val_len);
+
+#endif
@@ -40,6 +40,7 @@
 #include <hamlib/amplifier.h>
 
 #include "amp_conf.h"
+#include "amp_cache.h"
 #include "token.h"
 
 
@@ -71,6 +72,21 @@ static const struct confparams ampfrontend_cfg_params[] =
         TOK_RETRY, "retry", "Retry", "Max number of retry",
         "0", RIG_CONF_NUMERIC, { .n = { 0, 10, 1 } }
     },
+    {
+        TOK_AMP_CACHE_TIMEOUT, "cache_timeout", "Cache timeout",
+        "Serve levels read less than this many ms ago from the cache, 0 to always read the amplifier",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 60000, 1 } }
+    },
+    {
+        TOK_AMP_POLL_LEVELS, "poll_levels", "Poll levels",
+        "Levels to read in the background and serve from the cache, LEVEL[:MS]/... e.g. SWR:500/PWRFORWARD/POWERSTAT:2000",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_AMP_POLL_INTERVAL, "poll_interval", "Poll interval",
+        "Poll interval in ms of the poll_levels without their own",
+        "1000", RIG_CONF_NUMERIC, { .n = { 1, 60000, 1 } }
+    },
 
     { RIG_CONF_END, NULL, }
 };
@@ -326,6 +342,11 @@ int frontamp_set_conf(AMP *amp, hamlib_token_t token, const char *val)
 
 
 
+    case TOK_AMP_CACHE_TIMEOUT:
+    case TOK_AMP_POLL_LEVELS:
+    case TOK_AMP_POLL_INTERVAL:
+        return amp_cache_set_conf(amp, token, val);
+
 #if 0
 
     case TOK_MIN_AZ:
@@ -398,6 +419,11 @@ int frontamp_get_conf2(AMP *amp, hamlib_token_t token, char *val, int val_len)
         SNPRINTF(val, val_len, "%d", ampp->retry);
         break;
 
+    case TOK_AMP_CACHE_TIMEOUT:
+    case TOK_AMP_POLL_LEVELS:
+    case TOK_AMP_POLL_INTERVAL:
+        return amp_cache_get_conf(amp, token, val, val_len);
+
     case TOK_SERIAL_SPEED:
         if (ampp->type.rig != RIG_PORT_SERIAL)
         {
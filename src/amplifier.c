@@ -63,6 +63,8 @@
 #include "usb_port.h"
 #include "network.h"
 #include "token.h"
+#include "amp_cache.h"
+#include "station.h"
 
 //! @cond Doxygen_Suppress
 #define CHECK_AMP_ARG(r) (!(r) || !(r)->caps || !AMPSTATE(r)->comm_state)
@@ -262,6 +264,12 @@ AMP *HAMLIB_API amp_init(amp_model_t amp_model)
 
     ap->fd = -1;
 
+    if (amp_cache_init(amp) != RIG_OK)
+    {
+        free(amp);
+        return NULL;
+    }
+
     /*
      * let the backend a chance to setup his private data
      * This must be done only once defaults are setup,
@@ -277,6 +285,7 @@ AMP *HAMLIB_API amp_init(amp_model_t amp_model)
                       "%s: backend_init failed!\n",
                       __func__);
             /* cleanup and exit */
+            amp_cache_cleanup(amp);
             free(amp);
             return NULL;
         }
@@ -446,6 +455,9 @@ int HAMLIB_API amp_open(AMP *amp)
     memcpy(&rs->ampport_deprecated, ap,
            sizeof(rs->ampport_deprecated));
 
+    /* start polling the levels asked for before the open */
+    amp_cache_start(amp);
+
     return RIG_OK;
 }
 
@@ -497,6 +509,8 @@ int HAMLIB_API amp_close(AMP *amp)
         return -RIG_EINVAL;
     }
 
+    amp_cache_stop(amp);
+
     /*
      * Let the backend say 73s to the amp.
      * and ignore the return code.
@@ -584,6 +598,8 @@ int HAMLIB_API amp_cleanup(AMP *amp)
         amp->caps->amp_cleanup(amp);
     }
 
+    amp_cache_cleanup(amp);
+    station_leave(amp->state.station, amp);
     free(amp);
 
     return RIG_OK;
@@ -608,6 +624,7 @@ int HAMLIB_API amp_cleanup(AMP *amp)
 int HAMLIB_API amp_reset(AMP *amp, amp_reset_t reset)
 {
     const struct amp_caps *caps;
+    int retval;
 
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -623,7 +640,12 @@ int HAMLIB_API amp_reset(AMP *amp, amp_reset_t reset)
         return -RIG_ENAVAIL;
     }
 
-    return caps->reset(amp, reset);
+    amp_cache_lock(amp);
+    retval = caps->reset(amp, reset);
+    amp_cache_invalidate(amp, 0);
+    amp_cache_unlock(amp);
+
+    return retval;
 }
 
 
@@ -647,6 +669,7 @@ int HAMLIB_API amp_reset(AMP *amp, amp_reset_t reset)
 int HAMLIB_API amp_get_freq(AMP *amp, freq_t *freq)
 {
     const struct amp_caps *caps;
+    int retval;
 
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -662,7 +685,11 @@ int HAMLIB_API amp_get_freq(AMP *amp, freq_t *freq)
         return -RIG_ENAVAIL;
     }
 
-    return caps->get_freq(amp, freq);
+    amp_cache_lock(amp);
+    retval = caps->get_freq(amp, freq);
+    amp_cache_unlock(amp);
+
+    return retval;
 }
 
 
@@ -687,6 +714,7 @@ int HAMLIB_API amp_get_freq(AMP *amp, freq_t *freq)
 int HAMLIB_API amp_set_freq(AMP *amp, freq_t freq)
 {
     const struct amp_caps *caps;
+    int retval;
 
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -702,7 +730,13 @@ int HAMLIB_API amp_set_freq(AMP *amp, freq_t freq)
         return -RIG_ENAVAIL;
     }
 
-    return caps->set_freq(amp, freq);
+    /* SWR and power change with the band */
+    amp_cache_lock(amp);
+    retval = caps->set_freq(amp, freq);
+    amp_cache_invalidate(amp, 0);
+    amp_cache_unlock(amp);
+
+    return retval;
 }
 
 
@@ -721,6 +755,8 @@ int HAMLIB_API amp_set_freq(AMP *amp, freq_t freq)
  */
 const char *HAMLIB_API amp_get_info(AMP *amp)
 {
+    const char *info;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -733,7 +769,11 @@ const char *HAMLIB_API amp_get_info(AMP *amp)
         return NULL;
     }
 
-    return amp->caps->get_info(amp);
+    amp_cache_lock(amp);
+    info = amp->caps->get_info(amp);
+    amp_cache_unlock(amp);
+
+    return info;
 }
 
 
@@ -759,6 +799,8 @@ const char *HAMLIB_API amp_get_info(AMP *amp)
  */
 int HAMLIB_API amp_set_level(AMP *amp, setting_t level, value_t val)
 {
+    int retval;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -771,7 +813,12 @@ int HAMLIB_API amp_set_level(AMP *amp, setting_t level, value_t val)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->set_level(amp, level, val);
+    amp_cache_lock(amp);
+    retval = amp->caps->set_level(amp, level, val);
+    amp_cache_invalidate(amp, level);
+    amp_cache_unlock(amp);
+
+    return retval;
 }
 
 /**
@@ -781,7 +828,9 @@ int HAMLIB_API amp_set_level(AMP *amp, setting_t level, value_t val)
  * \param level The requested level.
  * \param val The variable to store the \a level value.
  *
- * Query the \a val corresponding to the \a level.
+ * Query the \a val corresponding to the \a level.  A value read within
+ * the cache timeout of the level, or a polled level, is served from the
+ * cache without reading the amplifier.
  *
  * \note \a val can be any type defined by #value_t.
  *
@@ -792,7 +841,7 @@ int HAMLIB_API amp_set_level(AMP *amp, setting_t level, value_t val)
  * \retval RIG_EINVAL \a amp is NULL or inconsistent.
  * \retval RIG_ENAVAIL amp_caps#get_level() capability is not available.
  *
- * \sa amp_get_ext_level()
+ * \sa amp_get_ext_level(), amp_set_cache_timeout(), amp_get_level_cached()
  */
 int HAMLIB_API amp_get_level(AMP *amp, setting_t level, value_t *val)
 {
@@ -808,7 +857,7 @@ int HAMLIB_API amp_get_level(AMP *amp, setting_t level, value_t *val)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->get_level(amp, level, val);
+    return amp_cache_get_level(amp, level, val);
 }
 
 
@@ -832,6 +881,8 @@ int HAMLIB_API amp_get_level(AMP *amp, setting_t level, value_t *val)
  */
 int HAMLIB_API amp_set_ext_level(AMP *amp, hamlib_token_t level, value_t val)
 {
+    int retval;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -844,7 +895,11 @@ int HAMLIB_API amp_set_ext_level(AMP *amp, hamlib_token_t level, value_t val)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->set_ext_level(amp, level, val);
+    amp_cache_lock(amp);
+    retval = amp->caps->set_ext_level(amp, level, val);
+    amp_cache_unlock(amp);
+
+    return retval;
 }
 
 /**
@@ -867,6 +922,8 @@ int HAMLIB_API amp_set_ext_level(AMP *amp, hamlib_token_t level, value_t val)
  */
 int HAMLIB_API amp_get_ext_level(AMP *amp, hamlib_token_t level, value_t *val)
 {
+    int retval;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -879,7 +936,11 @@ int HAMLIB_API amp_get_ext_level(AMP *amp, hamlib_token_t level, value_t *val)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->get_ext_level(amp, level, val);
+    amp_cache_lock(amp);
+    retval = amp->caps->get_ext_level(amp, level, val);
+    amp_cache_unlock(amp);
+
+    return retval;
 }
 
 
@@ -905,6 +966,8 @@ int HAMLIB_API amp_get_ext_level(AMP *amp, hamlib_token_t level, value_t *val)
  */
 int HAMLIB_API amp_set_powerstat(AMP *amp, powerstat_t status)
 {
+    int retval;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -917,7 +980,12 @@ int HAMLIB_API amp_set_powerstat(AMP *amp, powerstat_t status)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->set_powerstat(amp, status);
+    amp_cache_lock(amp);
+    retval = amp->caps->set_powerstat(amp, status);
+    amp_cache_invalidate(amp, 0);
+    amp_cache_unlock(amp);
+
+    return retval;
 }
 
 
@@ -954,7 +1022,7 @@ int HAMLIB_API amp_get_powerstat(AMP *amp, powerstat_t *status)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->get_powerstat(amp, status);
+    return amp_cache_get_powerstat(amp, status);
 }
 
 /**
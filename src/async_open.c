@@ -0,0 +1,532 @@
+/*
+ *  Hamlib Interface - asynchronous rig_open() and rig_close()
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file async_open.c
+ * \brief Asynchronous rig_open() and rig_close()
+ *
+ * Opening a rig opens its port and lines, probes the power status, lets
+ * the backend wake the rig up and reads back VFO, frequency, mode and
+ * split, which over a slow link or with a rig that needs its own delays
+ * takes seconds.  Closing has the backend restore the rig's transceive
+ * state first.  rig_open_async() and rig_close_async() run them on a
+ * thread of the rig, report each step to a callback and let an open be
+ * cancelled between steps, so that a GUI never waits on them.  While one
+ * runs the other threads get the cached state of the rig.
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "async_open.h"
+
+//! @cond Doxygen_Suppress
+struct async_open_priv
+{
+    rig_open_progress_cb_t cb;
+    rig_ptr_t cb_arg;
+    int busy;                   /* an open or close is running */
+    int closing;                /* and it is a close */
+    int cancel;
+    int result;                 /* of the last open or close */
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_t mutex;
+    pthread_cond_t done;        /* busy was cleared */
+    pthread_t thread_id;
+    int running;                /* thread_id is still to be joined */
+#endif
+};
+
+#if defined(HAVE_PTHREAD)
+static pthread_mutex_t async_open_create_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define ASYNC_OPEN_LOCK(priv) pthread_mutex_lock(&(priv)->mutex)
+#define ASYNC_OPEN_UNLOCK(priv) pthread_mutex_unlock(&(priv)->mutex)
+#else
+#define ASYNC_OPEN_LOCK(priv)
+#define ASYNC_OPEN_UNLOCK(priv)
+#endif
+
+
+static struct async_open_priv *async_open_priv(RIG *rig)
+{
+    struct async_open_priv *priv;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&async_open_create_mutex);
+#endif
+
+    priv = rig->state.async_open_priv_data;
+
+    if (!priv)
+    {
+        priv = calloc(1, sizeof(*priv));
+
+        if (priv)
+        {
+#if defined(HAVE_PTHREAD)
+            pthread_mutex_init(&priv->mutex, NULL);
+            pthread_cond_init(&priv->done, NULL);
+#endif
+            rig->state.async_open_priv_data = priv;
+        }
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&async_open_create_mutex);
+#endif
+
+    return priv;
+}
+
+
+/* true on the thread running the open or close, call with the lock held */
+static int async_open_is_worker(const struct async_open_priv *priv)
+{
+#if defined(HAVE_PTHREAD)
+    return priv->busy && priv->running
+           && pthread_equal(pthread_self(), priv->thread_id);
+#else
+    return priv->busy;
+#endif
+}
+
+
+static void async_open_done(RIG *rig, struct async_open_priv *priv,
+                            int retval)
+{
+    rig_open_progress_cb_t cb;
+    rig_ptr_t cb_arg;
+
+    ASYNC_OPEN_LOCK(priv);
+    cb = priv->cb;
+    cb_arg = priv->cb_arg;
+    ASYNC_OPEN_UNLOCK(priv);
+
+    if (cb)
+    {
+        cb(rig, RIG_OPEN_STEP_DONE, retval, cb_arg);
+    }
+
+    ASYNC_OPEN_LOCK(priv);
+    priv->result = retval;
+    priv->busy = 0;
+#if defined(HAVE_PTHREAD)
+    pthread_cond_broadcast(&priv->done);
+#endif
+    ASYNC_OPEN_UNLOCK(priv);
+}
+
+
+#if defined(HAVE_PTHREAD)
+static void *async_open_thread(void *arg)
+{
+    RIG *rig = (RIG *)arg;
+    struct async_open_priv *priv = rig->state.async_open_priv_data;
+    int retval;
+
+    retval = priv->closing ? rig_close(rig) : rig_open(rig);
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: async %s failed: %s\n", __func__,
+                  priv->closing ? "close" : "open", rigerror(retval));
+    }
+
+    async_open_done(rig, priv, retval);
+
+    return NULL;
+}
+#endif
+
+
+static int async_open_start(RIG *rig, int closing, rig_open_progress_cb_t cb,
+                            rig_ptr_t arg)
+{
+    struct async_open_priv *priv;
+    int open;
+
+    if (!rig || !rig->caps)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = async_open_priv(rig);
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    ASYNC_OPEN_LOCK(priv);
+    open = rig->state.comm_state != 0;
+
+    if (priv->busy || open != closing)
+    {
+        ASYNC_OPEN_UNLOCK(priv);
+        rig_debug(RIG_DEBUG_ERR, "%s: rig is %s\n", __func__,
+                  priv->busy ? "busy opening or closing"
+                  : closing ? "not open" : "already open");
+        return -RIG_EINVAL;
+    }
+
+#if defined(HAVE_PTHREAD)
+
+    /* the last open or close has ended, only its thread is left */
+    if (priv->running)
+    {
+        pthread_join(priv->thread_id, NULL);
+        priv->running = 0;
+    }
+
+#endif
+
+    priv->cb = cb;
+    priv->cb_arg = arg;
+    priv->closing = closing;
+    priv->cancel = 0;
+    priv->result = RIG_OK;
+    priv->busy = 1;
+
+#if defined(HAVE_PTHREAD)
+
+    if (pthread_create(&priv->thread_id, NULL, async_open_thread, rig))
+    {
+        priv->busy = 0;
+        ASYNC_OPEN_UNLOCK(priv);
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                  strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    priv->running = 1;
+    ASYNC_OPEN_UNLOCK(priv);
+
+    return RIG_OK;
+#else
+    {
+        /* no threads, open or close right away */
+        int retval = closing ? rig_close(rig) : rig_open(rig);
+
+        async_open_done(rig, priv, retval);
+
+        return retval;
+    }
+#endif
+}
+
+
+/*
+ * Called by rig_open() and rig_close() as they start each step.  On the
+ * thread of an asynchronous open or close it reports the step, and once
+ * the open has been cancelled it returns -RIG_ECANCELED instead, for
+ * rig_open() to undo what it has done so far.
+ */
+int rig_open_step(RIG *rig, rig_open_step_t step)
+{
+    struct async_open_priv *priv = rig->state.async_open_priv_data;
+    rig_open_progress_cb_t cb;
+    rig_ptr_t cb_arg;
+    int cancelled;
+
+    if (!priv)
+    {
+        return RIG_OK;
+    }
+
+    ASYNC_OPEN_LOCK(priv);
+
+    if (!async_open_is_worker(priv))
+    {
+        ASYNC_OPEN_UNLOCK(priv);
+        return RIG_OK;
+    }
+
+    /* closing, even when it undoes a cancelled open, runs to its end */
+    cancelled = priv->cancel && !priv->closing && step <= RIG_OPEN_STEP_STATE;
+    cb = priv->cb;
+    cb_arg = priv->cb_arg;
+    ASYNC_OPEN_UNLOCK(priv);
+
+    if (cancelled)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: open cancelled before step %d\n",
+                  __func__, step);
+        return -RIG_ECANCELED;
+    }
+
+    if (cb)
+    {
+        cb(rig, step, RIG_OK, cb_arg);
+    }
+
+    return RIG_OK;
+}
+
+
+/*
+ * True while an asynchronous open or close runs and the caller is not
+ * its thread, for the get functions to answer from the cache.
+ */
+int rig_async_open_busy(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    struct async_open_priv *priv = rig->state.async_open_priv_data;
+    int busy;
+
+    if (!priv)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+    busy = priv->busy && !async_open_is_worker(priv);
+    pthread_mutex_unlock(&priv->mutex);
+
+    return busy;
+#else
+    return 0;
+#endif
+}
+
+
+/*
+ * Cancels an open still running and waits for the thread, called by
+ * rig_close() and rig_cleanup().
+ */
+void rig_async_open_stop(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    struct async_open_priv *priv = rig->state.async_open_priv_data;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+
+    if (!priv->running || pthread_equal(pthread_self(), priv->thread_id))
+    {
+        pthread_mutex_unlock(&priv->mutex);
+        return;
+    }
+
+    priv->cancel = 1;
+    pthread_mutex_unlock(&priv->mutex);
+
+    pthread_join(priv->thread_id, NULL);
+    pthread_mutex_lock(&priv->mutex);
+    priv->running = 0;
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+}
+
+
+void rig_async_open_cleanup(RIG *rig)
+{
+    struct async_open_priv *priv = rig->state.async_open_priv_data;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    rig_async_open_stop(rig);
+#if defined(HAVE_PTHREAD)
+    pthread_cond_destroy(&priv->done);
+    pthread_mutex_destroy(&priv->mutex);
+#endif
+    free(priv);
+    rig->state.async_open_priv_data = NULL;
+}
+//! @endcond
+
+
+/**
+ * \brief Open the rig without waiting for it
+ * \param rig   The rig handle
+ * \param cb    Called as each step starts and when the open ends, NULL for none
+ * \param arg   Passed to \a cb
+ *
+ * Runs rig_open() on a thread of the rig and returns.  \a cb is called
+ * from that thread as each step of the open starts, with RIG_OK, and
+ * with RIG_OPEN_STEP_DONE and the return code of rig_open() at the end.
+ * rig_open_wait() waits for the end, and rig_open_cancel() stops the
+ * open before its next step.
+ *
+ * While the open runs, rig_get_freq(), rig_get_mode(), rig_get_vfo(),
+ * rig_get_ptt() and rig_get_split_vfo() called from other threads return
+ * what the cache holds, which is what the open has read so far, without
+ * waiting for the rig.  Other calls must wait for the end of the open.
+ *
+ * Without thread support the rig is opened before the function returns.
+ *
+ * \return RIG_OK if the open was started, otherwise a negative value,
+ * -RIG_EINVAL when the rig is open or an open or close is running.
+ *
+ * \sa rig_close_async(), rig_open()
+ */
+int HAMLIB_API rig_open_async(RIG *rig, rig_open_progress_cb_t cb,
+                              rig_ptr_t arg)
+{
+    return async_open_start(rig, 0, cb, arg);
+}
+
+
+/**
+ * \brief Close the rig without waiting for it
+ * \param rig   The rig handle
+ * \param cb    Called as each step starts and when the close ends, NULL for none
+ * \param arg   Passed to \a cb
+ *
+ * Runs rig_close() on a thread of the rig as rig_open_async() runs
+ * rig_open().  A close cannot be cancelled.
+ *
+ * \return RIG_OK if the close was started, otherwise a negative value,
+ * -RIG_EINVAL when the rig is not open or an open or close is running.
+ *
+ * \sa rig_open_async(), rig_close()
+ */
+int HAMLIB_API rig_close_async(RIG *rig, rig_open_progress_cb_t cb,
+                               rig_ptr_t arg)
+{
+    return async_open_start(rig, 1, cb, arg);
+}
+
+
+/**
+ * \brief Wait for an asynchronous open or close to end
+ * \param rig   The rig handle
+ * \param timeout_ms    Longest wait in ms, 0 to only check
+ *
+ * \return The return code of the last rig_open_async() or
+ * rig_close_async(), RIG_OK if none was started, or -RIG_ETIMEOUT if it
+ * was still running after \a timeout_ms.
+ */
+int HAMLIB_API rig_open_wait(RIG *rig, int timeout_ms)
+{
+    struct async_open_priv *priv;
+    int retval;
+
+    if (!rig || !rig->caps)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = rig->state.async_open_priv_data;
+
+    if (!priv)
+    {
+        return RIG_OK;
+    }
+
+#if defined(HAVE_PTHREAD)
+    {
+        struct timespec deadline;
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&priv->mutex);
+
+        while (priv->busy)
+        {
+            if (pthread_cond_timedwait(&priv->done, &priv->mutex, &deadline)
+                    == ETIMEDOUT)
+            {
+                break;
+            }
+        }
+
+        retval = priv->busy ? -RIG_ETIMEOUT : priv->result;
+        pthread_mutex_unlock(&priv->mutex);
+    }
+#else
+    retval = priv->result;
+#endif
+
+    return retval;
+}
+
+
+/**
+ * \brief Cancel an asynchronous open
+ * \param rig   The rig handle
+ *
+ * The open stops before its next step, closes what it has opened and
+ * ends with -RIG_ECANCELED.  A step already started, e.g. the backend
+ * waking up the rig, is not interrupted.  Nothing is done when no open
+ * is running.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a rig is NULL
+ *
+ * \sa rig_open_async()
+ */
+int HAMLIB_API rig_open_cancel(RIG *rig)
+{
+    struct async_open_priv *priv;
+
+    if (!rig || !rig->caps)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = rig->state.async_open_priv_data;
+
+    if (!priv)
+    {
+        return RIG_OK;
+    }
+
+    ASYNC_OPEN_LOCK(priv);
+
+    if (priv->busy && !priv->closing)
+    {
+        priv->cancel = 1;
+    }
+
+    ASYNC_OPEN_UNLOCK(priv);
+
+    return RIG_OK;
+}
+
+/** @} */
@@ -0,0 +1,575 @@
+/*
+ *  Hamlib Interface - coalescing asynchronous set commands
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file async_set.c
+ * \brief Coalescing asynchronous set commands
+ *
+ * Doppler tracking and rig to SDR sync set the frequency far more often
+ * than a CAT link can execute the commands.  An asynchronous set only
+ * stores the value in the slot of its command and VFO, replacing a value
+ * still waiting there, and a thread per rig sends the newest value of
+ * each slot in turn.  The rig then follows as fast as the link allows
+ * instead of falling further behind a queue of stale commands.
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "async_set.h"
+#include "misc.h"
+#include "worker.h"
+
+//! @cond Doxygen_Suppress
+/* a slot per command and VFO, freq, split freq and mode of a few VFOs */
+#define ASYNC_SET_SLOTS 16
+
+struct async_set_slot
+{
+    int pending;
+    unsigned long order;        /* queue order among the pending slots */
+    struct timespec queued;
+    rig_async_set_t set;
+};
+
+struct async_set_priv
+{
+    struct rig_worker worker;   /* first, see worker.h */
+    rig_async_set_cb_t cb;
+    rig_ptr_t cb_arg;
+    hamlib_async_set_stats_t stats;
+#if defined(HAVE_PTHREAD)
+    int busy;
+    unsigned long order;
+    struct async_set_slot slot[ASYNC_SET_SLOTS];
+#endif
+};
+
+
+static struct async_set_priv *async_set_priv(RIG *rig)
+{
+    return rig_worker_priv(&rig->state.async_set_priv_data,
+                           sizeof(struct async_set_priv), NULL);
+}
+
+
+static int async_set_apply(RIG *rig, const rig_async_set_t *set)
+{
+    switch (set->cmd)
+    {
+    case RIG_ASYNC_SET_FREQ:
+        return rig_set_freq(rig, set->vfo, set->freq);
+
+    case RIG_ASYNC_SET_SPLIT_FREQ:
+        return rig_set_split_freq(rig, set->vfo, set->freq);
+
+    case RIG_ASYNC_SET_MODE:
+        return rig_set_mode(rig, set->vfo, set->mode, set->width);
+    }
+
+    return -RIG_EINVAL;
+}
+
+
+#if defined(HAVE_PTHREAD)
+static void *async_set_thread(void *arg)
+{
+    RIG *rig = (RIG *)arg;
+    struct async_set_priv *priv = rig->state.async_set_priv_data;
+
+    pthread_mutex_lock(&priv->worker.mutex);
+
+    for (;;)
+    {
+        struct async_set_slot *next = NULL;
+        struct timespec queued;
+        rig_async_set_t set;
+        int retval;
+        int i;
+
+        for (i = 0; i < ASYNC_SET_SLOTS; i++)
+        {
+            if (priv->slot[i].pending
+                    && (!next || priv->slot[i].order < next->order))
+            {
+                next = &priv->slot[i];
+            }
+        }
+
+        if (!next)
+        {
+            priv->busy = 0;
+            pthread_cond_broadcast(&priv->worker.idle);
+
+            /* pending values are sent before stopping */
+            if (priv->worker.stop)
+            {
+                break;
+            }
+
+            pthread_cond_wait(&priv->worker.work, &priv->worker.mutex);
+            continue;
+        }
+
+        set = next->set;
+        queued = next->queued;
+        next->pending = 0;
+        priv->stats.pending--;
+        priv->busy = 1;
+        pthread_mutex_unlock(&priv->worker.mutex);
+
+        retval = async_set_apply(rig, &set);
+        set.queued_ms = elapsed_ms(&queued, HAMLIB_ELAPSED_GET);
+
+        if (retval != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: async set %d of %s failed: %s\n", __func__,
+                      set.cmd, rig_strvfo(set.vfo), rigerror(retval));
+        }
+
+        if (priv->cb)
+        {
+            priv->cb(rig, &set, retval, priv->cb_arg);
+        }
+
+        pthread_mutex_lock(&priv->worker.mutex);
+        priv->stats.applied++;
+
+        if (retval != RIG_OK)
+        {
+            priv->stats.failed++;
+        }
+
+        if (set.queued_ms > priv->stats.max_queued_ms)
+        {
+            priv->stats.max_queued_ms = set.queued_ms;
+        }
+    }
+
+    pthread_mutex_unlock(&priv->worker.mutex);
+
+    return NULL;
+}
+#endif
+
+
+static int async_set_queue(RIG *rig, const rig_async_set_t *set)
+{
+    struct async_set_priv *priv;
+
+    if (!rig || !rig->caps || !rig->state.comm_state)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = async_set_priv(rig);
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+#if defined(HAVE_PTHREAD)
+    {
+        struct async_set_slot *slot = NULL;
+        int retval;
+        int i;
+
+        pthread_mutex_lock(&priv->worker.mutex);
+
+        retval = rig_worker_start(&priv->worker, async_set_thread, rig);
+
+        if (retval != RIG_OK)
+        {
+            pthread_mutex_unlock(&priv->worker.mutex);
+            return retval;
+        }
+
+        for (i = 0; i < ASYNC_SET_SLOTS; i++)
+        {
+            struct async_set_slot *s = &priv->slot[i];
+
+            if (s->pending && s->set.cmd == set->cmd && s->set.vfo == set->vfo)
+            {
+                slot = s;
+                break;
+            }
+
+            if (!s->pending && !slot)
+            {
+                slot = s;
+            }
+        }
+
+        if (!slot)
+        {
+            pthread_mutex_unlock(&priv->worker.mutex);
+            rig_debug(RIG_DEBUG_ERR, "%s: no free async set slot\n", __func__);
+            return -RIG_ENOMEM;
+        }
+
+        priv->stats.requests++;
+
+        if (slot->pending)
+        {
+            unsigned long coalesced = slot->set.coalesced + 1;
+
+            /* the newest value wins, it keeps the place of the first */
+            slot->set = *set;
+            slot->set.coalesced = coalesced;
+            priv->stats.coalesced++;
+        }
+        else
+        {
+            slot->set = *set;
+            slot->set.coalesced = 0;
+            slot->pending = 1;
+            slot->order = ++priv->order;
+            priv->stats.pending++;
+            /* the wait is counted from the first value of the slot */
+            elapsed_ms(&slot->queued, HAMLIB_ELAPSED_SET);
+        }
+
+        pthread_cond_signal(&priv->worker.work);
+        pthread_mutex_unlock(&priv->worker.mutex);
+
+        return RIG_OK;
+    }
+#else
+    {
+        /* no threads, apply right away */
+        rig_async_set_t done = *set;
+        struct timespec queued;
+        int retval;
+
+        elapsed_ms(&queued, HAMLIB_ELAPSED_SET);
+        priv->stats.requests++;
+        retval = async_set_apply(rig, &done);
+        done.queued_ms = elapsed_ms(&queued, HAMLIB_ELAPSED_GET);
+        priv->stats.applied++;
+
+        if (retval != RIG_OK)
+        {
+            priv->stats.failed++;
+        }
+
+        if (priv->cb)
+        {
+            priv->cb(rig, &done, retval, priv->cb_arg);
+        }
+
+        return retval;
+    }
+#endif
+}
+
+
+/*
+ * True when called from the async set thread of the rig, whose sets must
+ * go to the rig and not back into the queue.
+ */
+static int rig_async_set_is_worker(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    const struct async_set_priv *priv = rig->state.async_set_priv_data;
+
+    return priv && rig_worker_is_self(&priv->worker);
+#else
+    return 1;
+#endif
+}
+
+
+/*
+ * True when a set of the async_set configuration is to be queued: it is
+ * made by the application and not by a backend from inside a call
+ * running on the same thread, e.g. between the two VFO exchanges of a
+ * split set, where it must reach the rig before the call goes on.
+ */
+int rig_async_set_queues(RIG *rig)
+{
+    return rig->state.async_set && rig_thread_depth() == 0
+           && !rig_async_set_is_worker(rig);
+}
+
+
+/*
+ * Sends what is pending and stops the thread, called by rig_close().
+ */
+void rig_async_set_stop(RIG *rig)
+{
+    struct async_set_priv *priv = rig->state.async_set_priv_data;
+
+    if (priv)
+    {
+        rig_worker_stop(&priv->worker);
+    }
+}
+
+
+void rig_async_set_cleanup(RIG *rig)
+{
+    struct async_set_priv *priv = rig->state.async_set_priv_data;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    rig_worker_destroy(&priv->worker);
+    free(priv);
+    rig->state.async_set_priv_data = NULL;
+}
+//! @endcond
+
+
+/**
+ * \brief Set the frequency without waiting for the rig
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param freq  The frequency to set to
+ *
+ * Queues rig_set_freq() to run on the async set thread of the rig and
+ * returns.  A frequency for the same VFO still waiting to be sent is
+ * replaced, so when the frequency changes faster than the rig can be
+ * told only the newest value is sent.  Sets for different commands and
+ * VFOs are sent in the order they were first queued.
+ *
+ * The result is passed to the callback of rig_set_async_callback().
+ * With the async_set configuration token rig_set_freq() itself queues,
+ * unless a backend calls it from inside another call of the rig.
+ *
+ * \return RIG_OK if the set was queued, otherwise a negative value.
+ *
+ * \sa rig_set_split_freq_async(), rig_set_mode_async(), rig_async_set_flush()
+ */
+int HAMLIB_API rig_set_freq_async(RIG *rig, vfo_t vfo, freq_t freq)
+{
+    rig_async_set_t set;
+
+    memset(&set, 0, sizeof(set));
+    set.cmd = RIG_ASYNC_SET_FREQ;
+    set.vfo = vfo;
+    set.freq = freq;
+
+    return async_set_queue(rig, &set);
+}
+
+
+/**
+ * \brief Set the split TX frequency without waiting for the rig
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param tx_freq   The transmit frequency to set to
+ *
+ * Queues rig_set_split_freq(), see rig_set_freq_async().
+ *
+ * \return RIG_OK if the set was queued, otherwise a negative value.
+ */
+int HAMLIB_API rig_set_split_freq_async(RIG *rig, vfo_t vfo, freq_t tx_freq)
+{
+    rig_async_set_t set;
+
+    memset(&set, 0, sizeof(set));
+    set.cmd = RIG_ASYNC_SET_SPLIT_FREQ;
+    set.vfo = vfo;
+    set.freq = tx_freq;
+
+    return async_set_queue(rig, &set);
+}
+
+
+/**
+ * \brief Set the mode without waiting for the rig
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param mode  The mode to set to
+ * \param width The passband width to set to
+ *
+ * Queues rig_set_mode(), see rig_set_freq_async().
+ *
+ * \return RIG_OK if the set was queued, otherwise a negative value.
+ */
+int HAMLIB_API rig_set_mode_async(RIG *rig, vfo_t vfo, rmode_t mode,
+                                  pbwidth_t width)
+{
+    rig_async_set_t set;
+
+    memset(&set, 0, sizeof(set));
+    set.cmd = RIG_ASYNC_SET_MODE;
+    set.vfo = vfo;
+    set.mode = mode;
+    set.width = width;
+
+    return async_set_queue(rig, &set);
+}
+
+
+/**
+ * \brief Set the callback of the asynchronous sets
+ * \param rig   The rig handle
+ * \param cb    Called after each asynchronous set, NULL for none
+ * \param arg   Passed to \a cb
+ *
+ * The callback runs on the async set thread and gets the value that was
+ * sent, how many older values it replaced and the return code.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value.
+ */
+int HAMLIB_API rig_set_async_callback(RIG *rig, rig_async_set_cb_t cb,
+                                      rig_ptr_t arg)
+{
+    struct async_set_priv *priv;
+
+    if (!rig || !rig->caps)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = async_set_priv(rig);
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->worker.mutex);
+#endif
+    priv->cb = cb;
+    priv->cb_arg = arg;
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->worker.mutex);
+#endif
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Wait for the asynchronous sets to be sent
+ * \param rig   The rig handle
+ * \param timeout_ms    Longest wait in ms
+ *
+ * \return RIG_OK when nothing is pending, -RIG_ETIMEOUT if sets were
+ * still pending after \a timeout_ms.
+ */
+int HAMLIB_API rig_async_set_flush(RIG *rig, int timeout_ms)
+{
+#if defined(HAVE_PTHREAD)
+    struct async_set_priv *priv;
+    struct timespec deadline;
+    int retval = RIG_OK;
+
+    if (!rig || !rig->caps)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = rig->state.async_set_priv_data;
+
+    if (!priv)
+    {
+        return RIG_OK;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&priv->worker.mutex);
+
+    while (priv->worker.running && (priv->stats.pending > 0 || priv->busy))
+    {
+        if (pthread_cond_timedwait(&priv->worker.idle, &priv->worker.mutex, &deadline) == ETIMEDOUT)
+        {
+            retval = -RIG_ETIMEOUT;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&priv->worker.mutex);
+
+    return retval;
+#else
+    return (!rig || !rig->caps) ? -RIG_EINVAL : RIG_OK;
+#endif
+}
+
+
+/**
+ * \brief Get the asynchronous set counters
+ * \param rig   The rig handle
+ * \param stats Set to the counters
+ *
+ * The counters cover the life of the rig handle, across rig_close().
+ *
+ * \return RIG_OK, or -RIG_EINVAL if an argument is NULL
+ */
+int HAMLIB_API rig_get_async_set_stats(RIG *rig, hamlib_async_set_stats_t *stats)
+{
+    struct async_set_priv *priv;
+
+    if (!rig || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = rig->state.async_set_priv_data;
+
+    if (!priv)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return RIG_OK;
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->worker.mutex);
+#endif
+    *stats = priv->stats;
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->worker.mutex);
+#endif
+
+    return RIG_OK;
+}
+
+/** @} */
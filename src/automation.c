@@ -0,0 +1,744 @@
+/*
+ *  Hamlib Interface - station automation
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file automation.c
+ * \brief Station automation on band changes
+ *
+ * Switches the antenna, tells the amplifier the frequency and turns the
+ * rotator to a preset when the rig changes band, following rules read
+ * from a file.  The rig's frequency reaches the engine through its
+ * cache, whether it was set, read or reported by the rig, and the
+ * actions run on a thread of their own so rig_set_freq() does not wait
+ * for them.  rig_set_ptt() does: keying up is held until the switching
+ * for the new band is done.
+ *
+ * Rules file, one band per line:
+ * \code
+ * # band  actions
+ * interlock=500           # longest PTT hold in ms
+ * 20m     ant=2 amp_freq rot=45
+ * BAND40M ant=1 amp_freq rot=300,10
+ * *       amp_freq        # any other band
+ * \endcode
+ *
+ * ant=N selects rig antenna N with rig_set_ant(), amp_freq sends the rig
+ * frequency to the amplifier with amp_set_freq(), on the band change and
+ * on every later frequency change, and rot=AZ[,EL] calls
+ * rot_set_position().
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include <hamlib/amplifier.h>
+#include <hamlib/rotator.h>
+#include "automation.h"
+#include "misc.h"
+#include "worker.h"
+
+//! @cond Doxygen_Suppress
+#define AUTOMATION_RULES_MAX 32
+#define AUTOMATION_INTERLOCK_MS 500
+
+struct automation_rule
+{
+    setting_t band;             /* RIG_BANDSELECT_*, 0 for the default rule */
+    int ant;                    /* antenna number from 1, 0 leaves it */
+    int amp_freq;               /* send the frequency to the amplifier */
+    int rot;                    /* turn the rotator to az, el */
+    azimuth_t az;
+    elevation_t el;
+};
+
+struct automation_priv
+{
+    struct rig_worker worker;   /* first, see worker.h */
+    struct automation_rule rule[AUTOMATION_RULES_MAX];
+    int rules;
+    int interlock_ms;
+    AMP *amp;
+    ROT *rot;
+    hamlib_automation_stats_t stats;
+    setting_t band;             /* band of the last frequency */
+    freq_t freq;                /* last frequency */
+    int band_pending;           /* band actions to run */
+    int freq_pending;           /* frequency to send to the amplifier */
+    int switching;              /* band actions running */
+    int busy;                   /* any action running */
+    struct timespec band_time;  /* when the band changed */
+};
+
+#if defined(HAVE_PTHREAD)
+#define AUTOMATION_LOCK(p) pthread_mutex_lock(&(p)->worker.mutex)
+#define AUTOMATION_UNLOCK(p) pthread_mutex_unlock(&(p)->worker.mutex)
+#else
+#define AUTOMATION_LOCK(p)
+#define AUTOMATION_UNLOCK(p)
+#endif
+
+
+static void automation_priv_init(void *p)
+{
+    struct automation_priv *priv = p;
+
+    priv->interlock_ms = AUTOMATION_INTERLOCK_MS;
+}
+
+
+static struct automation_priv *automation_priv(RIG *rig)
+{
+    return rig_worker_priv(&rig->state.automation_priv_data,
+                           sizeof(struct automation_priv), automation_priv_init);
+}
+
+
+static const struct automation_rule *automation_rule(const struct
+        automation_priv *priv, setting_t band)
+{
+    const struct automation_rule *any = NULL;
+    int i;
+
+    for (i = 0; i < priv->rules; i++)
+    {
+        if (priv->rule[i].band == band)
+        {
+            return &priv->rule[i];
+        }
+
+        if (priv->rule[i].band == 0)
+        {
+            any = &priv->rule[i];
+        }
+    }
+
+    return any;
+}
+
+
+static int automation_count(struct automation_priv *priv, int retval,
+                            const char *what)
+{
+    AUTOMATION_LOCK(priv);
+    priv->stats.actions++;
+
+    if (retval != RIG_OK)
+    {
+        priv->stats.failed++;
+    }
+
+    AUTOMATION_UNLOCK(priv);
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s failed: %s\n", __func__, what,
+                  rigerror(retval));
+    }
+
+    return retval;
+}
+
+
+/* runs one pending piece of work, called and returns with the lock held */
+static void automation_run(RIG *rig, struct automation_priv *priv)
+{
+    const struct automation_rule *rule = automation_rule(priv, priv->band);
+    freq_t freq = priv->freq;
+
+    if (priv->band_pending)
+    {
+        struct timespec band_time = priv->band_time;
+        double ms;
+
+        priv->band_pending = 0;
+        priv->freq_pending = 0;
+        priv->switching = 1;
+        priv->busy = 1;
+        priv->stats.band_changes++;
+        AUTOMATION_UNLOCK(priv);
+
+        if (rule && rule->ant > 0)
+        {
+            value_t option;
+
+            option.i = 0;
+            automation_count(priv, rig_set_ant(rig, RIG_VFO_CURR,
+                                               RIG_ANT_N(rule->ant - 1), option), "rig_set_ant");
+        }
+
+        if (rule && rule->amp_freq && priv->amp)
+        {
+            automation_count(priv, amp_set_freq(priv->amp, freq), "amp_set_freq");
+        }
+
+        if (rule && rule->rot && priv->rot)
+        {
+            automation_count(priv, rot_set_position(priv->rot, rule->az, rule->el),
+                             "rot_set_position");
+        }
+
+        ms = elapsed_ms(&band_time, HAMLIB_ELAPSED_GET);
+        AUTOMATION_LOCK(priv);
+        priv->switching = 0;
+
+        if (ms > priv->stats.max_switch_ms)
+        {
+            priv->stats.max_switch_ms = ms;
+        }
+    }
+    else if (priv->freq_pending)
+    {
+        priv->freq_pending = 0;
+        priv->busy = 1;
+        AUTOMATION_UNLOCK(priv);
+
+        if (rule && rule->amp_freq && priv->amp)
+        {
+            automation_count(priv, amp_set_freq(priv->amp, freq), "amp_set_freq");
+        }
+
+        AUTOMATION_LOCK(priv);
+    }
+
+    priv->busy = 0;
+}
+
+
+#if defined(HAVE_PTHREAD)
+static void *automation_thread(void *arg)
+{
+    RIG *rig = (RIG *)arg;
+    struct automation_priv *priv = rig->state.automation_priv_data;
+
+    pthread_mutex_lock(&priv->worker.mutex);
+
+    for (;;)
+    {
+        if (priv->band_pending || priv->freq_pending)
+        {
+            automation_run(rig, priv);
+            pthread_cond_broadcast(&priv->worker.idle);
+            continue;
+        }
+
+        /* pending actions are run before stopping */
+        if (priv->worker.stop)
+        {
+            break;
+        }
+
+        pthread_cond_wait(&priv->worker.work, &priv->worker.mutex);
+    }
+
+    pthread_mutex_unlock(&priv->worker.mutex);
+
+    return NULL;
+}
+#endif
+
+
+static int automation_parse_rule(struct automation_rule *rule, char *line)
+{
+    char *word = strtok(line, " \t");
+    char name[16];
+
+    memset(rule, 0, sizeof(*rule));
+
+    if (strcmp(word, "*") != 0)
+    {
+        /* 20m or BAND20M */
+        if (strncasecmp(word, "BAND", 4) == 0)
+        {
+            word += 4;
+        }
+
+        SNPRINTF(name, sizeof(name), "BAND%s", word);
+        name[sizeof(name) - 1] = '\0';
+
+        for (word = name; *word; word++)
+        {
+            *word = toupper((unsigned char) * word);
+        }
+
+        rule->band = rig_parse_band(name);
+
+        if (rule->band == 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: unknown band %s\n", __func__, name);
+            return -RIG_EINVAL;
+        }
+    }
+
+    while ((word = strtok(NULL, " \t")) != NULL)
+    {
+        if (strncmp(word, "ant=", 4) == 0)
+        {
+            rule->ant = atoi(word + 4);
+
+            if (rule->ant < 1 || rule->ant > 32)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: bad antenna %s\n", __func__, word);
+                return -RIG_EINVAL;
+            }
+        }
+        else if (strcmp(word, "amp_freq") == 0)
+        {
+            rule->amp_freq = 1;
+        }
+        else if (strncmp(word, "rot=", 4) == 0)
+        {
+            float az, el = 0;
+
+            if (sscanf(word + 4, "%f,%f", &az, &el) < 1)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: bad rotator preset %s\n", __func__, word);
+                return -RIG_EINVAL;
+            }
+
+            rule->rot = 1;
+            rule->az = az;
+            rule->el = el;
+        }
+        else
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: unknown action %s\n", __func__, word);
+            return -RIG_EINVAL;
+        }
+    }
+
+    return RIG_OK;
+}
+//! @endcond
+
+
+/**
+ * \brief Load the station automation rules
+ * \param rig   The rig handle
+ * \param path  Rules file
+ *
+ * Replaces the rules of the rig with those in \a path, see automation.c
+ * for the format.  The rules act on the next band change.
+ *
+ * \return RIG_OK if the rules were loaded, -RIG_EIO if the file could
+ * not be read, -RIG_EINVAL on a syntax error (logged with its line).
+ */
+int HAMLIB_API rig_automation_load(RIG *rig, const char *path)
+{
+    struct automation_priv *priv;
+    struct automation_rule rule[AUTOMATION_RULES_MAX];
+    int interlock_ms = AUTOMATION_INTERLOCK_MS;
+    char line[256];
+    int rules = 0, lineno = 0;
+    FILE *fp;
+
+    if (!rig || !rig->caps || !path)
+    {
+        return -RIG_EINVAL;
+    }
+
+    fp = fopen(path, "r");
+
+    if (!fp)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: %s\n", __func__, path, strerror(errno));
+        return -RIG_EIO;
+    }
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        char *p = strchr(line, '#');
+
+        lineno++;
+
+        if (p)
+        {
+            *p = '\0';
+        }
+
+        for (p = line; isspace((unsigned char) * p); p++) {}
+
+        p[strcspn(p, "\r\n")] = '\0';
+
+        if (*p == '\0')
+        {
+            continue;
+        }
+
+        if (strncmp(p, "interlock=", 10) == 0)
+        {
+            interlock_ms = atoi(p + 10);
+            continue;
+        }
+
+        if (rules == AUTOMATION_RULES_MAX
+                || automation_parse_rule(&rule[rules], p) != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: %s:%d: bad rule\n", __func__, path, lineno);
+            fclose(fp);
+            return -RIG_EINVAL;
+        }
+
+        rules++;
+    }
+
+    fclose(fp);
+
+    priv = automation_priv(rig);
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    AUTOMATION_LOCK(priv);
+    memcpy(priv->rule, rule, rules * sizeof(rule[0]));
+    priv->rules = rules;
+    priv->interlock_ms = interlock_ms;
+    /* act on the band in use, or the next one */
+    priv->band = 0;
+    priv->freq = 0;
+    AUTOMATION_UNLOCK(priv);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %d rules from %s, interlock %dms\n",
+              __func__, rules, path, interlock_ms);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Give station automation the amplifier and rotator to drive
+ * \param rig   The rig handle
+ * \param amp   Opened amplifier handle, or NULL
+ * \param rot   Opened rotator handle, or NULL
+ *
+ * The handles must stay open while the rig is.  Rules using a device
+ * that was not given are skipped for it.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value.
+ */
+int HAMLIB_API rig_automation_attach(RIG *rig, AMP *amp, ROT *rot)
+{
+    struct automation_priv *priv;
+
+    if (!rig || !rig->caps)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = automation_priv(rig);
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    AUTOMATION_LOCK(priv);
+    priv->amp = amp;
+    priv->rot = rot;
+    AUTOMATION_UNLOCK(priv);
+
+    return RIG_OK;
+}
+
+
+//! @cond Doxygen_Suppress
+/*
+ * The frequency of the rig's transmit VFO is now freq, called by
+ * rig_set_cache_freq().  Queues the band actions when the band changed,
+ * else the amplifier frequency.  Returns an error if the thread to run
+ * them cannot be started.
+ */
+int rig_automation_freq(RIG *rig, freq_t freq)
+{
+    struct automation_priv *priv = rig->state.automation_priv_data;
+    const struct automation_rule *rule;
+    setting_t band;
+    int retval = RIG_OK;
+
+    if (!priv || priv->rules == 0 || freq == priv->freq)
+    {
+        return RIG_OK;
+    }
+
+    band = (setting_t)rig_get_band(rig, freq, -1);
+
+    AUTOMATION_LOCK(priv);
+    priv->freq = freq;
+
+    if (band != priv->band)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: band changed to %s\n", __func__,
+                  rig_get_band_str(rig, band, 0));
+        priv->band = band;
+        priv->band_pending = 1;
+        elapsed_ms(&priv->band_time, HAMLIB_ELAPSED_SET);
+    }
+    else
+    {
+        rule = automation_rule(priv, band);
+
+        if (!rule || !rule->amp_freq || !priv->amp)
+        {
+            AUTOMATION_UNLOCK(priv);
+            return RIG_OK;
+        }
+
+        priv->freq_pending = 1;
+    }
+
+#if defined(HAVE_PTHREAD)
+
+    /*
+     * the actions must not run here, under the rig lock of the caller;
+     * they stay pending for the next frequency and the PTT interlock
+     * refuses to key up until they are done
+     */
+    retval = rig_worker_start(&priv->worker, automation_thread, rig);
+
+    if (retval == RIG_OK)
+    {
+        pthread_cond_signal(&priv->worker.work);
+    }
+
+    pthread_mutex_unlock(&priv->worker.mutex);
+#else
+    automation_run(rig, priv);
+#endif
+
+    return retval;
+}
+
+
+/*
+ * PTT interlock, called by rig_set_ptt() before keying up.  Waits for the
+ * switching of a band change to be done, at most the rules' interlock
+ * time, and refuses to key up after that.
+ */
+int rig_automation_ptt(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    struct automation_priv *priv = rig->state.automation_priv_data;
+    struct timespec start, deadline;
+    int retval = RIG_OK;
+    double ms;
+
+    if (!priv)
+    {
+        return RIG_OK;
+    }
+
+    pthread_mutex_lock(&priv->worker.mutex);
+
+    if (!priv->band_pending && !priv->switching)
+    {
+        pthread_mutex_unlock(&priv->worker.mutex);
+        return RIG_OK;
+    }
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += priv->interlock_ms / 1000;
+    deadline.tv_nsec += (priv->interlock_ms % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    while (priv->band_pending || priv->switching)
+    {
+        if (pthread_cond_timedwait(&priv->worker.idle, &priv->worker.mutex, &deadline) == ETIMEDOUT)
+        {
+            priv->stats.interlock_timeouts++;
+            retval = -RIG_ETIMEOUT;
+            break;
+        }
+    }
+
+    ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    priv->stats.interlocks++;
+    priv->stats.last_interlock_ms = ms;
+
+    if (ms > priv->stats.max_interlock_ms)
+    {
+        priv->stats.max_interlock_ms = ms;
+    }
+
+    pthread_mutex_unlock(&priv->worker.mutex);
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: band switching not done after %dms, PTT refused\n",
+                  __func__, priv->interlock_ms);
+    }
+    else
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: PTT held %.1fms for band switching\n",
+                  __func__, ms);
+    }
+
+    return retval;
+#else
+    /* the actions ran before rig_set_freq() returned */
+    return RIG_OK;
+#endif
+}
+
+
+/*
+ * Runs what is pending and stops the thread, called by rig_close().
+ */
+void rig_automation_stop(RIG *rig)
+{
+    struct automation_priv *priv = rig->state.automation_priv_data;
+
+    if (priv)
+    {
+        rig_worker_stop(&priv->worker);
+    }
+}
+
+
+void rig_automation_cleanup(RIG *rig)
+{
+    struct automation_priv *priv = rig->state.automation_priv_data;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    rig_worker_destroy(&priv->worker);
+    free(priv);
+    rig->state.automation_priv_data = NULL;
+}
+//! @endcond
+
+
+/**
+ * \brief Wait for the station automation actions to be done
+ * \param rig   The rig handle
+ * \param timeout_ms    Longest wait in ms
+ *
+ * \return RIG_OK when nothing is pending, -RIG_ETIMEOUT if actions were
+ * still pending after \a timeout_ms.
+ */
+int HAMLIB_API rig_automation_wait(RIG *rig, int timeout_ms)
+{
+#if defined(HAVE_PTHREAD)
+    struct automation_priv *priv;
+    struct timespec deadline;
+    int retval = RIG_OK;
+
+    if (!rig || !rig->caps)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = rig->state.automation_priv_data;
+
+    if (!priv)
+    {
+        return RIG_OK;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&priv->worker.mutex);
+
+    while (priv->worker.running
+            && (priv->band_pending || priv->freq_pending || priv->busy))
+    {
+        if (pthread_cond_timedwait(&priv->worker.idle, &priv->worker.mutex, &deadline) == ETIMEDOUT)
+        {
+            retval = -RIG_ETIMEOUT;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&priv->worker.mutex);
+
+    return retval;
+#else
+    return (!rig || !rig->caps) ? -RIG_EINVAL : RIG_OK;
+#endif
+}
+
+
+/**
+ * \brief Get the station automation counters
+ * \param rig   The rig handle
+ * \param stats Set to the counters
+ *
+ * \return RIG_OK, or -RIG_EINVAL if an argument is NULL
+ */
+int HAMLIB_API rig_automation_get_stats(RIG *rig,
+                                        hamlib_automation_stats_t *stats)
+{
+    struct automation_priv *priv;
+
+    if (!rig || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = rig->state.automation_priv_data;
+
+    if (!priv)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return RIG_OK;
+    }
+
+    AUTOMATION_LOCK(priv);
+    *stats = priv->stats;
+    AUTOMATION_UNLOCK(priv);
+
+    return RIG_OK;
+}
+
+/** @} */
@@ -1,7 +1,8 @@
 // This is currently included in rig.c
 // Can customize during build
-// Eventually should improved this for external actions when
-// rigctld gets integrated as a service within Hamlib
+// Antenna, amplifier and rotator switching on band changes is done by
+// the station automation rules instead, see rig_automation_load() in
+// automation.c, without rebuilding and without blocking rig_set_freq
 int HAMLIB_API rig_band_changed(RIG *rig, hamlib_bandselect_t band)
 {
     // See band_changed.c
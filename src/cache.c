@@ -21,8 +21,15 @@
  */
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <hamlib/config.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
 #include "cache.h"
 #include "misc.h"
+#include "automation.h"
 
 #define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
 
@@ -156,6 +163,7 @@ int rig_set_cache_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 int rig_set_cache_freq(RIG *rig, vfo_t vfo, freq_t freq)
 {
     int flag = HAMLIB_ELAPSED_SET;
+    int retval = RIG_OK;
     struct rig_cache *cachep = CACHE(rig);
 
     if (rig_need_debug(RIG_DEBUG_CACHE))
@@ -273,13 +281,21 @@ int rig_set_cache_freq(RIG *rig, vfo_t vfo, freq_t freq)
         return (-RIG_EINVAL);
     }
 
+    // station automation follows the transmit frequency
+    if (freq != 0 && rig->state.automation_priv_data
+            && vfo == (cachep->split == RIG_SPLIT_ON ? rig->state.tx_vfo
+                       : rig->state.current_vfo))
+    {
+        retval = rig_automation_freq(rig, freq);
+    }
+
     if (rig_need_debug(RIG_DEBUG_CACHE))
     {
         rig_cache_show(rig, __func__, __LINE__);
-        return (RIG_OK);
+        return (retval);
     }
 
-    return (RIG_OK);
+    return (retval);
 }
 
 /**
@@ -587,4 +603,286 @@ void rig_cache_show(RIG *rig, const char *func, int line)
     }
 }
 
+/*
+ * Adaptive cache timeouts
+ *
+ * With cache_adaptive set every cache class gets a timeout worked out
+ * from how long a backend read of that class takes and how much of the
+ * rig port's time polling may use (cache_target_load).  If a client
+ * polls all the measured classes back to back the port then spends the
+ * target load on polling and the rest is left for everything else.
+ *
+ * Time spent in write_block() and the read functions on the rig port is
+ * added up over a window of CACHE_ADAPT_WINDOW_MS.  When the port is
+ * busier than the target, e.g. while sending CW or switching PTT, the
+ * timeouts back off, and they tighten again once it has gone quiet.
+ * No timeout ever goes beyond cache_max_ms, so a cached value is never
+ * older than that.
+ */
+
+#define CACHE_ADAPT_WINDOW_MS 1000
+#define CACHE_ADAPT_MAX_PORTS 16
+#define CACHE_ADAPT_MIN_BACKOFF 0.5
+#define CACHE_ADAPT_MAX_BACKOFF 16.0
+
+static struct
+{
+    const hamlib_port_t *port;
+    struct rig_state *rs;
+} adapt_ports[CACHE_ADAPT_MAX_PORTS];
+static volatile int adapt_count;
+
+#if defined(HAVE_PTHREAD)
+static pthread_mutex_t adapt_lock = PTHREAD_MUTEX_INITIALIZER;
+#define ADAPT_LOCK pthread_mutex_lock(&adapt_lock)
+#define ADAPT_UNLOCK pthread_mutex_unlock(&adapt_lock)
+#else
+#define ADAPT_LOCK
+#define ADAPT_UNLOCK
+#endif
+
+
+/* Start measuring the rig port load, called by rig_open() */
+void rig_cache_adapt_start(RIG *rig)
+{
+    struct rig_state *rs = STATE(rig);
+    int i;
+
+    ADAPT_LOCK;
+
+    for (i = 0; i < adapt_count; i++)
+    {
+        if (adapt_ports[i].rs == rs)
+        {
+            break;
+        }
+    }
+
+    if (i == adapt_count && adapt_count < CACHE_ADAPT_MAX_PORTS)
+    {
+        adapt_ports[i].port = RIGPORT(rig);
+        adapt_ports[i].rs = rs;
+        adapt_count++;
+    }
+
+    rs->port_busy_ms = 0;
+    rs->port_load = 0;
+    elapsed_ms(&rs->port_load_window, HAMLIB_ELAPSED_SET);
+
+    ADAPT_UNLOCK;
+
+    if (i == CACHE_ADAPT_MAX_PORTS)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: too many adaptive rigs, port load not measured\n",
+                  __func__);
+    }
+}
+
+
+/* Stop measuring the rig port load, called by rig_close() */
+void rig_cache_adapt_stop(RIG *rig)
+{
+    struct rig_state *rs = STATE(rig);
+    int i;
+
+    ADAPT_LOCK;
+
+    for (i = 0; i < adapt_count; i++)
+    {
+        if (adapt_ports[i].rs == rs)
+        {
+            adapt_ports[i] = adapt_ports[--adapt_count];
+            break;
+        }
+    }
+
+    ADAPT_UNLOCK;
+}
+
+
+/* Note the start of a port transaction, cheap when no rig is adaptive */
+void port_busy_begin(struct timespec *start)
+{
+    if (adapt_count == 0)
+    {
+        start->tv_sec = 0;
+        start->tv_nsec = 0;
+        return;
+    }
+
+    elapsed_ms(start, HAMLIB_ELAPSED_SET);
+}
+
+
+/* Add the time since port_busy_begin() to the load of the port's rig */
+void port_busy_end(const hamlib_port_t *p, struct timespec *start)
+{
+    double ms;
+    int i;
+
+    if (adapt_count == 0 || (start->tv_sec == 0 && start->tv_nsec == 0))
+    {
+        return;
+    }
+
+    ms = elapsed_ms(start, HAMLIB_ELAPSED_GET);
+
+    ADAPT_LOCK;
+
+    for (i = 0; i < adapt_count; i++)
+    {
+        if (adapt_ports[i].port == p)
+        {
+            adapt_ports[i].rs->port_busy_ms += ms;
+            break;
+        }
+    }
+
+    ADAPT_UNLOCK;
+}
+
+
+/* Close the load window once it is over and adjust the backoff, holding ADAPT_LOCK */
+static void cache_adapt_window(struct rig_state *rs)
+{
+    double window = elapsed_ms(&rs->port_load_window, HAMLIB_ELAPSED_GET);
+    double target = rs->cache_target_load / 100.0;
+
+    if (window < CACHE_ADAPT_WINDOW_MS)
+    {
+        return;
+    }
+
+    rs->port_load = rs->port_busy_ms / window;
+    rs->port_busy_ms = 0;
+    elapsed_ms(&rs->port_load_window, HAMLIB_ELAPSED_SET);
+
+    if (rs->port_load > target && rs->cache_backoff < CACHE_ADAPT_MAX_BACKOFF)
+    {
+        rs->cache_backoff *= 2;
+    }
+    else if (rs->port_load < target / 2
+             && rs->cache_backoff > CACHE_ADAPT_MIN_BACKOFF)
+    {
+        rs->cache_backoff /= 2;
+    }
+}
+
+
+/**
+ * \brief Update the adaptive cache timeouts after a backend read
+ * \param rig The rig handle
+ * \param selection The cache class that was read
+ * \param start When the read started
+ *
+ * Does nothing unless cache_adaptive is set.
+ */
+void rig_cache_adapt(RIG *rig, hamlib_cache_t selection, struct timespec *start)
+{
+    struct rig_state *rs = STATE(rig);
+    double ms;
+    double target;
+    int classes = 0;
+    int i;
+
+    if (!rs->cache_adaptive || selection <= HAMLIB_CACHE_ALL
+            || selection > HAMLIB_CACHE_WIDTH)
+    {
+        return;
+    }
+
+    ms = elapsed_ms(start, HAMLIB_ELAPSED_GET);
+
+    if (rs->cache_latency_ms[selection] == 0)
+    {
+        rs->cache_latency_ms[selection] = ms;
+    }
+    else
+    {
+        rs->cache_latency_ms[selection] = rs->cache_latency_ms[selection] * 0.8 +
+                                          ms * 0.2;
+    }
+
+    ADAPT_LOCK;
+    cache_adapt_window(rs);
+    ADAPT_UNLOCK;
+
+    /* the width comes with the mode so it is not a read of its own */
+    for (i = HAMLIB_CACHE_VFO; i < HAMLIB_CACHE_WIDTH; i++)
+    {
+        if (rs->cache_latency_ms[i] > 0)
+        {
+            classes++;
+        }
+    }
+
+    target = (rs->cache_target_load > 0 ? rs->cache_target_load : 1) / 100.0;
+
+    for (i = HAMLIB_CACHE_VFO; i < HAMLIB_CACHE_WIDTH; i++)
+    {
+        double timeout = rs->cache_backoff * classes * rs->cache_latency_ms[i] /
+                         target;
+
+        rs->cache_timeouts_ms[i] = timeout > rs->cache_max_ms ? rs->cache_max_ms :
+                                   (int)timeout;
+    }
+
+    rs->cache_timeouts_ms[HAMLIB_CACHE_WIDTH] =
+        rs->cache_timeouts_ms[HAMLIB_CACHE_MODE];
+
+    rig_debug(RIG_DEBUG_CACHE,
+              "%s: class %d read %.1fms, load=%.0f%% backoff=%.2f timeout=%dms\n",
+              __func__, selection, ms, rs->port_load * 100, rs->cache_backoff,
+              rs->cache_timeouts_ms[selection]);
+}
+
+
+/**
+ * \brief Get the adaptive cache policy and the current cache timeouts
+ * \param rig The rig handle
+ * \param policy Where to store the policy
+ *
+ * The timeouts are filled in whether or not cache_adaptive is set, so
+ * this also shows the fixed timeouts set with rig_set_cache_timeout_ms().
+ *
+ * \return RIG_OK, or -RIG_EINVAL if an argument is NULL
+ *
+ * \sa rig_set_cache_timeout_ms()
+ */
+int HAMLIB_API rig_get_cache_policy(RIG *rig, hamlib_cache_policy_t *policy)
+{
+    struct rig_state *rs;
+    int i;
+
+    if (!rig || !policy)
+    {
+        return -RIG_EINVAL;
+    }
+
+    rs = STATE(rig);
+
+    ADAPT_LOCK;
+
+    if (rs->cache_adaptive)
+    {
+        cache_adapt_window(rs);
+    }
+
+    policy->adaptive = rs->cache_adaptive;
+    policy->target_load = rs->cache_target_load;
+    policy->max_ms = rs->cache_max_ms;
+    policy->load = rs->port_load * 100;
+    policy->backoff = rs->cache_backoff;
+
+    ADAPT_UNLOCK;
+
+    for (i = HAMLIB_CACHE_ALL; i <= HAMLIB_CACHE_WIDTH; i++)
+    {
+        policy->timeout_ms[i] = rig_get_cache_timeout_ms(rig, i);
+        policy->latency_ms[i] = rs->cache_latency_ms[i];
+    }
+
+    return RIG_OK;
+}
+
 /*! @} */
@@ -29,4 +29,10 @@ int rig_set_cache_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width);
 int rig_set_cache_freq(RIG *rig, vfo_t vfo, freq_t freq);
 void rig_cache_show(RIG *rig, const char *func, int line);
 
+void rig_cache_adapt_start(RIG *rig);
+void rig_cache_adapt_stop(RIG *rig);
+void rig_cache_adapt(RIG *rig, hamlib_cache_t selection, struct timespec *start);
+void port_busy_begin(struct timespec *start);
+void port_busy_end(const hamlib_port_t *p, struct timespec *start);
+
 #endif
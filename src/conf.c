@@ -39,6 +39,7 @@
 
 #include <hamlib/rig.h>
 #include "token.h"
+#include "cache.h"
 
 
 /*
@@ -225,6 +226,86 @@ static const struct confparams frontend_cfg_params[] =
         "True enables skipping setting the TX_VFO when RX_VFO is receiving and skips RX_VFO when TX_VFO is transmitting",
         "0", RIG_CONF_CHECKBUTTON, { }
     },
+    {
+        TOK_TRACE_RECORD, "trace_record", "Record port trace",
+        "File to record all rig port writes and reads to with their timing",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_TRACE_REPLAY, "trace_replay", "Replay port trace",
+        "Trace file recorded with trace_record to replay instead of opening the rig port",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_TRACE_TIMING, "trace_timing", "Replay timing",
+        "Replay timing in percent of the recorded timing, 0 replays as fast as possible",
+        "100", RIG_CONF_NUMERIC, { .n = { 0, 10000, 1 } }
+    },
+    {
+        TOK_CACHE_ADAPTIVE, "cache_adaptive", "Adaptive cache timeouts",
+        "True sets each cache timeout from the measured read time and port load instead of cache_timeout",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_CACHE_TARGET_LOAD, "cache_target_load", "Adaptive cache port load",
+        "Percentage of the rig port time polling may use with cache_adaptive",
+        "50", RIG_CONF_NUMERIC, { .n = { 1, 100, 1 } }
+    },
+    {
+        TOK_CACHE_MAX_MS, "cache_max_ms", "Adaptive cache max timeout",
+        "Longest cache timeout in ms with cache_adaptive, no cached value is older than this",
+        "1000", RIG_CONF_NUMERIC, { .n = { 0, 60000, 1 } }
+    },
+    {
+        TOK_ASYNC_SET, "async_set", "Asynchronous set",
+        "True returns from set_freq, set_split_freq and set_mode at once and sends only the newest value of each",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_MULTICAST_DELTA, "multicast_delta", "Multicast delta mode",
+        "True publishes only the fields that changed, with a full keyframe every multicast_keyframe ms and on a resync request",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_MULTICAST_KEYFRAME, "multicast_keyframe", "Multicast keyframe interval",
+        "Longest time in ms between full snapshots with multicast_delta, 0 sends them only on a resync request",
+        "5000", RIG_CONF_NUMERIC, { .n = { 0, 3600000, 1 } }
+    },
+    {
+        TOK_MULTICAST_SPECTRUM, "multicast_spectrum", "Multicast spectrum reduction",
+        "Reduce the multicast scope lines, e.g. width=100,bin=max,average=2,peak_hold=1000,interval=500, empty for full lines",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_KEYER_TYPE, "keyer_type", "Software keyer line",
+        "Line the software CW keyer keys for rig_send_morse, None uses the rig's own keyer",
+        "None", RIG_CONF_COMBO, { .c = {{ "None", "DTR", "RTS", "CM108", "GPIO", "GPION", NULL }} }
+    },
+    {
+        TOK_KEYER_PATHNAME, "keyer_pathname", "Software keyer path name",
+        "Device of the software keyer line, empty for DTR or RTS of the rig port",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_KEYER_BITNUM, "keyer_bitnum", "Software keyer bit [0-7]",
+        "CM108 GPIO bit number of the software keyer",
+        "2", RIG_CONF_NUMERIC, { .n = { 0, 7, 1 } }
+    },
+    {
+        TOK_KEYER_WPM, "keyer_wpm", "Software keyer speed",
+        "Software keyer character speed in WPM",
+        "25", RIG_CONF_NUMERIC, { .n = { 5, 99, 1 } }
+    },
+    {
+        TOK_KEYER_FARNSWORTH, "keyer_farnsworth", "Software keyer Farnsworth speed",
+        "Software keyer overall speed in WPM with longer spaces, 0 for none",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 99, 1 } }
+    },
+    {
+        TOK_KEYER_WEIGHT, "keyer_weight", "Software keyer weighting",
+        "Software keyer dot key down in percent of a dot and its space, 50 for 1:1",
+        "50", RIG_CONF_NUMERIC, { .n = { 10, 90, 1 } }
+    },
 
     { RIG_CONF_END, NULL, }
 };
@@ -834,6 +915,178 @@ static int frontend_set_conf(RIG *rig, hamlib_token_t token, const char *val)
         rs->freq_skip = val_i != 0;
         break;
 
+    case TOK_TRACE_RECORD:
+        free(rs->trace_record_pathname);
+        rs->trace_record_pathname = val[0] ? strdup(val) : NULL;
+        break;
+
+    case TOK_TRACE_REPLAY:
+        free(rs->trace_replay_pathname);
+        rs->trace_replay_pathname = val[0] ? strdup(val) : NULL;
+        break;
+
+    case TOK_TRACE_TIMING:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->trace_timing = val_i;
+        break;
+
+    case TOK_CACHE_ADAPTIVE:
+        if (1 != sscanf(val, "%ld", &val_i))
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->cache_adaptive = val_i != 0;
+
+        if (rs->cache_adaptive && rs->comm_state)
+        {
+            rig_cache_adapt_start(rig);
+        }
+        else if (!rs->cache_adaptive)
+        {
+            rig_cache_adapt_stop(rig);
+            // back to the fixed cache_timeout for every class
+            rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, CACHE(rig)->timeout_ms);
+        }
+
+        break;
+
+    case TOK_CACHE_TARGET_LOAD:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 1 || val_i > 100)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->cache_target_load = val_i;
+        break;
+
+    case TOK_CACHE_MAX_MS:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->cache_max_ms = val_i;
+        break;
+
+    case TOK_ASYNC_SET:
+        if (1 != sscanf(val, "%ld", &val_i))
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->async_set = val_i != 0;
+        break;
+
+    case TOK_MULTICAST_DELTA:
+        if (1 != sscanf(val, "%ld", &val_i))
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->multicast_delta = val_i != 0;
+        break;
+
+    case TOK_MULTICAST_KEYFRAME:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->multicast_keyframe_ms = val_i;
+        break;
+
+    case TOK_MULTICAST_SPECTRUM:
+    {
+        rig_spectrum_reduction_t reduction;
+
+        if (rig_spectrum_reduction_parse(val, &reduction) != RIG_OK)
+        {
+            return -RIG_EINVAL;
+        }
+
+        free(rs->multicast_spectrum);
+        rs->multicast_spectrum = val[0] ? strdup(val) : NULL;
+        break;
+    }
+
+    case TOK_KEYER_TYPE:
+        if (!strcmp(val, "None"))
+        {
+            rs->keyer_type = RIG_PTT_NONE;
+        }
+        else if (!strcmp(val, "DTR"))
+        {
+            rs->keyer_type = RIG_PTT_SERIAL_DTR;
+        }
+        else if (!strcmp(val, "RTS"))
+        {
+            rs->keyer_type = RIG_PTT_SERIAL_RTS;
+        }
+        else if (!strcmp(val, "CM108"))
+        {
+            rs->keyer_type = RIG_PTT_CM108;
+        }
+        else if (!strcmp(val, "GPIO"))
+        {
+            rs->keyer_type = RIG_PTT_GPIO;
+        }
+        else if (!strcmp(val, "GPION"))
+        {
+            rs->keyer_type = RIG_PTT_GPION;
+        }
+        else
+        {
+            return -RIG_EINVAL;
+        }
+
+        break;
+
+    case TOK_KEYER_PATHNAME:
+        free(rs->keyer_pathname);
+        rs->keyer_pathname = val[0] ? strdup(val) : NULL;
+        break;
+
+    case TOK_KEYER_BITNUM:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0 || val_i > 7)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->keyer_bitnum = val_i;
+        break;
+
+    case TOK_KEYER_WPM:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 5 || val_i > 99)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->keyer_wpm = val_i;
+        break;
+
+    case TOK_KEYER_FARNSWORTH:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 0 || val_i > 99)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->keyer_farnsworth_wpm = val_i;
+        break;
+
+    case TOK_KEYER_WEIGHT:
+        if (1 != sscanf(val, "%ld", &val_i) || val_i < 10 || val_i > 90)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->keyer_weight = val_i;
+        break;
+
     default:
         return -RIG_EINVAL;
     }
@@ -1216,6 +1469,100 @@ static int frontend_get_conf2(RIG *rig, hamlib_token_t token, char *val, int val
         SNPRINTF(val, val_len, "%d", rs->multicast_cmd_port);
         break;
 
+    case TOK_TRACE_RECORD:
+        SNPRINTF(val, val_len, "%s",
+                 rs->trace_record_pathname ? rs->trace_record_pathname : "");
+        break;
+
+    case TOK_TRACE_REPLAY:
+        SNPRINTF(val, val_len, "%s",
+                 rs->trace_replay_pathname ? rs->trace_replay_pathname : "");
+        break;
+
+    case TOK_TRACE_TIMING:
+        SNPRINTF(val, val_len, "%d", rs->trace_timing);
+        break;
+
+    case TOK_CACHE_ADAPTIVE:
+        SNPRINTF(val, val_len, "%d", rs->cache_adaptive);
+        break;
+
+    case TOK_CACHE_TARGET_LOAD:
+        SNPRINTF(val, val_len, "%d", rs->cache_target_load);
+        break;
+
+    case TOK_CACHE_MAX_MS:
+        SNPRINTF(val, val_len, "%d", rs->cache_max_ms);
+        break;
+
+    case TOK_ASYNC_SET:
+        SNPRINTF(val, val_len, "%d", rs->async_set);
+        break;
+
+    case TOK_MULTICAST_DELTA:
+        SNPRINTF(val, val_len, "%d", rs->multicast_delta);
+        break;
+
+    case TOK_MULTICAST_KEYFRAME:
+        SNPRINTF(val, val_len, "%d", rs->multicast_keyframe_ms);
+        break;
+
+    case TOK_MULTICAST_SPECTRUM:
+        SNPRINTF(val, val_len, "%s",
+                 rs->multicast_spectrum ? rs->multicast_spectrum : "");
+        break;
+
+    case TOK_KEYER_TYPE:
+        switch (rs->keyer_type)
+        {
+        case RIG_PTT_SERIAL_DTR:
+            s = "DTR";
+            break;
+
+        case RIG_PTT_SERIAL_RTS:
+            s = "RTS";
+            break;
+
+        case RIG_PTT_CM108:
+            s = "CM108";
+            break;
+
+        case RIG_PTT_GPIO:
+            s = "GPIO";
+            break;
+
+        case RIG_PTT_GPION:
+            s = "GPION";
+            break;
+
+        default:
+            s = "None";
+            break;
+        }
+
+        SNPRINTF(val, val_len, "%s", s);
+        break;
+
+    case TOK_KEYER_PATHNAME:
+        SNPRINTF(val, val_len, "%s", rs->keyer_pathname ? rs->keyer_pathname : "");
+        break;
+
+    case TOK_KEYER_BITNUM:
+        SNPRINTF(val, val_len, "%d", rs->keyer_bitnum);
+        break;
+
+    case TOK_KEYER_WPM:
+        SNPRINTF(val, val_len, "%d", rs->keyer_wpm);
+        break;
+
+    case TOK_KEYER_FARNSWORTH:
+        SNPRINTF(val, val_len, "%d", rs->keyer_farnsworth_wpm);
+        break;
+
+    case TOK_KEYER_WEIGHT:
+        SNPRINTF(val, val_len, "%d", rs->keyer_weight);
+        break;
+
     default:
         return -RIG_EINVAL;
     }
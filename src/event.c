@@ -49,6 +49,8 @@
 #include "misc.h"
 #include "cache.h"
 #include "network.h"
+#include "spectrum_reduce.h"
+#include "station.h"
 
 #define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
 
@@ -62,190 +64,200 @@ typedef struct rig_poll_routine_priv_data_s
 {
     pthread_t thread_id;
     rig_poll_routine_args args;
+    station_source_t *source;   // run by the station loop instead
+
+    // the state last published
+    vfo_t vfo, tx_vfo;
+    freq_t freq_main_a, freq_main_b, freq_main_c, freq_sub_a, freq_sub_b,
+           freq_sub_c;
+    rmode_t mode_main_a, mode_main_b, mode_main_c, mode_sub_a, mode_sub_b,
+            mode_sub_c;
+    pbwidth_t width_main_a, width_main_b, width_main_c, width_sub_a,
+              width_sub_b, width_sub_c;
+    ptt_t ptt;
+    split_t split;
+    int interval_count;
 } rig_poll_routine_priv_data;
 
-void *rig_poll_routine(void *arg)
+// Attempt to detect changes with the interval below (in milliseconds)
+#define CHANGE_DETECTION_INTERVAL 50
+
+// publishes the state of the rig when it changed, or every poll_interval
+static void rig_poll_check(RIG *rig, rig_poll_routine_priv_data *priv)
 {
-    rig_poll_routine_args *args = (rig_poll_routine_args *)arg;
-    RIG *rig = args->rig;
     struct rig_state *rs = &rig->state;
     struct rig_cache *cachep = CACHE(rig);
-    int update_occurred;
-
-    vfo_t vfo = RIG_VFO_NONE, tx_vfo = RIG_VFO_NONE;
-    freq_t freq_main_a = 0, freq_main_b = 0, freq_main_c = 0, freq_sub_a = 0,
-           freq_sub_b = 0, freq_sub_c = 0;
-    rmode_t mode_main_a = 0, mode_main_b = 0, mode_main_c = 0, mode_sub_a = 0,
-            mode_sub_b = 0, mode_sub_c = 0;
-    pbwidth_t width_main_a = 0, width_main_b = 0, width_main_c = 0, width_sub_a = 0,
-              width_sub_b = 0, width_sub_c = 0;
-    ptt_t ptt = RIG_PTT_OFF;
-    split_t split = RIG_SPLIT_OFF;
+    int update_occurred = 0;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting rig poll routine thread\n",
-              __FILE__, __LINE__);
-
-    // Rig cache time should be equal to rig poll interval (should be set automatically by rigctld at least)
-    rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, rs->poll_interval);
+    if (rig->state.current_vfo != priv->vfo)
+    {
+        priv->vfo = rig->state.current_vfo;
+        update_occurred = 1;
+    }
 
-    // Attempt to detect changes with the interval below (in milliseconds)
-    int change_detection_interval = 50;
-    int interval_count = 0;
+    if (rig->state.tx_vfo != priv->tx_vfo)
+    {
+        priv->tx_vfo = rig->state.tx_vfo;
+        update_occurred = 1;
+    }
 
-    update_occurred = 0;
+    if (cachep->freqMainA != priv->freq_main_a)
+    {
+        priv->freq_main_a = cachep->freqMainA;
+        update_occurred = 1;
+    }
 
-    network_publish_rig_poll_data(rig);
+    if (cachep->freqMainB != priv->freq_main_b)
+    {
+        priv->freq_main_b = cachep->freqMainB;
+        update_occurred = 1;
+    }
 
-    while (rs->poll_routine_thread_run)
+    if (cachep->freqMainC != priv->freq_main_c)
     {
-        if (rig->state.current_vfo != vfo)
-        {
-            vfo = rig->state.current_vfo;
-            update_occurred = 1;
-        }
+        priv->freq_main_c = cachep->freqMainC;
+        update_occurred = 1;
+    }
 
-        if (rig->state.tx_vfo != tx_vfo)
-        {
-            tx_vfo = rig->state.tx_vfo;
-            update_occurred = 1;
-        }
+    if (cachep->freqSubA != priv->freq_sub_a)
+    {
+        priv->freq_sub_a = cachep->freqSubA;
+        update_occurred = 1;
+    }
 
-        if (cachep->freqMainA != freq_main_a)
-        {
-            freq_main_a = cachep->freqMainA;
-            update_occurred = 1;
-        }
+    if (cachep->freqSubB != priv->freq_sub_b)
+    {
+        priv->freq_sub_b = cachep->freqSubB;
+        update_occurred = 1;
+    }
 
-        if (cachep->freqMainB != freq_main_b)
-        {
-            freq_main_b = cachep->freqMainB;
-            update_occurred = 1;
-        }
+    if (cachep->freqSubC != priv->freq_sub_c)
+    {
+        priv->freq_sub_c = cachep->freqSubC;
+        update_occurred = 1;
+    }
 
-        if (cachep->freqMainC != freq_main_c)
-        {
-            freq_main_b = cachep->freqMainC;
-            update_occurred = 1;
-        }
+    if (cachep->ptt != priv->ptt)
+    {
+        priv->ptt = cachep->ptt;
+        update_occurred = 1;
+    }
 
-        if (cachep->freqSubA != freq_sub_a)
-        {
-            freq_sub_a = cachep->freqSubA;
-            update_occurred = 1;
-        }
+    if (cachep->split != priv->split)
+    {
+        priv->split = cachep->split;
+        update_occurred = 1;
+    }
 
-        if (cachep->freqSubB != freq_sub_b)
-        {
-            freq_sub_b = cachep->freqSubB;
-            update_occurred = 1;
-        }
+    if (cachep->modeMainA != priv->mode_main_a)
+    {
+        priv->mode_main_a = cachep->modeMainA;
+        update_occurred = 1;
+    }
 
-        if (cachep->freqSubC != freq_sub_c)
-        {
-            freq_sub_c = cachep->freqSubC;
-            update_occurred = 1;
-        }
+    if (cachep->modeMainB != priv->mode_main_b)
+    {
+        priv->mode_main_b = cachep->modeMainB;
+        update_occurred = 1;
+    }
 
-        if (cachep->ptt != ptt)
-        {
-            ptt = cachep->ptt;
-            update_occurred = 1;
-        }
+    if (cachep->modeMainC != priv->mode_main_c)
+    {
+        priv->mode_main_c = cachep->modeMainC;
+        update_occurred = 1;
+    }
 
-        if (cachep->split != split)
-        {
-            split = cachep->split;
-            update_occurred = 1;
-        }
+    if (cachep->modeSubA != priv->mode_sub_a)
+    {
+        priv->mode_sub_a = cachep->modeSubA;
+        update_occurred = 1;
+    }
 
-        if (cachep->modeMainA != mode_main_a)
-        {
-            mode_main_a = cachep->modeMainA;
-            update_occurred = 1;
-        }
+    if (cachep->modeSubB != priv->mode_sub_b)
+    {
+        priv->mode_sub_b = cachep->modeSubB;
+        update_occurred = 1;
+    }
 
-        if (cachep->modeMainB != mode_main_b)
-        {
-            mode_main_b = cachep->modeMainB;
-            update_occurred = 1;
-        }
+    if (cachep->modeSubC != priv->mode_sub_c)
+    {
+        priv->mode_sub_c = cachep->modeSubC;
+        update_occurred = 1;
+    }
 
-        if (cachep->modeMainC != mode_main_c)
-        {
-            mode_main_c = cachep->modeMainC;
-            update_occurred = 1;
-        }
+    if (cachep->widthMainA != priv->width_main_a)
+    {
+        priv->width_main_a = cachep->widthMainA;
+        update_occurred = 1;
+    }
 
-        if (cachep->modeSubA != mode_sub_a)
-        {
-            mode_sub_a = cachep->modeSubA;
-            update_occurred = 1;
-        }
+    if (cachep->widthMainB != priv->width_main_b)
+    {
+        priv->width_main_b = cachep->widthMainB;
+        update_occurred = 1;
+    }
 
-        if (cachep->modeSubB != mode_sub_b)
-        {
-            mode_sub_b = cachep->modeSubB;
-            update_occurred = 1;
-        }
+    if (cachep->widthMainC != priv->width_main_c)
+    {
+        priv->width_main_c = cachep->widthMainC;
+        update_occurred = 1;
+    }
 
-        if (cachep->modeSubC != mode_sub_c)
-        {
-            mode_sub_c = cachep->modeSubC;
-            update_occurred = 1;
-        }
+    if (cachep->widthSubA != priv->width_sub_a)
+    {
+        priv->width_sub_a = cachep->widthSubA;
+        update_occurred = 1;
+    }
 
-        if (cachep->widthMainA != width_main_a)
-        {
-            width_main_a = cachep->widthMainA;
-            update_occurred = 1;
-        }
+    if (cachep->widthSubB != priv->width_sub_b)
+    {
+        priv->width_sub_b = cachep->widthSubB;
+        update_occurred = 1;
+    }
 
-        if (cachep->widthMainB != width_main_b)
-        {
-            width_main_b = cachep->widthMainB;
-            update_occurred = 1;
-        }
+    if (cachep->widthSubC != priv->width_sub_c)
+    {
+        priv->width_sub_c = cachep->widthSubC;
+        update_occurred = 1;
+    }
 
-        if (cachep->widthMainC != width_main_c)
-        {
-            width_main_c = cachep->widthMainC;
-            update_occurred = 1;
-        }
+    if (update_occurred)
+    {
+        network_publish_rig_poll_data(rig);
+        priv->interval_count = 0;
+    }
+    // Publish updates every poll_interval if no changes have been detected
+    else if (++priv->interval_count >= rs->poll_interval / CHANGE_DETECTION_INTERVAL)
+    {
+        priv->interval_count = 0;
+        network_publish_rig_poll_data(rig);
+    }
+}
 
-        if (cachep->widthSubA != width_sub_a)
-        {
-            width_sub_a = cachep->widthSubA;
-            update_occurred = 1;
-        }
+// the station loop runs the change detection
+static int rig_poll_station(void *arg)
+{
+    RIG *rig = arg;
 
-        if (cachep->widthSubB != width_sub_b)
-        {
-            width_sub_b = cachep->widthSubB;
-            update_occurred = 1;
-        }
+    rig_poll_check(rig, rig->state.poll_routine_priv_data);
 
-        if (cachep->widthSubC != width_sub_c)
-        {
-            width_sub_c = cachep->widthSubC;
-            update_occurred = 1;
-        }
+    return CHANGE_DETECTION_INTERVAL;
+}
 
-        if (update_occurred)
-        {
-            network_publish_rig_poll_data(rig);
-            update_occurred = 0;
-            interval_count = 0;
-        }
+void *rig_poll_routine(void *arg)
+{
+    rig_poll_routine_args *args = (rig_poll_routine_args *)arg;
+    RIG *rig = args->rig;
+    struct rig_state *rs = &rig->state;
+    rig_poll_routine_priv_data *priv = rs->poll_routine_priv_data;
 
-        hl_usleep(change_detection_interval * 1000);
-        interval_count++;
+    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting rig poll routine thread\n",
+              __FILE__, __LINE__);
 
-        // Publish updates every poll_interval if no changes have been detected
-        if (interval_count >= (rs->poll_interval / change_detection_interval))
-        {
-            interval_count = 0;
-            network_publish_rig_poll_data(rig);
-        }
+    while (rs->poll_routine_thread_run)
+    {
+        rig_poll_check(rig, priv);
+        hl_usleep(CHANGE_DETECTION_INTERVAL * 1000);
     }
 
     network_publish_rig_poll_data(rig);
@@ -296,6 +308,26 @@ int rig_poll_routine_start(RIG *rig)
 
     poll_routine_priv = (rig_poll_routine_priv_data *) rs->poll_routine_priv_data;
     poll_routine_priv->args.rig = rig;
+    poll_routine_priv->vfo = RIG_VFO_NONE;
+    poll_routine_priv->tx_vfo = RIG_VFO_NONE;
+
+    // Rig cache time should be equal to rig poll interval (should be set automatically by rigctld at least)
+    // unless the cache timeouts adapt to the port load by themselves
+    if (!rs->cache_adaptive)
+    {
+        rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, rs->poll_interval);
+    }
+
+    network_publish_rig_poll_data(rig);
+
+    poll_routine_priv->source = station_add(rs->station, -1, NULL,
+                                            rig_poll_station, rig, CHANGE_DETECTION_INTERVAL);
+
+    if (poll_routine_priv->source)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
     int err = pthread_create(&poll_routine_priv->thread_id, NULL,
                              rig_poll_routine, &poll_routine_priv->args);
 
@@ -340,6 +372,12 @@ int rig_poll_routine_stop(RIG *rig)
 
     poll_routine_priv = (rig_poll_routine_priv_data *) rs->poll_routine_priv_data;
 
+    if (poll_routine_priv->source)
+    {
+        station_remove(rs->station, poll_routine_priv->source);
+        poll_routine_priv->source = NULL;
+    }
+
     if (poll_routine_priv->thread_id != 0)
     {
         int err = pthread_join(poll_routine_priv->thread_id, NULL);
@@ -634,15 +672,16 @@ int rig_fire_freq_event(RIG *rig, vfo_t vfo, freq_t freq)
 
     double e = elapsed_ms(&rig->state.freq_event_elapsed, HAMLIB_ELAPSED_GET);
 
-    if (e >= 250) // throttle events to 4 per sec
+    if (e >= 250) // throttle multicast publishing to 4 per sec
     {
         elapsed_ms(&rig->state.freq_event_elapsed, HAMLIB_ELAPSED_SET);
         network_publish_rig_transceive_data(rig);
+    }
 
-        if (rig->callbacks.freq_event)
-        {
-            rig->callbacks.freq_event(rig, vfo, freq, rig->callbacks.freq_arg);
-        }
+    // the callback gets every change, a throttled one could be the last
+    if (rig->callbacks.freq_event)
+    {
+        rig->callbacks.freq_event(rig, vfo, freq, rig->callbacks.freq_arg);
     }
 
     RETURNFUNC(0);
@@ -841,6 +880,7 @@ int rig_fire_spectrum_event(RIG *rig, struct rig_spectrum_line *line)
     }
 
     network_publish_rig_spectrum_data(rig, line);
+    rig_spectrum_dispatch(rig, line);
 
     if (rig->callbacks.spectrum_event)
     {
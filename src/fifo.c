@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include "fifo.h"
+#include "misc.h"
 #include "config.h"
 
 void initFIFO(FIFO_RIG *fifo)
@@ -11,14 +12,31 @@ void initFIFO(FIFO_RIG *fifo)
 #ifdef _PTHREAD_H
     static pthread_mutex_t t = PTHREAD_MUTEX_INITIALIZER;
     fifo->mutex = t;
+    pthread_cond_init(&fifo->cond, NULL);
+#endif
+}
+
+// releases what initFIFO set up, before the fifo is freed
+void cleanupFIFO(FIFO_RIG *fifo)
+{
+#ifdef _PTHREAD_H
+    pthread_cond_destroy(&fifo->cond);
+    pthread_mutex_destroy(&fifo->mutex);
 #endif
 }
 
 void resetFIFO(FIFO_RIG *fifo)
 {
     rig_debug(RIG_DEBUG_TRACE, "%s: fifo flushed\n", __func__);
+#ifdef _PTHREAD_H
+    pthread_mutex_lock(&fifo->mutex);
+#endif
     fifo->head = fifo->tail;
     fifo->flush = 1;
+#ifdef _PTHREAD_H
+    pthread_cond_broadcast(&fifo->cond);
+    pthread_mutex_unlock(&fifo->mutex);
+#endif
 }
 
 // returns RIG_OK if added
@@ -52,30 +70,154 @@ int push(FIFO_RIG *fifo, const char *msg)
             rig_debug(RIG_DEBUG_VERBOSE, "%s: push 0x%02x (%d,%d)\n", __func__, msg[i],
                       fifo->head, fifo->tail);
 
-        if (fifo->tail + 1 == fifo->head) { return -RIG_EDOM; }
+        if ((fifo->tail + 1) % HAMLIB_FIFO_SIZE == fifo->head)
+        {
+#ifdef _PTHREAD_H
+            pthread_cond_broadcast(&fifo->cond);
+            pthread_mutex_unlock(&fifo->mutex);
+#endif
+            return -RIG_EDOM;
+        }
 
         fifo->tail = (fifo->tail + 1) % HAMLIB_FIFO_SIZE;
     }
 
 #ifdef _PTHREAD_H
+    pthread_cond_broadcast(&fifo->cond);
     pthread_mutex_unlock(&fifo->mutex);
 #endif
     return RIG_OK;
 }
 
-int peek(FIFO_RIG *fifo)
+// the number of chars queued, the caller holds the mutex
+static int fifo_queued(const FIFO_RIG *fifo)
 {
-    if (fifo == NULL) { return -1; }
+    return (fifo->tail - fifo->head + HAMLIB_FIFO_SIZE) % HAMLIB_FIFO_SIZE;
+}
 
-    if (fifo->tail < 0 || fifo->head < 0) { return -1; }
+// returns the number of chars queued
+int fifo_count(FIFO_RIG *fifo)
+{
+    int count;
 
-    if (fifo->tail > 1023 || fifo->head > 1023) { return -1; }
+#ifdef _PTHREAD_H
+    pthread_mutex_lock(&fifo->mutex);
+#endif
+    count = fifo_queued(fifo);
+#ifdef _PTHREAD_H
+    pthread_mutex_unlock(&fifo->mutex);
+#endif
+    return count;
+}
 
-    if (fifo->tail == fifo->head) { return -1; }
+// returns 1 if resetFIFO was called since the flag was last cleared
+// clears the flag when clear is set
+int fifo_flushed(FIFO_RIG *fifo, int clear)
+{
+    int flush;
 
 #ifdef _PTHREAD_H
     pthread_mutex_lock(&fifo->mutex);
 #endif
+    flush = fifo->flush;
+
+    if (clear)
+    {
+        fifo->flush = 0;
+    }
+
+#ifdef _PTHREAD_H
+    pthread_mutex_unlock(&fifo->mutex);
+#endif
+    return flush;
+}
+
+#ifdef _PTHREAD_H
+static void fifo_timedwait(FIFO_RIG *fifo, int timeout_ms)
+{
+    struct timespec until;
+
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += timeout_ms / 1000;
+    until.tv_nsec += (timeout_ms % 1000) * 1000000L;
+
+    if (until.tv_nsec >= 1000000000L)
+    {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+
+    pthread_cond_timedwait(&fifo->cond, &fifo->mutex, &until);
+}
+#endif
+
+// waits up to timeout_ms for a push, a flush or fifo_wake
+// returns the number of chars queued, without waiting if there are any
+int fifo_wait(FIFO_RIG *fifo, int timeout_ms)
+{
+#ifdef _PTHREAD_H
+    int count;
+
+    pthread_mutex_lock(&fifo->mutex);
+
+    if (fifo_queued(fifo) == 0 && !fifo->flush)
+    {
+        fifo_timedwait(fifo, timeout_ms);
+    }
+
+    count = fifo_queued(fifo);
+    pthread_mutex_unlock(&fifo->mutex);
+
+    return count;
+#else
+    hl_usleep(timeout_ms * 1000);
+    return fifo_count(fifo);
+#endif
+}
+
+// sleeps up to timeout_ms, less if the fifo is flushed or fifo_wake is called
+void fifo_sleep(FIFO_RIG *fifo, int timeout_ms)
+{
+#ifdef _PTHREAD_H
+    pthread_mutex_lock(&fifo->mutex);
+
+    if (!fifo->flush)
+    {
+        fifo_timedwait(fifo, timeout_ms);
+    }
+
+    pthread_mutex_unlock(&fifo->mutex);
+#else
+    hl_usleep(timeout_ms * 1000);
+#endif
+}
+
+void fifo_wake(FIFO_RIG *fifo)
+{
+#ifdef _PTHREAD_H
+    pthread_mutex_lock(&fifo->mutex);
+    pthread_cond_broadcast(&fifo->cond);
+    pthread_mutex_unlock(&fifo->mutex);
+#endif
+}
+
+int peek(FIFO_RIG *fifo)
+{
+    if (fifo == NULL) { return -1; }
+
+#ifdef _PTHREAD_H
+    pthread_mutex_lock(&fifo->mutex);
+#endif
+
+    if (fifo->tail < 0 || fifo->head < 0 || fifo->tail > 1023 || fifo->head > 1023
+            || fifo->tail == fifo->head)
+    {
+#ifdef _PTHREAD_H
+        pthread_mutex_unlock(&fifo->mutex);
+#endif
+        return -1;
+    }
+
     char c = fifo->data[fifo->head];
 
 #if 0
@@ -97,11 +239,18 @@ int peek(FIFO_RIG *fifo)
 
 int pop(FIFO_RIG *fifo)
 {
-    if (fifo->tail == fifo->head) { return -1; }
-
 #ifdef _PTHREAD_H
     pthread_mutex_lock(&fifo->mutex);
 #endif
+
+    if (fifo->tail == fifo->head)
+    {
+#ifdef _PTHREAD_H
+        pthread_mutex_unlock(&fifo->mutex);
+#endif
+        return -1;
+    }
+
     char c = fifo->data[fifo->head];
 #if 0
 
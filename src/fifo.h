@@ -1,5 +1,11 @@
 void initFIFO(FIFO_RIG *fifo);
+void cleanupFIFO(FIFO_RIG *fifo);
 void resetFIFO(FIFO_RIG *fifo);
 int push(FIFO_RIG *fifo, const char *msg);
 int pop(FIFO_RIG *fifo);
 int peek(FIFO_RIG *fifo);
+int fifo_count(FIFO_RIG *fifo);
+int fifo_flushed(FIFO_RIG *fifo, int clear);
+int fifo_wait(FIFO_RIG *fifo, int timeout_ms);
+void fifo_sleep(FIFO_RIG *fifo, int timeout_ms);
+void fifo_wake(FIFO_RIG *fifo);
@@ -52,6 +52,8 @@
 #include "network.h"
 #include "cm108.h"
 #include "asyncpipe.h"
+#include "trace.h"
+#include "cache.h"
 
 #define HAMLIB_TRACE2 rig_debug(RIG_DEBUG_TRACE,"%s trace(%d)\n",  __FILE__, __LINE__)
 
@@ -347,6 +349,7 @@ int HAMLIB_API port_open(hamlib_port_t *p)
 
     case RIG_PORT_NONE:
     case RIG_PORT_RPC:
+    case RIG_PORT_REPLAY:   /* trace attached by rig_open */
         break;  /* ez :) */
 
     case RIG_PORT_NETWORK:
@@ -381,6 +384,8 @@ int HAMLIB_API port_close(hamlib_port_t *p, rig_port_t port_type)
 {
     int ret = RIG_OK;
 
+    port_trace_stop(p);
+
     if (p->fd != -1)
     {
         switch (port_type)
@@ -1050,8 +1055,16 @@ int HAMLIB_API port_flush_sync_pipes(hamlib_port_t *p)
 int HAMLIB_API write_block(hamlib_port_t *p, const unsigned char *txbuffer,
                            size_t count)
 {
+    struct timespec busy;
     int ret;
 
+    if (p->type.rig == RIG_PORT_REPLAY)
+    {
+        return port_trace_replay_write(p, txbuffer, count);
+    }
+
+    port_busy_begin(&busy);
+
     if (p->fd < 0)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: port not open\n", __func__);
@@ -1127,6 +1140,7 @@ int HAMLIB_API write_block(hamlib_port_t *p, const unsigned char *txbuffer,
     rig_debug(RIG_DEBUG_TRACE, "%s(): TX %d bytes\n", __func__,
               (int)count);
     dump_hex((unsigned char *) txbuffer, count);
+    port_trace_record(p, PORT_TRACE_WRITE, txbuffer, count);
 
     if (p->post_write_delay > 0)
     {
@@ -1150,9 +1164,19 @@ int HAMLIB_API write_block(hamlib_port_t *p, const unsigned char *txbuffer,
         /* with sequential fast writes*/
     }
 
+    port_busy_end(p, &busy);
+
     return RIG_OK;
 }
 
+/* Log a completed read to the port trace, if one is being recorded */
+static int trace_read(hamlib_port_t *p, const unsigned char *rxbuffer, int ret)
+{
+    port_trace_record(p, ret < 0 ? PORT_TRACE_ERROR : PORT_TRACE_READ, rxbuffer,
+                      ret);
+    return ret;
+}
+
 static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
                               size_t count, int direct)
 {
@@ -1166,6 +1190,11 @@ static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
         return -RIG_EINTERNAL;
     }
 
+    if (p->type.rig == RIG_PORT_REPLAY)
+    {
+        return port_trace_replay_read(p, rxbuffer, count);
+    }
+
     /* Store the time of the read loop start */
     gettimeofday(&start_time, NULL);
 
@@ -1271,7 +1300,14 @@ static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
 int HAMLIB_API read_block(hamlib_port_t *p, unsigned char *rxbuffer,
                           size_t count)
 {
-    return read_block_generic(p, rxbuffer, count, !p->asyncio);
+    struct timespec busy;
+    int ret;
+
+    port_busy_begin(&busy);
+    ret = read_block_generic(p, rxbuffer, count, !p->asyncio);
+    port_busy_end(p, &busy);
+
+    return trace_read(p, rxbuffer, ret);
 }
 
 /**
@@ -1295,7 +1331,21 @@ int HAMLIB_API read_block(hamlib_port_t *p, unsigned char *rxbuffer,
 int HAMLIB_API read_block_direct(hamlib_port_t *p, unsigned char *rxbuffer,
                                  size_t count)
 {
-    return read_block_generic(p, rxbuffer, count, 1);
+    struct timespec busy;
+    int ret;
+
+    port_busy_begin(&busy);
+    ret = read_block_generic(p, rxbuffer, count, 1);
+
+    /* in async mode only the synchronous stream is recorded */
+    if (p->asyncio)
+    {
+        return ret;
+    }
+
+    port_busy_end(p, &busy);
+
+    return trace_read(p, rxbuffer, ret);
 }
 
 static int read_string_generic(hamlib_port_t *p,
@@ -1334,6 +1384,18 @@ static int read_string_generic(hamlib_port_t *p,
         return 0;
     }
 
+    if (p->type.rig == RIG_PORT_REPLAY)
+    {
+        total_count = port_trace_replay_read(p, rxbuffer, rxmax - 1);
+
+        if (total_count >= 0)
+        {
+            rxbuffer[total_count] = '\0';
+        }
+
+        return total_count;
+    }
+
     /* Store the time of the read loop start */
     gettimeofday(&start_time, NULL);
 
@@ -1420,7 +1482,7 @@ shortcut:
 //            rig_debug(RIG_DEBUG_VERBOSE, "%s: read %d bytes tot=%d\n", __func__, (int)rd_count, total_count);
             minlen -= rd_count;
 
-            if (errno == EAGAIN)
+            if (rd_count < 0 && errno == EAGAIN)
             {
                 hl_usleep(5 * 1000);
 //                rig_debug(RIG_DEBUG_WARN, "%s: port_read is busy? direct=%d\n", __func__,
@@ -1546,8 +1608,16 @@ int HAMLIB_API read_string(hamlib_port_t *p,
                            int flush_flag,
                            int expected_len)
 {
-    return read_string_generic(p, rxbuffer, rxmax, stopset, stopset_len, flush_flag,
-                               expected_len, !p->asyncio);
+    struct timespec busy;
+    int ret;
+
+    port_busy_begin(&busy);
+    ret = read_string_generic(p, rxbuffer, rxmax, stopset, stopset_len,
+                              flush_flag, expected_len, !p->asyncio);
+    port_busy_end(p, &busy);
+
+    /* flushing reads are not part of the protocol exchange */
+    return flush_flag ? ret : trace_read(p, rxbuffer, ret);
 }
 
 
@@ -1585,8 +1655,22 @@ int HAMLIB_API read_string_direct(hamlib_port_t *p,
                                   int flush_flag,
                                   int expected_len)
 {
-    return read_string_generic(p, rxbuffer, rxmax, stopset, stopset_len, flush_flag,
-                               expected_len, 1);
+    struct timespec busy;
+    int ret;
+
+    port_busy_begin(&busy);
+    ret = read_string_generic(p, rxbuffer, rxmax, stopset, stopset_len,
+                              flush_flag, expected_len, 1);
+
+    /* in async mode only the synchronous stream is recorded */
+    if (p->asyncio)
+    {
+        return ret;
+    }
+
+    port_busy_end(p, &busy);
+
+    return flush_flag ? ret : trace_read(p, rxbuffer, ret);
 }
 
 /** @} */
@@ -0,0 +1,944 @@
+/*
+ *  Hamlib Interface - software CW keyer
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file keyer.c
+ * \brief Software CW keyer
+ *
+ * Radios without a CAT keyer are keyed through their key jack from a
+ * serial DTR or RTS line, a GPIO pin or a CM108 GPIO, the lines Hamlib
+ * already drives for PTT.  The text is turned into a timeline of key down
+ * and key up intervals with the weighting, Farnsworth spacing and speed
+ * changes asked for, and a thread per rig sets the line at each edge.
+ * The edges are timed against absolute deadlines on the monotonic clock,
+ * so a late wakeup delays one edge but does not shift the rest of the
+ * message, and the thread asks for a real-time priority.  How late each
+ * edge was set is counted for rig_get_keyer_stats().
+ *
+ * The keyer is used by rig_send_morse(), rig_stop_morse() and
+ * rig_wait_morse() when the keyer_type configuration token names a line
+ * or a callback is set with rig_set_keyer_callback() before rig_open().
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "keyer.h"
+#include "fifo.h"
+#include "misc.h"
+#include "serial.h"
+#include "cm108.h"
+#include "gpio.h"
+
+//! @cond Doxygen_Suppress
+/* the longest character is 7 elements, each with its space, then a space */
+#define KEYER_CHAR_ELEMENTS 16
+
+/* longest sleep between checks of rig_stop_morse() */
+#define KEYER_SLICE_US 10000
+
+/* an edge set later than this after its deadline is counted late */
+#define KEYER_LATE_US 1000
+
+struct keyer_priv
+{
+    rig_keyer_cb_t cb;
+    rig_ptr_t cb_arg;
+    hamlib_keyer_stats_t stats;
+    double late_total_us;
+    hamlib_port_t line;
+    int line_shared;            /* the line is on the rig port, not closed here */
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_t mutex;
+    pthread_cond_t idle;        /* nothing queued and the last space is over */
+    pthread_t thread_id;
+    int running;
+    int stop;
+    int busy;
+    FIFO_RIG fifo;
+#endif
+};
+
+/* appends intervals to a timeline, merging those of the same key */
+struct keyer_builder
+{
+    rig_keyer_element_t *elements;
+    int max;
+    int n;
+    int last_key;
+};
+
+#if defined(HAVE_PTHREAD)
+static pthread_mutex_t keyer_create_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+static struct keyer_priv *keyer_priv(RIG *rig)
+{
+    struct keyer_priv *priv;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&keyer_create_mutex);
+#endif
+
+    priv = rig->state.keyer_priv_data;
+
+    if (!priv)
+    {
+        priv = calloc(1, sizeof(*priv));
+
+        if (priv)
+        {
+            priv->line.fd = -1;
+#if defined(HAVE_PTHREAD)
+            pthread_mutex_init(&priv->mutex, NULL);
+            pthread_cond_init(&priv->idle, NULL);
+            initFIFO(&priv->fifo);
+#endif
+            rig->state.keyer_priv_data = priv;
+        }
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&keyer_create_mutex);
+#endif
+
+    return priv;
+}
+
+
+static int keyer_params_valid(const rig_keyer_params_t *p)
+{
+    return p->wpm >= 5 && p->wpm <= 99 && p->farnsworth_wpm >= 0
+           && p->weight >= 10 && p->weight <= 90;
+}
+
+
+static void keyer_add(struct keyer_builder *b, int key, double us)
+{
+    if (us < 0.5)
+    {
+        return;
+    }
+
+    if (b->n > 0 && b->last_key == key)
+    {
+        if (b->elements && b->n <= b->max)
+        {
+            b->elements[b->n - 1].duration_us += (int)(us + 0.5);
+        }
+
+        return;
+    }
+
+    if (b->elements && b->n < b->max)
+    {
+        b->elements[b->n].key = key;
+        b->elements[b->n].duration_us = (int)(us + 0.5);
+    }
+
+    b->n++;
+    b->last_key = key;
+}
+
+
+/*
+ * Appends the intervals of one character, ending with the space after it.
+ * '>' and '<' send nothing and change the speed by 5 WPM for the rest of
+ * the text.
+ */
+static void keyer_char(struct keyer_builder *b, int c, rig_keyer_params_t *p)
+{
+    /* a dot is 1.2 s / WPM, from PARIS being 50 dots long */
+    double unit = 1200000.0 / p->wpm;
+    double gap = unit;
+    double weight = unit * (p->weight - 50) / 50.0;
+    const char *code;
+
+    if (c == '>' || c == '<')
+    {
+        p->wpm += c == '>' ? 5 : -5;
+        p->wpm = p->wpm < 5 ? 5 : p->wpm > 99 ? 99 : p->wpm;
+        return;
+    }
+
+    /* Farnsworth: the elements at wpm, the spaces between characters and
+       words stretched to bring PARIS down to farnsworth_wpm, as in the
+       ARRL code practice timing */
+    if (p->farnsworth_wpm > 0 && p->farnsworth_wpm < p->wpm)
+    {
+        gap = 1000000.0 * (60.0 * p->wpm - 37.2 * p->farnsworth_wpm)
+              / (p->farnsworth_wpm * p->wpm) / 19.0;
+    }
+
+    if (c == ' ')
+    {
+        /* the 3 after the last character make the 7 between words */
+        keyer_add(b, 0, 4 * gap);
+        return;
+    }
+
+    code = morse_code_char(c);
+
+    if (code == NULL)
+    {
+        return;
+    }
+
+    for (; *code; code++)
+    {
+        keyer_add(b, 1, (*code == '-' ? 3 : 1) * unit + weight);
+        keyer_add(b, 0, (code[1] ? unit : 3 * gap) - weight);
+    }
+}
+
+
+#if defined(HAVE_PTHREAD)
+static double keyer_us_until(const struct timespec *deadline)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (deadline->tv_sec - now.tv_sec) * 1e6
+           + (deadline->tv_nsec - now.tv_nsec) / 1e3;
+}
+
+
+static void keyer_timespec_add_us(struct timespec *t, double us)
+{
+    long long ns = t->tv_nsec + (long long)(us * 1000.0);
+
+    t->tv_sec += ns / 1000000000LL;
+    t->tv_nsec = ns % 1000000000LL;
+}
+
+
+/* sleeps until the deadline, returns -1 at once on rig_stop_morse()
+   each slice ends at an absolute time no later than the deadline, so a
+   long wait does not overshoot it */
+static int keyer_sleep_until(struct keyer_priv *priv,
+                             const struct timespec *deadline)
+{
+    for (;;)
+    {
+        double us;
+
+        if (fifo_flushed(&priv->fifo, 0))
+        {
+            return -1;
+        }
+
+        us = keyer_us_until(deadline);
+
+        if (us <= 0)
+        {
+            return 0;
+        }
+
+#if defined(HAVE_CLOCK_NANOSLEEP) && defined(TIMER_ABSTIME)
+
+        if (us > KEYER_SLICE_US)
+        {
+            struct timespec slice;
+
+            clock_gettime(CLOCK_MONOTONIC, &slice);
+            keyer_timespec_add_us(&slice, KEYER_SLICE_US);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &slice, NULL);
+        }
+        else
+        {
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL);
+        }
+
+#else
+        hl_usleep(us > KEYER_SLICE_US ? KEYER_SLICE_US : (rig_useconds_t) us);
+#endif
+    }
+}
+#endif
+
+
+static int keyer_line_set(RIG *rig, struct keyer_priv *priv, int key)
+{
+    hamlib_port_t *line = &priv->line;
+
+    switch (rig->state.keyer_type)
+    {
+    case RIG_PTT_SERIAL_DTR:
+        return ser_set_dtr(line, key);
+
+    case RIG_PTT_SERIAL_RTS:
+        return ser_set_rts(line, key);
+
+    case RIG_PTT_CM108:
+        return cm108_ptt_set(line, key ? RIG_PTT_ON : RIG_PTT_OFF);
+
+    case RIG_PTT_GPIO:
+    case RIG_PTT_GPION:
+        return gpio_ptt_set(line, key ? RIG_PTT_ON : RIG_PTT_OFF);
+
+    default:
+        return RIG_OK;
+    }
+}
+
+
+#if defined(HAVE_PTHREAD)
+/* sets the line at an edge and counts how late after its deadline */
+static void keyer_edge(RIG *rig, struct keyer_priv *priv, int key,
+                       const struct timespec *deadline)
+{
+    rig_keyer_cb_t cb;
+    rig_ptr_t cb_arg;
+    double late_us;
+    int retval;
+
+    retval = keyer_line_set(rig, priv, key);
+    late_us = -keyer_us_until(deadline);
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: keyer line %d failed: %s\n", __func__, key,
+                  rigerror(retval));
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+    late_us = late_us > 0 ? late_us : 0;
+    priv->stats.edges++;
+    priv->late_total_us += late_us;
+    priv->stats.mean_us = priv->late_total_us / priv->stats.edges;
+
+    if (late_us > priv->stats.max_us)
+    {
+        priv->stats.max_us = late_us;
+    }
+
+    if (late_us > KEYER_LATE_US)
+    {
+        priv->stats.late++;
+    }
+
+    cb = priv->cb;
+    cb_arg = priv->cb_arg;
+    pthread_mutex_unlock(&priv->mutex);
+
+    if (cb)
+    {
+        cb(rig, key, cb_arg);
+    }
+}
+
+
+static void keyer_params_get(RIG *rig, rig_keyer_params_t *params)
+{
+    params->wpm = rig->state.keyer_wpm;
+    params->farnsworth_wpm = rig->state.keyer_farnsworth_wpm;
+    params->weight = rig->state.keyer_weight;
+
+    if (!keyer_params_valid(params))
+    {
+        params->wpm = 25;
+        params->farnsworth_wpm = 0;
+        params->weight = 50;
+    }
+}
+
+
+static void *keyer_thread(void *arg)
+{
+    RIG *rig = (RIG *)arg;
+    struct keyer_priv *priv = rig->state.keyer_priv_data;
+    rig_keyer_params_t params;
+    struct timespec deadline;
+    int idle = 1;
+    int key = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    for (;;)
+    {
+        rig_keyer_element_t elements[KEYER_CHAR_ELEMENTS];
+        struct keyer_builder b;
+        int stop;
+        int c, i;
+
+        pthread_mutex_lock(&priv->mutex);
+        stop = priv->stop;
+        pthread_mutex_unlock(&priv->mutex);
+
+        if (stop)
+        {
+            break;
+        }
+
+        if (fifo_flushed(&priv->fifo, 1))
+        {
+            /* rig_stop_morse(): key up now and drop the timeline */
+            if (key)
+            {
+                key = 0;
+                clock_gettime(CLOCK_MONOTONIC, &deadline);
+                keyer_edge(rig, priv, key, &deadline);
+            }
+
+            idle = 1;
+            continue;
+        }
+
+        c = pop(&priv->fifo);
+
+        if (c < 0)
+        {
+            double us = keyer_us_until(&deadline);
+
+            /* text queued before the space after the last character is
+               over is keyed on the same timeline */
+            if (us > 0)
+            {
+                fifo_wait(&priv->fifo, (int)(us / 1000) + 1);
+                continue;
+            }
+
+            /* rig_keyer_send() queues under the mutex */
+            pthread_mutex_lock(&priv->mutex);
+
+            if (fifo_count(&priv->fifo) == 0)
+            {
+                priv->busy = 0;
+                pthread_cond_broadcast(&priv->idle);
+            }
+
+            pthread_mutex_unlock(&priv->mutex);
+            idle = 1;
+            fifo_wait(&priv->fifo, 1000);
+            continue;
+        }
+
+        /* a message starts now, a character queued in time follows the
+           last one on the same timeline */
+        if (idle)
+        {
+            /* speed changes in the text last to the end of the message */
+            keyer_params_get(rig, &params);
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            idle = 0;
+        }
+
+        memset(&b, 0, sizeof(b));
+        b.elements = elements;
+        b.max = KEYER_CHAR_ELEMENTS;
+        b.last_key = key;
+        keyer_char(&b, c, &params);
+
+        for (i = 0; i < b.n && i < KEYER_CHAR_ELEMENTS; i++)
+        {
+            if (elements[i].key != key)
+            {
+                if (keyer_sleep_until(priv, &deadline) < 0)
+                {
+                    break;
+                }
+
+                key = elements[i].key;
+                keyer_edge(rig, priv, key, &deadline);
+            }
+
+            keyer_timespec_add_us(&deadline, elements[i].duration_us);
+        }
+    }
+
+    if (key)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        keyer_edge(rig, priv, 0, &deadline);
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+    priv->busy = 0;
+    pthread_cond_broadcast(&priv->idle);
+    pthread_mutex_unlock(&priv->mutex);
+
+    return NULL;
+}
+#endif
+
+
+static int keyer_line_open(RIG *rig, struct keyer_priv *priv)
+{
+    struct rig_state *rs = &rig->state;
+    hamlib_port_t *rp = RIGPORT(rig);
+    hamlib_port_t *line = &priv->line;
+    const char *pathname = rs->keyer_pathname ? rs->keyer_pathname : "";
+
+    memset(line, 0, sizeof(*line));
+    line->fd = -1;
+    line->type.ptt = rs->keyer_type;
+    strncpy(line->pathname, pathname, HAMLIB_FILPATHLEN - 1);
+    priv->line_shared = 0;
+
+    switch (rs->keyer_type)
+    {
+    case RIG_PTT_NONE:
+        return RIG_OK;
+
+    case RIG_PTT_SERIAL_DTR:
+    case RIG_PTT_SERIAL_RTS:
+
+        /* keying DTR or RTS of the CAT port is the usual wiring */
+        if (pathname[0] == '\0' || !strcmp(pathname, rp->pathname))
+        {
+            if (rp->type.rig != RIG_PORT_SERIAL || rp->fd < 0)
+            {
+                rig_debug(RIG_DEBUG_ERR,
+                          "%s: keyer on the rig port needs a serial port, set keyer_pathname\n",
+                          __func__);
+                return -RIG_ECONF;
+            }
+
+            line->fd = rp->fd;
+            priv->line_shared = 1;
+        }
+        else
+        {
+            line->fd = ser_open(line);
+        }
+
+        break;
+
+    case RIG_PTT_CM108:
+        line->parm.cm108.ptt_bitnum = rs->keyer_bitnum;
+        line->fd = cm108_open(line);
+        break;
+
+    case RIG_PTT_GPIO:
+    case RIG_PTT_GPION:
+        line->fd = gpio_open(line, 1, rs->keyer_type == RIG_PTT_GPION ? 0 : 1);
+        break;
+
+    default:
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported keyer type %d\n", __func__,
+                  rs->keyer_type);
+        return -RIG_ECONF;
+    }
+
+    if (line->fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot open keyer line \"%s\"\n", __func__,
+                  line->pathname);
+        line->fd = -1;
+        return -RIG_EIO;
+    }
+
+    return keyer_line_set(rig, priv, 0);
+}
+
+
+static void keyer_line_close(RIG *rig, struct keyer_priv *priv)
+{
+    hamlib_port_t *line = &priv->line;
+
+    if (line->fd < 0)
+    {
+        return;
+    }
+
+    keyer_line_set(rig, priv, 0);
+
+    if (!priv->line_shared)
+    {
+        switch (rig->state.keyer_type)
+        {
+        case RIG_PTT_SERIAL_DTR:
+        case RIG_PTT_SERIAL_RTS:
+            ser_close(line);
+            break;
+
+        case RIG_PTT_CM108:
+            cm108_close(line);
+            break;
+
+        case RIG_PTT_GPIO:
+        case RIG_PTT_GPION:
+            gpio_close(line);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    line->fd = -1;
+}
+
+
+int rig_keyer_start(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    struct keyer_priv *priv = rig->state.keyer_priv_data;
+    int retval;
+    int err = -1;
+
+    if (rig->state.keyer_type == RIG_PTT_NONE && (!priv || !priv->cb))
+    {
+        return RIG_OK;
+    }
+
+    priv = keyer_priv(rig);
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    if (priv->running)
+    {
+        return RIG_OK;
+    }
+
+    retval = keyer_line_open(rig, priv);
+
+    if (retval != RIG_OK)
+    {
+        keyer_line_close(rig, priv);
+        return retval;
+    }
+
+    resetFIFO(&priv->fifo);
+    fifo_flushed(&priv->fifo, 1);
+    priv->stop = 0;
+    priv->busy = 0;
+    priv->stats.realtime = 0;
+
+#if defined(SCHED_FIFO)
+    {
+        pthread_attr_t attr;
+        struct sched_param param;
+
+        /* needs CAP_SYS_NICE or an rtprio limit, else the thread runs at
+           the normal priority */
+        pthread_attr_init(&attr);
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = sched_get_priority_max(SCHED_FIFO) / 2;
+        pthread_attr_setschedparam(&attr, &param);
+        err = pthread_create(&priv->thread_id, &attr, keyer_thread, rig);
+        pthread_attr_destroy(&attr);
+        priv->stats.realtime = err == 0;
+    }
+#endif
+
+    if (err != 0)
+    {
+        err = pthread_create(&priv->thread_id, NULL, keyer_thread, rig);
+    }
+
+    if (err != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create failed: %s\n", __func__,
+                  strerror(err));
+        keyer_line_close(rig, priv);
+        return -RIG_EINTERNAL;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: keyer started%s\n", __func__,
+              priv->stats.realtime ? " at real-time priority" : "");
+    priv->running = 1;
+#endif
+
+    return RIG_OK;
+}
+
+
+int rig_keyer_is_active(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    const struct keyer_priv *priv = rig->state.keyer_priv_data;
+
+    return priv && priv->running;
+#else
+    return 0;
+#endif
+}
+
+
+int rig_keyer_send(RIG *rig, const char *msg)
+{
+#if defined(HAVE_PTHREAD)
+    struct keyer_priv *priv = rig->state.keyer_priv_data;
+    int retval;
+
+    if (!priv || !priv->running)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+    retval = push(&priv->fifo, msg);
+    priv->busy = 1;
+    pthread_mutex_unlock(&priv->mutex);
+
+    return retval;
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+int rig_keyer_abort(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    struct keyer_priv *priv = rig->state.keyer_priv_data;
+
+    if (!priv || !priv->running)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    resetFIFO(&priv->fifo);
+#endif
+
+    return RIG_OK;
+}
+
+
+int rig_keyer_wait(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    struct keyer_priv *priv = rig->state.keyer_priv_data;
+
+    if (!priv || !priv->running)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+
+    while (priv->running && priv->busy)
+    {
+        pthread_cond_wait(&priv->idle, &priv->mutex);
+    }
+
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+
+    return RIG_OK;
+}
+
+
+/* stops keying at once, what is still queued is dropped */
+void rig_keyer_stop(RIG *rig)
+{
+#if defined(HAVE_PTHREAD)
+    struct keyer_priv *priv = rig->state.keyer_priv_data;
+
+    if (!priv || !priv->running)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+    priv->stop = 1;
+    pthread_mutex_unlock(&priv->mutex);
+    resetFIFO(&priv->fifo);
+
+    pthread_join(priv->thread_id, NULL);
+
+    pthread_mutex_lock(&priv->mutex);
+    priv->running = 0;
+    pthread_cond_broadcast(&priv->idle);
+    pthread_mutex_unlock(&priv->mutex);
+
+    keyer_line_close(rig, priv);
+#endif
+}
+
+
+void rig_keyer_cleanup(RIG *rig)
+{
+    struct keyer_priv *priv = rig->state.keyer_priv_data;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    rig_keyer_stop(rig);
+#if defined(HAVE_PTHREAD)
+    pthread_cond_destroy(&priv->fifo.cond);
+    pthread_cond_destroy(&priv->idle);
+    pthread_mutex_destroy(&priv->mutex);
+#endif
+    free(priv);
+    rig->state.keyer_priv_data = NULL;
+}
+//! @endcond
+
+
+/**
+ * \brief Turn text into software keyer intervals
+ * \param text      The text to send, '>' and '<' speed up and slow down by 5 WPM
+ * \param params    Speed, Farnsworth speed and weighting
+ * \param elements  Set to the key down and key up intervals, NULL to count them
+ * \param max       Room in \a elements
+ *
+ * Each character gives a key down interval per dot or dash and the key up
+ * spaces between them, the last one the space between characters, and a
+ * space in the text makes that the space between words.  Intervals of the
+ * same key are merged.  A weight over 50 lengthens each key down by the
+ * same time its space is shortened, so the speed is unchanged.  With a
+ * Farnsworth speed below the character speed the dots and dashes stay at
+ * the character speed and the spaces between characters and words are
+ * stretched until PARIS takes as long as at the Farnsworth speed.
+ * Characters without morse code are skipped.
+ *
+ * \return The number of intervals of the whole text, which may be more
+ * than \a max with only the first \a max stored, or -RIG_EINVAL for a
+ * NULL argument or parameters out of range: 5 to 99 WPM and a weight of
+ * 10 to 90.
+ *
+ * \sa rig_send_morse(), rig_set_keyer_callback()
+ */
+int HAMLIB_API rig_keyer_timeline(const char *text,
+                                  const rig_keyer_params_t *params,
+                                  rig_keyer_element_t *elements, int max)
+{
+    struct keyer_builder b;
+    rig_keyer_params_t p;
+
+    if (!text || !params || !keyer_params_valid(params) || max < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    memset(&b, 0, sizeof(b));
+    b.elements = elements;
+    b.max = elements ? max : 0;
+    p = *params;
+
+    for (; *text; text++)
+    {
+        keyer_char(&b, (unsigned char) *text, &p);
+    }
+
+    return b.n;
+}
+
+
+/**
+ * \brief Set the callback of the software keyer
+ * \param rig   The rig handle
+ * \param cb    Called at each key down and key up, NULL for none
+ * \param arg   Passed to \a cb
+ *
+ * The callback runs on the keyer thread right after the keyer line is
+ * set, e.g. to sound a sidetone or to drive a line Hamlib has no driver
+ * for.  Set before rig_open(), a callback starts the software keyer even
+ * when keyer_type is None, and then only the callback is keyed.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value.
+ */
+int HAMLIB_API rig_set_keyer_callback(RIG *rig, rig_keyer_cb_t cb,
+                                      rig_ptr_t arg)
+{
+    struct keyer_priv *priv;
+
+    if (!rig || !rig->caps)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = keyer_priv(rig);
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+#endif
+    priv->cb = cb;
+    priv->cb_arg = arg;
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Get the software keyer timing counters
+ * \param rig   The rig handle
+ * \param stats Set to the counters
+ *
+ * An edge is counted from its deadline on the keyer timeline to the
+ * return of the call that set the line, so the time the line driver
+ * takes is included.  The counters cover the life of the rig handle.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if an argument is NULL
+ */
+int HAMLIB_API rig_get_keyer_stats(RIG *rig, hamlib_keyer_stats_t *stats)
+{
+    struct keyer_priv *priv;
+
+    if (!rig || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = rig->state.keyer_priv_data;
+
+    if (!priv)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return RIG_OK;
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+#endif
+    *stats = priv->stats;
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+
+    return RIG_OK;
+}
+
+/** @} */
@@ -418,52 +418,15 @@ int HAMLIB_API dec2dmmm(double dec, int *degrees, double *minutes, int *sw)
 }
 
 
-/**
- * \brief Convert QRA locator (Maidenhead grid square) to Longitude/Latitude.
- *
- * \param longitude Pointer for the calculated Longitude.
- * \param latitude Pointer for the calculated Latitude.
- * \param locator The QRA locator--2 through 12 characters + nul string.
- *
- * Convert a QRA locator string to Longitude/Latitude in decimal degrees
- * (D.DDD).  The locator should be 2 through 12 chars long format.
- * \a locator2longlat is case insensitive, however it checks for locator
- * validity.
- *
- * Decimal long/lat is computed to center of grid square, i.e. given
- * `EM19` will return coordinates equivalent to the southwest corner
- * of `EM19mm`.
- *
- * \return RIG_OK if the operation has been successful, otherwise a **negative
- * value** if an error occurred (in which case, cause is set appropriately).
- *
- * \retval RIG_OK The conversion was successful.
- * \retval RIG_EINVAL The QRA locator exceeds RR99xx99xx99 or exceeds length
- * limit--currently 1 to 6 lon/lat pairs--or is otherwise malformed.
- *
- * \bug The fifth pair ranges from aa to xx, there is another convention
- *  that ranges from aa to yy.  At some point both conventions should be
- *  supported.
- *
- * \sa longlat2locator()
- */
 /* begin dph */
-int HAMLIB_API locator2longlat(double *longitude,
-                               double *latitude,
-                               const char *locator)
+/* locator2longlat() without the checks of the arguments and the debug */
+static int loc_decode(const char *locator, double *longitude,
+                      double *latitude)
 {
     int x_or_y, paircount;
     int locvalue, pair;
     double xy[2];
 
-    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
-    /* bail if NULL pointers passed */
-    if (!longitude || !latitude)
-    {
-        return -RIG_EINVAL;
-    }
-
     paircount = strlen(locator) / 2;
 
     /* verify paircount is within limits */
@@ -514,6 +477,53 @@ int HAMLIB_API locator2longlat(double *longitude,
 /* end dph */
 
 
+/**
+ * \brief Convert QRA locator (Maidenhead grid square) to Longitude/Latitude.
+ *
+ * \param longitude Pointer for the calculated Longitude.
+ * \param latitude Pointer for the calculated Latitude.
+ * \param locator The QRA locator--2 through 12 characters + nul string.
+ *
+ * Convert a QRA locator string to Longitude/Latitude in decimal degrees
+ * (D.DDD).  The locator should be 2 through 12 chars long format.
+ * \a locator2longlat is case insensitive, however it checks for locator
+ * validity.
+ *
+ * Decimal long/lat is computed to center of grid square, i.e. given
+ * `EM19` will return coordinates equivalent to the southwest corner
+ * of `EM19mm`.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The conversion was successful.
+ * \retval RIG_EINVAL The QRA locator exceeds RR99xx99xx99 or exceeds length
+ * limit--currently 1 to 6 lon/lat pairs--or is otherwise malformed.
+ *
+ * \bug The fifth pair ranges from aa to xx, there is another convention
+ *  that ranges from aa to yy.  At some point both conventions should be
+ *  supported.
+ *
+ * \sa longlat2locator()
+ */
+/* begin dph */
+int HAMLIB_API locator2longlat(double *longitude,
+                               double *latitude,
+                               const char *locator)
+{
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    /* bail if NULL pointers passed */
+    if (!longitude || !latitude)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return loc_decode(locator, longitude, latitude);
+}
+/* end dph */
+
+
 /**
  * \brief Convert longitude/latitude to QRA locator (Maidenhead grid square).
  *
@@ -589,6 +599,120 @@ int HAMLIB_API longlat2locator(double longitude,
 /* end dph */
 
 
+/* locators decoded at a time by qrb_bulk_locator() */
+#define QRB_BLOCK 64
+
+
+/* the range check of qrb(), converted to radians */
+static int qrb_check(double *lon, double *lat)
+{
+    if (*lat > 90.0 || *lat < -90.0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (*lon > 180.0 || *lon < -180.0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    /* Prevent ACOS() Domain Error */
+    if (*lat == 90.0)
+    {
+        *lat = 89.999999999;
+    }
+    else if (*lat == -90.0)
+    {
+        *lat = -89.999999999;
+    }
+
+    /* Convert variables to Radians */
+    *lat /= RADIAN;
+    *lon /= RADIAN;
+
+    return RIG_OK;
+}
+
+
+static int qrb_origin_fill(qrb_origin_t *origin, double lon, double lat)
+{
+    if (qrb_check(&lon, &lat) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    origin->lon = lon;
+    origin->lat = lat;
+    origin->sin_lat = sin(lat);
+    origin->cos_lat = cos(lat);
+
+    return RIG_OK;
+}
+
+
+/* the QRB of a checked remote station, longitude and latitude in radians */
+static void qrb_point(const qrb_origin_t *origin, double lon2, double lat2,
+                      double *distance, double *azimuth)
+{
+    double delta_long, sin_lat2, cos_lat2, cos_delta, tmp, arc, az;
+
+    delta_long = lon2 - origin->lon;
+    sin_lat2 = sin(lat2);
+    cos_lat2 = cos(lat2);
+    cos_delta = cos(delta_long);
+
+    tmp = origin->sin_lat * sin_lat2 + origin->cos_lat * cos_lat2 * cos_delta;
+
+    if (tmp > .999999999999999)
+    {
+        /* Station points coincide, use an Omni! */
+        *distance = 0.0;
+        *azimuth = 0.0;
+        return;
+    }
+
+    if (tmp < -.999999)
+    {
+        /*
+         * points are antipodal, it's straight down.
+         * Station is equal distance in all Azimuths.
+         * So take 180 Degrees of arc times 60 nm,
+         * and you get 10800 nm, or whatever units...
+         */
+        *distance = 180.0 * ARC_IN_KM;
+        *azimuth = 0.0;
+        return;
+    }
+
+    arc = acos(tmp);
+
+    /*
+     * One degree of arc is 60 Nautical miles
+     * at the surface of the earth, 111.2 km, or 69.1 sm
+     * This method is easier than the one in the handbook
+     */
+    *distance = ARC_IN_KM * RADIAN * arc;
+
+    /* Short Path */
+    /* Change to azimuth computation by Dave Freese, W1HKJ */
+    az = RADIAN * atan2(sin(delta_long) * cos_lat2,
+                        (origin->cos_lat * sin_lat2 - origin->sin_lat * cos_lat2 * cos_delta));
+
+    az = fmod(360.0 + az, 360.0);
+
+    if (az < 0.0)
+    {
+        az += 360.0;
+    }
+    else if (az >= 360.0)
+    {
+        az -= 360.0;
+    }
+
+    *azimuth = floor(az + 0.5);
+}
+
+
 /**
  * \brief Calculate the distance and bearing between two points.
  *
@@ -623,7 +747,7 @@ int HAMLIB_API qrb(double lon1,
                    double *distance,
                    double *azimuth)
 {
-    double delta_long, tmp, arc, az;
+    qrb_origin_t origin;
 
     rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -633,94 +757,192 @@ int HAMLIB_API qrb(double lon1,
         return -RIG_EINVAL;
     }
 
-    if ((lat1 > 90.0 || lat1 < -90.0) || (lat2 > 90.0 || lat2 < -90.0))
+    if (qrb_origin_fill(&origin, lon1, lat1) != RIG_OK
+            || qrb_check(&lon2, &lat2) != RIG_OK)
     {
         return -RIG_EINVAL;
     }
 
-    if ((lon1 > 180.0 || lon1 < -180.0) || (lon2 > 180.0 || lon2 < -180.0))
+    qrb_point(&origin, lon2, lat2, distance, azimuth);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Set the local station for qrb_bulk().
+ *
+ * \param origin Pointer for the local station.
+ * \param lon The local Longitude, decimal degrees.
+ * \param lat The local Latitude, decimal degrees.
+ *
+ * Work out the sine and cosine of the local latitude once for any number
+ * of qrb_bulk() or qrb_bulk_locator() calls.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The local station was set.
+ * \retval RIG_EINVAL If a NULL pointer passed or \a lat and \a lon values
+ * exceed -90 to 90 or -180 to 180.
+ *
+ * \sa qrb_bulk(), qrb_bulk_locator()
+ */
+int HAMLIB_API qrb_origin_set(qrb_origin_t *origin, double lon, double lat)
+{
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!origin)
     {
         return -RIG_EINVAL;
     }
 
-    /* Prevent ACOS() Domain Error */
-    if (lat1 == 90.0)
-    {
-        lat1 = 89.999999999;
-    }
-    else if (lat1 == -90.0)
-    {
-        lat1 = -89.999999999;
-    }
+    return qrb_origin_fill(origin, lon, lat);
+}
 
-    if (lat2 == 90.0)
-    {
-        lat2 = 89.999999999;
-    }
-    else if (lat2 == -90.0)
-    {
-        lat2 = -89.999999999;
-    }
 
-    /* Convert variables to Radians */
-    lat1 /= RADIAN;
-    lon1 /= RADIAN;
-    lat2 /= RADIAN;
-    lon2 /= RADIAN;
+/**
+ * \brief Calculate the distance and bearings to many points.
+ *
+ * \param origin The local station, see qrb_origin_set().
+ * \param n The number of remote stations.
+ * \param lon The remote Longitudes, decimal degrees.
+ * \param lat The remote Latitudes, decimal degrees.
+ * \param distance Array for the distances, km.
+ * \param azimuth Array for the short path bearings, decimal degrees.
+ * \param azimuth_long Array for the long path bearings, decimal degrees, or
+ * NULL.
+ *
+ * Calculate the QRB of \a n remote stations in one call, with the same
+ * results as qrb() and azimuth_long_path() for each of them.  The arrays
+ * are kept separate so the loop runs through each of them in order, and
+ * the trigonometry of the local station is done only once.  The long path
+ * distance is distance_long_path() of \a distance.
+ *
+ * A remote station outside -90 to 90 or -180 to 180 gets NAN for its
+ * results and the others are still calculated.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The calculations were successful.
+ * \retval RIG_EINVAL If a NULL pointer passed or a remote station is out of
+ * range.
+ *
+ * \sa qrb(), qrb_bulk_locator()
+ */
+int HAMLIB_API qrb_bulk(const qrb_origin_t *origin,
+                        int n,
+                        const double *lon,
+                        const double *lat,
+                        double *distance,
+                        double *azimuth,
+                        double *azimuth_long)
+{
+    int invalid = 0;
+    int i;
 
-    delta_long = lon2 - lon1;
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called, n=%d\n", __func__, n);
 
-    tmp = sin(lat1) * sin(lat2) + cos(lat1) * cos(lat2) * cos(delta_long);
+    if (!origin || n < 0 || (n > 0 && (!lon || !lat || !distance || !azimuth)))
+    {
+        return -RIG_EINVAL;
+    }
 
-    if (tmp > .999999999999999)
+    for (i = 0; i < n; i++)
     {
-        /* Station points coincide, use an Omni! */
-        *distance = 0.0;
-        *azimuth = 0.0;
-        return RIG_OK;
+        double lon2 = lon[i];
+        double lat2 = lat[i];
+
+        if (qrb_check(&lon2, &lat2) == RIG_OK)
+        {
+            qrb_point(origin, lon2, lat2, &distance[i], &azimuth[i]);
+        }
+        else
+        {
+            distance[i] = azimuth[i] = NAN;
+            invalid++;
+        }
     }
 
-    if (tmp < -.999999)
+    if (azimuth_long)
     {
-        /*
-         * points are antipodal, it's straight down.
-         * Station is equal distance in all Azimuths.
-         * So take 180 Degrees of arc times 60 nm,
-         * and you get 10800 nm, or whatever units...
-         */
-        *distance = 180.0 * ARC_IN_KM;
-        *azimuth = 0.0;
-        return RIG_OK;
+        /* azimuth_long_path() of whole degrees 0 to 360 */
+        for (i = 0; i < n; i++)
+        {
+            azimuth_long[i] = fmod(azimuth[i] + 180.0, 360.0);
+        }
     }
 
-    arc = acos(tmp);
+    return invalid ? -RIG_EINVAL : RIG_OK;
+}
 
-    /*
-     * One degree of arc is 60 Nautical miles
-     * at the surface of the earth, 111.2 km, or 69.1 sm
-     * This method is easier than the one in the handbook
-     */
-    *distance = ARC_IN_KM * RADIAN * arc;
 
-    /* Short Path */
-    /* Change to azimuth computation by Dave Freese, W1HKJ */
-    az = RADIAN * atan2(sin(lon2 - lon1) * cos(lat2),
-                        (cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(lon2 - lon1)));
+/**
+ * \brief Calculate the distance and bearings to many locators.
+ *
+ * \param origin The local station, see qrb_origin_set().
+ * \param n The number of remote stations.
+ * \param locator The QRA locators of the remote stations.
+ * \param distance Array for the distances, km.
+ * \param azimuth Array for the short path bearings, decimal degrees.
+ * \param azimuth_long Array for the long path bearings, decimal degrees, or
+ * NULL.
+ *
+ * As qrb_bulk(), with each remote station given as a QRA locator as taken
+ * by locator2longlat().  A malformed locator gets NAN for its results and
+ * the others are still calculated.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The calculations were successful.
+ * \retval RIG_EINVAL If a NULL pointer passed or a locator is malformed.
+ *
+ * \sa qrb_bulk(), locator2longlat()
+ */
+int HAMLIB_API qrb_bulk_locator(const qrb_origin_t *origin,
+                                int n,
+                                const char *const *locator,
+                                double *distance,
+                                double *azimuth,
+                                double *azimuth_long)
+{
+    double lon[QRB_BLOCK], lat[QRB_BLOCK];
+    int invalid = 0;
+    int i;
 
-    az = fmod(360.0 + az, 360.0);
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called, n=%d\n", __func__, n);
 
-    if (az < 0.0)
+    if (!origin || n < 0 || (n > 0 && (!locator || !distance || !azimuth)))
     {
-        az += 360.0;
+        return -RIG_EINVAL;
     }
-    else if (az >= 360.0)
+
+    /* decode a block of locators, then work out their QRB */
+    for (i = 0; i < n; i += QRB_BLOCK)
     {
-        az -= 360.0;
-    }
+        int count = n - i < QRB_BLOCK ? n - i : QRB_BLOCK;
+        int j;
 
-    *azimuth = floor(az + 0.5);
+        for (j = 0; j < count; j++)
+        {
+            if (!locator[i + j]
+                    || loc_decode(locator[i + j], &lon[j], &lat[j]) != RIG_OK)
+            {
+                /* out of range for qrb_bulk() */
+                lon[j] = lat[j] = 1000.0;
+            }
+        }
 
-    return RIG_OK;
+        if (qrb_bulk(origin, count, lon, lat, distance + i, azimuth + i,
+                     azimuth_long ? azimuth_long + i : NULL) != RIG_OK)
+        {
+            invalid++;
+        }
+    }
+
+    return invalid ? -RIG_EINVAL : RIG_OK;
 }
 
 
@@ -34,6 +34,7 @@
 #include <stdarg.h>
 #include <stdio.h>   /* Standard input/output definitions */
 #include <string.h>  /* String function definitions */
+#include <ctype.h>
 
 #ifdef HAVE_SYS_TYPES_H
 #  include <sys/types.h>
@@ -44,6 +45,11 @@
 #endif
 
 #include <math.h>
+#include <stdint.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
 
 #include <hamlib/rig.h>
 #include <hamlib/rotator.h>
@@ -53,6 +59,7 @@
 #include "serial.h"
 #include "network.h"
 #include "sprintflst.h"
+#include "idx_builtin.h"
 #include "../rigs/icom/icom.h"
 
 #if defined(_WIN32)
@@ -120,6 +127,122 @@ static int clock_gettime(clockid_t clock_id, struct timespec *tp)
 
 #endif // __APPLE__
 
+/* packed BCD of 0 to 99, so that a byte takes one step instead of two */
+#define BCD_ROW(t) 0x##t##0, 0x##t##1, 0x##t##2, 0x##t##3, 0x##t##4, \
+                   0x##t##5, 0x##t##6, 0x##t##7, 0x##t##8, 0x##t##9
+
+static const unsigned char bcd_pair[100] =
+{
+    BCD_ROW(0), BCD_ROW(1), BCD_ROW(2), BCD_ROW(3), BCD_ROW(4),
+    BCD_ROW(5), BCD_ROW(6), BCD_ROW(7), BCD_ROW(8), BCD_ROW(9)
+};
+
+/* the two digits of a byte, 16 * hi + lo - 6 * hi, as hi * 10 + lo would */
+#define BCD_BYTE(b) ((unsigned)(b) - 6 * ((unsigned)(b) >> 4))
+
+/* the digits are taken 8 at a time, so a 32-bit CPU divides 32-bit numbers */
+#define BCD_CHUNK 100000000U
+
+
+static void bcd_encode_le(unsigned char bcd_data[], unsigned long long freq,
+                          unsigned bcd_len)
+{
+    unsigned chunk = 0;
+    unsigned i;
+
+    for (i = 0; i < bcd_len / 2; i++)
+    {
+        if (i % 4 == 0)
+        {
+            chunk = freq % BCD_CHUNK;
+            freq /= BCD_CHUNK;
+        }
+
+        bcd_data[i] = bcd_pair[chunk % 100];
+        chunk /= 100;
+    }
+
+    if (bcd_len & 1)
+    {
+        if (i % 4 == 0)
+        {
+            chunk = freq % BCD_CHUNK;
+        }
+
+        bcd_data[i] &= 0xf0;
+        bcd_data[i] |= chunk % 10; /* NB: high nibble is left uncleared */
+    }
+}
+
+
+static void bcd_encode_be(unsigned char bcd_data[], unsigned long long freq,
+                          unsigned bcd_len)
+{
+    unsigned chunk = 0;
+    unsigned i;
+
+    if (bcd_len & 1)
+    {
+        bcd_data[bcd_len / 2] &= 0x0f;
+        bcd_data[bcd_len / 2] |= (freq % 10) <<
+                                 4; /* NB: low nibble is left uncleared */
+        freq /= 10;
+    }
+
+    for (i = 0; i < bcd_len / 2; i++)
+    {
+        if (i % 4 == 0)
+        {
+            chunk = freq % BCD_CHUNK;
+            freq /= BCD_CHUNK;
+        }
+
+        bcd_data[bcd_len / 2 - 1 - i] = bcd_pair[chunk % 100];
+        chunk /= 100;
+    }
+}
+
+
+static unsigned long long bcd_decode_le(const unsigned char bcd_data[],
+                                        unsigned bcd_len)
+{
+    unsigned long long f = 0;
+    int i;
+
+    if (bcd_len & 1)
+    {
+        f = bcd_data[bcd_len / 2] & 0x0f;
+    }
+
+    for (i = (bcd_len / 2) - 1; i >= 0; i--)
+    {
+        f = f * 100 + BCD_BYTE(bcd_data[i]);
+    }
+
+    return f;
+}
+
+
+static unsigned long long bcd_decode_be(const unsigned char bcd_data[],
+                                        unsigned bcd_len)
+{
+    unsigned long long f = 0;
+    unsigned i;
+
+    for (i = 0; i < bcd_len / 2; i++)
+    {
+        f = f * 100 + BCD_BYTE(bcd_data[i]);
+    }
+
+    if (bcd_len & 1)
+    {
+        f = f * 10 + (bcd_data[bcd_len / 2] >> 4);
+    }
+
+    return f;
+}
+
+
 /**
  * \brief Convert from binary to 4-bit BCD digits, little-endian
  * \param bcd_data
@@ -134,37 +257,18 @@ static int clock_gettime(clockid_t clock_id, struct timespec *tp)
  * bcd_len is the number of BCD digits, usually 10 or 8 in 1-Hz units,
  * and 6 digits in 100-Hz units for Tx offset data.
  *
- * Hope the compiler will do a good job optimizing it (esp. w/the 64bit freq)
- *
  * Returns a pointer to (unsigned char *)bcd_data.
  *
- * \sa to_bcd_be()
+ * \sa to_bcd_be(), to_bcd_fields()
  */
 unsigned char *HAMLIB_API to_bcd(unsigned char bcd_data[],
                                  unsigned long long freq,
                                  unsigned bcd_len)
 {
-    int i;
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
     /* '450'/4-> 5,0;0,4 */
     /* '450'/3-> 5,0;x,4 */
 
-    for (i = 0; i < bcd_len / 2; i++)
-    {
-        unsigned char a = freq % 10;
-        freq /= 10;
-        a |= (freq % 10) << 4;
-        freq /= 10;
-        bcd_data[i] = a;
-    }
-
-    if (bcd_len & 1)
-    {
-        bcd_data[i] &= 0xf0;
-        bcd_data[i] |= freq % 10; /* NB: high nibble is left uncleared */
-    }
+    bcd_encode_le(bcd_data, freq, bcd_len);
 
     return bcd_data;
 }
@@ -181,34 +285,14 @@ unsigned char *HAMLIB_API to_bcd(unsigned char bcd_data[],
  *
  * bcd_len is the number of BCD digits.
  *
- * Hope the compiler will do a good job optimizing it (esp. w/ the 64bit freq)
- *
  * Returns frequency in Hz an unsigned long long integer.
  *
- * \sa from_bcd_be()
+ * \sa from_bcd_be(), from_bcd_fields()
  */
 unsigned long long HAMLIB_API from_bcd(const unsigned char bcd_data[],
                                        unsigned bcd_len)
 {
-    int i;
-    freq_t f = 0;
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
-    if (bcd_len & 1)
-    {
-        f = bcd_data[bcd_len / 2] & 0x0f;
-    }
-
-    for (i = (bcd_len / 2) - 1; i >= 0; i--)
-    {
-        f *= 10;
-        f += bcd_data[i] >> 4;
-        f *= 10;
-        f += bcd_data[i] & 0x0f;
-    }
-
-    return f;
+    return bcd_decode_le(bcd_data, bcd_len);
 }
 
 
@@ -228,29 +312,10 @@ unsigned char *HAMLIB_API to_bcd_be(unsigned char bcd_data[],
                                     unsigned long long freq,
                                     unsigned bcd_len)
 {
-    int i;
-
     /* '450'/4 -> 0,4;5,0 */
     /* '450'/3 -> 4,5;0,x */
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
-    if (bcd_len & 1)
-    {
-        bcd_data[bcd_len / 2] &= 0x0f;
-        bcd_data[bcd_len / 2] |= (freq % 10) <<
-                                 4; /* NB: low nibble is left uncleared */
-        freq /= 10;
-    }
-
-    for (i = (bcd_len / 2) - 1; i >= 0; i--)
-    {
-        unsigned char a = freq % 10;
-        freq /= 10;
-        a |= (freq % 10) << 4;
-        freq /= 10;
-        bcd_data[i] = a;
-    }
+    bcd_encode_be(bcd_data, freq, bcd_len);
 
     return bcd_data;
 }
@@ -269,27 +334,121 @@ unsigned char *HAMLIB_API to_bcd_be(unsigned char bcd_data[],
  */
 unsigned long long HAMLIB_API from_bcd_be(const unsigned char bcd_data[],
         unsigned bcd_len)
+{
+    return bcd_decode_be(bcd_data, bcd_len);
+}
+
+
+static int bcd_fields_fit(size_t frame_len, const bcd_field_t fields[],
+                          int nfields)
 {
     int i;
-    freq_t f = 0;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    for (i = 0; i < nfields; i++)
+    {
+        if (fields[i].offset + (fields[i].digits + 1) / 2 > frame_len)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: field %d at %d is past %d bytes\n",
+                      __func__, i, fields[i].offset, (int) frame_len);
+            return 0;
+        }
+    }
 
-    for (i = 0; i < bcd_len / 2; i++)
+    return 1;
+}
+
+
+/**
+ * \brief Convert the BCD fields of a frame to binary in one pass
+ * \param frame
+ * \param frame_len
+ * \param fields
+ * \param nfields
+ * \param values
+ * \return nfields, or -RIG_EPROTO if a field is past frame_len
+ *
+ * Decodes fields[i] of frame into values[i], little or big-endian as
+ * the field says, e.g. all the frequencies of a CI-V scope header, without
+ * a call and a debug line per field.  Nothing is decoded when a field
+ * does not fit in the frame.
+ *
+ * \sa to_bcd_fields(), from_bcd()
+ */
+int HAMLIB_API from_bcd_fields(const unsigned char frame[], size_t frame_len,
+                               const bcd_field_t fields[], int nfields,
+                               unsigned long long values[])
+{
+    int i;
+
+    if (nfields < 0)
     {
-        f *= 10;
-        f += bcd_data[i] >> 4;
-        f *= 10;
-        f += bcd_data[i] & 0x0f;
+        return -RIG_EINVAL;
     }
 
-    if (bcd_len & 1)
+    if (!bcd_fields_fit(frame_len, fields, nfields))
     {
-        f *= 10;
-        f += bcd_data[bcd_len / 2] >> 4;
+        return -RIG_EPROTO;
     }
 
-    return f;
+    for (i = 0; i < nfields; i++)
+    {
+        const unsigned char *field = frame + fields[i].offset;
+
+        values[i] = fields[i].big_endian ?
+                    bcd_decode_be(field, fields[i].digits) :
+                    bcd_decode_le(field, fields[i].digits);
+    }
+
+    return nfields;
+}
+
+
+/**
+ * \brief Convert binary values to the BCD fields of a frame in one pass
+ * \param frame
+ * \param frame_len
+ * \param fields
+ * \param nfields
+ * \param values
+ * \return nfields, or -RIG_EPROTO if a field is past frame_len
+ *
+ * Encodes values[i] into fields[i] of frame, the counterpart of
+ * from_bcd_fields().  Nothing is written when a field does not fit in
+ * the frame.
+ *
+ * \sa from_bcd_fields(), to_bcd()
+ */
+int HAMLIB_API to_bcd_fields(unsigned char frame[], size_t frame_len,
+                             const bcd_field_t fields[], int nfields,
+                             const unsigned long long values[])
+{
+    int i;
+
+    if (nfields < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (!bcd_fields_fit(frame_len, fields, nfields))
+    {
+        return -RIG_EPROTO;
+    }
+
+    for (i = 0; i < nfields; i++)
+    {
+        unsigned char *field = frame + fields[i].offset;
+
+        if (fields[i].big_endian)
+        {
+            bcd_encode_be(field, values[i], fields[i].digits);
+        }
+        else
+        {
+            bcd_encode_le(field, values[i], fields[i].digits);
+        }
+    }
+
+    return nfields;
 }
 
 size_t HAMLIB_API to_hex(size_t source_length, const unsigned char *source_data,
@@ -363,6 +522,100 @@ int millis_to_dot10ths(int millis, int wpm)
     return ceil(millis / morse_code_dot_to_millis(wpm) * 10.0);
 }
 
+/**
+ * \brief Morse code of a character.
+ * \param c the character
+ * \return const char * the code as dots and dashes, e.g. ".-" for 'A',
+ * NULL if the character has no morse code
+ */
+const char *morse_code_char(int c)
+{
+    static const char *const letters[26] =
+    {
+        ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---",
+        "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.", "...", "-",
+        "..-", "...-", ".--", "-..-", "-.--", "--.."
+    };
+    static const char *const digits[10] =
+    {
+        "-----", ".----", "..---", "...--", "....-", ".....", "-....", "--...",
+        "---..", "----."
+    };
+    static const struct
+    {
+        char c;
+        const char *code;
+    } signs[] =
+    {
+        { '.', ".-.-.-" }, { ',', "--..--" }, { '?', "..--.." }, { '/', "-..-." },
+        { '=', "-...-" }, { '+', ".-.-." }, { '-', "-....-" }, { '(', "-.--." },
+        { ')', "-.--.-" }, { '\'', ".----." }, { ':', "---..." }, { ';', "-.-.-." },
+        { '"', ".-..-." }, { '@', ".--.-." }, { '!', "-.-.--" }, { '&', ".-..." },
+    };
+    int i;
+
+    if (c < 0 || c > 127)
+    {
+        return NULL;
+    }
+
+    if (isalpha(c))
+    {
+        return letters[toupper(c) - 'A'];
+    }
+
+    if (isdigit(c))
+    {
+        return digits[c - '0'];
+    }
+
+    for (i = 0; i < sizeof(signs) / sizeof(signs[0]); i++)
+    {
+        if (signs[i].c == c)
+        {
+            return signs[i].code;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Duration of one character sent in morse code, in tenths of dots.
+ * \param c the character
+ * \return int number of 1/10ths of dots, 0 if the character has no morse code
+ *
+ * Includes the 3 dot space after the character, and a space is the 4 dots
+ * more that make the 7 dot space between words.
+ */
+int morse_code_char_to_dot10ths(int c)
+{
+    const char *code;
+    int dots;
+    int i;
+
+    if (c == ' ')
+    {
+        return 40;
+    }
+
+    code = morse_code_char(c);
+
+    if (code == NULL)
+    {
+        return 0;
+    }
+
+    /* a dash is 3 dots, each element is followed by a 1 dot space and the
+       last one by the 3 dot space between characters */
+    for (dots = 2, i = 0; code[i]; i++)
+    {
+        dots += code[i] == '-' ? 4 : 2;
+    }
+
+    return dots * 10;
+}
+
 //! @cond Doxygen_Suppress
 #ifndef llabs
 #define llabs(a) ((a)<0?-(a):(a))
@@ -765,7 +1018,7 @@ static const struct
     { RIG_BANDSELECT_10M,   "BAND10M", 28000000, 29999999},
     { RIG_BANDSELECT_6M,    "BAND6M", 50000000, 53999999},
     { RIG_BANDSELECT_WFM,   "BANDWFM", 74800000, 107999999},
-    { RIG_BANDSELECT_MW,    "BANDMW", 530000000, 1700999999},
+    { RIG_BANDSELECT_MW,    "BANDMW", 530000, 1700999},
     { RIG_BANDSELECT_AIR,   "BANDAIR", 108000000, 136999999},
     { RIG_BANDSELECT_2M,    "BAND2M", 144000000, 145999999},
     { RIG_BANDSELECT_1_25M, "BAND1_25M", 219000000, 224999999},
@@ -1979,6 +2232,12 @@ double HAMLIB_API elapsed_ms(struct timespec *start, int option)
 int HAMLIB_API rig_get_cache_timeout_ms(RIG *rig, hamlib_cache_t selection)
 {
     rig_debug(RIG_DEBUG_TRACE, "%s: called selection=%d\n", __func__, selection);
+
+    if (selection > HAMLIB_CACHE_ALL && selection <= HAMLIB_CACHE_WIDTH)
+    {
+        return rig->state.cache_timeouts_ms[selection];
+    }
+
     return CACHE(rig)->timeout_ms;
 }
 
@@ -1987,7 +2246,25 @@ int HAMLIB_API rig_set_cache_timeout_ms(RIG *rig, hamlib_cache_t selection,
 {
     rig_debug(RIG_DEBUG_TRACE, "%s: called selection=%d, ms=%d\n", __func__,
               selection, ms);
+
+    if (selection > HAMLIB_CACHE_ALL && selection <= HAMLIB_CACHE_WIDTH)
+    {
+        rig->state.cache_timeouts_ms[selection] = ms;
+        return RIG_OK;
+    }
+
+    if (selection != HAMLIB_CACHE_ALL)
+    {
+        return -RIG_EINVAL;
+    }
+
     CACHE(rig)->timeout_ms = ms;
+
+    for (selection = HAMLIB_CACHE_VFO; selection <= HAMLIB_CACHE_WIDTH; selection++)
+    {
+        rig->state.cache_timeouts_ms[selection] = ms;
+    }
+
     return RIG_OK;
 }
 
@@ -2261,7 +2538,7 @@ int HAMLIB_API parse_hoststr(char *hoststr, int hoststr_len, char host[256],
  */
 int HAMLIB_API rig_flush_force(hamlib_port_t *port, int flush_async_data)
 {
-    if (port->type.rig == RIG_PORT_NONE)
+    if (port->type.rig == RIG_PORT_NONE || port->type.rig == RIG_PORT_REPLAY)
     {
         return RIG_OK;
     }
@@ -2879,6 +3156,342 @@ const char *spaces(int len)
     return s;
 }
 
+#if defined(HAVE_PTHREAD)
+static pthread_key_t thread_depth_key;
+static pthread_once_t thread_depth_once = PTHREAD_ONCE_INIT;
+
+static void thread_depth_init(void)
+{
+    pthread_key_create(&thread_depth_key, NULL);
+}
+#else
+static int thread_depth;
+#endif
+
+/*
+ * Unlike rig->state.depth, which all threads of a rig share, this counts
+ * the rig API calls of the calling thread only, so a call made from
+ * inside another one on the same thread can be told from a new one.
+ */
+void rig_thread_depth_add(int n)
+{
+#if defined(HAVE_PTHREAD)
+    intptr_t depth;
+
+    pthread_once(&thread_depth_once, thread_depth_init);
+    depth = (intptr_t) pthread_getspecific(thread_depth_key) + n;
+    pthread_setspecific(thread_depth_key, (void *)(depth > 0 ? depth : 0));
+#else
+    thread_depth += n;
+
+    if (thread_depth < 0) { thread_depth = 0; }
+
+#endif
+}
+
+int rig_thread_depth(void)
+{
+#if defined(HAVE_PTHREAD)
+    pthread_once(&thread_depth_once, thread_depth_init);
+    return (int)(intptr_t) pthread_getspecific(thread_depth_key);
+#else
+    return thread_depth;
+#endif
+}
+
+//! @cond Doxygen_Suppress
+#define RIG_BAND_MAP_MAX 32
+
+/*
+ * A rig's bands sorted by frequency, so that the band of a frequency is a
+ * binary search, and its BANDSELECT parm list split up once instead of on
+ * every lookup.
+ */
+struct rig_band_map
+{
+    int count;                                  /* bands in band[] */
+    hamlib_band_edge_t band[RIG_BAND_MAP_MAX];  /* sorted by start */
+    int rig_count;                              /* bands in rig_name[] */
+    const char *rig_name[RIG_BAND_MAP_MAX];     /* the rig's BANDSELECT list */
+    char rig_list[512];                         /* rig_name[] points in here */
+};
+
+
+static int rig_band_edge_cmp(const void *a, const void *b)
+{
+    const hamlib_band_edge_t *ea = a;
+    const hamlib_band_edge_t *eb = b;
+
+    return ea->start < eb->start ? -1 : ea->start > eb->start;
+}
+
+
+/* True if the rig can receive or transmit somewhere in start..stop */
+static int rig_band_in_range(const struct rig_state *rs, freq_t start,
+                             freq_t stop)
+{
+    const freq_range_t *lists[2] = { rs->rx_range_list, rs->tx_range_list };
+    int l, i;
+
+    /* no ranges at all, e.g. a network rig before it is asked */
+    if (RIG_IS_FRNG_END(rs->rx_range_list[0])
+            && RIG_IS_FRNG_END(rs->tx_range_list[0]))
+    {
+        return 1;
+    }
+
+    for (l = 0; l < 2; l++)
+    {
+        for (i = 0; i < HAMLIB_FRQRANGESIZ && !RIG_IS_FRNG_END(lists[l][i]); i++)
+        {
+            if (lists[l][i].startf <= stop && lists[l][i].endf >= start)
+            {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * Builds the band map of the rig from its frequency ranges and the
+ * BANDSELECT parm list of its caps.  Called by rig_open() once the
+ * backend has set up the ranges.
+ */
+int rig_band_map_build(RIG *rig)
+{
+    struct rig_band_map *map;
+    const char *list = rig->caps->parm_gran[PARM_BANDSELECT].step.s;
+    int i, j;
+
+    map = calloc(1, sizeof(*map));
+
+    if (!map)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    if (list)
+    {
+        char *p = map->rig_list;
+        char *token;
+
+        SNPRINTF(map->rig_list, sizeof(map->rig_list), "%s", list);
+
+        while ((token = strtok_r(p, ",", &p)) && map->rig_count < RIG_BAND_MAP_MAX)
+        {
+            map->rig_name[map->rig_count++] = token;
+        }
+    }
+
+    for (i = 0; rig_bandselect_str[i].str != NULL; i++)
+    {
+        hamlib_band_edge_t *band;
+
+        /* BANDGEN covers everything, it is what is left between the bands */
+        if (rig_bandselect_str[i].bandselect == RIG_BANDSELECT_GEN
+                || !rig_band_in_range(&rig->state, rig_bandselect_str[i].start,
+                                      rig_bandselect_str[i].stop))
+        {
+            continue;
+        }
+
+        band = &map->band[map->count++];
+        band->start = rig_bandselect_str[i].start;
+        band->stop = rig_bandselect_str[i].stop;
+        band->bandselect = rig_bandselect_str[i].bandselect;
+        band->name = rig_bandselect_str[i].str;
+        band->rig_band = -1;
+
+        for (j = 0; j < map->rig_count; j++)
+        {
+            if (strcmp(map->rig_name[j], band->name) == 0)
+            {
+                band->rig_band = j;
+                break;
+            }
+        }
+    }
+
+    qsort(map->band, map->count, sizeof(map->band[0]), rig_band_edge_cmp);
+
+    free(rig->state.band_map);
+    rig->state.band_map = map;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %d bands, %d in the rig's BANDSELECT list\n",
+              __func__, map->count, map->rig_count);
+
+    return RIG_OK;
+}
+
+
+void rig_band_map_free(RIG *rig)
+{
+    free(rig->state.band_map);
+    rig->state.band_map = NULL;
+}
+
+
+/* The band map, built on first use if the rig has not been opened */
+static const struct rig_band_map *rig_band_map_get(RIG *rig)
+{
+    if (!rig->state.band_map)
+    {
+        rig_band_map_build(rig);
+    }
+
+    return rig->state.band_map;
+}
+
+
+static const hamlib_band_edge_t *rig_band_map_find(const struct rig_band_map
+        *map, freq_t freq)
+{
+    int lo = 0;
+    int hi = map->count - 1;
+
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if (freq < map->band[mid].start)
+        {
+            hi = mid - 1;
+        }
+        else if (freq > map->band[mid].stop)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            return &map->band[mid];
+        }
+    }
+
+    return NULL;
+}
+//! @endcond
+
+
+/**
+ * \brief Find the band of a frequency
+ * \param rig   The rig handle
+ * \param freq  The frequency in Hz
+ * \param band  Set to the band \a freq is in
+ *
+ * Looks \a freq up in the rig's band map, a binary search cheap enough
+ * to call on every frequency change.
+ *
+ * \return RIG_OK, or -RIG_ENAVAIL if \a freq is not in any band the rig
+ * can tune, i.e. general coverage.
+ *
+ * \sa rig_get_band_info(), rig_get_band_map()
+ */
+int HAMLIB_API rig_lookup_band(RIG *rig, freq_t freq,
+                               const hamlib_band_edge_t **band)
+{
+    const struct rig_band_map *map;
+
+    if (!rig || !rig->caps || !band)
+    {
+        return -RIG_EINVAL;
+    }
+
+    map = rig_band_map_get(rig);
+
+    if (!map)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    *band = rig_band_map_find(map, freq);
+
+    return *band ? RIG_OK : -RIG_ENAVAIL;
+}
+
+
+/**
+ * \brief Get the edges and rig band index of a band
+ * \param rig   The rig handle
+ * \param bandselect    The RIG_BANDSELECT_* of the band
+ * \param band  Set to the band
+ *
+ * \return RIG_OK, or -RIG_ENAVAIL if the rig cannot tune \a bandselect.
+ *
+ * \sa rig_lookup_band(), rig_get_band_map()
+ */
+int HAMLIB_API rig_get_band_info(RIG *rig, setting_t bandselect,
+                                 const hamlib_band_edge_t **band)
+{
+    const struct rig_band_map *map;
+    int i;
+
+    if (!rig || !rig->caps || !band)
+    {
+        return -RIG_EINVAL;
+    }
+
+    map = rig_band_map_get(rig);
+
+    if (!map)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    for (i = 0; i < map->count; i++)
+    {
+        if (map->band[i].bandselect == bandselect)
+        {
+            *band = &map->band[i];
+            return RIG_OK;
+        }
+    }
+
+    *band = NULL;
+
+    return -RIG_ENAVAIL;
+}
+
+
+/**
+ * \brief Get all the bands a rig can tune
+ * \param rig   The rig handle
+ * \param bands Set to the bands, sorted by frequency
+ * \param count Set to the number of bands
+ *
+ * The bands stay valid until the rig is opened again or cleaned up.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred.
+ *
+ * \sa rig_lookup_band(), rig_get_band_info()
+ */
+int HAMLIB_API rig_get_band_map(RIG *rig, const hamlib_band_edge_t **bands,
+                                int *count)
+{
+    const struct rig_band_map *map;
+
+    if (!rig || !rig->caps || !bands || !count)
+    {
+        return -RIG_EINVAL;
+    }
+
+    map = rig_band_map_get(rig);
+
+    if (!map)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    *bands = map->band;
+    *count = map->count;
+
+    return RIG_OK;
+}
+
+
 // if which==0 rig_band_select str will be returned
 // if which!=0 the rig_parm_gran band str will be returne
 const char *rig_get_band_str(RIG *rig, hamlib_band_t band, int which)
@@ -2897,38 +3510,18 @@ const char *rig_get_band_str(RIG *rig, hamlib_band_t band, int which)
     }
     else
     {
-        char bandlist[512];
+        const struct rig_band_map *map = rig_band_map_get(rig);
 
-        rig_sprintf_parm_gran(bandlist, sizeof(bandlist) - 1, RIG_PARM_BANDSELECT,
-                              rig->caps->parm_gran);
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: bandlist=%s\n", __func__, bandlist);
-        int n = 0;
-        char *p = strchr(bandlist, '(') + 1;
-        char *token;
-
-        if (p == NULL)
+        if (map && band >= 0 && band < map->rig_count)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: unable to find open paren in '%s'\n", __func__,
-                      bandlist);
-            return 0;
-        }
-
-        while ((token = strtok_r(p, ",", &p)))
-        {
-            if (n == band)
+            for (i = 0; rig_bandselect_str[i].str != NULL; i++)
             {
-                for (i = 0; rig_bandselect_str[i].str != NULL; i++)
+                if (strcmp(rig_bandselect_str[i].str, map->rig_name[band]) == 0)
                 {
-                    if (strcmp(rig_bandselect_str[i].str, token) == 0)
-                    {
-                        return rig_bandselect_str[i].str;
-                    }
+                    return rig_bandselect_str[i].str;
                 }
             }
-
-            n++;
         }
-
     }
 
     return "BANDGEN";
@@ -2939,55 +3532,44 @@ const char *rig_get_band_str(RIG *rig, hamlib_band_t band, int which)
 // returns the rig's backend hamlib_band_t that can used to lookup the band str
 hamlib_band_t rig_get_band(RIG *rig, freq_t freq, int band)
 {
-    int i;
+    const struct rig_band_map *map = rig_band_map_get(rig);
+    const hamlib_band_edge_t *edge;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    if (!map)
+    {
+        return RIG_BAND_UNUSED;
+    }
 
     if (freq == 0)
     {
-        char bandlist[512];
+        int i;
 
-        rig_sprintf_parm_gran(bandlist, sizeof(bandlist) - 1, RIG_PARM_BANDSELECT,
-                              rig->caps->parm_gran);
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: bandlist=%s\n", __func__, bandlist);
-        // e.g. BANDSELECT(BAND160M,BAND80M,BANDUNUSED,BAND40M)
-        char *p = strchr(bandlist, '(') + 1;
-        char *token;
-
-        if (p == NULL)
+        if (band < 0 || band >= map->rig_count)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: unable to find open paren in '%s'\n", __func__,
-                      bandlist);
-            return 0;
+            return RIG_BAND_UNUSED;
         }
 
-        int n = 0;
-
-        while ((token = strtok_r(p, ",", &p)))
+        for (i = 0; rig_bandselect_str[i].str != NULL; i++)
         {
-            if (n == band) { return rig_bandselect_str[n].bandselect; }
-
-            n++;
+            if (strcmp(rig_bandselect_str[i].str, map->rig_name[band]) == 0)
+            {
+                return rig_bandselect_str[i].bandselect;
+            }
         }
 
         return RIG_BAND_UNUSED;
     }
 
-    for (i = 0 ; rig_bandselect_str[i].str != NULL; i++)
-    {
-        if (freq >= rig_bandselect_str[i].start && freq <= rig_bandselect_str[i].stop)
-        {
-            return rig_bandselect_str[i].bandselect;
-        }
-    }
+    edge = rig_band_map_find(map, freq);
 
-    return RIG_BAND_UNUSED;
+    return edge ? edge->bandselect : RIG_BANDSELECT_GEN;
 }
 
 // Gets the rig's band index from the hamlib_band_t
 int rig_get_band_rig(RIG *rig, freq_t freq, const char *band)
 {
-    char bandlist[512];
+    const struct rig_band_map *map;
+    const hamlib_band_edge_t *edge;
     int i;
 
     if (freq == 0 && band == NULL)
@@ -2996,56 +3578,39 @@ int rig_get_band_rig(RIG *rig, freq_t freq, const char *band)
         return RIG_BAND_GEN;
     }
 
-    if (freq == 0)
+    map = rig_band_map_get(rig);
+
+    if (!map)
     {
-        bandlist[0] = 0;
-        rig_sprintf_parm_gran(bandlist, sizeof(bandlist) - 1, RIG_PARM_BANDSELECT,
-                              rig->caps->parm_gran);
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: bandlist=%s\n", __func__, bandlist);
+        return RIG_BAND_GEN;
+    }
 
-        // e.g. BANDSELECT(BAND160M,BAND80M,BANDUNUSED,BAND40M)
-        if (strlen(bandlist) == 0)
+    if (freq == 0)
+    {
+        if (map->rig_count == 0)
         {
             rig_debug(RIG_DEBUG_ERR, "%s: rig does not have bandlist\n", __func__);
             return RIG_BAND_GEN;
         }
 
-        char *p = strchr(bandlist, '(') + 1;
-        char *token;
-
-        if (p == NULL)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: unable to find open paren in '%s'\n", __func__,
-                      bandlist);
-            return 0;
-        }
-
-        int n = 0;
-
-        while ((token = strtok_r(p, ",", &p)))
+        for (i = 0; i < map->rig_count; i++)
         {
-            if (strcmp(token, band) == 0) { return n; }
-
-            n++;
+            if (strcmp(map->rig_name[i], band) == 0) { return i; }
         }
 
         rig_debug(RIG_DEBUG_ERR, "%s: unknown band %s\n", __func__, band);
         return 0;
     }
 
-    for (i = 0 ; rig_bandselect_str[i].str != NULL; i++)
+    edge = rig_band_map_find(map, freq);
+
+    if (edge && edge->rig_band >= 0)
     {
-        if (freq >= rig_bandselect_str[i].start && freq <= rig_bandselect_str[i].stop)
-        {
-            // now we know the hamlib_band_t so we can look it up now
-            // this is 1-time recursive
-            return rig_get_band_rig(rig, 0.0, rig_bandselect_str[i].str);
-        }
+        return edge->rig_band;
     }
 
-    rig_debug(RIG_DEBUG_ERR, "%s: unable to find band=%s, freq=%f\n", __func__,
-              band, freq);
-    return 0; // just give a value for now of the 1st band -- this should be an error
+    // this is 1-time recursive
+    return rig_get_band_rig(rig, 0.0, edge ? edge->name : "BANDGEN");
 }
 
 // Returns RIG_OK if 2038 time routines pass tests
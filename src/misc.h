@@ -41,6 +41,9 @@ __BEGIN_DECLS
 
 // a function to return just a string of spaces for indenting rig debug lines
 HAMLIB_EXPORT (const char *) spaces(int len);
+// rig API calls running on the calling thread, kept by ENTERFUNC and RETURNFUNC
+HAMLIB_EXPORT (void) rig_thread_depth_add(int n);
+HAMLIB_EXPORT (int) rig_thread_depth(void);
 /*
  * Do a hex dump of the unsigned char array.
  */
@@ -77,6 +80,32 @@ extern HAMLIB_EXPORT(unsigned long long) from_bcd_be(const unsigned char
                                                      bcd_data[],
                                                      unsigned bcd_len);
 
+/*
+ * A BCD field of a frame, e.g. the frequencies of a CI-V scope header.
+ * from_bcd_fields() and to_bcd_fields() convert all the fields of a frame
+ * in one call, into or from values[] of the caller.  Nothing is converted
+ * and -RIG_EPROTO returned if a field does not fit in frame_len bytes,
+ * otherwise the number of fields.
+ */
+typedef struct
+{
+    unsigned short offset;      /* of the first byte of the field */
+    unsigned char digits;       /* bcd_len */
+    unsigned char big_endian;   /* as to_bcd_be()/from_bcd_be() */
+} bcd_field_t;
+
+extern HAMLIB_EXPORT(int) from_bcd_fields(const unsigned char frame[],
+                                          size_t frame_len,
+                                          const bcd_field_t fields[],
+                                          int nfields,
+                                          unsigned long long values[]);
+
+extern HAMLIB_EXPORT(int) to_bcd_fields(unsigned char frame[],
+                                        size_t frame_len,
+                                        const bcd_field_t fields[],
+                                        int nfields,
+                                        const unsigned long long values[]);
+
 extern HAMLIB_EXPORT(size_t) to_hex(size_t source_length,
                                     const unsigned char *source_data,
                                     size_t dest_length,
@@ -85,6 +114,8 @@ extern HAMLIB_EXPORT(size_t) to_hex(size_t source_length,
 extern HAMLIB_EXPORT(double) morse_code_dot_to_millis(int wpm);
 extern HAMLIB_EXPORT(int) dot10ths_to_millis(int dot10ths, int wpm);
 extern HAMLIB_EXPORT(int) millis_to_dot10ths(int millis, int wpm);
+extern HAMLIB_EXPORT(const char *) morse_code_char(int c);
+extern HAMLIB_EXPORT(int) morse_code_char_to_dot10ths(int c);
 
 extern HAMLIB_EXPORT(int) sprintf_freq(char *str, int str_len, freq_t);
 
@@ -157,7 +188,7 @@ extern HAMLIB_EXPORT(char *)date_strget(char *buf, int buflen, int localtime);
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 void errmsg(int err, char *s, const char *func, const char *file, int line);
 #define ERRMSG(err, s) errmsg(err,  s, __func__, __FILENAME__, __LINE__)
-#define ENTERFUNC {     ++rig->state.depth; \
+#define ENTERFUNC {     ++rig->state.depth; rig_thread_depth_add(1); \
                         rig_debug(RIG_DEBUG_VERBOSE, "%s%d:%s(%d):%s entered\n", spaces(rig->state.depth), rig->state.depth, __FILENAME__, __LINE__, __func__); \
                   }
 #define ENTERFUNC2 {    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d):%s entered\n", __FILENAME__, __LINE__, __func__); \
@@ -167,7 +198,7 @@ void errmsg(int err, char *s, const char *func, const char *file, int line);
 #define RETURNFUNC(rc) {do { \
 			            int rctmp = rc; \
                         rig_debug(RIG_DEBUG_VERBOSE, "%s%d:%s(%d):%s returning(%ld) %s\n", spaces(rig->state.depth), rig->state.depth, __FILENAME__, __LINE__, __func__, (long int) (rctmp), rctmp<0?rigerror2(rctmp):""); \
-                        --rig->state.depth; \
+                        --rig->state.depth; rig_thread_depth_add(-1); \
                         return (rctmp); \
                        } while(0);}
 #define RETURNFUNC2(rc) {do { \
@@ -215,6 +246,9 @@ extern int check_level_param(RIG *rig, setting_t level, value_t val, gran_t **gr
 extern HAMLIB_EXPORT(hamlib_band_t) rig_get_band(RIG *rig, freq_t freq, int band);
 extern HAMLIB_EXPORT(const char*) rig_get_band_str(RIG *rig, hamlib_band_t band, int which);
 extern HAMLIB_EXPORT(int) rig_get_band_rig(RIG *rig, freq_t freq, const char *band);
+extern HAMLIB_EXPORT(setting_t) rig_parse_band(const char *s);
+extern int rig_band_map_build(RIG *rig);
+extern void rig_band_map_free(RIG *rig);
 
 extern HAMLIB_EXPORT(int) rig_test_2038(RIG *rig);
 
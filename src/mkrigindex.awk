@@ -0,0 +1,260 @@
+#
+# mkrigindex.awk - generate the static rig model index
+#
+# Usage: awk -f mkrigindex.awk riglist.h register.c rigs/*/*.c > rig_index.c
+#
+# Reads the model numbers from riglist.h, the compiled in backends from
+# the rig_backend_list table in register.c and, from each backend's
+# DECLARE_INITRIG_BACKEND() function, the rig_caps it registers.  Writes
+# a table of { model, backend, caps } sorted by model number that lets
+# register.c find a model without calling every backend's init.
+#
+# Registrations inside #if blocks, and caps not initialised with
+# RIG_MODEL(), are left out; those are still found through
+# rig_register() once their backend has been loaded.  The backends whose
+# models are all in the table are listed in rig_index_backends, so that
+# rig_load_all_backends() can skip them.
+#
+
+function sym(s, re)
+{
+    if (!match(s, re))
+    {
+        return ""
+    }
+
+    return substr(s, RSTART, RLENGTH)
+}
+
+function strip(s, pre, post)
+{
+    return substr(s, length(pre) + 1, length(s) - length(pre) - length(post))
+}
+
+BEGIN {
+    per_backend = 1000
+    nreg = 0
+}
+
+# riglist.h: backend and model numbers
+FILENAME ~ /riglist\.h$/ {
+    if ($1 == "#define" && $2 == "MAX_MODELS_PER_BACKEND")
+    {
+        per_backend = $3 + 0
+    }
+    else if ($1 == "#define" && $2 ~ /^RIG_[A-Z0-9_]+$/ && $3 ~ /^[0-9]+$/)
+    {
+        number[$2] = $3 + 0
+    }
+    else if ($1 == "#define" && $2 ~ /^RIG_MODEL_/)
+    {
+        line = $0
+        sub(/\/\*.*/, "", line)
+        sub(/\/\/.*/, "", line)
+        gsub(/[ \t]/, "", line)
+        value = substr(line, length("#define") + length($2) + 1)
+
+        if (value ~ /^RIG_MAKE_MODEL\(RIG_[A-Z0-9_]+,[0-9]+\)$/)
+        {
+            value = strip(value, "RIG_MAKE_MODEL(", ")")
+            split(value, part, ",")
+
+            if (part[1] in number)
+            {
+                model[$2] = number[part[1]] * per_backend + part[2]
+            }
+        }
+        else if (value ~ /^[0-9]+$/)
+        {
+            model[$2] = value + 0
+        }
+        else if (value in model)
+        {
+            model[$2] = model[value]
+        }
+    }
+
+    next
+}
+
+# register.c: the backends always compiled in, by init function name
+FILENAME ~ /register\.c$/ {
+    if ($0 ~ /rig_backend_list\[/)
+    {
+        in_list = 1
+        depth = 0
+    }
+    else if (in_list && $0 ~ /^};/)
+    {
+        in_list = 0
+    }
+    else if (in_list && $1 ~ /^#if/)
+    {
+        depth++
+    }
+    else if (in_list && $1 ~ /^#endif/)
+    {
+        depth--
+    }
+    else if (in_list && depth == 0 && $0 ~ /RIG_FUNCNAMA?\(/)
+    {
+        be = sym($0, "RIG_FUNCNAMA?\\([a-z0-9_]+\\)")
+        sub(/^RIG_FUNCNAMA?\(/, "", be)
+        sub(/\)$/, "", be)
+        benum = sym($0, "\\{ *RIG_[A-Z0-9_]+")
+        sub(/^\{ */, "", benum)
+        backend[be] = benum
+    }
+
+    next
+}
+
+# backend sources: caps definitions
+/^(const )?struct rig_caps [A-Za-z0-9_]+ *=/ {
+    caps = $0
+    sub(/^(const )?struct rig_caps /, "", caps)
+    sub(/ *=.*/, "", caps)
+    pending = caps
+    next
+}
+
+pending != "" && /RIG_MODEL\(RIG_MODEL_[A-Za-z0-9_]+\)/ {
+    caps_model[pending] = strip(sym($0, "RIG_MODEL\\(RIG_MODEL_[A-Za-z0-9_]+\\)"),
+                                "RIG_MODEL(", ")")
+    pending = ""
+    next
+}
+
+pending != "" && /^};/ {
+    pending = ""
+}
+
+# backend sources: the caps registered by the backend init
+/^DECLARE_INITRIG_BACKEND\(/ {
+    init = strip(sym($0, "\\([a-z0-9_]+\\)"), "(", ")")
+    in_init = 1
+    depth = 0
+    next
+}
+
+in_init && /^}/ {
+    in_init = 0
+    next
+}
+
+in_init && $1 ~ /^\/\// {
+    next
+}
+
+in_init && $1 ~ /^#if/ {
+    depth++
+    next
+}
+
+in_init && $1 ~ /^#endif/ {
+    depth--
+    next
+}
+
+in_init && /rig_register\(/ && (depth > 0 || !/rig_register\(&[A-Za-z0-9_]+\)/) {
+    partial[init] = 1
+    next
+}
+
+in_init && /rig_register\(&[A-Za-z0-9_]+\)/ {
+    nreg++
+    reg_caps[nreg] = strip(sym($0, "&[A-Za-z0-9_]+"), "&", "")
+    reg_init[nreg] = init
+}
+
+END {
+    n = 0
+
+    for (i = 1; i <= nreg; i++)
+    {
+        caps = reg_caps[i]
+
+        if (!(reg_init[i] in backend) || !(caps in caps_model) ||
+                !(caps_model[caps] in model))
+        {
+            partial[reg_init[i]] = 1
+            continue
+        }
+
+        if (caps in seen)
+        {
+            continue
+        }
+
+        seen[caps] = 1
+        n++
+        e_caps[n] = caps
+        e_model[n] = caps_model[caps]
+        e_num[n] = model[caps_model[caps]]
+        e_be[n] = backend[reg_init[i]]
+
+        # insertion sort by model number
+        for (j = n; j > 1 && e_num[j - 1] > e_num[j]; j--)
+        {
+            t = e_caps[j]; e_caps[j] = e_caps[j - 1]; e_caps[j - 1] = t
+            t = e_model[j]; e_model[j] = e_model[j - 1]; e_model[j - 1] = t
+            t = e_num[j]; e_num[j] = e_num[j - 1]; e_num[j - 1] = t
+            t = e_be[j]; e_be[j] = e_be[j - 1]; e_be[j - 1] = t
+        }
+    }
+
+    print "/* Generated by mkrigindex.awk from the rig backend sources, do not edit */"
+    print ""
+    print "#include <hamlib/config.h>"
+    print "#include <hamlib/rig.h>"
+    print "#include \"register.h\""
+    print ""
+
+    for (i = 1; i <= n; i++)
+    {
+        print "extern struct rig_caps " e_caps[i] ";"
+    }
+
+    print ""
+    print "struct rig_index_entry rig_index[] ="
+    print "{"
+
+    for (i = 1; i <= n; i++)
+    {
+        print "    { " e_model[i] ", " e_be[i] ", &" e_caps[i] " },"
+    }
+
+    print "    { RIG_MODEL_NONE, 0, NULL }"
+    print "};"
+    print ""
+    print "const int rig_index_count = " n ";"
+    print ""
+    print "const int rig_index_backends[] ="
+    print "{"
+
+    for (i = 1; i <= n; i++)
+    {
+        be = e_be[i]
+
+        if (!(be in listed) && !(be in partial_be))
+        {
+            listed[be] = 1
+
+            for (init in backend)
+            {
+                if (backend[init] == be && (init in partial))
+                {
+                    partial_be[be] = 1
+                }
+            }
+
+            if (!(be in partial_be))
+            {
+                print "    " be ","
+            }
+        }
+    }
+
+    print "    -1"
+    print "};"
+}
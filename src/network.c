@@ -78,6 +78,7 @@
 #include "misc.h"
 #include "asyncpipe.h"
 #include "snapshot_data.h"
+#include "spectrum_reduce.h"
 
 #ifdef HAVE_WINDOWS_H
 // cppcheck-suppress missingInclude
@@ -132,6 +133,11 @@ typedef struct multicast_publisher_priv_data_s
 {
     pthread_t thread_id;
     multicast_publisher_args args;
+    void *delta_state;              // last published state in delta mode
+    struct timespec keyframe_time;
+    volatile int keyframe_requested;
+    rig_comm_status_t keyframe_status;  // comm status of the last keyframe
+    int spectrum_subscriber;        // reduced spectrum subscription or -1
 } multicast_publisher_priv_data;
 
 typedef struct multicast_receiver_args_s
@@ -841,7 +847,8 @@ int network_publish_rig_transceive_data(RIG *rig)
     return result;
 }
 
-int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line)
+static int multicast_publisher_write_spectrum(RIG *rig,
+        const struct rig_spectrum_line *line)
 {
     int result;
     struct rig_state *rs = &rig->state;
@@ -897,6 +904,26 @@ int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line)
     RETURNFUNC2(RIG_OK);
 }
 
+int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line)
+{
+    const multicast_publisher_priv_data *mcast_publisher_priv =
+        (multicast_publisher_priv_data *) rig->state.multicast_publisher_priv_data;
+
+    // Reduced lines come through multicast_publisher_spectrum_cb() instead
+    if (mcast_publisher_priv != NULL && mcast_publisher_priv->spectrum_subscriber >= 0)
+    {
+        return RIG_OK;
+    }
+
+    return multicast_publisher_write_spectrum(rig, line);
+}
+
+static int multicast_publisher_spectrum_cb(RIG *rig,
+        struct rig_spectrum_line *line, rig_ptr_t arg)
+{
+    return multicast_publisher_write_spectrum(rig, line);
+}
+
 static int multicast_publisher_read_packet(multicast_publisher_args
         const *mcast_publisher_args,
         uint8_t *type, struct rig_spectrum_line *spectrum_line,
@@ -963,6 +990,19 @@ static int multicast_publisher_read_packet(multicast_publisher_args
     return (RIG_OK);
 }
 
+// a change of the comm status, e.g. the DISCONNECTED of rig_close, goes out
+// as a keyframe, as a publisher closing down cannot answer a resync
+static int multicast_publisher_keyframe_due(multicast_publisher_priv_data
+        *mcast_publisher_priv, const struct rig_state *rs)
+{
+    return mcast_publisher_priv->delta_state == NULL
+           || mcast_publisher_priv->keyframe_requested
+           || mcast_publisher_priv->keyframe_status != rs->comm_status
+           || (rs->multicast_keyframe_ms > 0
+               && elapsed_ms(&mcast_publisher_priv->keyframe_time,
+                             HAMLIB_ELAPSED_GET) >= rs->multicast_keyframe_ms);
+}
+
 void *multicast_publisher(void *arg)
 {
     unsigned char spectrum_data[HAMLIB_MAX_SPECTRUM_DATA];
@@ -1019,18 +1059,45 @@ void *multicast_publisher(void *arg)
         {
             if (result == -RIG_ETIMEOUT)
             {
+                if (!rs->multicast_delta
+                        || !multicast_publisher_keyframe_due(mcast_publisher_priv, rs))
+                {
+                    continue;
+                }
+
+                packet_type = MULTICAST_PUBLISHER_DATA_PACKET_TYPE_POLL;
+            }
+            else
+            {
+                // TODO: how to detect closing of pipe, indicate with error code
+                // TODO: error handling, flush pipe in case of error?
+                hl_usleep(100 * 1000);
                 continue;
             }
-
-            // TODO: how to detect closing of pipe, indicate with error code
-            // TODO: error handling, flush pipe in case of error?
-            hl_usleep(100 * 1000);
-            continue;
         }
 
-        result = snapshot_serialize(sizeof(snapshot_buffer), snapshot_buffer, rig,
-                                    packet_type == MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM ? &spectrum_line :
-                                    NULL);
+        if (rs->multicast_delta)
+        {
+            int keyframe = multicast_publisher_keyframe_due(mcast_publisher_priv, rs);
+
+            if (keyframe)
+            {
+                mcast_publisher_priv->keyframe_requested = 0;
+                mcast_publisher_priv->keyframe_status = rs->comm_status;
+                elapsed_ms(&mcast_publisher_priv->keyframe_time, HAMLIB_ELAPSED_SET);
+            }
+
+            result = snapshot_serialize_delta(sizeof(snapshot_buffer), snapshot_buffer,
+                                              rig,
+                                              packet_type == MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM ? &spectrum_line :
+                                              NULL, &mcast_publisher_priv->delta_state, keyframe);
+        }
+        else
+        {
+            result = snapshot_serialize(sizeof(snapshot_buffer), snapshot_buffer, rig,
+                                        packet_type == MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM ? &spectrum_line :
+                                        NULL);
+        }
 
         if (result != RIG_OK)
         {
@@ -1039,6 +1106,12 @@ void *multicast_publisher(void *arg)
             continue;
         }
 
+        if (snapshot_buffer[0] == '\0')
+        {
+            // nothing changed since the last delta
+            continue;
+        }
+
         rig_debug(RIG_DEBUG_CACHE, "%s: sending rig snapshot data: %s\n", __func__,
                   snapshot_buffer);
 
@@ -1514,7 +1587,19 @@ void *multicast_receiver(void *arg)
         rig_debug(RIG_DEBUG_VERBOSE, "%s: received %ld bytes of data: %.*s\n", __func__,
                   (long) result, (int) result, data);
 
-        // TODO: if a new snapshot needs to be sent, call network_publish_rig_poll_data() and the publisher routine will send out a snapshot
+        if (snapshot_is_resync_request(data, result))
+        {
+            multicast_publisher_priv_data *mcast_publisher_priv =
+                (multicast_publisher_priv_data *) rs->multicast_publisher_priv_data;
+
+            // a receiver lost a delta, the next snapshot is a keyframe
+            if (mcast_publisher_priv != NULL)
+            {
+                mcast_publisher_priv->keyframe_requested = 1;
+                network_publish_rig_poll_data(rig);
+            }
+        }
+
         // TODO: new logic in publisher needs to be written for other types of responses
     }
 
@@ -1654,6 +1739,7 @@ int network_multicast_publisher_start(RIG *rig, const char *multicast_addr,
     mcast_publisher_priv->args.multicast_addr = multicast_addr;
     mcast_publisher_priv->args.multicast_port = multicast_port;
     mcast_publisher_priv->args.rig = rig;
+    mcast_publisher_priv->spectrum_subscriber = -1;
 
     mutex_status = pthread_mutex_init(&mcast_publisher_priv->args.write_lock, NULL);
 
@@ -1685,6 +1771,25 @@ int network_multicast_publisher_start(RIG *rig, const char *multicast_addr,
         RETURNFUNC(-RIG_EINTERNAL);
     }
 
+    if (rs->multicast_spectrum != NULL && rs->multicast_spectrum[0] != '\0')
+    {
+        rig_spectrum_reduction_t reduction;
+
+        // Already checked when the multicast_spectrum token was set
+        if (rig_spectrum_reduction_parse(rs->multicast_spectrum, &reduction) == RIG_OK)
+        {
+            mcast_publisher_priv->spectrum_subscriber =
+                rig_spectrum_subscribe(rig, &reduction, multicast_publisher_spectrum_cb, NULL);
+        }
+
+        if (mcast_publisher_priv->spectrum_subscriber < 0)
+        {
+            rig_debug(RIG_DEBUG_WARN,
+                      "%s: cannot reduce multicast spectrum '%s', publishing full lines\n",
+                      __func__, rs->multicast_spectrum);
+        }
+    }
+
     RETURNFUNC(RIG_OK);
 }
 
@@ -1712,6 +1817,12 @@ int network_multicast_publisher_stop(RIG *rig)
         RETURNFUNC(RIG_OK);
     }
 
+    if (mcast_publisher_priv->spectrum_subscriber >= 0)
+    {
+        rig_spectrum_unsubscribe(rig, mcast_publisher_priv->spectrum_subscriber);
+        mcast_publisher_priv->spectrum_subscriber = -1;
+    }
+
     if (mcast_publisher_priv->thread_id != 0)
     {
         int err = pthread_join(mcast_publisher_priv->thread_id, NULL);
@@ -1736,6 +1847,7 @@ int network_multicast_publisher_stop(RIG *rig)
 
     pthread_mutex_destroy(&mcast_publisher_priv->args.write_lock);
 
+    snapshot_delta_free(&mcast_publisher_priv->delta_state);
     free(rs->multicast_publisher_priv_data);
     rs->multicast_publisher_priv_data = NULL;
 
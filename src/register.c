@@ -155,44 +155,108 @@ static struct
 
 
 /*
- * This struct to keep track of known rig models.
- * It is chained, and used in a hash table, see below.
+ * Rig models are looked up in rig_index, generated at build time from the
+ * backend sources by mkrigindex.awk and sorted by model number, so that
+ * finding a model only initialises its own backend and listing the models
+ * initialises none.  A backend init still calls rig_register() for each
+ * of its models, which only marks the index entry as registered.  Caps
+ * that are not in the index, e.g. built at runtime or registered by an
+ * application, are kept in rig_extra, also sorted by model number.
  */
+static struct rig_caps **rig_extra;
+static int rig_extra_count;
+static int rig_extra_size;
+
+/* backends whose init has been called, by rig_backend_list index */
+static char rig_backend_loaded[RIG_BACKEND_MAX];
+
+static int rig_index_checked;
+
+
+static int rig_lookup_backend(rig_model_t rig_model);
+static int rig_init_backend(int be_idx);
+
+
 //! @cond Doxygen_Suppress
-struct rig_list
+static int rig_index_cmp(const void *a, const void *b)
 {
-    struct rig_caps *caps;
-    struct rig_list *next;
-};
-//! @endcond
+    const struct rig_index_entry *ea = a;
+    const struct rig_index_entry *eb = b;
 
+    return ea->model < eb->model ? -1 : ea->model > eb->model;
+}
 
-// This size has to be > than the max# of rigs for any manufacturer
-// A fatal error will occur when running rigctl if this value is too small
-//! @cond Doxygen_Suppress
-#define RIGLSTHASHSZ 65535
-#define HASH_FUNC(a) ((a)%RIGLSTHASHSZ)
-//! @endcond
 
+static struct rig_index_entry *rig_index_find(rig_model_t rig_model)
+{
+    int lo = 0;
+    int hi = rig_index_count - 1;
 
-/*
- * The rig_hash_table is a hash table pointing to a list of next==NULL
- *  terminated caps.
- */
-static struct rig_list *rig_hash_table[RIGLSTHASHSZ] = { NULL, };
+    if (!rig_index_checked)
+    {
+        int i;
+
+        /* mkrigindex.awk sorts the table, this only guards the search */
+        for (i = 1; i < rig_index_count; i++)
+        {
+            if (rig_index[i - 1].model >= rig_index[i].model)
+            {
+                rig_debug(RIG_DEBUG_WARN, "%s: rig index not sorted at model %u\n",
+                          __func__, rig_index[i].model);
+                qsort(rig_index, rig_index_count, sizeof(rig_index[0]),
+                      rig_index_cmp);
+                break;
+            }
+        }
 
+        rig_index_checked = 1;
+    }
 
-static int rig_lookup_backend(rig_model_t rig_model);
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if (rig_index[mid].model == rig_model)
+        {
+            return &rig_index[mid];
+        }
+
+        if (rig_index[mid].model < rig_model)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    return NULL;
+}
+
+
+static int rig_extra_find(rig_model_t rig_model)
+{
+    int i;
+
+    for (i = 0; i < rig_extra_count; i++)
+    {
+        if (rig_extra[i]->rig_model == rig_model)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+//! @endcond
 
 
-/*
- * Basically, this is a hash insert function that doesn't check for dup!
- */
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_register(struct rig_caps *caps)
 {
-    int hval;
-    struct rig_list *p;
+    struct rig_index_entry *entry;
+    int i;
 
     //rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -201,57 +265,82 @@ int HAMLIB_API rig_register(struct rig_caps *caps)
         return -RIG_EINVAL;
     }
 
-#if 0
-    rig_debug(RIG_DEBUG_ERR,
-              "%s: rig_register (%u)\n",
-              __func__,
-              caps->rig_model);
-#endif
+    entry = rig_index_find(caps->rig_model);
+
+    if (entry && entry->caps == caps)
+    {
+        entry->registered = 1;
+        entry->unregistered = 0;
+        return RIG_OK;
+    }
 
-    p = (struct rig_list *)calloc(1, sizeof(struct rig_list));
+    i = rig_extra_find(caps->rig_model);
 
-    if (!p)
+    if (i >= 0)
     {
-        return -RIG_ENOMEM;
+        rig_extra[i] = caps;
+        return RIG_OK;
     }
 
-    hval = HASH_FUNC(caps->rig_model);
+    if (rig_extra_count == rig_extra_size)
+    {
+        int size = rig_extra_size ? rig_extra_size * 2 : 16;
+        struct rig_caps **extra = realloc(rig_extra, size * sizeof(*extra));
+
+        if (!extra)
+        {
+            return -RIG_ENOMEM;
+        }
+
+        rig_extra = extra;
+        rig_extra_size = size;
+    }
 
-    if (rig_hash_table[hval])
+    for (i = rig_extra_count; i > 0
+            && rig_extra[i - 1]->rig_model > caps->rig_model; i--)
     {
-        printf("Hash collision!!! Fatal error!!\n");
-        exit(1);
+        rig_extra[i] = rig_extra[i - 1];
     }
 
-    p->caps = caps;
-    // p->handle = NULL;
-    p->next = rig_hash_table[hval];
-    rig_hash_table[hval] = p;
+    rig_extra[i] = caps;
+    rig_extra_count++;
 
-    //RETURNFUNC(RIG_OK);
     return RIG_OK;
 }
 //! @endcond
 
 /*
  * Get rig capabilities.
- * ie. rig_hash_table lookup
+ * Models in rig_index get their backend initialised on first use.
  */
 
 //! @cond Doxygen_Suppress
 struct rig_caps *HAMLIB_API rig_get_caps(rig_model_t rig_model)
 {
-    struct rig_list *p;
+    struct rig_index_entry *entry;
+    int i;
+
+    /* registered over the index, e.g. by an application */
+    i = rig_extra_find(rig_model);
 
-    for (p = rig_hash_table[HASH_FUNC(rig_model)]; p; p = p->next)
+    if (i >= 0)
     {
-        if (p->caps->rig_model == rig_model)
-        {
-            return p->caps;
-        }
+        return rig_extra[i];
+    }
+
+    entry = rig_index_find(rig_model);
+
+    if (!entry || entry->unregistered)
+    {
+        return NULL;    /* sorry, caps not registered! */
+    }
+
+    if (!entry->registered)
+    {
+        rig_init_backend(rig_lookup_backend(rig_model));
     }
 
-    return NULL;    /* sorry, caps not registered! */
+    return entry->registered ? entry->caps : NULL;
 }
 //! @endcond
 
@@ -279,6 +368,28 @@ static int rig_lookup_backend(rig_model_t rig_model)
 }
 //! @endcond
 
+/*
+ * Call the init of backend be_idx unless already done.
+ */
+//! @cond Doxygen_Suppress
+static int rig_init_backend(int be_idx)
+{
+    if (be_idx < 0 || !rig_backend_list[be_idx].be_init_all)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (rig_backend_loaded[be_idx])
+    {
+        return RIG_OK;
+    }
+
+    rig_backend_loaded[be_idx] = 1;
+
+    return (*rig_backend_list[be_idx].be_init_all)(NULL);
+}
+//! @endcond
+
 /*
  * rig_check_backend
  * check the backend declaring this model has been loaded
@@ -290,8 +401,6 @@ int HAMLIB_API rig_check_backend(rig_model_t rig_model)
 {
     const struct rig_caps *caps;
     int be_idx;
-    int retval;
-    int i, n;
 
     /* already loaded ? */
     caps = rig_get_caps(rig_model);
@@ -301,23 +410,6 @@ int HAMLIB_API rig_check_backend(rig_model_t rig_model)
         return RIG_OK;
     }
 
-    // hmmm...no caps so did we already load the rigs?
-    for (n = 0, i = 0; i < RIGLSTHASHSZ; i++)
-    {
-        if (rig_hash_table[i]) { ++n; }
-    }
-
-#if 0 // this stopped a 2nd rig_init call with a valid model to fail -- reversing
-
-    if (n > 1)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: rig model %u not found and rig count=%d\n",
-                  __func__, rig_model, n);
-        return -RIG_ENAVAIL;
-    }
-
-#endif
-
     be_idx = rig_lookup_backend(rig_model);
 
     /*
@@ -332,20 +424,8 @@ int HAMLIB_API rig_check_backend(rig_model_t rig_model)
         return -RIG_ENAVAIL;
     }
 
-    // do we need to load the backend?
-//    if (rig_backend_list[be_idx].be_init_all == 0)
-    {
-        retval = rig_load_backend(rig_backend_list[be_idx].be_name);
-    }
-#if 0
-    else
-    {
-        retval = RIG_OK;
-    }
-
-#endif
-
-    return retval;
+    /* models not in the index, loading the backend registers them */
+    return rig_init_backend(be_idx);
 }
 //! @endcond
 
@@ -354,65 +434,98 @@ int HAMLIB_API rig_check_backend(rig_model_t rig_model)
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_unregister(rig_model_t rig_model)
 {
-    int hval;
-    struct rig_list *p, *q;
+    struct rig_index_entry *entry;
+    int i;
 
-    hval = HASH_FUNC(rig_model);
-    q = NULL;
+    i = rig_extra_find(rig_model);
 
-    for (p = rig_hash_table[hval]; p; p = p->next)
+    if (i >= 0)
     {
-        if (p->caps->rig_model == rig_model)
+        rig_extra_count--;
+        memmove(&rig_extra[i], &rig_extra[i + 1],
+                (rig_extra_count - i) * sizeof(rig_extra[0]));
+        return RIG_OK;
+    }
+
+    entry = rig_index_find(rig_model);
+
+    if (entry && !entry->unregistered)
+    {
+        entry->unregistered = 1;
+        return RIG_OK;
+    }
+
+    return -RIG_EINVAL; /* sorry, caps not registered! */
+}
+//! @endcond
+
+/*
+ * Next registered caps in model order, merging rig_index and rig_extra.
+ * *i and *j are the positions in each, start both at 0.
+ */
+//! @cond Doxygen_Suppress
+static struct rig_caps *rig_list_next(int *i, int *j)
+{
+    while (*i < rig_index_count || *j < rig_extra_count)
+    {
+        const struct rig_index_entry *entry;
+
+        if (*i >= rig_index_count || (*j < rig_extra_count
+                                      && rig_extra[*j]->rig_model <= rig_index[*i].model))
         {
-            if (q == NULL)
-            {
-                rig_hash_table[hval] = p->next;
-            }
-            else
+            /* skip an index entry registered over */
+            if (*i < rig_index_count
+                    && rig_extra[*j]->rig_model == rig_index[*i].model)
             {
-                q->next = p->next;
+                (*i)++;
             }
 
-            free(p);
-            return RIG_OK;
+            return rig_extra[(*j)++];
         }
 
-        q = p;
+        entry = &rig_index[(*i)++];
+
+        /* listed from the index, without initialising the backend */
+        if (!entry->unregistered)
+        {
+            return entry->caps;
+        }
     }
 
-    return -RIG_EINVAL; /* sorry, caps not registered! */
+    return NULL;
 }
 //! @endcond
 
 /*
  * rig_list_foreach
- * executes cfunc on all the elements stored in the rig hash list
+ * executes cfunc on all the registered rig models, in model order
  */
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_list_foreach(int (*cfunc)(struct rig_caps *,
                                 rig_ptr_t),
                                 rig_ptr_t data)
 {
-    struct rig_list *p;
-    int i;
+    struct rig_caps *caps;
+    int i = 0, j = 0;
 
     if (!cfunc)
     {
         return -RIG_EINVAL;
     }
 
-    for (i = 0; i < RIGLSTHASHSZ; i++)
+    while ((caps = rig_list_next(&i, &j)) != NULL)
     {
-        struct rig_list *next = NULL;
+        int count = rig_extra_count;
 
-        for (p = rig_hash_table[i]; p; p = next)
+        if ((*cfunc)(caps, data) == 0)
         {
-            next = p->next;       /* read before call in case it is unregistered */
+            return RIG_OK;
+        }
 
-            if ((*cfunc)(p->caps, data) == 0)
-            {
-                return RIG_OK;
-            }
+        /* caps unregistered from rig_extra by cfunc */
+        if (rig_extra_count < count && j > 0)
+        {
+            j--;
         }
     }
 
@@ -422,33 +535,33 @@ int HAMLIB_API rig_list_foreach(int (*cfunc)(struct rig_caps *,
 
 /*
  * rig_list_foreach_model
- * executes cfunc on all the elements stored in the rig hash list
+ * executes cfunc on all the registered rig models, in model order
  */
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_list_foreach_model(int (*cfunc)(const rig_model_t rig_model,
                                       rig_ptr_t),
                                       rig_ptr_t data)
 {
-    struct rig_list *p;
-    int i;
+    struct rig_caps *caps;
+    int i = 0, j = 0;
 
     if (!cfunc)
     {
         return -RIG_EINVAL;
     }
 
-    for (i = 0; i < RIGLSTHASHSZ; i++)
+    while ((caps = rig_list_next(&i, &j)) != NULL)
     {
-        struct rig_list *next = NULL;
+        int count = rig_extra_count;
 
-        for (p = rig_hash_table[i]; p; p = next)
+        if ((*cfunc)(caps->rig_model, data) == 0)
         {
-            next = p->next;       /* read before call in case it is unregistered */
+            return RIG_OK;
+        }
 
-            if ((*cfunc)(p->caps->rig_model, data) == 0)
-            {
-                return RIG_OK;
-            }
+        if (rig_extra_count < count && j > 0)
+        {
+            j--;
         }
     }
 
@@ -527,11 +640,23 @@ int rig_load_all_backends()
 {
     int i;
 
-    memset(rig_hash_table, 0, sizeof(rig_hash_table));
-
+    /* the models of the other backends are listed from the index */
     for (i = 0; i < RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++)
     {
-        rig_load_backend(rig_backend_list[i].be_name);
+        int j;
+
+        for (j = 0; rig_index_backends[j] >= 0; j++)
+        {
+            if (rig_index_backends[j] == rig_backend_list[i].be_num)
+            {
+                break;
+            }
+        }
+
+        if (rig_index_backends[j] < 0)
+        {
+            rig_init_backend(i);
+        }
     }
 
     return RIG_OK;
@@ -561,6 +686,7 @@ int HAMLIB_API rig_load_backend(const char *be_name)
 
             if (be_init)
             {
+                rig_backend_loaded[i] = 1;
                 return (*be_init)(NULL);
             }
             else
@@ -41,6 +41,26 @@
 #error ABI_VERSION undefined! Did you include config.h?
 #endif
 
+/*
+ * Static index of the rig models, generated into rig_index.c by
+ * mkrigindex.awk and sorted by model number.  The registered flag is
+ * set by rig_register() once the backend has been initialised, the
+ * unregistered flag by rig_unregister().  rig_index_backends lists the
+ * backends all of whose models are in the index, ended by -1.
+ */
+struct rig_index_entry
+{
+    rig_model_t model;
+    int be_num;
+    struct rig_caps *caps;
+    int registered;
+    int unregistered;
+};
+
+extern struct rig_index_entry rig_index[];
+extern const int rig_index_count;
+extern const int rig_index_backends[];
+
 #define PREFIX_INITRIG initrigs
 #define PREFIX_PROBERIG probeallrigs
 
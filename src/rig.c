@@ -77,6 +77,14 @@
 #include "sprintflst.h"
 #include "hamlibdatetime.h"
 #include "cache.h"
+#include "async_set.h"
+#include "async_open.h"
+#include "station.h"
+#include "automation.h"
+#include "spectrum_reduce.h"
+#include "keyer.h"
+#include "rig_handle.h"
+#include "trace.h"
 
 /**
  * \brief Hamlib release number
@@ -242,7 +250,8 @@ static const char *const rigerror_table[] =
     "Argument out of domain of func",
     "Function deprecated",
     "Security error password not provided or crypto failure",
-    "Rig is not powered on"
+    "Rig is not powered on",
+    "Operation cancelled"
 };
 
 
@@ -258,10 +267,12 @@ typedef struct async_data_handler_priv_data_s
 {
     pthread_t thread_id;
     async_data_handler_args args;
+    station_source_t *source;   // frames read by the station loop instead
 } async_data_handler_priv_data;
 
 static int async_data_handler_start(RIG *rig);
 static int async_data_handler_stop(RIG *rig);
+static int async_data_handler_station(void *arg);
 void *async_data_handler(void *arg);
 #endif
 
@@ -522,98 +533,24 @@ static int rig_check_rig_caps()
     return (rc);
 }
 
-/**
- * \brief Allocate a new #RIG handle.
- * \param rig_model The rig model for this new handle
- *
- * Allocates a new RIG handle and initializes the associated data
- * for \a rig_model.
- *
- * \return a pointer to the #RIG handle otherwise NULL if memory allocation
- * failed or \a rig_model is unknown (e.g. backend autoload failed).
- *
- * \sa rig_cleanup(), rig_open()
+/*
+ * The initial state of a handle of the model of rig->caps.  It is
+ * shared by the handles of a model, see rig_handle.c, so it must only
+ * depend on the caps and must not point into the handle.
  */
-RIG *HAMLIB_API rig_init(rig_model_t rig_model)
+static void rig_init_state(RIG *rig)
 {
-    RIG *rig;
-    const struct rig_caps *caps;
+    const struct rig_caps *caps = rig->caps;
     struct rig_state *rs;
     hamlib_port_t *rp, *pttp, *dcdp;
     struct rig_cache *cachep;
     int i;
 
-    if (rig_test_2038(NULL))
-    {
-        rig_debug(RIG_DEBUG_WARN,
-                  "%s: 2038 time test failed....some time values may be incorrect\n", __func__);
-    }
-    else
-    {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: 2038 time test passed\n", __func__);
-    }
-
-    rig_check_rig_caps();
-
-    rig_check_backend(rig_model);
-
-    caps = rig_get_caps(rig_model);
-
-    if (!caps)
-    {
-        return (NULL);
-    }
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: rig_model=%s %s %s\n", __func__,
-              caps->mfg_name,
-              caps->model_name, caps->version);
-
-    if (caps->hamlib_check_rig_caps != NULL)
-    {
-        if (caps->hamlib_check_rig_caps[0] != 'H'
-                || strncmp(caps->hamlib_check_rig_caps, HAMLIB_CHECK_RIG_CAPS,
-                           strlen(caps->hamlib_check_rig_caps)) != 0)
-        {
-            rig_debug(RIG_DEBUG_ERR,
-                      "%s: Error validating integrity of rig_caps\nPossible hamlib DLL incompatibility\n",
-                      __func__);
-            return (NULL);
-        }
-    }
-    else
-    {
-        rig_debug(RIG_DEBUG_WARN,
-                  "%s: backend for %s does not contain hamlib_check_rig_caps\n", __func__,
-                  caps->model_name);
-    }
-
-    /*
-     * okay, we've found it. Allocate some memory and set it to zeros,
-     * and especially  the callbacks
-     */
-    rig = calloc(1, sizeof(RIG));
-
-    if (rig == NULL)
-    {
-        /*
-         * FIXME: how can the caller know it's a memory shortage,
-         *        and not "rig not found" ?
-         */
-        return (NULL);
-    }
-
-    /* caps is const, so we need to tell compiler
-       that we know what we are doing */
-    rig->caps = (struct rig_caps *) caps;
-
     /*
      * populate the rig->state
      * TODO: read the Preferences here!
      */
     rs = STATE(rig);
-#if defined(HAVE_PTHREAD)
-    pthread_mutex_init(&rs->mutex_set_transaction, NULL);
-#endif
 
     //TODO Allocate and link ports
     // For now, use the embedded ones
@@ -727,8 +664,18 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
     rs->multicast_cmd_addr =
         "224.0.0.2"; // enable multicast command server by default
     rs->multicast_cmd_port = 4532;
+    rs->multicast_keyframe_ms = 5000;
+    rs->keyer_type = RIG_PTT_NONE;
+    rs->keyer_bitnum = DEFAULT_CM108_PTT_BITNUM;
+    rs->keyer_wpm = 25;
+    rs->keyer_weight = 50;
+    rs->trace_timing = 100;
     rs->lo_freq = 0;
-    cachep->timeout_ms = 500;  // 500ms cache timeout by default
+    rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL,
+                             500);  // 500ms cache timeout by default
+    rs->cache_target_load = 50;
+    rs->cache_max_ms = 1000;
+    rs->cache_backoff = 1;
     cachep->ptt = 0;
     rs->targetable_vfo = rig->caps->targetable_vfo;
     rs->model_name = rig->caps->model_name;
@@ -888,6 +835,99 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
 
     // we have to copy rs to rig->state_deprecated for DLL backwards compatibility
     memcpy(&rig->state_deprecated, rs, sizeof(rig->state_deprecated));
+}
+
+
+/**
+ * \brief Allocate a new #RIG handle.
+ * \param rig_model The rig model for this new handle
+ *
+ * Allocates a new RIG handle and initializes the associated data
+ * for \a rig_model.
+ *
+ * \return a pointer to the #RIG handle otherwise NULL if memory allocation
+ * failed or \a rig_model is unknown (e.g. backend autoload failed).
+ *
+ * \sa rig_cleanup(), rig_open()
+ */
+RIG *HAMLIB_API rig_init(rig_model_t rig_model)
+{
+    RIG *rig;
+    const struct rig_caps *caps;
+    struct rig_state *rs;
+    static int library_checked;
+
+    /* the same for every handle, once is enough */
+    if (!library_checked)
+    {
+        library_checked = 1;
+
+        if (rig_test_2038(NULL))
+        {
+            rig_debug(RIG_DEBUG_WARN,
+                      "%s: 2038 time test failed....some time values may be incorrect\n", __func__);
+        }
+        else
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: 2038 time test passed\n", __func__);
+        }
+
+        rig_check_rig_caps();
+    }
+
+    rig_check_backend(rig_model);
+
+    caps = rig_get_caps(rig_model);
+
+    if (!caps)
+    {
+        return (NULL);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: rig_model=%s %s %s\n", __func__,
+              caps->mfg_name,
+              caps->model_name, caps->version);
+
+    if (caps->hamlib_check_rig_caps != NULL)
+    {
+        if (caps->hamlib_check_rig_caps[0] != 'H'
+                || strncmp(caps->hamlib_check_rig_caps, HAMLIB_CHECK_RIG_CAPS,
+                           strlen(caps->hamlib_check_rig_caps)) != 0)
+        {
+            rig_debug(RIG_DEBUG_ERR,
+                      "%s: Error validating integrity of rig_caps\nPossible hamlib DLL incompatibility\n",
+                      __func__);
+            return (NULL);
+        }
+    }
+    else
+    {
+        rig_debug(RIG_DEBUG_WARN,
+                  "%s: backend for %s does not contain hamlib_check_rig_caps\n", __func__,
+                  caps->model_name);
+    }
+
+    /*
+     * okay, we've found it. Get a handle in the initial state of the
+     * model, shared with its other handles until written to
+     */
+    rig = rig_handle_new(caps, rig_init_state);
+
+    if (rig == NULL)
+    {
+        /*
+         * FIXME: how can the caller know it's a memory shortage,
+         *        and not "rig not found" ?
+         */
+        return (NULL);
+    }
+
+    rs = STATE(rig);
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_init(&rs->mutex_set_transaction, NULL);
+    pthread_mutex_init(&rs->ptt_mutex, NULL);
+#endif
+
 
     /*
      * let the backend a chance to setup his private data
@@ -904,7 +944,7 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
                       "%s: backend_init failed!\n",
                       __func__);
             /* cleanup and exit */
-            free(rig);
+            rig_handle_free(rig);
             return (NULL);
         }
     }
@@ -1036,7 +1076,15 @@ int HAMLIB_API rig_open(RIG *rig)
     rs->async_data_enabled = rs->async_data_enabled && caps->async_data_supported;
     rp->asyncio = rs->async_data_enabled;
 
-    if (strlen(rp->pathname) > 0)
+    if (rs->trace_replay_pathname)
+    {
+        // replayed responses are served synchronously from the trace
+        rig_debug(RIG_DEBUG_TRACE, "%s: replaying trace %s\n", __func__,
+                  rs->trace_replay_pathname);
+        rs->async_data_enabled = 0;
+        rp->asyncio = 0;
+    }
+    else if (strlen(rp->pathname) > 0)
     {
         char hoststr[256], portstr[6];
         status = parse_hoststr(rp->pathname, sizeof(rp->pathname),
@@ -1103,6 +1151,19 @@ int HAMLIB_API rig_open(RIG *rig)
         RETURNFUNC2(-RIG_EINVAL);
     }
 
+    // a rig_open_async() is still at it
+    if (rig_async_open_busy(rig))
+    {
+        RETURNFUNC2(-RIG_EINVAL);
+    }
+
+    status = rig_open_step(rig, RIG_OPEN_STEP_PORT);
+
+    if (status != RIG_OK)
+    {
+        RETURNFUNC2(status);
+    }
+
     rs->comm_status = RIG_COMM_STATUS_CONNECTING;
 
     rp->fd = -1;
@@ -1146,10 +1207,22 @@ int HAMLIB_API rig_open(RIG *rig)
     }
 
     rp->timeout = caps->timeout;
-    status = port_open(rp);
+
+    // the port is RIG_PORT_REPLAY until port_close() stops the replay
+    if (rs->trace_replay_pathname)
+    {
+        status = port_trace_replay_start(rp, rs->trace_replay_pathname,
+                                         rs->trace_timing, &rs->trace_stats);
+    }
+
+    if (status >= 0)
+    {
+        status = port_open(rp);
+    }
 
     if (status < 0)
     {
+        port_trace_stop(rp);
         rig_debug(RIG_DEBUG_VERBOSE, "%s: rs->comm_state==0?=%d\n", __func__,
                   rs->comm_state);
         rs->comm_state = 0;
@@ -1157,6 +1230,30 @@ int HAMLIB_API rig_open(RIG *rig)
         RETURNFUNC2(status);
     }
 
+    if (rs->trace_record_pathname && !rs->trace_replay_pathname)
+    {
+        status = port_trace_record_start(rp, rs->trace_record_pathname,
+                                         caps->rig_model, &rs->trace_stats);
+    }
+
+    if (status >= 0)
+    {
+        status = rig_open_step(rig, RIG_OPEN_STEP_LINES);
+    }
+
+    if (status < 0)
+    {
+        port_close(rp, rp->type.rig);
+        rs->comm_state = 0;
+        rig->state.comm_status = RIG_COMM_STATUS_ERROR;
+        RETURNFUNC2(status);
+    }
+
+    if (rs->cache_adaptive)
+    {
+        rig_cache_adapt_start(rig);
+    }
+
     switch (pttp->type.ptt)
     {
     case RIG_PTT_NONE:
@@ -1408,7 +1505,8 @@ int HAMLIB_API rig_open(RIG *rig)
 
     if (caps->rig_open != NULL)
     {
-        if (caps->get_powerstat != NULL && !skip_init)
+        if (caps->get_powerstat != NULL && !skip_init
+                && rig_open_step(rig, RIG_OPEN_STEP_POWERSTAT) == RIG_OK)
         {
             powerstat_t powerflag;
             status = rig_get_powerstat(rig, &powerflag);
@@ -1436,7 +1534,13 @@ int HAMLIB_API rig_open(RIG *rig)
             }
         }
 
-        status = caps->rig_open(rig);
+        // a cancel during the power probe is sticky and ends up here
+        status = rig_open_step(rig, RIG_OPEN_STEP_BACKEND);
+
+        if (status == RIG_OK)
+        {
+            status = caps->rig_open(rig);
+        }
 
         if (status != RIG_OK)
         {
@@ -1458,6 +1562,18 @@ int HAMLIB_API rig_open(RIG *rig)
         }
     }
 
+    /* the backend open may have changed the frequency ranges */
+    rig_band_map_build(rig);
+
+    status = rig_open_step(rig, RIG_OPEN_STEP_STATE);
+
+    if (status != RIG_OK)
+    {
+        rp->retry = retry_save;
+        rig_close(rig);
+        RETURNFUNC2(status);
+    }
+
     /*
      * trigger state->current_vfo first retrieval
      */
@@ -1504,6 +1620,17 @@ int HAMLIB_API rig_open(RIG *rig)
         RETURNFUNC2(status);
     }
 
+    status = rig_keyer_start(rig);
+
+    if (status < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: rig_keyer_start failed: %s\n", __func__,
+                  rigerror(status));
+        morse_data_handler_stop(rig);
+        port_close(rp, rp->type.rig);
+        RETURNFUNC2(status);
+    }
+
 #endif
 
     if (rs->auto_disable_screensaver)
@@ -1648,11 +1775,19 @@ int HAMLIB_API rig_close(RIG *rig)
     caps = rig->caps;
     rs = STATE(rig);
 
+    // cancel a rig_open_async() still running, or let its close end
+    rig_async_open_stop(rig);
+
     if (!rs->comm_state)
     {
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    // send what the async sets still have pending while the port is open
+    rig_async_set_stop(rig);
+    rig_automation_stop(rig);
+    rig_keyer_stop(rig);
+
     remove_opened_rig(rig);
 
     rig->state.comm_status = RIG_COMM_STATUS_DISCONNECTED;
@@ -1676,9 +1811,12 @@ int HAMLIB_API rig_close(RIG *rig)
      */
     if (caps->rig_close)
     {
+        rig_open_step(rig, RIG_OPEN_STEP_CLOSE_BACKEND);
         caps->rig_close(rig);
     }
 
+    rig_open_step(rig, RIG_OPEN_STEP_CLOSE_PORT);
+
 
     /*
      * FIXME: what happens if PTT and rig ports are the same?
@@ -1781,6 +1919,7 @@ int HAMLIB_API rig_close(RIG *rig)
 
     dcdp->fd = pttp->fd = -1;
 
+    rig_cache_adapt_stop(rig);
     port_close(rp, rp->type.rig);
 
     // zero split so it will allow it to be set again on open for rigctld
@@ -1814,6 +1953,8 @@ int HAMLIB_API rig_cleanup(RIG *rig)
         return (-RIG_EINVAL);
     }
 
+    rig_async_open_stop(rig);
+
     /*
      * check if they forgot to close the rig
      */
@@ -1832,7 +1973,22 @@ int HAMLIB_API rig_cleanup(RIG *rig)
 
     //TODO Release and null any allocated port structures
 
-    free(rig);
+    free(rig->state.trace_record_pathname);
+    free(rig->state.trace_replay_pathname);
+    free(rig->state.multicast_spectrum);
+    free(rig->state.keyer_pathname);
+    rig_band_map_free(rig);
+    rig_async_set_cleanup(rig);
+    rig_async_open_cleanup(rig);
+    rig_automation_cleanup(rig);
+    rig_spectrum_cleanup(rig);
+    rig_keyer_cleanup(rig);
+    station_leave(rig->state.station, rig);
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_destroy(&rig->state.ptt_mutex);
+#endif
+
+    rig_handle_free(rig);
 
     return (RIG_OK);
 }
@@ -2044,6 +2200,11 @@ int rig_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
         return -RIG_EINVAL;
     }
 
+    if (rig_async_set_queues(rig))
+    {
+        return rig_set_freq_async(rig, vfo, freq);
+    }
+
     curr_band = rig_get_band(rig, freq, -1);
 
     if (rig->state.tx_vfo == vfo && curr_band != last_band)
@@ -2381,6 +2542,21 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
         return -RIG_EINVAL;
     }
 
+    // while rig_open_async() runs answer from the cache before ENTERFUNC,
+    // the call depth belongs to the open
+    if (freq && rig_async_open_busy(rig))
+    {
+        int cache_ms_freq, cache_ms_mode, cache_ms_width;
+
+        vfo = vfo_fixup(rig, vfo, cachep->split);
+
+        if (vfo == RIG_VFO_CURR) { vfo = rig->state.current_vfo; }
+
+        rig_get_cache(rig, vfo, freq, &cache_ms_freq, &mode, &cache_ms_mode, &width,
+                      &cache_ms_width);
+        return RIG_OK;
+    }
+
     ENTERFUNC;
 #if BUILTINFUNC
     rig_debug(RIG_DEBUG_VERBOSE, "%s called vfo=%s, called from %s\n",
@@ -2492,8 +2668,10 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     // We do not want to allow cache response with these values
     int wsjtx_special = ((long) * freq % 100) == 55 || ((long) * freq % 100) == 56;
 
-    if (!wsjtx_special && *freq != 0 && (cache_ms_freq < cachep->timeout_ms
-                                         || (cachep->timeout_ms == HAMLIB_CACHE_ALWAYS
+    int timeout_ms = rig->state.cache_timeouts_ms[HAMLIB_CACHE_FREQ];
+
+    if (!wsjtx_special && *freq != 0 && (cache_ms_freq < timeout_ms
+                                         || (timeout_ms == HAMLIB_CACHE_ALWAYS
                                                  || rig->state.use_cached_freq)))
     {
         rig_debug(RIG_DEBUG_TRACE,
@@ -2656,6 +2834,7 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
         }
     }
 
+    rig_cache_adapt(rig, HAMLIB_CACHE_FREQ, &__begin);
     ELAPSED2;
     LOCK(0);
     RETURNFUNC(retcode);
@@ -2718,6 +2897,11 @@ int HAMLIB_API rig_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
         return -RIG_EINVAL;
     }
 
+    if (rig_async_set_queues(rig))
+    {
+        return rig_set_mode_async(rig, vfo, mode, width);
+    }
+
     ENTERFUNC;
     ELAPSED1;
     LOCK(1);
@@ -2911,6 +3095,21 @@ int HAMLIB_API rig_get_mode(RIG *rig,
         return -RIG_EINVAL;
     }
 
+    // while rig_open_async() runs answer from the cache before ENTERFUNC,
+    // the call depth belongs to the open
+    if (mode && width && rig_async_open_busy(rig))
+    {
+        int cache_ms_freq, cache_ms_mode, cache_ms_width;
+
+        vfo = vfo_fixup(rig, vfo, cachep->split);
+
+        if (vfo == RIG_VFO_CURR) { vfo = rig->state.current_vfo; }
+
+        rig_get_cache(rig, vfo, &freq, &cache_ms_freq, mode, &cache_ms_mode, width,
+                      &cache_ms_width);
+        return RIG_OK;
+    }
+
     ELAPSED1;
     ENTERFUNC;
 
@@ -2948,7 +3147,7 @@ int HAMLIB_API rig_get_mode(RIG *rig,
         use_cache = 1;
     }
 
-    if (cachep->timeout_ms == HAMLIB_CACHE_ALWAYS
+    if (rig->state.cache_timeouts_ms[HAMLIB_CACHE_MODE] == HAMLIB_CACHE_ALWAYS
             || rig->state.use_cached_mode || use_cache)
     {
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age mode=%dms, width=%dms\n",
@@ -2958,8 +3157,9 @@ int HAMLIB_API rig_get_mode(RIG *rig,
         RETURNFUNC(RIG_OK);
     }
 
-    if ((*mode != RIG_MODE_NONE && cache_ms_mode < cachep->timeout_ms)
-            && cache_ms_width < cachep->timeout_ms)
+    if ((*mode != RIG_MODE_NONE
+            && cache_ms_mode < rig->state.cache_timeouts_ms[HAMLIB_CACHE_MODE])
+            && cache_ms_width < rig->state.cache_timeouts_ms[HAMLIB_CACHE_WIDTH])
     {
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age mode=%dms, width=%dms\n",
                   __func__, cache_ms_mode, cache_ms_width);
@@ -3039,6 +3239,7 @@ int HAMLIB_API rig_get_mode(RIG *rig,
 
     rig_set_cache_mode(rig, vfo, *mode, *width);
     rig_cache_show(rig, __func__, __LINE__);
+    rig_cache_adapt(rig, HAMLIB_CACHE_MODE, &__begin);
 
     LOCK(0);
     ELAPSED2;
@@ -3378,6 +3579,14 @@ int HAMLIB_API rig_get_vfo(RIG *rig, vfo_t *vfo)
         return -RIG_EINVAL;
     }
 
+    // while rig_open_async() runs answer from the cache before ENTERFUNC,
+    // the call depth belongs to the open
+    if (rig_async_open_busy(rig))
+    {
+        *vfo = cachep->vfo;
+        return RIG_OK;
+    }
+
     ENTERFUNC;
     ELAPSED1;
 
@@ -3399,7 +3608,7 @@ int HAMLIB_API rig_get_vfo(RIG *rig, vfo_t *vfo)
         use_cache = 1;
     }
 
-    if (cache_ms < cachep->timeout_ms || use_cache)
+    if (cache_ms < rig->state.cache_timeouts_ms[HAMLIB_CACHE_VFO] || use_cache)
     {
         *vfo = cachep->vfo;
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age=%dms, vfo=%s\n", __func__,
@@ -3437,6 +3646,7 @@ int HAMLIB_API rig_get_vfo(RIG *rig, vfo_t *vfo)
                   rigerror(retcode));
     }
 
+    rig_cache_adapt(rig, HAMLIB_CACHE_VFO, &__begin);
     ELAPSED2;
     LOCK(0);
     RETURNFUNC(retcode);
@@ -3465,6 +3675,7 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
     hamlib_port_t *pttp = PTTPORT(rig);
     struct rig_cache *cachep = CACHE(rig);
     int retcode = RIG_OK;
+    int cat_ptt;
 
     if (CHECK_RIG_ARG(rig))
     {
@@ -3477,7 +3688,31 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 
     caps = rig->caps;
 
-    LOCK(1);
+    // hold keying up until station automation has switched to the new band
+    if (ptt != RIG_PTT_OFF && rs->automation_priv_data)
+    {
+        retcode = rig_automation_ptt(rig);
+
+        if (retcode != RIG_OK)
+        {
+            ELAPSED2;
+            RETURNFUNC(retcode);
+        }
+    }
+
+    /* only PTT by CAT command waits for the CAT lock, a DTR/RTS, parallel,
+       CM108 or GPIO line is switched right away under a lock of its own */
+    cat_ptt = pttp->type.ptt == RIG_PTT_RIG
+              || pttp->type.ptt == RIG_PTT_RIG_MICDATA;
+
+    if (cat_ptt)
+    {
+        LOCK(1);
+    }
+    else
+    {
+        MUTEX_LOCK(rs->ptt_mutex);
+    }
 
     switch (pttp->type.ptt)
     {
@@ -3640,6 +3875,7 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
                           "%s: cannot open PTT device \"%s\"\n",
                           __func__,
                           pttp->pathname);
+                MUTEX_UNLOCK(rs->ptt_mutex);
                 ELAPSED2;
                 RETURNFUNC(-RIG_EIO);
             }
@@ -3651,6 +3887,7 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 
             if (RIG_OK != retcode)
             {
+                MUTEX_UNLOCK(rs->ptt_mutex);
                 ELAPSED2;
                 RETURNFUNC(retcode);
             }
@@ -3690,6 +3927,7 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
                           "%s: cannot open PTT device \"%s\"\n",
                           __func__,
                           pttp->pathname);
+                MUTEX_UNLOCK(rs->ptt_mutex);
                 ELAPSED2;
                 RETURNFUNC(-RIG_EIO);
             }
@@ -3702,6 +3940,7 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
             if (RIG_OK != retcode)
             {
                 rig_debug(RIG_DEBUG_ERR, "%s: ser_set_dtr retcode=%d\n", __func__, retcode);
+                MUTEX_UNLOCK(rs->ptt_mutex);
                 ELAPSED2;
                 RETURNFUNC(retcode);
             }
@@ -3741,6 +3980,7 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
     default:
         rig_debug(RIG_DEBUG_WARN, "%s: unknown PTT type=%d\n", __func__,
                   pttp->type.ptt);
+        MUTEX_UNLOCK(rs->ptt_mutex);
         ELAPSED2;
         RETURNFUNC(-RIG_EINVAL);
     }
@@ -3750,11 +3990,6 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
         rs->transmit = ptt != RIG_PTT_OFF;
     }
 
-    // some rigs like the FT-2000 with the SCU-17 need just a bit of time to let the relays work
-    // can affect fake it mode in WSJT-X when the rig is still in transmit and freq change
-    // is requested on a rig that can't change freq on a transmitting VFO
-    if (ptt != RIG_PTT_ON) { hl_usleep(50 * 1000); }
-
     cachep->ptt = ptt;
     elapsed_ms(&cachep->time_ptt, HAMLIB_ELAPSED_SET);
 
@@ -3763,6 +3998,22 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
     memcpy(&rig->state.pttport_deprecated, pttp,
            sizeof(rig->state.pttport_deprecated));
 
+    if (cat_ptt)
+    {
+        LOCK(0);
+    }
+    else
+    {
+        MUTEX_UNLOCK(rs->ptt_mutex);
+    }
+
+    // the settling delays below hold neither lock, so they never hold up
+    // the CAT commands of other threads
+    // some rigs like the FT-2000 with the SCU-17 need just a bit of time to let the relays work
+    // can affect fake it mode in WSJT-X when the rig is still in transmit and freq change
+    // is requested on a rig that can't change freq on a transmitting VFO
+    if (ptt != RIG_PTT_ON) { hl_usleep(50 * 1000); }
+
     if (rig->state.post_ptt_delay > 0) { hl_usleep(rig->state.post_ptt_delay * 1000); }
 
     ELAPSED2;
@@ -3805,6 +4056,14 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
         return -RIG_EINVAL;
     }
 
+    // while rig_open_async() runs answer from the cache before ENTERFUNC,
+    // the call depth belongs to the open
+    if (ptt && rig_async_open_busy(rig))
+    {
+        *ptt = cachep->ptt;
+        return RIG_OK;
+    }
+
     ELAPSED1;
     ENTERFUNC;
 
@@ -3817,7 +4076,7 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     cache_ms = elapsed_ms(&cachep->time_ptt, HAMLIB_ELAPSED_GET);
     rig_debug(RIG_DEBUG_TRACE, "%s: cache check age=%dms\n", __func__, cache_ms);
 
-    if (cache_ms < cachep->timeout_ms)
+    if (cache_ms < rs->cache_timeouts_ms[HAMLIB_CACHE_PTT])
     {
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age=%dms\n", __func__, cache_ms);
         *ptt = cachep->ptt;
@@ -3858,6 +4117,7 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
                 elapsed_ms(&cachep->time_ptt, HAMLIB_ELAPSED_SET);
             }
 
+            rig_cache_adapt(rig, HAMLIB_CACHE_PTT, &__begin);
             ELAPSED2;
             LOCK(0);
             RETURNFUNC(retcode);
@@ -3913,6 +4173,7 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
             }
         }
 
+        rig_cache_adapt(rig, HAMLIB_CACHE_PTT, &__begin);
         ELAPSED2;
         LOCK(0);
         RETURNFUNC(retcode);
@@ -4580,14 +4841,19 @@ int HAMLIB_API rig_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
     vfo_t curr_vfo, tx_vfo = RIG_VFO_CURR;
     freq_t tfreq = 0;
 
-    ENTERFUNC2;
-
     if (CHECK_RIG_ARG(rig))
     {
         rig_debug(RIG_DEBUG_ERR, "%s: rig or rig->caps is null\n", __func__);
         return -RIG_EINVAL;
     }
 
+    if (rig_async_set_queues(rig))
+    {
+        return rig_set_split_freq_async(rig, vfo, tx_freq);
+    }
+
+    ENTERFUNC2;
+
     ELAPSED1;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called vfo=%s, curr_vfo=%s, tx_freq=%.0f\n",
@@ -5833,6 +6099,15 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig,
         return -RIG_EINVAL;
     }
 
+    // while rig_open_async() runs answer from the cache before ENTERFUNC,
+    // the call depth belongs to the open
+    if (split && tx_vfo && rig_async_open_busy(rig))
+    {
+        *split = cachep->split;
+        *tx_vfo = cachep->split_vfo;
+        return RIG_OK;
+    }
+
     ELAPSED1;
     ENTERFUNC;
 
@@ -5865,7 +6140,7 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig,
     cache_ms = elapsed_ms(&cachep->time_split, HAMLIB_ELAPSED_GET);
     rig_debug(RIG_DEBUG_TRACE, "%s: cache check age=%dms\n", __func__, cache_ms);
 
-    if (cache_ms < cachep->timeout_ms)
+    if (cache_ms < rs->cache_timeouts_ms[HAMLIB_CACHE_SPLIT])
     {
         *split = cachep->split;
         *tx_vfo = cachep->split_vfo;
@@ -5881,6 +6156,7 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig,
 
     HAMLIB_TRACE;
     retcode = caps->get_split_vfo(rig, vfo, split, tx_vfo);
+    rig_cache_adapt(rig, HAMLIB_CACHE_SPLIT, &__begin);
 
     if (retcode == RIG_OK)
     {
@@ -7318,6 +7594,12 @@ int HAMLIB_API rig_send_morse(RIG *rig, vfo_t vfo, const char *msg)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    if (rig_keyer_is_active(rig))
+    {
+        // the software keyer keys the rig's key jack whatever its mode
+        RETURNFUNC(rig_keyer_send(rig, msg));
+    }
+
     caps = rig->caps;
 
     if (caps->send_morse == NULL)
@@ -7350,8 +7632,13 @@ int HAMLIB_API rig_send_morse(RIG *rig, vfo_t vfo, const char *msg)
         retcode = caps->send_morse(rig, vfo, msg);
         LOCK(0);
 #endif
-        push(rig->state.fifo_morse, msg);
-        RETURNFUNC(RIG_OK);
+        if (rig->state.fifo_morse == NULL)
+        {
+            // no morse data handler thread to queue for
+            RETURNFUNC(caps->send_morse(rig, vfo, msg));
+        }
+
+        RETURNFUNC(push(rig->state.fifo_morse, msg));
     }
 
     if (!caps->set_vfo)
@@ -7407,6 +7694,11 @@ int HAMLIB_API rig_stop_morse(RIG *rig, vfo_t vfo)
 
     ENTERFUNC;
 
+    if (rig_keyer_is_active(rig))
+    {
+        RETURNFUNC(rig_keyer_abort(rig));
+    }
+
     caps = rig->caps;
 
     if (caps->stop_morse == NULL)
@@ -7414,7 +7706,10 @@ int HAMLIB_API rig_stop_morse(RIG *rig, vfo_t vfo)
         RETURNFUNC(-RIG_ENAVAIL);
     }
 
-    resetFIFO(rig->state.fifo_morse); // clear out the CW queue
+    if (rig->state.fifo_morse)
+    {
+        resetFIFO(rig->state.fifo_morse); // clear out the CW queue
+    }
 
     if (vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
@@ -7514,6 +7809,11 @@ int HAMLIB_API rig_wait_morse(RIG *rig, vfo_t vfo)
 
     ENTERFUNC;
 
+    if (rig_keyer_is_active(rig))
+    {
+        RETURNFUNC(rig_keyer_wait(rig));
+    }
+
     caps = rig->caps;
 
     if (vfo == RIG_VFO_CURR
@@ -8309,6 +8609,20 @@ static int async_data_handler_start(RIG *rig)
     async_data_handler_priv = (async_data_handler_priv_data *)
                               rs->async_data_handler_priv_data;
     async_data_handler_priv->args.rig = rig;
+
+    // a read on the application's main loop would wait for the reply the
+    // loop was to forward, so only a station with its own thread reads
+    if (station_threaded(rs->station))
+    {
+        async_data_handler_priv->source = station_add(rs->station,
+                                          RIGPORT(rig)->fd, async_data_handler_station, NULL, rig, -1);
+
+        if (async_data_handler_priv->source)
+        {
+            RETURNFUNC(RIG_OK);
+        }
+    }
+
     int err = pthread_create(&async_data_handler_priv->thread_id, NULL,
                              async_data_handler, &async_data_handler_priv->args);
 
@@ -8343,6 +8657,21 @@ static int morse_data_handler_start(RIG *rig)
     morse_data_handler_priv = (morse_data_handler_priv_data *)
                               rs->morse_data_handler_priv_data;
     morse_data_handler_priv->args.rig = rig;
+
+    // allocated here so rig_send_morse can queue as soon as rig_open returns
+    if (rs->fifo_morse == NULL)
+    {
+        rs->fifo_morse = calloc(1, sizeof(FIFO_RIG));
+
+        if (rs->fifo_morse == NULL)
+        {
+            free(rs->morse_data_handler_priv_data);
+            rs->morse_data_handler_priv_data = NULL;
+            RETURNFUNC(-RIG_ENOMEM);
+        }
+    }
+
+    initFIFO(rs->fifo_morse);
     value_t keyspd;
     keyspd.i = 25; // default value if KEYSPD doesn't work
     rig_get_level(rig, RIG_VFO_CURR, RIG_LEVEL_KEYSPD, &keyspd);
@@ -8379,6 +8708,8 @@ static int async_data_handler_stop(RIG *rig)
 
     if (async_data_handler_priv != NULL)
     {
+        station_remove(rs->station, async_data_handler_priv->source);
+
         if (async_data_handler_priv->thread_id != 0)
         {
             // all cleanup is done in this function so we can kill thread
@@ -8418,29 +8749,17 @@ static int morse_data_handler_stop(RIG *rig)
     morse_data_handler_priv = (morse_data_handler_priv_data *)
                               rs->morse_data_handler_priv_data;
 
-    // wait until fifo queue is flushed
-    //HAMLIB_TRACE;
-    hl_usleep(100 * 1000);
-
-    //HAMLIB_TRACE;
-    while (peek(rs->fifo_morse) >= 0)
-    {
-        HAMLIB_TRACE;
-        rig_debug(RIG_DEBUG_TRACE, "%s: waiting for fifo queue to flush\n", __func__);
-        hl_usleep(100 * 1000);
-    }
-
-    //HAMLIB_TRACE;
-    hl_usleep(100 * 1000);
-
-    //HAMLIB_TRACE;
     if (morse_data_handler_priv != NULL)
     {
         if (morse_data_handler_priv->thread_id != 0)
         {
-            // all cleanup is done in this function so we can kill thread
-            // Windows was taking 30 seconds to stop without this
-            pthread_cancel(morse_data_handler_priv->thread_id);
+            // the thread hands what is still queued to the rig and returns,
+            // rig_stop_morse first to drop it instead
+            if (rs->fifo_morse)
+            {
+                fifo_wake(rs->fifo_morse);
+            }
+
             int err = pthread_join(morse_data_handler_priv->thread_id, NULL);
 
             if (err)
@@ -8457,17 +8776,103 @@ static int morse_data_handler_stop(RIG *rig)
         rs->morse_data_handler_priv_data = NULL;
     }
 
+    if (rs->fifo_morse)
+    {
+        cleanupFIFO(rs->fifo_morse);
+        free(rs->fifo_morse);
+        rs->fifo_morse = NULL;
+    }
+
     RETURNFUNC(RIG_OK);
 }
 #endif
 
 #if defined(HAVE_PTHREAD)
+// reads one frame, hands a transceive frame to the backend and a reply to
+// the reader of the sync pipe
+static int async_data_handler_read(RIG *rig)
+{
+    // read_frame_direct takes a const buffer, so the compiler takes it as read
+    unsigned char frame[MAX_FRAME_LENGTH] = { 0 };
+    struct rig_state *rs = STATE(rig);
+    int frame_length;
+    int async_frame;
+    int result;
+
+    result = rig->caps->read_frame_direct(rig, sizeof(frame), frame);
+
+    if (result < 0)
+    {
+        // Timeouts occur always if there is nothing to receive, so they are not really errors in this case
+        if (result != -RIG_ETIMEOUT)
+        {
+            // TODO: it may be necessary to have mutex locking on transaction_active flag
+            if (rs->transaction_active)
+            {
+                unsigned char data = (unsigned char) result;
+                write_block_sync_error(RIGPORT(rig), &data, 1);
+            }
+
+            // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
+            rig_debug(RIG_DEBUG_ERR, "%s: read_frame_direct() failed, result=%d\n",
+                      __func__, result);
+        }
+
+        return result;
+    }
+
+    frame_length = result;
+
+    async_frame = rig->caps->is_async_frame(rig, frame_length, frame);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: received frame: len=%d async=%d\n", __func__,
+              frame_length, async_frame);
+
+    if (async_frame)
+    {
+        result = rig->caps->process_async_frame(rig, frame_length, frame);
+
+        if (result < 0)
+        {
+            // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
+            rig_debug(RIG_DEBUG_ERR, "%s: process_async_frame() failed, result=%d\n",
+                      __func__, result);
+        }
+    }
+    else
+    {
+        result = write_block_sync(RIGPORT(rig), frame, frame_length);
+
+        if (result < 0)
+        {
+            // TODO: error handling? can writing to a pipe really fail in ways we can recover from?
+            rig_debug(RIG_DEBUG_ERR, "%s: write_block_sync() failed, result=%d\n", __func__,
+                      result);
+        }
+    }
+
+    return RIG_OK;
+}
+
+// the station loop found the rig port readable
+static int async_data_handler_station(void *arg)
+{
+    int result = async_data_handler_read((RIG *) arg);
+
+    // the same pause as the thread takes after a failed read
+    if (result < 0 && result != -RIG_ETIMEOUT)
+    {
+        return 500;
+    }
+
+    return 0;
+}
+
 void *async_data_handler(void *arg)
 {
     struct async_data_handler_args_s *args = (struct async_data_handler_args_s *)
             arg;
     RIG *rig = args->rig;
-    unsigned char frame[MAX_FRAME_LENGTH];
     struct rig_state *rs = STATE(rig);
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: Starting async data handler thread\n",
@@ -8479,214 +8884,233 @@ void *async_data_handler(void *arg)
 
     while (rs->async_data_handler_thread_run)
     {
-        int frame_length;
-        int async_frame;
-        int result;
-
-        result = rig->caps->read_frame_direct(rig, sizeof(frame), frame);
+        int result = async_data_handler_read(rig);
 
         if (result < 0)
         {
-            // Timeouts occur always if there is nothing to receive, so they are not really errors in this case
             if (result != -RIG_ETIMEOUT)
             {
-                // TODO: it may be necessary to have mutex locking on transaction_active flag
-                if (rs->transaction_active)
-                {
-                    unsigned char data = (unsigned char) result;
-                    write_block_sync_error(RIGPORT(rig), &data, 1);
-                }
-
-                // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
-                rig_debug(RIG_DEBUG_ERR, "%s: read_frame_direct() failed, result=%d\n",
-                          __func__, result);
                 hl_usleep(500 * 1000);
             }
 
             hl_usleep(20 * 1000);
-            continue;
         }
+    }
 
-        frame_length = result;
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: Stopping async data handler thread\n",
+              __func__);
 
-        async_frame = rig->caps->is_async_frame(rig, frame_length, frame);
+    pthread_exit(NULL);
+    return NULL;
+}
+#endif
 
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: received frame: len=%d async=%d\n", __func__,
-                  frame_length, async_frame);
+#if defined(HAVE_PTHREAD)
+/*
+ * Estimate of what the rig still has to key: the time each character sent
+ * to it will be keyed by, at the keying speed it was sent at.
+ */
+struct morse_keyed
+{
+    double *end_ms;     // ring of qsize entries
+    int first;
+    int count;
+    int qsize;
+    struct timespec start;
+};
 
-        if (async_frame)
-        {
-            result = rig->caps->process_async_frame(rig, frame_length, frame);
+static double morse_keyed_now(struct morse_keyed *k)
+{
+    return elapsed_ms(&k->start, HAMLIB_ELAPSED_GET);
+}
 
-            if (result < 0)
-            {
-                // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
-                rig_debug(RIG_DEBUG_ERR, "%s: process_async_frame() failed, result=%d\n",
-                          __func__, result);
-                continue;
-            }
-        }
-        else
-        {
-            result = write_block_sync(RIGPORT(rig), frame, frame_length);
+// forgets the characters keyed by now and returns how many are left
+static int morse_keyed_pending(struct morse_keyed *k)
+{
+    double now = morse_keyed_now(k);
 
-            if (result < 0)
-            {
-                // TODO: error handling? can writing to a pipe really fail in ways we can recover from?
-                rig_debug(RIG_DEBUG_ERR, "%s: write_block_sync() failed, result=%d\n", __func__,
-                          result);
-                continue;
-            }
+    while (k->count > 0 && k->end_ms[k->first] <= now)
+    {
+        k->first = (k->first + 1) % k->qsize;
+        k->count--;
+    }
+
+    return k->count;
+}
+
+static void morse_keyed_add(struct morse_keyed *k, const char *text, int wpm)
+{
+    double end = morse_keyed_now(k);
+
+    if (k->count > 0)
+    {
+        double last = k->end_ms[(k->first + k->count - 1) % k->qsize];
+        end = last > end ? last : end;
+    }
+
+    for (; *text; text++)
+    {
+        end += dot10ths_to_millis(morse_code_char_to_dot10ths(*text), wpm);
+
+        if (k->count == k->qsize)
+        {
+            // more than the estimate says fits, the rig took it anyway
+            k->first = (k->first + 1) % k->qsize;
+            k->count--;
         }
+
+        k->end_ms[(k->first + k->count) % k->qsize] = end;
+        k->count++;
     }
+}
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: Stopping async data handler thread\n",
-              __func__);
+// ms until the nth oldest character pending is keyed
+static int morse_keyed_wait_ms(struct morse_keyed *k, int n)
+{
+    double ms;
 
-    pthread_exit(NULL);
-    return NULL;
+    if (n > k->count) { n = k->count; }
+
+    if (n <= 0) { return 0; }
+
+    ms = k->end_ms[(k->first + n - 1) % k->qsize] - morse_keyed_now(k);
+
+    return ms > 1 ? (int) ms : 1;
 }
-#endif
 
-#if defined(HAVE_PTHREAD)
+/*
+ * Hands the queued text to the rig as soon as it comes, and then keeps the
+ * rig's CW buffer of morse_qsize characters topped up without overflowing
+ * it, from an estimate of what is left to key at the current speed.  The
+ * text goes out in chunks of at least half the buffer, or all there is, and
+ * those are sent while the rest of the buffer is still keying, so there
+ * are no gaps between them.  rig_stop_morse wakes the thread to drop the
+ * queue and the estimate at once.
+ */
 void *morse_data_handler(void *arg)
 {
     struct morse_data_handler_args_s *args =
         (struct morse_data_handler_args_s *) arg;
     RIG *rig = args->rig;
-    const struct rig_state *rs = STATE(rig);
+    struct rig_state *rs = STATE(rig);
+    morse_data_handler_priv_data *morse_data_handler_priv =
+        (morse_data_handler_priv_data *) rs->morse_data_handler_priv_data;
+    FIFO_RIG *fifo = rs->fifo_morse;
+    struct morse_keyed keyed;
+    char *c;
     int result;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: Starting morse data handler thread\n",
               __func__);
 
-    if (STATE(rig)->fifo_morse == NULL)
-    {
-        // Can't use rs-> 'cuz it's const
-        STATE(rig)->fifo_morse = calloc(1, sizeof(FIFO_RIG));
-    }
-
-    initFIFO(rs->fifo_morse);
-
-    char *c;
     int qsize = rig->caps->morse_qsize; // if backend overrides qsize
 
     if (qsize == 0) { qsize = 20; } // shortest length of any rig's CW morse capability
 
+    memset(&keyed, 0, sizeof(keyed));
+    keyed.qsize = qsize;
+    keyed.end_ms = calloc(qsize, sizeof(double));
+    elapsed_ms(&keyed.start, HAMLIB_ELAPSED_SET);
     c = calloc(1, qsize + 1);
 
-    while (rs->morse_data_handler_thread_run || (peek(rig->state.fifo_morse) >= 0))
+    if (keyed.end_ms == NULL || c == NULL)
     {
-        int n = 0;
-        memset(c, 0, qsize);
+        free(keyed.end_ms);
+        free(c);
+        return NULL;
+    }
+
+    while (rs->morse_data_handler_thread_run || fifo_count(fifo) > 0)
+    {
+        int queued = fifo_wait(fifo, 1000);
+        int room, want, n;
 
-        for (n = 0; n < qsize; n++)
+        if (fifo_flushed(fifo, 1))
         {
-            int d = peek(rs->fifo_morse);
+            // rig_stop_morse cleared the rig's buffer too
+            keyed.count = 0;
+            continue;
+        }
+
+        if (queued == 0)
+        {
+            continue;
+        }
+
+        room = qsize - morse_keyed_pending(&keyed);
+        want = queued < qsize / 2 ? queued : qsize / 2;
+
+        if (want < 1) { want = 1; }
+
+        if (room < want)
+        {
+            fifo_sleep(fifo, morse_keyed_wait_ms(&keyed, want - room));
+            continue;
+        }
+
+        for (n = 0; n < room && n < qsize; n++)
+        {
+            int d = pop(fifo);
 
             if (d < 0)
             {
                 break;
             }
 
-            d = pop(rs->fifo_morse);
             c[n] = (char) d;
         }
 
-        if (n > 0)
-        {
-#if 0
-// this does not work well at all -- rigs do not queue keyspd so any change is immediate
-// don't know if we can ever implement this
-            char *p;
-            // if we have + or - we will adjust speed and send before/speed/after which hopefully works
-            // I suspect some rigs will change speed immediately and not wait for queued character to flush
-            morse_data_handler_priv_data *morse_data_handler_priv =
-                (morse_data_handler_priv_data *) rs->morse_data_handler_priv_data;
-            value_t keyspd;
-            keyspd.i = morse_data_handler_priv->keyspd;
-            rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): keyspd=%d\n", __func__, __LINE__,
-                      keyspd.i);
-
-            if ((p = strchr(c, '+')) || (p = strchr(c, '-')))
-            {
-                HAMLIB_TRACE;
-                char spdchg = *p;
-                *p = 0;
+        c[n] = '\0';
 
-                if (strlen(c) > 0) { rig->caps->send_morse(rig, RIG_VFO_CURR, c); }
+        if (n == 0)
+        {
+            continue;
+        }
 
-                rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): keyspd=%d\n", __func__, __LINE__,
-                          keyspd.i);
-                keyspd.i += spdchg == '+' ? 5 : -5;
-                rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): keyspd=%d\n", __func__, __LINE__,
-                          keyspd.i);
+        int wpm = morse_data_handler_priv->keyspd > 0 ?
+                  morse_data_handler_priv->keyspd : 25;
+        int nloops = 10;
+        MUTEX_LOCK(morse_mutex);
 
-                while (p[1] == '+' || p[1] == '-')
-                {
-                    HAMLIB_TRACE;
-                    keyspd.i += p[1] == '+' ? 5 : -5;
-                    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): keyspd=%d\n", __func__, __LINE__,
-                              keyspd.i);
-                    p++;
-                }
+        do
+        {
+            result = rig->caps->send_morse(rig, RIG_VFO_CURR, c);
 
-                p++;
-                rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): keyspd=%d\n", __func__, __LINE__,
-                          keyspd.i);
-                rig_set_level(rig, RIG_VFO_CURR, RIG_LEVEL_KEYSPD,  keyspd);
-                morse_data_handler_priv->keyspd = keyspd.i;
-                memmove(c, p, p - c + 1);
+            if (result == RIG_OK)
+            {
+                break;
             }
 
-#endif
+            rig_debug(RIG_DEBUG_ERR, "%s: error: %s\n", __func__, rigerror(result));
 
-            if (strlen(c) > 0)
+            if (result == -RIG_EINVAL)
             {
-                int nloops = 10;
-                MUTEX_LOCK(morse_mutex);
-
-                do
-                {
-                    result = rig->caps->send_morse(rig, RIG_VFO_CURR, c);
-
-                    if (result != RIG_OK)
-                    {
-                        rig_debug(RIG_DEBUG_ERR, "%s: error: %s\n", __func__, rigerror(result));
-
-                        if (result == -RIG_EINVAL)
-                        {
-                            // severe error -- so flush it and stop
-                            resetFIFO(rs->fifo_morse);
-                            nloops = 0;
-                        }
-
-                        hl_usleep(100 * 1000);
-                    }
-
-                    //wait_morse_ptt(rig, RIG_VFO_CURR);
-                    nloops--;
+                // severe error -- so flush it and stop
+                resetFIFO(fifo);
+                break;
+            }
 
-                }
-                while (result != RIG_OK && STATE(rig)->fifo_morse->flush == 0 && --nloops > 0);
+            // the rig's buffer is fuller than estimated, e.g. after a speed
+            // change, try again once the next character is keyed
+            fifo_sleep(fifo, keyed.count > 0 ? morse_keyed_wait_ms(&keyed, 1) :
+                       dot10ths_to_millis(morse_code_char_to_dot10ths('0'), wpm));
+        }
+        while (!fifo_flushed(fifo, 0) && --nloops > 0);
 
-                MUTEX_UNLOCK(morse_mutex);
+        MUTEX_UNLOCK(morse_mutex);
 
-                if (nloops == 0)
-                {
-                    rig_debug(RIG_DEBUG_ERR, "%s: send_morse failed\n", __func__);
-                }
-            }
+        if (result == RIG_OK)
+        {
+            morse_keyed_add(&keyed, c, wpm);
+        }
+        else if (nloops == 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: send_morse failed\n", __func__);
         }
-
-        rs->fifo_morse->flush = 0; // reset flush flag
-        hl_usleep(100 * 1000);
     }
 
-    free(STATE(rig)->fifo_morse);
+    free(keyed.end_ms);
     free(c);
-    STATE(rig)->fifo_morse = NULL;
-    pthread_exit(NULL);
     return NULL;
 }
 #endif
@@ -0,0 +1,284 @@
+/*
+ *  Hamlib Interface - shared RIG handles
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file rig_handle.c
+ * \brief Copy-on-write RIG handles
+ *
+ * Every new RIG of a model starts with the same state: the range lists,
+ * tuning steps, filters, calibration and granularity tables copied from
+ * the caps, and defaults for the rest.  The tables have to stay in
+ * struct rig_state where backends and applications expect them, so
+ * instead of filling in a fresh copy for each handle the first rig_init()
+ * of a model writes the initial RIG once to a memory file and later
+ * handles map that file privately.  A page is copied only when a handle
+ * writes to it, so the tables stay shared unless the backend or a conf
+ * setting overrides them, and a process with hundreds of receivers pays
+ * only for the pages each one changes.
+ *
+ * The memory file of a model is closed when its last handle is freed.
+ *
+ * Without memfd_create() and mmap() each handle is allocated and set up
+ * on its own as before.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_PTHREAD)
+#define SHARED_HANDLES 1
+#include <sys/mman.h>
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "rig_handle.h"
+
+//! @cond Doxygen_Suppress
+#ifdef SHARED_HANDLES
+struct rig_handle_template
+{
+    const struct rig_caps *caps;
+    struct rig_caps caps_copy;  /* the caps the template was made from */
+    int fd;                     /* memory file with the initial RIG, -1 if none */
+    int handles;                /* handles mapped from it */
+    struct rig_handle_template *next;
+};
+
+static struct rig_handle_template *templates;
+static pthread_mutex_t templates_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* write the initial RIG of the model to a memory file */
+static int template_create(const struct rig_caps *caps,
+                           rig_handle_setup_t setup)
+{
+    const char *p;
+    size_t left;
+    RIG *image;
+    int fd;
+
+    image = calloc(1, sizeof(RIG));
+
+    if (!image)
+    {
+        return -1;
+    }
+
+    image->caps = (struct rig_caps *) caps;
+    setup(image);
+    image->state.shared_handle = 1;
+
+    fd = memfd_create("hamlib-rig", MFD_CLOEXEC);
+
+    for (p = (const char *) image, left = sizeof(RIG); fd >= 0 && left > 0;)
+    {
+        ssize_t n = write(fd, p, left);
+
+        if (n <= 0)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: cannot write the template of %s\n",
+                      __func__, caps->model_name);
+            close(fd);
+            fd = -1;
+            break;
+        }
+
+        p += n;
+        left -= n;
+    }
+
+    free(image);
+
+    return fd;
+}
+
+
+/* the template of the model, made again if a backend changed its caps */
+static struct rig_handle_template *template_get(const struct rig_caps *caps,
+        rig_handle_setup_t setup)
+{
+    struct rig_handle_template *t;
+
+    for (t = templates; t; t = t->next)
+    {
+        if (t->caps == caps)
+        {
+            break;
+        }
+    }
+
+    if (!t)
+    {
+        t = calloc(1, sizeof(*t));
+
+        if (!t)
+        {
+            return NULL;
+        }
+
+        t->caps = caps;
+        t->fd = -1;
+        t->next = templates;
+        templates = t;
+    }
+    else if (t->fd >= 0 && memcmp(&t->caps_copy, caps, sizeof(*caps)) == 0)
+    {
+        return t;
+    }
+
+    /* handles mapped from the old file keep it until they are freed */
+    if (t->fd >= 0)
+    {
+        close(t->fd);
+    }
+
+    memcpy(&t->caps_copy, caps, sizeof(*caps));
+    t->fd = template_create(caps, setup);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s template %s\n", __func__,
+              caps->model_name, t->fd >= 0 ? "created" : "failed");
+
+    return t;
+}
+
+
+/* drops a handle of the model, the last one releases the template */
+static void template_put(const struct rig_caps *caps, int mapped)
+{
+    struct rig_handle_template **tp;
+
+    for (tp = &templates; *tp; tp = &(*tp)->next)
+    {
+        struct rig_handle_template *t = *tp;
+
+        if (t->caps != caps)
+        {
+            continue;
+        }
+
+        if (mapped)
+        {
+            t->handles--;
+        }
+
+        if (t->handles <= 0)
+        {
+            if (t->fd >= 0)
+            {
+                close(t->fd);
+            }
+
+            *tp = t->next;
+            free(t);
+        }
+
+        return;
+    }
+}
+#endif
+//! @endcond
+
+
+/**
+ * \brief Allocate a RIG handle in its initial state
+ * \param caps The capabilities of the model
+ * \param setup Fills in the initial state of a zeroed handle
+ *
+ * \a setup must only depend on the caps and must not store pointers into
+ * the handle, since its result may be shared by every handle of the
+ * model.
+ *
+ * \return the handle, or NULL if out of memory.
+ */
+RIG *rig_handle_new(const struct rig_caps *caps, rig_handle_setup_t setup)
+{
+    RIG *rig;
+
+#ifdef SHARED_HANDLES
+    struct rig_handle_template *t;
+
+    pthread_mutex_lock(&templates_mutex);
+    t = template_get(caps, setup);
+    rig = MAP_FAILED;
+
+    if (t && t->fd >= 0)
+    {
+        rig = mmap(NULL, sizeof(RIG), PROT_READ | PROT_WRITE, MAP_PRIVATE, t->fd, 0);
+    }
+
+    if (rig != MAP_FAILED)
+    {
+        t->handles++;
+    }
+    else if (t)
+    {
+        template_put(caps, 0);
+    }
+
+    pthread_mutex_unlock(&templates_mutex);
+
+    if (rig != MAP_FAILED)
+    {
+        return rig;
+    }
+
+#endif
+
+    rig = calloc(1, sizeof(RIG));
+
+    if (!rig)
+    {
+        return NULL;
+    }
+
+    rig->caps = (struct rig_caps *) caps;
+    setup(rig);
+
+    return rig;
+}
+
+
+/**
+ * \brief Release a RIG handle from rig_handle_new()
+ * \param rig The handle
+ */
+void rig_handle_free(RIG *rig)
+{
+#ifdef SHARED_HANDLES
+
+    if (rig->state.shared_handle)
+    {
+        const struct rig_caps *caps = rig->caps;
+
+        munmap(rig, sizeof(RIG));
+        pthread_mutex_lock(&templates_mutex);
+        template_put(caps, 1);
+        pthread_mutex_unlock(&templates_mutex);
+        return;
+    }
+
+#endif
+
+    free(rig);
+}
@@ -0,0 +1,31 @@
+/*
+ *  Hamlib Interface - shared RIG handle header
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _RIG_HANDLE_H
+#define _RIG_HANDLE_H 1
+
+#include <hamlib/rig.h>
+
+typedef void (*rig_handle_setup_t)(RIG *rig);
+
+RIG *rig_handle_new(const struct rig_caps *caps, rig_handle_setup_t setup);
+void rig_handle_free(RIG *rig);
+
+#endif
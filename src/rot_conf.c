@@ -41,6 +41,7 @@
 #include <hamlib/rotator.h>
 
 #include "rot_conf.h"
+#include "rot_track.h"
 #include "token.h"
 
 
@@ -104,6 +105,16 @@ static const struct confparams rotfrontend_cfg_params[] =
         "Adjust azimuth 180 degrees for south oriented rotators",
         "0", RIG_CONF_CHECKBUTTON,
     },
+    {
+        TOK_TRACK_DEADBAND, "track_deadband", "Tracking deadband",
+        "How far in degrees each position sent while following a trajectory leads it",
+        "2", RIG_CONF_NUMERIC, { .n = { 0.1, 90, .1 } }
+    },
+    {
+        TOK_TRACK_INTERVAL, "track_interval", "Tracking interval",
+        "How often in ms the position is read while following a trajectory",
+        "250", RIG_CONF_NUMERIC, { .n = { 10, 10000, 1 } }
+    },
 
     { RIG_CONF_END, NULL, }
 };
@@ -326,6 +337,10 @@ int frontrot_set_conf(ROT *rot, hamlib_token_t token, const char *val)
         rs->south_zero = atoi(val);
         break;
 
+    case TOK_TRACK_DEADBAND:
+    case TOK_TRACK_INTERVAL:
+        return rot_track_set_conf(rot, token, val);
+
 
     case TOK_RTS_STATE:
         if (rotp->type.rig != RIG_PORT_SERIAL)
@@ -547,6 +562,10 @@ int frontrot_get_conf(ROT *rot, hamlib_token_t token, char *val, int val_len)
         SNPRINTF(val, val_len, "%d", rs->south_zero);
         break;
 
+    case TOK_TRACK_DEADBAND:
+    case TOK_TRACK_INTERVAL:
+        return rot_track_get_conf(rot, token, val, val_len);
+
     default:
         return -RIG_EINVAL;
     }
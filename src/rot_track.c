@@ -0,0 +1,934 @@
+/*
+ *  Hamlib Interface - rotator trajectory tracker
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file rot_track.c
+ * \brief Rotator trajectory tracker
+ *
+ * Satellite trackers send a new position every second or two, and
+ * controllers like the GS-232 or the SPID stop and start again on each
+ * one.  Given the whole time-stamped path of a pass instead, a thread per
+ * rotator reads the position at a fixed interval and sends each position
+ * a deadband ahead of the path, early enough for the measured command
+ * latency and slew rate to bring the rotator there before the path does.
+ * The rotator makes one move per deadband of path and the pointing error
+ * stays around the deadband.
+ *
+ * Before the pass starts the path is put in one continuous turn that fits
+ * the azimuth range of the rotator, so that crossing north does not
+ * unwind the rotator, and when no turn fits a rotator that reaches 180
+ * degrees of elevation follows the path flipped over the zenith.
+ */
+
+/**
+ * \addtogroup rotator
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/rotator.h>
+#include "rot_track.h"
+#include "station.h"
+#include "token.h"
+#include "misc.h"
+
+//! @cond Doxygen_Suppress
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define ROT_TRACK_DEFAULT_DEADBAND 2.0
+#define ROT_TRACK_DEFAULT_INTERVAL_MS 250
+/* until a slew has been measured */
+#define ROT_TRACK_DEFAULT_RATE 2.0
+/* reads failing in a row before giving up */
+#define ROT_TRACK_MAX_ERRORS 3
+/* how long past the end of the path to wait for the rotator */
+#define ROT_TRACK_SETTLE_S 30
+
+struct rot_track_priv
+{
+    double deadband;
+    int interval_ms;
+    rot_track_point_t *path;    /* as sent to the rotator */
+    int npoints;
+    int sent;                   /* a position was sent */
+    double sent_time;           /* path time of the last position sent */
+    double error_sum_sq;
+    unsigned long error_count;
+    rot_track_status_t status;
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;        /* the thread must stop */
+    pthread_t thread_id;
+    station_source_t *source;   /* run by the station loop instead */
+    int running;
+    int stop;
+    /* kept from one read to the next */
+    azimuth_t last_az;
+    elevation_t last_el;
+    double last_read;
+    int errors;
+#endif
+};
+
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static double norm180(double a)
+{
+    a = fmod(a, 360.0);
+
+    if (a > 180.0)
+    {
+        a -= 360.0;
+    }
+    else if (a <= -180.0)
+    {
+        a += 360.0;
+    }
+
+    return a;
+}
+
+
+static double clamp(double v, double lo, double hi)
+{
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+
+/* the larger of the two axis moves, what the slower motor has to cover */
+static double axis_dist(azimuth_t az1, elevation_t el1, azimuth_t az2,
+                        elevation_t el2)
+{
+    double daz = fabs(az1 - az2);
+    double del = fabs(el1 - el2);
+
+    return daz > del ? daz : del;
+}
+
+
+/* angle between two directions, also right across a flip */
+static double pointing_error(azimuth_t az1, elevation_t el1, azimuth_t az2,
+                             elevation_t el2)
+{
+    double c = sin(el1 * M_PI / 180) * sin(el2 * M_PI / 180)
+               + cos(el1 * M_PI / 180) * cos(el2 * M_PI / 180)
+               * cos((az1 - az2) * M_PI / 180);
+
+    return acos(clamp(c, -1, 1)) * 180 / M_PI;
+}
+
+
+static void path_at(const struct rot_track_priv *priv, double t,
+                    azimuth_t *az, elevation_t *el)
+{
+    const rot_track_point_t *p = priv->path;
+    int lo = 0, hi = priv->npoints - 1;
+    double f;
+
+    if (t <= p[0].time || hi == 0)
+    {
+        *az = p[0].az;
+        *el = p[0].el;
+        return;
+    }
+
+    if (t >= p[hi].time)
+    {
+        *az = p[hi].az;
+        *el = p[hi].el;
+        return;
+    }
+
+    while (hi - lo > 1)
+    {
+        int mid = (lo + hi) / 2;
+
+        if (p[mid].time <= t)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    f = (t - p[lo].time) / (p[hi].time - p[lo].time);
+    *az = p[lo].az + f * (p[hi].az - p[lo].az);
+    *el = p[lo].el + f * (p[hi].el - p[lo].el);
+}
+
+
+/* the first time after t the path is the deadband away from where it is at t */
+static double path_ahead(const struct rot_track_priv *priv, double t)
+{
+    const rot_track_point_t *p = priv->path;
+    azimuth_t az0, az;
+    elevation_t el0, el;
+    int i;
+
+    path_at(priv, t, &az0, &el0);
+
+    for (i = 1; i < priv->npoints; i++)
+    {
+        double lo, hi;
+        int n;
+
+        if (p[i].time <= t
+                || axis_dist(p[i].az, p[i].el, az0, el0) < priv->deadband)
+        {
+            continue;
+        }
+
+        lo = p[i - 1].time > t ? p[i - 1].time : t;
+        hi = p[i].time;
+
+        for (n = 0; n < 20; n++)
+        {
+            double mid = (lo + hi) / 2;
+
+            path_at(priv, mid, &az, &el);
+
+            if (axis_dist(az, el, az0, el0) >= priv->deadband)
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid;
+            }
+        }
+
+        return hi;
+    }
+
+    return p[priv->npoints - 1].time;
+}
+
+
+/*
+ * Put the path in one continuous turn inside the azimuth range, the turn
+ * nearest to the current azimuth, flipped if it has to.  Returns 0 when
+ * no turn fits, the rotator will then go round where the path crosses
+ * the end stop.
+ */
+static int track_plan(ROT *rot, struct rot_track_priv *priv,
+                      const rot_track_point_t *points, azimuth_t cur_az)
+{
+    const struct rot_state *rs = ROTSTATE(rot);
+    double az_lo = rs->min_az - rs->az_offset;
+    double az_hi = rs->max_az - rs->az_offset;
+    double el_lo = rs->min_el - rs->el_offset;
+    double el_hi = rs->max_el - rs->el_offset;
+    rot_track_point_t *path = priv->path;
+    int flip;
+    int i;
+
+    for (flip = 0; flip <= 1; flip++)
+    {
+        double az_min, az_max;
+        int k_lo, k_hi, k;
+
+        if (flip && el_hi < 180)
+        {
+            break;
+        }
+
+        for (i = 0; i < priv->npoints; i++)
+        {
+            double az = points[i].az + (flip ? 180 : 0);
+            double el = clamp(points[i].el, el_lo, 90);
+
+            path[i].time = points[i].time;
+
+            if (i == 0)
+            {
+                path[i].az = fmod(az, 360) < 0 ? fmod(az, 360) + 360 : fmod(az, 360);
+            }
+            else
+            {
+                path[i].az = path[i - 1].az
+                             + norm180(az - points[i - 1].az - (flip ? 180 : 0));
+            }
+
+            path[i].el = flip ? clamp(180 - el, el_lo, el_hi) : clamp(el, el_lo, el_hi);
+        }
+
+        /* path[0].az is in [0, 360), find the turns that fit */
+        az_min = az_max = path[0].az;
+
+        for (i = 1; i < priv->npoints; i++)
+        {
+            az_min = path[i].az < az_min ? path[i].az : az_min;
+            az_max = path[i].az > az_max ? path[i].az : az_max;
+        }
+
+        k_lo = (int)ceil((az_lo - az_min) / 360);
+        k_hi = (int)floor((az_hi - az_max) / 360);
+
+        if (k_lo > k_hi)
+        {
+            continue;
+        }
+
+        for (k = k_lo; k < k_hi; k++)
+        {
+            if (fabs(path[0].az + 360 * (k + 1) - cur_az)
+                    >= fabs(path[0].az + 360 * k - cur_az))
+            {
+                break;
+            }
+        }
+
+        for (i = 0; i < priv->npoints; i++)
+        {
+            path[i].az += 360 * k;
+        }
+
+        priv->status.flipped = flip;
+
+        return 1;
+    }
+
+    /* each point on its own, in range */
+    for (i = 0; i < priv->npoints; i++)
+    {
+        double az = fmod(points[i].az - az_lo, 360);
+
+        path[i].time = points[i].time;
+        path[i].az = az_lo + (az < 0 ? az + 360 : az);
+        path[i].el = clamp(points[i].el, el_lo, el_hi);
+    }
+
+    priv->status.flipped = 0;
+
+    return 0;
+}
+
+
+static void track_measure(struct rot_track_priv *priv, double ms)
+{
+    rot_track_status_t *st = &priv->status;
+
+    st->latency_ms = st->latency_ms > 0 ? 0.8 * st->latency_ms + 0.2 * ms : ms;
+}
+
+
+/*
+ * Take a position read at time now, returns 1 with the position to send
+ * in *az and *el when one is due.
+ */
+static int track_update(struct rot_track_priv *priv, double now,
+                        azimuth_t *az, elevation_t *el,
+                        double *last_read, azimuth_t *last_az, elevation_t *last_el)
+{
+    rot_track_status_t *st = &priv->status;
+    const rot_track_point_t *end = &priv->path[priv->npoints - 1];
+    double start = priv->path[0].time;
+    double latency_s = st->latency_ms / 1000;
+    double behind;
+    double t;
+
+    path_at(priv, now, &st->target_az, &st->target_el);
+
+    /* the rotator may count its azimuth in another turn */
+    st->az = st->target_az + norm180(*az - st->target_az);
+    st->el = *el;
+    st->error = pointing_error(st->az, st->el, st->target_az, st->target_el);
+    st->polls++;
+
+    /* the slew rate, from reads the rotator spent moving all along */
+    if (*last_read > 0 && priv->sent
+            && axis_dist(st->az, st->el, *last_az, *last_el) > 0.1)
+    {
+        azimuth_t sent_az;
+        elevation_t sent_el;
+
+        path_at(priv, priv->sent_time, &sent_az, &sent_el);
+
+        if (axis_dist(st->az, st->el, sent_az, sent_el) > 0.5)
+        {
+            double rate = axis_dist(st->az, st->el, *last_az, *last_el)
+                          / (now - *last_read);
+
+            st->slew_rate = 0.7 * st->slew_rate + 0.3 * rate;
+        }
+    }
+
+    *last_read = now;
+    *last_az = st->az;
+    *last_el = st->el;
+
+    if (now < start)
+    {
+        st->state = ROT_TRACK_WAIT;
+    }
+    else
+    {
+        st->state = ROT_TRACK_TRACKING;
+        priv->error_sum_sq += st->error * st->error;
+        priv->error_count++;
+        st->rms_error = sqrt(priv->error_sum_sq / priv->error_count);
+
+        if (st->error > st->max_error)
+        {
+            st->max_error = st->error;
+        }
+    }
+
+    if (now >= end->time && priv->sent && priv->sent_time >= end->time
+            && (axis_dist(st->az, st->el, end->az, end->el) <= priv->deadband
+                || now > end->time + ROT_TRACK_SETTLE_S))
+    {
+        st->state = ROT_TRACK_DONE;
+        return 0;
+    }
+
+    behind = axis_dist(st->az, st->el, st->target_az, st->target_el);
+
+    if (!priv->sent)
+    {
+        /* to the start, or to where a pass under way will be met */
+        t = now < start ? start : now + latency_s + behind / st->slew_rate;
+    }
+    else
+    {
+        double base;
+
+        /* early enough to get there before the path does */
+        if (priv->sent_time >= end->time
+                || now + latency_s + priv->deadband / st->slew_rate < priv->sent_time)
+        {
+            return 0;
+        }
+
+        base = priv->sent_time > now + latency_s ? priv->sent_time : now + latency_s;
+
+        if (behind > priv->deadband
+                && now + latency_s + behind / st->slew_rate > base)
+        {
+            base = now + latency_s + behind / st->slew_rate;
+        }
+
+        t = path_ahead(priv, base);
+    }
+
+    if (t > end->time)
+    {
+        t = end->time;
+    }
+
+    priv->sent = 1;
+    priv->sent_time = t;
+    path_at(priv, t, az, el);
+
+    return 1;
+}
+
+
+#if defined(HAVE_PTHREAD)
+/*
+ * Called with the mutex held: reads the position and sends the rotator
+ * ahead when it is time.  Returns when the next read is due, 0 when the
+ * tracker is done.
+ */
+static double track_step(ROT *rot, struct rot_track_priv *priv)
+{
+    double start, now;
+    double was_sent_time;
+    int was_sent;
+    azimuth_t az;
+    elevation_t el;
+    int retval;
+
+    start = now_s();
+    pthread_mutex_unlock(&priv->mutex);
+    retval = rot_get_position(rot, &az, &el);
+    now = now_s();
+    pthread_mutex_lock(&priv->mutex);
+
+    if (retval != RIG_OK)
+    {
+        rot_debug(RIG_DEBUG_WARN, "%s: rot_get_position: %s\n", __func__,
+                  rigerror(retval));
+
+        if (++priv->errors >= ROT_TRACK_MAX_ERRORS)
+        {
+            priv->status.state = ROT_TRACK_ERROR;
+            return 0;
+        }
+    }
+    else
+    {
+        priv->errors = 0;
+        track_measure(priv, (now - start) * 1000);
+
+        was_sent = priv->sent;
+        was_sent_time = priv->sent_time;
+
+        if (track_update(priv, now, &az, &el, &priv->last_read, &priv->last_az,
+                         &priv->last_el))
+        {
+            double sent;
+
+            rot_debug(RIG_DEBUG_TRACE, "%s: az=%.2f el=%.2f for %.2fs ahead\n",
+                      __func__, az, el, priv->sent_time - now);
+            pthread_mutex_unlock(&priv->mutex);
+            sent = now_s();
+            retval = rot_set_position(rot, az, el);
+            now = now_s();
+            pthread_mutex_lock(&priv->mutex);
+
+            if (retval == RIG_OK)
+            {
+                track_measure(priv, (now - sent) * 1000);
+                priv->status.commands++;
+            }
+            else
+            {
+                rot_debug(RIG_DEBUG_WARN, "%s: rot_set_position: %s\n", __func__,
+                          rigerror(retval));
+                /* try again on the next read */
+                priv->sent = was_sent;
+                priv->sent_time = was_sent_time;
+            }
+        }
+    }
+
+    if (priv->status.state == ROT_TRACK_DONE)
+    {
+        return 0;
+    }
+
+    return start + priv->interval_ms / 1000.0;
+}
+
+
+static void *rot_track_thread(void *arg)
+{
+    ROT *rot = arg;
+    struct rot_track_priv *priv = ROTSTATE(rot)->track_priv;
+
+    pthread_mutex_lock(&priv->mutex);
+
+    while (!priv->stop && priv->status.state != ROT_TRACK_DONE)
+    {
+        struct timespec due;
+        double next = track_step(rot, priv);
+
+        if (next == 0)
+        {
+            break;
+        }
+
+        due.tv_sec = (time_t) next;
+        due.tv_nsec = (long)((next - due.tv_sec) * 1e9);
+
+        if (!priv->stop)
+        {
+            pthread_cond_timedwait(&priv->wake, &priv->mutex, &due);
+        }
+    }
+
+    pthread_mutex_unlock(&priv->mutex);
+
+    return NULL;
+}
+
+
+/* the tracker of a rotator in a station runs on the station loop */
+static int rot_track_station(void *arg)
+{
+    ROT *rot = arg;
+    struct rot_track_priv *priv = ROTSTATE(rot)->track_priv;
+    double next = 0;
+    double ms;
+
+    pthread_mutex_lock(&priv->mutex);
+
+    if (!priv->stop && priv->status.state != ROT_TRACK_DONE)
+    {
+        next = track_step(rot, priv);
+    }
+
+    pthread_mutex_unlock(&priv->mutex);
+
+    if (next == 0)
+    {
+        return -1;
+    }
+
+    ms = (next - now_s()) * 1000;
+
+    return ms > 0 ? (int)(ms + 0.5) : 0;
+}
+#endif
+
+
+int rot_track_init(ROT *rot)
+{
+    struct rot_track_priv *priv;
+
+    priv = calloc(1, sizeof(*priv));
+
+    if (!priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    priv->deadband = ROT_TRACK_DEFAULT_DEADBAND;
+    priv->interval_ms = ROT_TRACK_DEFAULT_INTERVAL_MS;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_init(&priv->mutex, NULL);
+    pthread_cond_init(&priv->wake, NULL);
+#endif
+
+    ROTSTATE(rot)->track_priv = priv;
+
+    return RIG_OK;
+}
+
+
+void rot_track_cleanup(ROT *rot)
+{
+    struct rot_track_priv *priv = ROTSTATE(rot)->track_priv;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    rot_track_stop(rot);
+#if defined(HAVE_PTHREAD)
+    pthread_cond_destroy(&priv->wake);
+    pthread_mutex_destroy(&priv->mutex);
+#endif
+    free(priv->path);
+    free(priv);
+    ROTSTATE(rot)->track_priv = NULL;
+}
+
+
+int rot_track_set_conf(ROT *rot, hamlib_token_t token, const char *val)
+{
+    struct rot_track_priv *priv = ROTSTATE(rot)->track_priv;
+
+    if (!priv)
+    {
+        return -RIG_EINTERNAL;
+    }
+
+    switch (token)
+    {
+    case TOK_TRACK_DEADBAND:
+    {
+        double deadband = atof(val);
+
+        if (deadband < 0.1 || deadband > 90)
+        {
+            return -RIG_EINVAL;
+        }
+
+        priv->deadband = deadband;
+        break;
+    }
+
+    case TOK_TRACK_INTERVAL:
+    {
+        int interval_ms = atoi(val);
+
+        if (interval_ms < 10 || interval_ms > 10000)
+        {
+            return -RIG_EINVAL;
+        }
+
+        priv->interval_ms = interval_ms;
+        break;
+    }
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+
+int rot_track_get_conf(ROT *rot, hamlib_token_t token, char *val, int val_len)
+{
+    const struct rot_track_priv *priv = ROTSTATE(rot)->track_priv;
+
+    if (!priv)
+    {
+        return -RIG_EINTERNAL;
+    }
+
+    switch (token)
+    {
+    case TOK_TRACK_DEADBAND:
+        SNPRINTF(val, val_len, "%g", priv->deadband);
+        break;
+
+    case TOK_TRACK_INTERVAL:
+        SNPRINTF(val, val_len, "%d", priv->interval_ms);
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+//! @endcond
+
+
+/**
+ * \brief Follow a trajectory
+ *
+ * \param rot The #ROT handle.
+ * \param points The trajectory, in time order, e.g. a satellite pass.
+ * \param npoints How many points, at least 1.
+ *
+ * Moves the rotator to the first point at once and follows the path
+ * between the points, linearly interpolated, until the last one.  A
+ * thread, or the loop of the station the rotator was added to with
+ * rig_station_add_rot(), reads the position every track_interval ms and
+ * sends a position track_deadband degrees ahead of the path whenever the
+ * rotator would otherwise fall behind, allowing for the measured command
+ * latency and slew rate, so the rotator is moved once per deadband of
+ * path.  The path
+ * is kept in one turn of the azimuth range, or flipped over the zenith
+ * when the range has no turn for it and the rotator reaches 180 degrees
+ * of elevation.  Elevations are clamped to the rotator range.
+ *
+ * The points are copied and a trajectory already being followed is
+ * replaced.  While the trajectory is followed the application should
+ * leave the rotator position to the tracker, rot_track_get_status()
+ * reports the position it last read.
+ *
+ * \return RIG_OK, or a negative value if \a rot is not open, the points
+ * are not in time order or the thread could not be started.
+ *
+ * \sa rot_track_stop(), rot_track_get_status()
+ */
+int HAMLIB_API rot_track_start(ROT *rot, const rot_track_point_t *points,
+                               int npoints)
+{
+    struct rot_track_priv *priv;
+    rot_track_point_t *path;
+    azimuth_t az = 0;
+    elevation_t el = 0;
+    int i;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called, %d points\n", __func__, npoints);
+
+    if (!rot || !ROTSTATE(rot)->comm_state || !ROTSTATE(rot)->track_priv
+            || !points || npoints < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    for (i = 1; i < npoints; i++)
+    {
+        if (points[i].time <= points[i - 1].time)
+        {
+            return -RIG_EINVAL;
+        }
+    }
+
+#if defined(HAVE_PTHREAD)
+    priv = ROTSTATE(rot)->track_priv;
+    rot_track_stop(rot);
+
+    path = calloc(npoints, sizeof(*path));
+
+    if (!path)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    /* start in the turn the rotator is in */
+    rot_get_position(rot, &az, &el);
+
+    pthread_mutex_lock(&priv->mutex);
+    free(priv->path);
+    priv->path = path;
+    priv->npoints = npoints;
+    priv->sent = 0;
+    priv->error_sum_sq = 0;
+    priv->error_count = 0;
+    memset(&priv->status, 0, sizeof(priv->status));
+    priv->status.slew_rate = ROT_TRACK_DEFAULT_RATE;
+    priv->status.state = ROT_TRACK_WAIT;
+
+    if (!track_plan(rot, priv, points, az))
+    {
+        rot_debug(RIG_DEBUG_WARN, "%s: the path does not fit the azimuth range, "
+                  "the rotator will go round\n", __func__);
+    }
+
+    priv->stop = 0;
+    priv->last_az = 0;
+    priv->last_el = 0;
+    priv->last_read = 0;
+    priv->errors = 0;
+    priv->source = station_add_io(ROTSTATE(rot)->station, rot_track_station,
+                                  rot, 0);
+
+    if (!priv->source
+            && pthread_create(&priv->thread_id, NULL, rot_track_thread, rot))
+    {
+        priv->status.state = ROT_TRACK_IDLE;
+        pthread_mutex_unlock(&priv->mutex);
+        rot_debug(RIG_DEBUG_ERR, "%s: pthread_create failed\n", __func__);
+        return -RIG_EINTERNAL;
+    }
+
+    priv->running = 1;
+    pthread_mutex_unlock(&priv->mutex);
+
+    return RIG_OK;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
+
+
+/**
+ * \brief Stop following the trajectory
+ *
+ * \param rot The #ROT handle.
+ *
+ * Stops the tracker thread, the rotator finishes the move it was given.
+ * Closing the rotator stops the tracker too.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a rot is NULL.
+ *
+ * \sa rot_track_start()
+ */
+int HAMLIB_API rot_track_stop(ROT *rot)
+{
+    struct rot_track_priv *priv;
+
+    if (!rot || !ROTSTATE(rot)->track_priv)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = ROTSTATE(rot)->track_priv;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+
+    if (!priv->running)
+    {
+        pthread_mutex_unlock(&priv->mutex);
+        return RIG_OK;
+    }
+
+    priv->stop = 1;
+    pthread_cond_signal(&priv->wake);
+    pthread_mutex_unlock(&priv->mutex);
+
+    if (priv->source)
+    {
+        station_remove(ROTSTATE(rot)->station, priv->source);
+        priv->source = NULL;
+    }
+    else
+    {
+        pthread_join(priv->thread_id, NULL);
+    }
+
+    priv->running = 0;
+
+    if (priv->status.state == ROT_TRACK_WAIT
+            || priv->status.state == ROT_TRACK_TRACKING)
+    {
+        priv->status.state = ROT_TRACK_IDLE;
+    }
+#endif
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Get the trajectory tracker status
+ *
+ * \param rot The #ROT handle.
+ * \param status Where to store the status.
+ *
+ * Reports the state of the tracker, where the rotator and the path were
+ * at the last read, the pointing error and the measured latency and slew
+ * rate.  The pointing error is the angle between where the rotator points
+ * and the path, the errors while tracking are summed up in max_error and
+ * rms_error.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a rot or \a status is NULL.
+ *
+ * \sa rot_track_start()
+ */
+int HAMLIB_API rot_track_get_status(ROT *rot, rot_track_status_t *status)
+{
+    struct rot_track_priv *priv;
+
+    if (!rot || !ROTSTATE(rot)->track_priv || !status)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = ROTSTATE(rot)->track_priv;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+#endif
+    *status = priv->status;
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+
+    return RIG_OK;
+}
+
+/** @} */
@@ -65,6 +65,8 @@
 #endif
 #include "network.h"
 #include "rot_conf.h"
+#include "rot_track.h"
+#include "station.h"
 #include "token.h"
 #include "serial.h"
 
@@ -322,6 +324,12 @@ ROT *HAMLIB_API rot_init(rot_model_t rot_model)
     memcpy(rs->level_gran, caps->level_gran, sizeof(gran_t)*RIG_SETTING_MAX);
     memcpy(rs->parm_gran, caps->parm_gran, sizeof(gran_t)*RIG_SETTING_MAX);
 
+    if (rot_track_init(rot) != RIG_OK)
+    {
+        free(rot);
+        return NULL;
+    }
+
     /*
      * let the backend a chance to setup his private data
      * This must be done only once defaults are setup,
@@ -337,6 +345,7 @@ ROT *HAMLIB_API rot_init(rot_model_t rot_model)
                       "%s: backend_init failed!\n",
                       __func__);
             /* cleanup and exit */
+            rot_track_cleanup(rot);
             free(rot);
             return NULL;
         }
@@ -587,6 +596,8 @@ int HAMLIB_API rot_close(ROT *rot)
         return -RIG_EINVAL;
     }
 
+    rot_track_stop(rot);
+
     /*
      * Let the backend say 73s to the rot.
      * and ignore the return code.
@@ -682,6 +693,8 @@ int HAMLIB_API rot_cleanup(ROT *rot)
 
     //TODO Release any allocated port structures
     
+    rot_track_cleanup(rot);
+    station_leave(rot->state.station, rot);
     free(rot);
 
     return RIG_OK;
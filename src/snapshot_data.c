@@ -326,13 +326,11 @@ void snapshot_init()
     snprintf(snapshot_data_pid, sizeof(snapshot_data_pid), "%d", getpid());
 }
 
-int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
-                       struct rig_spectrum_line *spectrum_line)
+static cJSON *snapshot_create(RIG *rig, struct rig_spectrum_line *spectrum_line)
 {
     cJSON *root_node;
     cJSON *rig_node, *vfos_array, *vfo_node, *spectra_array, *spectrum_node;
     cJSON *node;
-    cJSON_bool bool_result;
     char buf[256];
     int result;
     int i;
@@ -341,7 +339,7 @@ int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
 
     if (root_node == NULL)
     {
-        RETURNFUNC2(-RIG_EINTERNAL);
+        return NULL;
     }
 
     node = cJSON_AddStringToObject(root_node, "app", PACKAGE_NAME);
@@ -454,6 +452,26 @@ int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
         cJSON_AddItemToObject(root_node, "spectra", spectra_array);
     }
 
+    return root_node;
+
+error:
+    cJSON_Delete(root_node);
+    return NULL;
+}
+
+int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
+                       struct rig_spectrum_line *spectrum_line)
+{
+    cJSON *root_node;
+    cJSON_bool bool_result;
+
+    root_node = snapshot_create(rig, spectrum_line);
+
+    if (root_node == NULL)
+    {
+        RETURNFUNC2(-RIG_EINTERNAL);
+    }
+
     bool_result = cJSON_PrintPreallocated(root_node, buffer, (int) buffer_length,
                                           0);
 
@@ -467,8 +485,241 @@ int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
     rig->state.snapshot_packet_sequence_number++;
 
     return RIG_OK;
+}
 
-error:
+/*
+ * Adds to delta_node the members of node that differ from those of
+ * last_node, except key which the caller has added.  Returns 1 if a
+ * member of last_node is gone, which a delta cannot express.
+ */
+static int snapshot_diff_object(cJSON *delta_node, const cJSON *node,
+                                const cJSON *last_node, const char *key)
+{
+    const cJSON *item;
+
+    cJSON_ArrayForEach(item, last_node)
+    {
+        if (!cJSON_GetObjectItemCaseSensitive(node, item->string))
+        {
+            return 1;
+        }
+    }
+
+    cJSON_ArrayForEach(item, node)
+    {
+        const cJSON *last_item;
+
+        if (strcmp(item->string, key) == 0)
+        {
+            continue;
+        }
+
+        last_item = cJSON_GetObjectItemCaseSensitive(last_node, item->string);
+
+        if (last_item && cJSON_Compare(item, last_item, 1))
+        {
+            continue;
+        }
+
+        cJSON_AddItemToObject(delta_node, item->string, cJSON_Duplicate(item, 1));
+    }
+
+    return 0;
+}
+
+/*
+ * Builds the delta packet of root_node against last_state, with the rig
+ * id always and the other rig members and VFOs only when they changed.
+ * Returns NULL if a keyframe is needed instead, and sets *changed to 0
+ * if there is nothing to send.
+ */
+static cJSON *snapshot_create_delta(cJSON *root_node, const cJSON *last_state,
+                                    int *changed)
+{
+    const cJSON *rig_node = cJSON_GetObjectItemCaseSensitive(root_node, "rig");
+    const cJSON *vfos_array = cJSON_GetObjectItemCaseSensitive(root_node, "vfos");
+    const cJSON *last_rig = cJSON_GetObjectItemCaseSensitive(last_state, "rig");
+    const cJSON *last_vfos = cJSON_GetObjectItemCaseSensitive(last_state, "vfos");
+    const cJSON *id_node = cJSON_GetObjectItemCaseSensitive(rig_node, "id");
+    const cJSON *vfo_node, *last_vfo;
+    cJSON *delta_node, *rig_delta, *vfos_delta, *spectra_array;
+
+    if (!cJSON_Compare(id_node, cJSON_GetObjectItemCaseSensitive(last_rig, "id"), 1)
+            || cJSON_GetArraySize(vfos_array) != cJSON_GetArraySize(last_vfos))
+    {
+        return NULL;
+    }
+
+    delta_node = cJSON_CreateObject();
+    cJSON_AddItemToObject(delta_node, "app", cJSON_Duplicate(
+                              cJSON_GetObjectItemCaseSensitive(root_node, "app"), 1));
+    cJSON_AddItemToObject(delta_node, "seq", cJSON_Duplicate(
+                              cJSON_GetObjectItemCaseSensitive(root_node, "seq"), 1));
+    cJSON_AddItemToObject(delta_node, "time", cJSON_Duplicate(
+                              cJSON_GetObjectItemCaseSensitive(root_node, "time"), 1));
+    cJSON_AddTrueToObject(delta_node, "delta");
+
+    rig_delta = cJSON_AddObjectToObject(delta_node, "rig");
+    cJSON_AddItemToObject(rig_delta, "id", cJSON_Duplicate(id_node, 1));
+
+    if (snapshot_diff_object(rig_delta, rig_node, last_rig, "id"))
+    {
+        cJSON_Delete(delta_node);
+        return NULL;
+    }
+
+    *changed = rig_delta->child->next != NULL;
+
+    vfos_delta = cJSON_CreateArray();
+    last_vfo = last_vfos->child;
+
+    cJSON_ArrayForEach(vfo_node, vfos_array)
+    {
+        const cJSON *name = cJSON_GetObjectItemCaseSensitive(vfo_node, "name");
+        cJSON *vfo_delta;
+
+        if (!cJSON_Compare(name, cJSON_GetObjectItemCaseSensitive(last_vfo, "name"), 1))
+        {
+            cJSON_Delete(vfos_delta);
+            cJSON_Delete(delta_node);
+            return NULL;
+        }
+
+        vfo_delta = cJSON_CreateObject();
+        cJSON_AddItemToObject(vfo_delta, "name", cJSON_Duplicate(name, 1));
+
+        if (snapshot_diff_object(vfo_delta, vfo_node, last_vfo, "name"))
+        {
+            cJSON_Delete(vfo_delta);
+            cJSON_Delete(vfos_delta);
+            cJSON_Delete(delta_node);
+            return NULL;
+        }
+
+        if (vfo_delta->child->next != NULL)
+        {
+            cJSON_AddItemToArray(vfos_delta, vfo_delta);
+            *changed = 1;
+        }
+        else
+        {
+            cJSON_Delete(vfo_delta);
+        }
+
+        last_vfo = last_vfo->next;
+    }
+
+    if (cJSON_GetArraySize(vfos_delta) > 0)
+    {
+        cJSON_AddItemToObject(delta_node, "vfos", vfos_delta);
+    }
+    else
+    {
+        cJSON_Delete(vfos_delta);
+    }
+
+    // spectrum lines are not state, each one is sent as it comes
+    spectra_array = cJSON_DetachItemFromObjectCaseSensitive(root_node, "spectra");
+
+    if (spectra_array != NULL)
+    {
+        cJSON_AddItemToObject(delta_node, "spectra", spectra_array);
+        *changed = 1;
+    }
+
+    return delta_node;
+}
+
+int snapshot_serialize_delta(size_t buffer_length, char *buffer, RIG *rig,
+                             struct rig_spectrum_line *spectrum_line,
+                             void **last_state, int keyframe)
+{
+    cJSON *root_node, *delta_node = NULL, *state;
+    cJSON_bool bool_result;
+    int changed = 1;
+
+    root_node = snapshot_create(rig, spectrum_line);
+
+    if (root_node == NULL)
+    {
+        RETURNFUNC2(-RIG_EINTERNAL);
+    }
+
+    if (!keyframe && *last_state != NULL)
+    {
+        delta_node = snapshot_create_delta(root_node, *last_state, &changed);
+
+        if (delta_node == NULL)
+        {
+            changed = 1;
+        }
+    }
+
+    if (!changed)
+    {
+        cJSON_Delete(delta_node);
+        cJSON_Delete(root_node);
+        buffer[0] = '\0';
+        return RIG_OK;
+    }
+
+    if (delta_node == NULL)
+    {
+        cJSON_AddTrueToObject(root_node, "keyframe");
+    }
+
+    bool_result = cJSON_PrintPreallocated(delta_node ? delta_node : root_node,
+                                          buffer, (int) buffer_length, 0);
+    cJSON_Delete(delta_node);
+
+    if (!bool_result)
+    {
+        cJSON_Delete(root_node);
+        RETURNFUNC2(-RIG_EINVAL);
+    }
+
+    // what the receivers now have, the base of the next delta
+    state = cJSON_CreateObject();
+    cJSON_AddItemToObject(state, "rig",
+                          cJSON_DetachItemFromObjectCaseSensitive(root_node, "rig"));
+    cJSON_AddItemToObject(state, "vfos",
+                          cJSON_DetachItemFromObjectCaseSensitive(root_node, "vfos"));
     cJSON_Delete(root_node);
-    RETURNFUNC2(-RIG_EINTERNAL);
+    cJSON_Delete(*last_state);
+    *last_state = state;
+
+    rig->state.snapshot_packet_sequence_number++;
+
+    return RIG_OK;
+}
+
+void snapshot_delta_free(void **last_state)
+{
+    cJSON_Delete(*last_state);
+    *last_state = NULL;
+}
+
+int snapshot_is_resync_request(const char *data, size_t length)
+{
+    cJSON *root_node = cJSON_ParseWithLength(data, length);
+    const cJSON *cmd, *id_node, *process;
+    int result;
+
+    if (root_node == NULL)
+    {
+        return 0;
+    }
+
+    cmd = cJSON_GetObjectItemCaseSensitive(root_node, "cmd");
+    id_node = cJSON_GetObjectItemCaseSensitive(root_node, "id");
+    process = cJSON_GetObjectItemCaseSensitive(id_node, "process");
+
+    // without an id the request is for every publisher on the group
+    result = cJSON_IsString(cmd) && strcmp(cmd->valuestring, "resync") == 0
+             && (!cJSON_IsString(process)
+                 || strcmp(process->valuestring, snapshot_data_pid) == 0);
+
+    cJSON_Delete(root_node);
+
+    return result;
 }
@@ -4,4 +4,18 @@
 void snapshot_init();
 int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig, struct rig_spectrum_line *spectrum_line);
 
+/*
+ * Serializes only what changed since the packet in *last_state, or a full
+ * snapshot marked as a keyframe if keyframe is set, *last_state is NULL or
+ * the change cannot be sent as a delta.  Leaves buffer empty if nothing
+ * changed.  Free *last_state with snapshot_delta_free().
+ */
+int snapshot_serialize_delta(size_t buffer_length, char *buffer, RIG *rig,
+                             struct rig_spectrum_line *spectrum_line,
+                             void **last_state, int keyframe);
+void snapshot_delta_free(void **last_state);
+
+/* Returns 1 if data is a {"cmd":"resync"} request for this process */
+int snapshot_is_resync_request(const char *data, size_t length);
+
 #endif
@@ -0,0 +1,577 @@
+/*
+ *  Hamlib Interface - per-subscriber spectrum reduction
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file spectrum_reduce.c
+ * \brief Per-subscriber spectrum reduction
+ *
+ * Scope lines come from the rig at full resolution, 475 points or more
+ * 20 to 30 times a second, while a band map or a status display may want
+ * 100 points twice a second.  Each subscriber gets the lines reduced its
+ * own way: the points binned to the width asked for by their maximum or
+ * mean, averaged over the last lines, held at their peak and sent no more
+ * often than asked for.  The reduction runs on the thread delivering the
+ * scope lines, so the loops are kept branch free over the 8-bit points
+ * for the compiler to vectorize.
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "spectrum_reduce.h"
+#include "misc.h"
+
+//! @cond Doxygen_Suppress
+#define SPECTRUM_SUBSCRIBERS 16
+
+/* the reduction of the lines of one scope for one subscriber */
+struct spectrum_scope_state
+{
+    size_t length;                      /* points of the line the state is for */
+    int width;                          /* bins out */
+    int primed;                         /* average and peak hold have a first line */
+    struct timespec peak_start;
+    uint16_t edge[HAMLIB_MAX_SPECTRUM_DATA + 1];   /* first point of each bin */
+    uint16_t average[HAMLIB_MAX_SPECTRUM_DATA];    /* 8.8 fixed point */
+    unsigned char peak[HAMLIB_MAX_SPECTRUM_DATA];
+    unsigned char binned[HAMLIB_MAX_SPECTRUM_DATA];
+    unsigned char out[HAMLIB_MAX_SPECTRUM_DATA];
+    struct timespec sent;
+    int sent_once;
+};
+
+struct spectrum_subscriber
+{
+    rig_spectrum_reduction_t reduction;
+    spectrum_cb_t cb;
+    rig_ptr_t arg;
+    struct spectrum_scope_state scope[HAMLIB_MAX_SPECTRUM_SCOPES];
+};
+
+struct spectrum_reduce_priv
+{
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_t mutex;
+#endif
+    struct spectrum_subscriber *subscriber[SPECTRUM_SUBSCRIBERS];
+};
+
+#if defined(HAVE_PTHREAD)
+static pthread_mutex_t spectrum_reduce_create_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+static struct spectrum_reduce_priv *spectrum_reduce_priv(RIG *rig)
+{
+    struct spectrum_reduce_priv *priv;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&spectrum_reduce_create_mutex);
+#endif
+
+    priv = rig->state.spectrum_reduce_priv_data;
+
+    if (!priv)
+    {
+        priv = calloc(1, sizeof(*priv));
+
+        if (priv)
+        {
+#if defined(HAVE_PTHREAD)
+            pthread_mutex_init(&priv->mutex, NULL);
+#endif
+            rig->state.spectrum_reduce_priv_data = priv;
+        }
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&spectrum_reduce_create_mutex);
+#endif
+
+    return priv;
+}
+
+
+/* averages over more than 2^8 lines would lose the 8.8 fixed point */
+static int spectrum_reduction_valid(const rig_spectrum_reduction_t *r)
+{
+    return r->width >= 0 && r->average >= 0 && r->average <= 8
+           && r->peak_hold_ms >= 0 && r->interval_ms >= 0
+           && (r->bin == RIG_SPECTRUM_BIN_MAX || r->bin == RIG_SPECTRUM_BIN_MEAN);
+}
+
+
+static void spectrum_bin_max(const unsigned char *in, const uint16_t *edge,
+                             int width, unsigned char *out)
+{
+    int i, j;
+
+    for (j = 0; j < width; j++)
+    {
+        unsigned char max = 0;
+
+        for (i = edge[j]; i < edge[j + 1]; i++)
+        {
+            max = in[i] > max ? in[i] : max;
+        }
+
+        out[j] = max;
+    }
+}
+
+
+static void spectrum_bin_mean(const unsigned char *in, const uint16_t *edge,
+                              int width, unsigned char *out)
+{
+    int i, j;
+
+    for (j = 0; j < width; j++)
+    {
+        int count = edge[j + 1] - edge[j];
+        unsigned int sum = 0;
+
+        for (i = edge[j]; i < edge[j + 1]; i++)
+        {
+            sum += in[i];
+        }
+
+        out[j] = (sum + count / 2) / count;
+    }
+}
+
+
+/* average += (value - average) / 2^shift, rounded back to 8 bits in out */
+static void spectrum_average(const unsigned char *in, uint16_t *average,
+                             int width, int shift, unsigned char *out)
+{
+    int j;
+
+    for (j = 0; j < width; j++)
+    {
+        int32_t value = (int32_t) in[j] << 8;
+        int32_t avg = average[j];
+
+        avg += (value - avg) >> shift;
+        average[j] = (uint16_t) avg;
+        out[j] = (unsigned char)((avg + 128) >> 8);
+    }
+}
+
+
+static void spectrum_peak(const unsigned char *in, unsigned char *peak,
+                          int width)
+{
+    int j;
+
+    for (j = 0; j < width; j++)
+    {
+        peak[j] = in[j] > peak[j] ? in[j] : peak[j];
+    }
+}
+
+
+static void spectrum_scope_reset(struct spectrum_scope_state *s,
+                                 const rig_spectrum_reduction_t *r, size_t length)
+{
+    int j;
+
+    s->length = length;
+    s->width = r->width > 0 && (size_t) r->width < length ? r->width : (int) length;
+    s->primed = 0;
+
+    /* bins of N / width points, the rounding spread over the line */
+    for (j = 0; j <= s->width; j++)
+    {
+        s->edge[j] = (uint16_t)((size_t) j * length / s->width);
+    }
+}
+
+
+/* returns the reduced points to send, or NULL if it is not time yet */
+static const unsigned char *spectrum_reduce_line(struct spectrum_scope_state *s,
+        const rig_spectrum_reduction_t *r, const struct rig_spectrum_line *line)
+{
+    const unsigned char *points;
+    int j;
+
+    if (line->spectrum_data_length != s->length || s->width == 0)
+    {
+        spectrum_scope_reset(s, r, line->spectrum_data_length);
+    }
+
+    if (s->width == (int) s->length)
+    {
+        points = line->spectrum_data;
+    }
+    else
+    {
+        if (r->bin == RIG_SPECTRUM_BIN_MEAN)
+        {
+            spectrum_bin_mean(line->spectrum_data, s->edge, s->width, s->binned);
+        }
+        else
+        {
+            spectrum_bin_max(line->spectrum_data, s->edge, s->width, s->binned);
+        }
+
+        points = s->binned;
+    }
+
+    if (!s->primed)
+    {
+        for (j = 0; j < s->width; j++)
+        {
+            s->average[j] = (uint16_t)(points[j] << 8);
+        }
+
+        memcpy(s->peak, points, s->width);
+        elapsed_ms(&s->peak_start, HAMLIB_ELAPSED_SET);
+        s->primed = 1;
+    }
+
+    if (r->average > 0)
+    {
+        spectrum_average(points, s->average, s->width, r->average, s->out);
+        points = s->out;
+    }
+
+    if (r->peak_hold_ms > 0)
+    {
+        if (elapsed_ms(&s->peak_start, HAMLIB_ELAPSED_GET) >= r->peak_hold_ms)
+        {
+            memcpy(s->peak, points, s->width);
+            elapsed_ms(&s->peak_start, HAMLIB_ELAPSED_SET);
+        }
+        else
+        {
+            spectrum_peak(points, s->peak, s->width);
+        }
+
+        points = s->peak;
+    }
+
+    /* averages and peaks take in every line, only sending is limited */
+    if (r->interval_ms > 0 && s->sent_once
+            && elapsed_ms(&s->sent, HAMLIB_ELAPSED_GET) < r->interval_ms)
+    {
+        return NULL;
+    }
+
+    elapsed_ms(&s->sent, HAMLIB_ELAPSED_SET);
+    s->sent_once = 1;
+
+    return points;
+}
+
+
+void rig_spectrum_dispatch(RIG *rig, const struct rig_spectrum_line *line)
+{
+    struct spectrum_reduce_priv *priv = rig->state.spectrum_reduce_priv_data;
+    int i;
+
+    if (!priv || line->id < 0 || line->id >= HAMLIB_MAX_SPECTRUM_SCOPES
+            || line->spectrum_data_length == 0
+            || line->spectrum_data_length > HAMLIB_MAX_SPECTRUM_DATA)
+    {
+        return;
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+#endif
+
+    for (i = 0; i < SPECTRUM_SUBSCRIBERS; i++)
+    {
+        struct spectrum_subscriber *sub = priv->subscriber[i];
+        struct spectrum_scope_state *s;
+        struct rig_spectrum_line reduced;
+        const unsigned char *points;
+
+        if (!sub)
+        {
+            continue;
+        }
+
+        s = &sub->scope[line->id];
+        points = spectrum_reduce_line(s, &sub->reduction, line);
+
+        if (!points)
+        {
+            continue;
+        }
+
+        reduced = *line;
+        reduced.spectrum_data_length = s->width;
+        reduced.spectrum_data = (unsigned char *) points;
+        sub->cb(rig, &reduced, sub->arg);
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+}
+
+
+void rig_spectrum_cleanup(RIG *rig)
+{
+    struct spectrum_reduce_priv *priv = rig->state.spectrum_reduce_priv_data;
+    int i;
+
+    if (!priv)
+    {
+        return;
+    }
+
+    for (i = 0; i < SPECTRUM_SUBSCRIBERS; i++)
+    {
+        free(priv->subscriber[i]);
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_destroy(&priv->mutex);
+#endif
+    free(priv);
+    rig->state.spectrum_reduce_priv_data = NULL;
+}
+//! @endcond
+
+
+/**
+ * \brief Receive the scope lines of a rig reduced
+ * \param rig       The rig handle
+ * \param reduction How to reduce the lines
+ * \param cb        Called with each reduced line
+ * \param arg       Passed to cb
+ *
+ * Calls \a cb from the thread delivering the scope lines, as
+ * rig_set_spectrum_callback() does, but with each line binned to
+ * \a reduction->width points by their maximum or mean, then averaged
+ * over about 2^\a reduction->average lines, then held at the peak of
+ * each point for \a reduction->peak_hold_ms, and no more often than every
+ * \a reduction->interval_ms.  Lines left out by the interval still go
+ * into the average and the peaks.  Each scope of the rig is reduced on
+ * its own.  The line passed to \a cb is only valid during the call, and
+ * \a cb must not subscribe or unsubscribe.
+ *
+ * \return the subscriber number to pass to rig_spectrum_unsubscribe(), or
+ * < 0 if an error occurred.
+ *
+ * \sa rig_spectrum_unsubscribe(), rig_spectrum_reduction_parse()
+ */
+int HAMLIB_API rig_spectrum_subscribe(RIG *rig,
+                                      const rig_spectrum_reduction_t *reduction,
+                                      spectrum_cb_t cb, rig_ptr_t arg)
+{
+    struct spectrum_reduce_priv *priv;
+    struct spectrum_subscriber *sub;
+    int i;
+
+    if (!rig || !rig->caps || !reduction || !cb || !spectrum_reduction_valid(reduction))
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = spectrum_reduce_priv(rig);
+    sub = calloc(1, sizeof(*sub));
+
+    if (!priv || !sub)
+    {
+        free(sub);
+        return -RIG_ENOMEM;
+    }
+
+    sub->reduction = *reduction;
+    sub->cb = cb;
+    sub->arg = arg;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+#endif
+
+    for (i = 0; i < SPECTRUM_SUBSCRIBERS && priv->subscriber[i]; i++)
+    {
+    }
+
+    if (i < SPECTRUM_SUBSCRIBERS)
+    {
+        priv->subscriber[i] = sub;
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+
+    if (i == SPECTRUM_SUBSCRIBERS)
+    {
+        free(sub);
+        return -RIG_ENAVAIL;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE,
+              "%s: subscriber %d width=%d bin=%d average=%d peak_hold=%d interval=%d\n",
+              __func__, i, reduction->width, reduction->bin, reduction->average,
+              reduction->peak_hold_ms, reduction->interval_ms);
+
+    return i;
+}
+
+
+/**
+ * \brief Stop receiving reduced scope lines
+ * \param rig           The rig handle
+ * \param subscriber    The number rig_spectrum_subscribe() returned
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred.
+ */
+int HAMLIB_API rig_spectrum_unsubscribe(RIG *rig, int subscriber)
+{
+    struct spectrum_reduce_priv *priv;
+    struct spectrum_subscriber *sub;
+
+    if (!rig || subscriber < 0 || subscriber >= SPECTRUM_SUBSCRIBERS)
+    {
+        return -RIG_EINVAL;
+    }
+
+    priv = rig->state.spectrum_reduce_priv_data;
+
+    if (!priv)
+    {
+        return -RIG_EINVAL;
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&priv->mutex);
+#endif
+    sub = priv->subscriber[subscriber];
+    priv->subscriber[subscriber] = NULL;
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&priv->mutex);
+#endif
+
+    if (!sub)
+    {
+        return -RIG_EINVAL;
+    }
+
+    free(sub);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Read a spectrum reduction from a string
+ * \param spec      Comma separated name=value pairs
+ * \param reduction Filled in, with zero for the names left out
+ *
+ * The names are width, bin (max or mean), average, peak_hold (ms) and
+ * interval (ms), as in "width=100,bin=max,interval=500".  This is the
+ * format of the multicast_spectrum token.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred.
+ */
+int HAMLIB_API rig_spectrum_reduction_parse(const char *spec,
+        rig_spectrum_reduction_t *reduction)
+{
+    const char *p = spec;
+
+    if (!spec || !reduction)
+    {
+        return -RIG_EINVAL;
+    }
+
+    memset(reduction, 0, sizeof(*reduction));
+    reduction->bin = RIG_SPECTRUM_BIN_MAX;
+
+    while (*p)
+    {
+        char name[16], value[16];
+        int n = 0;
+
+        if (sscanf(p, "%15[^=,]=%15[^,]%n", name, value, &n) != 2)
+        {
+            return -RIG_EINVAL;
+        }
+
+        if (strcmp(name, "width") == 0)
+        {
+            reduction->width = atoi(value);
+        }
+        else if (strcmp(name, "bin") == 0)
+        {
+            if (strcmp(value, "max") == 0)
+            {
+                reduction->bin = RIG_SPECTRUM_BIN_MAX;
+            }
+            else if (strcmp(value, "mean") == 0)
+            {
+                reduction->bin = RIG_SPECTRUM_BIN_MEAN;
+            }
+            else
+            {
+                return -RIG_EINVAL;
+            }
+        }
+        else if (strcmp(name, "average") == 0)
+        {
+            reduction->average = atoi(value);
+        }
+        else if (strcmp(name, "peak_hold") == 0)
+        {
+            reduction->peak_hold_ms = atoi(value);
+        }
+        else if (strcmp(name, "interval") == 0)
+        {
+            reduction->interval_ms = atoi(value);
+        }
+        else
+        {
+            return -RIG_EINVAL;
+        }
+
+        p += n;
+
+        if (*p == ',')
+        {
+            p++;
+        }
+    }
+
+    return spectrum_reduction_valid(reduction) ? RIG_OK : -RIG_EINVAL;
+}
+
+/** @} */
@@ -0,0 +1,1239 @@
+/*
+ *  Hamlib Interface - station event loop
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file station.c
+ * \brief Station event loop
+ *
+ * Each open handle runs threads of its own: a rig reads its transceive
+ * frames on one and publishes its state changes on another, an amplifier
+ * polls its levels on one and a rotator follows a trajectory on one.  A
+ * station of a rig, a rotator and an amplifier ends up with a handful of
+ * threads that each wake up on their own timer.
+ *
+ * Handles added to a station before they are opened hand this work to
+ * the station instead: one loop waits on the ports that send unasked
+ * data and on the timers of the polls, and calls the backend of the
+ * handle whose port became readable or whose timer is due.  Timers due
+ * within a few ms of each other run on the same wakeup.  The loop runs on
+ * a thread of the station started by rig_station_start(), or on the
+ * application's own main loop, which waits on the fd of
+ * rig_station_get_fd() and calls rig_station_dispatch() when it becomes
+ * readable.
+ *
+ * The backends are synchronous, a rotator read may take a few hundred
+ * ms, so the polls that send commands to a port run one after the other
+ * on a second thread of the station, the I/O thread, and the loop only
+ * runs what does not wait on a port.
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_SYS_SELECT_H
+#include <sys/select.h>
+#endif
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include <hamlib/amplifier.h>
+#include "station.h"
+
+//! @cond Doxygen_Suppress
+#if defined(HAVE_PTHREAD) && !defined(_WIN32)
+#define STATION_LOOP 1
+#endif
+
+#if defined(STATION_LOOP) && defined(HAVE_SYS_EPOLL_H) && defined(HAVE_SYS_TIMERFD_H)
+#define STATION_EPOLL 1
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#endif
+
+#if defined(STATION_LOOP)
+struct station_source
+{
+    int fd;                     /* -1 for a timer only */
+    station_read_t read_cb;
+    station_timer_t timer_cb;
+    void *arg;
+    double due;                 /* on the station clock, < 0 waits for a kick */
+    double rest;                /* the fd is left alone until then after an error */
+    int io;                     /* a timer run on the I/O thread */
+    int polled;                 /* fd in the set of this pass */
+    int busy;                   /* a callback runs */
+    pthread_t runner;           /* on this thread */
+    int removed;
+    struct station_source *next;
+};
+
+struct station_member
+{
+    void *handle;
+    void **station;             /* the station pointer of the handle state */
+};
+
+struct hamlib_station
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t idle;        /* a callback returned */
+    station_source_t *sources;
+    struct station_member *members;
+    int nmembers;
+    int wake[2];                /* interrupts the wait of the loop */
+    int epoll_fd;               /* of rig_station_get_fd(), -1 until asked */
+    int timer_fd;
+    pthread_t thread_id;
+    int running;
+    int stop;
+    int dispatching;            /* a pass of the loop is running */
+    pthread_cond_t io_wake;     /* an I/O timer was added or kicked, or the thread must stop */
+    pthread_t io_thread_id;
+    int io_running;
+    int io_stop;
+    hamlib_station_stats_t stats;
+};
+
+
+static double station_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+
+static void station_wake(hamlib_station_t *st)
+{
+    char c = 0;
+
+    if (write(st->wake[1], &c, 1) < 0 && errno != EAGAIN)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: write: %s\n", __func__, strerror(errno));
+    }
+}
+
+
+static void station_drain(int fd)
+{
+    char buf[64];
+
+    while (read(fd, buf, sizeof(buf)) > 0)
+    {
+    }
+}
+
+
+/* the next time the loop, or with io the I/O thread, has to run a source */
+static double station_next_due(hamlib_station_t *st, int io)
+{
+    const station_source_t *src;
+    double due = -1;
+
+    for (src = st->sources; src; src = src->next)
+    {
+        if (src->removed || src->io != io)
+        {
+            continue;
+        }
+
+        if (src->due >= 0 && (due < 0 || src->due < due))
+        {
+            due = src->due;
+        }
+
+        if (src->rest > 0 && (due < 0 || src->rest < due))
+        {
+            due = src->rest;
+        }
+    }
+
+    return due;
+}
+
+
+/* called with the mutex held: the timer fd goes readable at the next due time */
+static void station_arm(hamlib_station_t *st)
+{
+#if defined(STATION_EPOLL)
+    struct itimerspec its;
+    double due;
+
+    if (st->timer_fd < 0)
+    {
+        return;
+    }
+
+    memset(&its, 0, sizeof(its));
+    due = station_next_due(st, 0);
+
+    if (due >= 0)
+    {
+        its.it_value.tv_sec = (time_t)(due / 1000);
+        its.it_value.tv_nsec = (long)((due - its.it_value.tv_sec * 1000.0) * 1e6);
+
+        /* all zero would disarm it */
+        if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+        {
+            its.it_value.tv_nsec = 1;
+        }
+    }
+
+    timerfd_settime(st->timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+#endif
+}
+
+
+/* called with the mutex held: keeps the epoll set in step with the sources */
+static void station_watch(hamlib_station_t *st, int add, int fd)
+{
+#if defined(STATION_EPOLL)
+    struct epoll_event ev;
+
+    if (st->epoll_fd < 0 || fd < 0)
+    {
+        return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(st->epoll_fd, add ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd, &ev);
+#endif
+}
+
+
+/* called with the mutex held and no pass running */
+static void station_reap(hamlib_station_t *st)
+{
+    station_source_t **p = &st->sources;
+
+    while (*p)
+    {
+        station_source_t *src = *p;
+
+        if (src->removed && !src->busy)
+        {
+            *p = src->next;
+            free(src);
+        }
+        else
+        {
+            p = &src->next;
+        }
+    }
+}
+
+
+static int station_due(const station_source_t *src, double now)
+{
+    return !src->removed && src->timer_cb && src->due >= 0
+           && src->due <= now + STATION_SLACK_MS;
+}
+
+
+/* called with the mutex held, returns with it held */
+static void station_run_timer(hamlib_station_t *st, station_source_t *src)
+{
+    double late = station_now() - src->due;
+    double *max_late = src->io ? &st->stats.io_max_late_ms
+                       : &st->stats.max_late_ms;
+    int next;
+
+    if (late > *max_late)
+    {
+        *max_late = late;
+    }
+
+    src->due = -1;
+    src->busy = 1;
+    src->runner = pthread_self();
+    pthread_mutex_unlock(&st->mutex);
+    next = src->timer_cb(src->arg);
+    pthread_mutex_lock(&st->mutex);
+    src->busy = 0;
+    st->stats.timers++;
+
+    /* unless it was kicked while it ran */
+    if (next >= 0 && src->due < 0)
+    {
+        src->due = station_now() + next;
+    }
+
+    pthread_cond_broadcast(&st->idle);
+}
+
+
+/*
+ * One pass of the loop: waits up to timeout_ms, -1 for ever, for a port
+ * to become readable, a timer to be due or a kick, then runs what is
+ * ready.  Returns the number of callbacks run.
+ */
+static int station_dispatch(hamlib_station_t *st, int timeout_ms)
+{
+    station_source_t *src;
+    struct timeval tv;
+    fd_set rfds;
+    double wait_ms = timeout_ms;
+    double now, due;
+    int maxfd;
+    int ran = 0;
+    int n;
+
+    pthread_mutex_lock(&st->mutex);
+
+    if (st->dispatching)
+    {
+        pthread_mutex_unlock(&st->mutex);
+        return -RIG_EINVAL;
+    }
+
+    st->dispatching = 1;
+
+    FD_ZERO(&rfds);
+    FD_SET(st->wake[0], &rfds);
+    maxfd = st->wake[0];
+    now = station_now();
+
+    for (src = st->sources; src; src = src->next)
+    {
+        if (src->rest > 0 && src->rest <= now && !src->removed)
+        {
+            src->rest = 0;
+            station_watch(st, 1, src->fd);
+        }
+
+        src->polled = !src->removed && src->fd >= 0 && src->read_cb
+                      && src->rest == 0;
+
+        if (src->polled)
+        {
+            FD_SET(src->fd, &rfds);
+
+            if (src->fd > maxfd)
+            {
+                maxfd = src->fd;
+            }
+        }
+    }
+
+    due = station_next_due(st, 0);
+
+    if (due >= 0 && (wait_ms < 0 || due - now < wait_ms))
+    {
+        wait_ms = due > now ? due - now : 0;
+    }
+
+    pthread_mutex_unlock(&st->mutex);
+
+    if (wait_ms >= 0)
+    {
+        tv.tv_sec = (long)(wait_ms / 1000);
+        tv.tv_usec = (long)((wait_ms - tv.tv_sec * 1000.0) * 1000);
+    }
+
+    n = select(maxfd + 1, &rfds, NULL, NULL, wait_ms < 0 ? NULL : &tv);
+
+    if (n < 0)
+    {
+        /* interrupted, or a port closed under the wait: the next pass
+           builds the set again */
+        FD_ZERO(&rfds);
+    }
+    else if (FD_ISSET(st->wake[0], &rfds))
+    {
+        station_drain(st->wake[0]);
+    }
+
+    pthread_mutex_lock(&st->mutex);
+
+#if defined(STATION_EPOLL)
+
+    if (st->timer_fd >= 0)
+    {
+        station_drain(st->timer_fd);
+    }
+
+#endif
+
+    st->stats.wakeups++;
+    now = station_now();
+
+    for (src = st->sources; src; src = src->next)
+    {
+        if (src->polled && !src->removed && FD_ISSET(src->fd, &rfds))
+        {
+            int rest;
+
+            src->busy = 1;
+            src->runner = pthread_self();
+            pthread_mutex_unlock(&st->mutex);
+            rest = src->read_cb(src->arg);
+            pthread_mutex_lock(&st->mutex);
+            src->busy = 0;
+
+            if (rest > 0 && !src->removed)
+            {
+                src->rest = station_now() + rest;
+                station_watch(st, 0, src->fd);
+            }
+
+            st->stats.events++;
+            ran++;
+            pthread_cond_broadcast(&st->idle);
+        }
+
+        if (!src->io && station_due(src, now))
+        {
+            station_run_timer(st, src);
+            ran++;
+        }
+    }
+
+    station_reap(st);
+    station_arm(st);
+    st->dispatching = 0;
+    pthread_mutex_unlock(&st->mutex);
+
+    return ran;
+}
+
+
+/*
+ * Runs the timers that talk to a port, one at a time, so that a slow
+ * rotator or amplifier does not hold up the loop or the main loop of the
+ * application.
+ */
+static void *station_io_thread(void *arg)
+{
+    hamlib_station_t *st = arg;
+
+    pthread_mutex_lock(&st->mutex);
+
+    while (!st->io_stop)
+    {
+        station_source_t *src;
+        double now = station_now();
+        double due;
+
+        for (src = st->sources; src; src = src->next)
+        {
+            if (src->io && station_due(src, now))
+            {
+                break;
+            }
+        }
+
+        if (src)
+        {
+            station_run_timer(st, src);
+            station_reap(st);
+            continue;
+        }
+
+        due = station_next_due(st, 1);
+
+        if (due < 0)
+        {
+            pthread_cond_wait(&st->io_wake, &st->mutex);
+        }
+        else
+        {
+            struct timespec ts;
+            double ms = due - now;
+
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += (time_t)(ms / 1000);
+            ts.tv_nsec += (long)((ms - (time_t)(ms / 1000) * 1000.0) * 1e6);
+
+            if (ts.tv_nsec >= 1000000000L)
+            {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+
+            pthread_cond_timedwait(&st->io_wake, &st->mutex, &ts);
+        }
+
+        st->stats.wakeups++;
+    }
+
+    pthread_mutex_unlock(&st->mutex);
+
+    return NULL;
+}
+
+
+static void *station_thread(void *arg)
+{
+    hamlib_station_t *st = arg;
+
+    pthread_mutex_lock(&st->mutex);
+
+    while (!st->stop)
+    {
+        pthread_mutex_unlock(&st->mutex);
+        station_dispatch(st, -1);
+        pthread_mutex_lock(&st->mutex);
+    }
+
+    pthread_mutex_unlock(&st->mutex);
+
+    return NULL;
+}
+
+
+/*
+ * Adds a port read or a timer, or both, to the station.  read_cb runs
+ * when fd is readable, timer_cb first_ms from now and then as it asks,
+ * first_ms < 0 waits for station_kick().  Returns NULL when the source
+ * cannot be added, the caller then runs its own thread.
+ */
+station_source_t *station_add(hamlib_station_t *st, int fd,
+                              station_read_t read_cb, station_timer_t timer_cb,
+                              void *arg, int first_ms)
+{
+    station_source_t *src, **p;
+
+    if (!st || (fd >= FD_SETSIZE && read_cb))
+    {
+        return NULL;
+    }
+
+    src = calloc(1, sizeof(*src));
+
+    if (!src)
+    {
+        return NULL;
+    }
+
+    src->fd = read_cb ? fd : -1;
+    src->read_cb = read_cb;
+    src->timer_cb = timer_cb;
+    src->arg = arg;
+    src->due = first_ms < 0 || !timer_cb ? -1 : station_now() + first_ms;
+
+    pthread_mutex_lock(&st->mutex);
+
+    for (p = &st->sources; *p; p = &(*p)->next)
+    {
+    }
+
+    *p = src;
+    station_watch(st, 1, src->fd);
+    station_arm(st);
+    station_wake(st);
+    pthread_mutex_unlock(&st->mutex);
+
+    return src;
+}
+
+
+/*
+ * Adds a timer that talks to a port, run on the I/O thread of the
+ * station with the other ones, as station_add() runs a timer.
+ */
+station_source_t *station_add_io(hamlib_station_t *st, station_timer_t timer_cb,
+                                 void *arg, int first_ms)
+{
+    station_source_t *src, **p;
+
+    if (!st || !timer_cb)
+    {
+        return NULL;
+    }
+
+    src = calloc(1, sizeof(*src));
+
+    if (!src)
+    {
+        return NULL;
+    }
+
+    src->fd = -1;
+    src->io = 1;
+    src->timer_cb = timer_cb;
+    src->arg = arg;
+    src->due = first_ms < 0 ? -1 : station_now() + first_ms;
+
+    pthread_mutex_lock(&st->mutex);
+
+    if (!st->io_running)
+    {
+        st->io_stop = 0;
+
+        if (pthread_create(&st->io_thread_id, NULL, station_io_thread, st))
+        {
+            pthread_mutex_unlock(&st->mutex);
+            rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                      strerror(errno));
+            free(src);
+            return NULL;
+        }
+
+        st->io_running = 1;
+    }
+
+    for (p = &st->sources; *p; p = &(*p)->next)
+    {
+    }
+
+    *p = src;
+    pthread_cond_signal(&st->io_wake);
+    pthread_mutex_unlock(&st->mutex);
+
+    return src;
+}
+
+
+/*
+ * Takes a source off the station.  When it returns its callbacks have
+ * returned and are not called again, unless called from its own callback.
+ */
+void station_remove(hamlib_station_t *st, station_source_t *src)
+{
+    if (!st || !src)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+    src->removed = 1;
+    station_watch(st, 0, src->fd);
+
+    /* from its own callback it is freed once that returns */
+    while (src->busy && !pthread_equal(src->runner, pthread_self()))
+    {
+        pthread_cond_wait(&st->idle, &st->mutex);
+    }
+
+    station_reap(st);
+    station_arm(st);
+    station_wake(st);
+    pthread_mutex_unlock(&st->mutex);
+}
+
+
+/* runs the timer of the source as soon as possible */
+void station_kick(hamlib_station_t *st, station_source_t *src)
+{
+    if (!st || !src)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+
+    if (!src->removed)
+    {
+        src->due = station_now();
+
+        if (src->io)
+        {
+            pthread_cond_signal(&st->io_wake);
+        }
+        else
+        {
+            station_arm(st);
+            station_wake(st);
+        }
+    }
+
+    pthread_mutex_unlock(&st->mutex);
+}
+
+
+/* a thread of the station runs the loop, not the application */
+int station_threaded(hamlib_station_t *st)
+{
+    int running;
+
+    if (!st)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+    running = st->running;
+    pthread_mutex_unlock(&st->mutex);
+
+    return running;
+}
+
+
+static int station_join(hamlib_station_t *st, void *handle, void **station,
+                        int comm_state)
+{
+    struct station_member *members;
+
+    if (!st || !handle)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (*station || comm_state)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: the handle is open or in a station\n",
+                  __func__);
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+    members = realloc(st->members, (st->nmembers + 1) * sizeof(*members));
+
+    if (!members)
+    {
+        pthread_mutex_unlock(&st->mutex);
+        return -RIG_ENOMEM;
+    }
+
+    members[st->nmembers].handle = handle;
+    members[st->nmembers].station = station;
+    st->members = members;
+    st->nmembers++;
+    *station = st;
+    pthread_mutex_unlock(&st->mutex);
+
+    return RIG_OK;
+}
+
+
+/* called by the cleanup of a handle in the station */
+void station_leave(hamlib_station_t *st, void *handle)
+{
+    int i;
+
+    if (!st)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+
+    for (i = 0; i < st->nmembers; i++)
+    {
+        if (st->members[i].handle == handle)
+        {
+            *st->members[i].station = NULL;
+            st->members[i] = st->members[--st->nmembers];
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&st->mutex);
+}
+#endif
+//! @endcond
+
+
+/**
+ * \brief Create a station event loop
+ *
+ * Rigs, rotators and amplifiers added to the station with
+ * rig_station_add_rig(), rig_station_add_rot() and rig_station_add_amp()
+ * before they are opened run their port reads and polls on the loop of
+ * the station instead of threads of their own:
+ *
+ * - the transceive frames of a rig with async data enabled, when the
+ *   station runs its own thread,
+ * - the change detection of the rig poll routine,
+ * - the level polls of an amplifier, see amp_set_poll(),
+ * - the trajectory tracker of a rotator, see rot_track_start().
+ *
+ * Either start the thread of the station with rig_station_start(), or
+ * have the main loop of the application wait on rig_station_get_fd() and
+ * call rig_station_dispatch().  The amplifier polls and the tracker talk
+ * to their ports from the I/O thread of the station, one at a time, so
+ * that the loop never waits on a slow port.
+ *
+ * \return The station, or NULL when out of memory or when the station
+ * loop is not available on this platform.
+ *
+ * \sa rig_station_free()
+ */
+hamlib_station_t *HAMLIB_API rig_station_new(void)
+{
+#if defined(STATION_LOOP)
+    hamlib_station_t *st;
+
+    st = calloc(1, sizeof(*st));
+
+    if (!st)
+    {
+        return NULL;
+    }
+
+    if (pipe(st->wake) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pipe: %s\n", __func__, strerror(errno));
+        free(st);
+        return NULL;
+    }
+
+    fcntl(st->wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(st->wake[1], F_SETFL, O_NONBLOCK);
+    st->epoll_fd = -1;
+    st->timer_fd = -1;
+    pthread_mutex_init(&st->mutex, NULL);
+    pthread_cond_init(&st->idle, NULL);
+    pthread_cond_init(&st->io_wake, NULL);
+
+    return st;
+#else
+    rig_debug(RIG_DEBUG_ERR, "%s: no station loop on this platform\n", __func__);
+    return NULL;
+#endif
+}
+
+
+/**
+ * \brief Add a rig to a station
+ * \param st    The station
+ * \param rig   The rig handle, not open
+ *
+ * \return RIG_OK, or -RIG_EINVAL if the rig is open or already in a station.
+ */
+int HAMLIB_API rig_station_add_rig(hamlib_station_t *st, RIG *rig)
+{
+#if defined(STATION_LOOP)
+
+    if (!rig)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return station_join(st, rig, &STATE(rig)->station, STATE(rig)->comm_state);
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+/**
+ * \brief Add a rotator to a station
+ * \param st    The station
+ * \param rot   The rotator handle, not open
+ *
+ * \return RIG_OK, or -RIG_EINVAL if the rotator is open or already in a
+ * station.
+ */
+int HAMLIB_API rig_station_add_rot(hamlib_station_t *st, struct s_rot *rot)
+{
+#if defined(STATION_LOOP)
+
+    if (!rot)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return station_join(st, rot, &ROTSTATE(rot)->station,
+                        ROTSTATE(rot)->comm_state);
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+/**
+ * \brief Add an amplifier to a station
+ * \param st    The station
+ * \param amp   The amplifier handle, not open
+ *
+ * \return RIG_OK, or -RIG_EINVAL if the amplifier is open or already in a
+ * station.
+ */
+int HAMLIB_API rig_station_add_amp(hamlib_station_t *st, struct amp *amp)
+{
+#if defined(STATION_LOOP)
+
+    if (!amp)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return station_join(st, amp, &AMPSTATE(amp)->station,
+                        AMPSTATE(amp)->comm_state);
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+/**
+ * \brief Run the station loop on a thread of its own
+ * \param st    The station
+ *
+ * Start it before opening the rigs of the station for their transceive
+ * frames to be read on it, and stop it only after closing them.
+ *
+ * \return RIG_OK, or a negative value if the thread is running or could
+ * not be started.
+ */
+int HAMLIB_API rig_station_start(hamlib_station_t *st)
+{
+#if defined(STATION_LOOP)
+
+    if (!st)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+
+    if (st->running)
+    {
+        pthread_mutex_unlock(&st->mutex);
+        return -RIG_EINVAL;
+    }
+
+    st->stop = 0;
+
+    if (pthread_create(&st->thread_id, NULL, station_thread, st))
+    {
+        pthread_mutex_unlock(&st->mutex);
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                  strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    st->running = 1;
+    pthread_mutex_unlock(&st->mutex);
+
+    return RIG_OK;
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+/**
+ * \brief Stop the thread of the station loop
+ * \param st    The station
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a st is NULL.
+ */
+int HAMLIB_API rig_station_stop(hamlib_station_t *st)
+{
+#if defined(STATION_LOOP)
+
+    if (!st)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+
+    if (!st->running)
+    {
+        pthread_mutex_unlock(&st->mutex);
+        return RIG_OK;
+    }
+
+    st->stop = 1;
+    station_wake(st);
+    pthread_mutex_unlock(&st->mutex);
+
+    pthread_join(st->thread_id, NULL);
+
+    pthread_mutex_lock(&st->mutex);
+    st->running = 0;
+    pthread_mutex_unlock(&st->mutex);
+
+    return RIG_OK;
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+/**
+ * \brief Get the fd for an application main loop to wait on
+ * \param st    The station
+ *
+ * The fd becomes readable when a port of the station is readable or one
+ * of its timers is due, the main loop then calls rig_station_dispatch()
+ * with a timeout of 0.  The fd belongs to the station.
+ *
+ * \return The fd, or -RIG_ENAVAIL on platforms without epoll and timerfd.
+ */
+int HAMLIB_API rig_station_get_fd(hamlib_station_t *st)
+{
+#if defined(STATION_EPOLL)
+    station_source_t *src;
+    int fd;
+
+    if (!st)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+
+    if (st->epoll_fd < 0)
+    {
+        st->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        st->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+        if (st->epoll_fd < 0 || st->timer_fd < 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __func__, strerror(errno));
+
+            if (st->epoll_fd >= 0) { close(st->epoll_fd); }
+
+            if (st->timer_fd >= 0) { close(st->timer_fd); }
+
+            st->epoll_fd = -1;
+            st->timer_fd = -1;
+            pthread_mutex_unlock(&st->mutex);
+            return -RIG_EIO;
+        }
+
+        station_watch(st, 1, st->wake[0]);
+        station_watch(st, 1, st->timer_fd);
+
+        for (src = st->sources; src; src = src->next)
+        {
+            if (!src->removed && src->rest == 0)
+            {
+                station_watch(st, 1, src->fd);
+            }
+        }
+
+        station_arm(st);
+    }
+
+    fd = st->epoll_fd;
+    pthread_mutex_unlock(&st->mutex);
+
+    return fd;
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+/**
+ * \brief Run one pass of the station loop
+ * \param st    The station
+ * \param timeout_ms    Longest wait for a port or timer in ms, 0 to run
+ * only what is ready, -1 to wait for ever
+ *
+ * For applications that run the station loop on their own main loop
+ * instead of rig_station_start().
+ *
+ * \return The number of port reads and timers run, or -RIG_EINVAL when
+ * the thread of the station or another caller runs the loop.
+ */
+int HAMLIB_API rig_station_dispatch(hamlib_station_t *st, int timeout_ms)
+{
+#if defined(STATION_LOOP)
+
+    if (!st || station_threaded(st))
+    {
+        return -RIG_EINVAL;
+    }
+
+    return station_dispatch(st, timeout_ms);
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+/**
+ * \brief Get the counters of a station loop
+ * \param st    The station
+ * \param stats Where to store them
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a st or \a stats is NULL.
+ */
+int HAMLIB_API rig_station_get_stats(hamlib_station_t *st,
+                                     hamlib_station_stats_t *stats)
+{
+#if defined(STATION_LOOP)
+    const station_source_t *src;
+
+    if (!st || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+    *stats = st->stats;
+    stats->sources = 0;
+
+    for (src = st->sources; src; src = src->next)
+    {
+        if (!src->removed)
+        {
+            stats->sources++;
+        }
+    }
+
+    pthread_mutex_unlock(&st->mutex);
+
+    return RIG_OK;
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+/**
+ * \brief Free a station
+ * \param st    The station
+ *
+ * Stops the thread of the station.  The handles of the station must be
+ * closed first, they can be opened again out of the station.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if a handle of the station is still open.
+ */
+int HAMLIB_API rig_station_free(hamlib_station_t *st)
+{
+#if defined(STATION_LOOP)
+    int i;
+
+    if (!st)
+    {
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_lock(&st->mutex);
+    station_reap(st);
+
+    if (st->sources)
+    {
+        pthread_mutex_unlock(&st->mutex);
+        rig_debug(RIG_DEBUG_ERR, "%s: close the handles of the station first\n",
+                  __func__);
+        return -RIG_EINVAL;
+    }
+
+    pthread_mutex_unlock(&st->mutex);
+    rig_station_stop(st);
+
+    pthread_mutex_lock(&st->mutex);
+
+    if (st->io_running)
+    {
+        st->io_stop = 1;
+        pthread_cond_signal(&st->io_wake);
+        pthread_mutex_unlock(&st->mutex);
+        pthread_join(st->io_thread_id, NULL);
+        pthread_mutex_lock(&st->mutex);
+        st->io_running = 0;
+    }
+
+    for (i = 0; i < st->nmembers; i++)
+    {
+        *st->members[i].station = NULL;
+    }
+
+    pthread_mutex_unlock(&st->mutex);
+
+    free(st->members);
+    close(st->wake[0]);
+    close(st->wake[1]);
+
+    if (st->epoll_fd >= 0)
+    {
+        close(st->epoll_fd);
+        close(st->timer_fd);
+    }
+
+    pthread_cond_destroy(&st->io_wake);
+    pthread_cond_destroy(&st->idle);
+    pthread_mutex_destroy(&st->mutex);
+    free(st);
+
+    return RIG_OK;
+#else
+    return -RIG_ENAVAIL;
+#endif
+}
+
+
+//! @cond Doxygen_Suppress
+#if !defined(STATION_LOOP)
+station_source_t *station_add(hamlib_station_t *st, int fd,
+                              station_read_t read_cb, station_timer_t timer_cb,
+                              void *arg, int first_ms)
+{
+    return NULL;
+}
+
+
+station_source_t *station_add_io(hamlib_station_t *st, station_timer_t timer_cb,
+                                 void *arg, int first_ms)
+{
+    return NULL;
+}
+
+
+void station_remove(hamlib_station_t *st, station_source_t *src)
+{
+}
+
+
+void station_kick(hamlib_station_t *st, station_source_t *src)
+{
+}
+
+
+int station_threaded(hamlib_station_t *st)
+{
+    return 0;
+}
+
+
+void station_leave(hamlib_station_t *st, void *handle)
+{
+}
+#endif
+//! @endcond
+
+/*! @} */
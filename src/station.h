@@ -0,0 +1,46 @@
+/*
+ *  Hamlib Interface - station event loop header
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _STATION_H
+#define _STATION_H 1
+
+#include <hamlib/rig.h>
+
+/* timers due this close to a wakeup run on it */
+#define STATION_SLACK_MS 5
+
+typedef struct station_source station_source_t;
+
+/* the fd of the source is readable, returns 0 or ms to leave it alone after an error */
+typedef int (*station_read_t)(void *arg);
+/* the source is due, returns ms to its next run or -1 to wait for a kick */
+typedef int (*station_timer_t)(void *arg);
+
+station_source_t *station_add(hamlib_station_t *st, int fd,
+                              station_read_t read_cb, station_timer_t timer_cb,
+                              void *arg, int first_ms);
+station_source_t *station_add_io(hamlib_station_t *st, station_timer_t timer_cb,
+                                 void *arg, int first_ms);
+void station_remove(hamlib_station_t *st, station_source_t *src);
+void station_kick(hamlib_station_t *st, station_source_t *src);
+int station_threaded(hamlib_station_t *st);
+void station_leave(hamlib_station_t *st, void *handle);
+
+#endif
@@ -143,6 +143,38 @@
 #define TOK_MULTICAST_CMD_PORT  TOKEN_FRONTEND(135)
 /** \brief rig: Skip setting freq on opposite VFO when in split mode */
 #define TOK_FREQ_SKIP  TOKEN_FRONTEND(136)
+/** \brief rig: File to record rig port traffic to */
+#define TOK_TRACE_RECORD  TOKEN_FRONTEND(137)
+/** \brief rig: Trace file to replay in place of the rig port */
+#define TOK_TRACE_REPLAY  TOKEN_FRONTEND(138)
+/** \brief rig: Replay timing in percent of the recorded timing */
+#define TOK_TRACE_TIMING  TOKEN_FRONTEND(139)
+/** \brief rig: Adapt the cache timeouts to the measured port load */
+#define TOK_CACHE_ADAPTIVE  TOKEN_FRONTEND(140)
+/** \brief rig: Adaptive cache port load to aim for in percent */
+#define TOK_CACHE_TARGET_LOAD  TOKEN_FRONTEND(141)
+/** \brief rig: Adaptive cache longest timeout in ms */
+#define TOK_CACHE_MAX_MS  TOKEN_FRONTEND(142)
+/** \brief rig: Queue set_freq, set_split_freq and set_mode, newest value wins */
+#define TOK_ASYNC_SET  TOKEN_FRONTEND(143)
+/** \brief rig: Publish only the changed fields between multicast keyframes */
+#define TOK_MULTICAST_DELTA  TOKEN_FRONTEND(144)
+/** \brief rig: Longest time between multicast keyframes in ms */
+#define TOK_MULTICAST_KEYFRAME  TOKEN_FRONTEND(145)
+/** \brief rig: Spectrum reduction of the multicast scope lines */
+#define TOK_MULTICAST_SPECTRUM  TOKEN_FRONTEND(146)
+/** \brief rig: Line the software CW keyer keys */
+#define TOK_KEYER_TYPE  TOKEN_FRONTEND(147)
+/** \brief rig: Device of the software CW keyer line */
+#define TOK_KEYER_PATHNAME  TOKEN_FRONTEND(148)
+/** \brief rig: CM108 GPIO bit of the software CW keyer line */
+#define TOK_KEYER_BITNUM  TOKEN_FRONTEND(149)
+/** \brief rig: Software CW keyer character speed */
+#define TOK_KEYER_WPM  TOKEN_FRONTEND(150)
+/** \brief rig: Software CW keyer Farnsworth speed */
+#define TOK_KEYER_FARNSWORTH  TOKEN_FRONTEND(151)
+/** \brief rig: Software CW keyer weighting */
+#define TOK_KEYER_WEIGHT  TOKEN_FRONTEND(152)
 
 /*
  * rotator specific tokens
@@ -158,6 +190,20 @@
 #define TOK_MAX_EL  TOKEN_FRONTEND(113)
 /** \brief rot: South is zero degrees */
 #define TOK_SOUTH_ZERO  TOKEN_FRONTEND(114)
+/** \brief rot: How far in degrees each tracking command leads the trajectory */
+#define TOK_TRACK_DEADBAND  TOKEN_FRONTEND(115)
+/** \brief rot: Tracker position read interval in milliseconds */
+#define TOK_TRACK_INTERVAL  TOKEN_FRONTEND(116)
+
+/*
+ * amplifier specific tokens
+ */
+/** \brief amp: Level cache timeout in milliseconds */
+#define TOK_AMP_CACHE_TIMEOUT  TOKEN_FRONTEND(110)
+/** \brief amp: Levels to poll in the background, LEVEL[:MS]/... */
+#define TOK_AMP_POLL_LEVELS  TOKEN_FRONTEND(111)
+/** \brief amp: Default background poll interval in milliseconds */
+#define TOK_AMP_POLL_INTERVAL  TOKEN_FRONTEND(112)
 
 
 #endif /* _TOKEN_H */
@@ -0,0 +1,571 @@
+/*
+ *  Hamlib Interface - port trace record/replay
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file trace.c
+ * \brief Record and replay of port traffic
+ *
+ * A recording trace captures every write_block() and every read_string()
+ * or read_block() result of a live port together with the time between
+ * them.  A replay trace serves the recorded responses back to the backend
+ * through a #RIG_PORT_REPLAY port, so a backend can be exercised and
+ * benchmarked without the radio.
+ */
+
+/**
+ * \addtogroup rig_internal
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "trace.h"
+#include "misc.h"
+
+struct trace_record
+{
+    int type;
+    unsigned int delta_us;
+    int len;
+    unsigned char *data;
+};
+
+struct port_trace
+{
+    struct port_trace *next;
+    hamlib_port_t *port;
+    hamlib_trace_stats_t *stats;
+    struct timeval last;
+    rig_port_t port_type;   /* restored when the trace is stopped */
+
+    /* recording */
+    FILE *fp;
+
+    /* replay */
+    unsigned char *buf;
+    struct trace_record *records;
+    int nrecords;
+    int pos;
+    int timing;
+};
+
+static struct port_trace *trace_list;
+static volatile int trace_count;
+
+#if defined(HAVE_PTHREAD)
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+#define TRACE_LOCK pthread_mutex_lock(&trace_lock)
+#define TRACE_UNLOCK pthread_mutex_unlock(&trace_lock)
+#else
+#define TRACE_LOCK
+#define TRACE_UNLOCK
+#endif
+
+
+static struct port_trace *trace_find(const hamlib_port_t *p)
+{
+    struct port_trace *t;
+
+    for (t = trace_list; t != NULL; t = t->next)
+    {
+        if (t->port == p)
+        {
+            return t;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void trace_add(struct port_trace *t)
+{
+    TRACE_LOCK;
+    t->next = trace_list;
+    trace_list = t;
+    trace_count++;
+    TRACE_UNLOCK;
+}
+
+
+static unsigned int trace_delta_us(struct port_trace *t)
+{
+    struct timeval now, delta;
+
+    gettimeofday(&now, NULL);
+    timersub(&now, &t->last, &delta);
+    t->last = now;
+
+    return (unsigned int)(delta.tv_sec * 1000000 + delta.tv_usec);
+}
+
+
+static void put_le32(unsigned char *b, unsigned int v)
+{
+    b[0] = v & 0xff;
+    b[1] = (v >> 8) & 0xff;
+    b[2] = (v >> 16) & 0xff;
+    b[3] = (v >> 24) & 0xff;
+}
+
+
+static unsigned int get_le32(const unsigned char *b)
+{
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int)b[3] << 24);
+}
+
+
+/*
+ * Start recording the traffic of an open port to pathname
+ * stats may be NULL
+ */
+int port_trace_record_start(hamlib_port_t *p, const char *pathname,
+                            rig_model_t model, hamlib_trace_stats_t *stats)
+{
+    struct port_trace *t;
+    unsigned char hdr[12];
+
+    t = calloc(1, sizeof(struct port_trace));
+
+    if (!t)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    t->fp = fopen(pathname, "wb");
+
+    if (!t->fp)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot create %s: %s\n", __func__, pathname,
+                  strerror(errno));
+        free(t);
+        return -RIG_EIO;
+    }
+
+    memcpy(hdr, PORT_TRACE_MAGIC, 8);
+    put_le32(hdr + 8, model);
+
+    if (fwrite(hdr, sizeof(hdr), 1, t->fp) != 1)
+    {
+        fclose(t->fp);
+        free(t);
+        return -RIG_EIO;
+    }
+
+    t->port = p;
+    t->stats = stats;
+    t->port_type = p->type.rig;
+    gettimeofday(&t->last, NULL);
+
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+    }
+
+    trace_add(t);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: recording port traffic to %s\n", __func__,
+              pathname);
+
+    return RIG_OK;
+}
+
+
+/*
+ * Load a trace file and attach it to the port, switching the port to
+ * RIG_PORT_REPLAY until port_trace_stop() gives it back its own type
+ * timing is the replay speed in percent of the recorded timing,
+ * 0 replays as fast as possible
+ */
+int port_trace_replay_start(hamlib_port_t *p, const char *pathname,
+                            int timing, hamlib_trace_stats_t *stats)
+{
+    struct port_trace *t;
+    FILE *fp;
+    long size;
+    long off;
+    int n;
+
+    fp = fopen(pathname, "rb");
+
+    if (!fp)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot open %s: %s\n", __func__, pathname,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    t = calloc(1, sizeof(struct port_trace));
+
+    if (!t)
+    {
+        fclose(fp);
+        return -RIG_ENOMEM;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    rewind(fp);
+
+    t->buf = size > 0 ? malloc(size) : NULL;
+
+    if (!t->buf || fread(t->buf, size, 1, fp) != 1
+            || size < 12 || memcmp(t->buf, PORT_TRACE_MAGIC, 8) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s is not a trace file\n", __func__, pathname);
+        fclose(fp);
+        free(t->buf);
+        free(t);
+        return -RIG_EPROTO;
+    }
+
+    fclose(fp);
+
+    /* first pass counts the records, second pass indexes them */
+    for (n = 0, off = 12; off + 9 <= size; n++)
+    {
+        int len = (int)get_le32(t->buf + off + 5);
+
+        off += 9 + (t->buf[off] == PORT_TRACE_ERROR ? 0 : len);
+    }
+
+    t->records = calloc(n > 0 ? n : 1, sizeof(struct trace_record));
+
+    if (!t->records)
+    {
+        free(t->buf);
+        free(t);
+        return -RIG_ENOMEM;
+    }
+
+    for (n = 0, off = 12; off + 9 <= size; n++)
+    {
+        struct trace_record *r = &t->records[n];
+
+        r->type = t->buf[off];
+        r->delta_us = get_le32(t->buf + off + 1);
+        r->len = (int)get_le32(t->buf + off + 5);
+        r->data = t->buf + off + 9;
+
+        if (r->type != PORT_TRACE_ERROR && off + 9 + r->len > size)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: %s truncated after %d records\n", __func__,
+                      pathname, n);
+            break;
+        }
+
+        off += 9 + (r->type == PORT_TRACE_ERROR ? 0 : r->len);
+    }
+
+    t->nrecords = n;
+    t->port = p;
+    t->stats = stats;
+    t->timing = timing;
+    t->port_type = p->type.rig;
+    p->type.rig = RIG_PORT_REPLAY;
+
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+    }
+
+    trace_add(t);
+
+    rig_debug(RIG_DEBUG_VERBOSE,
+              "%s: replaying %d records of model %u from %s, timing=%d%%\n",
+              __func__, n, get_le32(t->buf + 8), pathname, timing);
+
+    return RIG_OK;
+}
+
+
+/*
+ * Detach any trace from the port, safe to call when none is active
+ */
+void port_trace_stop(hamlib_port_t *p)
+{
+    struct port_trace **tp;
+    struct port_trace *t = NULL;
+
+    if (trace_count == 0)
+    {
+        return;
+    }
+
+    TRACE_LOCK;
+
+    for (tp = &trace_list; *tp != NULL; tp = &(*tp)->next)
+    {
+        if ((*tp)->port == p)
+        {
+            t = *tp;
+            *tp = t->next;
+            trace_count--;
+            break;
+        }
+    }
+
+    TRACE_UNLOCK;
+
+    if (!t)
+    {
+        return;
+    }
+
+    p->type.rig = t->port_type;
+
+    if (t->fp)
+    {
+        fclose(t->fp);
+    }
+
+    if (t->records && t->pos < t->nrecords)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: %d of %d records not replayed\n", __func__,
+                  t->nrecords - t->pos, t->nrecords);
+
+        /* a write the backend no longer sends is a regression too */
+        for (; t->pos < t->nrecords && t->stats; t->pos++)
+        {
+            if (t->records[t->pos].type == PORT_TRACE_WRITE)
+            {
+                t->stats->mismatches++;
+            }
+        }
+    }
+
+    free(t->records);
+    free(t->buf);
+    free(t);
+}
+
+
+/*
+ * Append one exchange to a recording trace, no-op if the port is not
+ * being recorded.  For PORT_TRACE_ERROR len is the error code.
+ */
+void port_trace_record(hamlib_port_t *p, int type, const unsigned char *buf,
+                       int len)
+{
+    struct port_trace *t;
+    unsigned char hdr[9];
+
+    if (trace_count == 0)
+    {
+        return;
+    }
+
+    TRACE_LOCK;
+    t = trace_find(p);
+
+    if (!t || !t->fp)
+    {
+        TRACE_UNLOCK;
+        return;
+    }
+
+    hdr[0] = type;
+    put_le32(hdr + 1, trace_delta_us(t));
+    put_le32(hdr + 5, (unsigned int)(type == PORT_TRACE_ERROR ? -len : len));
+    fwrite(hdr, sizeof(hdr), 1, t->fp);
+
+    if (type != PORT_TRACE_ERROR && len > 0)
+    {
+        fwrite(buf, len, 1, t->fp);
+    }
+
+    if (t->stats)
+    {
+        switch (type)
+        {
+        case PORT_TRACE_WRITE:
+            t->stats->writes++;
+            t->stats->bytes_written += len;
+            break;
+
+        case PORT_TRACE_READ:
+            t->stats->reads++;
+            t->stats->bytes_read += len;
+            break;
+
+        default:
+            t->stats->read_errors++;
+        }
+    }
+
+    TRACE_UNLOCK;
+}
+
+
+/*
+ * Consume the next recorded write and compare it with what the backend sent
+ */
+int port_trace_replay_write(hamlib_port_t *p, const unsigned char *buf,
+                            size_t count)
+{
+    struct port_trace *t;
+
+    TRACE_LOCK;
+    t = trace_find(p);
+
+    if (!t || !t->records)
+    {
+        TRACE_UNLOCK;
+        rig_debug(RIG_DEBUG_ERR, "%s: no replay trace attached\n", __func__);
+        return -RIG_EIO;
+    }
+
+    if (t->stats)
+    {
+        t->stats->writes++;
+        t->stats->bytes_written += count;
+    }
+
+    if (t->pos < t->nrecords && t->records[t->pos].type == PORT_TRACE_WRITE)
+    {
+        const struct trace_record *r = &t->records[t->pos++];
+
+        if ((size_t) r->len != count || memcmp(r->data, buf, count) != 0)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: write differs from record %d\n", __func__,
+                      t->pos - 1);
+
+            if (t->stats) { t->stats->mismatches++; }
+        }
+    }
+    else
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: unexpected write at record %d\n", __func__,
+                  t->pos);
+
+        if (t->stats) { t->stats->mismatches++; }
+    }
+
+    TRACE_UNLOCK;
+
+    dump_hex(buf, count);
+
+    return RIG_OK;
+}
+
+
+/*
+ * Serve the next recorded response, skipping writes the backend did not
+ * repeat.  Returns the byte count or the recorded error, -RIG_ETIMEOUT at
+ * the end of the trace.
+ */
+int port_trace_replay_read(hamlib_port_t *p, unsigned char *buf, size_t max)
+{
+    struct port_trace *t;
+    const struct trace_record *r = NULL;
+    unsigned int delay_us = 0;
+    int timing;
+    int ret;
+
+    TRACE_LOCK;
+    t = trace_find(p);
+
+    if (!t || !t->records)
+    {
+        TRACE_UNLOCK;
+        rig_debug(RIG_DEBUG_ERR, "%s: no replay trace attached\n", __func__);
+        return -RIG_EIO;
+    }
+
+    while (t->pos < t->nrecords && t->records[t->pos].type == PORT_TRACE_WRITE)
+    {
+        t->pos++;
+
+        if (t->stats) { t->stats->mismatches++; }
+    }
+
+    if (t->pos < t->nrecords)
+    {
+        r = &t->records[t->pos++];
+        delay_us = r->delta_us;
+    }
+
+    timing = t->timing;
+
+    if (!r || r->type == PORT_TRACE_ERROR)
+    {
+        ret = r ? -r->len : -RIG_ETIMEOUT;
+
+        if (t->stats) { t->stats->read_errors++; }
+    }
+    else
+    {
+        ret = (size_t) r->len < max ? r->len : (int)max;
+        memcpy(buf, r->data, ret);
+
+        if (t->stats)
+        {
+            t->stats->reads++;
+            t->stats->bytes_read += ret;
+        }
+    }
+
+    TRACE_UNLOCK;
+
+    if (timing > 0 && delay_us > 0)
+    {
+        hl_usleep((rig_useconds_t)delay_us * timing / 100);
+    }
+
+    return ret;
+}
+
+
+/**
+ * \brief Get the port trace counters of a rig
+ * \param rig The rig handle
+ * \param stats Where to store the counters
+ *
+ * The counters are reset when rig_open() starts recording or replaying
+ * a trace and remain readable after rig_close().
+ *
+ * \return RIG_OK, or -RIG_EINVAL if an argument is NULL
+ */
+int HAMLIB_API rig_get_trace_stats(RIG *rig, hamlib_trace_stats_t *stats)
+{
+    if (!rig || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    TRACE_LOCK;
+    *stats = rig->state.trace_stats;
+    TRACE_UNLOCK;
+
+    return RIG_OK;
+}
+
+/** @} */
@@ -0,0 +1,59 @@
+/*
+ *  Hamlib Interface - port trace record/replay header
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H 1
+
+#include <hamlib/rig.h>
+
+/*
+ * Trace file layout, all integers little endian:
+ *
+ *   header: "HLTRACE1" followed by a 32 bit rig model
+ *   record: 1 byte type, 32 bit microseconds since the previous record,
+ *           32 bit length, then length bytes of data
+ *
+ * For PORT_TRACE_ERROR records the length field holds the negated
+ * Hamlib error code and no data follows.
+ */
+#define PORT_TRACE_MAGIC "HLTRACE1"
+
+#define PORT_TRACE_WRITE 'W'
+#define PORT_TRACE_READ  'R'
+#define PORT_TRACE_ERROR 'E'
+
+__BEGIN_DECLS
+
+int port_trace_record_start(hamlib_port_t *p, const char *pathname,
+                            rig_model_t model, hamlib_trace_stats_t *stats);
+int port_trace_replay_start(hamlib_port_t *p, const char *pathname,
+                            int timing, hamlib_trace_stats_t *stats);
+void port_trace_stop(hamlib_port_t *p);
+
+void port_trace_record(hamlib_port_t *p, int type, const unsigned char *buf,
+                       int len);
+int port_trace_replay_write(hamlib_port_t *p, const unsigned char *buf,
+                            size_t count);
+int port_trace_replay_read(hamlib_port_t *p, unsigned char *buf,
+                           size_t max);
+
+__END_DECLS
+
+#endif /* _TRACE_H */
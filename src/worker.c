@@ -0,0 +1,181 @@
+/*
+ *  Hamlib Interface - background worker thread of a rig
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \file worker.c
+ * \brief Background worker thread of a rig
+ *
+ * The asynchronous sets and the station automation each hand their work
+ * to a thread of the rig.  The private data holding it is allocated on
+ * first use, the thread is started with the first piece of work and it
+ * is stopped, after finishing what is pending, by rig_close().
+ */
+
+/**
+ * \addtogroup rig_internal
+ * @{
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "worker.h"
+
+//! @cond Doxygen_Suppress
+#if defined(HAVE_PTHREAD)
+static pthread_mutex_t worker_create_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+/*
+ * Returns *privp, allocating size bytes the first time, which start with
+ * a struct rig_worker and are then passed to init, NULL if out of memory
+ */
+void *rig_worker_priv(void **privp, size_t size, void (*init)(void *priv))
+{
+    void *priv;
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&worker_create_mutex);
+#endif
+
+    priv = *privp;
+
+    if (!priv)
+    {
+        priv = calloc(1, size);
+
+        if (priv)
+        {
+#if defined(HAVE_PTHREAD)
+            struct rig_worker *w = priv;
+
+            pthread_mutex_init(&w->mutex, NULL);
+            pthread_cond_init(&w->work, NULL);
+            pthread_cond_init(&w->idle, NULL);
+#endif
+
+            if (init)
+            {
+                init(priv);
+            }
+
+            *privp = priv;
+        }
+    }
+
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_unlock(&worker_create_mutex);
+#endif
+
+    return priv;
+}
+
+
+/*
+ * Starts the thread unless it is running, called with w->mutex held
+ */
+int rig_worker_start(struct rig_worker *w, void *(*thread)(void *), void *arg)
+{
+#if defined(HAVE_PTHREAD)
+
+    if (w->running)
+    {
+        return RIG_OK;
+    }
+
+    w->stop = 0;
+
+    if (pthread_create(&w->thread_id, NULL, thread, arg))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                  strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    w->running = 1;
+
+    return RIG_OK;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
+
+
+/*
+ * True when called from the thread of w
+ */
+int rig_worker_is_self(const struct rig_worker *w)
+{
+#if defined(HAVE_PTHREAD)
+    return w->running && pthread_equal(pthread_self(), w->thread_id);
+#else
+    return 0;
+#endif
+}
+
+
+/*
+ * Asks the thread to finish what is pending and stop, and waits for it,
+ * a no-op when called from the thread itself
+ */
+void rig_worker_stop(struct rig_worker *w)
+{
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_lock(&w->mutex);
+
+    if (!w->running || pthread_equal(pthread_self(), w->thread_id))
+    {
+        pthread_mutex_unlock(&w->mutex);
+        return;
+    }
+
+    w->stop = 1;
+    pthread_cond_signal(&w->work);
+    pthread_mutex_unlock(&w->mutex);
+
+    pthread_join(w->thread_id, NULL);
+
+    pthread_mutex_lock(&w->mutex);
+    w->running = 0;
+    pthread_mutex_unlock(&w->mutex);
+#endif
+}
+
+
+/*
+ * Stops the thread and releases its mutex and conditions, the caller
+ * frees the private data
+ */
+void rig_worker_destroy(struct rig_worker *w)
+{
+    rig_worker_stop(w);
+#if defined(HAVE_PTHREAD)
+    pthread_cond_destroy(&w->idle);
+    pthread_cond_destroy(&w->work);
+    pthread_mutex_destroy(&w->mutex);
+#endif
+}
+//! @endcond
+
+/** @} */
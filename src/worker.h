@@ -0,0 +1,54 @@
+/*
+ *  Hamlib Interface - background worker thread of a rig header
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _WORKER_H
+#define _WORKER_H 1
+
+#include <stddef.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+
+/*
+ * A thread started on the first piece of work and stopped with the rig,
+ * the first member of the private data of async_set.c and automation.c
+ */
+struct rig_worker
+{
+#if defined(HAVE_PTHREAD)
+    pthread_mutex_t mutex;
+    pthread_cond_t work;        /* work is pending or the thread must stop */
+    pthread_cond_t idle;        /* the pending work is done */
+    pthread_t thread_id;
+#endif
+    int running;
+    int stop;
+};
+
+void *rig_worker_priv(void **privp, size_t size, void (*init)(void *priv));
+int rig_worker_start(struct rig_worker *w, void *(*thread)(void *), void *arg);
+int rig_worker_is_self(const struct rig_worker *w);
+void rig_worker_stop(struct rig_worker *w);
+void rig_worker_destroy(struct rig_worker *w);
+
+#endif
@@ -162,6 +162,8 @@ declare_proto_amp(set_level);
 declare_proto_amp(get_level);
 declare_proto_amp(set_powerstat);
 declare_proto_amp(get_powerstat);
+declare_proto_amp(get_level_cached);
+declare_proto_amp(get_powerstat_cached);
 //declare_proto_amp(dump_caps);
 
 /*
@@ -182,6 +184,8 @@ struct test_table test_list[] =
     { 'R', "reset",         ACTION(reset),          ARG_IN, "Reset" },
     { 0x87, "set_powerstat",    ACTION(set_powerstat),  ARG_IN, "Power Status" },
     { 0x88, "get_powerstat",    ACTION(get_powerstat),  ARG_OUT, "Power Status" },
+    { 0x89, "get_level_cached", ACTION(get_level_cached), ARG_IN1 | ARG_OUT2 | ARG_OUT3, "Level", "Level Value", "Age(ms)" },
+    { 0x8a, "get_powerstat_cached", ACTION(get_powerstat_cached), ARG_OUT, "Power Status", "Age(ms)" },
     { 0x00, "", NULL },
 };
 
@@ -1981,6 +1985,88 @@ declare_proto_amp(get_powerstat)
     return status;
 }
 
+/* '0x89' */
+declare_proto_amp(get_level_cached)
+{
+    int status;
+    setting_t level;
+    value_t val;
+    double age_ms;
+
+    level = amp_parse_level(arg1);
+
+    if (!amp_has_get_level(amp, level))
+    {
+        return -RIG_EINVAL;
+    }
+
+    status = amp_get_level_cached(amp, level, &val, &age_ms);
+
+    if (status != RIG_OK)
+    {
+        return status;
+    }
+
+    if (interactive && prompt)
+    {
+        fprintf(fout, "%s: ", cmd->arg2);
+    }
+
+    if (AMP_LEVEL_IS_FLOAT(level))
+    {
+        fprintf(fout, "%f\n", val.f);
+    }
+    else if (AMP_LEVEL_IS_STRING(level))
+    {
+        fprintf(fout, "%s\n", val.s);
+    }
+    else
+    {
+        fprintf(fout, "%d\n", val.i);
+    }
+
+    if (interactive && prompt)
+    {
+        fprintf(fout, "%s: ", cmd->arg3);
+    }
+
+    fprintf(fout, "%.0f\n", age_ms);
+
+    return status;
+}
+
+
+/* '0x8a' */
+declare_proto_amp(get_powerstat_cached)
+{
+    int status;
+    powerstat_t stat;
+    double age_ms;
+
+    status = amp_get_powerstat_cached(amp, &stat, &age_ms);
+
+    if (status != RIG_OK)
+    {
+        return status;
+    }
+
+    if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+    {
+        fprintf(fout, "%s: ", cmd->arg1);
+    }
+
+    fprintf(fout, "%d\n", stat);
+
+    if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+    {
+        fprintf(fout, "%s: ", cmd->arg2);
+    }
+
+    fprintf(fout, "%.0f\n", age_ms);
+
+    return status;
+}
+
 /*
  * Special debugging purpose send command display reply until there's a
  * timeout.
@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# Run rig_bench against the FT-990 and FT-1000D simulators, once with the
+# cache off and once with a cache timeout, and print the rig_bench summary
+# of each with the bytes read per poll loop added, e.g. from the build tree:
+#
+#   (cd simulators && make simft990 simft1000)
+#   (cd tests && make rig_bench)
+#   sh ../tests/ftstatus_bench.sh > ftstatus.json
+#
+# With the cache on, the gets of a loop share the status blocks the rig
+# sends, so the run fails if it reads more than 60% of the bytes it reads
+# with the cache off.
+#
+# Usage: ftstatus_bench.sh [loops [cache_ms]]
+
+LOOPS=${1:-10}
+CACHE=${2:-1000}
+SIMDIR=${SIMDIR:-../simulators}
+RIG_BENCH=${RIG_BENCH:-./rig_bench}
+
+status=0
+
+# simulator  model
+while read sim model
+do
+    if [ ! -x "$SIMDIR/$sim" ]
+    then
+        echo "$sim not built" >&2
+        status=1
+        continue
+    fi
+
+    uncached=0
+
+    for cache in 0 $CACHE
+    do
+        result=$($RIG_BENCH -s "$SIMDIR/$sim" -n $LOOPS -c $cache $model 2>/dev/null | tail -1)
+        bytes=$(echo "$result" | sed -n 's/.*"bytes_read":\([0-9]*\).*/\1/p')
+
+        if [ -z "$bytes" ]
+        then
+            echo "$sim: no result with cache $cache" >&2
+            status=1
+            break
+        fi
+
+        echo "$result" | sed "s/}\$/,\"cache_ms\":$cache,\"bytes_per_loop\":$((bytes / LOOPS))}/"
+
+        if [ $cache = 0 ]
+        then
+            uncached=$bytes
+        elif [ $((bytes * 10)) -gt $((uncached * 6)) ]
+        then
+            echo "$sim: read $bytes bytes with the cache, $uncached without" >&2
+            status=1
+        fi
+    done
+done <<EOF
+simft990  1016
+simft1000 1003
+EOF
+
+exit $status
@@ -0,0 +1,171 @@
+/*
+ * Hamlib mcast_bench program
+ *
+ * Opens a dummy rig that publishes its multicast snapshots and drives it
+ * like an operator for a while: the VFO is tuned 10 times a second, PTT
+ * flips every second and with -s an IC-7300 sized spectrum line comes 20
+ * times a second.  Prints the CPU time it took and the final state as one
+ * JSON object, to compare with what rigtestmcastrx put together.
+ *
+ *   mcast_bench [-p port] [-P cmd_port] [-d seconds] [-D] [-k keyframe_ms] [-s]
+ *
+ * -D turns on the multicast_delta mode.  mcast_bench.sh runs both modes
+ * with and without spectrum.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "event.h"
+
+#define TUNE_MS 100
+#define PTT_MS 1000
+#define SPECTRUM_MS 50
+#define SPECTRUM_LENGTH 475
+
+
+static int set_conf(RIG *rig, const char *name, const char *val)
+{
+    return rig_set_conf(rig, rig_token_lookup(rig, name), val);
+}
+
+
+static void fire_spectrum(RIG *rig, freq_t freq, int line_number)
+{
+    unsigned char data[SPECTRUM_LENGTH];
+    struct rig_spectrum_line line;
+    int i;
+
+    for (i = 0; i < SPECTRUM_LENGTH; i++)
+    {
+        data[i] = (unsigned char)((i * 7 + line_number * 13) % 160);
+    }
+
+    memset(&line, 0, sizeof(line));
+    line.data_level_max = 160;
+    line.signal_strength_min = -80;
+    line.spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line.center_freq = freq;
+    line.span_freq = 50000;
+    line.low_edge_freq = freq - 25000;
+    line.high_edge_freq = freq + 25000;
+    line.spectrum_data_length = SPECTRUM_LENGTH;
+    line.spectrum_data = data;
+
+    rig_fire_spectrum_event(rig, &line);
+}
+
+
+static void usage(void)
+{
+    printf("Usage: mcast_bench [-p port] [-P cmd_port] [-d seconds] [-D] "
+           "[-k keyframe_ms] [-s]\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *port = "45360";
+    const char *cmd_port = "45361";
+    const char *keyframe_ms = "1000";
+    int duration_s = 5;
+    int delta = 0;
+    int spectrum = 0;
+    struct timespec start, tuned, keyed, swept;
+    freq_t freq = 14074000;
+    ptt_t ptt = RIG_PTT_OFF;
+    int lines = 0;
+    RIG *rig;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:P:d:Dk:sh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': port = optarg; break;
+
+        case 'P': cmd_port = optarg; break;
+
+        case 'd': duration_s = atoi(optarg); break;
+
+        case 'D': delta = 1; break;
+
+        case 'k': keyframe_ms = optarg; break;
+
+        case 's': spectrum = 1; break;
+
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    rig = rig_init(RIG_MODEL_DUMMY);
+
+    if (!rig)
+    {
+        fprintf(stderr, "rig_init failed\n");
+        return 1;
+    }
+
+    if (set_conf(rig, "multicast_data_port", port) != RIG_OK
+            || set_conf(rig, "multicast_cmd_port", cmd_port) != RIG_OK
+            || set_conf(rig, "multicast_delta", delta ? "1" : "0") != RIG_OK
+            || set_conf(rig, "multicast_keyframe", keyframe_ms) != RIG_OK
+            || rig_open(rig) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open the dummy rig\n");
+        return 1;
+    }
+
+    rig_set_freq(rig, RIG_VFO_A, freq);
+    rig_set_mode(rig, RIG_VFO_A, RIG_MODE_USB, 3000);
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    tuned = keyed = swept = start;
+
+    while (elapsed_ms(&start, HAMLIB_ELAPSED_GET) < duration_s * 1000.0)
+    {
+        if (elapsed_ms(&tuned, HAMLIB_ELAPSED_GET) >= TUNE_MS)
+        {
+            elapsed_ms(&tuned, HAMLIB_ELAPSED_SET);
+            freq += 10;
+            rig_set_freq(rig, RIG_VFO_A, freq);
+        }
+
+        if (elapsed_ms(&keyed, HAMLIB_ELAPSED_GET) >= PTT_MS)
+        {
+            elapsed_ms(&keyed, HAMLIB_ELAPSED_SET);
+            ptt = ptt == RIG_PTT_OFF ? RIG_PTT_ON : RIG_PTT_OFF;
+            rig_set_ptt(rig, RIG_VFO_CURR, ptt);
+        }
+
+        if (spectrum && elapsed_ms(&swept, HAMLIB_ELAPSED_GET) >= SPECTRUM_MS)
+        {
+            elapsed_ms(&swept, HAMLIB_ELAPSED_SET);
+            fire_spectrum(rig, freq, lines++);
+        }
+
+        hl_usleep(5 * 1000);
+    }
+
+    /* let the last change, or the keyframe of a resync, reach the receiver */
+    hl_usleep(1000 * 1000);
+
+    printf("{\"delta\":%d,\"spectrum\":%d,\"seconds\":%d,\"spectrum_lines\":%d,"
+           "\"cpu_ms\":%.1f,\"freq\":%.0f,\"ptt\":%d}\n",
+           delta, spectrum, duration_s, lines, clock() * 1000.0 / CLOCKS_PER_SEC,
+           freq, ptt != RIG_PTT_OFF);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+
+    return 0;
+}
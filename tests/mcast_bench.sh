@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Run mcast_bench with full snapshots and with multicast_delta, with and
+# without spectrum lines, and rigtestmcastrx on the same group.  Prints
+# the JSON line of both for each run, the receiver's with "rx" in front,
+# and fails if the receiver did not end up with the state of the rig,
+# e.g. from the build tree:
+#
+#   (cd tests && make mcast_bench rigtestmcastrx)
+#   sh ../tests/mcast_bench.sh > mcastbench.json
+#
+# Usage: mcast_bench.sh [seconds [drop_every]]
+#
+# drop_every makes the receiver drop every nth packet to try the resync.
+# Exits 77, i.e. skipped, when no multicast packets get through at all.
+
+SECONDS_RUN=${1:-5}
+DROP=${2:-0}
+PORT=45360
+CMD_PORT=45361
+
+status=0
+
+for spectrum in "" -s
+do
+    for delta in "" -D
+    do
+        ./rigtestmcastrx -q -p $PORT -P $CMD_PORT -l $DROP \
+            -d $((SECONDS_RUN + 4)) > mcast_bench_rx.out &
+        rx=$!
+        sleep 1
+
+        tx=$(./mcast_bench -p $PORT -P $CMD_PORT -d $SECONDS_RUN $delta $spectrum) \
+            || status=1
+        wait $rx
+        rx=$(cat mcast_bench_rx.out)
+        rm -f mcast_bench_rx.out
+
+        echo "$tx"
+        echo "$rx" | sed 's/^{/{"rx":1,/'
+
+        case "$rx" in
+        *'"packets":0,'*)
+            echo "no multicast packets received, skipping" >&2
+            exit 77
+            ;;
+        esac
+
+        freq=$(echo "$tx" | sed 's/.*"freq":\([0-9]*\).*/\1/')
+        ptt=$(echo "$tx" | sed 's/.*"ptt":\([0-9]*\).*/\1/')
+
+        case "$rx" in
+        *"\"stale\":0,\"freq\":$freq,\"ptt\":$ptt}"*)
+            ;;
+        *)
+            echo "receiver state differs from the rig" >&2
+            status=1
+            ;;
+        esac
+    done
+done
+
+exit $status
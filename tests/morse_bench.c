@@ -0,0 +1,421 @@
+/*
+ * Hamlib morse_bench program
+ *
+ * Starts a simulator on a pty pair, as rig_bench -s does, sends CW
+ * messages through rig_send_morse and follows what the simulated keyer
+ * reports taking: how long after rig_send_morse the first text reached
+ * the rig, how long the keyer sat idle between the chunks of a message
+ * and how much text the rig refused because its buffer was full.  Last a
+ * long message is aborted with rig_stop_morse, which must leave nothing
+ * more for the rig.  Prints one JSON object per message and a summary.
+ *
+ *   morse_bench [-n rounds] [-w wpm] -s simulator model
+ *
+ *   morse_bench -s ../simulators/simic7300 3073
+ *   morse_bench -s ../simulators/simts590 2031
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <hamlib/rig.h>
+#include "misc.h"
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <pthread.h>
+#define HAVE_SIMULATOR_LAUNCH 1
+#endif
+
+#define MAX_EVENTS 4096
+
+/* what the simulated keyer reported, with the time the line came in */
+struct cw_event
+{
+    double ms;
+    int text;           /* characters taken, 0 for a stop */
+    int idle_ms;
+    int rejected;
+};
+
+static const char *const messages[] =
+{
+    "5NN 123",
+    "CQ TEST W1AW W1AW TEST",
+    "W1AW 5NN 0123 TU QRZ? CQ TEST DE W1AW W1AW K  QRL? QRL? QRL?",
+};
+
+#define MESSAGES (int)(sizeof(messages) / sizeof(messages[0]))
+
+#ifdef HAVE_SIMULATOR_LAUNCH
+static struct cw_event events[MAX_EVENTS];
+static int nevents;
+static pthread_mutex_t events_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct timespec bench_start;
+static int sim_fd = -1;
+
+
+static void *sim_reader(void *arg)
+{
+    char line[256];
+    int len = 0;
+    char c;
+
+    while (read(sim_fd, &c, 1) == 1)
+    {
+        struct cw_event e;
+
+        if (c != '\n' && c != '\r')
+        {
+            if (len < sizeof(line) - 1)
+            {
+                line[len++] = c;
+            }
+
+            continue;
+        }
+
+        line[len] = '\0';
+        len = 0;
+        memset(&e, 0, sizeof(e));
+
+        if (sscanf(line, "CW text=%d idle_ms=%d", &e.text, &e.idle_ms) == 2)
+        {
+        }
+        else if (strncmp(line, "CW rejected", 11) == 0)
+        {
+            e.rejected = 1;
+        }
+        else if (strncmp(line, "CW stop", 7) != 0)
+        {
+            continue;
+        }
+
+        e.ms = elapsed_ms(&bench_start, HAMLIB_ELAPSED_GET);
+        pthread_mutex_lock(&events_lock);
+
+        if (nevents < MAX_EVENTS)
+        {
+            events[nevents++] = e;
+        }
+
+        pthread_mutex_unlock(&events_lock);
+    }
+
+    return NULL;
+}
+
+
+/* the simulator's first line with "name=..." is the pty to use */
+static pid_t sim_start(const char *path, char *pts, size_t pts_len)
+{
+    char line[256];
+    int master;
+    int len = 0;
+    pid_t pid;
+    pthread_t thread;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+    {
+        perror("posix_openpt");
+        return -1;
+    }
+
+    pid = fork();
+
+    if (pid < 0)
+    {
+        perror("fork");
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        int slave = open(ptsname(master), O_RDWR);
+
+        if (slave < 0)
+        {
+            _exit(127);
+        }
+
+        setsid();
+        dup2(slave, 1);
+        dup2(slave, 2);
+        close(master);
+        execl(path, path, "", "", (char *)NULL);
+        _exit(127);
+    }
+
+    while (len < sizeof(line) - 1)
+    {
+        fd_set rfds;
+        struct timeval tv = { 5, 0 };
+        char c;
+
+        FD_ZERO(&rfds);
+        FD_SET(master, &rfds);
+
+        if (select(master + 1, &rfds, NULL, NULL, &tv) <= 0
+                || read(master, &c, 1) != 1)
+        {
+            fprintf(stderr, "%s did not report its pty\n", path);
+            kill(pid, SIGTERM);
+            waitpid(pid, NULL, 0);
+            return -1;
+        }
+
+        if (c == '\r')
+        {
+            continue;
+        }
+
+        if (c != '\n')
+        {
+            line[len++] = c;
+            continue;
+        }
+
+        line[len] = '\0';
+        len = 0;
+
+        if (strncmp(line, "name=", 5) == 0)
+        {
+            SNPRINTF(pts, pts_len, "%s", line + 5);
+            break;
+        }
+    }
+
+    sim_fd = master;
+    pthread_create(&thread, NULL, sim_reader, NULL);
+    pthread_detach(thread);
+
+    return pid;
+}
+
+
+static void sim_stop(pid_t pid)
+{
+    if (pid > 0)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+    }
+}
+
+
+static int keying_ms(const char *text, int wpm)
+{
+    int dot10ths = 0;
+
+    for (; *text; text++)
+    {
+        dot10ths += morse_code_char_to_dot10ths(*text);
+    }
+
+    return dot10ths_to_millis(dot10ths, wpm);
+}
+
+
+/* events from the first one after ms on */
+static int events_since(double ms)
+{
+    int i;
+
+    pthread_mutex_lock(&events_lock);
+
+    for (i = 0; i < nevents && events[i].ms < ms; i++)
+    {
+    }
+
+    pthread_mutex_unlock(&events_lock);
+
+    return i;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *simulator = NULL;
+    char port[HAMLIB_FILPATHLEN] = "";
+    int rounds = 2;
+    int wpm = 30;
+    int sent = 0, chunks = 0, gaps = 0, rejected = 0, after_stop = 0;
+    double latency_total = 0, latency_max = 0, gap_max = 0, stop_ms = -1;
+    rig_model_t model;
+    value_t keyspd;
+    pid_t sim_pid;
+    RIG *rig;
+    int opt;
+    int r, m, i;
+
+    while ((opt = getopt(argc, argv, "n:w:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': rounds = atoi(optarg); break;
+
+        case 'w': wpm = atoi(optarg); break;
+
+        case 's': simulator = optarg; break;
+
+        default:
+            printf("Usage: morse_bench [-n rounds] [-w wpm] -s simulator model\n");
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (!simulator || optind >= argc)
+    {
+        printf("Usage: morse_bench [-n rounds] [-w wpm] -s simulator model\n");
+        return 1;
+    }
+
+    model = atoi(argv[optind]);
+    elapsed_ms(&bench_start, HAMLIB_ELAPSED_SET);
+    sim_pid = sim_start(simulator, port, sizeof(port));
+
+    if (sim_pid < 0)
+    {
+        return 3;
+    }
+
+    rig_set_debug(getenv("MORSE_DEBUG") ? RIG_DEBUG_TRACE : RIG_DEBUG_NONE);
+    rig = rig_init(model);
+
+    if (!rig)
+    {
+        sim_stop(sim_pid);
+        return 1;
+    }
+
+    rig_set_conf(rig, rig_token_lookup(rig, "rig_pathname"), port);
+
+    if (rig_open(rig) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open model %u on %s\n", model, port);
+        sim_stop(sim_pid);
+        return 1;
+    }
+
+    rig_set_mode(rig, RIG_VFO_CURR, RIG_MODE_CW, RIG_PASSBAND_NOCHANGE);
+    keyspd.i = wpm;
+    rig_set_level(rig, RIG_VFO_CURR, RIG_LEVEL_KEYSPD, keyspd);
+
+    for (r = 0; r < rounds; r++)
+    {
+        for (m = 0; m < MESSAGES; m++)
+        {
+            double t0 = elapsed_ms(&bench_start, HAMLIB_ELAPSED_GET);
+            int msg_chunks = 0, msg_gaps = 0, msg_rejected = 0;
+            double latency = -1, msg_gap_max = 0;
+
+            if (rig_send_morse(rig, RIG_VFO_CURR, messages[m]) != RIG_OK)
+            {
+                fprintf(stderr, "rig_send_morse failed\n");
+                break;
+            }
+
+            /* the keyer is done with it and idle for a while */
+            hl_usleep((keying_ms(messages[m], wpm) + 1000) * 1000);
+
+            i = events_since(t0);
+            pthread_mutex_lock(&events_lock);
+
+            for (; i < nevents; i++)
+            {
+                if (events[i].rejected)
+                {
+                    msg_rejected++;
+                    continue;
+                }
+
+                if (latency < 0)
+                {
+                    latency = events[i].ms - t0;
+                }
+                else if (events[i].idle_ms > 0)
+                {
+                    msg_gaps++;
+                    msg_gap_max = events[i].idle_ms > msg_gap_max ? events[i].idle_ms :
+                                  msg_gap_max;
+                }
+
+                msg_chunks++;
+            }
+
+            pthread_mutex_unlock(&events_lock);
+
+            printf("{\"model\":%u,\"message\":%d,\"chars\":%d,\"latency_ms\":%.1f,"
+                   "\"chunks\":%d,\"gaps\":%d,\"gap_max_ms\":%.0f,\"rejected\":%d}\n",
+                   model, m, (int) strlen(messages[m]), latency, msg_chunks, msg_gaps,
+                   msg_gap_max, msg_rejected);
+
+            sent++;
+            latency_total += latency > 0 ? latency : 0;
+            latency_max = latency > latency_max ? latency : latency_max;
+            chunks += msg_chunks;
+            gaps += msg_gaps;
+            gap_max = msg_gap_max > gap_max ? msg_gap_max : gap_max;
+            rejected += msg_rejected;
+        }
+    }
+
+    /* abort two long messages half a second into the first */
+    rig_send_morse(rig, RIG_VFO_CURR, messages[MESSAGES - 1]);
+    rig_send_morse(rig, RIG_VFO_CURR, messages[MESSAGES - 1]);
+    hl_usleep(500 * 1000);
+
+    {
+        double t0 = elapsed_ms(&bench_start, HAMLIB_ELAPSED_GET);
+        int stopped = 0;
+
+        rig_stop_morse(rig, RIG_VFO_CURR);
+        hl_usleep(2000 * 1000);
+
+        i = events_since(t0);
+        pthread_mutex_lock(&events_lock);
+
+        for (; i < nevents; i++)
+        {
+            if (!stopped && events[i].text == 0 && !events[i].rejected)
+            {
+                stop_ms = events[i].ms - t0;
+                stopped = 1;
+            }
+            else if (stopped && events[i].text > 0)
+            {
+                after_stop++;
+            }
+        }
+
+        pthread_mutex_unlock(&events_lock);
+    }
+
+    printf("{\"model\":%u,\"wpm\":%d,\"messages\":%d,\"latency_mean_ms\":%.1f,"
+           "\"latency_max_ms\":%.1f,\"chunks\":%d,\"gaps\":%d,\"gap_max_ms\":%.0f,"
+           "\"rejected\":%d,\"stop_ms\":%.1f,\"sent_after_stop\":%d}\n",
+           model, wpm, sent, sent ? latency_total / sent : 0, latency_max, chunks,
+           gaps, gap_max, rejected, stop_ms, after_stop);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+    sim_stop(sim_pid);
+
+    return sent == 0 || chunks == 0 || stop_ms < 0 || after_stop > 0;
+}
+#else
+int main(int argc, char *argv[])
+{
+    fprintf(stderr, "simulators are not supported on this platform\n");
+    return 77;
+}
+#endif
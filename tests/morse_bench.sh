@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Run morse_bench against the simulators with a CW keyer and print its
+# JSON lines, e.g. from the build tree:
+#
+#   (cd simulators && make simic7300 simts590)
+#   sh ../tests/morse_bench.sh 2 > morse.json
+#
+# Usage: morse_bench.sh [rounds]
+#
+# SIMDIR and MORSE_BENCH may be set to point at the simulators and the
+# morse_bench program, they default to the build tree layout.  Exits 77
+# when none of the simulators is built.
+
+SIMDIR=${SIMDIR:-../simulators}
+MORSE_BENCH=${MORSE_BENCH:-./morse_bench}
+ROUNDS=${1:-2}
+
+status=77
+
+# simulator   model
+while read sim model
+do
+    if [ ! -x "$SIMDIR/$sim" ]
+    then
+        echo "skipping $sim, not built" >&2
+        continue
+    fi
+
+    [ $status -eq 77 ] && status=0
+    $MORSE_BENCH -n $ROUNDS -s "$SIMDIR/$sim" $model || status=1
+done <<EOT
+simic7300     3073
+simts590      2031
+EOT
+
+exit $status
@@ -0,0 +1,316 @@
+/*
+ * Hamlib ptt_bench program
+ *
+ * Keeps a rigctld busy with frequency reads from several clients, with
+ * the cache off so that every read goes to the rig, and meanwhile keys
+ * the rig up and down from one more client.  Prints one JSON object with
+ * how long "T 1" and "T 0" took to answer and how the reads fared.
+ *
+ *   ptt_bench [-T host] [-t port] [-c clients] [-n keyings] [-l max_ms]
+ *
+ * Against the dummy rig with a slow CAT link, e.g.
+ *
+ *   rigctld -m 1 -C cmd_latency=200 -P RIG -t 45360
+ *   ptt_bench -t 45360 -c 3 -n 10 -l 300
+ *
+ * a CAT PTT command should wait for no more than the read in progress,
+ * and PTT on a line of its own (-P DTR/RTS/CM108/GPIO, or NONE for VOX)
+ * not at all.  -l fails the run if keying up took longer than max_ms.
+ * ptt_bench.sh runs both.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+
+#include "misc.h"
+
+struct bench_poller
+{
+    pthread_t thread;
+    int sock;
+    unsigned long reads;
+    unsigned long errors;
+    double total_ms;
+    double max_ms;
+};
+
+/* keying up and keying down */
+struct ptt_times
+{
+    int n;
+    int errors;
+    double total_ms;
+    double max_ms;
+};
+
+static const char *host = "localhost";
+static int port = 4532;
+static volatile int polling = 1;
+
+
+static int bench_connect(void)
+{
+    struct addrinfo hints, *res, *ai;
+    char service[16];
+    int sock = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%d", port);
+
+    if (getaddrinfo(host, service, &hints, &res) != 0)
+    {
+        return -1;
+    }
+
+    for (ai = res; ai; ai = ai->ai_next)
+    {
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+        if (sock < 0)
+        {
+            continue;
+        }
+
+        if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+            break;
+        }
+
+        close(sock);
+        sock = -1;
+    }
+
+    freeaddrinfo(res);
+
+    return sock;
+}
+
+
+/* send one command, the reply is a single line */
+static int bench_command(FILE *fp, const char *cmd, char *line, int len)
+{
+    fprintf(fp, "%s\n", cmd);
+    fflush(fp);
+
+    return fgets(line, len, fp) ? 0 : -1;
+}
+
+
+static void *poll_thread(void *arg)
+{
+    struct bench_poller *c = arg;
+    struct timespec sent;
+    char line[128];
+    FILE *fp;
+
+    fp = fdopen(c->sock, "r+");
+
+    if (!fp)
+    {
+        c->errors++;
+        return NULL;
+    }
+
+    /* every read goes to the rig */
+    if (bench_command(fp, "\\set_cache 0", line, sizeof(line)) < 0
+            || strcmp(line, "RPRT 0\n") != 0)
+    {
+        c->errors++;
+        fclose(fp);
+        return NULL;
+    }
+
+    while (polling)
+    {
+        double ms;
+
+        elapsed_ms(&sent, HAMLIB_ELAPSED_SET);
+
+        if (bench_command(fp, "f", line, sizeof(line)) < 0)
+        {
+            c->errors++;
+            break;
+        }
+
+        ms = elapsed_ms(&sent, HAMLIB_ELAPSED_GET);
+
+        if (strncmp(line, "RPRT", 4) == 0)
+        {
+            c->errors++;
+        }
+
+        c->reads++;
+        c->total_ms += ms;
+
+        if (ms > c->max_ms)
+        {
+            c->max_ms = ms;
+        }
+    }
+
+    fclose(fp);
+
+    return NULL;
+}
+
+
+static void ptt_command(FILE *fp, const char *cmd, struct ptt_times *t)
+{
+    struct timespec sent;
+    char line[128];
+    double ms;
+
+    elapsed_ms(&sent, HAMLIB_ELAPSED_SET);
+
+    if (bench_command(fp, cmd, line, sizeof(line)) < 0)
+    {
+        t->errors++;
+        return;
+    }
+
+    ms = elapsed_ms(&sent, HAMLIB_ELAPSED_GET);
+
+    /* the time counts even if the PTT line could not be switched */
+    if (strcmp(line, "RPRT 0\n") != 0)
+    {
+        t->errors++;
+    }
+
+    t->n++;
+    t->total_ms += ms;
+
+    if (ms > t->max_ms)
+    {
+        t->max_ms = ms;
+    }
+}
+
+
+static void usage(void)
+{
+    printf("Usage: ptt_bench [-T host] [-t port] [-c clients] [-n keyings] "
+           "[-l max_ms]\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+    struct bench_poller *pollers;
+    struct ptt_times on, off;
+    unsigned long reads = 0, poll_errors = 0;
+    double poll_total_ms = 0, poll_max_ms = 0;
+    double limit_ms = 0;
+    int npollers = 3;
+    int keyings = 10;
+    FILE *fp;
+    int sock;
+    int opt;
+    int i;
+
+    while ((opt = getopt(argc, argv, "T:t:c:n:l:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'T': host = optarg; break;
+
+        case 't': port = atoi(optarg); break;
+
+        case 'c': npollers = atoi(optarg); break;
+
+        case 'n': keyings = atoi(optarg); break;
+
+        case 'l': limit_ms = atof(optarg); break;
+
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (npollers < 0 || keyings < 1)
+    {
+        usage();
+        return 1;
+    }
+
+    pollers = calloc(npollers + 1, sizeof(*pollers));
+    sock = bench_connect();
+
+    if (!pollers || sock < 0 || !(fp = fdopen(sock, "r+")))
+    {
+        fprintf(stderr, "cannot connect to %s:%d\n", host, port);
+        return 1;
+    }
+
+    for (i = 0; i < npollers; i++)
+    {
+        pollers[i].sock = bench_connect();
+
+        if (pollers[i].sock < 0)
+        {
+            fprintf(stderr, "cannot connect to %s:%d\n", host, port);
+            return 1;
+        }
+
+        pthread_create(&pollers[i].thread, NULL, poll_thread, &pollers[i]);
+    }
+
+    /* let the reads queue up behind each other first */
+    hl_usleep(500 * 1000);
+    memset(&on, 0, sizeof(on));
+    memset(&off, 0, sizeof(off));
+
+    for (i = 0; i < keyings; i++)
+    {
+        ptt_command(fp, "T 1", &on);
+        hl_usleep(100 * 1000);
+        ptt_command(fp, "T 0", &off);
+        hl_usleep(150 * 1000);
+    }
+
+    polling = 0;
+    fclose(fp);
+
+    for (i = 0; i < npollers; i++)
+    {
+        pthread_join(pollers[i].thread, NULL);
+        reads += pollers[i].reads;
+        poll_errors += pollers[i].errors;
+        poll_total_ms += pollers[i].total_ms;
+
+        if (pollers[i].max_ms > poll_max_ms)
+        {
+            poll_max_ms = pollers[i].max_ms;
+        }
+    }
+
+    free(pollers);
+
+    printf("{\"clients\":%d,\"keyings\":%d,\"ptt_on_mean_ms\":%.3f,"
+           "\"ptt_on_max_ms\":%.3f,\"ptt_off_mean_ms\":%.3f,"
+           "\"ptt_off_max_ms\":%.3f,\"ptt_errors\":%d,\"reads\":%lu,"
+           "\"read_mean_ms\":%.3f,\"read_max_ms\":%.3f,\"read_errors\":%lu}\n",
+           npollers, keyings, on.n ? on.total_ms / on.n : 0, on.max_ms,
+           off.n ? off.total_ms / off.n : 0, off.max_ms, on.errors + off.errors,
+           reads, reads ? poll_total_ms / reads : 0, poll_max_ms, poll_errors);
+
+    if (limit_ms > 0 && on.max_ms > limit_ms)
+    {
+        fprintf(stderr, "keying up took %.1f ms, more than %.1f ms\n",
+                on.max_ms, limit_ms);
+        return 1;
+    }
+
+    return on.n < keyings || poll_errors || (npollers && !reads) ? 1 : 0;
+}
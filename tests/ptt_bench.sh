@@ -0,0 +1,50 @@
+#!/bin/sh
+#
+# Run ptt_bench against a dummy rig with a 200 ms CAT link, once with PTT
+# by CAT command and once with PTT off the CAT link (NONE, as for VOX,
+# which takes the same path as a DTR/RTS, CM108 or GPIO line), and print
+# the ptt_bench JSON line of each with the PTT type added, e.g. from the
+# build tree:
+#
+#   (cd tests && make rigctld ptt_bench)
+#   sh ../tests/ptt_bench.sh > pttbench.json
+#
+# PTT_PORT=/dev/ttyUSB0 adds a run with RTS on that serial port.  A pty
+# cannot stand in for it, it has no modem control lines.
+#
+# Usage: ptt_bench.sh [keyings [clients]]
+
+KEYINGS=${1:-10}
+CLIENTS=${2:-3}
+LATENCY=200
+PORT=45360
+
+status=0
+
+# rigctld gives PTT the lock ahead of the waiting reads, so keying waits
+# for the command in progress at most, whatever the PTT type
+limit=$((LATENCY + 100))
+
+for ptt in RIG NONE ${PTT_PORT:+RTS}
+do
+
+    if [ $ptt = RTS ]
+    then
+        ./rigctld -m 1 -C cmd_latency=$LATENCY -P RTS -p "$PTT_PORT" -t $PORT &
+    else
+        ./rigctld -m 1 -C cmd_latency=$LATENCY -P $ptt -t $PORT &
+    fi
+
+    pid=$!
+    sleep 2
+
+    result=$(./ptt_bench -t $PORT -c $CLIENTS -n $KEYINGS -l $limit) || status=1
+
+    kill $pid
+    wait $pid 2>/dev/null
+
+    echo "$result" | sed "s/}\$/,\"ptt_type\":\"$ptt\",\"cmd_latency_ms\":$LATENCY}/"
+    PORT=$((PORT + 1))
+done
+
+exit $status
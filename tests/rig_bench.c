@@ -1,130 +1,688 @@
 /*
  * Hamlib rig_bench program
+ *
+ * Runs a standard workload against a rig or rotator and prints one JSON
+ * object per API call with latency percentiles, followed by a summary
+ * with wall time and port transaction counts.
+ *
+ *   rig_bench [-r port] [-s simulator] [-n loops] [-c cache_ms]
+ *             [-t trace_file] [-R] model
+ *   rig_bench -N handles model
+ *
+ * With -s the simulator program is started on a pty pair and the
+ * benchmark connects to the pty it reports, e.g.
+ *
+ *   rig_bench -s ../simulators/simic7300 3073
+ *
+ * Without a model the rig on /dev/ttyUSB0 is probed.
+ *
+ * With -N the given number of handles of the model are created with
+ * rig_init() and released with rig_cleanup() without opening them, and
+ * the time and the memory each handle takes are printed instead.  The
+ * memory is the growth of private resident memory, so pages a handle
+ * shares with the other handles of its model are not counted.
  */
 
+#include <hamlib/config.h>
+
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <hamlib/rig.h>
+#include <hamlib/rotator.h>
 #include <sys/time.h>
 #include "misc.h"
 
+#if !defined(WIN32) && !defined(_WIN32)
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <pthread.h>
+#define HAVE_SIMULATOR_LAUNCH 1
+#endif
+
 #define LOOP_COUNT 100
 
 #define SERIAL_PORT "/dev/ttyUSB0"
 
+#define MAX_CALLS 16
 
-int main(int argc, const char *argv[])
+struct bench_call
 {
-    RIG *my_rig;        /* handle to rig (nstance) */
-    int retcode;        /* generic return code from functions */
-    rig_model_t myrig_model;
-    unsigned i;
-    struct timeval tv1, tv2;
-    float elapsed;
+    const char *name;
+    int count;
+    int errors;
+    double total_ms;
+    double *samples;
+};
+
+static struct bench_call calls[MAX_CALLS];
+static int ncalls;
+static int loop_count = LOOP_COUNT;
 
-    rig_set_debug(RIG_DEBUG_ERR);
 
-    /*
-     * allocate memory, setup & open port
-     */
+static double now_ms(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
 
-    if (argc < 2)
+
+static struct bench_call *bench_call_get(const char *name)
+{
+    int i;
+
+    for (i = 0; i < ncalls; i++)
     {
-        hamlib_port_t myport;
-        /* may be overridden by backend probe */
-        myport.type.rig = RIG_PORT_SERIAL;
-        myport.parm.serial.rate = 19200;
-        myport.parm.serial.data_bits = 8;
-        myport.parm.serial.stop_bits = 1;
-        myport.parm.serial.parity = RIG_PARITY_NONE;
-        myport.parm.serial.handshake = RIG_HANDSHAKE_NONE;
-        strncpy(myport.pathname, SERIAL_PORT, HAMLIB_FILPATHLEN - 1);
+        if (strcmp(calls[i].name, name) == 0)
+        {
+            return &calls[i];
+        }
+    }
 
-        rig_load_all_backends();
-        myrig_model = rig_probe(&myport);
+    if (ncalls == MAX_CALLS)
+    {
+        fprintf(stderr, "too many benchmark calls\n");
+        exit(1);
     }
-    else
+
+    calls[ncalls].name = name;
+    calls[ncalls].samples = calloc(loop_count + 1, sizeof(double));
+
+    return &calls[ncalls++];
+}
+
+
+static void bench_call_add(const char *name, double start_ms, int retcode)
+{
+    struct bench_call *c = bench_call_get(name);
+    double ms = now_ms() - start_ms;
+
+    if (retcode != RIG_OK)
     {
-        myrig_model = atoi(argv[1]);
+        c->errors++;
     }
 
-    my_rig = rig_init(myrig_model);
+    if (c->count <= loop_count)
+    {
+        c->samples[c->count] = ms;
+    }
 
-    if (!my_rig)
+    c->count++;
+    c->total_ms += ms;
+}
+
+
+/*
+ * a call that has only ever failed is not worth repeating, simulators
+ * that don't implement a command would just time out on every loop
+ */
+static int bench_call_unsupported(const char *name)
+{
+    const struct bench_call *c = bench_call_get(name);
+
+    return c->count > 0 && c->errors == c->count;
+}
+
+
+/* time one API call; expr is evaluated exactly once */
+#define BENCH(name, expr) \
+    do { double t0_ = now_ms(); int r_ = (expr); bench_call_add(name, t0_, r_); } while (0)
+
+/* as BENCH, but skipped once the call is known not to work */
+#define BENCH_LOOP(name, expr) \
+    do { if (!bench_call_unsupported(name)) { BENCH(name, expr); } } while (0)
+
+
+static int cmp_double(const void *a, const void *b)
+{
+    double d = *(const double *)a - *(const double *)b;
+
+    return d < 0 ? -1 : d > 0;
+}
+
+
+static double percentile(const double *sorted, int n, int pct)
+{
+    return n > 0 ? sorted[(n - 1) * pct / 100] : 0;
+}
+
+
+static void bench_report(unsigned model)
+{
+    int i;
+
+    for (i = 0; i < ncalls; i++)
     {
-        fprintf(stderr, "Unknown rig num: %u\n", myrig_model);
-        fprintf(stderr, "Please check riglist.h\n");
-        exit(1);    /* whoops! something went wrong (mem alloc?) */
+        struct bench_call *c = &calls[i];
+        int n = c->count <= loop_count + 1 ? c->count : loop_count + 1;
+
+        qsort(c->samples, n, sizeof(double), cmp_double);
+
+        printf("{\"model\":%u,\"call\":\"%s\",\"count\":%d,\"errors\":%d,"
+               "\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f}\n",
+               model, c->name, c->count, c->errors,
+               c->count ? c->total_ms / c->count : 0,
+               percentile(c->samples, n, 50), percentile(c->samples, n, 99),
+               n ? c->samples[n - 1] : 0);
+    }
+}
+
+
+#ifdef HAVE_SIMULATOR_LAUNCH
+static int sim_fd = -1;
+
+static void *sim_drain(void *arg)
+{
+    char buf[256];
+
+    /* keep the simulator from blocking on its own debug output */
+    while (read(sim_fd, buf, sizeof(buf)) > 0)
+    {
+    }
+
+    return NULL;
+}
+
+/*
+ * Start a simulator with its output on a pty, so it is line buffered,
+ * and return the first pty device it reports with "name=..."
+ */
+static pid_t sim_start(const char *path, char *pts, size_t pts_len)
+{
+    char line[256];
+    int master;
+    int len = 0;
+    pid_t pid;
+    pthread_t thread;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+    {
+        perror("posix_openpt");
+        return -1;
+    }
+
+    pid = fork();
+
+    if (pid < 0)
+    {
+        perror("fork");
+        return -1;
     }
 
-    printf("Opened rig model %u, '%s'\n",
-           my_rig->caps->rig_model,
-           my_rig->caps->model_name);
+    if (pid == 0)
+    {
+        int slave = open(ptsname(master), O_RDWR);
 
-    printf("Backend version: %s, Status: %s\n",
-           my_rig->caps->version,
-           rig_strstatus(my_rig->caps->status));
+        if (slave < 0)
+        {
+            _exit(127);
+        }
+
+        setsid();
+        dup2(slave, 1);
+        dup2(slave, 2);
+        close(master);
+        execl(path, path, "", "", (char *)NULL);
+        _exit(127);
+    }
+
+    while (len < sizeof(line) - 1)
+    {
+        fd_set rfds;
+        struct timeval tv = { 5, 0 };
+        char c;
 
-    printf("Serial speed: %d baud\n", RIGPORT(my_rig)->parm.serial.rate);
-#if 0 // if we want to bench serial or network I/O use this time
-    rig_set_cache_timeout_ms(my_rig, HAMLIB_CACHE_ALL, 0);
+        FD_ZERO(&rfds);
+        FD_SET(master, &rfds);
+
+        if (select(master + 1, &rfds, NULL, NULL, &tv) <= 0
+                || read(master, &c, 1) != 1)
+        {
+            fprintf(stderr, "%s did not report its pty\n", path);
+            kill(pid, SIGTERM);
+            waitpid(pid, NULL, 0);
+            return -1;
+        }
+
+        if (c == '\r')
+        {
+            continue;
+        }
+
+        if (c != '\n')
+        {
+            line[len++] = c;
+            continue;
+        }
+
+        line[len] = '\0';
+        len = 0;
+
+        if (strncmp(line, "name=", 5) == 0)
+        {
+            SNPRINTF(pts, pts_len, "%s", line + 5);
+            break;
+        }
+    }
+
+    sim_fd = master;
+    pthread_create(&thread, NULL, sim_drain, NULL);
+    pthread_detach(thread);
+
+    return pid;
+}
+
+static void sim_stop(pid_t pid)
+{
+    if (pid > 0)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+    }
+}
 #endif
 
-    strncpy(RIGPORT(my_rig)->pathname, SERIAL_PORT, HAMLIB_FILPATHLEN - 1);
 
+static int bench_rig(rig_model_t model, const char *port, int cache_ms,
+                     const char *trace_file)
+{
+    RIG *my_rig;
+    hamlib_trace_stats_t stats;
+    double start_ms, open_ms, wall_ms;
+    freq_t freq = 0;
+    int retcode;
+    int i;
+
+    my_rig = rig_init(model);
+
+    if (!my_rig)
+    {
+        fprintf(stderr, "Unknown rig num: %u\n", model);
+        fprintf(stderr, "Please check riglist.h\n");
+        return 1;
+    }
+
+    rig_set_conf(my_rig, rig_token_lookup(my_rig, "rig_pathname"), port);
+    rig_set_conf(my_rig, rig_token_lookup(my_rig, "trace_record"), trace_file);
+    /* the background poll thread would add its own transactions */
+    rig_set_conf(my_rig, rig_token_lookup(my_rig, "poll_interval"), "0");
+
+    start_ms = now_ms();
     retcode = rig_open(my_rig);
+    open_ms = now_ms() - start_ms;
 
     if (retcode != RIG_OK)
     {
-        printf("rig_open: error = %s\n", rigerror(retcode));
-        exit(2);
+        fprintf(stderr, "rig_open: error = %s\n", rigerror(retcode));
+        rig_cleanup(my_rig);
+        return 2;
     }
 
-    printf("Port %s opened ok\n", SERIAL_PORT);
-    printf("Perform %d loops...\n", LOOP_COUNT);
+    rig_set_cache_timeout_ms(my_rig, HAMLIB_CACHE_ALL, cache_ms);
 
-    /*
-     * we're not using getrusage here because we want effective time
-     */
-    gettimeofday(&tv1, NULL);
-
-    for (i = 0; i < LOOP_COUNT; i++)
+    for (i = 0; i < loop_count; i++)
     {
-        freq_t freq;
         rmode_t rmode;
         pbwidth_t width;
+        ptt_t ptt;
+        value_t val;
+
+        BENCH_LOOP("get_freq", rig_get_freq(my_rig, RIG_VFO_CURR, &freq));
+        BENCH_LOOP("get_mode",
+                   rig_get_mode(my_rig, RIG_VFO_CURR, &rmode, &width));
+        BENCH_LOOP("get_ptt", rig_get_ptt(my_rig, RIG_VFO_CURR, &ptt));
 
-        retcode = rig_get_freq(my_rig, RIG_VFO_CURR, &freq);
+        if (rig_has_get_level(my_rig, RIG_LEVEL_STRENGTH))
+        {
+            BENCH_LOOP("get_level_strength",
+                       rig_get_level(my_rig, RIG_VFO_CURR, RIG_LEVEL_STRENGTH, &val));
+        }
 
-        if (retcode != RIG_OK)
+        if (rig_has_get_level(my_rig, RIG_LEVEL_RFPOWER))
         {
-            printf("rig_get_freq: error =  %s \n", rigerror(retcode));
-            exit(1);
+            BENCH_LOOP("get_level_rfpower",
+                       rig_get_level(my_rig, RIG_VFO_CURR, RIG_LEVEL_RFPOWER, &val));
         }
+    }
+
+    BENCH("set_split_vfo",
+          rig_set_split_vfo(my_rig, RIG_VFO_A, RIG_SPLIT_ON, RIG_VFO_B));
+    BENCH("set_split_freq",
+          rig_set_split_freq(my_rig, RIG_VFO_CURR, freq + 5000));
+    BENCH("get_split_freq", rig_get_split_freq(my_rig, RIG_VFO_CURR, &freq));
+    BENCH("set_split_vfo",
+          rig_set_split_vfo(my_rig, RIG_VFO_A, RIG_SPLIT_OFF, RIG_VFO_A));
+
+    if (my_rig->caps->get_channel)
+    {
+        channel_t chan;
+
+        memset(&chan, 0, sizeof(chan));
+        chan.vfo = RIG_VFO_MEM;
+        chan.channel_num = 1;
+        BENCH("get_channel", rig_get_channel(my_rig, RIG_VFO_MEM, &chan, 1));
+    }
 
-        retcode = rig_get_mode(my_rig, RIG_VFO_CURR, &rmode, &width);
+    BENCH("close", rig_close(my_rig));
+    wall_ms = now_ms() - start_ms;
 
-        if (retcode != RIG_OK)
+    rig_get_trace_stats(my_rig, &stats);
+
+    bench_report(model);
+
+    printf("{\"model\":%u,\"name\":\"%s %s\",\"loops\":%d,\"open_ms\":%.3f,"
+           "\"wall_ms\":%.3f,\"writes\":%lu,\"reads\":%lu,\"read_errors\":%lu,"
+           "\"bytes_written\":%lu,\"bytes_read\":%lu}\n",
+           model, my_rig->caps->mfg_name, my_rig->caps->model_name, loop_count,
+           open_ms, wall_ms, stats.writes, stats.reads, stats.read_errors,
+           stats.bytes_written, stats.bytes_read);
+
+    rig_cleanup(my_rig);
+
+    return 0;
+}
+
+
+/* private resident bytes of the process, -1 if unknown */
+static long private_bytes(void)
+{
+    long size, resident, shared;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (!fp)
+    {
+        return -1;
+    }
+
+    if (fscanf(fp, "%ld %ld %ld", &size, &resident, &shared) != 3)
+    {
+        resident = shared = -1;
+    }
+
+    fclose(fp);
+
+    return resident < 0 ? -1 : (resident - shared) * sysconf(_SC_PAGESIZE);
+}
+
+
+static int bench_handles(rig_model_t model, int nhandles)
+{
+    RIG **rigs;
+    double start_ms, init_ms, cleanup_ms;
+    long start_bytes, bytes;
+    int shared = 0;
+    int i;
+
+    rigs = calloc(nhandles, sizeof(*rigs));
+
+    if (!rigs)
+    {
+        return 1;
+    }
+
+    /* load the backend and whatever the first handle sets up once */
+    rigs[0] = rig_init(model);
+
+    if (!rigs[0])
+    {
+        fprintf(stderr, "Unknown rig num: %u\n", model);
+        free(rigs);
+        return 1;
+    }
+
+    rig_cleanup(rigs[0]);
+
+    start_bytes = private_bytes();
+    start_ms = now_ms();
+
+    for (i = 0; i < nhandles; i++)
+    {
+        rigs[i] = rig_init(model);
+
+        if (!rigs[i])
         {
-            printf("rig_get_mode: error =  %s \n", rigerror(retcode));
-            exit(1);
+            fprintf(stderr, "rig_init failed after %d handles\n", i);
+            return 2;
         }
     }
 
-    gettimeofday(&tv2, NULL);
+    init_ms = now_ms() - start_ms;
+    bytes = private_bytes();
 
-    elapsed = tv2.tv_sec - tv1.tv_sec + (tv2.tv_usec - tv1.tv_usec) / 1000000.0;
-    printf("Elapsed: %.3fs, Avg: %f loops/s, %f s/loop\n",
-           elapsed,
-           LOOP_COUNT / elapsed,
-           elapsed / LOOP_COUNT);
+    for (i = 0; i < nhandles; i++)
+    {
+        shared += rigs[i]->state.shared_handle;
+    }
+
+    start_ms = now_ms();
 
-    rig_close(my_rig);      /* close port */
-    rig_cleanup(my_rig);    /* if you care about memory */
+    for (i = 0; i < nhandles; i++)
+    {
+        rig_cleanup(rigs[i]);
+    }
 
-    printf("port %s closed ok \n", SERIAL_PORT);
+    cleanup_ms = now_ms() - start_ms;
+
+    printf("{\"model\":%u,\"handles\":%d,\"shared\":%d,\"sizeof_rig\":%u,"
+           "\"bytes_per_handle\":%ld,\"init_us\":%.2f,\"cleanup_us\":%.2f}\n",
+           model, nhandles, shared, (unsigned) sizeof(RIG),
+           bytes < 0 || start_bytes < 0 ? -1 : (bytes - start_bytes) / nhandles,
+           init_ms * 1000 / nhandles, cleanup_ms * 1000 / nhandles);
+
+    free(rigs);
 
     return 0;
 }
+
+
+static int bench_rot(rot_model_t model, const char *port)
+{
+    ROT *my_rot;
+    double start_ms, open_ms, wall_ms;
+    azimuth_t az = 0;
+    elevation_t el = 0;
+    int retcode;
+    int i;
+
+    my_rot = rot_init(model);
+
+    if (!my_rot)
+    {
+        fprintf(stderr, "Unknown rot num: %u\n", model);
+        return 1;
+    }
+
+    rot_set_conf(my_rot, rot_token_lookup(my_rot, "rot_pathname"), port);
+
+    start_ms = now_ms();
+    retcode = rot_open(my_rot);
+    open_ms = now_ms() - start_ms;
+
+    if (retcode != RIG_OK)
+    {
+        fprintf(stderr, "rot_open: error = %s\n", rigerror(retcode));
+        rot_cleanup(my_rot);
+        return 2;
+    }
+
+    for (i = 0; i < loop_count; i++)
+    {
+        BENCH_LOOP("get_position", rot_get_position(my_rot, &az, &el));
+    }
+
+    BENCH("set_position", rot_set_position(my_rot, az + 10, el));
+    BENCH("stop", rot_stop(my_rot));
+    BENCH("close", rot_close(my_rot));
+    wall_ms = now_ms() - start_ms;
+
+    bench_report(model);
+
+    printf("{\"model\":%u,\"name\":\"%s %s\",\"loops\":%d,\"open_ms\":%.3f,"
+           "\"wall_ms\":%.3f}\n",
+           model, my_rot->caps->mfg_name, my_rot->caps->model_name, loop_count,
+           open_ms, wall_ms);
+
+    rot_cleanup(my_rot);
+
+    return 0;
+}
+
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-r port] [-s simulator] [-n loops] [-c cache_ms] "
+            "[-t trace_file] [-R] [model]\n"
+            "       %s -N handles model\n"
+            "  -r  rig or rotator port, default " SERIAL_PORT "\n"
+            "  -s  start this simulator on a pty and use it as the port\n"
+            "  -n  number of poll loops, default %d\n"
+            "  -c  cache timeout in ms during the poll loop, default 0\n"
+            "  -t  record the session to this trace file\n"
+            "  -R  model is a rotator\n"
+            "  -N  time rig_init() and rig_cleanup() of this many handles\n",
+            name, name, LOOP_COUNT);
+}
+
+
+int main(int argc, char *argv[])
+{
+    char port[HAMLIB_FILPATHLEN] = SERIAL_PORT;
+    const char *simulator = NULL;
+    const char *trace_file = NULL;
+    unsigned model;
+    int cache_ms = 0;
+    int rotator = 0;
+    int nhandles = 0;
+    int retcode;
+    int c;
+#ifdef HAVE_SIMULATOR_LAUNCH
+    pid_t sim_pid = -1;
+#endif
+
+    while ((c = getopt(argc, argv, "r:s:n:c:t:RN:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'r':
+            SNPRINTF(port, sizeof(port), "%s", optarg);
+            break;
+
+        case 's':
+            simulator = optarg;
+            break;
+
+        case 'n':
+            loop_count = atoi(optarg);
+            break;
+
+        case 'c':
+            cache_ms = atoi(optarg);
+            break;
+
+        case 't':
+            trace_file = optarg;
+            break;
+
+        case 'R':
+            rotator = 1;
+            break;
+
+        case 'N':
+            nhandles = atoi(optarg);
+            break;
+
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    rig_set_debug(RIG_DEBUG_ERR);
+
+    if (loop_count < 1 || nhandles < 0 || (nhandles && optind >= argc))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (nhandles)
+    {
+        rig_set_debug(RIG_DEBUG_NONE);
+        rig_load_all_backends();
+
+        return bench_handles(atoi(argv[optind]), nhandles);
+    }
+
+    if (optind >= argc)
+    {
+        hamlib_port_t myport;
+
+        memset(&myport, 0, sizeof(myport));
+        /* may be overridden by backend probe */
+        myport.type.rig = RIG_PORT_SERIAL;
+        myport.parm.serial.rate = 19200;
+        myport.parm.serial.data_bits = 8;
+        myport.parm.serial.stop_bits = 1;
+        myport.parm.serial.parity = RIG_PARITY_NONE;
+        myport.parm.serial.handshake = RIG_HANDSHAKE_NONE;
+        SNPRINTF(myport.pathname, sizeof(myport.pathname), "%s", port);
+
+        rig_load_all_backends();
+        model = rig_probe(&myport);
+    }
+    else
+    {
+        model = atoi(argv[optind]);
+    }
+
+    if (!trace_file)
+    {
+        /* still counts the transactions */
+#if defined(WIN32) || defined(_WIN32)
+        trace_file = "NUL";
+#else
+        trace_file = "/dev/null";
+#endif
+    }
+
+    if (simulator)
+    {
+#ifdef HAVE_SIMULATOR_LAUNCH
+        sim_pid = sim_start(simulator, port, sizeof(port));
+
+        if (sim_pid < 0)
+        {
+            return 3;
+        }
+
+#else
+        fprintf(stderr, "simulators are not supported on this platform\n");
+        return 3;
+#endif
+    }
+
+    if (rotator)
+    {
+        retcode = bench_rot(model, port);
+    }
+    else
+    {
+        retcode = bench_rig(model, port, cache_ms, trace_file);
+    }
+
+#ifdef HAVE_SIMULATOR_LAUNCH
+    sim_stop(sim_pid);
+#endif
+
+    return retcode;
+}
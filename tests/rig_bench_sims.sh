@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Run rig_bench against each simulator and print JSON lines, one per
+# API call plus one summary per model, e.g. from the build tree:
+#
+#   (cd simulators && make simic7300 simts590 ...)
+#   sh ../tests/rig_bench_sims.sh > bench.json
+#
+# Usage: rig_bench_sims.sh [rig_bench options, e.g. -n 50 -c 500]
+#
+# SIMDIR and RIG_BENCH may be set to point at the simulators and the
+# rig_bench program, they default to the build tree layout.
+
+SIMDIR=${SIMDIR:-../simulators}
+RIG_BENCH=${RIG_BENCH:-./rig_bench}
+
+status=0
+
+# simulator   model  rig_bench flags
+while read sim model flags
+do
+    if [ ! -x "$SIMDIR/$sim" ]
+    then
+        echo "skipping $sim, not built" >&2
+        continue
+    fi
+
+    $RIG_BENCH $flags "$@" -s "$SIMDIR/$sim" $model || status=1
+done <<EOF
+simic7300     3073
+simts590      2031
+simts890      2041
+simelecraftk4 2047
+simftdx101    1040
+simft991      1035
+simft990      1016
+simft1000     1003
+simrotorez    401   -R
+EOF
+
+exit $status
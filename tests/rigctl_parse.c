@@ -100,9 +100,8 @@ extern int read_history();
 #define ARG_IN  (ARG_IN1|ARG_IN2|ARG_IN3|ARG_IN4)
 #define ARG_OUT (ARG_OUT1|ARG_OUT2|ARG_OUT3|ARG_OUT4|ARG_OUT5)
 
-static int chk_vfo_executed;
+/* set once any client asked for the dump_state protocol, see dump_state */
 char rigctld_password[65];
-int is_passwordOK;
 int is_rigctld;
 extern int lock_mode; // used by rigctld
 extern powerstat_t rig_powerstat;
@@ -131,6 +130,7 @@ struct test_table
     unsigned char cmd;
     const char *name;
     int (*rig_routine)(RIG *,
+                       struct rigctl_parse_ctx *,
                        FILE *,
                        FILE *,
                        int,
@@ -158,6 +158,7 @@ struct test_table
 
 #define ACTION(f) rigctl_##f
 #define declare_proto_rig(f) static int (ACTION(f))(RIG *rig,           \
+                                                    struct rigctl_parse_ctx *ctx, \
                                                     FILE *fout,         \
                                                     FILE *fin,          \
                                                     int interactive,    \
@@ -254,9 +255,11 @@ declare_proto_rig(get_twiddle);
 declare_proto_rig(set_uplink);
 declare_proto_rig(set_cache);
 declare_proto_rig(get_cache);
+declare_proto_rig(get_cache_policy);
 declare_proto_rig(halt);
 declare_proto_rig(pause);
 declare_proto_rig(password);
+declare_proto_rig(select_rig);
 //declare_proto_rig(set_password);
 declare_proto_rig(set_clock);
 declare_proto_rig(get_clock);
@@ -362,6 +365,7 @@ static struct test_table test_list[] =
     { 0x97, "uplink",           ACTION(set_uplink),     ARG_IN | ARG_NOVFO, "1=Sub, 2=Main" },
     { 0x95, "set_cache",        ACTION(set_cache),      ARG_IN | ARG_NOVFO, "Timeout (msecs)" },
     { 0x96, "get_cache",        ACTION(get_cache),      ARG_OUT | ARG_NOVFO, "Timeout (msecs)" },
+    { 0xae, "get_cache_policy", ACTION(get_cache_policy), ARG_OUT | ARG_NOVFO, "Adaptive", "Target load", "Max (msecs)", "Load" },
     { '2',  "power2mW",         ACTION(power2mW),       ARG_IN1 | ARG_IN2 | ARG_IN3 | ARG_OUT1 | ARG_NOVFO, "Power [0.0..1.0]", "Frequency", "Mode", "Power mW" },
     { '4',  "mW2power",         ACTION(mW2power),       ARG_IN1 | ARG_IN2 | ARG_IN3 | ARG_OUT1 | ARG_NOVFO, "Pwr mW", "Freq", "Mode", "Power [0.0..1.0]" },
     { '1',  "dump_caps",        ACTION(dump_caps),      ARG_NOVFO },
@@ -394,6 +398,7 @@ static struct test_table test_list[] =
     { 0xaa, "set_gpio",    ACTION(cm108_set_bit), ARG_NOVFO | ARG_IN, "GPIO#", "0/1" },
     { 0xac, "set_conf",    ACTION(set_conf), ARG_NOVFO | ARG_IN, "Token", "Token Value" },
     { 0xad, "get_conf",    ACTION(get_conf), ARG_NOVFO | ARG_IN1 | ARG_OUT2, "Token", "Value"},
+    { 0xaf, "select_rig",  ACTION(select_rig), ARG_NOVFO | ARG_IN, "Rig" },   /* rigctld only--serve another rig */
     { 0x00, "", NULL },
 };
 
@@ -685,10 +690,71 @@ static int next_word(char *buffer, int argc, char *argv[], int newline)
     })
 
 
+void rigctl_parse_ctx_init(struct rigctl_parse_ctx *ctx,
+                           rigctl_lock_cb_t lock_cb, void *lock_arg)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->lock_cb = lock_cb;
+    ctx->lock_arg = lock_arg;
+    ctx->last_was_ret = 1;
+    ctx->select_rig = -1;
+}
+
+
+/* the power status of the rig of the session */
+static powerstat_t *rigctl_powerstat(const struct rigctl_parse_ctx *ctx)
+{
+    return ctx->status ? &ctx->status->powerstat : &rig_powerstat;
+}
+
+
+/* the rigctld lock mode of the rig of the session */
+static int *rigctl_lock_mode(const struct rigctl_parse_ctx *ctx)
+{
+    return ctx->status ? &ctx->status->lock_mode : &lock_mode;
+}
+
+
+static void rigctl_parse_lock(const struct rigctl_parse_ctx *ctx, int lock)
+{
+    if (ctx->lock_cb)
+    {
+        ctx->lock_cb(ctx->lock_arg, lock);
+    }
+    else if (ctx->sync_cb)
+    {
+        ctx->sync_cb(lock);
+    }
+}
+
+
+/*
+ * Sessions without a context of their own, rigctl and older callers,
+ * share this one.
+ */
 int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
                  sync_cb_t sync_cb,
                  int interactive, int prompt, int *vfo_opt, char send_cmd_term,
                  int *ext_resp_ptr, char *resp_sep_ptr, int use_password)
+{
+    static struct rigctl_parse_ctx shared_ctx =
+    {
+        .last_was_ret = 1,
+        .select_rig = -1,
+    };
+
+    shared_ctx.sync_cb = sync_cb;
+
+    return rigctl_parse_r(&shared_ctx, my_rig, fin, fout, argv, argc,
+                          interactive, prompt, vfo_opt, send_cmd_term,
+                          ext_resp_ptr, resp_sep_ptr, use_password);
+}
+
+
+int rigctl_parse_r(struct rigctl_parse_ctx *ctx, RIG *my_rig, FILE *fin,
+                   FILE *fout, char *argv[], int argc, int interactive,
+                   int prompt, int *vfo_opt, char send_cmd_term,
+                   int *ext_resp_ptr, char *resp_sep_ptr, int use_password)
 {
     int retcode = -RIG_EINTERNAL;        /* generic return code from functions */
     unsigned char cmd;
@@ -710,9 +776,6 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
 
         if (interactive)
         {
-            static int last_was_ret = 1;
-            static int last_cmd;
-
             if (prompt)
             {
                 fprintf_flush(fout, "\nRig command: ");
@@ -722,7 +785,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
             {
                 if ((retcode = scanfc(fin, "%c", &cmd)) < 1)
                 {
-                    if (last_cmd == 0)
+                    if (ctx->last_cmd == 0)
                     {
                         rig_debug(RIG_DEBUG_WARN,
                                   "%s: nothing to scan#1? retcode=%d, last_cmd=[empty]\n",
@@ -733,7 +796,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
                     {
                         rig_debug(RIG_DEBUG_WARN, "%s: nothing to scan#1? retcode=%d, last_cmd=%c\n",
                                   __func__,
-                                  retcode, last_cmd);
+                                  retcode, ctx->last_cmd);
                     }
 
                     return (RIGCTL_PARSE_ERROR);
@@ -822,7 +885,7 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
 
                 if (cmd == 0x0a || cmd == 0x0d)
                 {
-                    if (last_was_ret)
+                    if (ctx->last_was_ret)
                     {
                         if (prompt)
                         {
@@ -833,12 +896,13 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
                         return (RIG_OK);
                     }
 
-                    last_was_ret = 1;
+                    ctx->last_was_ret = 1;
                 }
             }
             while (cmd == 0x0a || cmd == 0x0d);
 
-            last_was_ret = 0;
+            ctx->last_was_ret = 0;
+            ctx->last_cmd = cmd;
 
             /* comment line */
             if (cmd == '#')
@@ -1709,7 +1773,12 @@ readline_repeat:
 
 #endif // HAVE_LIBREADLINE
 
-    if (sync_cb) { sync_cb(1); }    /* lock if necessary */
+    /*
+     * PTT must not wait behind the reads of other sessions, so it takes
+     * the lock ahead of them; it still takes it, whatever the PTT type,
+     * as rig_set_ptt() shares the rig state with the other commands.
+     */
+    rigctl_parse_lock(ctx, cmd == 'T' ? RIGCTL_LOCK_PTT : RIGCTL_LOCK);
 
     if (!prompt)
     {
@@ -1784,7 +1853,7 @@ readline_repeat:
         else if (strcmp(cmd_entry->arg1, "Password") == 0) { preCmd = 1; }
     }
 
-    if (use_password && !is_passwordOK && (cmd_entry->arg1 != NULL) && !preCmd)
+    if (use_password && !ctx->password_ok && (cmd_entry->arg1 != NULL) && !preCmd)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: password has not been provided\n", __func__);
         fflush(fin);
@@ -1794,8 +1863,9 @@ readline_repeat:
     else
     {
         // Allow only certain commands when the rig is powered off
-        if (my_rig->state.powerstat == RIG_POWER_OFF && (rig_powerstat == RIG_POWER_OFF
-                || rig_powerstat == RIG_POWER_STANDBY)
+        if (my_rig->state.powerstat == RIG_POWER_OFF
+                && (*rigctl_powerstat(ctx) == RIG_POWER_OFF
+                    || *rigctl_powerstat(ctx) == RIG_POWER_STANDBY)
                 && cmd_entry->cmd != '1' // dump_caps
                 && cmd_entry->cmd != '3' // dump_conf
                 && cmd_entry->cmd != 0x8f // dump_state
@@ -1804,6 +1874,7 @@ readline_repeat:
                 && cmd_entry->cmd != 0x88 // get_powerstat
                 && cmd_entry->cmd != 0xa5 // client_version
                 && cmd_entry->cmd != 0xf2 // set_vfo_opt
+                && cmd_entry->cmd != 0xaf // select_rig
                 && my_rig->caps->rig_model !=
                 RIG_MODEL_POWERSDR) // some rigs can do stuff when powered off
         {
@@ -1815,6 +1886,7 @@ readline_repeat:
         else
         {
             retcode = (*cmd_entry->rig_routine)(my_rig,
+                                                ctx,
                                                 fout,
                                                 fin,
                                                 interactive,
@@ -1840,7 +1912,7 @@ readline_repeat:
     {
         rig_debug(RIG_DEBUG_ERR, "%s: RIG_EIO?\n", __func__);
 
-        if (sync_cb) { sync_cb(0); }    /* unlock if necessary */
+        rigctl_parse_lock(ctx, RIGCTL_UNLOCK);    /* unlock if necessary */
 
         return (retcode);
     }
@@ -1898,7 +1970,7 @@ readline_repeat:
 
 #endif
 
-    if (sync_cb) { sync_cb(0); }    /* unlock if necessary */
+    rigctl_parse_lock(ctx, RIGCTL_UNLOCK);    /* unlock if necessary */
 
     return (retcode);
 }
@@ -2259,7 +2331,7 @@ declare_proto_rig(set_mode)
 
     ENTERFUNC2;
 
-    if (rig->state.lock_mode || lock_mode) { RETURNFUNC2(RIG_OK); }
+    if (rig->state.lock_mode || *rigctl_lock_mode(ctx)) { RETURNFUNC2(RIG_OK); }
 
     if (!strcmp(arg1, "?"))
     {
@@ -2456,7 +2528,7 @@ declare_proto_rig(get_vfo_info)
 /* '\get_vfo_list' */
 declare_proto_rig(get_vfo_list)
 {
-    static char prntbuf[256];
+    char prntbuf[256];
 
     ENTERFUNC2;
 
@@ -2491,7 +2563,7 @@ declare_proto_rig(test)
 /* '\get_modes' */
 declare_proto_rig(get_modes)
 {
-    static char prntbuf[1024];
+    char prntbuf[1024];
     int i;
     char freqbuf[32];
 
@@ -4679,9 +4751,9 @@ declare_proto_rig(dump_state)
     // protocol 1 fields can be multi-line -- just write the thing to allow for it
     // backward compatible as new values will just generate warnings
     rig_debug(RIG_DEBUG_ERR, "%s: chk_vfo_executed=%d\n", __func__,
-              chk_vfo_executed);
+              ctx->chk_vfo_executed);
 
-    if (chk_vfo_executed) // for 3.3 compatiblility
+    if (ctx->chk_vfo_executed) // for 3.3 compatiblility
     {
         fprintf(fout, "vfo_ops=0x%x\n", rig->caps->vfo_ops);
         fprintf(fout, "ptt_type=0x%x\n",
@@ -4980,7 +5052,7 @@ declare_proto_rig(set_powerstat)
 
     if (retval == RIG_OK)
     {
-        rig_powerstat = stat; // update our global so others can see powerstat
+        *rigctl_powerstat(ctx) = stat; // so the other sessions of the rig see it
     }
 
     fflush(fin);
@@ -5009,7 +5081,7 @@ declare_proto_rig(get_powerstat)
     }
 
     fprintf(fout, "%d%c", stat, resp_sep);
-    rig_powerstat = stat; // update our global so others can see powerstat
+    *rigctl_powerstat(ctx) = stat; // so the other sessions of the rig see it
 
     RETURNFUNC2(status);
 }
@@ -5388,7 +5460,7 @@ declare_proto_rig(chk_vfo)
 
     fprintf(fout, "%d\n", rig->state.vfo_opt);
 
-    chk_vfo_executed = 1; // this allows us to control dump_state version
+    ctx->chk_vfo_executed = 1; // this allows us to control dump_state version
 
     RETURNFUNC2(RIG_OK);
 }
@@ -5425,19 +5497,42 @@ declare_proto_rig(pause)
     return (RIG_OK);
 }
 
+/* '0xaf'--serve another rig of a multi-rig rigctld on this connection */
+declare_proto_rig(select_rig)
+{
+    int n;
+
+    ENTERFUNC2;
+
+    CHKSCN1ARG(sscanf(arg1, "%d", &n));
+
+    if (ctx->rigs == 0)
+    {
+        RETURNFUNC2(-RIG_ENAVAIL);
+    }
+
+    if (n < 0 || n >= ctx->rigs)
+    {
+        RETURNFUNC2(-RIG_EINVAL);
+    }
+
+    /* the caller switches once the command is done and the rig unlocked */
+    ctx->select_rig = n;
+
+    RETURNFUNC2(RIG_OK);
+}
+
 int rigctld_password_check(RIG *rig, const char *md5)
 {
     int retval = -RIG_EINVAL;
     //fprintf(fout, "password %s\n", password);
     rig_debug(RIG_DEBUG_TRACE, "%s: %s == %s\n", __func__, md5, rigctld_password);
-    is_passwordOK = 0;
 
     char *mymd5 = rig_make_md5(rigctld_password);
 
     if (strcmp(md5, mymd5) == 0)
     {
         retval = RIG_OK;
-        is_passwordOK = 1;
     }
 
     return (retval);
@@ -5454,6 +5549,7 @@ declare_proto_rig(password)
     if (is_rigctld)
     {
         retval = rigctld_password_check(rig, key);
+        ctx->password_ok = retval == RIG_OK;
     }
     else
     {
@@ -5569,6 +5665,73 @@ declare_proto_rig(get_cache)
     RETURNFUNC2(RIG_OK);
 }
 
+
+/* '0xae' */
+declare_proto_rig(get_cache_policy)
+{
+    static const char *classes[] =
+    {
+        "All", "VFO", "Freq", "Mode", "PTT", "Split", "Width"
+    };
+    hamlib_cache_policy_t policy;
+    int print_labels = (interactive && prompt) || (interactive && !prompt
+                       && ext_resp);
+    int i;
+
+    ENTERFUNC2;
+
+    rig_get_cache_policy(rig, &policy);
+
+    if (print_labels)
+    {
+        fprintf(fout, "%s: ", cmd->arg1);
+    }
+
+    fprintf(fout, "%d%c", policy.adaptive, resp_sep);
+
+    if (print_labels)
+    {
+        fprintf(fout, "%s: ", cmd->arg2);
+    }
+
+    fprintf(fout, "%d%c", policy.target_load, resp_sep);
+
+    if (print_labels)
+    {
+        fprintf(fout, "%s: ", cmd->arg3);
+    }
+
+    fprintf(fout, "%d%c", policy.max_ms, resp_sep);
+
+    if (print_labels)
+    {
+        fprintf(fout, "%s: ", cmd->arg4);
+    }
+
+    fprintf(fout, "%.0f%c", policy.load, resp_sep);
+
+    if (print_labels)
+    {
+        fprintf(fout, "Backoff: ");
+    }
+
+    fprintf(fout, "%.2f%c", policy.backoff, resp_sep);
+
+    /* one line per cache class: timeout and measured read time */
+    for (i = HAMLIB_CACHE_ALL; i <= HAMLIB_CACHE_WIDTH; i++)
+    {
+        if (print_labels)
+        {
+            fprintf(fout, "%s (msecs): ", classes[i]);
+        }
+
+        fprintf(fout, "%d %.1f%c", policy.timeout_ms[i], policy.latency_ms[i],
+                resp_sep);
+    }
+
+    RETURNFUNC2(RIG_OK);
+}
+
 /* '0xf8' */
 declare_proto_rig(set_clock)
 {
@@ -5692,7 +5855,7 @@ declare_proto_rig(set_lock_mode)
     if (is_rigctld)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: rigctld lock\n", __func__);
-        lock_mode = lock;
+        *rigctl_lock_mode(ctx) = lock;
         retval = RIG_OK;
     }
     else
@@ -5720,7 +5883,7 @@ declare_proto_rig(get_lock_mode)
     if (is_rigctld)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: rigctld lock\n", __func__);
-        lock = lock_mode;
+        lock = *rigctl_lock_mode(ctx);
         retval = RIG_OK;
     }
     else
@@ -52,6 +52,49 @@ int print_conf_list2(const struct confparams *cfp, rig_ptr_t data);
 int set_conf(RIG *my_rig, char *conf_parms);
 
 typedef void (*sync_cb_t)(int);
+typedef void (*rigctl_lock_cb_t)(void *arg, int lock);
+
+/* lock argument of rigctl_lock_cb_t */
+#define RIGCTL_UNLOCK   0
+#define RIGCTL_LOCK     1
+#define RIGCTL_LOCK_PTT 2   /* lock ahead of the commands already waiting */
+
+/*
+ * State the commands keep per rig, shared by the sessions of the rig.
+ */
+struct rigctl_rig_status
+{
+    powerstat_t powerstat;      /* last power status read or set */
+    int lock_mode;              /* set_lock_mode of rigctld, mode sets ignored */
+};
+
+/*
+ * State of one command session, e.g. one rigctld connection.  Sessions
+ * with their own context can be parsed at the same time from different
+ * threads; lock_cb serializes the commands of the sessions sharing a
+ * rig.  The readline and command line (argv) input of rigctl remain
+ * single session.
+ */
+struct rigctl_parse_ctx
+{
+    sync_cb_t sync_cb;          /* process wide lock, if no lock_cb */
+    rigctl_lock_cb_t lock_cb;   /* lock of the rig of the session */
+    void *lock_arg;
+    int last_was_ret;
+    int last_cmd;
+    int password_ok;
+    int rigs;                   /* rigs \select_rig can choose from, 0 if none */
+    int select_rig;             /* rig chosen by \select_rig, -1 if none */
+    struct rigctl_rig_status *status;   /* of the rig, NULL for the process wide one */
+    int chk_vfo_executed;       /* chk_vfo seen, dump_state adds protocol 1 fields */
+};
+
+void rigctl_parse_ctx_init(struct rigctl_parse_ctx *ctx,
+                           rigctl_lock_cb_t lock_cb, void *lock_arg);
+int rigctl_parse_r(struct rigctl_parse_ctx *ctx, RIG *my_rig, FILE *fin,
+                   FILE *fout, char *argv[], int argc, int interactive,
+                   int prompt, int *vfo_mode, char send_cmd_term,
+                   int *ext_resp_ptr, char *resp_sep_ptr, int use_password);
 int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc, sync_cb_t sync_cb,
                  int interactive, int prompt, int * vfo_mode, char send_cmd_term,
                  int * ext_resp_ptr, char * resp_sep_ptr, int use_password);
@@ -80,7 +80,7 @@
  *      keep up to date SHORT_OPTIONS, usage()'s output and man page. thanks.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "m:r:p:d:P:D:s:S:c:T:t:C:W:w:x:z:lLuovhVZMRA:n:"
+#define SHORT_OPTIONS "m:r:p:d:P:D:s:S:c:T:t:C:W:w:x:z:lLuovhVZMRA:n:BN:"
 static struct option long_options[] =
 {
     {"model",           1, 0, 'm'},
@@ -109,18 +109,70 @@ static struct option long_options[] =
     {"password",        1, 0, 'A'},
     {"rigctld-idle",    0, 0, 'R'},
     {"bind-all",        0, 0, 'b'},
+    {"batch",           0, 0, 'B'},
+    {"add-rig",         1, 0, 'N'},
     {0, 0, 0, 0}
 };
 
 
-struct handle_data
+#if defined(HAVE_FMEMOPEN) && defined(HAVE_OPEN_MEMSTREAM)
+#define RIGCTLD_BATCH 1
+
+#define MAXBATCHLEN 4096
+
+/* line that ends a batch, answered by "#batch <commands>" */
+#define BATCH_DELIMITER "#batch"
+
+/* pipelined command input and statistics for one client */
+struct rigctld_batch
+{
+    char buf[MAXBATCHLEN + 1];
+    size_t len;
+    unsigned long batches;
+    unsigned long commands;
+    unsigned long recvs;
+    unsigned long sends;
+    double busy_ms;
+};
+#endif
+
+/* highest number of rigs one rigctld serves, see --add-rig */
+#define MAXRIGS 16
+
+/*
+ * A radio served by rigctld.  Rig i listens on the base port + i, and
+ * only the connections of a rig wait for its lock, so a slow radio does
+ * not hold up the others.  A PTT command waiting for the lock gets it
+ * before the other commands waiting.
+ */
+struct rigctld_rig
 {
     RIG *rig;
+    volatile int opened;
+    unsigned client_count;
+    int sock_listen;
+    char port[NI_MAXSERV];
+    struct rigctl_rig_status status;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t lock;
+    pthread_cond_t unlocked;
+    int locked;
+    int ptt_waiting;
+#endif
+};
+
+struct handle_data
+{
+    struct rigctld_rig *r;
+    struct rigctl_parse_ctx ctx;
     int sock;
     struct sockaddr_storage cli_addr;
     socklen_t clilen;
     int vfo_mode;
     int use_password;
+#ifdef RIGCTLD_BATCH
+    struct rigctld_batch *batch;
+#endif
 };
 
 
@@ -128,12 +180,9 @@ void *handle_socket(void *arg);
 void usage(void);
 
 
-#ifdef HAVE_PTHREAD
-static unsigned client_count;
-#endif
-
 static RIG *my_rig;             /* handle to rig (instance) */
-static volatile int rig_opened = 0;
+static struct rigctld_rig rigs[MAXRIGS];
+static int nrigs = 1;
 static int verbose;
 
 #ifdef HAVE_SIG_ATOMIC_T
@@ -146,32 +195,54 @@ const char *portno = "4532";
 const char *src_addr = NULL; /* INADDR_ANY */
 extern char rigctld_password[65];
 char resp_sep = '\n';
-extern int lock_mode;
-extern powerstat_t rig_powerstat;
 static int rigctld_idle =
     0; // if true then rig will close when no clients are connected
 static int skip_open = 0;
 static int bind_all = 0;
+static int batch_mode = 0;
 
 #define MAXCONFLEN 2048
 
 
-void mutex_rigctld(int lock)
+static void rigctld_lock(void *arg, int lock)
 {
 #ifdef HAVE_PTHREAD
-    static pthread_mutex_t client_lock = PTHREAD_MUTEX_INITIALIZER;
+    struct rigctld_rig *r = arg;
+
+    pthread_mutex_lock(&r->lock);
 
-    if (lock)
+    if (lock == RIGCTL_LOCK_PTT)
     {
-        pthread_mutex_lock(&client_lock);
+        r->ptt_waiting++;
+
+        while (r->locked)
+        {
+            pthread_cond_wait(&r->unlocked, &r->lock);
+        }
+
+        r->ptt_waiting--;
+        r->locked = 1;
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: client lock engaged for PTT\n", __func__);
+    }
+    else if (lock)
+    {
+        while (r->locked || r->ptt_waiting)
+        {
+            pthread_cond_wait(&r->unlocked, &r->lock);
+        }
+
+        r->locked = 1;
         rig_debug(RIG_DEBUG_VERBOSE, "%s: client lock engaged\n", __func__);
     }
     else
     {
         rig_debug(RIG_DEBUG_VERBOSE, "%s: client lock disengaged\n", __func__);
-        pthread_mutex_unlock(&client_lock);
+        r->locked = 0;
+        pthread_cond_broadcast(&r->unlocked);
     }
 
+    pthread_mutex_unlock(&r->lock);
+
 #endif
 }
 
@@ -243,6 +314,344 @@ static void handle_error(enum rig_debug_level_e lvl, const char *msg)
 #endif
 }
 
+static int rigctld_set_conf(RIG *rig, char *conf_parms)
+{
+    char *token = strtok(conf_parms, ",");
+
+    while (token)
+    {
+        char mytoken[100], myvalue[100];
+        hamlib_token_t lookup;
+        int retcode;
+
+        sscanf(token, "%99[^=]=%99s", mytoken, myvalue);
+        //printf("mytoken=%s,myvalue=%s\n",mytoken, myvalue);
+        lookup = rig_token_lookup(rig, mytoken);
+
+        if (lookup == 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: no such token as '%s'\n", __func__, mytoken);
+            token = strtok(NULL, ",");
+            continue;
+        }
+
+        retcode = rig_set_conf(rig, lookup, myvalue);
+
+        if (retcode != RIG_OK)
+        {
+            return retcode;
+        }
+
+        token = strtok(NULL, ",");
+    }
+
+    return RIG_OK;
+}
+
+/*
+ * Set up a rig of --add-rig from "ID[,PARM=VAL...]", exits on failure
+ */
+static void rigctld_add_rig(struct rigctld_rig *r, char *conf)
+{
+    char *conf_parms = strchr(conf, ',');
+    rig_model_t model = atoi(conf);
+    int retcode;
+
+    r->rig = rig_init(model);
+
+    if (!r->rig)
+    {
+        fprintf(stderr, "Unknown rig num %u, or initialization error.\n", model);
+        exit(2);
+    }
+
+    retcode = conf_parms ? rigctld_set_conf(r->rig, conf_parms + 1) : RIG_OK;
+
+    if (retcode != RIG_OK)
+    {
+        fprintf(stderr, "Config parameter error: %s\n", rigerror(retcode));
+        exit(2);
+    }
+
+    if (!skip_open)
+    {
+        retcode = rig_open(r->rig);
+        r->opened = retcode == RIG_OK ? 1 : 0;
+
+        if (retcode != RIG_OK)
+        {
+            // continue, the rig may be powered off
+            fprintf(stderr, "rig_open: error = %s %s\n", rigerror(retcode),
+                    RIGPORT(r->rig)->pathname);
+        }
+        else if (rigctld_idle)
+        {
+            rig_close(r->rig);
+        }
+    }
+}
+
+/*
+ * Open a listening socket on the port, exits on failure
+ */
+static int rigctld_listen(const char *port)
+{
+    struct addrinfo hints, *result, *saved_result;
+    int sock_listen;
+    int retcode;
+
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_UNSPEC;    /* Allow IPv4 or IPv6 */
+    hints.ai_socktype = SOCK_STREAM;/* TCP socket */
+    hints.ai_flags = AI_PASSIVE;    /* For wildcard IP address */
+    hints.ai_protocol = 0;          /* Any protocol */
+
+    retcode = getaddrinfo(src_addr, port, &hints, &result);
+
+    if (retcode == 0 && result->ai_family == AF_INET6)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: Using IPV6\n", __func__);
+    }
+    else if (retcode == 0)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: Using IPV4\n", __func__);
+    }
+    else
+    {
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(retcode));
+        exit(2);
+    }
+
+    saved_result = result;
+
+    do
+    {
+        sock_listen = socket(result->ai_family,
+                             result->ai_socktype,
+                             result->ai_protocol);
+
+        if (sock_listen < 0)
+        {
+            handle_error(RIG_DEBUG_ERR, "socket");
+            freeaddrinfo(saved_result);     /* No longer needed */
+            exit(2);
+        }
+
+        const int optval = 1;
+#ifdef __MINGW32__
+
+        if (setsockopt(sock_listen, SOL_SOCKET, SO_REUSEADDR, (PCHAR)&optval,
+                       sizeof(optval)) < 0)
+#else
+        if (setsockopt(sock_listen, SOL_SOCKET, SO_REUSEADDR, &optval,
+                       sizeof(optval)) < 0)
+#endif
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: error enabling UDP address reuse: %s\n", __func__,
+                      strerror(errno));
+        }
+
+        // Windows does not have SO_REUSEPORT. However, SO_REUSEADDR works in a similar way.
+#if defined(SO_REUSEPORT)
+
+        if (setsockopt(sock_listen, SOL_SOCKET, SO_REUSEPORT, &optval,
+                       sizeof(optval)) < 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: error enabling UDP port reuse: %s\n", __func__,
+                      strerror(errno));
+        }
+
+#endif
+
+
+#if 0
+
+        if (setsockopt(sock_listen,
+                       SOL_SOCKET,
+                       SO_REUSEADDR,
+                       (char *)&reuseaddr,
+                       sizeof(reuseaddr))
+                < 0)
+        {
+
+            handle_error(RIG_DEBUG_ERR, "setsockopt");
+            freeaddrinfo(saved_result);     /* No longer needed */
+            exit(1);
+        }
+
+#endif
+
+#ifdef IPV6_V6ONLY
+
+        if (AF_INET6 == result->ai_family)
+        {
+            /* allow IPv4 mapped to IPv6 clients Windows and BSD default
+               this to 1 (i.e. disallowed) and we prefer it off */
+            int sockopt = 0;
+
+            if (setsockopt(sock_listen,
+                           IPPROTO_IPV6,
+                           IPV6_V6ONLY,
+                           (char *)&sockopt,
+                           sizeof(sockopt))
+                    < 0)
+            {
+
+                handle_error(RIG_DEBUG_ERR, "setsockopt");
+                freeaddrinfo(saved_result);     /* No longer needed */
+                exit(1);
+            }
+        }
+
+#endif
+
+        int retval = bind(sock_listen, result->ai_addr, result->ai_addrlen);
+
+        if (retval == 0)
+        {
+            break;
+        }
+
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: bind: %s\n", __func__, strerror(errno));
+        }
+
+        if (bind_all)
+        {
+            handle_error(RIG_DEBUG_WARN, "binding failed (trying next interface)");
+        }
+        else
+        {
+            handle_error(RIG_DEBUG_WARN, "binding failed");
+        }
+
+#ifdef __MINGW32__
+        closesocket(sock_listen);
+#else
+        close(sock_listen);
+#endif
+    }
+    while (bind_all && ((result = result->ai_next) != NULL));
+
+    freeaddrinfo(saved_result);     /* No longer needed */
+
+    if (NULL == result)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: bind error - no available interface\n", __func__);
+        exit(1);
+    }
+
+    if (listen(sock_listen, 4) < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "listening");
+        exit(1);
+    }
+
+
+    return sock_listen;
+}
+
+/*
+ * Accept a connection to the rig and start serving it, returns -1 if
+ * rigctld should stop
+ */
+static int rigctld_accept(struct rigctld_rig *r, int vfo_mode)
+{
+    struct handle_data *arg;
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+    int retcode;
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+    pthread_attr_t attr;
+#endif
+
+    arg = calloc(1, sizeof(struct handle_data));
+
+    if (!arg)
+    {
+        rig_debug(RIG_DEBUG_ERR, "calloc: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    if (rigctld_password[0] != 0) { arg->use_password = 1; }
+
+    arg->r = r;
+    rigctl_parse_ctx_init(&arg->ctx, rigctld_lock, r);
+    arg->ctx.rigs = nrigs;
+    arg->ctx.status = &r->status;
+    arg->clilen = sizeof(arg->cli_addr);
+    arg->vfo_mode = vfo_mode;
+#ifdef RIGCTLD_BATCH
+
+    if (batch_mode)
+    {
+        arg->batch = calloc(1, sizeof(struct rigctld_batch));
+    }
+
+#endif
+    arg->sock = accept(r->sock_listen,
+                       (struct sockaddr *)&arg->cli_addr,
+                       &arg->clilen);
+
+    if (arg->sock < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "accept");
+#ifdef RIGCTLD_BATCH
+        free(arg->batch);
+#endif
+        free(arg);
+        return -1;
+    }
+
+    if ((retcode = getnameinfo((struct sockaddr const *)&arg->cli_addr,
+                               arg->clilen,
+                               host,
+                               sizeof(host),
+                               serv,
+                               sizeof(serv),
+                               NI_NUMERICHOST | NI_NUMERICSERV))
+            < 0)
+    {
+        rig_debug(RIG_DEBUG_WARN,
+                  "Peer lookup error: %s",
+                  gai_strerror(retcode));
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE,
+              "Connection opened from %s:%s to port %s\n",
+              host,
+              serv,
+              r->port);
+
+#ifdef HAVE_PTHREAD
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    retcode = pthread_create(&thread, &attr, handle_socket, arg);
+
+    if (retcode != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "pthread_create: %s\n", strerror(retcode));
+#ifdef __MINGW32__
+        closesocket(arg->sock);
+#else
+        close(arg->sock);
+#endif
+#ifdef RIGCTLD_BATCH
+        free(arg->batch);
+#endif
+        free(arg);
+        return -1;
+    }
+
+#else
+    handle_socket(arg);
+#endif
+
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     rig_model_t my_model = RIG_MODEL_DUMMY;
@@ -257,26 +666,18 @@ int main(int argc, char *argv[])
     int serial_rate = 0;
     char *civaddr = NULL;   /* NULL means no need to set conf */
     char conf_parms[MAXCONFLEN] = "";
+    char *rig_confs[MAXRIGS];
 
-    struct addrinfo hints, *result, *saved_result;
-    int sock_listen;
 //    int reuseaddr = 1;
     int twiddle_timeout = 0;
     int twiddle_rit = 0;
     int uplink = 0;
-    char host[NI_MAXHOST];
-    char serv[NI_MAXSERV];
     char rigstartup[1024];
     char vbuf[1024];
 #if HAVE_SIGACTION
     struct sigaction act;
 #endif
 
-#ifdef HAVE_PTHREAD
-    pthread_t thread;
-    pthread_attr_t attr;
-#endif
-    struct handle_data *arg;
     int vfo_mode = 0; /* vfo_mode=0 means target VFO is current VFO */
     int i;
     extern int is_rigctld;
@@ -323,6 +724,14 @@ int main(int argc, char *argv[])
             bind_all = 1;
             break;
 
+        case 'B':
+#ifdef RIGCTLD_BATCH
+            batch_mode = 1;
+#else
+            fprintf(stderr, "batch mode is not supported on this platform\n");
+#endif
+            break;
+
         case 'A':
             strncpy(rigctld_password, optarg, sizeof(rigctld_password) - 1);
             //char *md5 = rig_make_m d5(rigctld_password);
@@ -619,6 +1028,22 @@ int main(int argc, char *argv[])
             rig_set_debug_time_stamp(1);
             break;
 
+        case 'N':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
+
+            if (nrigs == MAXRIGS)
+            {
+                fprintf(stderr, "At most %d rigs can be served\n", MAXRIGS);
+                exit(1);
+            }
+
+            rig_confs[nrigs++] = optarg;
+            break;
+
         default:
             usage();    /* unknown option? */
             exit(1);
@@ -661,32 +1086,12 @@ int main(int argc, char *argv[])
         exit(2);
     }
 
-    char *token = strtok(conf_parms, ",");
+    retcode = rigctld_set_conf(my_rig, conf_parms);
 
-    while (token)
+    if (retcode != RIG_OK)
     {
-        char mytoken[100], myvalue[100];
-        hamlib_token_t lookup;
-        sscanf(token, "%99[^=]=%99s", mytoken, myvalue);
-        //printf("mytoken=%s,myvalue=%s\n",mytoken, myvalue);
-        lookup = rig_token_lookup(my_rig, mytoken);
-
-        if (lookup == 0)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: no such token as '%s'\n", __func__, mytoken);
-            token = strtok(NULL, ",");
-            continue;
-        }
-
-        retcode = rig_set_conf(my_rig, rig_token_lookup(my_rig, mytoken), myvalue);
-
-        if (retcode != RIG_OK)
-        {
-            fprintf(stderr, "Config parameter error: %s\n", rigerror(retcode));
-            exit(2);
-        }
-
-        token = strtok(NULL, ",");
+        fprintf(stderr, "Config parameter error: %s\n", rigerror(retcode));
+        exit(2);
     }
 
     if (rig_file)
@@ -767,12 +1172,12 @@ int main(int argc, char *argv[])
     /* attempt to open rig to check early for issues */
     if (skip_open)
     {
-        rig_opened = 0;
+        rigs[0].opened = 0;
     }
     else
     {
         retcode = rig_open(my_rig);
-        rig_opened = retcode == RIG_OK ? 1 : 0;
+        rigs[0].opened = retcode == RIG_OK ? 1 : 0;
     }
 
     if (retcode != RIG_OK)
@@ -800,188 +1205,75 @@ int main(int argc, char *argv[])
         rig_close(my_rig);          /* we will reopen for clients */
 
         if (verbose > RIG_DEBUG_ERR)
-        {
-            printf("Closed rig model %u, '%s - will reopen for clients'\n",
-                   my_rig->caps->rig_model,
-                   my_rig->caps->model_name);
-        }
-    }
-
-#ifdef __MINGW32__
-#  ifndef SO_OPENTYPE
-#    define SO_OPENTYPE     0x7008
-#  endif
-#  ifndef SO_SYNCHRONOUS_NONALERT
-#    define SO_SYNCHRONOUS_NONALERT 0x20
-#  endif
-#  ifndef INVALID_SOCKET
-#    define INVALID_SOCKET -1
-#  endif
-
-    WSADATA wsadata;
-
-    if (WSAStartup(MAKEWORD(1, 1), &wsadata) == SOCKET_ERROR)
-    {
-        fprintf(stderr, "WSAStartup socket error\n");
-        exit(1);
-    }
-
-    {
-        int sockopt = SO_SYNCHRONOUS_NONALERT;
-        setsockopt(INVALID_SOCKET, SOL_SOCKET, SO_OPENTYPE, (char *)&sockopt,
-                   sizeof(sockopt));
-    }
-
-#endif
-
-    /*
-     * Prepare listening socket
-     */
-    memset(&hints, 0, sizeof(struct addrinfo));
-    hints.ai_family = AF_UNSPEC;    /* Allow IPv4 or IPv6 */
-    hints.ai_socktype = SOCK_STREAM;/* TCP socket */
-    hints.ai_flags = AI_PASSIVE;    /* For wildcard IP address */
-    hints.ai_protocol = 0;          /* Any protocol */
-
-    retcode = getaddrinfo(src_addr, portno, &hints, &result);
-
-    if (retcode == 0 && result->ai_family == AF_INET6)
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s: Using IPV6\n", __func__);
-    }
-    else if (retcode == 0)
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s: Using IPV4\n", __func__);
-    }
-    else
-    {
-        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(retcode));
-        exit(2);
-    }
-
-    saved_result = result;
-
-    do
-    {
-        sock_listen = socket(result->ai_family,
-                             result->ai_socktype,
-                             result->ai_protocol);
-
-        if (sock_listen < 0)
-        {
-            handle_error(RIG_DEBUG_ERR, "socket");
-            freeaddrinfo(saved_result);     /* No longer needed */
-            exit(2);
-        }
-
-        const int optval = 1;
-#ifdef __MINGW32__
-
-        if (setsockopt(sock_listen, SOL_SOCKET, SO_REUSEADDR, (PCHAR)&optval,
-                       sizeof(optval)) < 0)
-#else
-        if (setsockopt(sock_listen, SOL_SOCKET, SO_REUSEADDR, &optval,
-                       sizeof(optval)) < 0)
-#endif
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: error enabling UDP address reuse: %s\n", __func__,
-                      strerror(errno));
-        }
-
-        // Windows does not have SO_REUSEPORT. However, SO_REUSEADDR works in a similar way.
-#if defined(SO_REUSEPORT)
-
-        if (setsockopt(sock_listen, SOL_SOCKET, SO_REUSEPORT, &optval,
-                       sizeof(optval)) < 0)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: error enabling UDP port reuse: %s\n", __func__,
-                      strerror(errno));
-        }
-
-#endif
-
-
-#if 0
-
-        if (setsockopt(sock_listen,
-                       SOL_SOCKET,
-                       SO_REUSEADDR,
-                       (char *)&reuseaddr,
-                       sizeof(reuseaddr))
-                < 0)
-        {
-
-            handle_error(RIG_DEBUG_ERR, "setsockopt");
-            freeaddrinfo(saved_result);     /* No longer needed */
-            exit(1);
-        }
-
-#endif
-
-#ifdef IPV6_V6ONLY
-
-        if (AF_INET6 == result->ai_family)
-        {
-            /* allow IPv4 mapped to IPv6 clients Windows and BSD default
-               this to 1 (i.e. disallowed) and we prefer it off */
-            int sockopt = 0;
-
-            if (setsockopt(sock_listen,
-                           IPPROTO_IPV6,
-                           IPV6_V6ONLY,
-                           (char *)&sockopt,
-                           sizeof(sockopt))
-                    < 0)
-            {
-
-                handle_error(RIG_DEBUG_ERR, "setsockopt");
-                freeaddrinfo(saved_result);     /* No longer needed */
-                exit(1);
-            }
+        {
+            printf("Closed rig model %u, '%s - will reopen for clients'\n",
+                   my_rig->caps->rig_model,
+                   my_rig->caps->model_name);
         }
+    }
 
-#endif
+    rigs[0].rig = my_rig;
 
-        int retval = bind(sock_listen, result->ai_addr, result->ai_addrlen);
+    for (i = 1; i < nrigs; i++)
+    {
+        rigctld_add_rig(&rigs[i], rig_confs[i]);
+    }
 
-        if (retval == 0)
-        {
-            break;
-        }
+    for (i = 0; i < nrigs; i++)
+    {
+        rigs[i].status.powerstat = RIG_POWER_ON; // defaults to power on
+    }
 
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: bind: %s\n", __func__, strerror(errno));
-        }
+#ifdef HAVE_PTHREAD
 
-        if (bind_all)
-        {
-            handle_error(RIG_DEBUG_WARN, "binding failed (trying next interface)");
-        }
-        else
-        {
-            handle_error(RIG_DEBUG_WARN, "binding failed");
-        }
+    for (i = 0; i < nrigs; i++)
+    {
+        pthread_mutex_init(&rigs[i].lock, NULL);
+        pthread_cond_init(&rigs[i].unlocked, NULL);
+    }
 
-#ifdef __MINGW32__
-        closesocket(sock_listen);
-#else
-        close(sock_listen);
 #endif
-    }
-    while (bind_all && ((result = result->ai_next) != NULL));
 
-    freeaddrinfo(saved_result);     /* No longer needed */
+#ifdef __MINGW32__
+#  ifndef SO_OPENTYPE
+#    define SO_OPENTYPE     0x7008
+#  endif
+#  ifndef SO_SYNCHRONOUS_NONALERT
+#    define SO_SYNCHRONOUS_NONALERT 0x20
+#  endif
+#  ifndef INVALID_SOCKET
+#    define INVALID_SOCKET -1
+#  endif
 
-    if (NULL == result)
+    WSADATA wsadata;
+
+    if (WSAStartup(MAKEWORD(1, 1), &wsadata) == SOCKET_ERROR)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: bind error - no available interface\n", __func__);
+        fprintf(stderr, "WSAStartup socket error\n");
         exit(1);
     }
 
-    if (listen(sock_listen, 4) < 0)
     {
-        handle_error(RIG_DEBUG_ERR, "listening");
-        exit(1);
+        int sockopt = SO_SYNCHRONOUS_NONALERT;
+        setsockopt(INVALID_SOCKET, SOL_SOCKET, SO_OPENTYPE, (char *)&sockopt,
+                   sizeof(sockopt));
+    }
+
+#endif
+
+    /*
+     * Prepare listening sockets, rig i on the port after rig i - 1
+     */
+    SNPRINTF(rigs[0].port, sizeof(rigs[0].port), "%s", portno);
+
+    for (i = 0; i < nrigs; i++)
+    {
+        if (i > 0)
+        {
+            SNPRINTF(rigs[i].port, sizeof(rigs[i].port), "%d", atoi(portno) + i);
+        }
+
+        rigs[i].sock_listen = rigctld_listen(rigs[i].port);
     }
 
 #if HAVE_SIGACTION
@@ -1058,30 +1350,31 @@ int main(int argc, char *argv[])
     /*
      * main loop accepting connections
      */
-    rig_debug(RIG_DEBUG_TRACE, "%s: rigctld listening on port %s\n", __func__,
-              portno);
+    rig_debug(RIG_DEBUG_TRACE, "%s: rigctld listening on port %s, %d rig%s\n",
+              __func__, portno, nrigs, nrigs > 1 ? "s" : "");
 
     do
     {
         fd_set set;
         struct timeval timeout;
+        int maxfd = 0;
 
-        arg = calloc(1, sizeof(struct handle_data));
+        /* use select to allow for periodic checks for CTRL+C */
+        FD_ZERO(&set);
 
-        if (!arg)
+        for (i = 0; i < nrigs; i++)
         {
-            rig_debug(RIG_DEBUG_ERR, "calloc: %s\n", strerror(errno));
-            exit(1);
-        }
+            FD_SET(rigs[i].sock_listen, &set);
 
-        if (rigctld_password[0] != 0) { arg->use_password = 1; }
+            if (rigs[i].sock_listen > maxfd)
+            {
+                maxfd = rigs[i].sock_listen;
+            }
+        }
 
-        /* use select to allow for periodic checks for CTRL+C */
-        FD_ZERO(&set);
-        FD_SET(sock_listen, &set);
         timeout.tv_sec = 5;
         timeout.tv_usec = 0;
-        retcode = select(sock_listen + 1, &set, NULL, NULL, &timeout);
+        retcode = select(maxfd + 1, &set, NULL, NULL, &timeout);
 
         if (retcode == -1)
         {
@@ -1112,79 +1405,53 @@ int main(int argc, char *argv[])
         }
         else
         {
-            arg->rig = my_rig;
-            arg->clilen = sizeof(arg->cli_addr);
-            arg->vfo_mode = vfo_mode;
-            arg->sock = accept(sock_listen,
-                               (struct sockaddr *)&arg->cli_addr,
-                               &arg->clilen);
-
-            if (arg->sock < 0)
-            {
-                handle_error(RIG_DEBUG_ERR, "accept");
-                break;
-            }
-
-            if ((retcode = getnameinfo((struct sockaddr const *)&arg->cli_addr,
-                                       arg->clilen,
-                                       host,
-                                       sizeof(host),
-                                       serv,
-                                       sizeof(serv),
-                                       NI_NUMERICHOST | NI_NUMERICSERV))
-                    < 0)
+            for (i = 0; i < nrigs; i++)
             {
-                rig_debug(RIG_DEBUG_WARN,
-                          "Peer lookup error: %s",
-                          gai_strerror(retcode));
+                if (FD_ISSET(rigs[i].sock_listen, &set)
+                        && rigctld_accept(&rigs[i], vfo_mode) < 0)
+                {
+                    break;
+                }
             }
 
-            rig_debug(RIG_DEBUG_VERBOSE,
-                      "Connection opened from %s:%s\n",
-                      host,
-                      serv);
-
-#ifdef HAVE_PTHREAD
-            pthread_attr_init(&attr);
-            pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
-
-            retcode = pthread_create(&thread, &attr, handle_socket, arg);
-
-            if (retcode != 0)
+            if (i < nrigs)
             {
-                rig_debug(RIG_DEBUG_ERR, "pthread_create: %s\n", strerror(retcode));
                 break;
             }
-
-#else
-            handle_socket(arg);
-#endif
         }
     }
     while (!ctrl_c);
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: while loop done\n", __func__);
 
+    for (i = 0; i < nrigs; i++)
+    {
 #ifdef HAVE_PTHREAD
-    /* allow threads to finish current action */
-    mutex_rigctld(1);
+        /* allow threads to finish current action */
+        rigctld_lock(&rigs[i], 1);
 
-    if (client_count)
-    {
-        rig_debug(RIG_DEBUG_WARN, "%u outstanding client(s)\n", client_count);
-    }
+        if (rigs[i].client_count)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%u outstanding client(s)\n", rigs[i].client_count);
+        }
 
 #ifdef __MINGW__
-    closesocket(sock_listen);
+        closesocket(rigs[i].sock_listen);
 #else
-    close(sock_listen);
+        close(rigs[i].sock_listen);
 #endif
-    rig_close(my_rig);
-    mutex_rigctld(0);
+        rig_close(rigs[i].rig);
+        rigctld_lock(&rigs[i], 0);
 #else
-    rig_close(my_rig); /* close port */
+        rig_close(rigs[i].rig); /* close port */
 #endif
 
+        if (i > 0)
+        {
+            rig_cleanup(rigs[i].rig);
+        }
+    }
+
     rig_cleanup(my_rig); /* if you care about memory */
 
 #ifdef __MINGW32__
@@ -1221,12 +1488,272 @@ static FILE *get_fsockin(struct handle_data *handle_data_arg)
 #endif
 }
 
+#ifdef RIGCTLD_BATCH
+static const char *batch_line_end(const char *p, const char *end)
+{
+    while (p < end && *p != '\n' && *p != '\r')
+    {
+        p++;
+    }
+
+    while (p < end && (*p == '\n' || *p == '\r'))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+static int batch_is_delimiter(const char *p, const char *end)
+{
+    size_t n = strlen(BATCH_DELIMITER);
+
+    return end - p >= n && strncmp(p, BATCH_DELIMITER, n) == 0
+           && (end - p == n || p[n] == '\n' || p[n] == '\r');
+}
+
+/*
+ * Run the commands in [p, end) through rigctl_parse.  Returns the last
+ * retcode and advances *consumed past the commands that were executed,
+ * stopping early on quit or on an error that needs the rig reopened.
+ */
+static int batch_run(struct handle_data *handle_data_arg, char *p, size_t len,
+                     FILE *fout, char send_cmd_term, int *ext_resp,
+                     size_t *consumed, int *ncmds)
+{
+    FILE *fin;
+    int retcode = RIG_OK;
+    int c;
+
+    *consumed = len;
+
+    if (len == 0)
+    {
+        return RIG_OK;
+    }
+
+    fin = fmemopen(p, len, "r");
+
+    if (!fin)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fmemopen: %s\n", __func__, strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    while ((c = getc(fin)) != EOF)
+    {
+        if (c == '\n' || c == '\r')
+        {
+            continue;
+        }
+
+        ungetc(c, fin);
+
+        retcode = rigctl_parse_r(&handle_data_arg->ctx, handle_data_arg->r->rig, fin,
+                                 fout, NULL, 0,
+                                 1, 0, &handle_data_arg->vfo_mode, send_cmd_term, ext_resp, &resp_sep,
+                                 handle_data_arg->use_password);
+        (*ncmds)++;
+
+        if (retcode == RIGCTL_PARSE_END || retcode == RIGCTL_PARSE_ERROR
+                || (retcode < 0 && !RIG_IS_SOFT_ERRCODE(-retcode)))
+        {
+            long pos = ftell(fin);
+
+            *consumed = pos < 0 ? len : pos;
+            break;
+        }
+    }
+
+    fclose(fin);
+
+    return retcode;
+}
+
+/*
+ * Pipelined version of one rigctl_parse call: read whatever the client
+ * has sent, execute all complete command lines under a single
+ * acquisition of the client lock and send all the responses with one
+ * write.  A BATCH_DELIMITER line is answered with "#batch <n>" after
+ * the responses of the n commands before it, older rigctld ignore it
+ * as a comment.
+ */
+static int handle_batch(struct handle_data *handle_data_arg, char send_cmd_term,
+                        int *ext_resp)
+{
+    struct rigctld_batch *b = handle_data_arg->batch;
+    struct timespec busy;
+    const char *end;
+    char *p;
+    char *outbuf = NULL;
+    size_t outlen = 0;
+    FILE *fout;
+    int retcode = RIG_OK;
+
+    /* don't block on the socket while complete commands are pending */
+    end = b->buf + b->len;
+
+    while (end > b->buf && end[-1] != '\n' && end[-1] != '\r')
+    {
+        end--;
+    }
+
+    if (end == b->buf)
+    {
+        ssize_t n;
+
+        if (b->len == MAXBATCHLEN)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: command line longer than %d bytes\n", __func__,
+                      MAXBATCHLEN);
+            return RIGCTL_PARSE_ERROR;
+        }
+
+        n = recv(handle_data_arg->sock, b->buf + b->len, MAXBATCHLEN - b->len, 0);
+        b->recvs++;
+
+        if (n <= 0)
+        {
+            return RIGCTL_PARSE_ERROR;
+        }
+
+        b->len += n;
+
+        return RIG_OK;
+    }
+
+    fout = open_memstream(&outbuf, &outlen);
+
+    if (!fout)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: open_memstream: %s\n", __func__,
+                  strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    /* the whole batch runs under one acquisition of the lock */
+    rigctld_lock(handle_data_arg->r, 1);
+    handle_data_arg->ctx.lock_cb = NULL;
+    elapsed_ms(&busy, HAMLIB_ELAPSED_SET);
+
+    p = b->buf;
+
+    while (p < end)
+    {
+        const char *q = p;
+        const char *next;
+        size_t consumed;
+        int ncmds = 0;
+        int delimited = 0;
+
+        while (q < end && !(delimited = batch_is_delimiter(q, end)))
+        {
+            q = batch_line_end(q, end);
+        }
+
+        next = delimited ? batch_line_end(q, end) : q;
+
+        retcode = batch_run(handle_data_arg, p, q - p, fout, send_cmd_term,
+                            ext_resp, &consumed, &ncmds);
+        b->commands += ncmds;
+
+        if (consumed < q - p)
+        {
+            p += consumed;
+            break;
+        }
+
+        if (delimited)
+        {
+            fprintf(fout, "%s %d\n", BATCH_DELIMITER, ncmds);
+        }
+
+        p = (char *)next;
+    }
+
+    b->busy_ms += elapsed_ms(&busy, HAMLIB_ELAPSED_GET);
+    b->batches++;
+    handle_data_arg->ctx.lock_cb = rigctld_lock;
+    rigctld_lock(handle_data_arg->r, 0);
+
+    fclose(fout);
+
+    if (outlen > 0)
+    {
+        size_t sent = 0;
+
+        while (sent < outlen)
+        {
+            ssize_t n = send(handle_data_arg->sock, outbuf + sent, outlen - sent, 0);
+            b->sends++;
+
+            if (n <= 0)
+            {
+                retcode = -RIG_EIO;
+                break;
+            }
+
+            sent += n;
+        }
+    }
+
+    free(outbuf);
+
+    b->len -= p - b->buf;
+    memmove(b->buf, p, b->len);
+
+    return retcode;
+}
+#endif
+
+/*
+ * Move the connection to the rig chosen with \select_rig.  Called with
+ * no lock held, so a connection never holds the locks of two rigs.
+ */
+static struct rigctld_rig *rigctld_select_rig(struct handle_data
+        *handle_data_arg)
+{
+    struct rigctld_rig *from = handle_data_arg->r;
+    struct rigctld_rig *to = &rigs[handle_data_arg->ctx.select_rig];
+
+    handle_data_arg->ctx.select_rig = -1;
+
+    if (to == from)
+    {
+        return from;
+    }
+
+    rigctld_lock(from, 1);
+
+    if (rigctld_idle && from->client_count == 1)
+    {
+        rig_close(from->rig);
+    }
+
+    --from->client_count;
+    rigctld_lock(from, 0);
+
+    rigctld_lock(to, 1);
+    ++to->client_count;
+    rigctld_lock(to, 0);
+
+    handle_data_arg->r = to;
+    handle_data_arg->ctx.lock_arg = to;
+    handle_data_arg->ctx.status = &to->status;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: connection moved to rig %d (port %s)\n",
+              __func__, (int)(to - rigs), to->port);
+
+    return to;
+}
+
 /*
  * This is the function run by the threads
  */
 void *handle_socket(void *arg)
 {
     struct handle_data *handle_data_arg = (struct handle_data *)arg;
+    struct rigctld_rig *r = handle_data_arg->r;
     FILE *fsockin = NULL;
     FILE *fsockout = NULL;
     int retcode = RIG_OK;
@@ -1234,7 +1761,6 @@ void *handle_socket(void *arg)
     char serv[NI_MAXSERV];
     char send_cmd_term = '\r';  /* send_cmd termination char */
     int ext_resp = 0;
-    rig_powerstat = RIG_POWER_ON; // defaults to power on
     struct timespec powerstat_check_time;
 
     fsockin = get_fsockin(handle_data_arg);
@@ -1259,85 +1785,104 @@ void *handle_socket(void *arg)
     }
 
 #ifdef HAVE_PTHREAD
-    mutex_rigctld(1);
+    rigctld_lock(r, 1);
 
-    ++client_count;
+    ++r->client_count;
 #if 0
 
-    if (!client_count++)
+    if (!r->client_count++)
     {
-        retcode = rig_open(my_rig);
+        retcode = rig_open(r->rig);
 
         if (RIG_OK == retcode && verbose > RIG_DEBUG_ERR)
         {
             printf("Opened rig model %d, '%s'\n",
-                   my_rig->caps->rig_model,
-                   my_rig->caps->model_name);
+                   r->rig->caps->rig_model,
+                   r->rig->caps->model_name);
         }
     }
 
 #endif
 
-    mutex_rigctld(0);
+    rigctld_lock(r, 0);
 #else
-    mutex_rigctld(1);
-    retcode = rig_open(my_rig);
-    mutex_rigctld(1);
+    rigctld_lock(r, 1);
+    retcode = rig_open(r->rig);
+    rigctld_lock(r, 1);
 
     if (RIG_OK == retcode && verbose > RIG_DEBUG_ERR)
     {
         printf("Opened rig model %d, '%s'\n",
-               my_rig->caps->rig_model,
-               my_rig->caps->model_name);
+               r->rig->caps->rig_model,
+               r->rig->caps->model_name);
     }
 
 #endif
 
-    if (my_rig->caps->get_powerstat)
+    if (r->rig->caps->get_powerstat)
     {
-        mutex_rigctld(1);
-        rig_get_powerstat(my_rig, &rig_powerstat);
-        mutex_rigctld(0);
-        my_rig->state.powerstat = rig_powerstat;
+        rigctld_lock(r, 1);
+        rig_get_powerstat(r->rig, &r->status.powerstat);
+        rigctld_lock(r, 0);
+        r->rig->state.powerstat = r->status.powerstat;
     }
 
     elapsed_ms(&powerstat_check_time, HAMLIB_ELAPSED_SET);
 
     do
     {
-        mutex_rigctld(1);
-
-        if (!rig_opened)
+        /* the lock only to reopen, a command must not wait for it twice */
+        if (!r->opened)
         {
-            retcode = rig_open(my_rig);
-            rig_opened = retcode == RIG_OK ? 1 : 0;
-            rig_debug(RIG_DEBUG_ERR, "%s: rig_open reopened retcode=%d\n", __func__,
-                      retcode);
-        }
+            rigctld_lock(r, 1);
+
+            if (!r->opened)
+            {
+                retcode = rig_open(r->rig);
+                r->opened = retcode == RIG_OK ? 1 : 0;
+                rig_debug(RIG_DEBUG_ERR, "%s: rig_open reopened retcode=%d\n", __func__,
+                          retcode);
+            }
 
-        mutex_rigctld(0);
+            rigctld_lock(r, 0);
+        }
 
-        if (rig_opened) // only do this if rig is open
+        if (r->opened) // only do this if rig is open
         {
             rig_debug(RIG_DEBUG_TRACE, "%s: doing rigctl_parse vfo_mode=%d, secure=%d\n",
                       __func__,
                       handle_data_arg->vfo_mode, handle_data_arg->use_password);
-            retcode = rigctl_parse(handle_data_arg->rig, fsockin, fsockout, NULL, 0,
-                                   mutex_rigctld,
-                                   1, 0, &handle_data_arg->vfo_mode, send_cmd_term, &ext_resp, &resp_sep,
-                                   handle_data_arg->use_password);
+#ifdef RIGCTLD_BATCH
+
+            if (handle_data_arg->batch)
+            {
+                retcode = handle_batch(handle_data_arg, send_cmd_term, &ext_resp);
+            }
+            else
+#endif
+            {
+                retcode = rigctl_parse_r(&handle_data_arg->ctx, r->rig, fsockin, fsockout,
+                                         NULL, 0,
+                                         1, 0, &handle_data_arg->vfo_mode, send_cmd_term, &ext_resp, &resp_sep,
+                                         handle_data_arg->use_password);
+            }
+
+            if (handle_data_arg->ctx.select_rig >= 0)
+            {
+                r = rigctld_select_rig(handle_data_arg);
+            }
 
             if (retcode != 0) { rig_debug(RIG_DEBUG_VERBOSE, "%s: rigctl_parse retcode=%d\n", __func__, retcode); }
 
             // If we get a timeout, the rig might be powered off
             // Update our power status in case power gets turned off
             // Check power status if rig is powered off, but not more often than once per second
-            if (my_rig->caps->get_powerstat && (retcode == -RIG_ETIMEOUT ||
+            if (r->rig->caps->get_powerstat && (retcode == -RIG_ETIMEOUT ||
                     (retcode == -RIG_EPOWER && elapsed_ms(&powerstat_check_time, HAMLIB_ELAPSED_GET) >= 1000)))
             {
                 powerstat_t powerstat;
-                rig_get_powerstat(my_rig, &powerstat);
-                rig_powerstat = powerstat;
+                rig_get_powerstat(r->rig, &powerstat);
+                r->status.powerstat = powerstat;
 
                 if (powerstat == RIG_POWER_OFF || powerstat == RIG_POWER_STANDBY)
                 {
@@ -1361,75 +1906,75 @@ void *handle_socket(void *arg)
 
             do
             {
-                mutex_rigctld(1);
-                retcode = rig_close(my_rig);
-                rig_opened = 0;
-                mutex_rigctld(0);
+                rigctld_lock(r, 1);
+                retcode = rig_close(r->rig);
+                r->opened = 0;
+                rigctld_lock(r, 0);
                 rig_debug(RIG_DEBUG_ERR, "%s: rig_close retcode=%d\n", __func__, retcode);
 
                 hl_usleep(1000 * 1000);
 
-                mutex_rigctld(1);
+                rigctld_lock(r, 1);
 
-                if (!rig_opened)
+                if (!r->opened)
                 {
-                    retcode = rig_open(my_rig);
-                    rig_opened = retcode == RIG_OK ? 1 : 0;
+                    retcode = rig_open(r->rig);
+                    r->opened = retcode == RIG_OK ? 1 : 0;
                     rig_debug(RIG_DEBUG_ERR, "%s: rig_open retcode=%d, opened=%d\n", __func__,
-                              retcode, rig_opened);
+                              retcode, r->opened);
                 }
 
-                mutex_rigctld(0);
+                rigctld_lock(r, 0);
             }
-            while (!ctrl_c && !rig_opened && retry-- > 0 && retcode != RIG_OK);
+            while (!ctrl_c && !r->opened && retry-- > 0 && retcode != RIG_OK);
         }
     }
     while (!ctrl_c && (retcode == RIG_OK || RIG_IS_SOFT_ERRCODE(-retcode)));
 
 #if defined(HAVE_PTHREAD)
 
-    if (rigctld_idle && client_count == 1)
+    if (rigctld_idle && r->client_count == 1)
 #else
     if (rigctld_idle)
 #endif
     {
-        rig_close(my_rig);
+        rig_close(r->rig);
 
-        if (verbose > RIG_DEBUG_ERR) { printf("Closed rig model %s.  Will reopen for new clients\n", my_rig->caps->model_name); }
+        if (verbose > RIG_DEBUG_ERR) { printf("Closed rig model %s.  Will reopen for new clients\n", r->rig->caps->model_name); }
     }
 
 
 #ifdef HAVE_PTHREAD
-    --client_count;
+    --r->client_count;
 
-    if (rigctld_idle && client_count > 0) { printf("%u client%s still connected so rig remains open\n", client_count, client_count > 1 ? "s" : ""); }
+    if (rigctld_idle && r->client_count > 0) { printf("%u client%s still connected so rig remains open\n", r->client_count, r->client_count > 1 ? "s" : ""); }
 
 #if 0
-    mutex_rigctld(1);
+    rigctld_lock(r, 1);
 
     /* Release rig if there are no clients */
-    if (!--client_count)
+    if (!--r->client_count)
     {
-        rig_close(my_rig);
+        rig_close(r->rig);
 
         if (verbose > RIG_DEBUG_ERR)
         {
             printf("Closed rig model %d, '%s - no clients, will reopen for new clients'\n",
-                   my_rig->caps->rig_model,
-                   my_rig->caps->model_name);
+                   r->rig->caps->rig_model,
+                   r->rig->caps->model_name);
         }
     }
 
-    mutex_rigctld(0);
+    rigctld_lock(r, 0);
 #endif
 #else
-    rig_close(my_rig);
+    rig_close(r->rig);
 
     if (verbose > RIG_DEBUG_ERR)
     {
         printf("Closed rig model %d, '%s - will reopen for new clients'\n",
-               my_rig->caps->rig_model,
-               my_rig->caps->model_name);
+               r->rig->caps->rig_model,
+               r->rig->caps->model_name);
     }
 
 #endif
@@ -1452,6 +1997,20 @@ void *handle_socket(void *arg)
               host,
               serv);
 
+#ifdef RIGCTLD_BATCH
+
+    if (handle_data_arg->batch && handle_data_arg->batch->batches)
+    {
+        const struct rigctld_batch *b = handle_data_arg->batch;
+
+        rig_debug(RIG_DEBUG_VERBOSE,
+                  "%s:%s batches=%lu commands=%lu recv=%lu send=%lu busy=%.3fms/batch\n",
+                  host, serv, b->batches, b->commands, b->recvs, b->sends,
+                  b->busy_ms / b->batches);
+    }
+
+#endif
+
 handle_exit:
 
 // for MINGW we close the handle before fclose
@@ -1474,6 +2033,9 @@ handle_exit:
 
 #endif
 
+#ifdef RIGCTLD_BATCH
+    free(handle_data_arg->batch);
+#endif
     free(arg);
 
 #ifdef HAVE_PTHREAD
@@ -1513,6 +2075,8 @@ void usage(void)
         "  -Z, --debug-time-stamps       enable time stamps for debug messages\n"
         "  -A, --password                set password for rigctld access\n"
         "  -R, --rigctld-idle            make rigctld close the rig when no clients are connected\n"
+        "  -B, --batch                   execute pipelined commands together and send their replies at once\n"
+        "  -N, --add-rig=ID[,PARM=VAL]   also serve radio ID with config parameters, on the next port\n"
         "  -h, --help                    display this help and exit\n"
         "  -V, --version                 output version information and exit\n\n",
         portno);
@@ -0,0 +1,327 @@
+/*
+ * Hamlib rigctld_bench program
+ *
+ * Connects clients to the rigs of a multi-rig rigctld, or to rigctld
+ * processes on consecutive ports, sets and reads back the frequency as
+ * fast as the rigs answer for a while, and prints one JSON object with
+ * the aggregate commands per second.
+ *
+ *   rigctld_bench [-T host] [-t port] [-n rigs] [-c clients] [-d seconds]
+ *                 [-s] [-S]
+ *
+ * Rig i is reached on port + i, or with -s on the first port followed
+ * by "\select_rig i".  Each rig gets its own frequency, so an answer
+ * from the wrong rig counts as an error.  -S keeps rig 0 busy with
+ * "\pause" for the whole run and fails if any other rig took more than
+ * half of that to answer.  rigctld_bench.sh compares one rigctld
+ * serving 8 rigs with 8 rigctld processes.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+
+#include "misc.h"
+
+struct bench_client
+{
+    pthread_t thread;
+    int rig;
+    int sock;
+    unsigned long commands;
+    unsigned long errors;
+    double total_ms;
+    double max_ms;
+};
+
+static const char *host = "localhost";
+static int base_port = 4532;
+static int duration_s = 5;
+static int select_rig;
+
+
+static int bench_connect(int rig)
+{
+    struct addrinfo hints, *res, *ai;
+    char port[16];
+    int sock = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%d", base_port + (select_rig ? 0 : rig));
+
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+    {
+        return -1;
+    }
+
+    for (ai = res; ai; ai = ai->ai_next)
+    {
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+        if (sock < 0)
+        {
+            continue;
+        }
+
+        if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+            break;
+        }
+
+        close(sock);
+        sock = -1;
+    }
+
+    freeaddrinfo(res);
+
+    return sock;
+}
+
+
+/* send one command, the reply is a single line */
+static int bench_command(FILE *fp, const char *cmd, char *line, int len)
+{
+    fprintf(fp, "%s\n", cmd);
+    fflush(fp);
+
+    return fgets(line, len, fp) ? 0 : -1;
+}
+
+
+static void *bench_thread(void *arg)
+{
+    struct bench_client *c = arg;
+    struct timespec start, sent;
+    char cmd[64], line[128], expect[32];
+    FILE *fp;
+
+    fp = fdopen(c->sock, "r+");
+
+    if (!fp)
+    {
+        c->errors++;
+        return NULL;
+    }
+
+    if (select_rig)
+    {
+        snprintf(cmd, sizeof(cmd), "\\select_rig %d", c->rig);
+
+        if (bench_command(fp, cmd, line, sizeof(line)) < 0
+                || strcmp(line, "RPRT 0\n") != 0)
+        {
+            c->errors++;
+            fclose(fp);
+            return NULL;
+        }
+    }
+
+    snprintf(cmd, sizeof(cmd), "F %d", 14000000 + c->rig * 1000);
+    snprintf(expect, sizeof(expect), "%d\n", 14000000 + c->rig * 1000);
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    while (elapsed_ms(&start, HAMLIB_ELAPSED_GET) < duration_s * 1000.0)
+    {
+        double ms;
+
+        elapsed_ms(&sent, HAMLIB_ELAPSED_SET);
+
+        if (bench_command(fp, cmd, line, sizeof(line)) < 0
+                || strcmp(line, "RPRT 0\n") != 0
+                || bench_command(fp, "f", line, sizeof(line)) < 0)
+        {
+            c->errors++;
+            break;
+        }
+
+        ms = elapsed_ms(&sent, HAMLIB_ELAPSED_GET);
+
+        if (strcmp(line, expect) != 0)
+        {
+            c->errors++;
+        }
+
+        c->commands += 2;
+        c->total_ms += ms;
+
+        if (ms > c->max_ms)
+        {
+            c->max_ms = ms;
+        }
+    }
+
+    fclose(fp);
+
+    return NULL;
+}
+
+
+/* holds the lock of rig 0 for the whole run */
+static void *stall_thread(void *arg)
+{
+    struct bench_client *c = arg;
+    char cmd[32], line[128];
+    FILE *fp;
+
+    fp = fdopen(c->sock, "r+");
+
+    if (!fp)
+    {
+        c->errors++;
+        return NULL;
+    }
+
+    snprintf(cmd, sizeof(cmd), "\\pause %d", duration_s);
+
+    if (bench_command(fp, cmd, line, sizeof(line)) < 0
+            || strcmp(line, "RPRT 0\n") != 0)
+    {
+        c->errors++;
+    }
+
+    fclose(fp);
+
+    return NULL;
+}
+
+
+static void usage(void)
+{
+    printf("Usage: rigctld_bench [-T host] [-t port] [-n rigs] [-c clients] "
+           "[-d seconds] [-s] [-S]\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+    struct bench_client *clients;
+    struct bench_client staller;
+    unsigned long commands = 0, errors = 0;
+    double total_ms = 0, max_ms = 0;
+    int nrigs = 1;
+    int per_rig = 1;
+    int stall = 0;
+    int first_rig;
+    int nclients;
+    int opt;
+    int i;
+
+    while ((opt = getopt(argc, argv, "T:t:n:c:d:sSh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'T': host = optarg; break;
+
+        case 't': base_port = atoi(optarg); break;
+
+        case 'n': nrigs = atoi(optarg); break;
+
+        case 'c': per_rig = atoi(optarg); break;
+
+        case 'd': duration_s = atoi(optarg); break;
+
+        case 's': select_rig = 1; break;
+
+        case 'S': stall = 1; break;
+
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (nrigs < 1 + stall || per_rig < 1 || duration_s < 1)
+    {
+        usage();
+        return 1;
+    }
+
+    /* with -S rig 0 is busy, the clients use the other rigs */
+    first_rig = stall;
+    nclients = (nrigs - first_rig) * per_rig;
+    clients = calloc(nclients, sizeof(*clients));
+
+    if (!clients)
+    {
+        return 1;
+    }
+
+    memset(&staller, 0, sizeof(staller));
+
+    if (stall)
+    {
+        staller.sock = bench_connect(0);
+
+        if (staller.sock < 0)
+        {
+            fprintf(stderr, "cannot connect to rig 0\n");
+            return 1;
+        }
+
+        pthread_create(&staller.thread, NULL, stall_thread, &staller);
+        hl_usleep(100 * 1000);
+    }
+
+    for (i = 0; i < nclients; i++)
+    {
+        clients[i].rig = first_rig + i / per_rig;
+        clients[i].sock = bench_connect(clients[i].rig);
+
+        if (clients[i].sock < 0)
+        {
+            fprintf(stderr, "cannot connect to rig %d\n", clients[i].rig);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < nclients; i++)
+    {
+        pthread_create(&clients[i].thread, NULL, bench_thread, &clients[i]);
+    }
+
+    for (i = 0; i < nclients; i++)
+    {
+        pthread_join(clients[i].thread, NULL);
+        commands += clients[i].commands;
+        errors += clients[i].errors;
+        total_ms += clients[i].total_ms;
+
+        if (clients[i].max_ms > max_ms)
+        {
+            max_ms = clients[i].max_ms;
+        }
+    }
+
+    if (stall)
+    {
+        pthread_join(staller.thread, NULL);
+        errors += staller.errors;
+    }
+
+    printf("{\"rigs\":%d,\"clients\":%d,\"select\":%d,\"stall\":%d,"
+           "\"seconds\":%d,\"commands\":%lu,\"commands_per_s\":%.1f,"
+           "\"errors\":%lu,\"mean_ms\":%.3f,\"max_ms\":%.3f}\n",
+           nrigs, nclients, select_rig, stall, duration_s, commands,
+           (double) commands / duration_s, errors,
+           commands ? total_ms * 2 / commands : 0, max_ms);
+
+    free(clients);
+
+    if (stall && max_ms > duration_s * 500.0)
+    {
+        fprintf(stderr, "a busy rig held up the others\n");
+        return 1;
+    }
+
+    return errors || !commands ? 1 : 0;
+}
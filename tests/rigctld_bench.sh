@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# Run rigctld_bench against 8 dummy rigs served by one rigctld (-N) and
+# by 8 rigctld processes, with the dummy's default 20 ms command latency
+# and with none, and prints the rigctld_bench JSON line of each with the
+# daemon layout and latency added, e.g. from the build tree:
+#
+#   (cd tests && make rigctld rigctld_bench)
+#   sh ../tests/rigctld_bench.sh > rigbench.json
+#
+# Usage: rigctld_bench.sh [clients_per_rig [seconds]]
+
+RIGS=8
+CLIENTS=${1:-2}
+SECONDS_RUN=${2:-5}
+PORT=45350
+
+status=0
+
+for latency in 20 0
+do
+    for mode in multi processes
+    do
+        pids=
+        conf=1,cmd_latency=$latency
+
+        if [ $mode = multi ]
+        then
+            add=
+            i=1
+
+            while [ $i -lt $RIGS ]
+            do
+                add="$add -N $conf"
+                i=$((i + 1))
+            done
+
+            ./rigctld -m 1 -C cmd_latency=$latency -t $PORT $add &
+            pids=$!
+        else
+            i=0
+
+            while [ $i -lt $RIGS ]
+            do
+                ./rigctld -m 1 -C cmd_latency=$latency -t $((PORT + i)) &
+                pids="$pids $!"
+                i=$((i + 1))
+            done
+        fi
+
+        sleep 2
+
+        result=$(./rigctld_bench -t $PORT -n $RIGS -c $CLIENTS \
+                 -d $SECONDS_RUN) || status=1
+
+        kill $pids
+        wait $pids 2>/dev/null
+
+        echo "$result" | sed "s/}\$/,\"daemon\":\"$mode\",\"cmd_latency_ms\":$latency}/"
+        PORT=$((PORT + RIGS))
+    done
+done
+
+exit $status
@@ -6,7 +6,9 @@
  *
  *   This program will synchronize frequency from one rig to another
  *   Implemented for AirSpy SDR# to keep freq synced with a real rig
- *   It simply polls the real rig and when freq changes sends it to SDR# (or whatever rig is hooked up)
+ *   It follows the rig's transceive events, or polls a rig without them,
+ *   and sends only what changed to SDR# (or whatever rig is hooked up),
+ *   optionally mode, split and PTT too and in both directions
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -48,6 +50,10 @@
 // cppcheck-suppress *
 #include <sys/types.h>
 
+#ifdef HAVE_PTHREAD
+#  include <pthread.h>
+#endif
+
 #ifdef HAVE_NETINET_IN_H
 // cppcheck-suppress *
 #  include <netinet/in.h>
@@ -73,6 +79,7 @@
 #include "rigctl_parse.h"
 #include "riglist.h"
 #include "sleep.h"
+#include "misc.h"
 
 /*
  * Reminder: when adding long options,
@@ -80,7 +87,7 @@
  * NB: do NOT use -W since it's reserved by POSIX.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "B:m:M:r:R:p:d:P:D:s:S:c:C:lLuvhVZ"
+#define SHORT_OPTIONS "Bm:M:r:R:p:d:P:D:s:S:c:C:bxXTi:t:lLuvhVZ"
 static struct option long_options[] =
 {
     {"mapa2b",          0, 0, 'B'},
@@ -95,6 +102,12 @@ static struct option long_options[] =
     {"serial-speed2",   1, 0, 'S'},
     {"civaddr",         1, 0, 'c'},
     {"set-conf",        1, 0, 'C'},
+    {"bidirectional",   0, 0, 'b'},
+    {"sync-mode",       0, 0, 'x'},
+    {"sync-split",      0, 0, 'X'},
+    {"sync-ptt",        0, 0, 'T'},
+    {"interval",        1, 0, 'i'},
+    {"latency",         1, 0, 't'},
     {"list",            0, 0, 'l'},
     {"show-conf",       0, 0, 'L'},
     {"dump-caps",       0, 0, 'u'},
@@ -124,7 +137,6 @@ static int volatile ctrl_c;
 
 #define MAXCONFLEN 2048
 
-#if 0
 # ifdef WIN32
 static BOOL WINAPI CtrlHandler(DWORD fdwCtrlType)
 {
@@ -156,7 +168,6 @@ static void signal_handler(int sig)
     }
 }
 # endif  /* ifdef WIN32 */
-#endif   /* if 0 */
 
 #if 0
 static void handle_error(enum rig_debug_level_e lvl, const char *msg)
@@ -196,6 +207,506 @@ static void handle_error(enum rig_debug_level_e lvl, const char *msg)
 #endif  /* if 0 */
 
 
+/*
+ * Sync engine
+ *
+ * Each side keeps the state last read from or written to its rig.  A
+ * side is read when its rig reports a change through the event callbacks
+ * (transceive/async data) or, for a rig without events, every interval.
+ * Only the fields that differ from the other side's state are written,
+ * and writing updates the other side's state, so its echo of our own
+ * write reads back unchanged and is not sent back again.
+ */
+#define SYNC_INTERVAL_MS 100    /* default poll interval without events */
+#define SYNC_RESYNC_MS 1000     /* poll interval of a rig with events */
+#define SYNC_LATENCY_MS 250     /* time between two latency test changes */
+#define SYNC_LOST_MS 5000       /* a change not synced by then is lost */
+
+struct sync_state
+{
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    split_t split;
+    vfo_t tx_vfo;
+    freq_t tx_freq;
+    ptt_t ptt;
+};
+
+struct sync_side
+{
+    RIG *rig;
+    const char *name;
+    vfo_t vfo;                  /* VFO the other side's freq is written to */
+    int events;                 /* rig reports changes by itself */
+    int event;                  /* a change was reported since the last read */
+    int read;                   /* state has been read once */
+    struct timespec last_poll;
+    struct sync_state state;
+};
+
+static struct sync_side sync_side[2];
+static int bidirectional;       /* sync changes on -M rig back to -m rig */
+static int sync_mode;
+static int sync_split;
+static int sync_ptt;
+static int interval_ms = SYNC_INTERVAL_MS;
+static int latency_count;       /* latency test changes, 0 to just sync */
+
+static struct
+{
+    unsigned long reads;
+    unsigned long writes;
+    unsigned long freq_writes;
+    unsigned long echoes;
+} sync_stats;
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sync_cond = PTHREAD_COND_INITIALIZER;
+#endif
+
+
+/* event callbacks, called from the rig's async data thread */
+static void sync_wake(struct sync_side *s)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&sync_mutex);
+    s->event = 1;
+    pthread_cond_signal(&sync_cond);
+    pthread_mutex_unlock(&sync_mutex);
+#else
+    s->event = 1;
+#endif
+}
+
+
+static int sync_freq_event(RIG *rig, vfo_t vfo, freq_t freq, rig_ptr_t arg)
+{
+    sync_wake((struct sync_side *)arg);
+    return RIG_OK;
+}
+
+
+static int sync_mode_event(RIG *rig, vfo_t vfo, rmode_t mode,
+                           pbwidth_t width, rig_ptr_t arg)
+{
+    sync_wake((struct sync_side *)arg);
+    return RIG_OK;
+}
+
+
+static int sync_ptt_event(RIG *rig, vfo_t vfo, ptt_t ptt, rig_ptr_t arg)
+{
+    sync_wake((struct sync_side *)arg);
+    return RIG_OK;
+}
+
+
+/* wait up to ms for an event, returns the sides with one pending */
+static int sync_wait(int ms)
+{
+    int pending = 0;
+    int i;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&sync_mutex);
+
+    if (!sync_side[0].event && !sync_side[1].event && ms > 0)
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += ms / 1000;
+        ts.tv_nsec += (long)(ms % 1000) * 1000000;
+
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+
+        pthread_cond_timedwait(&sync_cond, &sync_mutex, &ts);
+    }
+
+#else
+
+    if (!sync_side[0].event && !sync_side[1].event && ms > 0)
+    {
+        hl_usleep(ms * 1000);
+    }
+
+#endif
+
+    for (i = 0; i < 2; i++)
+    {
+        if (sync_side[i].event)
+        {
+            sync_side[i].event = 0;
+            pending |= 1 << i;
+        }
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&sync_mutex);
+#endif
+
+    return pending;
+}
+
+
+static int sync_read(struct sync_side *s, struct sync_state *st)
+{
+    int retcode;
+
+    *st = s->state;
+    sync_stats.reads++;
+
+    retcode = rig_get_freq(s->rig, RIG_VFO_CURR, &st->freq);
+
+    if (retcode != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s rig_get_freq: %s\n", __func__, s->name,
+                  rigerror(retcode));
+        return retcode;
+    }
+
+    if (sync_mode)
+    {
+        rig_get_mode(s->rig, RIG_VFO_CURR, &st->mode, &st->width);
+    }
+
+    if (sync_split)
+    {
+        rig_get_split_vfo(s->rig, RIG_VFO_CURR, &st->split, &st->tx_vfo);
+
+        if (st->split == RIG_SPLIT_ON)
+        {
+            rig_get_split_freq(s->rig, RIG_VFO_CURR, &st->tx_freq);
+        }
+    }
+
+    if (sync_ptt)
+    {
+        rig_get_ptt(s->rig, RIG_VFO_CURR, &st->ptt);
+    }
+
+    return RIG_OK;
+}
+
+
+/* write to the other side what changed on this side, returns writes */
+static int sync_write(const struct sync_side *from,
+                      const struct sync_state *st, struct sync_side *to)
+{
+    struct sync_state *ts = &to->state;
+    int writes = 0;
+
+    if (st->freq != from->state.freq && st->freq != ts->freq)
+    {
+        if (rig_set_freq(to->rig, to->vfo, st->freq) == RIG_OK)
+        {
+            ts->freq = st->freq;
+            sync_stats.freq_writes++;
+            writes++;
+        }
+    }
+
+    if (sync_mode && (st->mode != from->state.mode
+                      || st->width != from->state.width)
+            && (st->mode != ts->mode || st->width != ts->width))
+    {
+        if (rig_set_mode(to->rig, to->vfo, st->mode, st->width) == RIG_OK)
+        {
+            ts->mode = st->mode;
+            ts->width = st->width;
+            writes++;
+        }
+    }
+
+    if (sync_split && (st->split != from->state.split
+                       || st->tx_vfo != from->state.tx_vfo)
+            && (st->split != ts->split || st->tx_vfo != ts->tx_vfo))
+    {
+        if (rig_set_split_vfo(to->rig, RIG_VFO_CURR, st->split,
+                              st->tx_vfo) == RIG_OK)
+        {
+            ts->split = st->split;
+            ts->tx_vfo = st->tx_vfo;
+            writes++;
+        }
+    }
+
+    if (sync_split && st->split == RIG_SPLIT_ON
+            && st->tx_freq != from->state.tx_freq && st->tx_freq != ts->tx_freq)
+    {
+        if (rig_set_split_freq(to->rig, RIG_VFO_CURR, st->tx_freq) == RIG_OK)
+        {
+            ts->tx_freq = st->tx_freq;
+            writes++;
+        }
+    }
+
+    if (sync_ptt && st->ptt != from->state.ptt && st->ptt != ts->ptt)
+    {
+        if (rig_set_ptt(to->rig, RIG_VFO_CURR, st->ptt) == RIG_OK)
+        {
+            ts->ptt = st->ptt;
+            writes++;
+        }
+    }
+
+    sync_stats.writes += writes;
+
+    return writes;
+}
+
+
+static int sync_changed(const struct sync_state *a, const struct sync_state *b)
+{
+    return a->freq != b->freq || a->mode != b->mode || a->width != b->width
+           || a->split != b->split || a->tx_vfo != b->tx_vfo
+           || a->tx_freq != b->tx_freq || a->ptt != b->ptt;
+}
+
+
+static int sync_open(struct sync_side *s)
+{
+    int retcode;
+
+    /* ask for transceive data where the rig can send it */
+    if (s->rig->caps->async_data_supported)
+    {
+        rig_set_conf(s->rig, rig_token_lookup(s->rig, "async"), "1");
+    }
+    else
+    {
+        /* the poll routine would set the cache timeout to its interval */
+        rig_set_conf(s->rig, rig_token_lookup(s->rig, "poll_interval"), "0");
+    }
+
+    retcode = rig_open(s->rig);
+
+    if (retcode != RIG_OK)
+    {
+        return retcode;
+    }
+
+    s->events = s->rig->state.async_data_enabled;
+
+    if (s->events)
+    {
+        rig_set_freq_callback(s->rig, sync_freq_event, s);
+        rig_set_mode_callback(s->rig, sync_mode_event, s);
+        rig_set_ptt_callback(s->rig, sync_ptt_event, s);
+    }
+    else
+    {
+        /* polling has to see changes made on the rig itself */
+        rig_set_cache_timeout_ms(s->rig, HAMLIB_CACHE_ALL, 0);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s %s\n", __func__, s->name,
+              s->events ? "follows transceive events" : "is polled");
+
+    return RIG_OK;
+}
+
+
+/* the latency test changes the freq on the rig behind the sync's back */
+static struct
+{
+    int count;
+    int lost;
+    struct sync_side *side;     /* side changed, NULL when synced */
+    freq_t freq;
+    struct timespec changed;
+    struct timespec next;
+    int phase_ms;
+    double min_ms, max_ms, sum_ms;
+} latency;
+
+
+static void latency_change(void)
+{
+    struct sync_side *s = &sync_side[bidirectional ? latency.count % 2 : 0];
+    rmode_t mode;
+
+    latency.freq = 14074000 + (latency.count + 1) * 1000;
+
+    /* straight to the backend, as the VFO knob would, the cache is not told */
+    s->rig->caps->set_freq(s->rig, RIG_VFO_CURR, latency.freq);
+
+    if (sync_mode && s->rig->caps->set_mode && latency.count % 4 == 3)
+    {
+        mode = s->state.mode == RIG_MODE_USB ? RIG_MODE_LSB : RIG_MODE_USB;
+        s->rig->caps->set_mode(s->rig, RIG_VFO_CURR, mode, s->state.width);
+    }
+
+    elapsed_ms(&latency.changed, HAMLIB_ELAPSED_SET);
+    latency.side = s;
+    latency.count++;
+
+    /* vary the phase against the poll interval */
+    elapsed_ms(&latency.next, HAMLIB_ELAPSED_SET);
+    latency.phase_ms = latency.count * 37 % 100;
+}
+
+
+static void latency_synced(const struct sync_side *to)
+{
+    double ms;
+
+    if (!latency.side || to == latency.side || to->state.freq != latency.freq)
+    {
+        return;
+    }
+
+    ms = elapsed_ms(&latency.changed, HAMLIB_ELAPSED_GET);
+
+    if (latency.min_ms == 0 || ms < latency.min_ms)
+    {
+        latency.min_ms = ms;
+    }
+
+    if (ms > latency.max_ms)
+    {
+        latency.max_ms = ms;
+    }
+
+    latency.sum_ms += ms;
+    latency.side = NULL;
+}
+
+
+static int sync_loop(void)
+{
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        struct sync_side *s = &sync_side[i];
+
+        if (sync_read(s, &s->state) != RIG_OK)
+        {
+            return -RIG_EIO;
+        }
+
+        elapsed_ms(&s->last_poll, HAMLIB_ELAPSED_SET);
+    }
+
+    /* start from the -m rig's state */
+    {
+        struct sync_state from = sync_side[0].state;
+
+        memset(&sync_side[0].state, 0, sizeof(sync_side[0].state));
+        sync_write(&sync_side[0], &from, &sync_side[1]);
+        sync_side[0].state = from;
+        sync_stats.writes = sync_stats.freq_writes = 0;
+    }
+
+    elapsed_ms(&latency.next, HAMLIB_ELAPSED_SET);
+
+    while (!ctrl_c)
+    {
+        int timeout = SYNC_RESYNC_MS;
+        int pending;
+
+        for (i = 0; i < 2; i++)
+        {
+            struct sync_side *s = &sync_side[i];
+            int due = (s->events ? SYNC_RESYNC_MS : interval_ms)
+                      - (int)elapsed_ms(&s->last_poll, HAMLIB_ELAPSED_GET);
+
+            if ((i == 0 || bidirectional) && due < timeout)
+            {
+                timeout = due;
+            }
+        }
+
+        if (latency_count)
+        {
+            int due = SYNC_LATENCY_MS + latency.phase_ms
+                      - (int)elapsed_ms(&latency.next, HAMLIB_ELAPSED_GET);
+
+            if (latency.count == latency_count && !latency.side)
+            {
+                break;
+            }
+
+            if (latency.side
+                    && elapsed_ms(&latency.changed, HAMLIB_ELAPSED_GET) > SYNC_LOST_MS)
+            {
+                latency.lost++;
+                latency.side = NULL;
+            }
+
+            if (!latency.side && latency.count < latency_count)
+            {
+                if (due <= 0)
+                {
+                    latency_change();
+                    continue;
+                }
+
+                if (due < timeout)
+                {
+                    timeout = due;
+                }
+            }
+        }
+
+        pending = sync_wait(timeout);
+
+        for (i = 0; i < 2; i++)
+        {
+            struct sync_side *s = &sync_side[i];
+            struct sync_side *to = &sync_side[!i];
+            struct sync_state st;
+            int polled = (s->events ? SYNC_RESYNC_MS : interval_ms)
+                         <= elapsed_ms(&s->last_poll, HAMLIB_ELAPSED_GET);
+
+            if (i == 1 && !bidirectional)
+            {
+                continue;
+            }
+
+            if (!(pending & (1 << i)) && !polled)
+            {
+                continue;
+            }
+
+            if (polled)
+            {
+                elapsed_ms(&s->last_poll, HAMLIB_ELAPSED_SET);
+            }
+
+            if (sync_read(s, &st) != RIG_OK)
+            {
+                continue;
+            }
+
+            if (!sync_changed(&st, &s->state))
+            {
+                /* the event was the echo of our own write */
+                if (pending & (1 << i))
+                {
+                    sync_stats.echoes++;
+                }
+
+                continue;
+            }
+
+            sync_write(s, &st, to);
+            s->state = st;
+            latency_synced(to);
+        }
+    }
+
+    return RIG_OK;
+}
+
+
 int main(int argc, char *argv[])
 {
     rig_model_t my_model[] = { RIG_MODEL_DUMMY, RIG_MODEL_SDRSHARP };
@@ -458,6 +969,49 @@ int main(int argc, char *argv[])
             strncat(conf_parms, optarg, MAXCONFLEN - strlen(conf_parms));
             break;
 
+        case 'b':
+            bidirectional = 1;
+            break;
+
+        case 'x':
+            sync_mode = 1;
+            break;
+
+        case 'X':
+            sync_split = 1;
+            break;
+
+        case 'T':
+            sync_ptt = 1;
+            break;
+
+        case 'i':
+            if (!optarg)
+            {
+                usage();        /* wrong arg count */
+                exit(1);
+            }
+
+            interval_ms = atoi(optarg);
+
+            if (interval_ms < 1)
+            {
+                fprintf(stderr, "Invalid interval of %s\n", optarg);
+                exit(1);
+            }
+
+            break;
+
+        case 't':
+            if (!optarg)
+            {
+                usage();        /* wrong arg count */
+                exit(1);
+            }
+
+            latency_count = atoi(optarg);
+            break;
+
         case 'v':
             verbose++;
             break;
@@ -521,7 +1075,6 @@ int main(int argc, char *argv[])
         exit(2);
     }
 
-#if 0
     retcode = set_conf(my_rig, conf_parms);
 
     if (retcode != RIG_OK)
@@ -530,8 +1083,6 @@ int main(int argc, char *argv[])
         exit(2);
     }
 
-#endif
-
     if (my_model[0] > 5 && !rig_file)
     {
         fprintf(stderr, "-r rig com port not provided\n");
@@ -543,8 +1094,12 @@ int main(int argc, char *argv[])
         strncpy(RIGPORT(my_rig)->pathname, rig_file, HAMLIB_FILPATHLEN - 1);
     }
 
-    fprintf(stderr, "rig to send frequency to: %s\n", rig_file2);
-    strncpy(RIGPORT(my_rig_sync)->pathname, rig_file2, HAMLIB_FILPATHLEN - 1);
+    /* a rig without a port, e.g. a second dummy rig, needs no file */
+    if (my_rig_sync->caps->port_type != RIG_PORT_NONE)
+    {
+        fprintf(stderr, "rig to send frequency to: %s\n", rig_file2);
+        strncpy(RIGPORT(my_rig_sync)->pathname, rig_file2, HAMLIB_FILPATHLEN - 1);
+    }
 
 #if 0
 
@@ -609,8 +1164,14 @@ int main(int argc, char *argv[])
         exit(0);
     }
 
-    /* open and close rig connection to check early for issues */
-    retcode = rig_open(my_rig);
+    sync_side[0].rig = my_rig;
+    sync_side[0].name = "rig";
+    sync_side[0].vfo = RIG_VFO_CURR;
+    sync_side[1].rig = my_rig_sync;
+    sync_side[1].name = "sync rig";
+    sync_side[1].vfo = mapa2b ? RIG_VFO_B : RIG_VFO_CURR;
+
+    retcode = sync_open(&sync_side[0]);
 
     if (retcode != RIG_OK)
     {
@@ -619,7 +1180,7 @@ int main(int argc, char *argv[])
     }
 
 
-    retcode = rig_open(my_rig_sync);
+    retcode = sync_open(&sync_side[1]);
 
     if (retcode != RIG_OK)
     {
@@ -638,37 +1199,48 @@ int main(int argc, char *argv[])
     rig_debug(RIG_DEBUG_VERBOSE, "Backend version: %s, Status: %s\n",
               my_rig->caps->version, rig_strstatus(my_rig->caps->status));
 
+#ifdef WIN32
+    SetConsoleCtrlHandler(CtrlHandler, TRUE);
+#else
+    signal(SIGINT, signal_handler);
+#endif
+
     /*
      * main loop
      */
-    do
+    retcode = sync_loop();
+
+    if (latency_count)
     {
-        freq_t freq;
-        retcode = rig_get_freq(my_rig, RIG_VFO_CURR, &freq);
+        int synced = latency.count - latency.lost;
+
+        printf("latency: changes=%d lost=%d min_ms=%.1f avg_ms=%.1f max_ms=%.1f "
+               "reads=%lu writes=%lu freq_writes=%lu echoes=%lu\n",
+               latency.count, latency.lost, latency.min_ms,
+               synced ? latency.sum_ms / synced : 0, latency.max_ms,
+               sync_stats.reads, sync_stats.writes, sync_stats.freq_writes,
+               sync_stats.echoes);
 
-        if (retcode != RIG_OK)
+        /* a write per change, none sent back */
+        if (latency.lost || sync_stats.freq_writes != (unsigned long)latency.count)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: Error in rig_get_freq: %s\n", __func__,
-                      rigerror(retcode));
+            retcode = -RIG_EINTERNAL;
         }
-
-        retcode = rig_set_freq(my_rig_sync, RIG_VFO_CURR, freq);
-
-        hl_usleep(400 * 1000); // fairly fast to keep up
     }
-    while (retcode == 0 && !ctrl_c);
 
+    rig_close(my_rig_sync);
+    rig_cleanup(my_rig_sync);
     rig_close(my_rig);          /* close port */
     rig_cleanup(my_rig);        /* if you care about memory */
 
-    return 0;
+    return retcode == RIG_OK ? 0 : 2;
 }
 
 void usage()
 {
     const char *name = "rigctlsync";
     printf("Usage: %s -m rignumber -r comport -s baud -M rignumber -R comport [OPTIONS]...\n\n"
-           "Will copy frequency from -m rig to -M rig\n"
+           "Will copy frequency from -m rig to -M rig as it changes\n"
            "e.g. will keep SDR# synchronized to a rig.\n\n",
            name);
 
@@ -684,6 +1256,13 @@ void usage()
         "  -S, --serial-speed2=BAUD      set serial speed of the virtual com port [default=115200]\n"
         "  -c, --civaddr=ID              set CI-V address, decimal (for Icom rigs only)\n"
         "  -C, --set-conf=PARM=VAL       set config parameters\n"
+        "  -B, --mapa2b                  set VFOB of the -M rig instead of its current VFO\n"
+        "  -b, --bidirectional           also sync changes on the -M rig back to the -m rig\n"
+        "  -x, --sync-mode               sync mode and passband too\n"
+        "  -X, --sync-split              sync split and TX frequency too\n"
+        "  -T, --sync-ptt                sync PTT too\n"
+        "  -i, --interval=MS             poll interval for rigs without transceive [default=100]\n"
+        "  -t, --latency=COUNT           measure sync latency over COUNT changes and exit\n"
         "  -L, --show-conf               list all config parameters\n"
         "  -l, --list                    list all model numbers and exit\n"
         "  -u, --dump-caps               dump capabilities and exit\n"
@@ -696,3 +1275,43 @@ void usage()
     printf("\nReport bugs to <hamlib-developer@lists.sourceforge.net>.\n");
 
 }
+
+
+int set_conf(RIG *rig, char *conf_parms)
+{
+    char *p, *n;
+
+    p = conf_parms;
+
+    while (p && *p != '\0')
+    {
+        int ret;
+
+        /* FIXME: left hand value of = cannot be null */
+        char *q = strchr(p, '=');
+
+        if (!q)
+        {
+            return RIG_EINVAL;
+        }
+
+        *q++ = '\0';
+        n = strchr(q, ',');
+
+        if (n)
+        {
+            *n++ = '\0';
+        }
+
+        ret = rig_set_conf(rig, rig_token_lookup(rig, p), q);
+
+        if (ret != RIG_OK)
+        {
+            return ret;
+        }
+
+        p = n;
+    }
+
+    return RIG_OK;
+}
@@ -1,8 +1,29 @@
+/*
+ * rigtestmcastrx - receives the multicast rig snapshots
+ *
+ * Prints each packet as it comes and keeps the full rig state from the
+ * keyframes and deltas of the multicast_delta mode.  A delta that does not
+ * follow the packet before it sends a resync request to the command group,
+ * which the publisher answers with a keyframe.
+ *
+ *   rigtestmcastrx [-a addr] [-p port] [-c cmd_addr] [-P cmd_port]
+ *                  [-d seconds] [-l n] [-q]
+ *
+ * With -d it stops after that many seconds and prints the traffic from the
+ * first to the last packet, the CPU time and the state it ended up with as
+ * JSON.  -l drops every nth packet to try the resync, -q does not print the
+ * packets.
+ */
+
+#include <hamlib/config.h>
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <time.h>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -14,18 +35,252 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/select.h>
 #endif
 
+#include "misc.h"
+#include "cJSON.h"
+
 #define MCAST_PORT 4532
 #define MCAST_ADDR "224.0.0.1"
-#define BUFFER_SIZE 4096
+#define MCAST_CMD_ADDR "224.0.0.2"
+#define BUFFER_SIZE 16384
+
+/* resync requests are repeated at most this often while the state is stale */
+#define RESYNC_INTERVAL_MS 500
+
+struct rx_stats
+{
+    struct timespec first;      /* first packet, the rates are over first to last */
+    double last_ms;
+    unsigned long packets;
+    unsigned long keyframes;
+    unsigned long deltas;
+    unsigned long bytes;
+    unsigned long gaps;
+    unsigned long resyncs;
+    unsigned long dropped;
+};
+
+static cJSON *state;            /* the rig state put together, NULL until a keyframe */
+static double last_seq;
+static int stale;               /* a delta was lost since the last keyframe */
+static char process[32];        /* the publisher, to ask it alone for a resync */
+
+
+/* copies the members of delta over those of node */
+static void merge_object(cJSON *node, const cJSON *delta)
+{
+    const cJSON *item;
+
+    cJSON_ArrayForEach(item, delta)
+    {
+        cJSON *copy = cJSON_Duplicate(item, 1);
+
+        if (cJSON_HasObjectItem(node, item->string))
+        {
+            cJSON_ReplaceItemInObjectCaseSensitive(node, item->string, copy);
+        }
+        else
+        {
+            cJSON_AddItemToObject(node, item->string, copy);
+        }
+    }
+}
+
+
+static void apply_delta(const cJSON *delta)
+{
+    const cJSON *vfo_delta;
+    cJSON *vfos = cJSON_GetObjectItemCaseSensitive(state, "vfos");
+    const cJSON *spectra;
+
+    merge_object(cJSON_GetObjectItemCaseSensitive(state, "rig"),
+                 cJSON_GetObjectItemCaseSensitive(delta, "rig"));
+
+    cJSON_ArrayForEach(vfo_delta, cJSON_GetObjectItemCaseSensitive(delta, "vfos"))
+    {
+        const cJSON *name = cJSON_GetObjectItemCaseSensitive(vfo_delta, "name");
+        cJSON *vfo;
+
+        cJSON_ArrayForEach(vfo, vfos)
+        {
+            if (cJSON_Compare(name, cJSON_GetObjectItemCaseSensitive(vfo, "name"), 1))
+            {
+                break;
+            }
+        }
+
+        if (vfo)
+        {
+            merge_object(vfo, vfo_delta);
+        }
+        else
+        {
+            cJSON_AddItemToArray(vfos, cJSON_Duplicate(vfo_delta, 1));
+        }
+    }
+
+    spectra = cJSON_GetObjectItemCaseSensitive(delta, "spectra");
+
+    if (spectra)
+    {
+        cJSON_DeleteItemFromObjectCaseSensitive(state, "spectra");
+        cJSON_AddItemToObject(state, "spectra", cJSON_Duplicate(spectra, 1));
+    }
+
+    cJSON_ReplaceItemInObjectCaseSensitive(state, "seq", cJSON_Duplicate(
+            cJSON_GetObjectItemCaseSensitive(delta, "seq"), 1));
+    cJSON_ReplaceItemInObjectCaseSensitive(state, "time", cJSON_Duplicate(
+            cJSON_GetObjectItemCaseSensitive(delta, "time"), 1));
+}
+
+
+static void send_resync(int sock, const struct sockaddr_in *cmd_addr)
+{
+    char request[128];
+
+    if (process[0])
+    {
+        snprintf(request, sizeof(request),
+                 "{\"cmd\":\"resync\",\"id\":{\"process\":\"%s\"}}", process);
+    }
+    else
+    {
+        snprintf(request, sizeof(request), "{\"cmd\":\"resync\"}");
+    }
+
+    sendto(sock, request, strlen(request), 0, (const struct sockaddr *) cmd_addr,
+           sizeof(*cmd_addr));
+}
+
+
+/* keeps the state, stale when it missed a delta */
+static void handle_packet(const char *buffer, int length, struct rx_stats *stats)
+{
+    cJSON *packet = cJSON_ParseWithLength(buffer, length);
+    const cJSON *id_process;
+    double seq;
+
+    if (packet == NULL)
+    {
+        return;
+    }
+
+    seq = cJSON_GetNumberValue(cJSON_GetObjectItemCaseSensitive(packet, "seq"));
+    id_process = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(
+                     cJSON_GetObjectItemCaseSensitive(packet, "rig"), "id"), "process");
 
-int main()
+    if (cJSON_IsString(id_process))
+    {
+        snprintf(process, sizeof(process), "%s", id_process->valuestring);
+    }
+
+    if (!cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(packet, "delta")))
+    {
+        /* a keyframe, or a full snapshot when not in delta mode */
+        cJSON_Delete(state);
+        state = packet;
+        last_seq = seq;
+        stale = 0;
+        stats->keyframes++;
+        return;
+    }
+
+    stats->deltas++;
+
+    if (state == NULL)
+    {
+        cJSON_Delete(packet);
+        stale = 1;
+        return;
+    }
+
+    if (seq != last_seq + 1)
+    {
+        stats->gaps++;
+        stale = 1;
+    }
+
+    /* the fields in a delta are whole values, so use them even when stale */
+    apply_delta(packet);
+    last_seq = seq;
+    cJSON_Delete(packet);
+}
+
+
+static void print_state(const struct rx_stats *stats)
+{
+    double seconds = stats->last_ms > 0 ? stats->last_ms / 1000 : 1;
+    const cJSON *vfo = cJSON_GetArrayItem(cJSON_GetObjectItemCaseSensitive(state,
+                                          "vfos"), 0);
+    const cJSON *vfos;
+    int ptt = 0;
+
+    cJSON_ArrayForEach(vfos, cJSON_GetObjectItemCaseSensitive(state, "vfos"))
+    {
+        ptt |= cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(vfos, "ptt"));
+    }
+
+    printf("{\"seconds\":%.1f,\"packets\":%lu,\"keyframes\":%lu,\"deltas\":%lu,"
+           "\"bytes\":%lu,\"bytes_per_s\":%.1f,\"packets_per_s\":%.1f,"
+           "\"gaps\":%lu,\"resyncs\":%lu,\"dropped\":%lu,\"cpu_ms\":%.1f,"
+           "\"stale\":%d,\"freq\":%.0f,\"ptt\":%d}\n",
+           seconds, stats->packets, stats->keyframes, stats->deltas, stats->bytes,
+           (double) stats->bytes / seconds, (double) stats->packets / seconds,
+           stats->gaps, stats->resyncs, stats->dropped,
+           clock() * 1000.0 / CLOCKS_PER_SEC, state == NULL || stale,
+           cJSON_GetNumberValue(cJSON_GetObjectItemCaseSensitive(vfo, "freq")), ptt);
+}
+
+
+static void usage(void)
+{
+    printf("Usage: rigtestmcastrx [-a addr] [-p port] [-c cmd_addr] [-P cmd_port] "
+           "[-d seconds] [-l n] [-q]\n");
+}
+
+
+int main(int argc, char *argv[])
 {
     int sock;
-    struct sockaddr_in mcast_addr;
+    struct sockaddr_in mcast_addr, cmd_addr;
     char buffer[BUFFER_SIZE];
     int bytes_received;
+    const char *addr = MCAST_ADDR;
+    const char *cmd = MCAST_CMD_ADDR;
+    int port = MCAST_PORT;
+    int cmd_port = MCAST_PORT;
+    int seconds = 0;
+    int drop_every = 0;
+    int quiet = 0;
+    struct rx_stats stats;
+    struct timespec start, resync_time;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:p:c:P:d:l:qh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a': addr = optarg; break;
+
+        case 'p': port = atoi(optarg); break;
+
+        case 'c': cmd = optarg; break;
+
+        case 'P': cmd_port = atoi(optarg); break;
+
+        case 'd': seconds = atoi(optarg); break;
+
+        case 'l': drop_every = atoi(optarg); break;
+
+        case 'q': quiet = 1; break;
+
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
 
 #ifdef _WIN32
     WSADATA wsaData;
@@ -58,7 +313,7 @@ int main()
 
     memset(&mcast_addr, 0, sizeof(mcast_addr));
     mcast_addr.sin_family = AF_INET;
-    mcast_addr.sin_port = htons(MCAST_PORT);
+    mcast_addr.sin_port = htons(port);
     mcast_addr.sin_addr.s_addr = htonl(INADDR_ANY);
 
     if (bind(sock, (struct sockaddr *)&mcast_addr, sizeof(mcast_addr)) < 0)
@@ -69,7 +324,7 @@ int main()
 
     struct ip_mreq mreq;
 
-    mreq.imr_multiaddr.s_addr = inet_addr(MCAST_ADDR);
+    mreq.imr_multiaddr.s_addr = inet_addr(addr);
 
     mreq.imr_interface.s_addr = htonl(INADDR_ANY);
 
@@ -80,18 +335,75 @@ int main()
         exit(EXIT_FAILURE);
     }
 
-    while (1)
+    memset(&cmd_addr, 0, sizeof(cmd_addr));
+    cmd_addr.sin_family = AF_INET;
+    cmd_addr.sin_port = htons(cmd_port);
+    cmd_addr.sin_addr.s_addr = inet_addr(cmd);
+
+    memset(&stats, 0, sizeof(stats));
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    elapsed_ms(&resync_time, HAMLIB_ELAPSED_SET);
+
+    while (seconds == 0 || elapsed_ms(&start, HAMLIB_ELAPSED_GET) < seconds * 1000.0)
     {
-        bytes_received = recvfrom(sock, buffer, BUFFER_SIZE, 0, NULL, 0);
+        struct timeval timeout;
+        fd_set rfds;
+        int ready;
+
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000;
+        FD_ZERO(&rfds);
+        FD_SET(sock, &rfds);
 
-        if (bytes_received < 0)
+        ready = select(sock + 1, &rfds, NULL, NULL, &timeout);
+
+        if (ready > 0)
+        {
+            bytes_received = recvfrom(sock, buffer, BUFFER_SIZE - 1, 0, NULL, 0);
+
+            if (bytes_received < 0)
+            {
+                perror("recvfrom() failed");
+                break;
+            }
+
+            buffer[bytes_received] = '\0';
+
+            if (stats.packets == 0)
+            {
+                elapsed_ms(&stats.first, HAMLIB_ELAPSED_SET);
+            }
+
+            stats.last_ms = elapsed_ms(&stats.first, HAMLIB_ELAPSED_GET);
+            stats.packets++;
+            stats.bytes += bytes_received;
+
+            if (drop_every > 0 && stats.packets % drop_every == 0)
+            {
+                stats.dropped++;
+                continue;
+            }
+
+            if (!quiet)
+            {
+                printf("%s\n", buffer);
+            }
+
+            handle_packet(buffer, bytes_received, &stats);
+        }
+
+        /* keep asking while stale, the request or its keyframe may be lost too */
+        if (stale && elapsed_ms(&resync_time, HAMLIB_ELAPSED_GET) >= RESYNC_INTERVAL_MS)
         {
-            perror("recvfrom() failed");
-            break;
+            send_resync(sock, &cmd_addr);
+            stats.resyncs++;
+            elapsed_ms(&resync_time, HAMLIB_ELAPSED_SET);
         }
+    }
 
-        buffer[bytes_received] = '\0';
-        printf("%s\n", buffer);
+    if (seconds > 0)
+    {
+        print_state(&stats);
     }
 
     // Drop membership before closing the socket
@@ -101,6 +413,7 @@ int main()
         perror("setsockopt() failed");
     }
 
+    cJSON_Delete(state);
     close(sock);
 #ifdef _WIN32
     WSACleanup();
@@ -108,4 +421,3 @@ int main()
 
     return 0;
 }
-
@@ -32,6 +32,7 @@
 #include <getopt.h>
 #include <errno.h>
 #include <signal.h>
+#include <time.h>
 
 #include <sys/types.h>          /* See NOTES */
 
@@ -60,6 +61,12 @@
 #include "rig.h"
 #include "rotctl_parse.h"
 #include "rotlist.h"
+#include "misc.h"
+
+#if !defined(__MINGW32__)
+/* the multiplexed server parses each line from a memory stream */
+#  define HAVE_MULTIPLEX 1
+#endif
 
 struct handle_data
 {
@@ -70,6 +77,9 @@ struct handle_data
 };
 
 void *handle_socket(void *arg);
+#ifdef HAVE_MULTIPLEX
+static int serve_multiplexed(ROT *rot, int sock_listen);
+#endif
 
 void usage();
 
@@ -79,7 +89,7 @@ void usage();
  * NB: do NOT use -W since it's reserved by POSIX.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "m:r:R:s:C:o:O:t:T:LuvhVlZ"
+#define SHORT_OPTIONS "m:r:R:s:C:o:O:t:T:MLuvhVlZ"
 static struct option long_options[] =
 {
     {"model",           1, 0, 'm'},
@@ -88,6 +98,7 @@ static struct option long_options[] =
     {"serial-speed",    1, 0, 's'},
     {"port",            1, 0, 't'},
     {"listen-addr",     1, 0, 'T'},
+    {"multiplex",       0, 0, 'M'},
     {"list",            0, 0, 'l'},
     {"set-conf",        1, 0, 'C'},
     {"set-azoffset",    1, 0, 'o'},
@@ -105,6 +116,7 @@ const char *portno = "4533";
 const char *src_addr = NULL;    /* INADDR_ANY */
 azimuth_t az_offset;
 elevation_t el_offset;
+int multiplex;
 
 #define MAXCONFLEN 2048
 
@@ -282,6 +294,10 @@ int main(int argc, char *argv[])
             src_addr = optarg;
             break;
 
+        case 'M':
+            multiplex = 1;
+            break;
+
         case 'o':
             if (!optarg)
             {
@@ -581,6 +597,26 @@ int main(int argc, char *argv[])
     }
 
 #endif
+#endif
+
+#ifdef HAVE_MULTIPLEX
+
+    if (multiplex)
+    {
+        retcode = serve_multiplexed(my_rot, sock_listen);
+        rot_close(my_rot);
+        rot_cleanup(my_rot);
+        return retcode;
+    }
+
+#else
+
+    if (multiplex)
+    {
+        fprintf(stderr, "-M is not supported on this platform\n");
+        exit(1);
+    }
+
 #endif
 
     /*
@@ -762,6 +798,441 @@ handle_exit:
 }
 
 
+#ifdef HAVE_MULTIPLEX
+/*
+ * Multiplexed server, -M
+ *
+ * One thread serves every client with select(), each complete line is
+ * run through rotctl_parse() as it arrives.  A client sending
+ * "\subscribe_position MS" gets a "position: AZ EL" line pushed every
+ * MS ms.  One shared poller reads the position at the rate of the
+ * fastest subscription and "p" is answered from that reading while it
+ * is fresh, so the rotator sees the same traffic for one client or for
+ * fifty.
+ */
+#define MUX_MAX_CLIENTS 256
+#define MUX_LINE_LEN 1024
+#define MUX_MIN_STREAM_MS 10
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+struct mux_client
+{
+    int sock;
+    char line[MUX_LINE_LEN];
+    int len;
+    int stream_ms;              /* 0 when not subscribed */
+    double next_push_ms;
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+};
+
+struct mux_position
+{
+    int valid;
+    azimuth_t az;
+    elevation_t el;
+    double read_ms;             /* when it was read */
+};
+
+static struct timespec mux_start;
+
+
+static double mux_now(void)
+{
+    return elapsed_ms(&mux_start, HAMLIB_ELAPSED_GET);
+}
+
+
+/* the fastest subscription in ms, 0 if nobody is subscribed */
+static int mux_fastest(struct mux_client **clients)
+{
+    int fastest = 0;
+    int i;
+
+    for (i = 0; i < MUX_MAX_CLIENTS; i++)
+    {
+        if (clients[i] && clients[i]->stream_ms
+                && (!fastest || clients[i]->stream_ms < fastest))
+        {
+            fastest = clients[i]->stream_ms;
+        }
+    }
+
+    return fastest;
+}
+
+
+static void mux_drop(struct mux_client **clients, int i)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "Connection closed from %s:%s\n",
+              clients[i]->host, clients[i]->serv);
+    close(clients[i]->sock);
+    free(clients[i]);
+    clients[i] = NULL;
+}
+
+
+/*
+ * A client that does not take its data is dropped rather than allowed
+ * to stall the others.
+ */
+static int mux_send(struct mux_client *client, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = send(client->sock, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n <= 0)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: %s:%s not reading, dropped\n", __func__,
+                      client->host, client->serv);
+            return -1;
+        }
+
+        buf += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+
+static void mux_accept(struct mux_client **clients, int sock_listen)
+{
+    struct mux_client *client;
+    struct sockaddr_storage cli_addr;
+    socklen_t clilen = sizeof(cli_addr);
+    int sock;
+    int i;
+
+    sock = accept(sock_listen, (struct sockaddr *) &cli_addr, &clilen);
+
+    if (sock < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "accept");
+        return;
+    }
+
+    for (i = 0; i < MUX_MAX_CLIENTS && clients[i]; i++)
+    {
+    }
+
+    client = i < MUX_MAX_CLIENTS && sock < FD_SETSIZE
+             ? calloc(1, sizeof(*client)) : NULL;
+
+    if (!client)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: too many clients\n", __func__);
+        close(sock);
+        return;
+    }
+
+    client->sock = sock;
+
+    if (getnameinfo((struct sockaddr const *)&cli_addr, clilen,
+                    client->host, sizeof(client->host),
+                    client->serv, sizeof(client->serv),
+                    NI_NUMERICHOST | NI_NUMERICSERV) != 0)
+    {
+        strcpy(client->host, "?");
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "Connection opened from %s:%s\n",
+              client->host, client->serv);
+    clients[i] = client;
+}
+
+
+/* returns -1 when the client is to be dropped */
+static int mux_line(ROT *rot, struct mux_client **clients,
+                    struct mux_client *client, char *line,
+                    struct mux_position *pos)
+{
+    char *out = NULL;
+    size_t out_len = 0;
+    int fastest = mux_fastest(clients);
+    int retcode = 0;
+    int ms;
+    FILE *fin, *fout;
+
+    if (sscanf(line, "\\subscribe_position %d", &ms) == 1)
+    {
+        char reply[32];
+
+        if (ms != 0 && ms < MUX_MIN_STREAM_MS)
+        {
+            SNPRINTF(reply, sizeof(reply), NETROTCTL_RET "%d\n", -RIG_EINVAL);
+        }
+        else
+        {
+            client->stream_ms = ms;
+            client->next_push_ms = mux_now();
+            SNPRINTF(reply, sizeof(reply), NETROTCTL_RET "0\n");
+        }
+
+        return mux_send(client, reply, strlen(reply));
+    }
+
+    if ((strcmp(line, "p") == 0 || strcmp(line, "\\get_pos") == 0)
+            && fastest > 0 && pos->valid && mux_now() - pos->read_ms < fastest)
+    {
+        char reply[64];
+
+        SNPRINTF(reply, sizeof(reply), "%.2f\n%.2f\n", pos->az, pos->el);
+        return mux_send(client, reply, strlen(reply));
+    }
+
+    strcat(line, "\n");
+    fin = fmemopen(line, strlen(line), "r");
+    fout = open_memstream(&out, &out_len);
+
+    if (!fin || !fout)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __func__, strerror(errno));
+
+        if (fin) { fclose(fin); }
+
+        if (fout) { fclose(fout); free(out); }
+
+        return -1;
+    }
+
+    do
+    {
+        /* scanfc() retries on a stale EINVAL */
+        errno = 0;
+        retcode = rotctl_parse(rot, fin, fout, NULL, 0, 1, 0, '\r');
+    }
+    while (retcode == 0 || retcode == 2);
+
+    fclose(fin);
+    fclose(fout);
+
+    if (out_len > 0 && mux_send(client, out, out_len) < 0)
+    {
+        retcode = 1;
+    }
+
+    free(out);
+
+    /* 'q' closes the connection */
+    return retcode == 1 ? -1 : 0;
+}
+
+
+/* poll when a push is due, push to each subscriber at its own rate */
+static void mux_stream(ROT *rot, struct mux_client **clients,
+                       struct mux_position *pos)
+{
+    int fastest = mux_fastest(clients);
+    double now = mux_now();
+    int due = 0;
+    int i;
+
+    for (i = 0; i < MUX_MAX_CLIENTS; i++)
+    {
+        if (clients[i] && clients[i]->stream_ms
+                && clients[i]->next_push_ms <= now)
+        {
+            due = 1;
+        }
+    }
+
+    if (!due)
+    {
+        return;
+    }
+
+    if (!pos->valid || now - pos->read_ms >= fastest)
+    {
+        int retcode = rot_get_position(rot, &pos->az, &pos->el);
+
+        now = mux_now();
+
+        if (retcode != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: rot_get_position: %s\n", __func__,
+                      rigerror(retcode));
+            pos->valid = 0;
+        }
+        else
+        {
+            pos->valid = 1;
+            pos->read_ms = now;
+        }
+    }
+
+    for (i = 0; i < MUX_MAX_CLIENTS; i++)
+    {
+        struct mux_client *client = clients[i];
+        char line[64];
+
+        if (!client || !client->stream_ms || client->next_push_ms > now)
+        {
+            continue;
+        }
+
+        /* fixed rate, missed pushes are not made up */
+        client->next_push_ms += client->stream_ms;
+
+        if (client->next_push_ms < now)
+        {
+            client->next_push_ms = now + client->stream_ms;
+        }
+
+        if (pos->valid)
+        {
+            SNPRINTF(line, sizeof(line), "position: %.2f %.2f\n", pos->az, pos->el);
+        }
+        else
+        {
+            SNPRINTF(line, sizeof(line), NETROTCTL_RET "%d\n", -RIG_EIO);
+        }
+
+        if (mux_send(client, line, strlen(line)) < 0)
+        {
+            mux_drop(clients, i);
+        }
+    }
+}
+
+
+static int serve_multiplexed(ROT *rot, int sock_listen)
+{
+    struct mux_client *clients[MUX_MAX_CLIENTS] = { NULL };
+    struct mux_position pos = { 0 };
+
+    elapsed_ms(&mux_start, HAMLIB_ELAPSED_SET);
+
+    while (1)
+    {
+        struct timeval tv, *ptv = NULL;
+        double now = mux_now();
+        double next_ms = 0;
+        int streaming = 0;
+        fd_set rfds;
+        int maxfd = sock_listen;
+        int i;
+
+        FD_ZERO(&rfds);
+        FD_SET(sock_listen, &rfds);
+
+        for (i = 0; i < MUX_MAX_CLIENTS; i++)
+        {
+            struct mux_client *client = clients[i];
+
+            if (!client)
+            {
+                continue;
+            }
+
+            FD_SET(client->sock, &rfds);
+
+            if (client->sock > maxfd)
+            {
+                maxfd = client->sock;
+            }
+
+            if (client->stream_ms && (!streaming || client->next_push_ms < next_ms))
+            {
+                next_ms = client->next_push_ms;
+                streaming = 1;
+            }
+        }
+
+        /* wait for the next push, or just for the clients */
+        if (streaming)
+        {
+            double wait_ms = next_ms > now ? next_ms - now : 0;
+
+            tv.tv_sec = (long)(wait_ms / 1000);
+            tv.tv_usec = (long)((wait_ms - tv.tv_sec * 1000.0) * 1000);
+            ptv = &tv;
+        }
+
+        if (select(maxfd + 1, &rfds, NULL, NULL, ptv) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            handle_error(RIG_DEBUG_ERR, "select");
+            return 1;
+        }
+
+        if (FD_ISSET(sock_listen, &rfds))
+        {
+            mux_accept(clients, sock_listen);
+        }
+
+        for (i = 0; i < MUX_MAX_CLIENTS; i++)
+        {
+            struct mux_client *client = clients[i];
+            char *nl;
+            ssize_t n;
+
+            if (!client || !FD_ISSET(client->sock, &rfds))
+            {
+                continue;
+            }
+
+            /* room for the newline mux_line() puts back */
+            n = recv(client->sock, client->line + client->len,
+                     sizeof(client->line) - client->len - 2, 0);
+
+            if (n <= 0)
+            {
+                mux_drop(clients, i);
+                continue;
+            }
+
+            client->len += n;
+            client->line[client->len] = '\0';
+
+            while (clients[i] && (nl = strchr(client->line, '\n')))
+            {
+                char line[MUX_LINE_LEN];
+                int line_len = nl - client->line;
+
+                memcpy(line, client->line, line_len);
+                line[line_len] = '\0';
+
+                if (line_len > 0 && line[line_len - 1] == '\r')
+                {
+                    line[line_len - 1] = '\0';
+                }
+
+                client->len -= line_len + 1;
+                memmove(client->line, nl + 1, client->len + 1);
+
+                if (line[0] && mux_line(rot, clients, client, line, &pos) < 0)
+                {
+                    mux_drop(clients, i);
+                }
+            }
+
+            /* a line longer than the buffer is thrown away */
+            if (clients[i] && client->len >= (int) sizeof(client->line) - 2)
+            {
+                client->len = 0;
+            }
+        }
+
+        mux_stream(rot, clients, &pos);
+    }
+}
+#endif
+
+
 void usage()
 {
     printf("Usage: rotctld [OPTION]... [COMMAND]...\n"
@@ -774,6 +1245,8 @@ void usage()
         "  -s, --serial-speed=BAUD       set serial speed of the serial port\n"
         "  -t, --port=NUM                set TCP listening port, default %s\n"
         "  -T, --listen-addr=IPADDR      set listening IP address, default ANY\n"
+        "  -M, --multiplex               serve all clients from one thread, allows\n"
+        "                                \\subscribe_position streaming\n"
         "  -C, --set-conf=PARM=VAL       set config parameters\n"
         "  -o, --set-azoffset==VAL       set offset for azimuth\n"
         "  -O, --set-eloffset==VAL       set offset for elevation\n"
@@ -0,0 +1,278 @@
+/*
+ * Hamlib rotctld_bench program
+ *
+ * Connects a number of clients to rotctld, each watching the rotator
+ * position for a while, and prints one JSON object with the number of
+ * positions received and how long they took.
+ *
+ *   rotctld_bench [-T host] [-t port] [-c clients] [-i interval_ms]
+ *                 [-d seconds] [-S]
+ *
+ * Each client sends "p" every interval_ms, or with -S subscribes with
+ * "\subscribe_position interval_ms" and counts the pushed positions,
+ * which needs rotctld -M.  rotctld_bench.sh runs it against
+ * simrotorez and counts the commands the rotator had to answer.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+
+#include "misc.h"
+
+struct bench_client
+{
+    pthread_t thread;
+    int sock;
+    unsigned long positions;
+    unsigned long errors;
+    double total_ms;
+    double max_ms;
+};
+
+static const char *host = "localhost";
+static const char *port = "4533";
+static int interval_ms = 100;
+static int duration_s = 5;
+static int subscribe;
+
+
+static int bench_connect(void)
+{
+    struct addrinfo hints, *res, *ai;
+    int sock = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+    {
+        return -1;
+    }
+
+    for (ai = res; ai; ai = ai->ai_next)
+    {
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+        if (sock < 0)
+        {
+            continue;
+        }
+
+        if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+            break;
+        }
+
+        close(sock);
+        sock = -1;
+    }
+
+    freeaddrinfo(res);
+
+    return sock;
+}
+
+
+static void bench_add(struct bench_client *c, double ms)
+{
+    c->positions++;
+    c->total_ms += ms;
+
+    if (ms > c->max_ms)
+    {
+        c->max_ms = ms;
+    }
+}
+
+
+static void *bench_thread(void *arg)
+{
+    struct bench_client *c = arg;
+    struct timespec start, sent;
+    char line[128];
+    FILE *fp;
+
+    fp = fdopen(c->sock, "r+");
+
+    if (!fp)
+    {
+        c->errors++;
+        return NULL;
+    }
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    if (subscribe)
+    {
+        /* the time between pushes, compared with the interval asked for */
+        fprintf(fp, "\\subscribe_position %d\n", interval_ms);
+        fflush(fp);
+
+        if (!fgets(line, sizeof(line), fp) || strcmp(line, "RPRT 0\n") != 0)
+        {
+            c->errors++;
+            fclose(fp);
+            return NULL;
+        }
+
+        elapsed_ms(&sent, HAMLIB_ELAPSED_SET);
+
+        while (elapsed_ms(&start, HAMLIB_ELAPSED_GET) < duration_s * 1000.0
+                && fgets(line, sizeof(line), fp))
+        {
+            float az, el;
+
+            if (sscanf(line, "position: %f %f", &az, &el) == 2)
+            {
+                bench_add(c, elapsed_ms(&sent, HAMLIB_ELAPSED_GET));
+            }
+            else
+            {
+                c->errors++;
+            }
+
+            elapsed_ms(&sent, HAMLIB_ELAPSED_SET);
+        }
+    }
+    else
+    {
+        /* the round trip of each "p" */
+        while (elapsed_ms(&start, HAMLIB_ELAPSED_GET) < duration_s * 1000.0)
+        {
+            char el[64];
+            double ms;
+
+            elapsed_ms(&sent, HAMLIB_ELAPSED_SET);
+            fprintf(fp, "p\n");
+            fflush(fp);
+
+            if (!fgets(line, sizeof(line), fp) || !fgets(el, sizeof(el), fp))
+            {
+                c->errors++;
+                break;
+            }
+
+            ms = elapsed_ms(&sent, HAMLIB_ELAPSED_GET);
+
+            if (strncmp(line, "RPRT", 4) == 0)
+            {
+                c->errors++;
+            }
+            else
+            {
+                bench_add(c, ms);
+            }
+
+            if (ms < interval_ms)
+            {
+                hl_usleep((interval_ms - ms) * 1000);
+            }
+        }
+    }
+
+    fclose(fp);
+
+    return NULL;
+}
+
+
+static void usage(void)
+{
+    printf("Usage: rotctld_bench [-T host] [-t port] [-c clients] "
+           "[-i interval_ms] [-d seconds] [-S]\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+    struct bench_client *clients;
+    unsigned long positions = 0, errors = 0;
+    double total_ms = 0, max_ms = 0;
+    int nclients = 1;
+    int opt;
+    int i;
+
+    while ((opt = getopt(argc, argv, "T:t:c:i:d:Sh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'T': host = optarg; break;
+
+        case 't': port = optarg; break;
+
+        case 'c': nclients = atoi(optarg); break;
+
+        case 'i': interval_ms = atoi(optarg); break;
+
+        case 'd': duration_s = atoi(optarg); break;
+
+        case 'S': subscribe = 1; break;
+
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (nclients < 1 || interval_ms < 1 || duration_s < 1)
+    {
+        usage();
+        return 1;
+    }
+
+    clients = calloc(nclients, sizeof(*clients));
+
+    if (!clients)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < nclients; i++)
+    {
+        clients[i].sock = bench_connect();
+
+        if (clients[i].sock < 0)
+        {
+            fprintf(stderr, "cannot connect to %s:%s\n", host, port);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < nclients; i++)
+    {
+        pthread_create(&clients[i].thread, NULL, bench_thread, &clients[i]);
+    }
+
+    for (i = 0; i < nclients; i++)
+    {
+        pthread_join(clients[i].thread, NULL);
+        positions += clients[i].positions;
+        errors += clients[i].errors;
+        total_ms += clients[i].total_ms;
+
+        if (clients[i].max_ms > max_ms)
+        {
+            max_ms = clients[i].max_ms;
+        }
+    }
+
+    printf("{\"mode\":\"%s\",\"clients\":%d,\"interval_ms\":%d,"
+           "\"seconds\":%d,\"positions\":%lu,\"errors\":%lu,"
+           "\"mean_ms\":%.3f,\"max_ms\":%.3f}\n",
+           subscribe ? "subscribe" : "poll", nclients, interval_ms, duration_s,
+           positions, errors, positions ? total_ms / positions : 0, max_ms);
+
+    free(clients);
+
+    return errors || !positions ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#!/bin/sh
+#
+# Run rotctld_bench against rotctld on simrotorez with 1, 10 and 50
+# clients, with a thread per client polling, multiplexed (-M) polling
+# and multiplexed with position subscriptions.  Prints the rotctld_bench
+# JSON line with the number of commands the rotator answered added, e.g.
+# from the build tree:
+#
+#   (cd simulators && make simrotorez) && (cd tests && make rotctld_bench)
+#   sh ../tests/rotctld_bench.sh > rotbench.json
+#
+# Usage: rotctld_bench.sh [interval_ms [seconds]]
+#
+# SIMDIR may be set to point at the simulators, it defaults to the
+# build tree layout.  simrotorez output is line buffered with stdbuf.
+
+SIMDIR=${SIMDIR:-../simulators}
+INTERVAL=${1:-100}
+SECONDS_RUN=${2:-5}
+PORT=45330
+OUT=rotctld_bench.sim
+
+status=0
+
+for clients in 1 10 50
+do
+    for mode in thread mux subscribe
+    do
+        stdbuf -oL "$SIMDIR/simrotorez" > $OUT 2>&1 &
+        sim=$!
+        sleep 1
+        pty=$(sed -n 's/^name=//p' $OUT | head -1)
+
+        case $mode in
+        thread)    rotd_flags= ; bench_flags= ;;
+        mux)       rotd_flags=-M ; bench_flags= ;;
+        subscribe) rotd_flags=-M ; bench_flags=-S ;;
+        esac
+
+        # RT-21, the protocol simrotorez answers
+        ./rotctld -m 405 -r "$pty" -t $PORT $rotd_flags &
+        rotd=$!
+        sleep 1
+
+        result=$(./rotctld_bench -t $PORT -c $clients -i $INTERVAL \
+                 -d $SECONDS_RUN $bench_flags) || status=1
+
+        kill $rotd $sim
+        wait $rotd $sim 2>/dev/null
+
+        commands=$(grep -c '^line\[' $OUT)
+        echo "$result" | sed "s/}\$/,\"daemon\":\"$mode\",\"rotator_commands\":$commands}/"
+        PORT=$((PORT + 1))
+    done
+done
+
+rm -f $OUT
+
+exit $status
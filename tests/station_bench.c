@@ -0,0 +1,464 @@
+/*
+ * Hamlib station_bench program
+ *
+ * Runs a station of a rig, a rotator and an amplifier and prints one JSON
+ * object with the threads the library runs, how often they wake up and
+ * the latency of the rig:
+ *
+ *   station_bench [-s rig_simulator] [-o rot_simulator] [-d seconds] [-S|-F]
+ *
+ * The rig is an IC-7300 simulator with async data on, so its frames are
+ * read by a reader of their own and its state published by the poll
+ * routine, the rotator a SPID simulator following a slow pass with the
+ * trajectory tracker and the amplifier the dummy one with two levels
+ * polled, e.g. from the build tree:
+ *
+ *   station_bench -s ../simulators/simic7300 -o ../simulators/simspid -S
+ *
+ * By default every handle runs its own threads.  With -S the handles are
+ * added to a station that runs them on its thread, with -F the station
+ * is run on the main loop of the benchmark through rig_station_get_fd().
+ *
+ * For the given seconds the benchmark only waits, and the wakeups are the
+ * context switches of all its threads.  Then it reads the frequency with
+ * the cache off and reports the round trip through the frame reader, and
+ * with a station the latest a timer of its loop and a poll of its I/O
+ * thread ran.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include <hamlib/amplifier.h>
+#include <sys/time.h>
+#include "misc.h"
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <sys/wait.h>
+#include <sys/select.h>
+#define HAVE_SIMULATOR_LAUNCH 1
+#endif
+
+#define RUN_SECONDS 5
+#define FREQ_READS 20
+#define PASS_POINTS 10
+
+#define MODE_THREADS 0
+#define MODE_STATION 1
+#define MODE_MAINLOOP 2
+
+static const char *mode_names[] = { "threads", "station", "mainloop" };
+
+
+static double now_ms(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+
+/*
+ * Threads of the process and the context switches they made, -1 without
+ * a /proc to read them from.
+ */
+static int task_stats(unsigned long *switches)
+{
+    struct dirent *d;
+    DIR *dir;
+    int tasks = 0;
+
+    *switches = 0;
+    dir = opendir("/proc/self/task");
+
+    if (!dir)
+    {
+        return -1;
+    }
+
+    while ((d = readdir(dir)) != NULL)
+    {
+        char path[300], line[128];
+        unsigned long n;
+        FILE *fp;
+
+        if (d->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        tasks++;
+        SNPRINTF(path, sizeof(path), "/proc/self/task/%s/status", d->d_name);
+        fp = fopen(path, "r");
+
+        if (!fp)
+        {
+            continue;
+        }
+
+        while (fgets(line, sizeof(line), fp))
+        {
+            if (sscanf(line, "voluntary_ctxt_switches: %lu", &n) == 1
+                    || sscanf(line, "nonvoluntary_ctxt_switches: %lu", &n) == 1)
+            {
+                *switches += n;
+            }
+        }
+
+        fclose(fp);
+    }
+
+    closedir(dir);
+
+    return tasks;
+}
+
+
+#ifdef HAVE_SIMULATOR_LAUNCH
+/*
+ * Start a simulator with its output on a pty, so it is line buffered,
+ * and return the first pty device it reports with "name=...".  The pty
+ * is closed then, the simulator ignores the hangup and its debug output
+ * is dropped without a thread of the benchmark to read it.
+ */
+static pid_t sim_start(const char *path, char *pts, size_t pts_len)
+{
+    char line[256];
+    int master;
+    int len = 0;
+    pid_t pid;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+    {
+        perror("posix_openpt");
+        return -1;
+    }
+
+    pid = fork();
+
+    if (pid < 0)
+    {
+        perror("fork");
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        int slave = open(ptsname(master), O_RDWR);
+
+        if (slave < 0)
+        {
+            _exit(127);
+        }
+
+        setsid();
+        signal(SIGHUP, SIG_IGN);
+        dup2(slave, 1);
+        dup2(slave, 2);
+        close(master);
+        execl(path, path, "", "", (char *)NULL);
+        _exit(127);
+    }
+
+    while (len < sizeof(line) - 1)
+    {
+        fd_set rfds;
+        struct timeval tv = { 5, 0 };
+        char c;
+
+        FD_ZERO(&rfds);
+        FD_SET(master, &rfds);
+
+        if (select(master + 1, &rfds, NULL, NULL, &tv) <= 0
+                || read(master, &c, 1) != 1)
+        {
+            fprintf(stderr, "%s did not report its pty\n", path);
+            kill(pid, SIGTERM);
+            waitpid(pid, NULL, 0);
+            close(master);
+            return -1;
+        }
+
+        if (c == '\r')
+        {
+            continue;
+        }
+
+        if (c != '\n')
+        {
+            line[len++] = c;
+            continue;
+        }
+
+        line[len] = '\0';
+        len = 0;
+
+        if (strncmp(line, "name=", 5) == 0)
+        {
+            SNPRINTF(pts, pts_len, "%s", line + 5);
+            break;
+        }
+    }
+
+    close(master);
+
+    return pid;
+}
+
+static void sim_stop(pid_t pid)
+{
+    if (pid > 0)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+    }
+}
+#endif
+
+
+/* waits, running the station on this loop with -F */
+static void idle_for(hamlib_station_t *st, int fd, double ms)
+{
+    double end = now_ms() + ms;
+    double left;
+
+    while ((left = end - now_ms()) > 0)
+    {
+        if (fd >= 0)
+        {
+            fd_set rfds;
+            struct timeval tv;
+
+            tv.tv_sec = (long)(left / 1000);
+            tv.tv_usec = (long)((left - tv.tv_sec * 1000.0) * 1000);
+            FD_ZERO(&rfds);
+            FD_SET(fd, &rfds);
+
+            if (select(fd + 1, &rfds, NULL, NULL, &tv) > 0)
+            {
+                rig_station_dispatch(st, 0);
+            }
+        }
+        else
+        {
+            hl_usleep((int)(left * 1000));
+        }
+    }
+}
+
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: station_bench [-s rig_simulator] [-o rot_simulator] "
+            "[-d seconds] [-S|-F]\n");
+    exit(2);
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *rig_sim = "../simulators/simic7300";
+    const char *rot_sim = "../simulators/simspid";
+    rot_track_point_t pass[PASS_POINTS];
+    hamlib_station_stats_t stats;
+    rot_track_status_t track;
+    hamlib_amp_cache_stats_t amp_stats;
+    unsigned long sw_start, sw_end;
+    char rig_port[HAMLIB_FILPATHLEN];
+    char rot_port[HAMLIB_FILPATHLEN];
+    hamlib_station_t *st = NULL;
+    double start, cat_total = 0, cat_max = 0, idle_ms;
+    int seconds = RUN_SECONDS;
+    int mode = MODE_THREADS;
+    int fd = -1;
+    int threads, reads = 0;
+    pid_t rig_pid, rot_pid;
+    freq_t freq;
+    int status = 0;
+    int i, c;
+    RIG *rig;
+    ROT *rot;
+    AMP *amp;
+
+    while ((c = getopt(argc, argv, "s:o:d:SF")) != -1)
+    {
+        switch (c)
+        {
+        case 's': rig_sim = optarg; break;
+
+        case 'o': rot_sim = optarg; break;
+
+        case 'd': seconds = atoi(optarg); break;
+
+        case 'S': mode = MODE_STATION; break;
+
+        case 'F': mode = MODE_MAINLOOP; break;
+
+        default: usage();
+        }
+    }
+
+#ifdef HAVE_SIMULATOR_LAUNCH
+    rig_set_debug(RIG_DEBUG_NONE);
+    rig_pid = sim_start(rig_sim, rig_port, sizeof(rig_port));
+    rot_pid = sim_start(rot_sim, rot_port, sizeof(rot_port));
+
+    if (rig_pid < 0 || rot_pid < 0)
+    {
+        sim_stop(rig_pid);
+        sim_stop(rot_pid);
+        return 1;
+    }
+
+    rig = rig_init(RIG_MODEL_IC7300);
+    rot = rot_init(ROT_MODEL_SPID_ROT2PROG);
+    amp = amp_init(AMP_MODEL_DUMMY);
+
+    if (!rig || !rot || !amp)
+    {
+        fprintf(stderr, "cannot create the handles\n");
+        sim_stop(rig_pid);
+        sim_stop(rot_pid);
+        return 1;
+    }
+
+    rig_set_conf(rig, rig_token_lookup(rig, "rig_pathname"), rig_port);
+    rig_set_conf(rig, rig_token_lookup(rig, "async"), "1");
+    rot_set_conf(rot, rot_token_lookup(rot, "rot_pathname"), rot_port);
+
+    if (mode != MODE_THREADS)
+    {
+        st = rig_station_new();
+
+        if (!st || rig_station_add_rig(st, rig) != RIG_OK
+                || rig_station_add_rot(st, rot) != RIG_OK
+                || rig_station_add_amp(st, amp) != RIG_OK)
+        {
+            fprintf(stderr, "cannot set up the station\n");
+            status = 1;
+            goto out;
+        }
+
+        if (mode == MODE_STATION)
+        {
+            rig_station_start(st);
+        }
+        else if ((fd = rig_station_get_fd(st)) < 0)
+        {
+            fprintf(stderr, "no station fd: %s\n", rigerror(fd));
+            status = 1;
+            goto out;
+        }
+    }
+
+    if (rig_open(rig) != RIG_OK || rot_open(rot) != RIG_OK
+            || amp_open(amp) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open the station\n");
+        status = 1;
+        goto out;
+    }
+
+    amp_set_conf(amp, amp_token_lookup(amp, "poll_levels"),
+                 "PWRFORWARD:500/SWR:500");
+
+    /* a slow pass over the run, one move per deadband */
+    start = now_ms() / 1000;
+
+    for (i = 0; i < PASS_POINTS; i++)
+    {
+        pass[i].time = start + (seconds + 2) * i / (PASS_POINTS - 1.0);
+        pass[i].az = 100 + 20.0 * i / (PASS_POINTS - 1);
+        pass[i].el = 10 + 10.0 * i / (PASS_POINTS - 1);
+    }
+
+    rot_track_start(rot, pass, PASS_POINTS);
+
+    /* let the handles settle into their polls */
+    idle_for(st, fd, 1000);
+
+    task_stats(&sw_start);
+    start = now_ms();
+    idle_for(st, fd, seconds * 1000);
+    idle_ms = now_ms() - start;
+    threads = task_stats(&sw_end);
+
+    /* the round trip of a read through the frame reader */
+    rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, 0);
+
+    for (i = 0; i < FREQ_READS; i++)
+    {
+        double t0 = now_ms();
+
+        if (rig_get_freq(rig, RIG_VFO_A, &freq) == RIG_OK)
+        {
+            double ms = now_ms() - t0;
+
+            cat_total += ms;
+            reads++;
+
+            if (ms > cat_max)
+            {
+                cat_max = ms;
+            }
+        }
+
+        idle_for(st, fd, 50);
+    }
+
+    rot_track_get_status(rot, &track);
+    amp_get_cache_stats(amp, &amp_stats);
+    memset(&stats, 0, sizeof(stats));
+
+    if (st)
+    {
+        rig_station_get_stats(st, &stats);
+    }
+
+    printf("{\"mode\":\"%s\",\"threads\":%d,\"wakeups_per_s\":%.1f,"
+           "\"freq_reads\":%d,\"cat_ms_avg\":%.2f,\"cat_ms_max\":%.2f,"
+           "\"timer_late_ms_max\":%.2f,\"io_late_ms_max\":%.2f,"
+           "\"station_wakeups\":%lu,\"rot_commands\":%lu,\"amp_polls\":%lu}\n",
+           mode_names[mode], threads - 1,
+           threads > 0 ? (sw_end - sw_start) * 1000.0 / idle_ms : -1.0,
+           reads, reads ? cat_total / reads : 0.0, cat_max, stats.max_late_ms,
+           stats.io_max_late_ms, stats.wakeups, track.commands, amp_stats.polls);
+
+    if (reads < FREQ_READS || track.commands == 0 || amp_stats.polls == 0)
+    {
+        fprintf(stderr, "%s: the station did not run\n", mode_names[mode]);
+        status = 1;
+    }
+
+    rot_track_stop(rot);
+    amp_close(amp);
+    rot_close(rot);
+    rig_close(rig);
+
+out:
+    rig_station_free(st);
+    amp_cleanup(amp);
+    rot_cleanup(rot);
+    rig_cleanup(rig);
+    sim_stop(rig_pid);
+    sim_stop(rot_pid);
+
+    return status;
+#else
+    fprintf(stderr, "station_bench needs the simulators, not on this platform\n");
+    return 1;
+#endif
+}
@@ -0,0 +1,47 @@
+#!/bin/sh
+#
+# Run station_bench with per-handle threads, with a station thread and
+# with the station on the main loop of the benchmark, and print the
+# station_bench JSON line of each, e.g. from the build tree:
+#
+#   (cd simulators && make simic7300 simspid)
+#   (cd tests && make station_bench)
+#   sh ../tests/station_bench.sh > station.json
+#
+# The run fails if a station does not run the rig, the rotator and the
+# amplifier on fewer threads than the handles do on their own.
+#
+# Usage: station_bench.sh [seconds]
+
+SECONDS_RUN=${1:-5}
+SIMDIR=${SIMDIR:-../simulators}
+STATION_BENCH=${STATION_BENCH:-./station_bench}
+
+status=0
+own=0
+
+for mode in "" -S -F
+do
+    result=$($STATION_BENCH -s "$SIMDIR/simic7300" -o "$SIMDIR/simspid" -d $SECONDS_RUN $mode 2>/dev/null | tail -1)
+    threads=$(echo "$result" | sed -n 's/.*"threads":\([0-9]*\).*/\1/p')
+
+    if [ -z "$threads" ]
+    then
+        echo "station_bench $mode: no result" >&2
+        status=1
+        continue
+    fi
+
+    echo "$result"
+
+    if [ -z "$mode" ]
+    then
+        own=$threads
+    elif [ "$threads" -ge "$own" ]
+    then
+        echo "station_bench $mode: $threads threads, $own without a station" >&2
+        status=1
+    fi
+done
+
+exit $status
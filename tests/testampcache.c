@@ -0,0 +1,241 @@
+/*
+ * testampcache - amplifier level cache and poller test
+ *
+ * Runs the Elecraft KPA backend against a simulated KPA500 on a pty that
+ * takes AMP_LATENCY ms per command and counts the commands it answers.
+ * A dashboard reading power, SWR, fault and power status for a few
+ * clients is run without the cache, with a cache timeout and with the
+ * levels polled in the background.  Checks the values, that polled
+ * levels are served from the cache with their age and that the link
+ * load no longer grows with the number of clients.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <hamlib/amplifier.h>
+#include "misc.h"
+#include "testcheck.h"
+
+#define AMP_LATENCY 5
+#define CLIENTS 4
+#define ROUNDS 10
+#define ROUND_MS 50
+
+static int sim_fd = -1;
+static volatile int sim_stop;
+static volatile unsigned long sim_commands;
+
+static void sim_reply(const char *cmd)
+{
+    const char *reply;
+
+    if (cmd[0] == '\0')
+    {
+        reply = ";";            /* wake up */
+    }
+    else
+    {
+        sim_commands++;
+        hl_usleep(AMP_LATENCY * 1000);
+
+        if (strcmp(cmd, "^AE") == 0) { reply = "^AE1;"; }
+        else if (strcmp(cmd, "^SW") == 0) { reply = "^SW015;"; }
+        else if (strcmp(cmd, "^PWF") == 0) { reply = "^PWF0500;"; }
+        else if (strcmp(cmd, "^PWR") == 0) { reply = "^PWR0012;"; }
+        else if (strcmp(cmd, "^SF") == 0) { reply = "^SF00;"; }
+        else if (strcmp(cmd, "^ON") == 0) { reply = "^ON1;"; }
+        else if (strcmp(cmd, "^OS") == 0) { reply = "^OS1;"; }
+        else if (strcmp(cmd, "^FR") == 0) { reply = "^FR14074;"; }
+        else { return; }        /* sets are not answered */
+    }
+
+    if (write(sim_fd, reply, strlen(reply)) < 0)
+    {
+        perror("write");
+    }
+}
+
+
+/* a KPA500 answering the commands of the backend */
+static void *sim_thread(void *arg)
+{
+    char cmd[64];
+    int len = 0;
+
+    while (!sim_stop)
+    {
+        char c;
+        ssize_t n = read(sim_fd, &c, 1);
+
+        if (n <= 0)
+        {
+            hl_usleep(1000);
+            continue;
+        }
+
+        if (c != ';')
+        {
+            if (len < (int) sizeof(cmd) - 1)
+            {
+                cmd[len++] = c;
+            }
+
+            continue;
+        }
+
+        cmd[len] = '\0';
+        len = 0;
+        sim_reply(cmd);
+    }
+
+    return NULL;
+}
+
+
+static const char *sim_open(void)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0)
+    {
+        return NULL;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    sim_fd = fd;
+
+    return ptsname(fd);
+}
+
+
+/* CLIENTS clients reading the dashboard every ROUND_MS, commands sent */
+static unsigned long dashboard(AMP *amp, int *errors)
+{
+    unsigned long start = sim_commands;
+    powerstat_t stat;
+    value_t val;
+    int round, client;
+
+    *errors = 0;
+
+    for (round = 0; round < ROUNDS; round++)
+    {
+        for (client = 0; client < CLIENTS; client++)
+        {
+            *errors += amp_get_level(amp, AMP_LEVEL_PWR_FWD, &val) != RIG_OK
+                       || val.i != 500;
+            *errors += amp_get_level(amp, AMP_LEVEL_SWR, &val) != RIG_OK
+                       || val.f != 1.5f;
+            *errors += amp_get_level(amp, AMP_LEVEL_FAULT, &val) != RIG_OK
+                       || strcmp(val.s, "No fault condition") != 0;
+            *errors += amp_get_powerstat(amp, &stat) != RIG_OK
+                       || stat != RIG_POWER_OPERATE;
+        }
+
+        hl_usleep(ROUND_MS * 1000);
+    }
+
+    return sim_commands - start;
+}
+
+
+int main(int argc, char *argv[])
+{
+    hamlib_amp_cache_stats_t stats;
+    unsigned long direct, cached, polled, before;
+    pthread_t sim;
+    powerstat_t stat;
+    const char *path;
+    double age_ms;
+    value_t val;
+    char buf[128];
+    int errors;
+    AMP *amp;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    path = sim_open();
+
+    if (!path || pthread_create(&sim, NULL, sim_thread, NULL))
+    {
+        fprintf(stderr, "cannot start the KPA500 simulator\n");
+        return 1;
+    }
+
+    amp_load_all_backends();
+    amp = amp_init(AMP_MODEL_ELECRAFT_KPA1500);
+
+    if (!amp)
+    {
+        return 1;
+    }
+
+    amp_set_conf(amp, amp_token_lookup(amp, "amp_pathname"), path);
+
+    if (amp_open(amp) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open the amplifier on %s\n", path);
+        return 1;
+    }
+
+    direct = dashboard(amp, &errors);
+    check(errors == 0, "values read without the cache");
+
+    amp_set_conf(amp, amp_token_lookup(amp, "cache_timeout"), "200");
+    cached = dashboard(amp, &errors);
+    check(errors == 0, "values read through the cache");
+    check(cached < direct / 2, "cache timeout saves commands");
+
+    /* polled levels served from the cache whatever the number of clients */
+    amp_set_conf(amp, amp_token_lookup(amp, "cache_timeout"), "0");
+    check(amp_set_conf(amp, amp_token_lookup(amp, "poll_levels"),
+                       "PWRFORWARD:100/SWR:250/FAULT/POWERSTAT:500") == RIG_OK,
+          "poll levels set");
+    amp_get_conf(amp, amp_token_lookup(amp, "poll_levels"), buf);
+    check(strcmp(buf, "SWR:250/PWRFORWARD:100/FAULT/POWERSTAT:500") == 0,
+          "poll levels read back");
+    hl_usleep(300 * 1000);
+
+    amp_get_cache_stats(amp, &stats);
+    before = stats.misses;
+    polled = dashboard(amp, &errors);
+    amp_get_cache_stats(amp, &stats);
+    check(errors == 0, "values polled");
+    check(stats.misses == before, "polled levels served from the cache");
+    check(stats.polls > 0 && stats.poll_errors == 0, "poller reads the levels");
+    check(polled < direct / CLIENTS, "polling takes the clients off the link");
+
+    check(amp_get_level_cached(amp, AMP_LEVEL_PWR_FWD, &val, &age_ms) == RIG_OK
+          && val.i == 500 && age_ms < 200, "polled level age");
+    check(amp_get_powerstat_cached(amp, &stat, &age_ms) == RIG_OK
+          && stat == RIG_POWER_OPERATE && age_ms < 1000, "polled power status age");
+
+    printf("commands: direct=%lu cached=%lu polled=%lu for %d clients, "
+           "hits=%lu misses=%lu polls=%lu max_age_ms=%.0f\n", direct, cached,
+           polled, CLIENTS, stats.hits, stats.misses, stats.polls,
+           stats.max_age_ms);
+
+    check(amp_set_conf(amp, amp_token_lookup(amp, "poll_levels"),
+                       "PWRFORWARD:0") == -RIG_EINVAL, "bad interval");
+    check(amp_set_conf(amp, amp_token_lookup(amp, "poll_levels"),
+                       "TEMP") == -RIG_EINVAL, "bad level");
+
+    /* closing stops the poller */
+    amp_close(amp);
+    before = sim_commands;
+    hl_usleep(300 * 1000);
+    check(sim_commands == before, "no polls after close");
+
+    amp_cleanup(amp);
+    sim_stop = 1;
+    pthread_join(sim, NULL);
+    close(sim_fd);
+
+    return failures ? 1 : 0;
+}
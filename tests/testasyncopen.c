@@ -0,0 +1,217 @@
+/*
+ * testasyncopen - asynchronous rig_open() and rig_close() test
+ *
+ * Opens and closes the dummy rig, slowed down to a CAT link taking
+ * CMD_LATENCY ms per command, first with rig_open() and rig_close() and
+ * then with rig_open_async() and rig_close_async() while polling the
+ * rig every FRAME_MS ms as a GUI would.  Reports how long the polling
+ * thread was blocked each way, and checks the steps reported, that the
+ * polls were answered from the cache, and that a cancelled open closes
+ * the rig again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "testcheck.h"
+
+#define CMD_LATENCY "50"
+#define FRAME_MS 10
+
+static rig_open_step_t steps[16];
+static int nsteps;
+static int done_retval;
+static int cancel_at = -1;
+
+static void progress(RIG *rig, rig_open_step_t step, int retval, rig_ptr_t arg)
+{
+    if (nsteps < 16)
+    {
+        steps[nsteps++] = step;
+    }
+
+    if (step == RIG_OPEN_STEP_DONE)
+    {
+        done_retval = retval;
+    }
+
+    if ((int)step == cancel_at)
+    {
+        rig_open_cancel(rig);
+    }
+}
+
+
+static int reported(rig_open_step_t step)
+{
+    int i;
+
+    for (i = 0; i < nsteps; i++)
+    {
+        if (steps[i] == step)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* what a GUI reads every frame */
+static double poll_rig(RIG *rig, double *max_call_ms)
+{
+    struct timespec call;
+    double ms;
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    ptt_t ptt;
+    vfo_t vfo, tx_vfo;
+    split_t split;
+
+    elapsed_ms(&call, HAMLIB_ELAPSED_SET);
+    rig_get_freq(rig, RIG_VFO_A, &freq);
+    rig_get_mode(rig, RIG_VFO_A, &mode, &width);
+    rig_get_ptt(rig, RIG_VFO_CURR, &ptt);
+    rig_get_vfo(rig, &vfo);
+    rig_get_split_vfo(rig, RIG_VFO_CURR, &split, &tx_vfo);
+    ms = elapsed_ms(&call, HAMLIB_ELAPSED_GET);
+
+    if (ms > *max_call_ms)
+    {
+        *max_call_ms = ms;
+    }
+
+    return ms;
+}
+
+
+/* starts an async open or close and polls until it ends */
+static int run_async(RIG *rig, int closing, double *blocked_ms,
+                     double *max_call_ms, int *polls)
+{
+    struct timespec call;
+    int retval;
+
+    nsteps = 0;
+    *max_call_ms = 0;
+    *polls = 0;
+    elapsed_ms(&call, HAMLIB_ELAPSED_SET);
+    retval = closing ? rig_close_async(rig, progress, NULL)
+             : rig_open_async(rig, progress, NULL);
+    *blocked_ms = elapsed_ms(&call, HAMLIB_ELAPSED_GET);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    while (rig_open_wait(rig, 0) == -RIG_ETIMEOUT)
+    {
+        *blocked_ms += poll_rig(rig, max_call_ms);
+        (*polls)++;
+        hl_usleep(FRAME_MS * 1000);
+    }
+
+    return rig_open_wait(rig, 0);
+}
+
+
+int main(int argc, char *argv[])
+{
+    double open_ms, close_ms, blocked_ms, max_call_ms;
+    struct timespec start;
+    freq_t freq;
+    int polls;
+    int retval;
+    int i;
+    RIG *rig;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    rig = rig_init(RIG_MODEL_DUMMY);
+
+    if (!rig)
+    {
+        return 1;
+    }
+
+    rig_set_conf(rig, rig_token_lookup(rig, "cmd_latency"), CMD_LATENCY);
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    retval = rig_open(rig);
+    open_ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+
+    if (retval != RIG_OK)
+    {
+        fprintf(stderr, "cannot open the dummy rig\n");
+        return 1;
+    }
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    rig_close(rig);
+    close_ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    printf("sync: open_ms=%.0f close_ms=%.0f\n", open_ms, close_ms);
+
+    retval = run_async(rig, 0, &blocked_ms, &max_call_ms, &polls);
+    printf("async open: blocked_ms=%.1f max_call_ms=%.2f polls=%d\n",
+           blocked_ms, max_call_ms, polls);
+
+    check(retval == RIG_OK && done_retval == RIG_OK, "async open succeeded");
+    check(rig->state.comm_state, "rig open");
+    check(polls > 0, "polled while opening");
+    check(max_call_ms < atoi(CMD_LATENCY) / 2, "polls answered from the cache");
+    check(blocked_ms < open_ms / 10, "async open does not block");
+    check(nsteps > 0 && steps[0] == RIG_OPEN_STEP_PORT
+          && steps[nsteps - 1] == RIG_OPEN_STEP_DONE, "first and last step");
+
+    for (i = 1; i < nsteps; i++)
+    {
+        check(steps[i] > steps[i - 1], "steps in order");
+    }
+
+    check(reported(RIG_OPEN_STEP_LINES) && reported(RIG_OPEN_STEP_POWERSTAT)
+          && reported(RIG_OPEN_STEP_BACKEND) && reported(RIG_OPEN_STEP_STATE),
+          "every open step reported");
+
+    check(rig_open_async(rig, NULL, NULL) == -RIG_EINVAL, "no open of an open rig");
+
+    /* with the open done, a get goes to the rig again */
+    rig_set_freq(rig, RIG_VFO_A, 7074000);
+    check(rig_get_freq(rig, RIG_VFO_A, &freq) == RIG_OK && freq == 7074000,
+          "frequency after the open");
+
+    retval = run_async(rig, 1, &blocked_ms, &max_call_ms, &polls);
+    printf("async close: blocked_ms=%.1f max_call_ms=%.2f polls=%d\n",
+           blocked_ms, max_call_ms, polls);
+
+    check(retval == RIG_OK && !rig->state.comm_state, "async close succeeded");
+    check(reported(RIG_OPEN_STEP_CLOSE_BACKEND)
+          && reported(RIG_OPEN_STEP_CLOSE_PORT)
+          && steps[nsteps - 1] == RIG_OPEN_STEP_DONE, "close steps reported");
+    check(blocked_ms < close_ms / 2 + 1, "async close does not block");
+
+    /* cancelled while the backend wakes the rig, it stops before the reads */
+    cancel_at = RIG_OPEN_STEP_BACKEND;
+    retval = run_async(rig, 0, &blocked_ms, &max_call_ms, &polls);
+    cancel_at = -1;
+    printf("cancelled open: retval=%d steps=%d\n", retval, nsteps);
+
+    check(retval == -RIG_ECANCELED && done_retval == -RIG_ECANCELED,
+          "cancelled open returns -RIG_ECANCELED");
+    check(!rig->state.comm_state, "cancelled open closed the rig");
+    check(!reported(RIG_OPEN_STEP_STATE) && reported(RIG_OPEN_STEP_CLOSE_PORT),
+          "cancelled before the state reads and closed");
+
+    /* and can be opened again, then freed with an async open running */
+    check(rig_open(rig) == RIG_OK, "open after cancel");
+    check(rig_close(rig) == RIG_OK, "close after cancel");
+    check(rig_open_async(rig, NULL, NULL) == RIG_OK, "async open to clean up");
+
+    rig_cleanup(rig);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * testasyncset - coalescing asynchronous set test and benchmark
+ *
+ * Retunes the dummy rig, slowed down to a CAT link taking CMD_LATENCY ms
+ * per command, every UPDATE_MS ms as Doppler tracking would, first with
+ * rig_set_freq() and then with rig_set_freq_async().  Reports how long
+ * the caller was blocked and how far behind the rig ended up, and checks
+ * that the asynchronous sets were coalesced, that the last value reached
+ * the rig and that the async_set token makes rig_set_freq() and
+ * rig_set_mode() queue too, but not when a backend sets the frequency
+ * from inside a call of its own.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "testcheck.h"
+
+#define CMD_LATENCY "20"
+#define UPDATE_MS 5
+#define UPDATES 200
+
+static unsigned long callbacks;
+
+static void set_done(RIG *rig, const rig_async_set_t *set, int retval,
+                     rig_ptr_t arg)
+{
+    callbacks++;
+}
+
+
+/* a backend setting the TX frequency between two VFO changes, as the
+   split sets of Icom, Yaesu and Xiegu rigs do */
+static int xchg_set_split_freq_mode(RIG *rig, vfo_t vfo, freq_t tx_freq,
+                                    rmode_t tx_mode, pbwidth_t tx_width)
+{
+    int retval = rig_set_vfo(rig, RIG_VFO_B);
+
+    if (retval == RIG_OK)
+    {
+        retval = rig_set_freq(rig, RIG_VFO_CURR, tx_freq);
+    }
+
+    rig_set_vfo(rig, RIG_VFO_A);
+
+    return retval;
+}
+
+
+static void test_nested_set(void)
+{
+    static struct rig_caps caps;
+    freq_t freq_a = 0, freq_b = 0;
+    RIG *rig;
+
+    caps = *rig_get_caps(RIG_MODEL_DUMMY);
+    caps.rig_model = RIG_MAKE_MODEL(RIG_DUMMY, 90);
+    caps.model_name = "Dummy split";
+    caps.set_split_freq_mode = xchg_set_split_freq_mode;
+    rig_register(&caps);
+
+    rig = rig_init(caps.rig_model);
+
+    if (!rig || rig_open(rig) != RIG_OK)
+    {
+        check(0, "open the split dummy");
+        return;
+    }
+
+    rig_set_freq(rig, RIG_VFO_A, 14074000);
+    rig_set_freq(rig, RIG_VFO_B, 14074000);
+    rig_set_conf(rig, rig_token_lookup(rig, "async_set"), "1");
+    check(rig_set_split_freq_mode(rig, RIG_VFO_A, 14076000, RIG_MODE_USB,
+                                  2400) == RIG_OK, "split set with async_set");
+    rig_async_set_flush(rig, 1000);
+    rig_set_conf(rig, rig_token_lookup(rig, "async_set"), "0");
+
+    rig_get_freq(rig, RIG_VFO_A, &freq_a);
+    rig_get_freq(rig, RIG_VFO_B, &freq_b);
+    check(freq_a == 14074000 && freq_b == 14076000,
+          "a backend's own set is not queued, A=%.0f B=%.0f", freq_a, freq_b);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+}
+
+
+/* Doppler on a 435MHz downlink, a few Hz per update */
+static freq_t doppler(int i)
+{
+    return 435000000 + 10000 - i * 7;
+}
+
+
+static double track(RIG *rig, int async, double *blocked_ms)
+{
+    struct timespec start, call;
+    freq_t freq;
+    int i;
+
+    *blocked_ms = 0;
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    for (i = 0; i < UPDATES; i++)
+    {
+        elapsed_ms(&call, HAMLIB_ELAPSED_SET);
+
+        if (async)
+        {
+            rig_set_freq_async(rig, RIG_VFO_A, doppler(i));
+        }
+        else
+        {
+            rig_set_freq(rig, RIG_VFO_A, doppler(i));
+        }
+
+        *blocked_ms += elapsed_ms(&call, HAMLIB_ELAPSED_GET);
+        hl_usleep(UPDATE_MS * 1000);
+    }
+
+    check(rig_async_set_flush(rig, 1000) == RIG_OK, "flush");
+    rig_get_freq(rig, RIG_VFO_A, &freq);
+    check(freq == doppler(UPDATES - 1), "last frequency reached the rig");
+
+    /* how long after the last update the rig had it */
+    return elapsed_ms(&start, HAMLIB_ELAPSED_GET) - UPDATES * UPDATE_MS;
+}
+
+
+int main(int argc, char *argv[])
+{
+    hamlib_async_set_stats_t stats;
+    double blocked_ms, lag_ms;
+    rmode_t mode;
+    pbwidth_t width;
+    freq_t freq;
+    RIG *rig;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    rig = rig_init(RIG_MODEL_DUMMY);
+
+    if (!rig)
+    {
+        return 1;
+    }
+
+    rig_set_conf(rig, rig_token_lookup(rig, "cmd_latency"), CMD_LATENCY);
+
+    if (rig_open(rig) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open the dummy rig\n");
+        return 1;
+    }
+
+    lag_ms = track(rig, 0, &blocked_ms);
+    printf("sync: updates=%d blocked_ms=%.0f lag_ms=%.0f\n", UPDATES,
+           blocked_ms, lag_ms);
+
+    rig_set_async_callback(rig, set_done, NULL);
+    lag_ms = track(rig, 1, &blocked_ms);
+    rig_get_async_set_stats(rig, &stats);
+    printf("async: updates=%d blocked_ms=%.1f lag_ms=%.0f applied=%lu "
+           "coalesced=%lu max_queued_ms=%.0f\n", UPDATES, blocked_ms, lag_ms,
+           stats.applied, stats.coalesced, stats.max_queued_ms);
+
+    check(stats.requests == UPDATES, "every update counted");
+    check(stats.applied + stats.coalesced == stats.requests,
+          "each update sent or replaced");
+    check(stats.coalesced > UPDATES / 2, "most updates coalesced");
+    check(callbacks == stats.applied, "a callback per command");
+    check(stats.failed == 0 && stats.pending == 0, "no failed or pending sets");
+    check(blocked_ms < UPDATES * 1.0, "async caller not blocked");
+    /* a value waits for at most the command in progress and its own */
+    check(stats.max_queued_ms < 2 * atoi(CMD_LATENCY) + 50,
+          "values sent within two commands");
+
+    /* the async_set token queues the plain calls, mode and freq together */
+    rig_set_conf(rig, rig_token_lookup(rig, "async_set"), "1");
+
+    rig_set_mode(rig, RIG_VFO_A, RIG_MODE_LSB, 2400);
+    rig_set_freq(rig, RIG_VFO_A, 14100000);
+    rig_set_mode(rig, RIG_VFO_A, RIG_MODE_USB, 2400);
+    rig_set_freq(rig, RIG_VFO_A, 14074000);
+    check(rig_async_set_flush(rig, 1000) == RIG_OK, "flush after async_set");
+
+    rig_get_async_set_stats(rig, &stats);
+    check(stats.requests == UPDATES + 4, "async_set queues set_freq and set_mode");
+
+    rig_set_conf(rig, rig_token_lookup(rig, "async_set"), "0");
+    rig_get_freq(rig, RIG_VFO_A, &freq);
+    rig_get_mode(rig, RIG_VFO_A, &mode, &width);
+    check(freq == 14074000 && mode == RIG_MODE_USB, "newest freq and mode set");
+
+    /* pending sets are sent before the rig is closed */
+    rig_set_freq_async(rig, RIG_VFO_A, 7074000);
+    rig_close(rig);
+    rig_get_async_set_stats(rig, &stats);
+    check(stats.pending == 0, "close sends pending sets");
+
+    rig_cleanup(rig);
+
+    test_nested_set();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * testautomation - station automation test
+ *
+ * Drives the dummy amplifier and rotator and the dummy rig's antenna from
+ * band change rules, with the rig slowed down to CMD_LATENCY ms per
+ * command.  Checks the actions of each band, that the amplifier follows
+ * the frequency within a band, that keying up right after a band change
+ * waits for the antenna switch and that it is refused once the switching
+ * takes longer than the interlock time.  Prints how long rig_set_freq()
+ * and the interlocked rig_set_ptt() took.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include <hamlib/amplifier.h>
+#include <hamlib/rotator.h>
+#include "misc.h"
+#include "testcheck.h"
+
+#define CMD_LATENCY "20"
+#define RULES "testautomation.rules"
+
+
+static int write_rules(const char *rules)
+{
+    FILE *fp = fopen(RULES, "w");
+
+    if (!fp)
+    {
+        return -1;
+    }
+
+    fputs(rules, fp);
+    fclose(fp);
+
+    return 0;
+}
+
+
+static ant_t get_ant(RIG *rig)
+{
+    ant_t curr = RIG_ANT_NONE, tx, rx;
+    value_t option;
+
+    rig_get_ant(rig, RIG_VFO_CURR, RIG_ANT_CURR, &option, &curr, &tx, &rx);
+
+    return curr;
+}
+
+
+int main(int argc, char *argv[])
+{
+    hamlib_automation_stats_t stats;
+    struct timespec start;
+    double set_freq_ms, ptt_ms;
+    unsigned long band_changes;
+    azimuth_t az;
+    elevation_t el;
+    freq_t freq;
+    RIG *rig;
+    AMP *amp;
+    ROT *rot;
+    int retval;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    rig = rig_init(RIG_MODEL_DUMMY);
+    amp = amp_init(AMP_MODEL_DUMMY);
+    rot = rot_init(ROT_MODEL_DUMMY);
+
+    if (!rig || !amp || !rot)
+    {
+        return 1;
+    }
+
+    rig_set_conf(rig, rig_token_lookup(rig, "cmd_latency"), CMD_LATENCY);
+
+    if (rig_open(rig) != RIG_OK || amp_open(amp) != RIG_OK
+            || rot_open(rot) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open the dummy devices\n");
+        return 1;
+    }
+
+    if (write_rules("# test rules\n"
+                    "interlock=500\n"
+                    "20m     ant=2 amp_freq rot=45\n"
+                    "BAND40M ant=1 amp_freq rot=300,10   # comment\n"
+                    "*       amp_freq\n") < 0)
+    {
+        fprintf(stderr, "cannot write %s\n", RULES);
+        return 1;
+    }
+
+    check(rig_automation_load(rig, RULES) == RIG_OK, "rules loaded");
+    check(rig_automation_attach(rig, amp, rot) == RIG_OK, "devices attached");
+
+    /* 40m: antenna 1, amplifier and rotator preset */
+    rig_set_freq(rig, RIG_VFO_CURR, 7074000);
+    check(rig_automation_wait(rig, 1000) == RIG_OK, "40m actions done");
+    check(get_ant(rig) == RIG_ANT_1, "40m antenna");
+    amp_get_freq(amp, &freq);
+    check(freq == 7074000, "amplifier on 40m");
+    rig_automation_get_stats(rig, &stats);
+    band_changes = stats.band_changes;
+
+    /* the amplifier follows within the band, no band change */
+    rig_set_freq(rig, RIG_VFO_CURR, 7100000);
+    check(rig_automation_wait(rig, 1000) == RIG_OK, "40m retune done");
+    amp_get_freq(amp, &freq);
+    check(freq == 7100000, "amplifier follows the frequency");
+    rig_automation_get_stats(rig, &stats);
+    check(stats.band_changes == band_changes, "no band change within 40m");
+
+    /* 20m and key up at once: PTT waits for the antenna switch */
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    rig_set_freq(rig, RIG_VFO_CURR, 14074000);
+    set_freq_ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    retval = rig_set_ptt(rig, RIG_VFO_CURR, RIG_PTT_ON);
+    ptt_ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    check(retval == RIG_OK, "PTT on 20m");
+    check(get_ant(rig) == RIG_ANT_2, "antenna switched before keying up");
+    rig_automation_get_stats(rig, &stats);
+    check(stats.interlocks == 1 && stats.last_interlock_ms > 0,
+          "PTT interlocked once");
+    rig_set_ptt(rig, RIG_VFO_CURR, RIG_PTT_OFF);
+
+    check(rig_automation_wait(rig, 1000) == RIG_OK, "20m actions done");
+    amp_get_freq(amp, &freq);
+    check(freq == 14074000, "amplifier on 20m");
+    hl_usleep(200 * 1000);
+    rot_get_position(rot, &az, &el);
+    check(az > 0 && az <= 45, "rotator turning to the 20m preset");
+
+    printf("set_freq_ms=%.1f ptt_ms=%.1f interlock_ms=%.1f switch_ms=%.1f "
+           "actions=%lu\n", set_freq_ms, ptt_ms, stats.last_interlock_ms,
+           stats.max_switch_ms, stats.actions);
+
+    /* no band change, no wait */
+    rig_set_ptt(rig, RIG_VFO_CURR, RIG_PTT_ON);
+    rig_set_ptt(rig, RIG_VFO_CURR, RIG_PTT_OFF);
+    rig_automation_get_stats(rig, &stats);
+    check(stats.interlocks == 1, "PTT not held without a band change");
+
+    /* switching slower than the interlock time refuses PTT */
+    write_rules("interlock=50\n40m ant=1\n20m ant=2\n");
+    check(rig_automation_load(rig, RULES) == RIG_OK, "rules reloaded");
+    rig_set_conf(rig, rig_token_lookup(rig, "cmd_latency"), "300");
+    rig_set_freq(rig, RIG_VFO_CURR, 7074000);
+    check(rig_set_ptt(rig, RIG_VFO_CURR, RIG_PTT_ON) == -RIG_ETIMEOUT,
+          "PTT refused while switching");
+    rig_automation_get_stats(rig, &stats);
+    check(stats.interlock_timeouts == 1, "interlock timeout counted");
+    check(rig_automation_wait(rig, 2000) == RIG_OK, "slow switching done");
+    rig_set_conf(rig, rig_token_lookup(rig, "cmd_latency"), CMD_LATENCY);
+
+    check(rig_automation_load(rig, "/nonexistent/rules") == -RIG_EIO,
+          "missing rules file");
+    write_rules("20m ant=2 flap\n");
+    check(rig_automation_load(rig, RULES) == -RIG_EINVAL, "bad action");
+    write_rules("21m ant=2\n");
+    check(rig_automation_load(rig, RULES) == -RIG_EINVAL, "bad band");
+    remove(RULES);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+    amp_close(amp);
+    amp_cleanup(amp);
+    rot_close(rot);
+    rot_cleanup(rot);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * testband - band map test and benchmark
+ *
+ * Checks the band map of the dummy rig: bands sorted and apart, the
+ * band of a frequency, band edges and the rig's BANDSELECT indexes.
+ * Then times the band lookups rig_set_freq() and the Yaesu backend do
+ * on every frequency change, for a satellite pass retuned for Doppler
+ * shift at a high rate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "testcheck.h"
+
+#define DOPPLER_STEPS 100000
+
+
+int main(int argc, char *argv[])
+{
+    const hamlib_band_edge_t *bands, *band;
+    struct timespec start;
+    int count, sum = 0;
+    double ms;
+    RIG *rig;
+    int i;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    rig = rig_init(RIG_MODEL_DUMMY);
+
+    if (!rig || rig_open(rig) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open the dummy rig\n");
+        return 1;
+    }
+
+    check(rig_get_band_map(rig, &bands, &count) == RIG_OK && count > 10,
+          "band map");
+
+    for (i = 1; i < count; i++)
+    {
+        check(bands[i - 1].stop < bands[i].start, "bands sorted and apart");
+    }
+
+    check(rig_lookup_band(rig, 14074000, &band) == RIG_OK
+          && band->bandselect == RIG_BANDSELECT_20M
+          && band->start <= 14000000 && band->stop >= 14350000, "20m band");
+    check(rig_lookup_band(rig, 12000000, &band) == -RIG_ENAVAIL,
+          "no band at 12MHz");
+    check((setting_t)rig_get_band(rig, 12000000, -1) == RIG_BANDSELECT_GEN,
+          "general coverage at 12MHz");
+    check((setting_t)rig_get_band(rig, 1000000, -1) == RIG_BANDSELECT_MW,
+          "medium wave");
+    check((setting_t)rig_get_band(rig, 145800000, -1)
+          == RIG_BANDSELECT_2M, "2m band");
+
+    /* the dummy rig's list is BANDUNUSED,BAND70CM,BAND33CM,BAND23CM */
+    check(rig_get_band_info(rig, RIG_BANDSELECT_70CM, &band) == RIG_OK
+          && band->rig_band == 1, "70cm is rig band 1");
+    check(rig_get_band_info(rig, RIG_BANDSELECT_20M, &band) == RIG_OK
+          && band->rig_band == -1, "20m is not a rig band");
+    check(rig_get_band_rig(rig, 0, "BAND33CM") == 2, "BAND33CM index");
+    check(rig_get_band_rig(rig, 1296000000, NULL) == 3, "23cm index by freq");
+    check(strcmp(rig_get_band_str(rig, 1, 1), "BAND70CM") == 0,
+          "rig band 1 name");
+    check((setting_t)rig_get_band(rig, 0, 2) == RIG_BANDSELECT_33CM,
+          "rig band 2");
+
+    /* 435MHz downlink, retuned every step by up to +-10kHz of Doppler */
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    for (i = 0; i < DOPPLER_STEPS; i++)
+    {
+        freq_t freq = 435000000 + (i % 20001) - 10000;
+
+        sum += (setting_t)rig_get_band(rig, freq, -1) == RIG_BANDSELECT_70CM;
+        sum += rig_get_band_rig(rig, freq, NULL);
+    }
+
+    ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    check(sum == DOPPLER_STEPS * 2, "70cm during the pass");
+
+    printf("bands=%d doppler_steps=%d ns_per_step=%.1f\n", count,
+           DOPPLER_STEPS, ms * 1e6 / DOPPLER_STEPS);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,276 @@
+/*
+ * testbatch - rigctld pipelined poll test and benchmark
+ *
+ * Sends a 5 command extended response poll to rigctld in one packet and
+ * reads the replies, reporting the latency per poll and how many
+ * send()/recv() calls it took, e.g.
+ *
+ *   rigctld -m 1 -t 4532 --batch &
+ *   ./testbatch -d localhost 4532
+ *
+ * -d ends each poll with the "#batch" delimiter and waits for rigctld
+ * to answer it, this needs rigctld --batch.  Without -d any rigctld
+ * works, so the same poll can be timed with and without --batch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#define closesocket close
+#endif
+
+#define POLL_COUNT 100
+#define POLL_CMDS 5
+#define POLL "+f\n+m\n+v\n+s\n+j\n"
+#define BATCH_DELIMITER "#batch"
+
+static double now_ms(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double d = *(const double *)a - *(const double *)b;
+
+    return d < 0 ? -1 : d > 0;
+}
+
+static int connect_to(const char *host, const char *port)
+{
+    struct addrinfo hints, *res, *ai;
+    int sock = -1;
+    int i;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+    {
+        fprintf(stderr, "cannot resolve %s:%s\n", host, port);
+        return -1;
+    }
+
+    /* rigctld may still be starting up */
+    for (i = 0; i < 20 && sock < 0; i++)
+    {
+        for (ai = res; ai; ai = ai->ai_next)
+        {
+            sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+            if (sock < 0)
+            {
+                continue;
+            }
+
+            if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+            {
+                break;
+            }
+
+            closesocket(sock);
+            sock = -1;
+        }
+
+        if (sock < 0)
+        {
+            usleep(100 * 1000);
+        }
+    }
+
+    freeaddrinfo(res);
+
+    if (sock < 0)
+    {
+        fprintf(stderr, "cannot connect to %s:%s\n", host, port);
+    }
+
+    return sock;
+}
+
+/*
+ * Read until the poll is answered: POLL_CMDS "RPRT" lines, plus the
+ * delimiter line if one was sent.  Returns the number of recv() calls
+ * or -1 on error.
+ */
+static int read_poll(int sock, int delimited)
+{
+    char buf[4096];
+    size_t len = 0;
+    int rprt = 0;
+    int done = 0;
+    int recvs = 0;
+
+    while (!done)
+    {
+        char *line, *nl;
+        int n = recv(sock, buf + len, sizeof(buf) - 1 - len, 0);
+
+        recvs++;
+
+        if (n <= 0)
+        {
+            fprintf(stderr, "connection closed\n");
+            return -1;
+        }
+
+        len += n;
+        buf[len] = '\0';
+        line = buf;
+
+        while ((nl = strchr(line, '\n')) != NULL)
+        {
+            *nl = '\0';
+
+            if (strncmp(line, "RPRT ", 5) == 0)
+            {
+                if (atoi(line + 5) != 0)
+                {
+                    fprintf(stderr, "command failed: %s\n", line);
+                    return -1;
+                }
+
+                rprt++;
+            }
+            else if (strncmp(line, BATCH_DELIMITER " ", 7) == 0)
+            {
+                if (atoi(line + 7) != POLL_CMDS || rprt != POLL_CMDS)
+                {
+                    fprintf(stderr, "batch of %d commands answered as '%s' after %d replies\n",
+                            POLL_CMDS, line, rprt);
+                    return -1;
+                }
+
+                done = 1;
+            }
+
+            if (!delimited && rprt == POLL_CMDS)
+            {
+                done = 1;
+            }
+
+            line = nl + 1;
+        }
+
+        len -= line - buf;
+        memmove(buf, line, len);
+    }
+
+    if (len > 0)
+    {
+        fprintf(stderr, "unexpected data after the poll: %.*s\n", (int)len, buf);
+        return -1;
+    }
+
+    return recvs;
+}
+
+int main(int argc, char *argv[])
+{
+    char request[256];
+    double *samples;
+    double total_ms = 0;
+    int polls = POLL_COUNT;
+    int delimited = 0;
+    int recvs = 0;
+    int sock;
+    int c;
+    int i;
+
+    while ((c = getopt(argc, argv, "dn:")) != -1)
+    {
+        switch (c)
+        {
+        case 'd':
+            delimited = 1;
+            break;
+
+        case 'n':
+            polls = atoi(optarg);
+            break;
+
+        default:
+            polls = 0;
+        }
+    }
+
+    if (polls < 1 || argc - optind != 2)
+    {
+        fprintf(stderr, "Usage: %s [-d] [-n polls] host port\n", argv[0]);
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        fprintf(stderr, "WSAStartup failed: %d\n", WSAGetLastError());
+        return 1;
+    }
+
+#endif
+
+    sock = connect_to(argv[optind], argv[optind + 1]);
+
+    if (sock < 0)
+    {
+        return 1;
+    }
+
+    snprintf(request, sizeof(request), "%s%s", POLL,
+             delimited ? BATCH_DELIMITER "\n" : "");
+    samples = calloc(polls, sizeof(double));
+
+    for (i = 0; i < polls; i++)
+    {
+        double t0 = now_ms();
+        int n;
+
+        if (send(sock, request, strlen(request), 0) != strlen(request))
+        {
+            fprintf(stderr, "send failed\n");
+            return 1;
+        }
+
+        n = read_poll(sock, delimited);
+
+        if (n < 0)
+        {
+            return 1;
+        }
+
+        recvs += n;
+        samples[i] = now_ms() - t0;
+        total_ms += samples[i];
+    }
+
+    send(sock, "q\n", 2, 0);
+    closesocket(sock);
+
+    qsort(samples, polls, sizeof(double), cmp_double);
+
+    printf("polls=%d commands/poll=%d send/poll=1 recv/poll=%.2f "
+           "mean_ms=%.3f p50_ms=%.3f p99_ms=%.3f\n",
+           polls, POLL_CMDS, (double)recvs / polls, total_ms / polls,
+           samples[(polls - 1) * 50 / 100], samples[(polls - 1) * 99 / 100]);
+
+    free(samples);
+
+    return 0;
+}
@@ -2,17 +2,331 @@
 /*
  * Very simple test program to check BCD conversion against some other --SF
  * This is mainly to test freq2bcd and bcd2freq functions.
+ *
+ *   testbcd <freq> [digits]    show the BCD of freq both ways
+ *   testbcd -t                 check the conversions against a digit at a
+ *                              time, exhaustively up to 8 digits
+ *   testbcd -b [count]         time them, one JSON line
  */
 
 #include <hamlib/config.h>
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <hamlib/rig.h>
 #include "misc.h"
+#include "testcheck.h"
 
 #define MAXDIGITS 32
 
+
+/* the conversions a digit at a time, as Hamlib had them */
+static void ref_to_bcd(unsigned char bcd_data[], unsigned long long freq,
+                       unsigned bcd_len)
+{
+    int i;
+
+    for (i = 0; i < bcd_len / 2; i++)
+    {
+        unsigned char a = freq % 10;
+        freq /= 10;
+        a |= (freq % 10) << 4;
+        freq /= 10;
+        bcd_data[i] = a;
+    }
+
+    if (bcd_len & 1)
+    {
+        bcd_data[i] &= 0xf0;
+        bcd_data[i] |= freq % 10;
+    }
+}
+
+
+static unsigned long long ref_from_bcd(const unsigned char bcd_data[],
+                                       unsigned bcd_len)
+{
+    unsigned long long f = 0;
+    int i;
+
+    if (bcd_len & 1)
+    {
+        f = bcd_data[bcd_len / 2] & 0x0f;
+    }
+
+    for (i = (bcd_len / 2) - 1; i >= 0; i--)
+    {
+        f *= 10;
+        f += bcd_data[i] >> 4;
+        f *= 10;
+        f += bcd_data[i] & 0x0f;
+    }
+
+    return f;
+}
+
+
+static void ref_to_bcd_be(unsigned char bcd_data[], unsigned long long freq,
+                          unsigned bcd_len)
+{
+    int i;
+
+    if (bcd_len & 1)
+    {
+        bcd_data[bcd_len / 2] &= 0x0f;
+        bcd_data[bcd_len / 2] |= (freq % 10) << 4;
+        freq /= 10;
+    }
+
+    for (i = (bcd_len / 2) - 1; i >= 0; i--)
+    {
+        unsigned char a = freq % 10;
+        freq /= 10;
+        a |= (freq % 10) << 4;
+        freq /= 10;
+        bcd_data[i] = a;
+    }
+}
+
+
+static unsigned long long ref_from_bcd_be(const unsigned char bcd_data[],
+        unsigned bcd_len)
+{
+    unsigned long long f = 0;
+    int i;
+
+    for (i = 0; i < bcd_len / 2; i++)
+    {
+        f *= 10;
+        f += bcd_data[i] >> 4;
+        f *= 10;
+        f += bcd_data[i] & 0x0f;
+    }
+
+    if (bcd_len & 1)
+    {
+        f *= 10;
+        f += bcd_data[bcd_len / 2] >> 4;
+    }
+
+    return f;
+}
+
+
+/* a conversion check, only the first 20 failures are printed */
+static void check_conv(int ok, const char *what, unsigned long long value,
+                       unsigned digits)
+{
+    if (!ok && failures >= 20)
+    {
+        failures++;
+        return;
+    }
+
+    check(ok, "%s, value %llu, %u digits", what, value, digits);
+}
+
+
+/* encode both ways into buffers filled with a pattern, bytes and all */
+static void check_value(unsigned long long value, unsigned digits)
+{
+    unsigned char b[12], r[12];
+
+    memset(b, 0xa5, sizeof(b));
+    memset(r, 0xa5, sizeof(r));
+    to_bcd(b, value, digits);
+    ref_to_bcd(r, value, digits);
+    check_conv(memcmp(b, r, sizeof(b)) == 0, "to_bcd", value, digits);
+    check_conv(from_bcd(b, digits) == ref_from_bcd(r, digits), "from_bcd",
+               value, digits);
+
+    memset(b, 0x5a, sizeof(b));
+    memset(r, 0x5a, sizeof(r));
+    to_bcd_be(b, value, digits);
+    ref_to_bcd_be(r, value, digits);
+    check_conv(memcmp(b, r, sizeof(b)) == 0, "to_bcd_be", value, digits);
+    check_conv(from_bcd_be(b, digits) == ref_from_bcd_be(r, digits),
+               "from_bcd_be", value, digits);
+}
+
+
+static unsigned long long xorshift(void)
+{
+    static unsigned long long x = 88172645463325252ULL;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return x;
+}
+
+
+static int self_test(void)
+{
+    /* division, max division and two 5 byte frequencies of an Icom scope line */
+    static const bcd_field_t fields[] =
+    {
+        { 1, 2, 0 }, { 2, 2, 0 }, { 4, 10, 0 }, { 9, 10, 0 }, { 14, 3, 1 },
+    };
+    unsigned long long in[5] = { 1, 11, 14074000, 25000, 123 };
+    unsigned long long out[5];
+    unsigned long long limit = 1;
+    unsigned char frame[16], b[4];
+    unsigned digits;
+    unsigned i;
+
+    /* every byte, and every pair of bytes, decoded, including non-digits */
+    for (i = 0; i < 65536; i++)
+    {
+        b[0] = i & 0xff;
+        b[1] = i >> 8;
+
+        for (digits = 1; digits <= 4; digits++)
+        {
+            check_conv(from_bcd(b, digits) == ref_from_bcd(b, digits),
+                       "from_bcd bytes", i, digits);
+            check_conv(from_bcd_be(b, digits) == ref_from_bcd_be(b, digits),
+                       "from_bcd_be bytes", i, digits);
+        }
+    }
+
+    /* every value of up to 6 digits, and the first million of 7 and 8 */
+    for (digits = 1; digits <= 8; digits++)
+    {
+        unsigned long long v;
+
+        limit = limit * 10 > 1000000 ? 1000000 : limit * 10;
+
+        for (v = 0; v < limit; v++)
+        {
+            check_value(v, digits);
+
+            if (digits <= 6)
+            {
+                unsigned char c[4];
+
+                to_bcd(c, v, digits);
+                check_conv(from_bcd(c, digits) == v, "round trip", v, digits);
+                to_bcd_be(c, v, digits);
+                check_conv(from_bcd_be(c, digits) == v, "round trip be", v,
+                           digits);
+            }
+        }
+    }
+
+    /* longer fields, and values with more digits than the field */
+    for (i = 0; i < 20000; i++)
+    {
+        unsigned long long v = xorshift();
+
+        for (digits = 1; digits <= 20; digits++)
+        {
+            check_value(v, digits);
+            check_value(v % 100000000000ULL, digits);
+        }
+    }
+
+    memset(frame, 0, sizeof(frame));
+    check(to_bcd_fields(frame, sizeof(frame), fields, 5, in) == 5, "to_bcd_fields");
+    check(frame[4] == 0x00 && frame[5] == 0x40 && frame[6] == 0x07
+          && frame[7] == 0x14 && frame[14] == 0x12 && (frame[15] & 0xf0) == 0x30,
+          "to_bcd_fields bytes");
+    check(from_bcd_fields(frame, sizeof(frame), fields, 5, out) == 5
+          && memcmp(in, out, sizeof(in)) == 0, "from_bcd_fields");
+
+    memset(out, 0, sizeof(out));
+    check(from_bcd_fields(frame, 14, fields, 5, out) == -RIG_EPROTO
+          && out[0] == 0, "field past the frame");
+    check(from_bcd_fields(frame, 14, fields, 4, out) == 4, "short frame");
+    check(to_bcd_fields(frame, 3, fields, 3, in) == -RIG_EPROTO
+          && frame[1] == 0x01, "nothing written past the frame");
+
+    if (failures)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("testbcd: all checks passed\n");
+
+    return 0;
+}
+
+
+static double ns_per(struct timespec *start, long count)
+{
+    return elapsed_ms(start, HAMLIB_ELAPSED_GET) * 1e6 / count;
+}
+
+
+static int bench(long count)
+{
+    static const bcd_field_t fields[] =
+    {
+        { 1, 2, 0 }, { 2, 2, 0 }, { 4, 10, 0 }, { 9, 10, 0 },
+    };
+    unsigned long long values[4];
+    unsigned char b[16];
+    volatile unsigned long long sink = 0;
+    double ref_ns, ns, header_calls_ns, header_ns;
+    struct timespec start;
+    long i;
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    for (i = 0; i < count; i++)
+    {
+        ref_to_bcd(b, 14074000 + i, 10);
+        sink += ref_from_bcd(b, 10);
+    }
+
+    ref_ns = ns_per(&start, count);
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    for (i = 0; i < count; i++)
+    {
+        to_bcd(b, 14074000 + i, 10);
+        sink += from_bcd(b, 10);
+    }
+
+    ns = ns_per(&start, count);
+
+    /* an Icom scope header, decoded a field per call and in one pass */
+    to_bcd(b + 4, 14074000, 10);
+    to_bcd(b + 9, 25000, 10);
+    b[1] = 0x01;
+    b[2] = 0x11;
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    for (i = 0; i < count; i++)
+    {
+        b[4] = (unsigned char) i;
+        sink += from_bcd(b + 1, 2) + from_bcd(b + 2, 2) + from_bcd(b + 4, 10)
+                + from_bcd(b + 9, 10);
+    }
+
+    header_calls_ns = ns_per(&start, count);
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    for (i = 0; i < count; i++)
+    {
+        b[4] = (unsigned char) i;
+        from_bcd_fields(b, sizeof(b), fields, 4, values);
+        sink += values[0] + values[1] + values[2] + values[3];
+    }
+
+    header_ns = ns_per(&start, count);
+
+    printf("{\"count\":%ld,\"digit_loop_ns\":%.1f,\"bcd_ns\":%.1f,"
+           "\"scope_header_calls_ns\":%.1f,\"scope_header_fields_ns\":%.1f}\n",
+           count, ref_ns, ns, header_calls_ns, header_ns);
+
+    return sink == 0;
+}
+
+
 int main(int argc, char *argv[])
 {
     unsigned char b[(MAXDIGITS + 1) / 2];
@@ -20,9 +334,21 @@ int main(int argc, char *argv[])
     int digits = 10;
     int i;
 
+    if (argc >= 2 && strcmp(argv[1], "-t") == 0)
+    {
+        rig_set_debug(RIG_DEBUG_NONE);
+        return self_test();
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "-b") == 0)
+    {
+        rig_set_debug(RIG_DEBUG_NONE);
+        return bench(argc > 2 ? atol(argv[2]) : 10000000);
+    }
+
     if (argc != 2 && argc != 3)
     {
-        fprintf(stderr, "Usage: %s <freq> [digits]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <freq> [digits] | -t | -b [count]\n", argv[0]);
         exit(1);
     }
 
@@ -0,0 +1,259 @@
+/*
+ * testcacheadapt - adaptive cache timeout test
+ *
+ * Polls frequency, mode and split through a NET rigctl connection in a
+ * loop, once with the cache disabled and once with cache_adaptive, while
+ * a second connection changes the frequency every so often.  Checks that
+ * the adaptive cache keeps the port busy for less than half as long,
+ * that the polled frequency never lags the change by more than
+ * cache_max_ms plus one poll, and that the timeouts back off while the
+ * port is kept busy switching PTT.  rigctld must not cache, e.g.
+ *
+ *   rigctld -m 1 -t 4532 -C poll_interval=0,cache_timeout=0 &
+ *   ./testcacheadapt localhost:4532
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+
+#define PHASE_MS 3000
+#define CHANGE_MS 700
+#define TARGET_LOAD "25"
+#define MAX_MS "400"
+#define BUSY_CMDS 4
+
+struct poll_result
+{
+    int polls;
+    unsigned long writes;
+    double busy_ms;
+    double worst_lag_ms;
+    hamlib_cache_policy_t policy;
+};
+
+
+static RIG *open_rig(const char *path, int adaptive)
+{
+    RIG *rig = rig_init(RIG_MODEL_NETRIGCTL);
+
+    if (!rig)
+    {
+        return NULL;
+    }
+
+    rig_set_conf(rig, rig_token_lookup(rig, "rig_pathname"), path);
+    /* no background polling, this test is the only client of the port */
+    rig_set_conf(rig, rig_token_lookup(rig, "poll_interval"), "0");
+
+    if (adaptive)
+    {
+        rig_set_conf(rig, rig_token_lookup(rig, "cache_adaptive"), "1");
+        rig_set_conf(rig, rig_token_lookup(rig, "cache_target_load"), TARGET_LOAD);
+        rig_set_conf(rig, rig_token_lookup(rig, "cache_max_ms"), MAX_MS);
+    }
+    else
+    {
+        rig_set_conf(rig, rig_token_lookup(rig, "cache_timeout"), "0");
+    }
+
+    /* only to count the port writes */
+    rig_set_conf(rig, rig_token_lookup(rig, "trace_record"), "/dev/null");
+
+    if (rig_open(rig) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        rig_cleanup(rig);
+        return NULL;
+    }
+
+    return rig;
+}
+
+
+static int poll_phase(RIG *rig, RIG *setter, int busy, struct poll_result *r)
+{
+    hamlib_trace_stats_t start, end;
+    struct timespec phase, change;
+    freq_t want = 14074000;
+    int changed = 0;
+
+    memset(r, 0, sizeof(*r));
+    rig_get_trace_stats(rig, &start);
+    elapsed_ms(&phase, HAMLIB_ELAPSED_SET);
+    elapsed_ms(&change, HAMLIB_ELAPSED_SET);
+
+    while (elapsed_ms(&phase, HAMLIB_ELAPSED_GET) < PHASE_MS)
+    {
+        freq_t freq;
+        rmode_t mode;
+        pbwidth_t width;
+        vfo_t tx_vfo;
+        split_t split;
+        struct timespec poll;
+        int i;
+
+        if (!busy && !changed && elapsed_ms(&change, HAMLIB_ELAPSED_GET) > CHANGE_MS)
+        {
+            want += 1000;
+
+            if (rig_set_freq(setter, RIG_VFO_CURR, want) != RIG_OK)
+            {
+                fprintf(stderr, "set_freq failed\n");
+                return -1;
+            }
+
+            elapsed_ms(&change, HAMLIB_ELAPSED_SET);
+            changed = 1;
+        }
+
+        elapsed_ms(&poll, HAMLIB_ELAPSED_SET);
+
+        if (rig_get_freq(rig, RIG_VFO_CURR, &freq) != RIG_OK
+                || rig_get_mode(rig, RIG_VFO_CURR, &mode, &width) != RIG_OK
+                || rig_get_split_vfo(rig, RIG_VFO_CURR, &split, &tx_vfo) != RIG_OK)
+        {
+            fprintf(stderr, "poll failed\n");
+            return -1;
+        }
+
+        r->busy_ms += elapsed_ms(&poll, HAMLIB_ELAPSED_GET);
+
+        if (changed && freq == want)
+        {
+            double lag = elapsed_ms(&change, HAMLIB_ELAPSED_GET);
+
+            if (lag > r->worst_lag_ms)
+            {
+                r->worst_lag_ms = lag;
+            }
+
+            elapsed_ms(&change, HAMLIB_ELAPSED_SET);
+            changed = 0;
+        }
+
+        /* keep the port busy without touching the polled values */
+        for (i = 0; busy && i < BUSY_CMDS; i++)
+        {
+            rig_set_ptt(rig, RIG_VFO_CURR, i & 1 ? RIG_PTT_OFF : RIG_PTT_ON);
+        }
+
+        r->polls++;
+        /* a client polling at a sane rate, not spinning on the cache */
+        hl_usleep(5 * 1000);
+    }
+
+    rig_get_trace_stats(rig, &end);
+    r->writes = end.writes - start.writes;
+    rig_get_cache_policy(rig, &r->policy);
+
+    return 0;
+}
+
+
+static void print_result(const char *name, const struct poll_result *r)
+{
+    printf("%s: polls=%d writes=%lu writes/s=%.1f poll_load=%.0f%% "
+           "worst_lag_ms=%.0f port_load=%.0f%% backoff=%.2f "
+           "timeouts_ms=%d/%d/%d/%d/%d read_ms=%.1f/%.1f/%.1f/%.1f/%.1f\n",
+           name, r->polls, r->writes, r->writes * 1000.0 / PHASE_MS,
+           r->busy_ms * 100 / PHASE_MS, r->worst_lag_ms, r->policy.load,
+           r->policy.backoff,
+           r->policy.timeout_ms[HAMLIB_CACHE_VFO],
+           r->policy.timeout_ms[HAMLIB_CACHE_FREQ],
+           r->policy.timeout_ms[HAMLIB_CACHE_MODE],
+           r->policy.timeout_ms[HAMLIB_CACHE_PTT],
+           r->policy.timeout_ms[HAMLIB_CACHE_SPLIT],
+           r->policy.latency_ms[HAMLIB_CACHE_VFO],
+           r->policy.latency_ms[HAMLIB_CACHE_FREQ],
+           r->policy.latency_ms[HAMLIB_CACHE_MODE],
+           r->policy.latency_ms[HAMLIB_CACHE_PTT],
+           r->policy.latency_ms[HAMLIB_CACHE_SPLIT]);
+}
+
+
+int main(int argc, char *argv[])
+{
+    struct poll_result fixed, adaptive, busy;
+    RIG *rig, *setter;
+    int max_ms = atoi(MAX_MS);
+    double poll_ms;
+    int failures = 0;
+    int i;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s host:port\n", argv[0]);
+        return 1;
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    setter = open_rig(argv[1], 0);
+    rig = open_rig(argv[1], 0);
+
+    if (!setter || !rig || poll_phase(rig, setter, 0, &fixed) < 0)
+    {
+        return 1;
+    }
+
+    print_result("fixed", &fixed);
+    rig_close(rig);
+    rig_cleanup(rig);
+
+    rig = open_rig(argv[1], 1);
+
+    if (!rig || poll_phase(rig, setter, 0, &adaptive) < 0
+            || poll_phase(rig, setter, 1, &busy) < 0)
+    {
+        return 1;
+    }
+
+    print_result("adaptive", &adaptive);
+    print_result("adaptive busy", &busy);
+
+    if (adaptive.busy_ms * 2 > fixed.busy_ms)
+    {
+        fprintf(stderr, "FAIL: adaptive cache polled for %.0fms, fixed %.0fms\n",
+                adaptive.busy_ms, fixed.busy_ms);
+        failures++;
+    }
+
+    /* a poll is three reads that may all miss the cache */
+    poll_ms = 3 * adaptive.policy.latency_ms[HAMLIB_CACHE_FREQ] + 5;
+
+    if (adaptive.worst_lag_ms > max_ms + poll_ms + 100)
+    {
+        fprintf(stderr, "FAIL: frequency change seen after %.0fms, bound %dms\n",
+                adaptive.worst_lag_ms, max_ms);
+        failures++;
+    }
+
+    for (i = HAMLIB_CACHE_VFO; i <= HAMLIB_CACHE_WIDTH; i++)
+    {
+        if (adaptive.policy.timeout_ms[i] > max_ms
+                || busy.policy.timeout_ms[i] > max_ms)
+        {
+            fprintf(stderr, "FAIL: cache class %d timeout over cache_max_ms\n", i);
+            failures++;
+        }
+    }
+
+    if (busy.policy.backoff <= adaptive.policy.backoff)
+    {
+        fprintf(stderr, "FAIL: no backoff on a busy port, backoff %.2f\n",
+                busy.policy.backoff);
+        failures++;
+    }
+
+    rig_close(rig);
+    rig_cleanup(rig);
+    rig_close(setter);
+    rig_cleanup(setter);
+
+    return failures ? 1 : 0;
+}
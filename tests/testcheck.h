@@ -0,0 +1,33 @@
+/*
+ * testcheck.h - checks of the self-checking test programs
+ *
+ * check() prints a failed check to stderr and counts it in failures,
+ * which the test turns into its exit status at the end of main().
+ */
+
+#ifndef _TESTCHECK_H
+#define _TESTCHECK_H 1
+
+#include <stdio.h>
+#include <stdarg.h>
+
+static int failures;
+
+static void check(int ok, const char *what, ...)
+{
+    va_list args;
+
+    if (ok)
+    {
+        return;
+    }
+
+    va_start(args, what);
+    fprintf(stderr, "FAIL: ");
+    vfprintf(stderr, what, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    failures++;
+}
+
+#endif
@@ -0,0 +1,262 @@
+/*
+ * testkeyer - software CW keyer timeline and timing test
+ *
+ * Checks the key down and key up intervals rig_keyer_timeline() makes for
+ * the speed, weighting, Farnsworth spacing and speed changes, then keys
+ * PARIS at 20, 35 and 50 WPM through the keyer callback of a dummy rig,
+ * which stands in for the keyer line, and checks the order and number
+ * of the edges against the timeline.  Last a message is aborted with
+ * rig_stop_morse().  Prints the timing of each speed as JSON.
+ *
+ * Each edge must come within MAX_ERROR_US of the timeline and the key
+ * up within MAX_STOP_US of the stop.  That depends on the load of the
+ * machine, so make check allows SLACK times as much and -t checks the
+ * bounds themselves.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "testcheck.h"
+
+#define MAX_EDGES 256
+#define MAX_ERROR_US 5000
+#define MAX_STOP_US 30000
+#define SLACK 4
+
+static int slack = SLACK;
+
+
+static int total_us(const rig_keyer_element_t *e, int n)
+{
+    int i, us = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        us += e[i].duration_us;
+    }
+
+    return us;
+}
+
+
+static void test_timeline(void)
+{
+    rig_keyer_element_t e[128];
+    rig_keyer_params_t p = { 20, 0, 50 };
+    int n;
+
+    /* PARIS and the space after it are 50 dots, 60 ms each at 20 WPM */
+    n = rig_keyer_timeline("PARIS ", &p, e, 128);
+    check(n == 28, "PARIS is 14 key downs and their spaces");
+    check(abs(total_us(e, n) - 3000000) < 50, "PARIS takes 3 s at 20 WPM");
+    check(e[0].key == 1 && e[0].duration_us == 60000 && e[1].key == 0
+          && e[1].duration_us == 60000 && e[2].duration_us == 180000,
+          "dot, space and dash");
+    check(e[n - 1].key == 0 && e[n - 1].duration_us == 7 * 60000,
+          "word space");
+    check(rig_keyer_timeline("PARIS ", &p, NULL, 0) == n, "count only");
+    check(rig_keyer_timeline("PARIS ", &p, e, 4) == n, "count past max");
+
+    p.weight = 60;
+    n = rig_keyer_timeline("PARIS ", &p, e, 128);
+    check(abs(total_us(e, n) - 3000000) < 50, "weighting keeps the speed");
+    check(e[0].duration_us == 72000 && e[1].duration_us == 48000,
+          "weighting lengthens the key down");
+
+    /* the spaces stretch PARIS to 10 WPM, the elements stay at 20 WPM */
+    p.weight = 50;
+    p.farnsworth_wpm = 10;
+    n = rig_keyer_timeline("PARIS ", &p, e, 128);
+    check(abs(total_us(e, n) - 6000000) < 100, "Farnsworth takes 6 s");
+    check(e[0].duration_us == 60000 && e[1].duration_us == 60000,
+          "Farnsworth keeps the elements");
+
+    p.farnsworth_wpm = 0;
+    n = rig_keyer_timeline("E>E<<E", &p, e, 128);
+    check(n == 6 && e[0].duration_us == 60000 && e[2].duration_us == 48000
+          && e[4].duration_us == 80000, "speed changes");
+    check(rig_keyer_timeline("~", &p, e, 128) == 0, "no code, no time");
+
+    p.wpm = 200;
+    check(rig_keyer_timeline("E", &p, e, 128) == -RIG_EINVAL, "reject speed");
+    p.wpm = 20;
+    p.weight = 95;
+    check(rig_keyer_timeline("E", &p, e, 128) == -RIG_EINVAL, "reject weight");
+}
+
+
+#if defined(HAVE_PTHREAD)
+/* the edges the callback saw */
+static struct
+{
+    pthread_mutex_t mutex;
+    int n;
+    int key[MAX_EDGES];
+    struct timespec at[MAX_EDGES];
+} edges = { PTHREAD_MUTEX_INITIALIZER };
+
+
+static int record_edge(RIG *rig, int key, rig_ptr_t arg)
+{
+    pthread_mutex_lock(&edges.mutex);
+
+    if (edges.n < MAX_EDGES)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &edges.at[edges.n]);
+        edges.key[edges.n++] = key;
+    }
+
+    pthread_mutex_unlock(&edges.mutex);
+
+    return RIG_OK;
+}
+
+
+static double us_between(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) * 1e6 + (b->tv_nsec - a->tv_nsec) / 1e3;
+}
+
+
+static void test_speed(RIG *rig, int wpm)
+{
+    rig_keyer_element_t e[64];
+    rig_keyer_params_t p = { 0, 0, 50 };
+    hamlib_keyer_stats_t stats;
+    char val[8];
+    double expected = 0, error, max_error = 0, total_error = 0;
+    int n, i;
+
+    p.wpm = wpm;
+    n = rig_keyer_timeline("PARIS", &p, e, 64);
+    SNPRINTF(val, sizeof(val), "%d", wpm);
+    rig_set_conf(rig, rig_token_lookup(rig, "keyer_wpm"), val);
+    edges.n = 0;
+
+    check(rig_send_morse(rig, RIG_VFO_CURR, "PARIS") == RIG_OK, "send PARIS");
+    check(rig_wait_morse(rig, RIG_VFO_CURR) == RIG_OK, "wait for PARIS");
+
+    pthread_mutex_lock(&edges.mutex);
+    check(edges.n == n, "an edge per interval");
+
+    for (i = 0; i < edges.n && i < n; i++)
+    {
+        check(edges.key[i] == e[i].key, "edge key");
+        error = us_between(&edges.at[0], &edges.at[i]) - expected;
+        error = error < 0 ? -error : error;
+        total_error += error;
+        max_error = error > max_error ? error : max_error;
+        expected += e[i].duration_us;
+    }
+
+    pthread_mutex_unlock(&edges.mutex);
+
+    check(max_error < MAX_ERROR_US * slack, "edges on time, %.0f us late",
+          max_error);
+
+    rig_get_keyer_stats(rig, &stats);
+
+    printf("{\"wpm\":%d,\"edges\":%d,\"mean_error_us\":%.0f,\"max_error_us\":%.0f,"
+           "\"keyer_mean_us\":%.0f,\"keyer_max_us\":%.0f,\"keyer_late\":%lu,"
+           "\"realtime\":%d}\n", wpm, n, n ? total_error / n : 0, max_error,
+           stats.mean_us, stats.max_us, stats.late, stats.realtime);
+}
+
+
+static void test_abort(RIG *rig)
+{
+    const char *msg = "CQ CQ CQ DE W1AW W1AW W1AW K";
+    rig_keyer_params_t p = { 20, 0, 50 };
+    struct timespec stopped;
+    int n, full;
+
+    full = rig_keyer_timeline(msg, &p, NULL, 0);
+    rig_set_conf(rig, rig_token_lookup(rig, "keyer_wpm"), "20");
+    edges.n = 0;
+    rig_send_morse(rig, RIG_VFO_CURR, msg);
+    hl_usleep(300 * 1000);
+
+    clock_gettime(CLOCK_MONOTONIC, &stopped);
+    check(rig_stop_morse(rig, RIG_VFO_CURR) == RIG_OK, "stop");
+    check(rig_wait_morse(rig, RIG_VFO_CURR) == RIG_OK, "wait after stop");
+    hl_usleep(200 * 1000);
+
+    pthread_mutex_lock(&edges.mutex);
+    n = edges.n;
+    check(n > 0 && edges.key[n - 1] == 0, "key up after stop");
+    check(n > 0 && n < full, "message cut short");
+
+    check(n > 0 && us_between(&stopped, &edges.at[n - 1]) < MAX_STOP_US * slack,
+          "key up in time");
+
+    pthread_mutex_unlock(&edges.mutex);
+
+    hl_usleep(200 * 1000);
+    pthread_mutex_lock(&edges.mutex);
+    check(edges.n == n, "nothing keyed after stop");
+    pthread_mutex_unlock(&edges.mutex);
+}
+#endif
+
+
+int main(int argc, char *argv[])
+{
+#if defined(HAVE_PTHREAD)
+    RIG *rig;
+#endif
+
+    if (argc > 1 && !strcmp(argv[1], "-t"))
+    {
+        slack = 1;
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    test_timeline();
+
+#if defined(HAVE_PTHREAD)
+    rig = rig_init(RIG_MODEL_DUMMY);
+
+    if (!rig)
+    {
+        fprintf(stderr, "rig_init failed\n");
+        return 1;
+    }
+
+    rig_set_keyer_callback(rig, record_edge, NULL);
+
+    if (rig_open(rig) != RIG_OK)
+    {
+        fprintf(stderr, "rig_open failed\n");
+        return 1;
+    }
+
+    test_speed(rig, 20);
+    test_speed(rig, 35);
+    test_speed(rig, 50);
+    test_abort(rig);
+
+    rig_close(rig);
+    rig_cleanup(rig);
+#endif
+
+    if (failures)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("testkeyer: all checks passed\n");
+
+    return 0;
+}
@@ -0,0 +1,243 @@
+/*
+ * testqrb - bulk distance and bearing test
+ *
+ * Checks qrb_bulk() and qrb_bulk_locator() against qrb(),
+ * azimuth_long_path() and locator2longlat() for known locator pairs and
+ * for points all over the globe, poles, date line and antipodes
+ * included, then times a batch of spots both ways.
+ *
+ *   testqrb [spots]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include "testcheck.h"
+
+#define SPOTS 100000
+
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static void random_locator(char *loc, int pairs)
+{
+    static const int range[] = { 18, 10, 24, 10, 24, 10 };
+    int i;
+
+    for (i = 0; i < pairs * 2; i++)
+    {
+        int r = rand() % range[i / 2];
+
+        loc[i] = range[i / 2] == 10 ? '0' + r : (i / 2 ? 'a' : 'A') + r;
+    }
+
+    loc[pairs * 2] = '\0';
+}
+
+
+int main(int argc, char *argv[])
+{
+    static const struct
+    {
+        const char *loc1, *loc2;
+        double distance, azimuth;
+    } known[] =
+    {
+        { "EM79UT96LW", "JO01AB", 6327.389998, 48 },
+        { "FN20", "PF95", 16963.163952, 272 },
+        { "JN58TD", "RE78IR", 18480.777066, 66 },
+        { "AA00", "RR99", 19904.816937, 359 },
+        { "FN31pr", "FN31pr", 0, 0 },
+    };
+    int spots = argc > 1 ? atoi(argv[1]) : SPOTS;
+    double *lon, *lat, *distance, *azimuth, *azimuth_long;
+    char (*locbuf)[9];
+    const char **loc;
+    double max_diff = 0;
+    double t_single, t_bulk, t_loc_single, t_loc_bulk;
+    qrb_origin_t origin;
+    double olon, olat;
+    int retcode;
+    int i;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    srand(1);
+
+    lon = calloc(spots, sizeof(double));
+    lat = calloc(spots, sizeof(double));
+    distance = calloc(spots, sizeof(double));
+    azimuth = calloc(spots, sizeof(double));
+    azimuth_long = calloc(spots, sizeof(double));
+    locbuf = calloc(spots, sizeof(*locbuf));
+    loc = calloc(spots, sizeof(*loc));
+
+    if (spots < 16 || !lon || !lat || !distance || !azimuth || !azimuth_long
+            || !locbuf || !loc)
+    {
+        fprintf(stderr, "usage: testqrb [spots >= 16]\n");
+        return 1;
+    }
+
+    /* the locator pairs of testloc */
+    for (i = 0; i < (int)(sizeof(known) / sizeof(known[0])); i++)
+    {
+        const char *one[1];
+
+        one[0] = known[i].loc2;
+        locator2longlat(&olon, &olat, known[i].loc1);
+        qrb_origin_set(&origin, olon, olat);
+        retcode = qrb_bulk_locator(&origin, 1, one, distance, azimuth,
+                                   azimuth_long);
+        check(retcode == RIG_OK && fabs(distance[0] - known[i].distance) < 1e-6
+              && azimuth[0] == known[i].azimuth
+              && azimuth_long[0] == azimuth_long_path(known[i].azimuth),
+              known[i].loc2);
+    }
+
+    check(qrb_origin_set(&origin, 0, 91) == -RIG_EINVAL, "origin out of range");
+    check(qrb_origin_set(NULL, 0, 0) == -RIG_EINVAL, "no origin");
+
+    /* random spots, the edges and the origin's own antipode */
+    olon = -81.2;
+    olat = 41.9;
+    qrb_origin_set(&origin, olon, olat);
+
+    for (i = 0; i < spots; i++)
+    {
+        lon[i] = rand() * 360.0 / RAND_MAX - 180;
+        lat[i] = rand() * 180.0 / RAND_MAX - 90;
+    }
+
+    lat[0] = 90;
+    lat[1] = -90;
+    lon[2] = 180;
+    lon[3] = -180;
+    lon[4] = olon;
+    lat[4] = olat;
+    lon[5] = olon + 180;
+    lat[5] = -olat;
+    lat[6] = 90.5;
+
+    retcode = qrb_bulk(&origin, spots, lon, lat, distance, azimuth, azimuth_long);
+    check(retcode == -RIG_EINVAL && isnan(distance[6]) && isnan(azimuth[6]),
+          "spot out of range");
+
+    for (i = 0; i < spots; i++)
+    {
+        double d, az;
+
+        if (qrb(olon, olat, lon[i], lat[i], &d, &az) != RIG_OK)
+        {
+            check(i == 6, "qrb of a spot");
+            continue;
+        }
+
+        if (fabs(d - distance[i]) > max_diff)
+        {
+            max_diff = fabs(d - distance[i]);
+        }
+
+        if (az != azimuth[i] || azimuth_long_path(az) != azimuth_long[i])
+        {
+            fprintf(stderr, "spot %d: %f %f azimuth %f/%f long %f/%f\n", i,
+                    lon[i], lat[i], az, azimuth[i], azimuth_long_path(az),
+                    azimuth_long[i]);
+            check(0, "azimuth as qrb");
+        }
+    }
+
+    check(max_diff < 1e-9, "distance as qrb");
+    lat[6] = 0;
+
+    /* locators of 4 to 8 characters, a bad one in between */
+    for (i = 0; i < spots; i++)
+    {
+        random_locator(locbuf[i], 2 + i % 3);
+        loc[i] = locbuf[i];
+    }
+
+    strcpy(locbuf[7], "ZZ99");
+    retcode = qrb_bulk_locator(&origin, spots, loc, distance, azimuth, NULL);
+    check(retcode == -RIG_EINVAL && isnan(distance[7]), "bad locator");
+
+    for (i = 0; i < spots; i++)
+    {
+        double d, az, lo, la;
+
+        if (i == 7)
+        {
+            continue;
+        }
+
+        locator2longlat(&lo, &la, loc[i]);
+        qrb(olon, olat, lo, la, &d, &az);
+
+        if (fabs(d - distance[i]) > 1e-9 || az != azimuth[i])
+        {
+            fprintf(stderr, "locator %s: %f/%f %f/%f\n", loc[i], d, distance[i],
+                    az, azimuth[i]);
+            check(0, "locator as qrb");
+        }
+    }
+
+    strcpy(locbuf[7], "EN91");
+
+    /* one call a spot against one call for all */
+    t_single = now_us();
+
+    for (i = 0; i < spots; i++)
+    {
+        qrb(olon, olat, lon[i], lat[i], &distance[i], &azimuth[i]);
+        azimuth_long[i] = azimuth_long_path(azimuth[i]);
+    }
+
+    t_single = now_us() - t_single;
+    t_bulk = now_us();
+    qrb_bulk(&origin, spots, lon, lat, distance, azimuth, azimuth_long);
+    t_bulk = now_us() - t_bulk;
+
+    t_loc_single = now_us();
+
+    for (i = 0; i < spots; i++)
+    {
+        double lo, la;
+
+        locator2longlat(&lo, &la, loc[i]);
+        qrb(olon, olat, lo, la, &distance[i], &azimuth[i]);
+        azimuth_long[i] = azimuth_long_path(azimuth[i]);
+    }
+
+    t_loc_single = now_us() - t_loc_single;
+    t_loc_bulk = now_us();
+    qrb_bulk_locator(&origin, spots, loc, distance, azimuth, azimuth_long);
+    t_loc_bulk = now_us() - t_loc_bulk;
+
+    printf("spots=%d max_distance_diff=%g\n", spots, max_diff);
+    printf("lon/lat: qrb %.1f ns/spot, qrb_bulk %.1f ns/spot\n",
+           t_single * 1000 / spots, t_bulk * 1000 / spots);
+    printf("locator: locator2longlat+qrb %.1f ns/spot, qrb_bulk_locator %.1f ns/spot\n",
+           t_loc_single * 1000 / spots, t_loc_bulk * 1000 / spots);
+
+    free(lon);
+    free(lat);
+    free(distance);
+    free(azimuth);
+    free(azimuth_long);
+    free(locbuf);
+    free(loc);
+
+    return failures ? 1 : 0;
+}
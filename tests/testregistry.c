@@ -0,0 +1,130 @@
+/*
+ * testregistry - rig model registry test and startup benchmark
+ *
+ * Times the first rig_init() of one model, as a program that opens one
+ * rig does at startup, then loading every backend and listing all the
+ * models, as rigctl -l does, and prints the resident set size after
+ * each step.  Checks that the models are listed once each in model
+ * order and that rig_get_caps() finds every one of them.
+ *
+ *   testregistry [model]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+
+struct list_check
+{
+    int count;
+    int failures;
+    rig_model_t last;
+};
+
+
+/* resident set size in kB, -1 where /proc is not available */
+static long rss_kb(void)
+{
+    char line[128];
+    long kb = -1;
+    FILE *fp = fopen("/proc/self/status", "r");
+
+    if (!fp)
+    {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strncmp(line, "VmRSS:", 6) == 0)
+        {
+            kb = atol(line + 6);
+            break;
+        }
+    }
+
+    fclose(fp);
+
+    return kb;
+}
+
+
+static int check_caps(struct rig_caps *caps, rig_ptr_t data)
+{
+    struct list_check *check = (struct list_check *)data;
+
+    if (caps->rig_model <= check->last)
+    {
+        fprintf(stderr, "FAIL: model %u listed after %u\n", caps->rig_model,
+                check->last);
+        check->failures++;
+    }
+
+    if (rig_get_caps(caps->rig_model) != caps)
+    {
+        fprintf(stderr, "FAIL: rig_get_caps(%u) is not the listed caps\n",
+                caps->rig_model);
+        check->failures++;
+    }
+
+    check->last = caps->rig_model;
+    check->count++;
+
+    return 1;  /* !=0, we want them all ! */
+}
+
+
+int main(int argc, char *argv[])
+{
+    rig_model_t model = argc > 1 ? atoi(argv[1]) : RIG_MODEL_DUMMY;
+    struct list_check check;
+    struct timespec start;
+    double init_ms, list_ms;
+    long rss_start, rss_init, rss_list;
+    RIG *rig;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    rss_start = rss_kb();
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    rig = rig_init(model);
+    init_ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    rss_init = rss_kb();
+
+    if (!rig)
+    {
+        fprintf(stderr, "FAIL: rig_init(%u)\n", model);
+        return 1;
+    }
+
+    rig_cleanup(rig);
+
+    memset(&check, 0, sizeof(check));
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    rig_load_all_backends();
+    rig_list_foreach(check_caps, &check);
+    list_ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    rss_list = rss_kb();
+
+    printf("rig_init: model=%u ms=%.3f rss_kb=%ld (+%ld)\n", model, init_ms,
+           rss_init, rss_init - rss_start);
+    printf("list: models=%d ms=%.3f rss_kb=%ld (+%ld)\n", check.count, list_ms,
+           rss_list, rss_list - rss_init);
+
+    if (rig_get_caps(RIG_MODEL_NONE) != NULL || rig_get_caps(999999) != NULL)
+    {
+        fprintf(stderr, "FAIL: caps found for an unknown model\n");
+        check.failures++;
+    }
+
+    if (check.count < 2)
+    {
+        fprintf(stderr, "FAIL: only %d models listed\n", check.count);
+        check.failures++;
+    }
+
+    return check.failures ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * testrighandle - rig handles of one model share their initial state
+ *
+ * Checks that each handle still starts with the tables of its caps,
+ * that a change to one handle is not seen by the others, that a handle
+ * made after a backend changed its caps gets the new tables, that
+ * many handles can be made and released and that nothing is left open
+ * once the last handle is gone.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <hamlib/rig.h>
+#include "testcheck.h"
+
+#define HANDLES 200
+
+
+/* the lowest free descriptor, higher when something was left open */
+static int free_fd(void)
+{
+    int fd = open("/dev/null", O_RDONLY);
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    return fd;
+}
+
+static int same_tables(RIG *rig)
+{
+    const struct rig_caps *caps = rig->caps;
+    const struct rig_state *rs = &rig->state;
+
+    return memcmp(rs->preamp, caps->preamp, sizeof(rs->preamp)) == 0
+           && memcmp(rs->attenuator, caps->attenuator, sizeof(rs->attenuator)) == 0
+           && memcmp(rs->tuning_steps, caps->tuning_steps,
+                     sizeof(rs->tuning_steps)) == 0
+           && memcmp(rs->filters, caps->filters, sizeof(rs->filters)) == 0
+           && memcmp(rs->level_gran, caps->level_gran, sizeof(rs->level_gran)) == 0
+           && rs->rig_model == caps->rig_model
+           && rs->has_get_func == caps->has_get_func;
+}
+
+
+int main(void)
+{
+    static RIG *rigs[HANDLES];
+    struct rig_caps *caps;
+    char path[HAMLIB_FILPATHLEN];
+    RIG *a, *b, *c;
+    int preamp;
+    int fd;
+    int i;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    rig_load_all_backends();
+    fd = free_fd();
+
+    a = rig_init(RIG_MODEL_DUMMY);
+    b = rig_init(RIG_MODEL_DUMMY);
+
+    if (!a || !b)
+    {
+        fprintf(stderr, "rig_init failed\n");
+        return 1;
+    }
+
+    printf("shared=%d sizeof(RIG)=%u\n", a->state.shared_handle,
+           (unsigned) sizeof(RIG));
+    check(same_tables(a) && same_tables(b), "tables from the caps");
+    check(a->state.priv && a->state.priv != b->state.priv, "own backend state");
+
+    /* a change stays with its handle */
+    preamp = b->state.preamp[0];
+    a->state.preamp[0] = preamp + 10;
+    rig_set_conf(a, rig_token_lookup(a, "rig_pathname"), "/dev/rig_a");
+    rig_get_conf2(b, rig_token_lookup(b, "rig_pathname"), path, sizeof(path));
+    check(b->state.preamp[0] == preamp, "preamp of the other handle");
+    check(strcmp(path, "/dev/rig_a") != 0, "pathname of the other handle");
+    check(rig_open(a) == RIG_OK && rig_set_freq(a, RIG_VFO_CURR, 14074000) == RIG_OK,
+          "set_freq");
+    check(b->state.comm_state == 0 && CACHE(b)->freqMainA != 14074000,
+          "state of the other handle");
+
+    rig_cleanup(a);
+
+    c = rig_init(RIG_MODEL_DUMMY);
+    check(c && same_tables(c), "new handle after a cleanup");
+    rig_cleanup(c);
+
+    /* backends like netrigctl fill in their caps at rig_open() */
+    caps = (struct rig_caps *) b->caps;
+    caps->preamp[0] = preamp + 20;
+    c = rig_init(RIG_MODEL_DUMMY);
+    check(c && c->state.preamp[0] == preamp + 20, "new handle after a caps change");
+    caps->preamp[0] = preamp;
+    rig_cleanup(c);
+    rig_cleanup(b);
+
+    for (i = 0; i < HANDLES; i++)
+    {
+        rigs[i] = rig_init(i % 2 ? RIG_MODEL_NETRIGCTL : RIG_MODEL_DUMMY);
+        check(rigs[i] && same_tables(rigs[i]), "many handles");
+    }
+
+    for (i = 0; i < HANDLES; i++)
+    {
+        if (rigs[i])
+        {
+            rig_cleanup(rigs[i]);
+        }
+    }
+
+    check(free_fd() == fd, "templates released with their last handle");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * testrottrack - rotator trajectory tracking test
+ *
+ * Follows a pass crossing north with the trajectory tracker, then the
+ * same pass sent the usual way, one rot_set_position() a second, and
+ * prints the pointing error and the commands of both.  Checks that the
+ * tracker stays within a few degrees of the path, keeps to one turn of
+ * the azimuth range and plans a pass over the zenith when the range has
+ * no turn for it.
+ *
+ *   testrottrack [model device [seconds]]
+ *
+ * runs against a rotator or a simulator, e.g. simulators/simspid (901)
+ * or simrotorez (405, azimuth on the first pty), with a longer pass.
+ * Without arguments the dummy rotator is used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <hamlib/rotator.h>
+#include "misc.h"
+#include "testcheck.h"
+
+#define POINTS 21
+
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* 20 degrees of azimuth from az0, elevation rising by 10 and back */
+static void make_pass(rot_track_point_t *p, double start, double seconds,
+                      double az0)
+{
+    int i;
+
+    for (i = 0; i < POINTS; i++)
+    {
+        double f = (double) i / (POINTS - 1);
+
+        p[i].time = start + f * seconds;
+        p[i].az = fmod(az0 + 20 * f, 360);
+        p[i].el = 20 + 10 * sin(f * M_PI);
+    }
+}
+
+
+static void pass_at(const rot_track_point_t *p, double t, azimuth_t *az,
+                    elevation_t *el)
+{
+    int i;
+
+    for (i = 1; i < POINTS - 1 && p[i].time < t; i++)
+    {
+    }
+
+    *az = p[i].az;
+    *el = p[i].el;
+
+    if (t > p[i - 1].time && t < p[i].time)
+    {
+        double f = (t - p[i - 1].time) / (p[i].time - p[i - 1].time);
+
+        *az = p[i - 1].az + f * (fmod(p[i].az - p[i - 1].az + 540, 360) - 180);
+        *el = p[i - 1].el + f * (p[i].el - p[i - 1].el);
+    }
+}
+
+
+static double pointing_error(azimuth_t az1, elevation_t el1, azimuth_t az2,
+                             elevation_t el2)
+{
+    double c = sin(el1 * M_PI / 180) * sin(el2 * M_PI / 180)
+               + cos(el1 * M_PI / 180) * cos(el2 * M_PI / 180)
+               * cos((az1 - az2) * M_PI / 180);
+
+    return acos(c > 1 ? 1 : c < -1 ? -1 : c) * 180 / M_PI;
+}
+
+
+/* follow a pass with the tracker, returns the final status */
+static void tracked(ROT *rot, double lead_s, double seconds,
+                    rot_track_status_t *st, double *min_az, double *max_az)
+{
+    rot_track_point_t pass[POINTS];
+
+    make_pass(pass, now_s() + lead_s, seconds, 350);
+    check(rot_track_start(rot, pass, POINTS) == RIG_OK, "tracking started");
+
+    *min_az = 1000;
+    *max_az = -1000;
+
+    do
+    {
+        hl_usleep(100 * 1000);
+        rot_track_get_status(rot, st);
+
+        if (st->state == ROT_TRACK_TRACKING)
+        {
+            *min_az = st->az < *min_az ? st->az : *min_az;
+            *max_az = st->az > *max_az ? st->az : *max_az;
+        }
+    }
+    while ((st->state == ROT_TRACK_WAIT || st->state == ROT_TRACK_TRACKING)
+            && now_s() < pass[POINTS - 1].time + 30);
+
+    rot_track_stop(rot);
+}
+
+
+/* the same pass a position a second, returns the largest error */
+static double naive(ROT *rot, double lead_s, double seconds,
+                    unsigned long *commands)
+{
+    rot_track_point_t pass[POINTS];
+    double max_error = 0;
+    double next = 0;
+    double t;
+
+    make_pass(pass, now_s() + lead_s, seconds, 350);
+    *commands = 0;
+
+    while ((t = now_s()) < pass[POINTS - 1].time)
+    {
+        azimuth_t az, raz;
+        elevation_t el, rel;
+
+        pass_at(pass, t, &az, &el);
+
+        if (t >= next)
+        {
+            rot_set_position(rot, az, el);
+            (*commands)++;
+            next = (t < pass[0].time ? pass[0].time : t) + 1;
+        }
+
+        if (t >= pass[0].time && rot_get_position(rot, &raz, &rel) == RIG_OK)
+        {
+            double error = pointing_error(raz, rel, az, el);
+
+            max_error = error > max_error ? error : max_error;
+        }
+
+        hl_usleep(100 * 1000);
+    }
+
+    return max_error;
+}
+
+
+int main(int argc, char *argv[])
+{
+    rot_track_point_t pass[POINTS];
+    rot_track_status_t st;
+    rot_track_point_t bad[2] = { { 10, 0, 0 }, { 5, 0, 0 } };
+    unsigned long naive_commands;
+    double naive_error;
+    double min_az, max_az;
+    double lead_s = 4, seconds = 5;
+    char buf[32];
+    ROT *rot;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    rot_load_all_backends();
+    rot = rot_init(argc > 2 ? atoi(argv[1]) : ROT_MODEL_DUMMY);
+
+    if (!rot)
+    {
+        return 1;
+    }
+
+    if (argc > 2)
+    {
+        rot_set_conf(rot, rot_token_lookup(rot, "rot_pathname"), argv[2]);
+        seconds = argc > 3 ? atof(argv[3]) : 30;
+        lead_s = 10;
+    }
+    else
+    {
+        rot_set_conf(rot, rot_token_lookup(rot, "track_interval"), "50");
+    }
+
+    if (rot_open(rot) != RIG_OK)
+    {
+        fprintf(stderr, "cannot open the rotator\n");
+        return 1;
+    }
+
+    check(rot_track_start(rot, bad, 2) == -RIG_EINVAL, "points out of order");
+    check(rot_set_conf(rot, rot_token_lookup(rot, "track_deadband"), "0")
+          == -RIG_EINVAL, "bad deadband");
+    rot_get_conf2(rot, rot_token_lookup(rot, "track_deadband"), buf, sizeof(buf));
+    check(strcmp(buf, "2") == 0, "default deadband");
+
+    /* across north in one turn */
+    tracked(rot, lead_s, seconds, &st, &min_az, &max_az);
+    printf("tracked: state=%d flipped=%d commands=%lu polls=%lu max_error=%.2f "
+           "rms_error=%.2f slew_rate=%.1f latency_ms=%.0f az=%.1f..%.1f\n",
+           st.state, st.flipped, st.commands, st.polls, st.max_error,
+           st.rms_error, st.slew_rate, st.latency_ms, min_az, max_az);
+    check(st.state == ROT_TRACK_DONE, "pass done");
+
+    if (argc <= 2)
+    {
+        check(!st.flipped, "not flipped");
+        check(max_az - min_az < 30, "one turn across north");
+        check(st.max_error < 6, "tracking error");
+        check(st.commands >= 5 && st.commands <= 25, "one command per deadband");
+    }
+
+    /* one position a second */
+    naive_error = naive(rot, lead_s, seconds, &naive_commands);
+    printf("naive: commands=%lu max_error=%.2f\n", naive_commands, naive_error);
+
+    if (argc <= 2)
+    {
+        check(naive_error > st.max_error, "tracker beats one position a second");
+
+        /* a stop at south, a pass crossing south goes over the zenith */
+        rot_set_conf(rot, rot_token_lookup(rot, "min_az"), "-180");
+        rot_set_conf(rot, rot_token_lookup(rot, "max_az"), "180");
+        rot_set_conf(rot, rot_token_lookup(rot, "max_el"), "180");
+        make_pass(pass, now_s() + 2, seconds, 170);
+        check(rot_track_start(rot, pass, POINTS) == RIG_OK, "flipped pass started");
+        hl_usleep(500 * 1000);
+        rot_track_get_status(rot, &st);
+        printf("flipped: state=%d flipped=%d target=%.1f/%.1f\n", st.state,
+               st.flipped, st.target_az, st.target_el);
+        check(st.state == ROT_TRACK_WAIT && st.flipped, "pass flipped");
+        check(fabs(st.target_az + 10) < 0.1 && fabs(st.target_el - 160) < 0.1,
+              "flipped start");
+        rot_track_stop(rot);
+        rot_track_get_status(rot, &st);
+        check(st.state == ROT_TRACK_IDLE, "tracking stopped");
+    }
+
+    rot_close(rot);
+    rot_cleanup(rot);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * testspectrum - per-subscriber spectrum reduction test and benchmark
+ *
+ * Feeds random scope lines to subscribers asking for max and mean
+ * binning, averaging, peak hold and a send interval, and checks each
+ * reduced line against a plain reduction of the same lines.  Then checks
+ * rig_spectrum_reduction_parse(), the multicast_spectrum token and the
+ * subscriber limit, and prints as JSON how many lines per second one core
+ * reduces for the subscribers of a typical band map and waterfall setup,
+ * for IC-7300 and 2048 point lines.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "event.h"
+#include "testcheck.h"
+
+#define LENGTH 475
+#define WIDTH 100
+#define LINES 200
+#define BENCH_LINES 20000
+
+
+/* the last line a subscriber was sent */
+struct received
+{
+    int lines;
+    int length;
+    unsigned char data[HAMLIB_MAX_SPECTRUM_DATA];
+};
+
+static unsigned char input[LENGTH];
+
+
+static int receive(RIG *rig, struct rig_spectrum_line *line, rig_ptr_t arg)
+{
+    struct received *r = arg;
+
+    r->lines++;
+    r->length = line->spectrum_data_length;
+    memcpy(r->data, line->spectrum_data, line->spectrum_data_length);
+
+    return RIG_OK;
+}
+
+
+static void fire(RIG *rig, const unsigned char *data, int length)
+{
+    struct rig_spectrum_line line;
+
+    memset(&line, 0, sizeof(line));
+    line.data_level_max = 160;
+    line.spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
+    line.center_freq = 14074000;
+    line.span_freq = 50000;
+    line.spectrum_data_length = length;
+    line.spectrum_data = (unsigned char *) data;
+
+    rig_fire_spectrum_event(rig, &line);
+}
+
+
+static int subscribe(RIG *rig, const char *spec, struct received *r)
+{
+    rig_spectrum_reduction_t reduction;
+
+    if (rig_spectrum_reduction_parse(spec, &reduction) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return rig_spectrum_subscribe(rig, &reduction, receive, r);
+}
+
+
+static void test_reductions(RIG *rig)
+{
+    struct received bin_max, bin_mean, average, peak, interval;
+    int id[5];
+    double avg[LENGTH];
+    unsigned char held[LENGTH];
+    int i, j, k;
+
+    memset(&bin_max, 0, sizeof(bin_max));
+    memset(&bin_mean, 0, sizeof(bin_mean));
+    memset(&average, 0, sizeof(average));
+    memset(&peak, 0, sizeof(peak));
+    memset(&interval, 0, sizeof(interval));
+
+    id[0] = subscribe(rig, "width=100,bin=max", &bin_max);
+    id[1] = subscribe(rig, "width=100,bin=mean", &bin_mean);
+    id[2] = subscribe(rig, "average=3", &average);
+    id[3] = subscribe(rig, "peak_hold=3600000", &peak);
+    id[4] = subscribe(rig, "interval=3600000", &interval);
+
+    for (k = 0; k < 5; k++)
+    {
+        check(id[k] >= 0, "subscribe");
+    }
+
+    for (i = 0; i < LINES; i++)
+    {
+        int max_ok = 1, mean_ok = 1, average_ok = 1, peak_ok = 1;
+
+        for (j = 0; j < LENGTH; j++)
+        {
+            input[j] = rand() % 161;
+        }
+
+        fire(rig, input, LENGTH);
+
+        for (k = 0; k < WIDTH; k++)
+        {
+            int from = k * LENGTH / WIDTH, to = (k + 1) * LENGTH / WIDTH;
+            int max = 0, sum = 0;
+
+            for (j = from; j < to; j++)
+            {
+                max = input[j] > max ? input[j] : max;
+                sum += input[j];
+            }
+
+            max_ok &= bin_max.data[k] == max;
+            mean_ok &= bin_mean.data[k] == (sum + (to - from) / 2) / (to - from);
+        }
+
+        for (j = 0; j < LENGTH; j++)
+        {
+            avg[j] = i == 0 ? input[j] : avg[j] + (input[j] - avg[j]) / 8;
+            held[j] = i == 0 || input[j] > held[j] ? input[j] : held[j];
+
+            /* the fixed point average may round the other way */
+            average_ok &= abs(average.data[j] - (int)(avg[j] + 0.5)) <= 1;
+            peak_ok &= peak.data[j] == held[j];
+        }
+
+        check(bin_max.length == WIDTH && max_ok, "max binning");
+        check(bin_mean.length == WIDTH && mean_ok, "mean binning");
+        check(average.length == LENGTH && average_ok, "average");
+        check(peak.length == LENGTH && peak_ok, "peak hold");
+    }
+
+    check(bin_max.lines == LINES, "every line sent without an interval");
+    check(interval.lines == 1, "lines held back by the interval");
+
+    for (k = 0; k < 5; k++)
+    {
+        check(rig_spectrum_unsubscribe(rig, id[k]) == RIG_OK, "unsubscribe");
+    }
+
+    fire(rig, input, LENGTH);
+    check(bin_max.lines == LINES, "nothing sent after unsubscribe");
+    check(rig_spectrum_unsubscribe(rig, id[0]) == -RIG_EINVAL,
+          "unsubscribe twice");
+}
+
+
+static void test_parse(RIG *rig)
+{
+    rig_spectrum_reduction_t r;
+    struct received sink;
+    int id[17];
+    int i;
+
+    check(rig_spectrum_reduction_parse(
+              "width=250,bin=mean,average=2,peak_hold=500,interval=200", &r) == RIG_OK
+          && r.width == 250 && r.bin == RIG_SPECTRUM_BIN_MEAN && r.average == 2
+          && r.peak_hold_ms == 500 && r.interval_ms == 200, "parse all names");
+    check(rig_spectrum_reduction_parse("", &r) == RIG_OK && r.width == 0
+          && r.bin == RIG_SPECTRUM_BIN_MAX, "parse empty");
+    check(rig_spectrum_reduction_parse("bin=median", &r) != RIG_OK,
+          "reject unknown binning");
+    check(rig_spectrum_reduction_parse("average=9", &r) != RIG_OK,
+          "reject long average");
+    check(rig_spectrum_reduction_parse("width", &r) != RIG_OK,
+          "reject name without value");
+    check(rig_spectrum_reduction_parse("speed=2", &r) != RIG_OK,
+          "reject unknown name");
+
+    check(rig_set_conf(rig, rig_token_lookup(rig, "multicast_spectrum"),
+                       "width=100,interval=500") == RIG_OK, "multicast_spectrum");
+    check(rig_set_conf(rig, rig_token_lookup(rig, "multicast_spectrum"),
+                       "width=-1") != RIG_OK, "reject bad multicast_spectrum");
+
+    for (i = 0; i < 17; i++)
+    {
+        id[i] = subscribe(rig, "width=10", &sink);
+    }
+
+    check(id[15] >= 0 && id[16] == -RIG_ENAVAIL, "subscriber limit");
+
+    for (i = 0; i < 16; i++)
+    {
+        rig_spectrum_unsubscribe(rig, id[i]);
+    }
+}
+
+
+/* lines per CPU second for a band map, a waterfall and a raw display */
+static double bench(RIG *rig, int length)
+{
+    static const char *const setup[] =
+    {
+        "width=100,bin=max,peak_hold=1000,interval=500",
+        "width=250,bin=mean,average=2",
+        "average=3",
+        "width=800,bin=max",
+    };
+    static unsigned char data[4][HAMLIB_MAX_SPECTRUM_DATA];
+    struct received sink;
+    int id[4];
+    clock_t start;
+    double seconds;
+    int i, j;
+
+    for (i = 0; i < 4; i++)
+    {
+        id[i] = subscribe(rig, setup[i], &sink);
+
+        for (j = 0; j < length; j++)
+        {
+            data[i][j] = rand() % 161;
+        }
+    }
+
+    start = clock();
+
+    for (i = 0; i < BENCH_LINES; i++)
+    {
+        fire(rig, data[i % 4], length);
+    }
+
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    for (i = 0; i < 4; i++)
+    {
+        rig_spectrum_unsubscribe(rig, id[i]);
+    }
+
+    return seconds > 0 ? BENCH_LINES / seconds : 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    RIG *rig;
+    double lines_475, lines_2048;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    srand(7300);
+    rig = rig_init(RIG_MODEL_DUMMY);
+
+    /* not opened, so no other thread takes CPU time from the benchmark */
+    if (!rig)
+    {
+        fprintf(stderr, "rig_init failed\n");
+        return 1;
+    }
+
+    test_reductions(rig);
+    test_parse(rig);
+
+    lines_475 = bench(rig, 475);
+    lines_2048 = bench(rig, 2048);
+
+    printf("{\"subscribers\":4,\"lines_per_s_475\":%.0f,"
+           "\"lines_per_s_2048\":%.0f}\n", lines_475, lines_2048);
+
+    rig_cleanup(rig);
+
+    if (failures)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    printf("testspectrum: all checks passed\n");
+
+    return 0;
+}
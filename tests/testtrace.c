@@ -0,0 +1,149 @@
+/*  Port trace record/replay test and benchmark
+ *
+ *  Record a standard session against a rig or simulator:
+ *      ./testtrace -R /dev/pts/3 3073 ic7300.trace
+ *  Replay it without the rig, as fast as possible:
+ *      ./testtrace 3073 ic7300.trace
+ *
+ *  The replay fails if the backend issues a different sequence of
+ *  commands than was recorded, so a trace doubles as a regression test
+ *  of a backend's transaction count.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <hamlib/rig.h>
+
+#define LOOP_COUNT 10
+
+static double elapsed_since(const struct timeval *tv1)
+{
+    struct timeval tv2;
+
+    gettimeofday(&tv2, NULL);
+
+    return (tv2.tv_sec - tv1->tv_sec) * 1000.0
+           + (tv2.tv_usec - tv1->tv_usec) / 1000.0;
+}
+
+int main(int argc, char *argv[])
+{
+    RIG *my_rig;
+    const char *record_port = NULL;
+    hamlib_trace_stats_t stats;
+    struct timeval tv;
+    double open_ms, loop_ms;
+    rig_model_t model;
+    int retcode;
+    int i;
+
+    if (argc == 5 && strcmp(argv[1], "-R") == 0)
+    {
+        record_port = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s [-R rig_port] model trace_file\n", argv[0]);
+        return 1;
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    model = atoi(argv[1]);
+    my_rig = rig_init(model);
+
+    if (!my_rig)
+    {
+        fprintf(stderr, "Unknown rig num: %u\n", model);
+        return 1;
+    }
+
+    /* the background poll thread would interleave its own transactions */
+    rig_set_conf(my_rig, rig_token_lookup(my_rig, "poll_interval"), "0");
+
+    if (record_port)
+    {
+        rig_set_conf(my_rig, rig_token_lookup(my_rig, "rig_pathname"), record_port);
+        rig_set_conf(my_rig, rig_token_lookup(my_rig, "trace_record"), argv[2]);
+    }
+    else
+    {
+        rig_set_conf(my_rig, rig_token_lookup(my_rig, "trace_replay"), argv[2]);
+        rig_set_conf(my_rig, rig_token_lookup(my_rig, "trace_timing"), "0");
+    }
+
+    gettimeofday(&tv, NULL);
+    retcode = rig_open(my_rig);
+    open_ms = elapsed_since(&tv);
+
+    if (retcode != RIG_OK)
+    {
+        fprintf(stderr, "rig_open: error = %s\n", rigerror(retcode));
+        return 1;
+    }
+
+    /* the exchange must not depend on how fast the replay runs */
+    rig_set_cache_timeout_ms(my_rig, HAMLIB_CACHE_ALL, 0);
+
+    gettimeofday(&tv, NULL);
+
+    for (i = 0; i < LOOP_COUNT; i++)
+    {
+        freq_t freq;
+        rmode_t mode;
+        pbwidth_t width;
+        ptt_t ptt;
+
+        retcode = rig_get_freq(my_rig, RIG_VFO_CURR, &freq);
+
+        if (retcode == RIG_OK)
+        {
+            retcode = rig_get_mode(my_rig, RIG_VFO_CURR, &mode, &width);
+        }
+
+        if (retcode == RIG_OK)
+        {
+            retcode = rig_get_ptt(my_rig, RIG_VFO_CURR, &ptt);
+        }
+
+        if (retcode != RIG_OK)
+        {
+            fprintf(stderr, "loop %d: error = %s\n", i, rigerror(retcode));
+            return 1;
+        }
+    }
+
+    loop_ms = elapsed_since(&tv);
+
+    rig_close(my_rig);
+    rig_get_trace_stats(my_rig, &stats);
+
+    /* the replay borrows the rig port only while the rig is open */
+    if (RIGPORT(my_rig)->type.rig != my_rig->caps->port_type)
+    {
+        fprintf(stderr, "port type %d not restored to %d after rig_close\n",
+                RIGPORT(my_rig)->type.rig, my_rig->caps->port_type);
+        return 1;
+    }
+
+    rig_cleanup(my_rig);
+
+    printf("model=%u open_ms=%.3f loop_ms=%.3f writes=%lu reads=%lu "
+           "read_errors=%lu bytes_written=%lu bytes_read=%lu mismatches=%lu\n",
+           model, open_ms, loop_ms, stats.writes, stats.reads, stats.read_errors,
+           stats.bytes_written, stats.bytes_read, stats.mismatches);
+
+    if (stats.mismatches)
+    {
+        fprintf(stderr, "%lu writes differ from the recorded trace\n",
+                stats.mismatches);
+        return 1;
+    }
+
+    return 0;
+}